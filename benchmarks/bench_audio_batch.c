@@ -0,0 +1,107 @@
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "bench_common.h"
+#include "audio_batch.h"
+
+// Coste por llamada y por paquete de SEND_AUDIO_BATCH según el tamaño del
+// lote. Cada llamada modela un IOCTL METHOD_BUFFERED: una llamada al sistema
+// real, la copia del lote a SystemBuffer, la validación de todos los
+// descriptores, una única sección crítica (spinlock) para escribir y la copia
+// del vector de resultados. Un lote de 1 equivale al SEND_AUDIO clásico.
+
+#define BENCH_FRAME_SIZE    4
+#define BENCH_PACKET_FRAMES 120 // 2,5 ms a 48 kHz
+#define BENCH_RING_FRAMES   (64 * 1024)
+#define BENCH_BASE_PACKETS  2000000ULL
+
+static UCHAR g_UserBatch[AUDIO_BATCH_HEADER_SIZE(MAX_AUDIO_BATCH_PACKETS) +
+                         MAX_AUDIO_BATCH_PACKETS * BENCH_PACKET_FRAMES * BENCH_FRAME_SIZE];
+static UCHAR g_SystemBuffer[sizeof(g_UserBatch)];
+static UCHAR g_Storage[BENCH_RING_FRAMES * BENCH_FRAME_SIZE];
+
+static ULONG BuildBatch(ULONG count)
+{
+    PAUDIO_BATCH_HEADER header = (PAUDIO_BATCH_HEADER)g_UserBatch;
+    ULONG offset = (ULONG)AUDIO_BATCH_HEADER_SIZE(count);
+    ULONG i;
+
+    header->PacketCount = count;
+    header->Reserved = 0;
+
+    for (i = 0; i < count; i++) {
+        header->Packets[i].Timestamp = i;
+        header->Packets[i].DataOffset = offset;
+        header->Packets[i].DataLength = BENCH_PACKET_FRAMES * BENCH_FRAME_SIZE;
+        memset(g_UserBatch + offset, (int)i, BENCH_PACKET_FRAMES * BENCH_FRAME_SIZE);
+        offset += BENCH_PACKET_FRAMES * BENCH_FRAME_SIZE;
+    }
+
+    return offset;
+}
+
+static double RunBatch(PRING_BUFFER ring, pthread_spinlock_t *lock, ULONG batchSize, ULONG64 calls)
+{
+    AUDIO_BATCH_RESULT results[MAX_AUDIO_BATCH_PACKETS];
+    ULONG length = BuildBatch(batchSize);
+    ULONG totalFrames;
+    double start = BenchNowSeconds();
+    ULONG64 i;
+
+    for (i = 0; i < calls; i++) {
+        // Transición a modo kernel y copia del I/O manager
+        syscall(SYS_getppid);
+        memcpy(g_SystemBuffer, g_UserBatch, length);
+
+        if (!NT_SUCCESS(AudioBatchValidate(g_SystemBuffer, length, BENCH_FRAME_SIZE, &totalFrames))) {
+            return 0.0;
+        }
+
+        pthread_spin_lock(lock);
+        AudioBatchWrite(ring, g_SystemBuffer, NULL, FALSE, results);
+        pthread_spin_unlock(lock);
+
+        memcpy(g_SystemBuffer, results, batchSize * sizeof(AUDIO_BATCH_RESULT));
+        BenchDoNotOptimize(g_SystemBuffer);
+
+        // El lector libera el espacio entre llamadas
+        RingBufferDiscard(ring, totalFrames);
+    }
+
+    return (BenchNowSeconds() - start) * 1e9 / (double)calls;
+}
+
+int main(int argc, char **argv)
+{
+    static const ULONG batchSizes[] = { 1, 2, 4, 8, 16, 32, 64 };
+    ULONG64 packets = (ULONG64)(BENCH_BASE_PACKETS * BenchScale(argc, argv));
+    pthread_spinlock_t lock;
+    RING_BUFFER ring;
+    double singleCost = 0.0;
+    size_t i;
+
+    pthread_spin_init(&lock, PTHREAD_PROCESS_PRIVATE);
+    RingBufferInitialize(&ring, g_Storage, BENCH_RING_FRAMES, BENCH_FRAME_SIZE);
+
+    printf("=== SEND_AUDIO_BATCH: coste según tamaño de lote (%llu paquetes de %u bytes) ===\n",
+           (unsigned long long)packets, BENCH_PACKET_FRAMES * BENCH_FRAME_SIZE);
+    printf("%-8s %14s %14s %14s %10s\n", "lote", "ns/llamada", "ns/paquete", "paquetes/s", "speedup");
+
+    for (i = 0; i < sizeof(batchSizes) / sizeof(batchSizes[0]); i++) {
+        ULONG64 calls = packets / batchSizes[i];
+        double perCall = RunBatch(&ring, &lock, batchSizes[i], calls);
+        double perPacket = perCall / batchSizes[i];
+
+        if (batchSizes[i] == 1) {
+            singleCost = perPacket;
+        }
+
+        printf("%-8u %14.1f %14.1f %14.0f %9.2fx\n",
+               batchSizes[i], perCall, perPacket, 1e9 / perPacket, singleCost / perPacket);
+    }
+
+    pthread_spin_destroy(&lock);
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "channel_mix.h"
+
+// Mezcla de canales por preset: Mframes/s del núcleo (float -> float, bloque
+// de 10 ms a 48 kHz) con la referencia escalar y con SSE2, y del camino de
+// escritura completo (int16 -> mezcla -> int16 en el anillo) con la mejor
+// variante. La forma 3->2 no tiene núcleo propio y mide el genérico.
+
+#define BENCH_BLOCK_FRAMES 480
+#define BENCH_BASE_FRAMES  400000000ULL
+#define BENCH_RING_FRAMES  4096
+
+typedef struct _BENCH_SHAPE {
+    const char *Name;
+    ULONG InputChannels;
+    ULONG OutputChannels;
+    CHANNEL_MIX_PRESET Preset;
+} BENCH_SHAPE;
+
+static const BENCH_SHAPE g_Shapes[] = {
+    { "mono->estéreo", 1, 2, CHANNEL_MIX_PRESET_MONO_TO_STEREO },
+    { "estéreo->mono", 2, 1, CHANNEL_MIX_PRESET_STEREO_TO_MONO },
+    { "5.1->estéreo",  6, 2, CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO },
+    { "7.1->estéreo",  8, 2, CHANNEL_MIX_PRESET_SURROUND71_TO_STEREO },
+    { "3->2 directa",  3, 2, CHANNEL_MIX_PRESET_DIRECT },
+};
+
+#define BENCH_SHAPE_COUNT (sizeof(g_Shapes) / sizeof(g_Shapes[0]))
+
+static CHANNEL_MIX g_Mix;
+static float g_Source[BENCH_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+static float g_Target[BENCH_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+static SHORT g_Packet[BENCH_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+static SHORT g_Storage[BENCH_RING_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+static SHORT g_Drain[BENCH_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+
+static BOOLEAN Initialize(const BENCH_SHAPE *shape, SAMPLE_FORMAT format, SAMPLE_CONVERT_ISA isa)
+{
+    CHANNEL_MIX_CONFIG config;
+
+    memset(&config, 0, sizeof(config));
+    config.InputChannels = shape->InputChannels;
+    config.OutputChannels = shape->OutputChannels;
+    config.SourceFormat = format;
+    config.TargetFormat = format;
+    config.Preset = shape->Preset;
+    config.Isa = isa;
+
+    return NT_SUCCESS(ChannelMixInitialize(&g_Mix, &config));
+}
+
+// Frames por segundo del núcleo de mezcla
+static double RunKernel(const BENCH_SHAPE *shape, SAMPLE_CONVERT_ISA isa, ULONG64 totalFrames)
+{
+    ULONG64 blocks = totalFrames / BENCH_BLOCK_FRAMES;
+    double start;
+    ULONG64 i;
+
+    if (!Initialize(shape, SAMPLE_FORMAT_FLOAT32, isa)) {
+        return 0.0;
+    }
+
+    if (blocks == 0) {
+        blocks = 1;
+    }
+
+    start = BenchNowSeconds();
+    for (i = 0; i < blocks; i++) {
+        ChannelMixFrames(&g_Mix, g_Target, g_Source, BENCH_BLOCK_FRAMES);
+        BenchDoNotOptimize(g_Target);
+    }
+
+    return (double)(blocks * BENCH_BLOCK_FRAMES) / (BenchNowSeconds() - start);
+}
+
+// Frames por segundo de escritura en el anillo (el anillo se vacía en cada vuelta)
+static double RunWritePath(const BENCH_SHAPE *shape, ULONG64 totalFrames)
+{
+    RING_BUFFER ring;
+    ULONG64 blocks = totalFrames / BENCH_BLOCK_FRAMES;
+    double start;
+    ULONG64 i;
+
+    if (!Initialize(shape, SAMPLE_FORMAT_INT16, SampleConvertGetBestIsa()) ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, BENCH_RING_FRAMES,
+                                         shape->OutputChannels * sizeof(SHORT)))) {
+        return 0.0;
+    }
+
+    if (blocks == 0) {
+        blocks = 1;
+    }
+
+    start = BenchNowSeconds();
+    for (i = 0; i < blocks; i++) {
+        ChannelMixWriteRing(&g_Mix, NULL, &ring, g_Packet, BENCH_BLOCK_FRAMES);
+        RingBufferRead(&ring, g_Drain, BENCH_BLOCK_FRAMES);
+        BenchDoNotOptimize(g_Drain);
+    }
+
+    return (double)(blocks * BENCH_BLOCK_FRAMES) / (BenchNowSeconds() - start);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 totalFrames = (ULONG64)(BENCH_BASE_FRAMES * BenchScale(argc, argv));
+    double scalar;
+    double sse2;
+    ULONG shape;
+    ULONG i;
+
+    for (i = 0; i < BENCH_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS; i++) {
+        g_Source[i] = (float)((i * 7919) % 2001) / 1000.0f - 1.0f;
+        g_Packet[i] = (SHORT)((i * 2654435761UL) >> 18);
+    }
+
+    // Cada forma mide el mismo número de frames
+    totalFrames /= BENCH_SHAPE_COUNT;
+
+    printf("=== Mezcla de canales: bloques de %u frames ===\n", BENCH_BLOCK_FRAMES);
+    printf("%-16s %12s %12s %9s %16s\n", "forma (Mf/s)", "escalar", "SSE2", "SSE2/esc", "anillo int16");
+
+    for (shape = 0; shape < BENCH_SHAPE_COUNT; shape++) {
+        scalar = RunKernel(&g_Shapes[shape], SAMPLE_CONVERT_ISA_SCALAR, totalFrames);
+        sse2 = SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)
+                   ? RunKernel(&g_Shapes[shape], SAMPLE_CONVERT_ISA_SSE2, totalFrames)
+                   : 0.0;
+
+        printf("%-16s %12.1f %12.1f %8.1fx %16.1f\n", g_Shapes[shape].Name, scalar / 1e6, sse2 / 1e6,
+               sse2 / scalar, RunWritePath(&g_Shapes[shape], totalFrames / 4) / 1e6);
+    }
+
+    return 0;
+}
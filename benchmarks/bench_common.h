@@ -0,0 +1,52 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+// Utilidades compartidas por los benchmarks de host
+
+static inline double BenchNowSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static inline unsigned long long BenchNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + (unsigned long long)ts.tv_nsec;
+}
+
+// Contador de ciclos de referencia (TSC, a frecuencia nominal); 0 si no hay
+static inline unsigned long long BenchNowCycles(void)
+{
+#if defined(__x86_64__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Escala de iteraciones: primer argumento o variable VMIC_BENCH_SCALE
+static inline double BenchScale(int argc, char **argv)
+{
+    const char *value = (argc > 1) ? argv[1] : getenv("VMIC_BENCH_SCALE");
+    double scale = value ? atof(value) : 1.0;
+    return scale > 0.0 ? scale : 1.0;
+}
+
+// Evita que el compilador elimine cálculos cuyo resultado no se usa
+static inline void BenchDoNotOptimize(const void *ptr)
+{
+    __asm__ __volatile__("" : : "r"(ptr) : "memory");
+}
+
+#endif // BENCH_COMMON_H
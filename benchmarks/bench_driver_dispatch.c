@@ -0,0 +1,161 @@
+#include <string.h>
+
+#include "virtual_mic.h"
+#include "driver_core.h"
+#include "bench_common.h"
+
+// El driver completo sobre el shim de src/host/km, por tamaño de paquete:
+// SEND_AUDIO entregado por DispatchDeviceControl seguido de un IRP_MJ_READ
+// del mismo tamaño por DispatchRead, frente al anillo solo (RingBufferWrite y
+// RingBufferRead con el mismo tamaño de frame). La diferencia es lo que cuesta
+// el camino del IRP: despacho y contabilidad, validación, traza, conversión
+// fusionada, cola de lecturas y estadísticas. Los IRP se reutilizan (no se
+// mide la asignación del I/O manager). Mejor de varios intentos alternos.
+
+#define BENCH_RING_FRAMES  16384
+#define BENCH_MAX_FRAMES   4800
+#define BENCH_BASE_BYTES   (256ULL * 1024 * 1024)
+#define BENCH_ROUNDS       5
+
+DRIVER_INITIALIZE DriverEntry;
+
+static const ULONG g_PacketFrames[] = { 32, 128, 480, 1920, 4800 };
+
+static DRIVER_OBJECT g_DriverObject;
+static FILE_OBJECT g_FileObject;
+static UCHAR g_SendBuffer[sizeof(AUDIO_BUFFER_PACKET) + BENCH_MAX_FRAMES * DEFAULT_CHANNELS * sizeof(SHORT)];
+static SHORT g_Samples[BENCH_MAX_FRAMES * DEFAULT_CHANNELS];
+static SHORT g_Output[BENCH_MAX_FRAMES * DEFAULT_CHANNELS];
+static SHORT g_Storage[BENCH_RING_FRAMES * DEFAULT_CHANNELS];
+
+static NTSTATUS Ioctl(PIRP Irp, ULONG Code, PVOID Buffer, ULONG InputLength, ULONG OutputLength)
+{
+    PIO_STACK_LOCATION stack = IoGetCurrentIrpStackLocation(Irp);
+
+    Irp->AssociatedIrp.SystemBuffer = Buffer;
+    Irp->IoStatus.Information = 0;
+    Irp->HostCompleted = 0;
+    stack->Parameters.DeviceIoControl.IoControlCode = Code;
+    stack->Parameters.DeviceIoControl.InputBufferLength = InputLength;
+    stack->Parameters.DeviceIoControl.OutputBufferLength = OutputLength;
+
+    return g_DriverObject.MajorFunction[IRP_MJ_DEVICE_CONTROL](g_DriverObject.DeviceObject, Irp);
+}
+
+static double RunDriver(ULONG Frames, ULONG64 Packets)
+{
+    PIRP send = HostAllocateIrp(IRP_MJ_DEVICE_CONTROL, &g_FileObject);
+    PIRP read = HostAllocateIrp(IRP_MJ_READ, &g_FileObject);
+    PAUDIO_BUFFER_PACKET packet = (PAUDIO_BUFFER_PACKET)g_SendBuffer;
+    ULONG dataLength = Frames * DEFAULT_CHANNELS * sizeof(SHORT);
+    unsigned long long start;
+    ULONG64 failures = 0;
+    ULONG64 i;
+
+    read->AssociatedIrp.SystemBuffer = g_Output;
+    IoGetCurrentIrpStackLocation(read)->Parameters.Read.Length = dataLength;
+
+    packet->Timestamp = 0;
+    packet->DataLength = dataLength;
+    memcpy(packet->Data, g_Samples, dataLength);
+
+    start = BenchNowNs();
+
+    for (i = 0; i < Packets; i++) {
+        // METHOD_BUFFERED: SystemBuffer ya tiene la copia del paquete
+        if (Ioctl(send, IOCTL_VIRTUALMIC_SEND_AUDIO, g_SendBuffer, sizeof(AUDIO_BUFFER_PACKET) + dataLength, 0) !=
+            STATUS_SUCCESS) {
+            failures++;
+        }
+
+        read->HostCompleted = 0;
+        read->IoStatus.Information = 0;
+        if (g_DriverObject.MajorFunction[IRP_MJ_READ](g_DriverObject.DeviceObject, read) != STATUS_SUCCESS) {
+            failures++;
+        }
+        BenchDoNotOptimize(g_Output);
+    }
+
+    start = BenchNowNs() - start;
+
+    HostFreeIrp(send);
+    HostFreeIrp(read);
+
+    if (failures != 0) {
+        printf("   (%llu paquetes fallidos con %lu frames)\n", (unsigned long long)failures, (unsigned long)Frames);
+    }
+
+    return (double)start / (double)Packets;
+}
+
+static double RunRing(ULONG Frames, ULONG64 Packets)
+{
+    RING_BUFFER ring;
+    unsigned long long start;
+    ULONG64 i;
+
+    RingBufferInitialize(&ring, g_Storage, BENCH_RING_FRAMES, DEFAULT_CHANNELS * sizeof(SHORT));
+
+    start = BenchNowNs();
+
+    for (i = 0; i < Packets; i++) {
+        RingBufferWrite(&ring, g_Samples, Frames);
+        RingBufferRead(&ring, g_Output, Frames);
+        BenchDoNotOptimize(g_Output);
+    }
+
+    return (double)(BenchNowNs() - start) / (double)Packets;
+}
+
+int main(int argc, char **argv)
+{
+    double scale = BenchScale(argc, argv);
+    SET_BUFFER_REQUEST bufferRequest;
+    PIRP irp;
+    ULONG i;
+    ULONG round;
+
+    for (i = 0; i < BENCH_MAX_FRAMES * DEFAULT_CHANNELS; i++) {
+        g_Samples[i] = (SHORT)(i * 7);
+    }
+
+    if (!NT_SUCCESS(DriverEntry(&g_DriverObject, NULL))) {
+        printf("DriverEntry falló\n");
+        return 1;
+    }
+
+    // Capacidad para el paquete más grande
+    bufferRequest.Unit = BUFFER_LATENCY_FRAMES;
+    bufferRequest.Latency = BENCH_RING_FRAMES;
+    irp = HostAllocateIrp(IRP_MJ_DEVICE_CONTROL, &g_FileObject);
+    if (!NT_SUCCESS(Ioctl(irp, IOCTL_VIRTUALMIC_SET_BUFFER, &bufferRequest, sizeof(bufferRequest), 0))) {
+        printf("SET_BUFFER falló\n");
+        return 1;
+    }
+    HostFreeIrp(irp);
+
+    printf("=== Driver en el host: SEND_AUDIO + IRP_MJ_READ por tamaño de paquete (48 kHz estéreo int16) ===\n");
+    printf("%-8s %12s %12s %12s %12s %12s\n", "frames", "anillo ns", "driver ns", "coste ns", "anillo MB/s",
+           "driver MB/s");
+
+    for (i = 0; i < RTL_NUMBER_OF(g_PacketFrames); i++) {
+        ULONG frames = g_PacketFrames[i];
+        double bytes = (double)frames * DEFAULT_CHANNELS * sizeof(SHORT);
+        ULONG64 packets = (ULONG64)(BENCH_BASE_BYTES * scale / bytes);
+        double bestRing = 1e30;
+        double bestDriver = 1e30;
+
+        // Cada paquete cruza el anillo dos veces (escritura y lectura): los
+        // MB/s cuentan los bytes de audio entregados al lector
+        for (round = 0; round < BENCH_ROUNDS; round++) {
+            bestRing = min(bestRing, RunRing(frames, packets));
+            bestDriver = min(bestDriver, RunDriver(frames, packets));
+        }
+
+        printf("%-8lu %12.1f %12.1f %12.1f %12.1f %12.1f\n", (unsigned long)frames, bestRing, bestDriver,
+               bestDriver - bestRing, bytes * 1000.0 / bestRing, bytes * 1000.0 / bestDriver);
+    }
+
+    g_DriverObject.DriverUnload(&g_DriverObject);
+    return 0;
+}
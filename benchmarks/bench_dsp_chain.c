@@ -0,0 +1,216 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "dsp_chain.h"
+
+// Coste de la cadena de procesado en la lectura: paquetes de 10 ms a 48 kHz
+// procesados en el sitio, cada etapa sola y la cadena típica de voz (paso alto,
+// EQ de 4 bandas, compresor y limitador con 5 ms de anticipación), con la
+// referencia escalar y con SSE2. Se da en ns por frame, µs por paquete y
+// porcentaje del presupuesto de tiempo real del paquete (10 ms). Al final, la
+// cadena típica con llamadas de distintos tamaños: el coste fijo por llamada
+// se reparte en bloques de DSP_CHAIN_BLOCK_FRAMES.
+
+#define BENCH_RATE          48000
+#define BENCH_PACKET_FRAMES 480
+#define BENCH_MAX_CHANNELS  8
+#define BENCH_BASE_FRAMES   20000000ULL
+
+typedef enum _BENCH_CHAIN {
+    BENCH_CHAIN_EQ1,
+    BENCH_CHAIN_EQ4,
+    BENCH_CHAIN_EQ8,
+    BENCH_CHAIN_COMPRESSOR,
+    BENCH_CHAIN_LIMITER,
+    BENCH_CHAIN_VOICE,
+} BENCH_CHAIN;
+
+typedef struct _BENCH_CASE {
+    const char *Name;
+    BENCH_CHAIN Chain;
+    SAMPLE_FORMAT Format;
+    ULONG Channels;
+} BENCH_CASE;
+
+static const BENCH_CASE g_Cases[] = {
+    { "EQ 1 banda est.",        BENCH_CHAIN_EQ1,        SAMPLE_FORMAT_FLOAT32, 2 },
+    { "EQ 4 bandas est.",       BENCH_CHAIN_EQ4,        SAMPLE_FORMAT_FLOAT32, 2 },
+    { "EQ 4 bandas 8 can.",     BENCH_CHAIN_EQ4,        SAMPLE_FORMAT_FLOAT32, 8 },
+    { "EQ 8 bandas 8 can.",     BENCH_CHAIN_EQ8,        SAMPLE_FORMAT_FLOAT32, 8 },
+    { "compresor est.",         BENCH_CHAIN_COMPRESSOR, SAMPLE_FORMAT_FLOAT32, 2 },
+    { "compresor 8 can.",       BENCH_CHAIN_COMPRESSOR, SAMPLE_FORMAT_FLOAT32, 8 },
+    { "limitador est.",         BENCH_CHAIN_LIMITER,    SAMPLE_FORMAT_FLOAT32, 2 },
+    { "limitador 8 can.",       BENCH_CHAIN_LIMITER,    SAMPLE_FORMAT_FLOAT32, 8 },
+    { "voz float32 mono",       BENCH_CHAIN_VOICE,      SAMPLE_FORMAT_FLOAT32, 1 },
+    { "voz float32 est.",       BENCH_CHAIN_VOICE,      SAMPLE_FORMAT_FLOAT32, 2 },
+    { "voz int16 est.",         BENCH_CHAIN_VOICE,      SAMPLE_FORMAT_INT16,   2 },
+    { "voz float32 8 can.",     BENCH_CHAIN_VOICE,      SAMPLE_FORMAT_FLOAT32, 8 },
+};
+
+#define BENCH_CASE_COUNT (sizeof(g_Cases) / sizeof(g_Cases[0]))
+
+static const ULONG g_CallFrames[] = { 8, 64, 480 };
+
+#define BENCH_CALL_COUNT (sizeof(g_CallFrames) / sizeof(g_CallFrames[0]))
+
+static UCHAR g_Memory[1 << 17];
+static float g_Packet[BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS];
+static float g_Work[BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS];
+
+static DSP_STAGE_CONFIG *AddStage(DSP_CHAIN_CONFIG *config, DSP_STAGE_TYPE type)
+{
+    DSP_STAGE_CONFIG *stage = &config->Stage[config->Stages++];
+
+    stage->Type = type;
+    stage->AttackMs = 5.0f;
+    stage->ReleaseMs = 100.0f;
+    stage->ThresholdDb = -24.0f;
+    stage->Ratio = 4.0f;
+    stage->KneeDb = 6.0f;
+    stage->MakeupDb = 6.0f;
+    stage->CeilingDb = -1.0f;
+    stage->LookaheadMs = 5.0f;
+    return stage;
+}
+
+static VOID AddEq(DSP_CHAIN_CONFIG *config, ULONG bands)
+{
+    DSP_STAGE_CONFIG *stage = AddStage(config, DSP_STAGE_EQ);
+    ULONG i;
+
+    stage->Bands = bands;
+    for (i = 0; i < bands; i++) {
+        stage->Band[i].Shape = DSP_EQ_PEAKING;
+        stage->Band[i].Frequency = 100.0f * (float)(1 << i);
+        stage->Band[i].Q = 1.0f;
+        stage->Band[i].GainDb = (i & 1) ? -3.0f : 4.0f;
+    }
+}
+
+static VOID BuildConfig(const BENCH_CASE *Case, SAMPLE_CONVERT_ISA isa, DSP_CHAIN_CONFIG *config)
+{
+    DSP_STAGE_CONFIG *stage;
+
+    memset(config, 0, sizeof(*config));
+    config->SampleRate = BENCH_RATE;
+    config->Channels = Case->Channels;
+    config->Format = Case->Format;
+    config->Isa = isa;
+
+    switch (Case->Chain) {
+    case BENCH_CHAIN_EQ1:
+        AddEq(config, 1);
+        break;
+    case BENCH_CHAIN_EQ4:
+        AddEq(config, 4);
+        break;
+    case BENCH_CHAIN_EQ8:
+        AddEq(config, 8);
+        break;
+    case BENCH_CHAIN_COMPRESSOR:
+        AddStage(config, DSP_STAGE_COMPRESSOR);
+        break;
+    case BENCH_CHAIN_LIMITER:
+        AddStage(config, DSP_STAGE_LIMITER);
+        break;
+    default:
+        stage = AddStage(config, DSP_STAGE_EQ);
+        stage->Bands = 1;
+        stage->Band[0].Shape = DSP_EQ_HIGH_PASS;
+        stage->Band[0].Frequency = 80.0f;
+        stage->Band[0].Q = 0.7071f;
+        AddEq(config, 4);
+        AddStage(config, DSP_STAGE_COMPRESSOR);
+        AddStage(config, DSP_STAGE_LIMITER);
+        break;
+    }
+}
+
+// Nanosegundos por frame procesando en llamadas de callFrames frames
+static double Run(const BENCH_CASE *Case, SAMPLE_CONVERT_ISA isa, ULONG callFrames, ULONG64 totalFrames)
+{
+    DSP_CHAIN_CONFIG config;
+    PDSP_CHAIN chain;
+    ULONG64 packets = totalFrames / BENCH_PACKET_FRAMES;
+    ULONG frameBytes = SampleFormatGetBytes(Case->Format) * Case->Channels;
+    ULONG64 start;
+    ULONG64 i;
+    ULONG offset;
+
+    BuildConfig(Case, isa, &config);
+    if (!NT_SUCCESS(DspChainInitialize(g_Memory, sizeof(g_Memory), &config, &chain))) {
+        return 0.0;
+    }
+
+    if (packets == 0) {
+        packets = 1;
+    }
+
+    start = BenchNowNs();
+    for (i = 0; i < packets; i++) {
+        // Cada paquete parte de la misma señal (los datos enteros son bytes arbitrarios)
+        memcpy(g_Work, g_Packet, (SIZE_T)BENCH_PACKET_FRAMES * frameBytes);
+        for (offset = 0; offset < BENCH_PACKET_FRAMES; offset += callFrames) {
+            DspChainProcess(chain, (PUCHAR)g_Work + (SIZE_T)offset * frameBytes, callFrames);
+        }
+        BenchDoNotOptimize(g_Work);
+    }
+
+    return (double)(BenchNowNs() - start) / (double)(packets * BENCH_PACKET_FRAMES);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 totalFrames = (ULONG64)(BENCH_BASE_FRAMES * BenchScale(argc, argv));
+    BOOLEAN sse2 = SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2);
+    SAMPLE_CONVERT_ISA best = sse2 ? SAMPLE_CONVERT_ISA_SSE2 : SAMPLE_CONVERT_ISA_SCALAR;
+    double scalar;
+    double vector;
+    double fastest;
+    ULONG i;
+    ULONG k;
+
+    // Voz sintética: dos senos con la envolvente subiendo por encima del umbral
+    for (i = 0; i < BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS; i++) {
+        g_Packet[i] = (float)((i * 7919) % 2001) / 2000.0f - 0.5f;
+        g_Packet[i] *= 0.2f + 1.6f * (float)i / (BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS);
+    }
+
+    totalFrames /= BENCH_CASE_COUNT * 2;
+
+    printf("=== Cadena de procesado en la lectura: paquetes de %u frames a %u Hz ===\n",
+           BENCH_PACKET_FRAMES, BENCH_RATE);
+    printf("%-22s %12s %12s %12s %12s %10s\n",
+           "caso", "escalar ns/f", "SSE2 ns/f", "aceleración", "us/paquete", "% de 10 ms");
+
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+        scalar = Run(&g_Cases[i], SAMPLE_CONVERT_ISA_SCALAR, BENCH_PACKET_FRAMES, totalFrames);
+        vector = sse2 ? Run(&g_Cases[i], SAMPLE_CONVERT_ISA_SSE2, BENCH_PACKET_FRAMES, totalFrames) : 0.0;
+        fastest = sse2 ? vector : scalar;
+
+        printf("%-22s %12.3f %12.3f %11.2fx %12.3f %9.2f%%\n", g_Cases[i].Name, scalar, vector,
+               sse2 ? scalar / vector : 1.0, fastest * BENCH_PACKET_FRAMES / 1000.0,
+               fastest * BENCH_PACKET_FRAMES / 1e5);
+    }
+
+    printf("\n=== Cadena de voz por tamaño de llamada (%s) ===\n", sse2 ? "SSE2" : "escalar");
+    printf("%-22s", "caso");
+    for (k = 0; k < BENCH_CALL_COUNT; k++) {
+        printf(" %9u f/ll", g_CallFrames[k]);
+    }
+    printf("\n");
+
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+        if (g_Cases[i].Chain != BENCH_CHAIN_VOICE) {
+            continue;
+        }
+
+        printf("%-22s", g_Cases[i].Name);
+        for (k = 0; k < BENCH_CALL_COUNT; k++) {
+            printf(" %9.3f ns/f", Run(&g_Cases[i], best, g_CallFrames[k], totalFrames / BENCH_CALL_COUNT));
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
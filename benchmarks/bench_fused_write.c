@@ -0,0 +1,182 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "fused_write.h"
+
+// Escritura en el anillo por etapas frente a fusionada, como en
+// WriteInputFramesToRing: paquetes de 10 ms a 48 kHz convertidos (y
+// mezclados) al anillo y medidos. Por etapas es SampleConvertWriteRing o
+// ChannelMixWriteRing seguidos de LevelMeterProcessRing; fusionada,
+// FusedWriteRing. El lector descarta lo escrito, así que el anillo nunca se
+// llena. Se da en ns y ciclos de TSC por frame y en GB/s de datos movidos
+// (bytes de entrada más bytes escritos en el anillo). Las dos variantes se
+// alternan en varias rondas y se queda la mejor de cada una, para que el
+// ruido de otras cargas de la máquina no caiga solo en una.
+
+#define BENCH_PACKET_FRAMES 480
+#define BENCH_RING_FRAMES   8192
+#define BENCH_MAX_CHANNELS  8
+#define BENCH_BASE_FRAMES   100000000ULL
+#define BENCH_ROUNDS        5
+
+typedef struct _BENCH_CASE {
+    const char *Name;
+    SAMPLE_FORMAT Source;
+    SAMPLE_FORMAT Device;
+    ULONG Inputs;
+    ULONG Outputs;       // Igual a Inputs: sin mezcla
+    BOOLEAN Metering;
+} BENCH_CASE;
+
+static const BENCH_CASE g_Cases[] = {
+    { "int16 est. + medidor",      SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_INT16,   2, 2, TRUE },
+    { "int16 -> float32 + med.",   SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_FLOAT32, 2, 2, TRUE },
+    { "float32 -> int16 + med.",   SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_INT16,   2, 2, TRUE },
+    { "float32 8 can. + med.",     SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32, 8, 8, TRUE },
+    { "mono -> est. int16",        SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_INT16,   1, 2, FALSE },
+    { "mono -> est. + med.",       SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_FLOAT32, 1, 2, TRUE },
+    { "est. -> mono + med.",       SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_INT16,   2, 1, TRUE },
+    { "5.1 -> est. float32",       SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32, 6, 2, FALSE },
+    { "5.1 int16 -> est. + med.",  SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_INT16,   6, 2, TRUE },
+    { "7.1 int32 -> est. + med.",  SAMPLE_FORMAT_INT32,   SAMPLE_FORMAT_FLOAT32, 8, 2, TRUE },
+};
+
+#define BENCH_CASE_COUNT (sizeof(g_Cases) / sizeof(g_Cases[0]))
+
+typedef struct _BENCH_RESULT {
+    double NsPerFrame;
+    double CyclesPerFrame;
+} BENCH_RESULT;
+
+static CHANNEL_MIX g_Mix;
+static float g_Packet[BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS];
+static float g_Storage[BENCH_RING_FRAMES * BENCH_MAX_CHANNELS];
+
+static BOOLEAN Run(const BENCH_CASE *Case, BOOLEAN fused, ULONG64 totalFrames, BENCH_RESULT *Result)
+{
+    SAMPLE_CONVERTER converter;
+    CHANNEL_MIX_CONFIG mixConfig;
+    PCHANNEL_MIX mix = NULL;
+    LEVEL_METER meter;
+    PLEVEL_METER activeMeter = Case->Metering ? &meter : NULL;
+    RING_BUFFER ring;
+    FUSED_WRITE write;
+    SAMPLE_CONVERT_ISA isa = SampleConvertGetBestIsa();
+    ULONG64 packets = totalFrames / BENCH_PACKET_FRAMES;
+    ULONG64 start;
+    ULONG64 cycles;
+    ULONG64 head;
+    ULONG64 i;
+
+    memset(&mixConfig, 0, sizeof(mixConfig));
+    mixConfig.InputChannels = Case->Inputs;
+    mixConfig.OutputChannels = Case->Outputs;
+    mixConfig.SourceFormat = Case->Source;
+    mixConfig.TargetFormat = Case->Device;
+    mixConfig.Isa = isa;
+
+    if (!NT_SUCCESS(SampleConverterInitialize(&converter, Case->Source, Case->Device, Case->Outputs, isa)) ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, BENCH_RING_FRAMES,
+                                         SampleFormatGetBytes(Case->Device) * Case->Outputs)) ||
+        !NT_SUCCESS(LevelMeterInitialize(&meter, Case->Device, Case->Outputs, isa))) {
+        return FALSE;
+    }
+
+    if (Case->Inputs != Case->Outputs) {
+        if (!NT_SUCCESS(ChannelMixInitialize(&g_Mix, &mixConfig))) {
+            return FALSE;
+        }
+        mix = &g_Mix;
+    }
+
+    if (fused && !FusedWriteSelect(&write, &converter, mix, activeMeter, isa)) {
+        return FALSE;
+    }
+
+    if (packets == 0) {
+        packets = 1;
+    }
+
+    start = BenchNowNs();
+    cycles = BenchNowCycles();
+    for (i = 0; i < packets; i++) {
+        if (fused) {
+            FusedWriteRing(&write, &ring, g_Packet, BENCH_PACKET_FRAMES);
+        } else {
+            head = ring.Head;
+            if (mix != NULL) {
+                ChannelMixWriteRing(mix, NULL, &ring, g_Packet, BENCH_PACKET_FRAMES);
+            } else {
+                SampleConvertWriteRing(&ring, &converter, g_Packet, BENCH_PACKET_FRAMES);
+            }
+            if (activeMeter != NULL) {
+                LevelMeterProcessRing(activeMeter, &ring, head, (ULONG)(ring.Head - head));
+            }
+        }
+        RingBufferDiscard(&ring, BENCH_PACKET_FRAMES);
+        BenchDoNotOptimize(&meter);
+    }
+
+    cycles = BenchNowCycles() - cycles;
+    Result->NsPerFrame = (double)(BenchNowNs() - start) / (double)(packets * BENCH_PACKET_FRAMES);
+    Result->CyclesPerFrame = (double)cycles / (double)(packets * BENCH_PACKET_FRAMES);
+    return TRUE;
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 totalFrames = (ULONG64)(BENCH_BASE_FRAMES * BenchScale(argc, argv));
+    BENCH_RESULT staged;
+    BENCH_RESULT fused;
+    BENCH_RESULT round;
+    BOOLEAN supported;
+    double bytesPerFrame;
+    ULONG i;
+    ULONG r;
+
+    if (SampleConvertGetBestIsa() == SAMPLE_CONVERT_ISA_SCALAR) {
+        printf("CPU sin SSE2: no hay escritura fusionada\n");
+        return 0;
+    }
+
+    // Ruido de amplitud media en cualquier formato (bytes arbitrarios en enteros)
+    for (i = 0; i < BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS; i++) {
+        g_Packet[i] = (float)((i * 7919) % 2001) / 2000.0f - 0.5f;
+    }
+
+    totalFrames /= BENCH_CASE_COUNT * 2 * BENCH_ROUNDS;
+
+    printf("=== Escritura por etapas frente a fusionada: paquetes de %u frames ===\n", BENCH_PACKET_FRAMES);
+    printf("%-26s %10s %10s %10s %10s %10s %10s %9s\n",
+           "caso", "etapas ns/f", "fus. ns/f", "etapas c/f", "fus. c/f", "etapas GB/s", "fus. GB/s", "aceler.");
+
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+        supported = TRUE;
+        for (r = 0; r < BENCH_ROUNDS && supported; r++) {
+            supported = Run(&g_Cases[i], FALSE, totalFrames, &round);
+            if (r == 0 || round.NsPerFrame < staged.NsPerFrame) {
+                staged = round;
+            }
+
+            supported = supported && Run(&g_Cases[i], TRUE, totalFrames, &round);
+            if (r == 0 || round.NsPerFrame < fused.NsPerFrame) {
+                fused = round;
+            }
+        }
+
+        if (!supported) {
+            printf("%-26s sin especialización\n", g_Cases[i].Name);
+            continue;
+        }
+
+        bytesPerFrame = (double)(SampleFormatGetBytes(g_Cases[i].Source) * g_Cases[i].Inputs +
+                                 SampleFormatGetBytes(g_Cases[i].Device) * g_Cases[i].Outputs);
+
+        printf("%-26s %10.3f %10.3f %10.2f %10.2f %10.2f %10.2f %8.2fx\n", g_Cases[i].Name,
+               staged.NsPerFrame, fused.NsPerFrame, staged.CyclesPerFrame, fused.CyclesPerFrame,
+               bytesPerFrame / staged.NsPerFrame, bytesPerFrame / fused.NsPerFrame,
+               staged.NsPerFrame / fused.NsPerFrame);
+    }
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "gain_ramp.h"
+
+// Coste por frame de la ganancia de salida (estéreo, bloques de 10 ms a
+// 48 kHz, en el sitio) con la referencia escalar y con SSE2: rampa continua,
+// ganancia constante, y los dos estados estables que el lector resuelve sin
+// multiplicar (unidad: nada; silencio: solo relleno con ceros).
+
+#define BENCH_BLOCK_FRAMES 480
+#define BENCH_CHANNELS     2
+#define BENCH_BASE_FRAMES  200000000ULL
+
+typedef enum _BENCH_MODE {
+    BENCH_MODE_RAMP = 0,
+    BENCH_MODE_CONSTANT,
+    BENCH_MODE_UNITY,
+    BENCH_MODE_SILENT,
+    BENCH_MODE_COUNT
+} BENCH_MODE;
+
+static const char *g_ModeNames[BENCH_MODE_COUNT] = { "rampa", "constante", "unidad", "silencio" };
+static const char *g_FormatNames[SAMPLE_FORMAT_COUNT] = { "int16", "int24", "int32", "float32" };
+
+static LONG g_Block[BENCH_BLOCK_FRAMES * BENCH_CHANNELS];
+
+// Nanosegundos por frame
+static double Run(SAMPLE_FORMAT format, SAMPLE_CONVERT_ISA isa, BENCH_MODE mode, ULONG64 totalFrames)
+{
+    GAIN_RAMP ramp;
+    ULONG64 blocks = totalFrames / BENCH_BLOCK_FRAMES;
+    ULONG64 start;
+    ULONG64 i;
+
+    if (!NT_SUCCESS(GainRampInitialize(&ramp, (mode == BENCH_MODE_CONSTANT) ? 0.5f : 1.0f, isa))) {
+        return 0.0;
+    }
+
+    if (mode == BENCH_MODE_SILENT) {
+        GainRampSetTarget(&ramp, 0.0f, 0);
+    }
+
+    if (blocks == 0) {
+        blocks = 1;
+    }
+
+    start = BenchNowNs();
+    for (i = 0; i < blocks; i++) {
+        // La rampa se reinicia con cada bloque para no llegar nunca al estado estable
+        if (mode == BENCH_MODE_RAMP) {
+            GainRampSetTarget(&ramp, (i & 1) ? 1.0f : 0.25f, BENCH_BLOCK_FRAMES);
+        }
+
+        // Lo mismo que hace ReadAudioFromBuffer con cada lectura
+        if (GainRampIsSilent(&ramp)) {
+            memset(g_Block, 0, sizeof(g_Block));
+        } else if (!GainRampIsUnity(&ramp)) {
+            GainRampApply(&ramp, format, BENCH_CHANNELS, g_Block, BENCH_BLOCK_FRAMES);
+        }
+        BenchDoNotOptimize(g_Block);
+    }
+
+    return (double)(BenchNowNs() - start) / (double)(blocks * BENCH_BLOCK_FRAMES);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 totalFrames = (ULONG64)(BENCH_BASE_FRAMES * BenchScale(argc, argv));
+    BOOLEAN sse2 = SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2);
+    SAMPLE_FORMAT format;
+    BENCH_MODE mode;
+    ULONG i;
+
+    for (i = 0; i < BENCH_BLOCK_FRAMES * BENCH_CHANNELS; i++) {
+        g_Block[i] = (LONG)((i * 2654435761UL) >> 8);
+    }
+
+    // Cada combinación mide el mismo número de frames
+    totalFrames /= SAMPLE_FORMAT_COUNT * BENCH_MODE_COUNT;
+
+    printf("=== Ganancia de salida: estéreo, bloques de %u frames ===\n", BENCH_BLOCK_FRAMES);
+    printf("%-8s %-10s %14s %14s\n", "formato", "modo", "escalar ns/f", "SSE2 ns/f");
+
+    for (format = SAMPLE_FORMAT_INT16; format < SAMPLE_FORMAT_COUNT; format++) {
+        for (mode = BENCH_MODE_RAMP; mode < BENCH_MODE_COUNT; mode++) {
+            printf("%-8s %-10s %14.3f %14.3f\n", g_FormatNames[format], g_ModeNames[mode],
+                   Run(format, SAMPLE_CONVERT_ISA_SCALAR, mode, totalFrames),
+                   sse2 ? Run(format, SAMPLE_CONVERT_ISA_SSE2, mode, totalFrames) : 0.0);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "ioctl_dispatch.h"
+#include "ring_buffer.h"
+
+// Coste del despacho de IOCTL con IRP falsos: la cadena de case de antes,
+// la tabla sin contabilidad y la tabla con contabilidad (IoctlDispatcherCall),
+// para un envío de 10 ms estéreo int16 (escritura y lectura del anillo) y un
+// GET_STATS. Al final imprime lo que devolvería GET_IOCTL_STATS de la última
+// ronda. Se da el mejor de varios intentos alternos.
+
+#define BENCH_CTL_CODE(function) ((0x22UL << 16) | ((ULONG)(function) << 2))
+
+#define BENCH_IOCTL_SEND_AUDIO BENCH_CTL_CODE(0x800)
+#define BENCH_IOCTL_SET_FORMAT BENCH_CTL_CODE(0x801)
+#define BENCH_IOCTL_GET_STATS  BENCH_CTL_CODE(0x802)
+#define BENCH_IOCTL_MUTE       BENCH_CTL_CODE(0x803)
+#define BENCH_IOCTL_SET_GAIN   BENCH_CTL_CODE(0x80C)
+#define BENCH_IOCTL_METERING   BENCH_CTL_CODE(0x80F)
+
+#define BENCH_RING_FRAMES  (1 << 14)
+#define BENCH_PACKET       480
+#define BENCH_BASE_CALLS   1000000ULL
+#define BENCH_ROUNDS       5
+
+struct _DEVICE_OBJECT {
+    RING_BUFFER Ring;
+    ULONG64 Calls;
+};
+
+struct _IRP {
+    ULONG IoControlCode;
+    ULONG InputLength;
+    PVOID SystemBuffer;
+    ULONG_PTR Information;
+};
+
+typedef struct _BENCH_STATS {
+    ULONG64 SamplesProcessed;
+    ULONG BufferUsage;
+    ULONG Underruns;
+    ULONG Overruns;
+    ULONG64 UptimeMs;
+} BENCH_STATS;
+
+static SHORT g_Storage[BENCH_RING_FRAMES * 2];
+static SHORT g_Packet[BENCH_PACKET * 2];
+static SHORT g_Output[BENCH_PACKET * 2];
+static BENCH_STATS g_Stats;
+static struct _DEVICE_OBJECT g_Device;
+static IOCTL_DISPATCHER g_Dispatcher;
+
+static NTSTATUS __attribute__((noinline)) BenchSendAudio(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    ULONG frames = RingBufferWrite(&DeviceObject->Ring, Irp->SystemBuffer, Irp->InputLength / (2 * sizeof(SHORT)));
+
+    // El lector del otro extremo, para que el anillo no se llene
+    RingBufferRead(&DeviceObject->Ring, g_Output, frames);
+    Irp->Information = frames * 2 * sizeof(SHORT);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS __attribute__((noinline)) BenchGetStats(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    BENCH_STATS *stats = (BENCH_STATS *)Irp->SystemBuffer;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->SamplesProcessed = DeviceObject->Calls++;
+    stats->BufferUsage = RingBufferGetUsedFrames(&DeviceObject->Ring);
+    Irp->Information = sizeof(*stats);
+    return STATUS_SUCCESS;
+}
+
+static NTSTATUS __attribute__((noinline)) BenchOther(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    DeviceObject->Calls++;
+    Irp->Information = 0;
+    return STATUS_SUCCESS;
+}
+
+// Mismo orden que la tabla del driver: los códigos medidos no van primero
+static const IOCTL_DISPATCH_ENTRY g_Table[] = {
+    { BENCH_IOCTL_SET_FORMAT, BenchOther },
+    { BENCH_IOCTL_MUTE,       BenchOther },
+    { BENCH_IOCTL_SET_GAIN,   BenchOther },
+    { BENCH_IOCTL_METERING,   BenchOther },
+    { BENCH_IOCTL_SEND_AUDIO, BenchSendAudio },
+    { BENCH_IOCTL_GET_STATS,  BenchGetStats }
+};
+
+#define BENCH_TABLE_ENTRIES (sizeof(g_Table) / sizeof(g_Table[0]))
+
+typedef enum _BENCH_MODE {
+    BENCH_MODE_SWITCH = 0,
+    BENCH_MODE_TABLE,
+    BENCH_MODE_ACCOUNTED,
+    BENCH_MODE_COUNT
+} BENCH_MODE;
+
+static const char *g_ModeNames[BENCH_MODE_COUNT] = { "switch", "tabla", "tabla + contadores" };
+
+static NTSTATUS __attribute__((noinline)) DispatchSwitch(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    switch (Irp->IoControlCode) {
+        case BENCH_IOCTL_SET_FORMAT:
+        case BENCH_IOCTL_MUTE:
+        case BENCH_IOCTL_SET_GAIN:
+        case BENCH_IOCTL_METERING:
+            return BenchOther(DeviceObject, Irp);
+
+        case BENCH_IOCTL_SEND_AUDIO:
+            return BenchSendAudio(DeviceObject, Irp);
+
+        case BENCH_IOCTL_GET_STATS:
+            return BenchGetStats(DeviceObject, Irp);
+
+        default:
+            return STATUS_INVALID_DEVICE_REQUEST;
+    }
+}
+
+static NTSTATUS __attribute__((noinline)) DispatchTable(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    const IOCTL_DISPATCH_ENTRY *entry = IoctlDispatcherLookup(&g_Dispatcher, Irp->IoControlCode);
+
+    return (entry != NULL) ? entry->Handler(DeviceObject, Irp) : STATUS_INVALID_DEVICE_REQUEST;
+}
+
+static NTSTATUS __attribute__((noinline)) DispatchAccounted(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    const IOCTL_DISPATCH_ENTRY *entry = IoctlDispatcherLookup(&g_Dispatcher, Irp->IoControlCode);
+
+    if (entry == NULL) {
+        return STATUS_INVALID_DEVICE_REQUEST;
+    }
+
+    return IoctlDispatcherCall(&g_Dispatcher, entry, DeviceObject, Irp, Irp->InputLength, &Irp->Information);
+}
+
+static double Run(BENCH_MODE Mode, ULONG Code, ULONG64 Calls)
+{
+    struct _IRP irp;
+    unsigned long long start;
+    ULONG64 i;
+
+    RingBufferInitialize(&g_Device.Ring, g_Storage, BENCH_RING_FRAMES, 2 * sizeof(SHORT));
+    IoctlDispatcherInitialize(&g_Dispatcher, g_Table, BENCH_TABLE_ENTRIES);
+
+    irp.IoControlCode = Code;
+    irp.InputLength = (Code == BENCH_IOCTL_SEND_AUDIO) ? sizeof(g_Packet) : 0;
+    irp.SystemBuffer = (Code == BENCH_IOCTL_SEND_AUDIO) ? (PVOID)g_Packet : (PVOID)&g_Stats;
+
+    start = BenchNowNs();
+
+    for (i = 0; i < Calls; i++) {
+        irp.Information = 0;
+        switch (Mode) {
+            case BENCH_MODE_SWITCH:
+                DispatchSwitch(&g_Device, &irp);
+                break;
+            case BENCH_MODE_TABLE:
+                DispatchTable(&g_Device, &irp);
+                break;
+            default:
+                DispatchAccounted(&g_Device, &irp);
+                break;
+        }
+        BenchDoNotOptimize(&irp);
+    }
+
+    return (double)(BenchNowNs() - start) / (double)Calls;
+}
+
+static void RunCode(const char *Name, ULONG Code, ULONG64 Calls)
+{
+    double best[BENCH_MODE_COUNT];
+    double ns;
+    ULONG round;
+    ULONG mode;
+
+    for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+        best[mode] = 1e30;
+    }
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+            ns = Run((BENCH_MODE)mode, Code, Calls);
+            best[mode] = min(best[mode], ns);
+        }
+    }
+
+    printf("\n--- %s ---\n", Name);
+    printf("%-20s %12s %12s\n", "despacho", "ns/llamada", "coste ns");
+    for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+        printf("%-20s %12.2f %12.2f\n", g_ModeNames[mode], best[mode], best[mode] - best[BENCH_MODE_SWITCH]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 calls = (ULONG64)(BENCH_BASE_CALLS * BenchScale(argc, argv));
+    IOCTL_STATS_HEADER header;
+    IOCTL_CALL_STATS stats[BENCH_TABLE_ENTRIES];
+    struct _IRP irp;
+    ULONG entries;
+    ULONG i;
+
+    memset(g_Packet, 0x11, sizeof(g_Packet));
+
+    printf("=== Despacho de IOCTL con IRP falsos (%u entradas) ===\n", (unsigned)BENCH_TABLE_ENTRIES);
+    RunCode("GET_STATS", BENCH_IOCTL_GET_STATS, calls);
+    RunCode("SEND_AUDIO (480 frames estéreo int16)", BENCH_IOCTL_SEND_AUDIO, calls);
+
+    // Lo que vería GET_IOCTL_STATS tras una mezcla de llamadas
+    RingBufferInitialize(&g_Device.Ring, g_Storage, BENCH_RING_FRAMES, 2 * sizeof(SHORT));
+    IoctlDispatcherInitialize(&g_Dispatcher, g_Table, BENCH_TABLE_ENTRIES);
+    for (i = 0; i < 100000; i++) {
+        irp.IoControlCode = (i % 10 == 0) ? BENCH_IOCTL_GET_STATS : BENCH_IOCTL_SEND_AUDIO;
+        irp.InputLength = (irp.IoControlCode == BENCH_IOCTL_SEND_AUDIO) ? sizeof(g_Packet) : 0;
+        irp.SystemBuffer = (irp.IoControlCode == BENCH_IOCTL_SEND_AUDIO) ? (PVOID)g_Packet : (PVOID)&g_Stats;
+        DispatchAccounted(&g_Device, &irp);
+    }
+
+    entries = IoctlDispatcherGetStats(&g_Dispatcher, &header, stats, BENCH_TABLE_ENTRIES);
+
+    printf("\n--- GET_IOCTL_STATS tras 100000 llamadas (90 %% SEND_AUDIO) ---\n");
+    printf("%-10s %10s %8s %12s %12s %10s %10s\n", "código", "llamadas", "errores", "bytes in", "bytes out",
+           "ns medio", "ns máx");
+    for (i = 0; i < entries; i++) {
+        if (stats[i].Calls == 0) {
+            continue;
+        }
+        printf("0x%08X %10llu %8llu %12llu %12llu %10.1f %10llu\n", stats[i].IoControlCode,
+               (unsigned long long)stats[i].Calls, (unsigned long long)stats[i].Errors,
+               (unsigned long long)stats[i].BytesIn, (unsigned long long)stats[i].BytesOut,
+               (double)stats[i].TotalTimeNs / (double)stats[i].Calls, (unsigned long long)stats[i].MaxTimeNs);
+    }
+
+    return 0;
+}
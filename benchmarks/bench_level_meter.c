@@ -0,0 +1,112 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "level_meter.h"
+
+// Coste de los medidores de nivel sobre la escritura en el anillo: paquetes de
+// 10 ms a 48 kHz copiados (o convertidos) al anillo como en
+// WriteInputFramesToRing, sin medir y midiendo después los frames escritos con
+// la referencia escalar y con SSE2. El lector descarta lo escrito, así que el
+// anillo nunca se llena. La sobrecarga se da relativa a la copia sola y en
+// microsegundos por paquete de 10 ms (con la variante más rápida).
+
+#define BENCH_PACKET_FRAMES 480
+#define BENCH_RING_FRAMES   8192
+#define BENCH_MAX_CHANNELS  8
+#define BENCH_BASE_FRAMES   100000000ULL
+
+typedef struct _BENCH_CASE {
+    const char *Name;
+    SAMPLE_FORMAT Source;
+    SAMPLE_FORMAT Device;
+    ULONG Channels;
+} BENCH_CASE;
+
+static const BENCH_CASE g_Cases[] = {
+    { "int16 estéreo",          SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_INT16,   2 },
+    { "int16 -> float32 est.",  SAMPLE_FORMAT_INT16,   SAMPLE_FORMAT_FLOAT32, 2 },
+    { "int24 estéreo",          SAMPLE_FORMAT_INT24,   SAMPLE_FORMAT_INT24,   2 },
+    { "int32 estéreo",          SAMPLE_FORMAT_INT32,   SAMPLE_FORMAT_INT32,   2 },
+    { "float32 estéreo",        SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32, 2 },
+    { "float32 6 canales",      SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32, 6 },
+    { "float32 8 canales",      SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32, 8 },
+};
+
+#define BENCH_CASE_COUNT (sizeof(g_Cases) / sizeof(g_Cases[0]))
+
+static float g_Packet[BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS];
+static float g_Storage[BENCH_RING_FRAMES * BENCH_MAX_CHANNELS];
+
+// Nanosegundos por frame; Isa COUNT = sin medidores
+static double Run(const BENCH_CASE *Case, SAMPLE_CONVERT_ISA isa, ULONG64 totalFrames)
+{
+    SAMPLE_CONVERTER converter;
+    LEVEL_METER meter;
+    RING_BUFFER ring;
+    ULONG64 packets = totalFrames / BENCH_PACKET_FRAMES;
+    ULONG64 start;
+    ULONG64 head;
+    ULONG64 i;
+
+    if (!NT_SUCCESS(SampleConverterInitialize(&converter, Case->Source, Case->Device, Case->Channels,
+                                              SampleConvertGetBestIsa())) ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, BENCH_RING_FRAMES,
+                                         SampleFormatGetBytes(Case->Device) * Case->Channels))) {
+        return 0.0;
+    }
+
+    if (isa != SAMPLE_CONVERT_ISA_COUNT &&
+        !NT_SUCCESS(LevelMeterInitialize(&meter, Case->Device, Case->Channels, isa))) {
+        return 0.0;
+    }
+
+    if (packets == 0) {
+        packets = 1;
+    }
+
+    start = BenchNowNs();
+    for (i = 0; i < packets; i++) {
+        head = ring.Head;
+        SampleConvertWriteRing(&ring, &converter, g_Packet, BENCH_PACKET_FRAMES);
+        if (isa != SAMPLE_CONVERT_ISA_COUNT) {
+            LevelMeterProcessRing(&meter, &ring, head, (ULONG)(ring.Head - head));
+        }
+        RingBufferDiscard(&ring, BENCH_PACKET_FRAMES);
+        BenchDoNotOptimize(&meter);
+    }
+
+    return (double)(BenchNowNs() - start) / (double)(packets * BENCH_PACKET_FRAMES);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 totalFrames = (ULONG64)(BENCH_BASE_FRAMES * BenchScale(argc, argv));
+    BOOLEAN sse2 = SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2);
+    double copy;
+    double scalar;
+    double vector;
+    ULONG i;
+
+    // Ruido de amplitud media en cualquier formato (bytes arbitrarios en enteros)
+    for (i = 0; i < BENCH_PACKET_FRAMES * BENCH_MAX_CHANNELS; i++) {
+        g_Packet[i] = (float)((i * 7919) % 2001) / 2000.0f - 0.5f;
+    }
+
+    totalFrames /= BENCH_CASE_COUNT * 3;
+
+    printf("=== Medidores de nivel en la escritura: paquetes de %u frames ===\n", BENCH_PACKET_FRAMES);
+    printf("%-22s %10s %12s %12s %10s %10s %12s\n",
+           "caso", "copia ns/f", "escalar ns/f", "SSE2 ns/f", "+escalar", "+SSE2", "+us/paquete");
+
+    for (i = 0; i < BENCH_CASE_COUNT; i++) {
+        copy = Run(&g_Cases[i], SAMPLE_CONVERT_ISA_COUNT, totalFrames);
+        scalar = Run(&g_Cases[i], SAMPLE_CONVERT_ISA_SCALAR, totalFrames);
+        vector = sse2 ? Run(&g_Cases[i], SAMPLE_CONVERT_ISA_SSE2, totalFrames) : 0.0;
+
+        printf("%-22s %10.3f %12.3f %12.3f %9.0f%% %9.0f%% %12.3f\n", g_Cases[i].Name, copy, scalar, vector,
+               (scalar / copy - 1.0) * 100.0, sse2 ? (vector / copy - 1.0) * 100.0 : 0.0,
+               ((sse2 ? vector : scalar) - copy) * BENCH_PACKET_FRAMES / 1000.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <string.h>
+
+#include "bench_common.h"
+#include "mirror_buffer.h"
+#include "ring_buffer.h"
+
+// Copia partida (firstChunk/secondChunk) frente a anillo espejo de una sola
+// copia, con paquetes grandes y de tamaño impar que cruzan el wrap-around.
+
+#define BENCH_RING_SIZE (256 * 1024)
+#define BENCH_BASE_BYTES (1024ULL * 1024 * 1024)
+
+static double RunCase(PRING_BUFFER ring, PUCHAR packet, ULONG packetSize, ULONG64 totalBytes)
+{
+    ULONG64 done = 0;
+    double start = BenchNowSeconds();
+
+    while (done < totalBytes) {
+        RingBufferWrite(ring, packet, packetSize);
+        RingBufferRead(ring, packet, packetSize);
+        done += packetSize;
+    }
+
+    BenchDoNotOptimize(packet);
+    return (double)totalBytes / (BenchNowSeconds() - start) / (1024.0 * 1024.0);
+}
+
+int main(int argc, char **argv)
+{
+    static const ULONG packetSizes[] = { 997, 1921, 4099, 16411, 65537, 131071 };
+    MIRROR_BUFFER mirror;
+    RING_BUFFER splitRing;
+    RING_BUFFER mirroredRing;
+    PUCHAR splitStorage;
+    PUCHAR packet;
+    ULONG64 totalBytes = (ULONG64)(BENCH_BASE_BYTES * BenchScale(argc, argv));
+    size_t i;
+
+    if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, BENCH_RING_SIZE))) {
+        printf("No se pudo crear el buffer espejo\n");
+        return 1;
+    }
+
+    splitStorage = (PUCHAR)malloc(BENCH_RING_SIZE);
+    packet = (PUCHAR)malloc(BENCH_RING_SIZE);
+    memset(packet, 0x42, BENCH_RING_SIZE);
+
+    printf("=== Benchmark anillo espejo vs copia partida (anillo de %u KiB, %llu MiB por caso) ===\n",
+           BENCH_RING_SIZE / 1024, (unsigned long long)(totalBytes >> 20));
+    printf("%-10s %18s %18s %10s\n", "paquete", "partida MiB/s", "espejo MiB/s", "speedup");
+
+    for (i = 0; i < sizeof(packetSizes) / sizeof(packetSizes[0]); i++) {
+        double splitRate;
+        double mirroredRate;
+
+        RingBufferInitialize(&splitRing, splitStorage, BENCH_RING_SIZE, 1);
+        splitRate = RunCase(&splitRing, packet, packetSizes[i], totalBytes);
+
+        RingBufferInitializeMirrored(&mirroredRing, mirror.BaseAddress, BENCH_RING_SIZE, 1);
+        mirroredRate = RunCase(&mirroredRing, packet, packetSizes[i], totalBytes);
+
+        printf("%-10u %18.1f %18.1f %9.2fx\n",
+               packetSizes[i], splitRate, mirroredRate, mirroredRate / splitRate);
+    }
+
+    free(packet);
+    free(splitStorage);
+    MirrorBufferFree(&mirror);
+    return 0;
+}
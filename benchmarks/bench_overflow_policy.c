@@ -0,0 +1,266 @@
+#include <pthread.h>
+#include <errno.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "ring_buffer.h"
+
+// Comportamiento de las políticas de desbordamiento con un productor más rápido
+// que el consumidor en tiempo real. Cada frame lleva la marca de tiempo de su
+// escritura, así que la latencia medida es la que acumula el buffer.
+// Modelo de host del driver: mutex en lugar de spinlocks y variable de
+// condición en lugar de SpaceAvailableEvent.
+
+#define POLICY_REJECT      0
+#define POLICY_DROP_OLDEST 1
+#define POLICY_BLOCK       2
+
+#define BENCH_RING_FRAMES     4096      // ~85 ms a 48 kHz
+#define BENCH_PERIOD_NS       1000000ULL
+#define BENCH_CONSUMER_FRAMES 48        // 48 kHz
+#define BENCH_PRODUCER_FRAMES 60        // 25% más rápido que el consumidor
+#define BENCH_BLOCK_TIMEOUT_NS 20000000ULL
+
+typedef struct _POLICY_CONTEXT {
+    RING_BUFFER Ring;
+    ULONG64 Storage[BENCH_RING_FRAMES];
+    pthread_mutex_t ProducerLock;
+    pthread_mutex_t ConsumerLock;
+    pthread_mutex_t SpaceLock;
+    pthread_cond_t SpaceAvailable;
+    volatile LONG WritersWaiting;
+    ULONG Policy;
+    ULONG Periods;
+    unsigned long long Start;
+    volatile BOOLEAN ProducerDone;
+
+    // Resultados
+    ULONG64 FramesOffered;
+    ULONG64 FramesAccepted;
+    ULONG64 FramesDropped;
+    ULONG64 FramesDelivered;
+    ULONG Overruns;
+    unsigned long long LatencySumNs;
+    unsigned long long LatencyMaxNs;
+} POLICY_CONTEXT;
+
+static void SleepUntil(unsigned long long deadlineNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(deadlineNs / 1000000000ULL);
+    ts.tv_nsec = (long)(deadlineNs % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static ULONG WriteReject(POLICY_CONTEXT *context, const ULONG64 *frames, ULONG count)
+{
+    ULONG written = 0;
+
+    pthread_mutex_lock(&context->ProducerLock);
+    if (RingBufferGetFreeFrames(&context->Ring) >= count) {
+        written = RingBufferWrite(&context->Ring, frames, count);
+    }
+    pthread_mutex_unlock(&context->ProducerLock);
+
+    if (written == 0) {
+        context->Overruns++;
+    }
+    return written;
+}
+
+static ULONG WriteDropOldest(POLICY_CONTEXT *context, const ULONG64 *frames, ULONG count)
+{
+    ULONG written;
+    ULONG dropped = 0;
+
+    pthread_mutex_lock(&context->ProducerLock);
+    written = RingBufferWrite(&context->Ring, frames, count);
+    if (written < count) {
+        pthread_mutex_lock(&context->ConsumerLock);
+        written += RingBufferWriteDropOldest(&context->Ring, frames + written, count - written, &dropped);
+        pthread_mutex_unlock(&context->ConsumerLock);
+    }
+    pthread_mutex_unlock(&context->ProducerLock);
+
+    if (dropped > 0) {
+        context->FramesDropped += dropped;
+        context->Overruns++;
+    }
+    return written;
+}
+
+static ULONG WriteBlocking(POLICY_CONTEXT *context, const ULONG64 *frames, ULONG count)
+{
+    unsigned long long deadline = BenchNowNs() + BENCH_BLOCK_TIMEOUT_NS;
+    struct timespec ts;
+    ULONG written = 0;
+    BOOLEAN blocked = FALSE;
+
+    ts.tv_sec = (time_t)(deadline / 1000000000ULL);
+    ts.tv_nsec = (long)(deadline % 1000000000ULL);
+
+    for (;;) {
+        pthread_mutex_lock(&context->ProducerLock);
+        written += RingBufferWrite(&context->Ring, frames + written, count - written);
+        pthread_mutex_unlock(&context->ProducerLock);
+
+        if (written == count || BenchNowNs() >= deadline) {
+            break;
+        }
+
+        if (!blocked) {
+            context->Overruns++;
+            blocked = TRUE;
+        }
+
+        pthread_mutex_lock(&context->SpaceLock);
+        __atomic_add_fetch(&context->WritersWaiting, 1, __ATOMIC_SEQ_CST);
+        if (RingBufferGetFreeFrames(&context->Ring) == 0) {
+            pthread_cond_timedwait(&context->SpaceAvailable, &context->SpaceLock, &ts);
+        }
+        __atomic_sub_fetch(&context->WritersWaiting, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&context->SpaceLock);
+    }
+
+    return written;
+}
+
+static void *Producer(void *arg)
+{
+    POLICY_CONTEXT *context = (POLICY_CONTEXT *)arg;
+    ULONG64 packet[BENCH_PRODUCER_FRAMES];
+    ULONG period;
+    ULONG written;
+    ULONG i;
+
+    for (period = 0; period < context->Periods; period++) {
+        unsigned long long now;
+
+        SleepUntil(context->Start + period * BENCH_PERIOD_NS);
+
+        now = BenchNowNs();
+        for (i = 0; i < BENCH_PRODUCER_FRAMES; i++) {
+            packet[i] = now;
+        }
+
+        switch (context->Policy) {
+            case POLICY_DROP_OLDEST:
+                written = WriteDropOldest(context, packet, BENCH_PRODUCER_FRAMES);
+                break;
+            case POLICY_BLOCK:
+                written = WriteBlocking(context, packet, BENCH_PRODUCER_FRAMES);
+                break;
+            default:
+                written = WriteReject(context, packet, BENCH_PRODUCER_FRAMES);
+                break;
+        }
+
+        context->FramesOffered += BENCH_PRODUCER_FRAMES;
+        context->FramesAccepted += written;
+    }
+
+    context->ProducerDone = TRUE;
+    return NULL;
+}
+
+static void *Consumer(void *arg)
+{
+    POLICY_CONTEXT *context = (POLICY_CONTEXT *)arg;
+    ULONG64 chunk[BENCH_CONSUMER_FRAMES];
+    ULONG period = 0;
+    ULONG n;
+    ULONG i;
+
+    while (!context->ProducerDone) {
+        unsigned long long now;
+
+        SleepUntil(context->Start + period++ * BENCH_PERIOD_NS + BENCH_PERIOD_NS / 2);
+
+        pthread_mutex_lock(&context->ConsumerLock);
+        n = RingBufferRead(&context->Ring, chunk, BENCH_CONSUMER_FRAMES);
+        pthread_mutex_unlock(&context->ConsumerLock);
+
+        if (n > 0 && __atomic_load_n(&context->WritersWaiting, __ATOMIC_SEQ_CST) > 0) {
+            pthread_mutex_lock(&context->SpaceLock);
+            pthread_cond_signal(&context->SpaceAvailable);
+            pthread_mutex_unlock(&context->SpaceLock);
+        }
+
+        now = BenchNowNs();
+        for (i = 0; i < n; i++) {
+            unsigned long long latency = now - chunk[i];
+            context->LatencySumNs += latency;
+            if (latency > context->LatencyMaxNs) {
+                context->LatencyMaxNs = latency;
+            }
+        }
+        context->FramesDelivered += n;
+    }
+
+    return NULL;
+}
+
+static void RunPolicy(const char *name, ULONG policy, ULONG periods)
+{
+    POLICY_CONTEXT *context = (POLICY_CONTEXT *)calloc(1, sizeof(POLICY_CONTEXT));
+    pthread_condattr_t condAttr;
+    pthread_t producer;
+    pthread_t consumer;
+    double seconds;
+
+    if (context == NULL) {
+        return;
+    }
+
+    RingBufferInitialize(&context->Ring, context->Storage, BENCH_RING_FRAMES, sizeof(ULONG64));
+    pthread_mutex_init(&context->ProducerLock, NULL);
+    pthread_mutex_init(&context->ConsumerLock, NULL);
+    pthread_mutex_init(&context->SpaceLock, NULL);
+    pthread_condattr_init(&condAttr);
+    pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+    pthread_cond_init(&context->SpaceAvailable, &condAttr);
+    pthread_condattr_destroy(&condAttr);
+    context->Policy = policy;
+    context->Periods = periods;
+    context->Start = BenchNowNs() + BENCH_PERIOD_NS;
+
+    pthread_create(&consumer, NULL, Consumer, context);
+    pthread_create(&producer, NULL, Producer, context);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    seconds = (double)(BenchNowNs() - context->Start) * 1e-9;
+
+    printf("%-12s %12.0f %12.0f %10llu %9u %10.2f %10.2f\n",
+           name,
+           (double)context->FramesAccepted / seconds,
+           (double)context->FramesDelivered / seconds,
+           (unsigned long long)(context->FramesOffered - context->FramesAccepted + context->FramesDropped),
+           context->Overruns,
+           context->FramesDelivered ? (double)context->LatencySumNs / context->FramesDelivered * 1e-6 : 0.0,
+           (double)context->LatencyMaxNs * 1e-6);
+
+    pthread_cond_destroy(&context->SpaceAvailable);
+    pthread_mutex_destroy(&context->SpaceLock);
+    pthread_mutex_destroy(&context->ConsumerLock);
+    pthread_mutex_destroy(&context->ProducerLock);
+    free(context);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG periods = (ULONG)(2000 * BenchScale(argc, argv));
+
+    printf("=== Políticas de desbordamiento (productor %u frames/ms, consumidor %u frames/ms, anillo %u frames) ===\n",
+           BENCH_PRODUCER_FRAMES, BENCH_CONSUMER_FRAMES, BENCH_RING_FRAMES);
+    printf("%-12s %12s %12s %10s %9s %10s %10s\n",
+           "política", "aceptados/s", "entregados/s", "perdidos", "overruns", "lat ms", "lat máx ms");
+
+    RunPolicy("reject", POLICY_REJECT, periods);
+    RunPolicy("drop-oldest", POLICY_DROP_OLDEST, periods);
+    RunPolicy("block", POLICY_BLOCK, periods);
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+#include <pthread.h>
+#include <errno.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "read_queue.h"
+#include "ring_buffer.h"
+
+// Coste de CPU de un productor más rápido que el tiempo real (lector de
+// ficheros) con el anillo lleno: reintentos activos ante STATUS_BUFFER_TOO_SMALL
+// frente a envíos pendientes (OVERFLOW_POLICY_PEND) con varias escrituras
+// solapadas. Modelo de host de src/driver/pending_writes.c: mutex en lugar de
+// spinlocks y variable de condición en lugar de la espera de E/S solapada.
+
+#define MODE_BUSY_RETRY 0
+#define MODE_PEND       1
+
+#define BENCH_RING_FRAMES     4096      // ~85 ms a 48 kHz
+#define BENCH_PERIOD_NS       1000000ULL
+#define BENCH_CONSUMER_FRAMES 48        // 48 kHz
+#define BENCH_PACKET_FRAMES   480       // 10 ms por envío
+#define BENCH_IN_FLIGHT       4
+#define BENCH_BASE_PERIODS    2000      // 2 s de audio
+
+typedef struct _BENCH_WRITE {
+    READ_QUEUE_ENTRY Entry;
+    volatile BOOLEAN Completed;
+} BENCH_WRITE;
+
+typedef struct _PEND_CONTEXT {
+    RING_BUFFER Ring;
+    USHORT Storage[BENCH_RING_FRAMES];
+    USHORT Packet[BENCH_PACKET_FRAMES];
+    READ_QUEUE WriteQueue;
+    pthread_mutex_t ProducerLock;
+    pthread_mutex_t QueueLock;
+    pthread_mutex_t CompletionLock;
+    pthread_cond_t Completed;
+    BENCH_WRITE Writes[BENCH_IN_FLIGHT];
+    ULONG Mode;
+    ULONG Periods;
+    volatile BOOLEAN ConsumerDone;
+
+    // Resultados
+    ULONG64 Submits;
+    ULONG64 FramesDelivered;
+    ULONG Underruns;
+    double ProducerCpuSeconds;
+} PEND_CONTEXT;
+
+static void SleepUntil(unsigned long long deadlineNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(deadlineNs / 1000000000ULL);
+    ts.tv_nsec = (long)(deadlineNs % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+static double ThreadCpuSeconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void CompleteWrite(PEND_CONTEXT *context, BENCH_WRITE *write)
+{
+    pthread_mutex_lock(&context->CompletionLock);
+    write->Completed = TRUE;
+    pthread_cond_broadcast(&context->Completed);
+    pthread_mutex_unlock(&context->CompletionLock);
+}
+
+// WriteFramesReject: todo o nada
+static BOOLEAN TryWrite(PEND_CONTEXT *context)
+{
+    BOOLEAN written = FALSE;
+
+    pthread_mutex_lock(&context->ProducerLock);
+    if (context->WriteQueue.Count == 0 &&
+        RingBufferGetFreeFrames(&context->Ring) >= BENCH_PACKET_FRAMES) {
+        RingBufferWrite(&context->Ring, context->Packet, BENCH_PACKET_FRAMES);
+        written = TRUE;
+    }
+    pthread_mutex_unlock(&context->ProducerLock);
+
+    return written;
+}
+
+// ServicePendingWrites
+static void ServiceWrites(PEND_CONTEXT *context)
+{
+    PREAD_QUEUE_ENTRY entry;
+
+    if (__atomic_load_n(&context->WriteQueue.Count, __ATOMIC_SEQ_CST) == 0) {
+        return;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&context->ProducerLock);
+        pthread_mutex_lock(&context->QueueLock);
+        entry = ReadQueuePeekReady(&context->WriteQueue, RingBufferGetFreeFrames(&context->Ring));
+        if (entry != NULL) {
+            ReadQueueRemove(&context->WriteQueue, entry);
+        }
+        pthread_mutex_unlock(&context->QueueLock);
+
+        if (entry != NULL) {
+            RingBufferWrite(&context->Ring, context->Packet, entry->Frames);
+        }
+        pthread_mutex_unlock(&context->ProducerLock);
+
+        if (entry == NULL) {
+            break;
+        }
+
+        CompleteWrite(context, CONTAINING_RECORD(entry, BENCH_WRITE, Entry));
+    }
+}
+
+// QueueOrCompleteWrite
+static void SubmitPending(PEND_CONTEXT *context, BENCH_WRITE *write)
+{
+    write->Completed = FALSE;
+    context->Submits++;
+
+    if (TryWrite(context)) {
+        CompleteWrite(context, write);
+        return;
+    }
+
+    pthread_mutex_lock(&context->QueueLock);
+    ReadQueueInsert(&context->WriteQueue, &write->Entry, BENCH_PACKET_FRAMES);
+    pthread_mutex_unlock(&context->QueueLock);
+
+    ServiceWrites(context);
+}
+
+static void *Producer(void *arg)
+{
+    PEND_CONTEXT *context = (PEND_CONTEXT *)arg;
+    double cpuStart = ThreadCpuSeconds();
+    ULONG64 packet = 0;
+    BENCH_WRITE *write;
+
+    while (!context->ConsumerDone) {
+        if (context->Mode == MODE_BUSY_RETRY) {
+            // Bucle típico de un cliente sin contrapresión: reintentar hasta que quepa
+            context->Submits++;
+            if (!TryWrite(context)) {
+                sched_yield();
+            }
+            continue;
+        }
+
+        write = &context->Writes[packet % BENCH_IN_FLIGHT];
+        if (packet >= BENCH_IN_FLIGHT) {
+            pthread_mutex_lock(&context->CompletionLock);
+            while (!write->Completed && !context->ConsumerDone) {
+                pthread_cond_wait(&context->Completed, &context->CompletionLock);
+            }
+            pthread_mutex_unlock(&context->CompletionLock);
+
+            if (context->ConsumerDone) {
+                break;
+            }
+        }
+
+        SubmitPending(context, write);
+        packet++;
+    }
+
+    context->ProducerCpuSeconds = ThreadCpuSeconds() - cpuStart;
+    return NULL;
+}
+
+static void *Consumer(void *arg)
+{
+    PEND_CONTEXT *context = (PEND_CONTEXT *)arg;
+    USHORT chunk[BENCH_CONSUMER_FRAMES];
+    unsigned long long next = BenchNowNs();
+    ULONG framesRead;
+    ULONG period;
+
+    for (period = 0; period < context->Periods; period++) {
+        next += BENCH_PERIOD_NS;
+        SleepUntil(next);
+
+        framesRead = RingBufferRead(&context->Ring, chunk, BENCH_CONSUMER_FRAMES);
+        if (framesRead < BENCH_CONSUMER_FRAMES) {
+            context->Underruns++;
+        }
+        context->FramesDelivered += framesRead;
+
+        if (framesRead > 0) {
+            ServiceWrites(context);
+        }
+    }
+
+    // Liberar al productor si espera una finalización
+    pthread_mutex_lock(&context->CompletionLock);
+    context->ConsumerDone = TRUE;
+    pthread_cond_broadcast(&context->Completed);
+    pthread_mutex_unlock(&context->CompletionLock);
+
+    return NULL;
+}
+
+static void RunMode(PEND_CONTEXT *context, ULONG mode, ULONG periods)
+{
+    pthread_t producer;
+    pthread_t consumer;
+
+    memset(context, 0, sizeof(*context));
+    RingBufferInitialize(&context->Ring, context->Storage, BENCH_RING_FRAMES, sizeof(USHORT));
+    ReadQueueInitialize(&context->WriteQueue, 0xFFFFFFFFUL);
+    pthread_mutex_init(&context->ProducerLock, NULL);
+    pthread_mutex_init(&context->QueueLock, NULL);
+    pthread_mutex_init(&context->CompletionLock, NULL);
+    pthread_cond_init(&context->Completed, NULL);
+    context->Mode = mode;
+    context->Periods = periods;
+
+    pthread_create(&consumer, NULL, Consumer, context);
+    pthread_create(&producer, NULL, Producer, context);
+    pthread_join(consumer, NULL);
+    pthread_join(producer, NULL);
+
+    pthread_mutex_destroy(&context->ProducerLock);
+    pthread_mutex_destroy(&context->QueueLock);
+    pthread_mutex_destroy(&context->CompletionLock);
+    pthread_cond_destroy(&context->Completed);
+}
+
+int main(int argc, char **argv)
+{
+    static const char *modeNames[] = { "busy-retry", "pend" };
+    static PEND_CONTEXT context;
+    ULONG periods = (ULONG)(BENCH_BASE_PERIODS * BenchScale(argc, argv));
+    double wallSeconds;
+    ULONG mode;
+
+    if (periods == 0) {
+        periods = 1;
+    }
+
+    wallSeconds = (double)periods * BENCH_PERIOD_NS * 1e-9;
+
+    printf("=== Contrapresión de escritores: anillo de %u frames, paquetes de %u frames, %.1f s ===\n",
+           BENCH_RING_FRAMES, BENCH_PACKET_FRAMES, wallSeconds);
+    printf("%-12s %14s %14s %12s %10s\n", "modo", "CPU productor", "% de un core", "envíos", "underruns");
+
+    for (mode = MODE_BUSY_RETRY; mode <= MODE_PEND; mode++) {
+        RunMode(&context, mode, periods);
+
+        printf("%-12s %12.3f s %13.1f%% %12llu %10u\n",
+               modeNames[mode],
+               context.ProducerCpuSeconds,
+               context.ProducerCpuSeconds / wallSeconds * 100.0,
+               (unsigned long long)context.Submits,
+               context.Underruns);
+    }
+
+    return 0;
+}
@@ -0,0 +1,185 @@
+#include <math.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "resampler.h"
+
+// Conversión de frecuencia polifásica: rendimiento (Mframes/s de entrada,
+// estéreo int16 -> int16 como en el camino de escritura) con el producto
+// escalar escalar y SSE2, y calidad (THD+N de un tono de 997 Hz a -6 dBFS en
+// float, sin cuantización) por calidad y razón. Al bajar la frecuencia se
+// añade un segundo tono por encima de la Nyquist de salida: lo que de él se
+// cuele como alias cuenta como distorsión.
+
+#define BENCH_CHANNELS      2
+#define BENCH_PACKET_FRAMES 441             // 10 ms a 44.1 kHz
+#define BENCH_BASE_FRAMES   40000000ULL
+#define BENCH_TONE_HZ       997.0
+#define BENCH_TONE_SECONDS  2
+
+static const char *g_QualityNames[RESAMPLER_QUALITY_COUNT] = { "baja", "media", "alta" };
+
+static const ULONG g_Rates[][2] = {
+    { 44100, 48000 },
+    { 48000, 44100 },
+    { 16000, 48000 },
+    { 48000, 16000 },
+    { 96000, 48000 },
+};
+
+#define BENCH_RATE_COUNT (sizeof(g_Rates) / sizeof(g_Rates[0]))
+
+static UCHAR g_Memory[2 * 1024 * 1024];
+static SHORT g_Packet[BENCH_PACKET_FRAMES * BENCH_CHANNELS];
+static SHORT g_Output[BENCH_PACKET_FRAMES * 8 * BENCH_CHANNELS];
+static float g_Tone[192000 * BENCH_TONE_SECONDS];
+static float g_ToneOut[192000 * BENCH_TONE_SECONDS * 4];
+
+static PRESAMPLER Create(ULONG inputRate, ULONG outputRate, ULONG channels, SAMPLE_FORMAT format,
+                         RESAMPLER_QUALITY quality, SAMPLE_CONVERT_ISA isa)
+{
+    RESAMPLER_CONFIG config;
+    PRESAMPLER resampler;
+
+    config.InputRate = inputRate;
+    config.OutputRate = outputRate;
+    config.Channels = channels;
+    config.SourceFormat = format;
+    config.TargetFormat = format;
+    config.Quality = quality;
+    config.Isa = isa;
+
+    if (!NT_SUCCESS(ResamplerInitialize(g_Memory, sizeof(g_Memory), &config, &resampler))) {
+        return NULL;
+    }
+
+    return resampler;
+}
+
+// Frames de entrada por segundo
+static double RunThroughput(ULONG inputRate, ULONG outputRate, RESAMPLER_QUALITY quality,
+                            SAMPLE_CONVERT_ISA isa, ULONG64 totalFrames)
+{
+    PRESAMPLER resampler = Create(inputRate, outputRate, BENCH_CHANNELS, SAMPLE_FORMAT_INT16, quality, isa);
+    ULONG64 packets = totalFrames / BENCH_PACKET_FRAMES;
+    ULONG consumed;
+    double start;
+    ULONG64 i;
+
+    if (resampler == NULL) {
+        return 0.0;
+    }
+
+    if (packets == 0) {
+        packets = 1;
+    }
+
+    start = BenchNowSeconds();
+    for (i = 0; i < packets; i++) {
+        ResamplerProcess(resampler, g_Packet, BENCH_PACKET_FRAMES, &consumed,
+                         g_Output, BENCH_PACKET_FRAMES * 8);
+        BenchDoNotOptimize(g_Output);
+    }
+
+    return (double)(packets * BENCH_PACKET_FRAMES) / (BenchNowSeconds() - start);
+}
+
+// Ajuste por mínimos cuadrados del tono: el residuo es ruido más distorsión
+static double MeasureThdN(const float *signal, ULONG frames, double rate)
+{
+    double scc = 0.0, sss = 0.0, scs = 0.0, syc = 0.0, sys = 0.0;
+    double det, a, b, c, s, fit, residual = 0.0, power = 0.0;
+    ULONG i;
+
+    for (i = 0; i < frames; i++) {
+        c = cos(2.0 * M_PI * BENCH_TONE_HZ * i / rate);
+        s = sin(2.0 * M_PI * BENCH_TONE_HZ * i / rate);
+        scc += c * c;
+        sss += s * s;
+        scs += c * s;
+        syc += signal[i] * c;
+        sys += signal[i] * s;
+    }
+
+    det = scc * sss - scs * scs;
+    a = (syc * sss - sys * scs) / det;
+    b = (sys * scc - syc * scs) / det;
+
+    for (i = 0; i < frames; i++) {
+        fit = a * cos(2.0 * M_PI * BENCH_TONE_HZ * i / rate) + b * sin(2.0 * M_PI * BENCH_TONE_HZ * i / rate);
+        residual += (signal[i] - fit) * (signal[i] - fit);
+        power += fit * fit;
+    }
+
+    return 10.0 * log10(residual / power);
+}
+
+static double RunQuality(ULONG inputRate, ULONG outputRate, RESAMPLER_QUALITY quality)
+{
+    PRESAMPLER resampler = Create(inputRate, outputRate, 1, SAMPLE_FORMAT_FLOAT32, quality,
+                                  SampleConvertGetBestIsa());
+    ULONG frames = inputRate * BENCH_TONE_SECONDS;
+    double alias = (outputRate + 0.375 * ((double)inputRate - outputRate)) / 2.0;
+    ULONG consumed;
+    ULONG produced;
+    ULONG settle;
+    ULONG i;
+
+    if (resampler == NULL) {
+        return 0.0;
+    }
+
+    for (i = 0; i < frames; i++) {
+        g_Tone[i] = (float)(0.5 * sin(2.0 * M_PI * BENCH_TONE_HZ * i / inputRate));
+        if (outputRate < inputRate) {
+            g_Tone[i] += (float)(0.25 * sin(2.0 * M_PI * alias * i / inputRate));
+        }
+    }
+
+    produced = ResamplerProcess(resampler, g_Tone, frames, &consumed, g_ToneOut,
+                                sizeof(g_ToneOut) / sizeof(g_ToneOut[0]));
+
+    // Fuera el arranque y el final (ventanas con silencio)
+    settle = resampler->Taps * resampler->Interpolation / resampler->Decimation + 1;
+    return MeasureThdN(g_ToneOut + settle, produced - 2 * settle, outputRate);
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 totalFrames = (ULONG64)(BENCH_BASE_FRAMES * BenchScale(argc, argv));
+    double scalar;
+    double sse2;
+    char pair[32];
+    ULONG rate;
+    ULONG quality;
+    ULONG i;
+
+    for (i = 0; i < BENCH_PACKET_FRAMES * BENCH_CHANNELS; i++) {
+        g_Packet[i] = (SHORT)((i * 2654435761UL) >> 18);
+    }
+
+    // Cada razón y calidad procesa el mismo número de frames
+    totalFrames /= BENCH_RATE_COUNT * RESAMPLER_QUALITY_COUNT;
+
+    printf("=== Conversión de frecuencia: paquetes de %u frames int16 estéreo ===\n", BENCH_PACKET_FRAMES);
+    printf("%-16s %-6s %12s %12s %8s %10s\n", "razón", "cal.", "escalar", "SSE2", "SSE2/esc", "THD+N");
+
+    for (rate = 0; rate < BENCH_RATE_COUNT; rate++) {
+        snprintf(pair, sizeof(pair), "%u->%u", g_Rates[rate][0], g_Rates[rate][1]);
+
+        for (quality = 0; quality < RESAMPLER_QUALITY_COUNT; quality++) {
+            scalar = RunThroughput(g_Rates[rate][0], g_Rates[rate][1], (RESAMPLER_QUALITY)quality,
+                                   SAMPLE_CONVERT_ISA_SCALAR, totalFrames);
+            sse2 = SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)
+                       ? RunThroughput(g_Rates[rate][0], g_Rates[rate][1], (RESAMPLER_QUALITY)quality,
+                                       SAMPLE_CONVERT_ISA_SSE2, totalFrames)
+                       : 0.0;
+
+            printf("%-16s %-6s %9.2f Mf/s %9.2f Mf/s %7.1fx %7.1f dB\n",
+                   pair, g_QualityNames[quality], scalar / 1e6, sse2 / 1e6,
+                   sse2 / scalar, RunQuality(g_Rates[rate][0], g_Rates[rate][1], (RESAMPLER_QUALITY)quality));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "ring_buffer.h"
+
+// Rendimiento del anillo SPSC lock-free frente al esquema anterior: un único
+// lock compartido por productor y consumidor (equivalente a BufferLock).
+
+#define BENCH_RING_SIZE 8192
+#define BENCH_BASE_BYTES (256ULL * 1024 * 1024)
+
+typedef ULONG (*RING_OP)(void *ring, void *data, ULONG length);
+
+typedef struct _LOCKED_RING {
+    pthread_spinlock_t Lock;
+    RING_BUFFER Ring;
+} LOCKED_RING;
+
+typedef struct _BENCH_CONTEXT {
+    void *Ring;
+    RING_OP Write;
+    RING_OP Read;
+    ULONG ChunkSize;
+    ULONG64 TotalBytes;
+} BENCH_CONTEXT;
+
+static ULONG LockFreeWrite(void *ring, void *data, ULONG length)
+{
+    return RingBufferWrite((PRING_BUFFER)ring, data, length);
+}
+
+static ULONG LockFreeRead(void *ring, void *data, ULONG length)
+{
+    return RingBufferRead((PRING_BUFFER)ring, data, length);
+}
+
+static ULONG LockedWrite(void *ring, void *data, ULONG length)
+{
+    LOCKED_RING *locked = (LOCKED_RING *)ring;
+    ULONG n;
+
+    pthread_spin_lock(&locked->Lock);
+    n = RingBufferWrite(&locked->Ring, data, length);
+    pthread_spin_unlock(&locked->Lock);
+    return n;
+}
+
+static ULONG LockedRead(void *ring, void *data, ULONG length)
+{
+    LOCKED_RING *locked = (LOCKED_RING *)ring;
+    ULONG n;
+
+    pthread_spin_lock(&locked->Lock);
+    n = RingBufferRead(&locked->Ring, data, length);
+    pthread_spin_unlock(&locked->Lock);
+    return n;
+}
+
+static void *Producer(void *arg)
+{
+    BENCH_CONTEXT *context = (BENCH_CONTEXT *)arg;
+    UCHAR chunk[16384];
+    ULONG64 done = 0;
+
+    memset(chunk, 0x33, sizeof(chunk));
+    while (done < context->TotalBytes) {
+        ULONG n = context->Write(context->Ring, chunk, context->ChunkSize);
+        if (n == 0) {
+            sched_yield();
+        }
+        done += n;
+    }
+
+    return NULL;
+}
+
+static void *Consumer(void *arg)
+{
+    BENCH_CONTEXT *context = (BENCH_CONTEXT *)arg;
+    UCHAR chunk[16384];
+    ULONG64 done = 0;
+
+    while (done < context->TotalBytes) {
+        ULONG n = context->Read(context->Ring, chunk, context->ChunkSize);
+        if (n == 0) {
+            sched_yield();
+        }
+        done += n;
+    }
+
+    return NULL;
+}
+
+static double RunOnce(void *ring, RING_OP writeOp, RING_OP readOp, ULONG chunkSize, ULONG64 totalBytes)
+{
+    BENCH_CONTEXT context;
+    pthread_t producer;
+    pthread_t consumer;
+    double start;
+    double elapsed;
+
+    context.Ring = ring;
+    context.Write = writeOp;
+    context.Read = readOp;
+    context.ChunkSize = chunkSize;
+    context.TotalBytes = totalBytes;
+
+    start = BenchNowSeconds();
+    pthread_create(&producer, NULL, Producer, &context);
+    pthread_create(&consumer, NULL, Consumer, &context);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    elapsed = BenchNowSeconds() - start;
+
+    return (double)totalBytes / elapsed / (1024.0 * 1024.0);
+}
+
+int main(int argc, char **argv)
+{
+    static const ULONG chunkSizes[] = { 64, 256, 960, 1920, 4096 };
+    static UCHAR storage[BENCH_RING_SIZE];
+    static LOCKED_RING locked;
+    static RING_BUFFER lockFree;
+    ULONG64 totalBytes = (ULONG64)(BENCH_BASE_BYTES * BenchScale(argc, argv));
+    size_t i;
+
+    pthread_spin_init(&locked.Lock, PTHREAD_PROCESS_PRIVATE);
+
+    printf("=== Benchmark del buffer circular (anillo de %u bytes, %llu MiB por caso) ===\n",
+           BENCH_RING_SIZE, (unsigned long long)(totalBytes >> 20));
+    printf("%-10s %18s %18s %10s\n", "chunk", "spinlock MiB/s", "lock-free MiB/s", "speedup");
+
+    for (i = 0; i < sizeof(chunkSizes) / sizeof(chunkSizes[0]); i++) {
+        double lockedRate;
+        double lockFreeRate;
+
+        RingBufferInitialize(&locked.Ring, storage, sizeof(storage), 1);
+        lockedRate = RunOnce(&locked, LockedWrite, LockedRead, chunkSizes[i], totalBytes);
+
+        RingBufferInitialize(&lockFree, storage, sizeof(storage), 1);
+        lockFreeRate = RunOnce(&lockFree, LockFreeWrite, LockFreeRead, chunkSizes[i], totalBytes);
+
+        printf("%-10u %18.1f %18.1f %9.2fx\n",
+               chunkSizes[i], lockedRate, lockFreeRate, lockFreeRate / lockedRate);
+    }
+
+    pthread_spin_destroy(&locked.Lock);
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include <errno.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "bench_common.h"
+#include "ring_buffer.h"
+#include "shared_ring.h"
+
+// Productor y consumidor en procesos separados: anillo en memoria compartida
+// (IOCTL_VIRTUALMIC_MAP_RING) frente al camino de un IOCTL por paquete.
+// El camino IOCTL se modela con una tubería: una llamada al sistema y una
+// copia a memoria del kernel por paquete (SystemBuffer) más la copia al anillo
+// del driver. El timbre del anillo compartido es un eventfd que el consumidor
+// solo toca cuando ya hay el espacio que el productor pidió en
+// ProducerWaitFrames (medio anillo: histéresis frente al ping-pong).
+
+#define BENCH_FRAME_SIZE   4      // 16 bits estéreo
+#define BENCH_RING_FRAMES  4096
+#define BENCH_BASE_PACKETS 500000ULL
+
+typedef struct _BENCH_RESULT {
+    double PacketsPerSecond;
+    ULONG64 Doorbells;
+} BENCH_RESULT;
+
+static void FillPacket(PUCHAR packet, ULONG bytes, ULONG64 sequence)
+{
+    memset(packet, (int)(sequence & 0xFF), bytes);
+    memcpy(packet, &sequence, sizeof(sequence));
+}
+
+static BOOLEAN CheckPacket(const UCHAR *packet, ULONG64 sequence)
+{
+    ULONG64 value;
+
+    memcpy(&value, packet, sizeof(value));
+    return value == sequence;
+}
+
+static int WaitChild(pid_t child)
+{
+    int status;
+
+    waitpid(child, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static BENCH_RESULT RunSharedRing(ULONG packetFrames, ULONG64 packets)
+{
+    BENCH_RESULT result = { 0.0, 0 };
+    SIZE_T size = SharedRingGetRequiredSize(BENCH_RING_FRAMES, BENCH_FRAME_SIZE);
+    ULONG packetBytes = packetFrames * BENCH_FRAME_SIZE;
+    SHARED_RING_VIEW consumer;
+    UCHAR packet[BENCH_RING_FRAMES * BENCH_FRAME_SIZE];
+    ULONG64 received = 0;
+    ULONG framesRead;
+    PVOID memory;
+    double start;
+    int doorbell;
+    pid_t child;
+
+    memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    doorbell = eventfd(0, 0);
+    if (memory == MAP_FAILED || doorbell < 0) {
+        return result;
+    }
+
+    SharedRingFormat(memory, size, BENCH_RING_FRAMES, BENCH_FRAME_SIZE);
+    SharedRingAttachConsumer(&consumer, memory, BENCH_RING_FRAMES, BENCH_FRAME_SIZE);
+
+    start = BenchNowSeconds();
+
+    child = fork();
+    if (child == 0) {
+        SHARED_RING_VIEW producer;
+        ULONG64 sequence;
+        uint64_t value;
+
+        SharedRingAttachProducer(&producer, memory, size);
+
+        for (sequence = 0; sequence < packets; sequence++) {
+            FillPacket(packet, packetBytes, sequence);
+
+            // Paquete completo o nada: se espera al timbre si no cabe
+            while (SharedRingGetFreeFrames(&producer) < packetFrames) {
+                if (SharedRingPrepareWait(&producer, max(packetFrames, BENCH_RING_FRAMES / 2))) {
+                    if (read(doorbell, &value, sizeof(value)) < 0 && errno != EINTR) {
+                        _exit(1);
+                    }
+                }
+            }
+
+            SharedRingWrite(&producer, packet, packetFrames);
+        }
+
+        _exit(0);
+    }
+
+    // Consumidor (el driver): lee paquetes completos a su ritmo
+    while (received < packets) {
+        if (!NT_SUCCESS(SharedRingRead(&consumer, packet, packetFrames, &framesRead))) {
+            break;
+        }
+
+        if (framesRead == 0) {
+            sched_yield();
+            continue;
+        }
+
+        if (SharedRingShouldNotifyProducer(&consumer)) {
+            uint64_t one = 1;
+            if (write(doorbell, &one, sizeof(one)) == sizeof(one)) {
+                result.Doorbells++;
+            }
+        }
+
+        // El productor solo publica paquetes completos
+        if (framesRead != packetFrames || !CheckPacket(packet, received)) {
+            break;
+        }
+
+        received++;
+    }
+
+    if (received < packets) {
+        kill(child, SIGKILL);
+    }
+
+    if (WaitChild(child) == 0 && received == packets) {
+        result.PacketsPerSecond = (double)packets / (BenchNowSeconds() - start);
+    }
+
+    close(doorbell);
+    munmap(memory, size);
+    return result;
+}
+
+static BOOLEAN ReadExact(int fd, PUCHAR buffer, ULONG bytes)
+{
+    ULONG done = 0;
+
+    while (done < bytes) {
+        ssize_t n = read(fd, buffer + done, bytes - done);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return FALSE;
+        }
+        done += (ULONG)n;
+    }
+
+    return TRUE;
+}
+
+static BENCH_RESULT RunIoctlModel(ULONG packetFrames, ULONG64 packets)
+{
+    BENCH_RESULT result = { 0.0, 0 };
+    static UCHAR storage[BENCH_RING_FRAMES * BENCH_FRAME_SIZE];
+    ULONG packetBytes = packetFrames * BENCH_FRAME_SIZE;
+    UCHAR systemBuffer[BENCH_RING_FRAMES * BENCH_FRAME_SIZE];
+    UCHAR packet[BENCH_RING_FRAMES * BENCH_FRAME_SIZE];
+    RING_BUFFER ring;
+    ULONG64 received = 0;
+    double start;
+    int pipeFds[2];
+    pid_t child;
+
+    if (pipe(pipeFds) != 0) {
+        return result;
+    }
+
+    RingBufferInitialize(&ring, storage, BENCH_RING_FRAMES, BENCH_FRAME_SIZE);
+
+    start = BenchNowSeconds();
+
+    child = fork();
+    if (child == 0) {
+        ULONG64 sequence;
+
+        close(pipeFds[0]);
+        for (sequence = 0; sequence < packets; sequence++) {
+            FillPacket(packet, packetBytes, sequence);
+
+            // Un DeviceIoControl por paquete
+            if (write(pipeFds[1], packet, packetBytes) != (ssize_t)packetBytes) {
+                _exit(1);
+            }
+        }
+
+        _exit(0);
+    }
+
+    close(pipeFds[1]);
+
+    while (received < packets) {
+        if (!ReadExact(pipeFds[0], systemBuffer, packetBytes)) {
+            break;
+        }
+
+        // WriteAudioToBuffer y la lectura posterior del cliente
+        RingBufferWrite(&ring, systemBuffer, packetFrames);
+        RingBufferRead(&ring, packet, packetFrames);
+
+        if (!CheckPacket(packet, received)) {
+            break;
+        }
+
+        received++;
+    }
+
+    if (received < packets) {
+        kill(child, SIGKILL);
+    }
+
+    if (WaitChild(child) == 0 && received == packets) {
+        result.PacketsPerSecond = (double)packets / (BenchNowSeconds() - start);
+    }
+
+    close(pipeFds[0]);
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    static const ULONG packetFrames[] = { 48, 120, 240, 480, 960 };
+    ULONG64 packets = (ULONG64)(BENCH_BASE_PACKETS * BenchScale(argc, argv));
+    size_t i;
+
+    printf("=== Anillo compartido frente a un IOCTL por paquete (%llu paquetes, frames de %u bytes) ===\n",
+           (unsigned long long)packets, BENCH_FRAME_SIZE);
+    printf("%-8s %16s %16s %10s %10s\n", "frames", "IOCTL paq/s", "compartido paq/s", "speedup", "timbres");
+
+    for (i = 0; i < sizeof(packetFrames) / sizeof(packetFrames[0]); i++) {
+        BENCH_RESULT ioctl = RunIoctlModel(packetFrames[i], packets);
+        BENCH_RESULT shared = RunSharedRing(packetFrames[i], packets);
+
+        printf("%-8u %16.0f %16.0f %9.2fx %10llu\n",
+               packetFrames[i],
+               ioctl.PacketsPerSecond,
+               shared.PacketsPerSecond,
+               ioctl.PacketsPerSecond > 0.0 ? shared.PacketsPerSecond / ioctl.PacketsPerSecond : 0.0,
+               (unsigned long long)shared.Doorbells);
+    }
+
+    return 0;
+}
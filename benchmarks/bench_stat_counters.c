@@ -0,0 +1,145 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "stat_counters.h"
+
+// Coste de contar en el camino caliente según crece el número de escritores:
+// contadores por procesador (STAT_COUNTERS) frente a un contador compartido
+// con InterlockedIncrement (lo que hacía Overruns). Cada hilo, fijado a un
+// procesador, suma BENCH_BASE_INCREMENTS veces entre trozos de trabajo que
+// imitan el resto del paquete; se da el tiempo por suma de cada hilo. Con
+// ranuras propias debe quedarse plano; el compartido crece con los hilos.
+// Con más hilos que procesadores los hilos se turnan y la cifra no es útil.
+
+#define BENCH_BASE_INCREMENTS 20000000ULL
+#define BENCH_WORK_ITERATIONS 8           // Trabajo entre sumas (sin memoria compartida)
+
+typedef struct _BENCH_SHARED {
+    STAT_COUNTERS Counters;
+    volatile LONG Shared;                 // Contador único, como el antiguo Overruns
+    UCHAR Pad[VMIC_CACHE_LINE];
+    pthread_barrier_t Start;
+    ULONG64 Increments;
+    BOOLEAN PerCpu;
+} BENCH_SHARED;
+
+typedef struct _BENCH_THREAD {
+    BENCH_SHARED *Shared;
+    ULONG Cpu;
+    double NsPerIncrement;
+} BENCH_THREAD;
+
+static void *Writer(void *arg)
+{
+    BENCH_THREAD *thread = (BENCH_THREAD *)arg;
+    BENCH_SHARED *shared = thread->Shared;
+    cpu_set_t cpus;
+    unsigned long long start;
+    volatile ULONG work = 0;
+    ULONG64 i;
+    ULONG k;
+
+    CPU_ZERO(&cpus);
+    CPU_SET(thread->Cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    pthread_barrier_wait(&shared->Start);
+    start = BenchNowNs();
+
+    for (i = 0; i < shared->Increments; i++) {
+        for (k = 0; k < BENCH_WORK_ITERATIONS; k++) {
+            work = work + k;
+        }
+
+        if (shared->PerCpu) {
+            StatCountersAdd(&shared->Counters, STAT_COUNTER_SAMPLES_PROCESSED, 1);
+        } else {
+            __atomic_add_fetch(&shared->Shared, 1, __ATOMIC_SEQ_CST);
+        }
+    }
+
+    thread->NsPerIncrement = (double)(BenchNowNs() - start) / (double)shared->Increments;
+    return NULL;
+}
+
+// Media por hilo del tiempo por suma (trabajo incluido)
+static double Run(BENCH_SHARED *shared, BOOLEAN perCpu, ULONG threads, ULONG processors)
+{
+    pthread_t handles[256];
+    BENCH_THREAD contexts[256];
+    double total = 0.0;
+    ULONG i;
+
+    shared->PerCpu = perCpu;
+    shared->Shared = 0;
+    pthread_barrier_init(&shared->Start, NULL, threads);
+
+    for (i = 0; i < threads; i++) {
+        contexts[i].Shared = shared;
+        contexts[i].Cpu = i % processors;
+        pthread_create(&handles[i], NULL, Writer, &contexts[i]);
+    }
+
+    for (i = 0; i < threads; i++) {
+        pthread_join(handles[i], NULL);
+        total += contexts[i].NsPerIncrement;
+    }
+
+    pthread_barrier_destroy(&shared->Start);
+    return total / threads;
+}
+
+int main(int argc, char **argv)
+{
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    ULONG processors = (online > 0) ? (ULONG)min(online, 256) : 1;
+    ULONG64 total;
+    BENCH_SHARED *shared;
+    PVOID memory;
+    SIZE_T size;
+    double perCpu;
+    double single;
+    double baseline = 0.0;
+    ULONG threads;
+
+    shared = (BENCH_SHARED *)calloc(1, sizeof(BENCH_SHARED));
+    size = StatCountersGetRequiredSize(processors);
+    memory = malloc(size);
+    if (shared == NULL || memory == NULL ||
+        !NT_SUCCESS(StatCountersInitialize(&shared->Counters, memory, size, processors))) {
+        printf("Sin memoria\n");
+        return 1;
+    }
+
+    total = (ULONG64)(BENCH_BASE_INCREMENTS * BenchScale(argc, argv));
+    shared->Increments = max(total / 2, 1);
+
+    printf("=== Contadores por procesador frente a contador compartido (%u procesadores) ===\n", processors);
+    printf("%8s %16s %16s %12s\n", "hilos", "por CPU ns/suma", "compart. ns/suma", "por CPU rel.");
+
+    // 1, 2, 4, ... y por último todos los procesadores
+    for (threads = 1;; threads *= 2) {
+        threads = min(threads, processors);
+        perCpu = Run(shared, TRUE, threads, processors);
+        single = Run(shared, FALSE, threads, processors);
+        if (threads == 1) {
+            baseline = perCpu;
+        }
+
+        printf("%8u %16.2f %16.2f %11.2fx\n", threads, perCpu, single, perCpu / baseline);
+        if (threads == processors) {
+            break;
+        }
+    }
+
+    if (processors == 1) {
+        printf("Un solo procesador: no hay escalado que medir\n");
+    }
+
+    free(memory);
+    free(shared);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <stdarg.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "ring_buffer.h"
+#include "trace_ring.h"
+
+// Coste por paquete del diagnóstico del camino caliente: el envío y la
+// lectura de un paquete estéreo int16 de 10 ms por el anillo, sin nada, con
+// la traza binaria (IOCTL, escritura, fin del IOCTL y lectura) y con los seis
+// DEBUG_PRINT que hacía el driver por paquete. El registro de cadenas se
+// aproxima con vsnprintf a un buffer de pila, que es lo que DbgPrint hace
+// antes de entregar el mensaje: es una cota inferior de su coste. Se da el
+// mejor de varios intentos alternos.
+//
+// La hora de cada registro es una lectura de memoria, como
+// KeQueryInterruptTime (en máquinas virtuales rdtsc puede costar más que el
+// registro entero).
+
+#define BENCH_RING_FRAMES  (1 << 14)
+#define BENCH_PACKET       480
+#define BENCH_BASE_PACKETS 500000ULL
+#define BENCH_ROUNDS       5
+#define BENCH_IOCTL_CODE   0x222000
+
+typedef enum _BENCH_MODE {
+    BENCH_MODE_OFF = 0,
+    BENCH_MODE_TRACE,
+    BENCH_MODE_STRING,
+    BENCH_MODE_COUNT
+} BENCH_MODE;
+
+static const char *g_ModeNames[BENCH_MODE_COUNT] = { "sin diagnóstico", "traza binaria", "cadenas" };
+
+static SHORT g_Storage[BENCH_RING_FRAMES * 2];
+static SHORT g_Packet[BENCH_PACKET * 2];
+static SHORT g_Output[BENCH_PACKET * 2];
+static RING_BUFFER g_Ring;
+static TRACE_RING g_Trace;
+static TRACE_RECORD g_Records[4096];
+static volatile ULONG g_Sink;
+static volatile ULONG64 g_InterruptTime;
+
+// Como DbgPrint: formatea el mensaje completo con su prefijo
+static void __attribute__((noinline, format(printf, 1, 2))) StringLog(const char *format, ...)
+{
+    char buffer[512];
+    va_list args;
+
+    va_start(args, format);
+    g_Sink += (ULONG)vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    BenchDoNotOptimize(buffer);
+}
+
+static double Run(BENCH_MODE Mode, ULONG64 Packets)
+{
+    ULONG bytes = sizeof(g_Packet);
+    unsigned long long start;
+    ULONG written;
+    ULONG read;
+    ULONG64 i;
+
+    RingBufferInitialize(&g_Ring, g_Storage, BENCH_RING_FRAMES, 2 * sizeof(SHORT));
+    TraceRingInitialize(&g_Trace, g_Records, sizeof(g_Records), 4096);
+
+    start = BenchNowNs();
+
+    for (i = 0; i < Packets; i++) {
+        // Envío (DispatchDeviceControl -> HandleSendAudio -> WriteAudioToBuffer)
+        if (Mode == BENCH_MODE_TRACE) {
+            TraceRingWrite(&g_Trace, TRACE_EVENT_IOCTL, g_InterruptTime, BENCH_IOCTL_CODE, bytes + 16, 0);
+        } else if (Mode == BENCH_MODE_STRING) {
+            StringLog("VirtualMic: IOCTL 0x%X received\n", BENCH_IOCTL_CODE);
+            StringLog("VirtualMic: HandleSendAudio called\n");
+        }
+
+        written = RingBufferWrite(&g_Ring, g_Packet, BENCH_PACKET) * 2 * sizeof(SHORT);
+
+        if (Mode == BENCH_MODE_TRACE) {
+            TraceRingWrite(&g_Trace, TRACE_EVENT_WRITE, g_InterruptTime, bytes, written, 0);
+            TraceRingWrite(&g_Trace, TRACE_EVENT_IOCTL_COMPLETE, g_InterruptTime, BENCH_IOCTL_CODE, 0, written);
+        } else if (Mode == BENCH_MODE_STRING) {
+            StringLog("VirtualMic: Written %lu bytes to audio buffer\n", (unsigned long)written);
+            StringLog("VirtualMic: Successfully written %lu bytes to buffer\n", (unsigned long)written);
+        }
+
+        // Lectura (DispatchRead -> ReadAudioFromBuffer)
+        if (Mode == BENCH_MODE_STRING) {
+            StringLog("VirtualMic: Read request received\n");
+        }
+
+        read = RingBufferRead(&g_Ring, g_Output, BENCH_PACKET);
+
+        if (Mode == BENCH_MODE_TRACE) {
+            TraceRingWrite(&g_Trace, TRACE_EVENT_READ, g_InterruptTime, BENCH_PACKET, read, 0);
+        } else if (Mode == BENCH_MODE_STRING) {
+            StringLog("VirtualMic: Read %lu frames from audio buffer\n", (unsigned long)read);
+        }
+
+        BenchDoNotOptimize(g_Output);
+        g_InterruptTime = i;
+    }
+
+    return (double)(BenchNowNs() - start) / (double)Packets;
+}
+
+int main(int argc, char **argv)
+{
+    ULONG64 packets = (ULONG64)(BENCH_BASE_PACKETS * BenchScale(argc, argv));
+    double best[BENCH_MODE_COUNT];
+    double ns;
+    ULONG round;
+    ULONG mode;
+
+    memset(g_Packet, 0x11, sizeof(g_Packet));
+
+    for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+        best[mode] = 1e30;
+    }
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+            ns = Run((BENCH_MODE)mode, packets);
+            best[mode] = min(best[mode], ns);
+        }
+    }
+
+    printf("=== Diagnóstico por paquete (estéreo int16, %u frames) ===\n", BENCH_PACKET);
+    printf("%-18s %12s %12s %10s\n", "modo", "ns/paquete", "coste ns", "relativo");
+    for (mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+        printf("%-18s %12.2f %12.2f %9.2fx\n", g_ModeNames[mode], best[mode],
+               best[mode] - best[BENCH_MODE_OFF], best[mode] / best[BENCH_MODE_OFF]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <pthread.h>
+#include <errno.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "ring_buffer.h"
+#include "watermark.h"
+
+// Productor que sondea el nivel con GET_STATS frente a uno que espera el aviso
+// de nivel bajo (IOCTL_VIRTUALMIC_SET_WATERMARKS). Se cuentan las llamadas al
+// driver (consultas, envíos y esperas) y los underruns del consumidor en
+// tiempo real. Modelo de host: mutex en lugar de spinlocks y variable de
+// condición en lugar del evento de usuario.
+
+#define BENCH_RING_FRAMES     2048      // ~42 ms a 48 kHz
+#define BENCH_PERIOD_NS       1000000ULL
+#define BENCH_CONSUMER_FRAMES 48        // 48 kHz
+#define BENCH_PACKET_FRAMES   480       // 10 ms por envío
+#define BENCH_LOW_WATER       960       // 20 ms
+#define BENCH_BASE_PERIODS    2000      // 2 s de audio
+
+typedef struct _WATERMARK_CONTEXT {
+    RING_BUFFER Ring;
+    USHORT Storage[BENCH_RING_FRAMES];
+    USHORT Packet[BENCH_PACKET_FRAMES];
+    pthread_mutex_t ProducerLock;
+    WATERMARK_STATE Watermarks;
+    pthread_mutex_t EventLock;
+    pthread_cond_t EventSignaled;
+    BOOLEAN EventSet;
+    BOOLEAN EventDriven;
+    ULONG PollIntervalNs;
+    ULONG Periods;
+    volatile BOOLEAN ConsumerDone;
+
+    // Resultados
+    ULONG64 StatsCalls;
+    ULONG64 SendCalls;
+    ULONG64 WaitCalls;
+    ULONG Underruns;
+} WATERMARK_CONTEXT;
+
+static void SleepUntil(unsigned long long deadlineNs)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(deadlineNs / 1000000000ULL);
+    ts.tv_nsec = (long)(deadlineNs % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+// SignalWatermarks
+static void SignalWatermarksModel(WATERMARK_CONTEXT *context)
+{
+    if (!context->EventDriven ||
+        !WatermarkUpdate(&context->Watermarks, RingBufferGetUsedFrames(&context->Ring))) {
+        return;
+    }
+
+    pthread_mutex_lock(&context->EventLock);
+    context->EventSet = TRUE;
+    pthread_cond_signal(&context->EventSignaled);
+    pthread_mutex_unlock(&context->EventLock);
+}
+
+// SEND_AUDIO con OVERFLOW_POLICY_REJECT
+static BOOLEAN SendPacket(WATERMARK_CONTEXT *context)
+{
+    BOOLEAN written = FALSE;
+
+    context->SendCalls++;
+
+    pthread_mutex_lock(&context->ProducerLock);
+    if (RingBufferGetFreeFrames(&context->Ring) >= BENCH_PACKET_FRAMES) {
+        RingBufferWrite(&context->Ring, context->Packet, BENCH_PACKET_FRAMES);
+        written = TRUE;
+    }
+    pthread_mutex_unlock(&context->ProducerLock);
+
+    if (written) {
+        SignalWatermarksModel(context);
+    }
+
+    return written;
+}
+
+// Rellena el anillo; el productor conoce el nivel por la consulta previa
+static void Refill(WATERMARK_CONTEXT *context, ULONG usedFrames)
+{
+    while (usedFrames + BENCH_PACKET_FRAMES <= BENCH_RING_FRAMES && SendPacket(context)) {
+        usedFrames += BENCH_PACKET_FRAMES;
+    }
+}
+
+static void *PollingProducer(WATERMARK_CONTEXT *context)
+{
+    unsigned long long next = BenchNowNs();
+    ULONG used;
+
+    while (!context->ConsumerDone) {
+        // GET_STATS: una ida y vuelta completa por consulta
+        context->StatsCalls++;
+        used = RingBufferGetUsedFrames(&context->Ring);
+        if (used <= BENCH_LOW_WATER) {
+            Refill(context, used);
+        }
+
+        next += context->PollIntervalNs;
+        SleepUntil(next);
+    }
+
+    return NULL;
+}
+
+static void *EventProducer(WATERMARK_CONTEXT *context)
+{
+    // El registro avisa de inmediato: el anillo empieza vacío
+    WatermarkInitialize(&context->Watermarks, BENCH_LOW_WATER, 0);
+    SignalWatermarksModel(context);
+
+    while (!context->ConsumerDone) {
+        context->WaitCalls++;
+
+        pthread_mutex_lock(&context->EventLock);
+        while (!context->EventSet && !context->ConsumerDone) {
+            pthread_cond_wait(&context->EventSignaled, &context->EventLock);
+        }
+        context->EventSet = FALSE;
+        pthread_mutex_unlock(&context->EventLock);
+
+        Refill(context, RingBufferGetUsedFrames(&context->Ring));
+    }
+
+    return NULL;
+}
+
+static void *Producer(void *arg)
+{
+    WATERMARK_CONTEXT *context = (WATERMARK_CONTEXT *)arg;
+
+    return context->EventDriven ? EventProducer(context) : PollingProducer(context);
+}
+
+static void *Consumer(void *arg)
+{
+    WATERMARK_CONTEXT *context = (WATERMARK_CONTEXT *)arg;
+    USHORT chunk[BENCH_CONSUMER_FRAMES];
+    unsigned long long next = BenchNowNs();
+    ULONG period;
+
+    // Margen para que el productor haga el primer relleno
+    next += 20 * BENCH_PERIOD_NS;
+
+    for (period = 0; period < context->Periods; period++) {
+        next += BENCH_PERIOD_NS;
+        SleepUntil(next);
+
+        if (RingBufferRead(&context->Ring, chunk, BENCH_CONSUMER_FRAMES) < BENCH_CONSUMER_FRAMES) {
+            context->Underruns++;
+        }
+
+        SignalWatermarksModel(context);
+    }
+
+    pthread_mutex_lock(&context->EventLock);
+    context->ConsumerDone = TRUE;
+    pthread_cond_broadcast(&context->EventSignaled);
+    pthread_mutex_unlock(&context->EventLock);
+
+    return NULL;
+}
+
+static void RunOnce(WATERMARK_CONTEXT *context, BOOLEAN eventDriven, ULONG pollIntervalMs, ULONG periods)
+{
+    pthread_t producer;
+    pthread_t consumer;
+
+    memset(context, 0, sizeof(*context));
+    RingBufferInitialize(&context->Ring, context->Storage, BENCH_RING_FRAMES, sizeof(USHORT));
+    pthread_mutex_init(&context->ProducerLock, NULL);
+    pthread_mutex_init(&context->EventLock, NULL);
+    pthread_cond_init(&context->EventSignaled, NULL);
+    context->EventDriven = eventDriven;
+    context->PollIntervalNs = pollIntervalMs * 1000000UL;
+    context->Periods = periods;
+
+    pthread_create(&producer, NULL, Producer, context);
+    pthread_create(&consumer, NULL, Consumer, context);
+    pthread_join(consumer, NULL);
+    pthread_join(producer, NULL);
+
+    pthread_mutex_destroy(&context->ProducerLock);
+    pthread_mutex_destroy(&context->EventLock);
+    pthread_cond_destroy(&context->EventSignaled);
+}
+
+static void PrintRow(const char *name, WATERMARK_CONTEXT *context, double seconds)
+{
+    ULONG64 calls = context->StatsCalls + context->SendCalls + context->WaitCalls;
+
+    printf("%-14s %10.0f %10llu %10llu %10llu %10u\n",
+           name,
+           (double)calls / seconds,
+           (unsigned long long)context->StatsCalls,
+           (unsigned long long)context->SendCalls,
+           (unsigned long long)context->WaitCalls,
+           context->Underruns);
+}
+
+int main(int argc, char **argv)
+{
+    static const ULONG pollIntervalsMs[] = { 1, 10, 40 };
+    static WATERMARK_CONTEXT context;
+    ULONG periods = (ULONG)(BENCH_BASE_PERIODS * BenchScale(argc, argv));
+    double seconds;
+    char name[32];
+    size_t i;
+
+    if (periods == 0) {
+        periods = 1;
+    }
+
+    seconds = (double)periods * BENCH_PERIOD_NS * 1e-9;
+
+    printf("=== Sondeo de GET_STATS frente a avisos de nivel: anillo de %u frames, umbral bajo %u, %.1f s ===\n",
+           BENCH_RING_FRAMES, BENCH_LOW_WATER, seconds);
+    printf("%-14s %10s %10s %10s %10s %10s\n",
+           "productor", "llamadas/s", "GET_STATS", "envíos", "esperas", "underruns");
+
+    for (i = 0; i < sizeof(pollIntervalsMs) / sizeof(pollIntervalsMs[0]); i++) {
+        RunOnce(&context, FALSE, pollIntervalsMs[i], periods);
+        snprintf(name, sizeof(name), "sondeo %lu ms", (unsigned long)pollIntervalsMs[i]);
+        PrintRow(name, &context, seconds);
+    }
+
+    RunOnce(&context, TRUE, 0, periods);
+    PrintRow("eventos", &context, seconds);
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "drift_control.h"
+
+// Simulación de deriva de reloj: el productor envía paquetes de 10 ms con su
+// reloj (desviado en ppm respecto al del consumidor) y el consumidor lee 10 ms
+// del suyo. Sin compensación el anillo acaba lleno o vacío en minutos; con
+// DriftControlReadRing el llenado debe quedar acotado alrededor del objetivo
+// durante todo el día simulado.
+//
+// Se simula en mono a 16 kHz para que un día pase en poco tiempo: el lazo se
+// configura en segundos y su comportamiento no depende de la frecuencia.
+// Argumento opcional: horas simuladas (24 por defecto).
+
+#define SIM_RATE           16000
+#define SIM_PACKET_FRAMES  160          // 10 ms
+#define SIM_RING_FRAMES    4096         // 256 ms
+#define SIM_TARGET_FRAMES  800          // 50 ms
+#define SIM_RESPONSE_S     60
+#define SIM_MAX_PPM        1000
+#define SIM_REPORT_S       (2 * 3600)
+#define SIM_PI             3.14159265358979323846
+
+typedef struct _SIM_SCENARIO {
+    const char *Name;
+    double Ppm;            // Deriva fija del productor
+    double SwingPpm;       // Amplitud de la deriva variable (térmica)
+    double SwingPeriodS;
+    double JitterMs;       // Retraso aleatorio de cada paquete, 0..JitterMs
+} SIM_SCENARIO;
+
+static const SIM_SCENARIO g_Scenarios[] = {
+    { "+500 ppm",                      500.0,   0.0,    0.0, 0.0 },
+    { "-500 ppm",                     -500.0,   0.0,    0.0, 0.0 },
+    { "deriva térmica ±500 ppm (6 h)",   0.0, 500.0, 21600.0, 0.0 },
+    { "+500 ppm con jitter de 8 ms",   500.0,   0.0,    0.0, 8.0 },
+};
+
+#define SIM_SCENARIO_COUNT (sizeof(g_Scenarios) / sizeof(g_Scenarios[0]))
+
+typedef struct _SIM_RESULT {
+    double FirstXrunS;     // Primer anillo lleno o vacío (< 0: ninguno)
+    ULONG64 OverrunFrames;
+    ULONG64 UnderrunFrames;
+    ULONG MinFill;
+    ULONG MaxFill;
+} SIM_RESULT;
+
+static SHORT g_Storage[SIM_RING_FRAMES];
+static SHORT g_Packet[SIM_PACKET_FRAMES];
+static SHORT g_Output[SIM_PACKET_FRAMES];
+static UCHAR g_Memory[1 << 16];
+static ULONG g_Seed;
+
+static double NextUniform(void)
+{
+    g_Seed = g_Seed * 1103515245 + 12345;
+    return (double)((g_Seed >> 8) & 0xFFFFFF) / (double)0x1000000;
+}
+
+static double ProducerPpm(const SIM_SCENARIO *Scenario, double Time)
+{
+    if (Scenario->SwingPeriodS > 0.0) {
+        return Scenario->Ppm + Scenario->SwingPpm * sin(2.0 * SIM_PI * Time / Scenario->SwingPeriodS);
+    }
+
+    return Scenario->Ppm;
+}
+
+static VOID NoteXrun(SIM_RESULT *Result, double Time)
+{
+    if (Result->FirstXrunS < 0.0) {
+        Result->FirstXrunS = Time;
+    }
+}
+
+// Compensate FALSE lee del anillo tal cual, como el driver sin el modo
+static BOOLEAN Simulate(const SIM_SCENARIO *Scenario, BOOLEAN Compensate, double Hours, SIM_RESULT *Result)
+{
+    DRIFT_CONTROL_CONFIG config;
+    DRIFT_CONTROL_STATS stats;
+    PDRIFT_CONTROL driftControl = NULL;
+    RING_BUFFER ring;
+    double period = (double)SIM_PACKET_FRAMES / SIM_RATE;
+    double producerTime = 0.0;
+    double arrival;
+    double now;
+    double correction;
+    double correctionMin = 1e9;
+    double correctionMax = -1e9;
+    ULONG64 reads = (ULONG64)(Hours * 3600.0 / period);
+    ULONG64 perReport = (ULONG64)(SIM_REPORT_S / period);
+    ULONG64 read;
+    ULONG reportMin = SIM_RING_FRAMES;
+    ULONG reportMax = 0;
+    ULONG written;
+    ULONG delivered;
+    ULONG fill;
+
+    memset(Result, 0, sizeof(*Result));
+    Result->FirstXrunS = -1.0;
+    Result->MinFill = SIM_RING_FRAMES;
+
+    if (!NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, SIM_RING_FRAMES, sizeof(SHORT)))) {
+        return FALSE;
+    }
+
+    if (Compensate) {
+        config.Channels = 1;
+        config.Format = SAMPLE_FORMAT_INT16;
+        config.TargetFill = SIM_TARGET_FRAMES;
+        config.MaxCorrectionPpm = SIM_MAX_PPM;
+        config.ResponseFrames = SIM_RESPONSE_S * SIM_RATE;
+        config.Isa = SampleConvertGetBestIsa();
+
+        if (!NT_SUCCESS(DriftControlInitialize(g_Memory, sizeof(g_Memory), &config, &driftControl))) {
+            return FALSE;
+        }
+    }
+
+    // El consumidor empieza con el anillo en el objetivo
+    RingBufferWrite(&ring, g_Storage, SIM_TARGET_FRAMES);
+    arrival = producerTime + NextUniform() * Scenario->JitterMs / 1000.0;
+
+    for (read = 1; read <= reads; read++) {
+        now = (double)read * period;
+
+        // Paquetes que llegan antes de esta lectura (el jitter no los reordena)
+        while (arrival <= now) {
+            written = RingBufferWrite(&ring, g_Packet, SIM_PACKET_FRAMES);
+            if (written < SIM_PACKET_FRAMES) {
+                Result->OverrunFrames += SIM_PACKET_FRAMES - written;
+                NoteXrun(Result, arrival);
+            }
+
+            producerTime += period / (1.0 + ProducerPpm(Scenario, producerTime) * 1e-6);
+            arrival = producerTime + NextUniform() * Scenario->JitterMs / 1000.0;
+        }
+
+        delivered = Compensate ? DriftControlReadRing(driftControl, &ring, g_Output, SIM_PACKET_FRAMES)
+                               : RingBufferRead(&ring, g_Output, SIM_PACKET_FRAMES);
+        if (delivered < SIM_PACKET_FRAMES) {
+            Result->UnderrunFrames += SIM_PACKET_FRAMES - delivered;
+            NoteXrun(Result, now);
+        }
+
+        fill = RingBufferGetUsedFrames(&ring);
+        reportMin = min(reportMin, fill);
+        reportMax = max(reportMax, fill);
+
+        if (Compensate) {
+            DriftControlGetStats(driftControl, &stats);
+            correction = stats.CorrectionPpb / 1000.0;
+            correctionMin = min(correctionMin, correction);
+            correctionMax = max(correctionMax, correction);
+
+            if (read % perReport == 0) {
+                printf("  %5.1f h  llenado %4u..%4u  deriva real %+7.1f ppm  estimada %+7.1f ppm  corrección %+7.1f..%+7.1f ppm\n",
+                       now / 3600.0, reportMin, reportMax, ProducerPpm(Scenario, now),
+                       stats.DriftPpb / 1000.0, correctionMin, correctionMax);
+                correctionMin = 1e9;
+                correctionMax = -1e9;
+            }
+        }
+
+        if (read % perReport == 0) {
+            Result->MinFill = min(Result->MinFill, reportMin);
+            Result->MaxFill = max(Result->MaxFill, reportMax);
+            reportMin = SIM_RING_FRAMES;
+            reportMax = 0;
+        }
+    }
+
+    Result->MinFill = min(Result->MinFill, reportMin);
+    Result->MaxFill = max(Result->MaxFill, reportMax);
+    return TRUE;
+}
+
+static VOID PrintResult(const char *Label, const SIM_RESULT *Result)
+{
+    if (Result->FirstXrunS < 0.0) {
+        printf("  %-15s sin desbordamientos; llenado %u..%u frames (%.1f..%.1f ms, objetivo %.1f ms)\n",
+               Label, Result->MinFill, Result->MaxFill,
+               Result->MinFill * 1000.0 / SIM_RATE, Result->MaxFill * 1000.0 / SIM_RATE,
+               SIM_TARGET_FRAMES * 1000.0 / SIM_RATE);
+    } else {
+        printf("  %-15s primer desbordamiento a los %.0f s; %.1f s perdidos por anillo lleno, %.1f s por vacío\n",
+               Label, Result->FirstXrunS,
+               (double)Result->OverrunFrames / SIM_RATE, (double)Result->UnderrunFrames / SIM_RATE);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    SIM_RESULT result;
+    double hours = (argc > 1) ? atof(argv[1]) : 24.0;
+    double start;
+    ULONG i;
+
+    if (hours <= 0.0) {
+        printf("Uso: %s [horas]\n", argv[0]);
+        return 1;
+    }
+
+    printf("=== Deriva de reloj: %.1f h a %u Hz, anillo de %u frames, objetivo %u, respuesta %u s, máximo %u ppm ===\n",
+           hours, SIM_RATE, SIM_RING_FRAMES, SIM_TARGET_FRAMES, SIM_RESPONSE_S, SIM_MAX_PPM);
+
+    for (i = 0; i < SIM_SCENARIO_COUNT; i++) {
+        printf("\n--- %s ---\n", g_Scenarios[i].Name);
+
+        g_Seed = i + 1;
+        if (!Simulate(&g_Scenarios[i], FALSE, hours, &result)) {
+            return 1;
+        }
+        PrintResult("sin compensar:", &result);
+
+        g_Seed = i + 1;
+        start = BenchNowSeconds();
+        if (!Simulate(&g_Scenarios[i], TRUE, hours, &result)) {
+            return 1;
+        }
+        PrintResult("compensado:", &result);
+        printf("  (%.1f s de CPU)\n", BenchNowSeconds() - start);
+    }
+
+    return 0;
+}
@@ -0,0 +1,296 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "jitter_buffer.h"
+
+// Simulación del jitter buffer con perfiles de retardo de red: cada perfil da
+// el retardo (ms) de cada paquete de 10 ms, o su pérdida. Se reproducen con el
+// retardo adaptativo y con retardos fijos (MinDelay = MaxDelay) y se compara
+// el audio recibido que no llegó a tiempo, los episodios de silencio y el
+// retardo de reproducción medio.
+//
+// Sin argumentos usa perfiles sintéticos. Con argumentos lee ficheros de texto
+// con un valor por línea: retardo en ms, "-" para un paquete perdido; las
+// líneas que empiezan por # se ignoran.
+
+#define SIM_RATE           48000
+#define SIM_PACKET_FRAMES  480          // 10 ms
+#define SIM_TICK_FRAMES    48           // El lector vacía cada 1 ms
+#define SIM_PACKETS        6000         // 60 s por perfil sintético
+#define SIM_MAX_PACKETS    360000       // 1 h por fichero
+#define SIM_LOST           (-1.0)
+
+typedef struct _SIM_PACKET {
+    ULONG64 Timestamp;
+    ULONG64 Arrival;
+} SIM_PACKET;
+
+typedef struct _SIM_RESULT {
+    ULONG64 Lost;              // Recibidos que no salieron (frames)
+    ULONG64 Stretched;
+    ULONG Episodes;            // Tramos de silencio (el final cuenta como uno)
+    double AverageDelay;       // Retardo de reproducción medio (frames)
+    ULONG MaxDelay;
+} SIM_RESULT;
+
+typedef struct _SIM_POLICY {
+    const char *Name;
+    ULONG MinDelay;
+    ULONG MaxDelay;
+    ULONG Percentile;
+} SIM_POLICY;
+
+static const SIM_POLICY g_Policies[] = {
+    { "adaptativo p95", 240, 9600, 95 },
+    { "adaptativo p99", 240, 9600, 99 },
+    { "fijo 20 ms",     960, 960, 100 },
+    { "fijo 60 ms",     2880, 2880, 100 },
+    { "fijo 120 ms",    5760, 5760, 100 },
+};
+
+#define SIM_POLICY_COUNT (sizeof(g_Policies) / sizeof(g_Policies[0]))
+
+static double g_Delays[SIM_MAX_PACKETS];
+static SIM_PACKET g_Packets[SIM_MAX_PACKETS];
+static SHORT g_Packet[SIM_PACKET_FRAMES];
+static UCHAR g_Memory[1 << 20];
+static ULONG g_Seed;
+
+static double NextUniform(void)
+{
+    g_Seed = g_Seed * 1103515245 + 12345;
+    return (double)((g_Seed >> 8) & 0xFFFFFF) / (double)0x1000000;
+}
+
+static double NextExponential(double Mean)
+{
+    return -Mean * log(1.0 - NextUniform());
+}
+
+// Red cableada: 20 ms de base y ±1 ms
+static ULONG ProfileLan(void)
+{
+    ULONG i;
+
+    for (i = 0; i < SIM_PACKETS; i++) {
+        g_Delays[i] = 20.0 + 2.0 * NextUniform();
+    }
+
+    return SIM_PACKETS;
+}
+
+// Wi-Fi: cola larga y ráfagas de retransmisiones que llegan juntas
+static ULONG ProfileWifi(void)
+{
+    double burst = 0.0;
+    ULONG i;
+
+    for (i = 0; i < SIM_PACKETS; i++) {
+        if (burst <= 0.0 && NextUniform() < 0.01) {
+            burst = 40.0 + 60.0 * NextUniform();
+        }
+
+        g_Delays[i] = 5.0 + NextExponential(4.0) + burst;
+        burst = (burst > 10.0) ? burst - 10.0 : 0.0;
+    }
+
+    return SIM_PACKETS;
+}
+
+// Red móvil: el retardo base cambia por tramos de varios segundos y hay pérdidas
+static ULONG ProfileCellular(void)
+{
+    double base = 60.0;
+    ULONG i;
+
+    for (i = 0; i < SIM_PACKETS; i++) {
+        if (i % 1000 == 0) {
+            base = 40.0 + 80.0 * NextUniform();
+        }
+
+        g_Delays[i] = (NextUniform() < 0.02) ? SIM_LOST : base + NextExponential(15.0);
+    }
+
+    return SIM_PACKETS;
+}
+
+// Retardo cambiante: 10 s tranquilos, 10 s con mucho jitter, y así
+static ULONG ProfileAlternating(void)
+{
+    ULONG i;
+
+    for (i = 0; i < SIM_PACKETS; i++) {
+        g_Delays[i] = ((i / 1000) % 2 == 0) ? 30.0 + 2.0 * NextUniform() : 30.0 + 80.0 * NextUniform();
+    }
+
+    return SIM_PACKETS;
+}
+
+static ULONG LoadProfile(const char *Path)
+{
+    char line[128];
+    FILE *file = fopen(Path, "r");
+    ULONG count = 0;
+
+    if (file == NULL) {
+        printf("No se puede abrir %s\n", Path);
+        return 0;
+    }
+
+    while (count < SIM_MAX_PACKETS && fgets(line, sizeof(line), file) != NULL) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+            continue;
+        }
+
+        g_Delays[count++] = (line[0] == '-') ? SIM_LOST : strtod(line, NULL);
+    }
+
+    fclose(file);
+    return count;
+}
+
+static int CompareArrival(const void *A, const void *B)
+{
+    const SIM_PACKET *a = (const SIM_PACKET *)A;
+    const SIM_PACKET *b = (const SIM_PACKET *)B;
+
+    return (a->Arrival > b->Arrival) - (a->Arrival < b->Arrival);
+}
+
+static ULONG BuildPackets(ULONG Count)
+{
+    ULONG packets = 0;
+    ULONG i;
+
+    for (i = 0; i < Count; i++) {
+        if (g_Delays[i] < 0.0) {
+            continue;
+        }
+
+        g_Packets[packets].Timestamp = (ULONG64)i * SIM_PACKET_FRAMES;
+        g_Packets[packets].Arrival = g_Packets[packets].Timestamp + (ULONG64)(g_Delays[i] * SIM_RATE / 1000.0);
+        packets++;
+    }
+
+    qsort(g_Packets, packets, sizeof(SIM_PACKET), CompareArrival);
+    return packets;
+}
+
+static BOOLEAN Simulate(const SIM_POLICY *Policy, ULONG Packets, ULONG64 Duration, SIM_RESULT *Result)
+{
+    JITTER_BUFFER_CONFIG config;
+    JITTER_BUFFER_STATS stats;
+    PJITTER_BUFFER jitterBuffer;
+    ULONG64 concealed = 0;
+    ULONG64 delaySum = 0;
+    ULONG64 playingTicks = 0;
+    ULONG64 now;
+    const VOID *data;
+    ULONG frames;
+    ULONG next = 0;
+    BOOLEAN silent = FALSE;
+
+    config.FrameSize = sizeof(SHORT);
+    config.MinDelay = Policy->MinDelay;
+    config.MaxDelay = Policy->MaxDelay;
+    config.Percentile = Policy->Percentile;
+
+    if (!NT_SUCCESS(JitterBufferInitialize(g_Memory, sizeof(g_Memory), &config, &jitterBuffer))) {
+        return FALSE;
+    }
+
+    memset(Result, 0, sizeof(*Result));
+
+    for (now = 0; now < Duration; now += SIM_TICK_FRAMES) {
+        while (next < Packets && g_Packets[next].Arrival <= now) {
+            JitterBufferInsert(jitterBuffer, g_Packets[next].Timestamp, g_Packet, SIM_PACKET_FRAMES, now);
+            next++;
+        }
+
+        while (JitterBufferPeek(jitterBuffer, now, &data, &frames)) {
+            JitterBufferConsume(jitterBuffer, frames);
+        }
+
+        JitterBufferGetStats(jitterBuffer, &stats);
+
+        if (stats.FramesConcealed > concealed) {
+            if (!silent) {
+                Result->Episodes++;
+            }
+            silent = TRUE;
+        } else if (stats.FramesReleased > 0) {
+            silent = FALSE;
+        }
+        concealed = stats.FramesConcealed;
+
+        if (stats.State == JITTER_BUFFER_STATE_PLAYING) {
+            delaySum += stats.PlayoutDelay;
+            playingTicks++;
+            Result->MaxDelay = max(Result->MaxDelay, stats.PlayoutDelay);
+        }
+    }
+
+    // Lo recibido que no salió: tardío o fuera de la ventana
+    Result->Lost = (ULONG64)Packets * SIM_PACKET_FRAMES - stats.FramesReleased;
+    Result->Stretched = stats.FramesStretched;
+    Result->AverageDelay = playingTicks ? (double)delaySum / (double)playingTicks : 0.0;
+
+    return TRUE;
+}
+
+static VOID RunProfile(const char *Name, ULONG Count)
+{
+    SIM_RESULT result;
+    ULONG64 duration;
+    ULONG packets;
+    ULONG policy;
+
+    packets = BuildPackets(Count);
+    duration = (ULONG64)Count * SIM_PACKET_FRAMES + 2 * SIM_RATE;
+
+    printf("\n--- %s: %u paquetes, %u perdidos en la red ---\n", Name, Count, Count - packets);
+    printf("%-16s %12s %10s %12s %12s %12s\n", "política", "perdido ms", "huecos", "estirado ms", "retardo ms", "máximo ms");
+
+    for (policy = 0; policy < SIM_POLICY_COUNT; policy++) {
+        if (!Simulate(&g_Policies[policy], packets, duration, &result)) {
+            printf("%-16s configuración no válida\n", g_Policies[policy].Name);
+            continue;
+        }
+
+        printf("%-16s %12.1f %10u %12.1f %12.1f %12.1f\n",
+               g_Policies[policy].Name,
+               (double)result.Lost * 1000.0 / SIM_RATE,
+               result.Episodes,
+               (double)result.Stretched * 1000.0 / SIM_RATE,
+               result.AverageDelay * 1000.0 / SIM_RATE,
+               (double)result.MaxDelay * 1000.0 / SIM_RATE);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+
+    printf("=== Jitter buffer: paquetes de 10 ms a 48 kHz, lector cada 1 ms ===\n");
+    printf("perdido = recibido tarde (sin contar la red), retardo = sobre el tránsito mínimo\n");
+
+    if (argc > 1) {
+        for (i = 1; i < argc; i++) {
+            RunProfile(argv[i], LoadProfile(argv[i]));
+        }
+        return 0;
+    }
+
+    g_Seed = 1;
+    RunProfile("LAN", ProfileLan());
+    g_Seed = 2;
+    RunProfile("Wi-Fi con ráfagas", ProfileWifi());
+    g_Seed = 3;
+    RunProfile("red móvil", ProfileCellular());
+    g_Seed = 4;
+    RunProfile("jitter alterno", ProfileAlternating());
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#ifndef AUDIO_BATCH_H
+#define AUDIO_BATCH_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+#include "sample_convert.h"
+
+// Formato de IOCTL_VIRTUALMIC_SEND_AUDIO_BATCH: una cabecera con el número de
+// paquetes, el array de descriptores y a continuación los datos. Los offsets
+// son relativos al inicio del buffer de entrada. La salida es un
+// AUDIO_BATCH_RESULT por paquete, en el mismo orden.
+
+#define MAX_AUDIO_BATCH_PACKETS 64
+
+typedef struct _AUDIO_BATCH_DESCRIPTOR {
+    ULONG64 Timestamp;
+    ULONG DataOffset;
+    ULONG DataLength;
+} AUDIO_BATCH_DESCRIPTOR, *PAUDIO_BATCH_DESCRIPTOR;
+
+typedef struct _AUDIO_BATCH_HEADER {
+    ULONG PacketCount;
+    ULONG Reserved;
+    AUDIO_BATCH_DESCRIPTOR Packets[1]; // PacketCount descriptores
+} AUDIO_BATCH_HEADER, *PAUDIO_BATCH_HEADER;
+
+typedef struct _AUDIO_BATCH_RESULT {
+    LONG Status;       // NTSTATUS del paquete
+    ULONG BytesWritten;
+} AUDIO_BATCH_RESULT, *PAUDIO_BATCH_RESULT;
+
+#define AUDIO_BATCH_HEADER_SIZE(count) \
+    (FIELD_OFFSET(AUDIO_BATCH_HEADER, Packets) + (count) * sizeof(AUDIO_BATCH_DESCRIPTOR))
+
+// Valida en una sola pasada la cabecera y todos los descriptores: datos dentro
+// del buffer y longitudes múltiplo de FrameSize. Devuelve el total de frames.
+NTSTATUS AudioBatchValidate(
+    _In_reads_bytes_(Length) const VOID *Buffer,
+    _In_ ULONG Length,
+    _In_ ULONG FrameSize,
+    _Out_ PULONG TotalFrames
+);
+
+// Escribe un lote ya validado. Sin DropOldest cada paquete entra completo o se
+// rechaza con STATUS_BUFFER_TOO_SMALL; con DropOldest se descarta audio antiguo
+// y el llamador debe excluir también al consumidor. El llamador serializa a
+// los productores. Devuelve los paquetes rechazados o con frames descartados.
+// Con Converter los paquetes vienen en su formato de origen (BytesWritten
+// cuenta bytes de entrada); NULL copia frames de Ring->FrameSize.
+ULONG AudioBatchWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Buffer,
+    _In_opt_ const SAMPLE_CONVERTER *Converter,
+    _In_ BOOLEAN DropOldest,
+    _Out_writes_(((const AUDIO_BATCH_HEADER *)Buffer)->PacketCount) PAUDIO_BATCH_RESULT Results
+);
+
+#endif // AUDIO_BATCH_H
@@ -3,6 +3,8 @@
 
 #include "virtual_mic.h"
 #include "driver_core.h"
+#include "audio_batch.h"
+#include "fused_write.h"
 
 // Funciones de procesamiento de audio
 NTSTATUS WriteAudioToBuffer(
@@ -12,6 +14,35 @@ NTSTATUS WriteAudioToBuffer(
     _Out_ PULONG BytesWritten
 );
 
+// Escribe un lote de SEND_AUDIO_BATCH en una sola sección crítica (salvo con
+// OVERFLOW_POLICY_BLOCK o con conversión de frecuencia, que escriben paquete a
+// paquete). Un lote no queda pendiente: con OVERFLOW_POLICY_PEND se rechaza
+// por paquete.
+NTSTATUS WriteAudioBatchToBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID BatchBuffer,
+    _In_ ULONG BatchLength,
+    _Out_writes_(MAX_AUDIO_BATCH_PACKETS) PAUDIO_BATCH_RESULT Results,
+    _Out_ PULONG PacketCount
+);
+
+// Envío con jitter buffer activo: el paquete se guarda en la posición de
+// Timestamp y pasa al anillo lo que ya venció. Sin jitter buffer equivale a
+// WriteAudioToBuffer.
+NTSTATUS WriteTimestampedAudio(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID AudioData,
+    _In_ ULONG DataLength,
+    _In_ ULONG64 Timestamp,
+    _Out_ PULONG BytesWritten
+);
+
+// Pasa al anillo lo que ha vencido desde el último envío (silencio incluido):
+// lo llaman las lecturas para que el tiempo avance aunque el productor calle
+VOID ServiceJitterBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
 NTSTATUS ReadAudioFromBuffer(
     _In_ PDEVICE_EXTENSION DeviceExtension,
     _Out_ PVOID AudioData,
@@ -19,11 +50,66 @@ NTSTATUS ReadAudioFromBuffer(
     _Out_ PULONG BytesRead
 );
 
+// Cambia el formato del dispositivo y/o el de entrada (PASSIVE_LEVEL)
 NTSTATUS SetAudioFormat(
     _In_ PDEVICE_EXTENSION DeviceExtension,
-    _In_ ULONG SampleRate,
-    _In_ USHORT Channels,
-    _In_ USHORT BitsPerSample
+    _In_ const SET_FORMAT_REQUEST *Request
+);
+
+// Sustituye la matriz de mezcla del par de canales activo (PASSIVE_LEVEL)
+NTSTATUS SetChannelMix(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_CHANNEL_MIX_REQUEST *Request
+);
+
+// Activa, desactiva o consulta el jitter buffer (PASSIVE_LEVEL). Stats recibe
+// los contadores del que estaba activo.
+NTSTATUS SetJitterBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_JITTER_BUFFER_REQUEST *Request,
+    _Out_ PJITTER_BUFFER_STATS Stats
+);
+
+// Activa, desactiva o consulta la compensación de deriva (PASSIVE_LEVEL).
+// Stats recibe el estado del lazo que estaba activo.
+NTSTATUS SetDriftControl(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_DRIFT_CONTROL_REQUEST *Request,
+    _Out_ PDRIFT_CONTROL_STATS Stats
+);
+
+// Activa, sustituye, desactiva o consulta la cadena de procesado de la
+// lectura (PASSIVE_LEVEL). Stats recibe el estado de la que estaba activa.
+NTSTATUS SetDspChain(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_DSP_CHAIN_REQUEST *Request,
+    _Out_ PDSP_CHAIN_STATS Stats
+);
+
+// Activa, desactiva o consulta los medidores de nivel (ver METERING_REQUEST).
+// Snapshot recibe la ventana anterior a la petición.
+NTSTATUS SetMetering(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const METERING_REQUEST *Request,
+    _Out_ PLEVEL_METER_SNAPSHOT Snapshot
+);
+
+// Ganancia y silencio de salida con rampa (ver SET_GAIN_REQUEST)
+NTSTATUS SetOutputGain(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ float Gain,
+    _In_ ULONG RampFrames
+);
+
+VOID SetOutputMute(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ BOOLEAN Mute
+);
+
+// Latencias del anillo interno desde la petición anterior; empieza otra ventana
+VOID GetLatencyStats(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _Out_ PLATENCY_STATS Stats
 );
 
 VOID GetCurrentAudioFormat(
@@ -31,12 +117,39 @@ VOID GetCurrentAudioFormat(
     _Out_ PAUDIO_FORMAT Format
 );
 
-// Funciones de utilidad para el buffer circular
-ULONG GetBufferFreeSpace(
+// Escritura de frames del productor en el anillo, con conversión de formato y,
+// si hay Resampler, de frecuencia. Se llaman con ProducerLock tomado (la de
+// descarte, también con ConsumerLock) y devuelven frames de entrada consumidos.
+ULONG WriteInputFramesToRing(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const VOID *AudioData,
+    _In_ ULONG Frames
+);
+
+ULONG WriteInputFramesToRingDropOldest(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const VOID *AudioData,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+);
+
+// Frames del anillo que bastan para Frames frames de entrada en cualquier
+// estado del conversor de frecuencia (con ProducerLock tomado)
+ULONG GetRingFramesForInput(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG Frames
+);
+
+// Funciones de utilidad para el buffer circular (en frames del formato activo)
+ULONG GetBufferFreeFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
+ULONG GetBufferUsedFrames(
     _In_ PDEVICE_EXTENSION DeviceExtension
 );
 
-ULONG GetBufferUsedSpace(
+ULONG GetBufferCapacityFrames(
     _In_ PDEVICE_EXTENSION DeviceExtension
 );
 
@@ -0,0 +1,112 @@
+#ifndef CHANNEL_MIX_H
+#define CHANNEL_MIX_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+#include "sample_convert.h"
+#include "resampler.h"
+
+// Mezcla de canales entre el productor y el dispositivo (1 a 8 canales) con
+// una matriz de ganancias lineales: salida[o] = suma de Matrix[o][i] * entrada[i],
+// acumulada en orden de i. Se trabaja en float: la entrada se decodifica desde
+// su formato y la salida se codifica al del dispositivo (o pasa al conversor
+// de frecuencia). Los canales siguen el orden de WAVEFORMATEXTENSIBLE
+// (FL FR FC LFE BL BR SL SR).
+//
+// Las formas habituales (1->2, 2->1, 6->2, 8->2) tienen núcleo SSE2; el resto
+// usa el escalar genérico. Todos acumulan en el mismo orden y dan resultados
+// idénticos bit a bit. El camino de datos no reserva memoria ni usa la CRT.
+
+#define CHANNEL_MIX_MAX_CHANNELS 8
+#define CHANNEL_MIX_BLOCK_FRAMES 256     // Frames por pasada de decodificación/codificación
+#define CHANNEL_MIX_MAX_GAIN     16.0f   // |coeficiente| máximo de una matriz propia
+
+// Valores de SET_CHANNEL_MIX_REQUEST.Preset
+typedef enum _CHANNEL_MIX_PRESET {
+    CHANNEL_MIX_PRESET_AUTO = 0,           // El preset del par de canales o, si no hay, DIRECT
+    CHANNEL_MIX_PRESET_MONO_TO_STEREO,     // L = R = M
+    CHANNEL_MIX_PRESET_STEREO_TO_MONO,     // M = (L + R) / 2
+    CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO, // ITU-R BS.775 sin LFE, normalizada
+    CHANNEL_MIX_PRESET_SURROUND71_TO_STEREO, // Ídem con los laterales
+    CHANNEL_MIX_PRESET_DIRECT,             // Canal i -> canal i; sobrantes en silencio o descartados
+    CHANNEL_MIX_PRESET_CUSTOM,             // Matriz del llamador
+    CHANNEL_MIX_PRESET_COUNT
+} CHANNEL_MIX_PRESET;
+
+typedef struct _CHANNEL_MIX CHANNEL_MIX, *PCHANNEL_MIX;
+
+// Mezcla Frames frames intercalados de Source (InputChannels) a Target (OutputChannels)
+typedef VOID (*CHANNEL_MIX_ROUTINE)(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+);
+
+typedef struct _CHANNEL_MIX_CONFIG {
+    ULONG InputChannels;
+    ULONG OutputChannels;
+    SAMPLE_FORMAT SourceFormat;
+    SAMPLE_FORMAT TargetFormat;   // Con conversor de frecuencia detrás, FLOAT32
+    CHANNEL_MIX_PRESET Preset;
+    SAMPLE_CONVERT_ISA Isa;       // SCALAR fuerza la referencia; el resto usa SSE2
+    float Matrix[CHANNEL_MIX_MAX_CHANNELS][CHANNEL_MIX_MAX_CHANNELS]; // [salida][entrada], solo CUSTOM
+} CHANNEL_MIX_CONFIG, *PCHANNEL_MIX_CONFIG;
+
+struct _CHANNEL_MIX {
+    ULONG InputChannels;
+    ULONG OutputChannels;
+    CHANNEL_MIX_PRESET Preset;    // El efectivo (AUTO ya resuelto)
+    CHANNEL_MIX_ROUTINE Routine;
+    float Matrix[CHANNEL_MIX_MAX_CHANNELS][CHANNEL_MIX_MAX_CHANNELS];
+
+    SAMPLE_CONVERTER Decoder;     // Formato de entrada -> float32
+    SAMPLE_CONVERTER Encoder;     // float32 -> formato de destino
+    float InputBlock[CHANNEL_MIX_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+    float OutputBlock[CHANNEL_MIX_BLOCK_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+};
+
+// Canales de entrada y salida que exige Preset (0 = cualquiera)
+VOID ChannelMixGetPresetShape(
+    _In_ CHANNEL_MIX_PRESET Preset,
+    _Out_ PULONG InputChannels,
+    _Out_ PULONG OutputChannels
+);
+
+// STATUS_INVALID_PARAMETER si los canales no encajan con el preset o la
+// matriz propia tiene coeficientes no finitos o mayores que CHANNEL_MIX_MAX_GAIN;
+// STATUS_NOT_SUPPORTED si se fuerza una variante que la CPU no tiene
+NTSTATUS ChannelMixInitialize(
+    _Out_ PCHANNEL_MIX Mix,
+    _In_ const CHANNEL_MIX_CONFIG *Config
+);
+
+VOID ChannelMixFrames(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+);
+
+// Igual que SampleConvertWriteRing: decodifica, mezcla y escribe en el anillo.
+// Con Resampler (configurado con FLOAT32 de entrada y OutputChannels canales)
+// la mezcla pasa antes por él y solo se consume la entrada cuya salida cabe.
+ULONG ChannelMixWriteRing(
+    _Inout_ PCHANNEL_MIX Mix,
+    _Inout_opt_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+);
+
+// Igual que SampleConvertWriteRingDropOldest (el llamador excluye al consumidor)
+ULONG ChannelMixWriteRingDropOldest(
+    _Inout_ PCHANNEL_MIX Mix,
+    _Inout_opt_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+);
+
+#endif // CHANNEL_MIX_H
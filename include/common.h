@@ -3,9 +3,42 @@
 
 #include <ntddk.h>
 
+// Niveles de registro: lo que queda por encima de VMIC_LOG_LEVEL no se
+// compila (los argumentos tampoco se evalúan). Por defecto las compilaciones
+// DBG imprimen hasta INFO y las de release solo errores. VERBOSE es el camino
+// por paquete (envíos, escrituras, lecturas): formatear a ese ritmo cuesta
+// más que el propio paquete; para seguirlo está la traza binaria (TRACE_LOG).
+#define VMIC_LOG_LEVEL_NONE    0
+#define VMIC_LOG_LEVEL_ERROR   1
+#define VMIC_LOG_LEVEL_INFO    2
+#define VMIC_LOG_LEVEL_VERBOSE 3
+
+#ifndef VMIC_LOG_LEVEL
+#if DBG
+#define VMIC_LOG_LEVEL VMIC_LOG_LEVEL_INFO
+#else
+#define VMIC_LOG_LEVEL VMIC_LOG_LEVEL_ERROR
+#endif
+#endif
+
 // Macros de utilidad
-#define DEBUG_PRINT(fmt, ...) DbgPrint("VirtualMic: " fmt "\n", ##__VA_ARGS__)
+#if VMIC_LOG_LEVEL >= VMIC_LOG_LEVEL_ERROR
 #define ERROR_PRINT(fmt, ...) DbgPrint("VirtualMic ERROR: " fmt "\n", ##__VA_ARGS__)
+#else
+#define ERROR_PRINT(fmt, ...) ((void)0)
+#endif
+
+#if VMIC_LOG_LEVEL >= VMIC_LOG_LEVEL_INFO
+#define DEBUG_PRINT(fmt, ...) DbgPrint("VirtualMic: " fmt "\n", ##__VA_ARGS__)
+#else
+#define DEBUG_PRINT(fmt, ...) ((void)0)
+#endif
+
+#if VMIC_LOG_LEVEL >= VMIC_LOG_LEVEL_VERBOSE
+#define VERBOSE_PRINT(fmt, ...) DbgPrint("VirtualMic: " fmt "\n", ##__VA_ARGS__)
+#else
+#define VERBOSE_PRINT(fmt, ...) ((void)0)
+#endif
 
 // Validaciones
 #define IS_VALID_SAMPLE_RATE(rate) ((rate) >= 8000 && (rate) <= 192000)
@@ -0,0 +1,135 @@
+#ifndef DRIFT_CONTROL_H
+#define DRIFT_CONTROL_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+#include "sample_convert.h"
+
+// Compensación de deriva de reloj entre productor y consumidor. Los relojes
+// nunca coinciden del todo y, al cabo de horas, el anillo acaba lleno o vacío.
+// El lector no toma los frames del anillo uno a uno: los interpola con un paso
+// 1 + Correction (frames del anillo por frame entregado), de modo que consume
+// un poco más deprisa si el anillo tiende a llenarse y más despacio si tiende
+// a vaciarse.
+//
+// Lazo: tras cada lectura completa se filtra el llenado (media exponencial de
+// constante ResponseFrames / 4) y un PI con amortiguamiento crítico y
+// constante de tiempo ResponseFrames (frames del dispositivo) da la corrección:
+//   Correction = 2 e / T + (1 / T^2) * suma(e), e = llenado medio - TargetFill
+// La parte integral converge a la deriva relativa entre los dos relojes y
+// deja el error en cero; ambas partes se acotan a ±MaxCorrectionPpm. Una
+// lectura que vacía el anillo congela el lazo (no es deriva sino un corte).
+//
+// Con paquetes del mismo tamaño que las lecturas, el llenado visto al leer
+// solo toma dos valores (llegó o no el último paquete), así que enganchado el
+// lazo oscila lentamente alrededor de la deriva real. La amplitud cae con el
+// cuadrado de T: con T de un minuto es de unas decenas de ppm (décimas de
+// cent), muy por debajo de lo audible. El llenado queda dentro de un paquete.
+//
+// Interpolador: sinc con ventana de Kaiser (el prototipo de resampler.h) de
+// DRIFT_CONTROL_TAPS coeficientes en DRIFT_CONTROL_PHASES + 1 fases; la fase
+// fraccionaria se interpola linealmente entre dos filas. La posición es de
+// punto fijo 32.32, así que el paso se ajusta en pasos de 0,0002 ppm y los
+// cambios de corrección nunca producen saltos audibles.
+//
+// Trabaja en float: lo leído del anillo se decodifica y la salida se codifica
+// al mismo formato. El llamador reserva la memoria y serializa las llamadas
+// (el lado consumidor del anillo).
+
+#define DRIFT_CONTROL_TAPS                 32
+#define DRIFT_CONTROL_PHASE_BITS           7
+#define DRIFT_CONTROL_PHASES               (1 << DRIFT_CONTROL_PHASE_BITS)
+#define DRIFT_CONTROL_BLOCK_FRAMES         256     // Frames por pasada de decodificación/codificación
+#define DRIFT_CONTROL_MAX_CORRECTION_PPM   10000
+#define DRIFT_CONTROL_MIN_RESPONSE_FRAMES  4800    // 100 ms a 48 kHz
+#define DRIFT_CONTROL_MAX_CHANNELS         8
+
+typedef struct _DRIFT_CONTROL_CONFIG {
+    ULONG Channels;
+    SAMPLE_FORMAT Format;         // El del anillo y el de la salida
+    ULONG TargetFill;             // Frames que se quieren en el anillo
+    ULONG MaxCorrectionPpm;       // 1..DRIFT_CONTROL_MAX_CORRECTION_PPM
+    ULONG ResponseFrames;         // Constante de tiempo del lazo
+    SAMPLE_CONVERT_ISA Isa;
+} DRIFT_CONTROL_CONFIG, *PDRIFT_CONTROL_CONFIG;
+
+// Estado del lazo (también se devuelve por IOCTL)
+typedef struct _DRIFT_CONTROL_STATS {
+    ULONG64 FramesConsumed;       // Leídos del anillo
+    ULONG64 FramesProduced;       // Entregados
+    LONG CorrectionPpb;           // Corrección aplicada (> 0: se consume más deprisa)
+    LONG DriftPpb;                // Parte integral: deriva estimada del productor
+    ULONG AverageFill;            // Llenado filtrado (frames)
+    ULONG TargetFill;             // Objetivo en uso
+    ULONG ShortReads;             // Lecturas que vaciaron el anillo
+    ULONG Reserved;
+} DRIFT_CONTROL_STATS, *PDRIFT_CONTROL_STATS;
+
+typedef struct _DRIFT_CONTROL {
+    DRIFT_CONTROL_CONFIG Config;
+    ULONG FrameSize;              // Bytes por frame del anillo
+
+    // Lazo
+    double ProportionalGain;      // 2 / T
+    double IntegralGain;          // 1 / T^2
+    double SmoothingFrames;       // T / 4
+    double MaxCorrection;
+    double AverageFill;
+    double Integral;
+    BOOLEAN Primed;               // AverageFill ya tiene una medida
+
+    // Interpolador: la próxima salida usa la ventana de History que empieza
+    // en Position >> 32 con la fase fraccionaria Position & 0xFFFFFFFF
+    ULONG64 Position;
+    ULONG64 Step;                 // 2^32 * (1 + corrección)
+    ULONG HistoryFrames;          // Frames válidos en History
+
+    const float *Coefficients;    // PHASES + 1 filas de TAPS (ventana en orden temporal)
+    float *History;               // TAPS + BLOCK_FRAMES frames intercalados
+    float *OutputBlock;           // BLOCK_FRAMES frames intercalados
+
+    SAMPLE_CONVERTER Decoder;     // Formato del anillo -> float32
+    SAMPLE_CONVERTER Encoder;     // float32 -> formato del anillo
+    DRIFT_CONTROL_STATS Stats;
+} DRIFT_CONTROL, *PDRIFT_CONTROL;
+
+BOOLEAN DriftControlIsValidConfig(
+    _In_ const DRIFT_CONTROL_CONFIG *Config
+);
+
+// Bytes necesarios para Config (0 si no es válida)
+SIZE_T DriftControlGetRequiredSize(
+    _In_ const DRIFT_CONTROL_CONFIG *Config
+);
+
+// Diseña el interpolador (PASSIVE_LEVEL). El DRIFT_CONTROL vive al principio
+// de Memory (se libera junto con ella)
+NTSTATUS DriftControlInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const DRIFT_CONTROL_CONFIG *Config,
+    _Out_ PDRIFT_CONTROL *DriftControl
+);
+
+// Olvida la historia y el lazo; conserva los contadores
+VOID DriftControlReset(
+    _Inout_ PDRIFT_CONTROL DriftControl
+);
+
+// Entrega hasta Frames frames en Output consumiendo el anillo al ritmo
+// corregido y, si la lectura fue completa, actualiza el lazo con el llenado
+// que queda. Un TargetFill que ya no cabe en el anillo (tras redimensionarlo)
+// se sustituye por la mitad de su capacidad. Devuelve los frames entregados.
+ULONG DriftControlReadRing(
+    _Inout_ PDRIFT_CONTROL DriftControl,
+    _Inout_ PRING_BUFFER Ring,
+    _Out_ PVOID Output,
+    _In_ ULONG Frames
+);
+
+VOID DriftControlGetStats(
+    _In_ const DRIFT_CONTROL *DriftControl,
+    _Out_ PDRIFT_CONTROL_STATS Stats
+);
+
+#endif // DRIFT_CONTROL_H
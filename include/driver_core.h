@@ -2,6 +2,31 @@
 #define DRIVER_CORE_H
 
 #include "virtual_mic.h"
+#include "ring_buffer.h"
+#include "mirror_buffer.h"
+#include "shared_ring.h"
+#include "read_queue.h"
+#include "watermark.h"
+#include "sample_convert.h"
+#include "resampler.h"
+#include "channel_mix.h"
+#include "gain_ramp.h"
+#include "jitter_buffer.h"
+#include "drift_control.h"
+#include "level_meter.h"
+#include "dsp_chain.h"
+#include "stat_counters.h"
+#include "latency_histogram.h"
+#include "trace_ring.h"
+#include "ioctl_dispatch.h"
+
+// Cola de IRP pendientes con cancelación segura (src/driver/pending_irp_queue.c).
+// El umbral de cada IRP se evalúa con READ_QUEUE; la entrada vive en el IRP.
+typedef struct _PENDING_IRP_QUEUE {
+    IO_CSQ Csq;
+    KSPIN_LOCK Lock;
+    READ_QUEUE Queue; // Protegida por Lock
+} PENDING_IRP_QUEUE, *PPENDING_IRP_QUEUE;
 
 // Estructura de extensión del dispositivo
 typedef struct _DEVICE_EXTENSION {
@@ -10,12 +35,122 @@ typedef struct _DEVICE_EXTENSION {
     UNICODE_STRING SymbolicLinkName;
     BOOLEAN IsInitialized;
     PVOID AudioBuffer;
-    KSPIN_LOCK BufferLock;
     ULONG BufferSize;
-    ULONG WritePosition;
-    ULONG ReadPosition;
+    RING_BUFFER Ring;
+    BOOLEAN MirroredBuffer;  // Buffer mapeado dos veces (ver mirror_buffer.h)
+    BOOLEAN MirrorPreferred; // Se pide espejo en cada reserva que cubra su granularidad
+    MIRROR_BUFFER Mirror;
+    KSPIN_LOCK ProducerLock; // Serializa escritores concurrentes (el anillo es SPSC)
+    KSPIN_LOCK ConsumerLock; // Serializa lectores concurrentes
+    
+    // Formato del anillo y conversión desde el formato de entrada del
+    // productor. Cambian junto con el anillo, con ambos locks tomados.
+    AUDIO_FORMAT Format;
+    // Mezcla de canales -> conversor de frecuencia -> anillo: las etapas que
+    // no hacen falta quedan a NULL. InputConverter describe siempre la entrada
+    // (SourceFormat, Channels y SourceFrameSize) y, sin más etapas, convierte.
+    SAMPLE_CONVERTER InputConverter;
+    PCHANNEL_MIX ChannelMix;         // NULL si el productor envía los canales del dispositivo
+    PRESAMPLER Resampler;            // NULL si el productor usa la frecuencia del dispositivo
+    
+    // Jitter buffer por Timestamp delante de las etapas (SET_JITTER_BUFFER), en
+    // frames de entrada. Como las etapas, solo se toca con ProducerLock tomado;
+    // JitterConfig (sin FrameSize) cambia con SharedRingMutex tomado.
+    PJITTER_BUFFER JitterBuffer;     // NULL: los paquetes entran en orden de llegada
+    JITTER_BUFFER_CONFIG JitterConfig;
+    
+    // Medidores de lo que se escribe en el anillo (IOCTL_VIRTUALMIC_METERING):
+    // solo se tocan con ProducerLock tomado. Siguen el formato del anillo.
+    LEVEL_METER LevelMeter;
+    BOOLEAN MeteringEnabled;
+    
+    // Compensación de deriva en la lectura (SET_DRIFT_CONTROL): como la
+    // ganancia, solo se toca con ConsumerLock tomado. DriftConfig cambia con
+    // SharedRingMutex tomado y conserva los valores pedidos (0 = por defecto).
+    PDRIFT_CONTROL DriftControl;     // NULL: el anillo se lee tal cual
+    SET_DRIFT_CONTROL_REQUEST DriftConfig;
+    
+    // Cadena de procesado tras la ganancia (SET_DSP_CHAIN): solo se toca con
+    // ConsumerLock tomado y sigue el formato del anillo. DspConfig cambia con
+    // SharedRingMutex tomado.
+    PDSP_CHAIN DspChain;             // NULL: sin procesado
+    SET_DSP_CHAIN_REQUEST DspConfig;
+    
+    // Ganancia y silencio de salida: se aplican al leer, con ConsumerLock tomado.
+    // OutputGain va hacia Muted ? 0 : Gain con rampas de GainRampFrames frames.
+    GAIN_RAMP OutputGain;
+    float Gain;
+    ULONG GainRampFrames;
+    BOOLEAN Muted;
+    
+    // Política ante buffer lleno
+    ULONG OverflowPolicy;
+    ULONG BlockTimeoutMs;
+    FAST_MUTEX BlockingWriteMutex; // Mantiene contiguo el paquete de un escritor bloqueado
+    KEVENT SpaceAvailableEvent;
+    volatile LONG WritersWaiting;
+    
+    // Contadores de GET_STATS: una ranura por procesador (StatsMemory, reserva
+    // propia) para no añadir contención a lectores ni escritores
+    STAT_COUNTERS Stats;
+    PVOID StatsMemory;
+    ULONG64 StartTimeMs;           // GetSystemUptimeMs en InitializeDevice
+    
+    // Latencia del anillo interno (GET_LATENCY): las marcas de llegada se
+    // ponen con ProducerLock; el histograma, en microsegundos, se llena y se
+    // vacía con ConsumerLock
+    LATENCY_TAGS LatencyTags;
+    LATENCY_HISTOGRAM Latency;
+    
+    // Traza binaria (DRAIN_TRACE): se escribe sin locks desde cualquier
+    // camino; TraceMutex serializa los vaciados. TraceMemory es reserva propia.
+    TRACE_RING Trace;
+    PVOID TraceMemory;
+    FAST_MUTEX TraceMutex;
+    
+    // Despacho de IOCTL con contadores por código (GET_IOCTL_STATS): la tabla
+    // la pone DriverEntry; los contadores se suman sin locks
+    IOCTL_DISPATCHER Dispatcher;
+    
+    // Anillo compartido con el proceso productor (IOCTL_VIRTUALMIC_MAP_RING)
+    BOOLEAN SharedRingActive;      // Protegido por ConsumerLock
+    SHARED_RING_VIEW SharedRing;   // Extremo consumidor
+    PKEVENT SharedRingEvent;       // Timbre del productor (opcional)
+    FAST_MUTEX SharedRingMutex;    // Serializa mapeo y desmapeo
+    PMDL SharedRingMdl;
+    PVOID SharedRingSystemAddress;
+    PVOID SharedRingUserAddress;
+    PEPROCESS SharedRingProcess;
+    PFILE_OBJECT SharedRingOwner;
+    
+    // Lecturas pendientes (src/driver/pending_reads.c)
+    PENDING_IRP_QUEUE PendingReads;
+    volatile LONG ReadServiceRequests;
+    
+    // Envíos pendientes con OVERFLOW_POLICY_PEND (src/driver/pending_writes.c)
+    PENDING_IRP_QUEUE PendingWrites;
+    
+    // Avisos de nivel de llenado (src/driver/watermarks.c)
+    WATERMARK_STATE Watermarks;
+    PKEVENT WatermarkEvent;        // Protegido por WatermarkLock
+    PFILE_OBJECT WatermarkOwner;
+    KSPIN_LOCK WatermarkLock;
 } DEVICE_EXTENSION, *PDEVICE_EXTENSION;
 
+// Evento de la traza binaria con la hora actual; con VMIC_TRACE=0 no se
+// compila (los argumentos tampoco se evalúan)
+#ifndef VMIC_TRACE
+#define VMIC_TRACE 1
+#endif
+
+#if VMIC_TRACE
+#define TRACE_LOG(DeviceExtension, Event, Arg0, Arg1, Arg2) \
+    TraceRingWrite(&(DeviceExtension)->Trace, (Event), KeQueryInterruptTime(), \
+                   (ULONG)(Arg0), (ULONG)(Arg1), (ULONG)(Arg2))
+#else
+#define TRACE_LOG(DeviceExtension, Event, Arg0, Arg1, Arg2) ((void)0)
+#endif
+
 // Variables globales del driver
 extern UNICODE_STRING g_DeviceName;
 extern UNICODE_STRING g_SymbolicLinkName;
@@ -30,6 +165,13 @@ VOID CleanupDevice(
     _In_ PDEVICE_OBJECT DeviceObject
 );
 
+// Vacía la traza en Header y los MaxRecords registros que le siguen (PASSIVE_LEVEL)
+VOID DrainTrace(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _Out_ PTRACE_DRAIN_HEADER Header,
+    _In_ ULONG MaxRecords
+);
+
 NTSTATUS AllocateAudioBuffer(
     _In_ PDEVICE_EXTENSION DeviceExtension
 );
@@ -38,4 +180,159 @@ VOID FreeAudioBuffer(
     _In_ PDEVICE_EXTENSION DeviceExtension
 );
 
+NTSTATUS ResizeAudioBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG NewCapacity
+);
+
+// Sustituye el anillo por uno vacío con el BlockAlign de Format (misma
+// capacidad en frames) y publica a la vez formato y etapas. Si tiene éxito se
+// queda con ChannelMix, Resampler, JitterBuffer, DriftControl y DspChain y
+// libera los anteriores; si falla, siguen siendo del llamador. Los medidores de nivel
+// empiezan una ventana vacía en el formato nuevo.
+NTSTATUS ReformatAudioBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const AUDIO_FORMAT *Format,
+    _In_ const SAMPLE_CONVERTER *InputConverter,
+    _In_opt_ PCHANNEL_MIX ChannelMix,
+    _In_opt_ PRESAMPLER Resampler,
+    _In_opt_ PJITTER_BUFFER JitterBuffer,
+    _In_opt_ PDRIFT_CONTROL DriftControl,
+    _In_opt_ PDSP_CHAIN DspChain
+);
+
+VOID FreeResampler(
+    _In_opt_ PRESAMPLER Resampler
+);
+
+VOID FreeChannelMix(
+    _In_opt_ PCHANNEL_MIX ChannelMix
+);
+
+VOID FreeJitterBuffer(
+    _In_opt_ PJITTER_BUFFER JitterBuffer
+);
+
+VOID FreeDriftControl(
+    _In_opt_ PDRIFT_CONTROL DriftControl
+);
+
+VOID FreeDspChain(
+    _In_opt_ PDSP_CHAIN DspChain
+);
+
+// Anillo compartido (src/driver/shared_ring_mapping.c). Se llaman a
+// PASSIVE_LEVEL; MapSharedRing en el contexto del proceso productor.
+NTSTATUS MapSharedRing(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PFILE_OBJECT FileObject,
+    _In_ ULONG Capacity,
+    _In_opt_ HANDLE NotificationEvent,
+    _Out_ PMAP_RING_RESPONSE Response
+);
+
+// FileObject NULL fuerza el desmapeo (descarga del driver)
+NTSTATUS UnmapSharedRing(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+);
+
+// Cola de IRP pendientes (src/driver/pending_irp_queue.c)
+NTSTATUS PendingIrpQueueInitialize(
+    _Out_ PPENDING_IRP_QUEUE Pending,
+    _In_ ULONG MinFillFrames
+);
+
+// Marca el IRP como pendiente; Frames es el tamaño usado para el umbral
+VOID PendingIrpQueueInsert(
+    _Inout_ PPENDING_IRP_QUEUE Pending,
+    _In_ PIRP Irp,
+    _In_ ULONG Frames
+);
+
+// Extrae la cabeza si ya alcanza su umbral con AvailableFrames
+PIRP PendingIrpQueueRemoveReady(
+    _Inout_ PPENDING_IRP_QUEUE Pending,
+    _In_ ULONG AvailableFrames
+);
+
+// Completa con STATUS_CANCELLED los IRP de FileObject (NULL = todos)
+VOID PendingIrpQueueFlush(
+    _Inout_ PPENDING_IRP_QUEUE Pending,
+    _In_opt_ PFILE_OBJECT FileObject
+);
+
+// Lecturas asíncronas (src/driver/pending_reads.c)
+NTSTATUS InitializePendingReads(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
+// Completa el IRP_MJ_READ o lo deja pendiente (devuelve STATUS_PENDING)
+NTSTATUS QueueOrCompleteRead(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PIRP Irp
+);
+
+// Lo llama el camino de escritura tras publicar frames
+VOID ServicePendingReads(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
+// Cancela las lecturas pendientes de FileObject (NULL = todas)
+VOID FlushPendingReads(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+);
+
+// Envíos con contrapresión (src/driver/pending_writes.c)
+NTSTATUS InitializePendingWrites(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
+// Escribe el paquete completo o deja pendiente el IRP (devuelve STATUS_PENDING)
+NTSTATUS QueueOrCompleteWrite(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PIRP Irp,
+    _In_ const VOID *AudioData,
+    _In_ ULONG DataLength
+);
+
+// Lo llama el camino de lectura tras liberar espacio
+VOID ServicePendingWrites(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
+// Cancela los envíos pendientes de FileObject (NULL = todos)
+VOID FlushPendingWrites(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+);
+
+// Avisos de nivel de llenado (src/driver/watermarks.c). Register a
+// PASSIVE_LEVEL en el contexto del proceso; NotificationEvent NULL anula.
+NTSTATUS RegisterWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PFILE_OBJECT FileObject,
+    _In_ ULONG LowWaterFrames,
+    _In_ ULONG HighWaterFrames,
+    _In_ HANDLE NotificationEvent
+);
+
+// FileObject NULL anula cualquier registro (descarga del driver)
+NTSTATUS UnregisterWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+);
+
+// Lo llaman lectores y escritores tras mover el anillo
+VOID SignalWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
+// Tras cambiar la capacidad del anillo (Resize/ReformatAudioBuffer): recorta
+// los umbrales a la capacidad nueva y vuelve a anunciar la zona actual
+VOID RefreshWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+);
+
 #endif // DRIVER_CORE_H
\ No newline at end of file
@@ -0,0 +1,184 @@
+#ifndef DSP_CHAIN_H
+#define DSP_CHAIN_H
+
+#include "portable.h"
+#include "sample_convert.h"
+
+// Cadena de etapas de procesado (ecualizador, compresor, limitador) sobre lo
+// que se lee, en el formato del dispositivo y en el sitio. Se trabaja por
+// bloques de DSP_CHAIN_BLOCK_FRAMES frames en float: cada bloque se decodifica
+// (en float32 se usa el propio buffer), pasa por todas las etapas y se vuelve
+// a codificar, así que el bloque y los estados de las etapas siguen en L1 de
+// una etapa a la siguiente y el coste por llamada de cada etapa se reparte
+// entre todo el bloque.
+//
+// Etapas:
+//   EQ          biquads en cascada (fórmulas del Audio EQ Cookbook de RBJ),
+//               forma directa II traspuesta, el mismo filtro en todos los canales
+//   COMPRESSOR  compresor con los canales enlazados: nivel de pico por frame,
+//               curva estática en dB con rodilla suave y suavizado de la
+//               reducción con ataque y relajación
+//   LIMITER     limitador de pico con anticipación: ninguna muestra supera el
+//               techo. Retrasa la señal LookaheadMs
+//
+// Toda la memoria (estados, líneas de retardo, bloque de trabajo) se reserva
+// al crear la cadena: procesar no reserva nada ni usa la CRT. Las variantes
+// SSE2 dan resultados idénticos bit a bit a la escalar.
+
+#define DSP_CHAIN_MAX_STAGES    8
+#define DSP_CHAIN_MAX_CHANNELS  8
+#define DSP_CHAIN_BLOCK_FRAMES  64      // 2 KB en float con 8 canales
+
+#define DSP_EQ_MAX_BANDS        8
+#define DSP_EQ_MIN_Q            0.1f
+#define DSP_EQ_MAX_Q            40.0f
+#define DSP_EQ_MAX_GAIN_DB      24.0f
+
+#define DSP_COMPRESSOR_MIN_THRESHOLD_DB (-60.0f)
+#define DSP_COMPRESSOR_MAX_RATIO        100.0f
+#define DSP_COMPRESSOR_MAX_KNEE_DB      24.0f
+#define DSP_COMPRESSOR_MAX_MAKEUP_DB    24.0f
+
+#define DSP_LIMITER_MIN_CEILING_DB      (-24.0f)
+#define DSP_LIMITER_MIN_LOOKAHEAD_MS    0.1f
+#define DSP_LIMITER_MAX_LOOKAHEAD_MS    20.0f
+
+#define DSP_MIN_ATTACK_MS       0.01f
+#define DSP_MAX_ATTACK_MS       500.0f
+#define DSP_MIN_RELEASE_MS      1.0f
+#define DSP_MAX_RELEASE_MS      5000.0f
+
+typedef enum _DSP_STAGE_TYPE {
+    DSP_STAGE_EQ = 0,
+    DSP_STAGE_COMPRESSOR,
+    DSP_STAGE_LIMITER,
+    DSP_STAGE_TYPE_COUNT
+} DSP_STAGE_TYPE;
+
+// Forma de cada banda del ecualizador
+typedef enum _DSP_EQ_SHAPE {
+    DSP_EQ_PEAKING = 0,
+    DSP_EQ_LOW_SHELF,
+    DSP_EQ_HIGH_SHELF,
+    DSP_EQ_LOW_PASS,
+    DSP_EQ_HIGH_PASS,
+    DSP_EQ_BAND_PASS,     // Ganancia 1 en Frequency
+    DSP_EQ_NOTCH,
+    DSP_EQ_SHAPE_COUNT
+} DSP_EQ_SHAPE;
+
+typedef struct _DSP_EQ_BAND {
+    ULONG Shape;          // DSP_EQ_*
+    float Frequency;      // Hz, por debajo de la mitad de la frecuencia de muestreo
+    float Q;              // DSP_EQ_MIN_Q..DSP_EQ_MAX_Q (también la pendiente de los shelf)
+    float GainDb;         // Solo PEAKING y shelf: ±DSP_EQ_MAX_GAIN_DB
+} DSP_EQ_BAND, *PDSP_EQ_BAND;
+
+// Una etapa: cada tipo usa solo sus campos (los demás se ignoran)
+typedef struct _DSP_STAGE_CONFIG {
+    ULONG Type;           // DSP_STAGE_*
+    ULONG Bands;          // EQ: bandas usadas de Band (1..DSP_EQ_MAX_BANDS)
+    DSP_EQ_BAND Band[DSP_EQ_MAX_BANDS];
+    float ThresholdDb;    // COMPRESSOR: DSP_COMPRESSOR_MIN_THRESHOLD_DB..0
+    float Ratio;          // COMPRESSOR: 1..DSP_COMPRESSOR_MAX_RATIO
+    float KneeDb;         // COMPRESSOR: anchura de la rodilla, 0 = dura
+    float MakeupDb;       // COMPRESSOR: ganancia tras comprimir
+    float CeilingDb;      // LIMITER: DSP_LIMITER_MIN_CEILING_DB..0
+    float LookaheadMs;    // LIMITER: anticipación (y retardo)
+    float AttackMs;       // COMPRESSOR
+    float ReleaseMs;      // COMPRESSOR y LIMITER
+} DSP_STAGE_CONFIG, *PDSP_STAGE_CONFIG;
+
+// Entrada de IOCTL_VIRTUALMIC_SET_DSP_CHAIN (Mode: DSP_CHAIN_MODE_* de
+// virtual_mic.h). Las etapas se aplican en orden.
+typedef struct _SET_DSP_CHAIN_REQUEST {
+    ULONG Mode;
+    ULONG Stages;         // 1..DSP_CHAIN_MAX_STAGES con ENABLE
+    DSP_STAGE_CONFIG Stage[DSP_CHAIN_MAX_STAGES];
+} SET_DSP_CHAIN_REQUEST, *PSET_DSP_CHAIN_REQUEST;
+
+// Estado de la cadena (también se devuelve por IOCTL)
+typedef struct _DSP_CHAIN_STATS {
+    ULONG64 FramesProcessed;
+    ULONG LatencyFrames;  // Retardo total (anticipación de los limitadores)
+    ULONG Stages;
+    float GainReductionDb[DSP_CHAIN_MAX_STAGES]; // Actual, >= 0 (0 en EQ)
+} DSP_CHAIN_STATS, *PDSP_CHAIN_STATS;
+
+typedef struct _DSP_CHAIN_CONFIG {
+    ULONG SampleRate;
+    ULONG Channels;
+    SAMPLE_FORMAT Format;         // El de los datos que se procesan
+    SAMPLE_CONVERT_ISA Isa;       // SCALAR fuerza la referencia; el resto usa SSE2
+    ULONG Stages;
+    DSP_STAGE_CONFIG Stage[DSP_CHAIN_MAX_STAGES];
+} DSP_CHAIN_CONFIG, *PDSP_CHAIN_CONFIG;
+
+// Procesa Frames (<= DSP_CHAIN_BLOCK_FRAMES) frames intercalados en el sitio
+typedef VOID (*DSP_STAGE_ROUTINE)(
+    _Inout_ PVOID Context,
+    _Inout_ float *Block,
+    _In_ ULONG Frames
+);
+
+typedef struct _DSP_STAGE {
+    DSP_STAGE_TYPE Type;
+    DSP_STAGE_ROUTINE Process;
+    PVOID Context;                // Estado propio del tipo, dentro de la reserva de la cadena
+} DSP_STAGE, *PDSP_STAGE;
+
+typedef struct _DSP_CHAIN {
+    DSP_CHAIN_CONFIG Config;
+    ULONG FrameSize;              // Bytes por frame de los datos
+    ULONG LatencyFrames;
+    DSP_STAGE Stage[DSP_CHAIN_MAX_STAGES];
+    float *Block;                 // DSP_CHAIN_BLOCK_FRAMES frames (sin usar en float32)
+    SAMPLE_CONVERTER Decoder;     // Format -> float32
+    SAMPLE_CONVERTER Encoder;     // float32 -> Format
+    BOOLEAN Idle;                 // Sin nada procesado desde el último reinicio
+    ULONG64 FramesProcessed;
+} DSP_CHAIN, *PDSP_CHAIN;
+
+// Rangos de una etapa que no dependen del formato
+BOOLEAN DspStageIsValidConfig(
+    _In_ const DSP_STAGE_CONFIG *Stage
+);
+
+BOOLEAN DspChainIsValidConfig(
+    _In_ const DSP_CHAIN_CONFIG *Config
+);
+
+// Bytes necesarios para Config (0 si no es válida)
+SIZE_T DspChainGetRequiredSize(
+    _In_ const DSP_CHAIN_CONFIG *Config
+);
+
+// Diseña las etapas (PASSIVE_LEVEL). La DSP_CHAIN vive al principio de Memory
+// (se libera junto con ella)
+NTSTATUS DspChainInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const DSP_CHAIN_CONFIG *Config,
+    _Out_ PDSP_CHAIN *Chain
+);
+
+// Vuelve al silencio (estados, envolventes y líneas de retardo); conserva los
+// contadores. Sin nada procesado desde el último reinicio no hace nada.
+VOID DspChainReset(
+    _Inout_ PDSP_CHAIN Chain
+);
+
+// Procesa Frames frames intercalados en el sitio. El llamador serializa las
+// llamadas.
+VOID DspChainProcess(
+    _Inout_ PDSP_CHAIN Chain,
+    _Inout_ PVOID Data,
+    _In_ ULONG Frames
+);
+
+VOID DspChainGetStats(
+    _In_ const DSP_CHAIN *Chain,
+    _Out_ PDSP_CHAIN_STATS Stats
+);
+
+#endif // DSP_CHAIN_H
@@ -0,0 +1,58 @@
+#ifndef DSP_STAGES_H
+#define DSP_STAGES_H
+
+#include "dsp_chain.h"
+
+// Interfaz interna entre la cadena (dsp_chain.c) y los tipos de etapa
+// (dsp_eq.c, dsp_dynamics.c). Cada tipo se describe con una tabla de
+// operaciones: la cadena reserva Context con el tamaño que pide el tipo y solo
+// llama a Process por bloque; el resto se usa al crearla, al reiniciarla o al
+// consultar su estado. Isa distinto de SCALAR usa los núcleos SSE2.
+
+typedef struct _DSP_STAGE_OPS {
+    // Bytes del contexto (0 si la etapa no vale para ese formato)
+    SIZE_T (*GetRequiredSize)(const DSP_STAGE_CONFIG *Stage, ULONG SampleRate, ULONG Channels);
+
+    // Diseña la etapa sobre Context (ya a cero) y la deja en silencio
+    VOID (*Initialize)(PVOID Context, const DSP_STAGE_CONFIG *Stage, ULONG SampleRate,
+                       ULONG Channels, SAMPLE_CONVERT_ISA Isa);
+
+    DSP_STAGE_ROUTINE Process;
+    VOID (*Reset)(PVOID Context);
+    ULONG (*GetLatency)(const VOID *Context);
+    float (*GetGainReduction)(const VOID *Context);   // dB >= 0
+} DSP_STAGE_OPS;
+
+extern const DSP_STAGE_OPS DspEqOps;
+extern const DSP_STAGE_OPS DspCompressorOps;
+extern const DSP_STAGE_OPS DspLimiterOps;
+
+// Cálculo en double sin la CRT para diseñar las etapas (dsp_chain.c)
+double DspSinPi(
+    _In_ double X
+);
+
+double DspCosPi(
+    _In_ double X
+);
+
+// 2^X con |X| < 1000
+double DspExp2(
+    _In_ double X
+);
+
+// 10^(Db / 20)
+double DspDbToGain(
+    _In_ double Db
+);
+
+// Coeficiente por frame de un filtro exponencial de constante Ms a SampleRate
+// (la distancia al objetivo cae a 1/e en Ms milisegundos)
+float DspSmoothingCoefficient(
+    _In_ float Ms,
+    _In_ ULONG SampleRate
+);
+
+#define DSP_CONTEXT_ALIGN(size) (((size) + VMIC_CACHE_LINE - 1) & ~(SIZE_T)(VMIC_CACHE_LINE - 1))
+
+#endif // DSP_STAGES_H
@@ -0,0 +1,80 @@
+#ifndef FUSED_WRITE_H
+#define FUSED_WRITE_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+#include "sample_convert.h"
+#include "channel_mix.h"
+#include "level_meter.h"
+
+// Escritura fusionada en el anillo: conversión de formato, mezcla de canales
+// y medidores en una sola pasada sobre los datos del productor. Cada grupo de
+// 8 muestras de salida se decodifica, se mezcla, se codifica en el anillo y
+// se mide sin salir de los registros, en lugar de recorrer el paquete una vez
+// por etapa (bloque de float de la mezcla y relectura del anillo para medir).
+//
+// La especialización se elige con la configuración activa: forma de la mezcla
+// (sin mezcla, 1->2, 2->1, 6->2, 8->2), formatos de origen y destino (int16,
+// int32, float32) y medidores sí/no. Lo que no tiene especialización (int24,
+// otras formas, conversor de frecuencia, CPU sin SSE2) devuelve FALSE en
+// FusedWriteSelect y sigue por el camino por etapas. Las ganancias de la
+// escritura son las de la matriz de mezcla; la ganancia de salida se aplica
+// en la lectura, donde está su rampa.
+//
+// El resultado es idéntico bit a bit al camino por etapas: mismos valores en
+// el anillo y mismo estado del medidor (que debe usar SSE2). Como en
+// channel_mix.c, SSE2 no necesita guardar estado extendido en el kernel.
+
+typedef enum _FUSED_WRITE_SHAPE {
+    FUSED_WRITE_SHAPE_COPY = 0,          // Sin mezcla: solo conversión (y medidores)
+    FUSED_WRITE_SHAPE_MONO_TO_STEREO,
+    FUSED_WRITE_SHAPE_STEREO_TO_MONO,
+    FUSED_WRITE_SHAPE_SURROUND51_TO_STEREO,
+    FUSED_WRITE_SHAPE_SURROUND71_TO_STEREO,
+    FUSED_WRITE_SHAPE_COUNT
+} FUSED_WRITE_SHAPE;
+
+// Procesa Groups grupos de 8 muestras de salida. Con medidores acumula en
+// Meter los picos, sumas y saturadas del tramo, pero no cuenta sus frames.
+typedef VOID (*FUSED_WRITE_ROUTINE)(
+    _In_ const CHANNEL_MIX *Mix,
+    _Inout_opt_ PLEVEL_METER Meter,
+    _Out_ PUCHAR Target,
+    _In_ const UCHAR *Source,
+    _In_ SIZE_T Groups
+);
+
+typedef struct _FUSED_WRITE {
+    FUSED_WRITE_SHAPE Shape;
+    FUSED_WRITE_ROUTINE Routine;
+    const SAMPLE_CONVERTER *Converter;   // Sin mezcla
+    PCHANNEL_MIX Mix;                    // Con mezcla (Decoder y Encoder dan los formatos)
+    PLEVEL_METER Meter;                  // NULL sin medidores
+    SAMPLE_FORMAT TargetFormat;
+    ULONG SourceFrameSize;
+    ULONG TargetFrameSize;
+    ULONG GroupFrames;                   // Frames de salida por grupo de 8 muestras
+} FUSED_WRITE, *PFUSED_WRITE;
+
+// Elige la especialización de la configuración activa. Converter es el de la
+// escritura sin mezcla; con Mix se usan sus conversores. Isa SCALAR (o una CPU
+// sin SSE2) no fusiona. Devuelve FALSE si no hay especialización.
+BOOLEAN FusedWriteSelect(
+    _Out_ PFUSED_WRITE Fused,
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _In_opt_ PCHANNEL_MIX Mix,
+    _In_opt_ PLEVEL_METER Meter,
+    _In_ SAMPLE_CONVERT_ISA Isa
+);
+
+// Igual que SampleConvertWriteRing / ChannelMixWriteRing seguidos de
+// LevelMeterProcessRing sobre lo escrito. Devuelve frames escritos (que son
+// también los de entrada consumidos).
+ULONG FusedWriteRing(
+    _In_ const FUSED_WRITE *Fused,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+);
+
+#endif // FUSED_WRITE_H
@@ -0,0 +1,75 @@
+#ifndef GAIN_RAMP_H
+#define GAIN_RAMP_H
+
+#include "portable.h"
+#include "sample_convert.h"
+
+// Ganancia de salida con rampas lineales: cada cambio (silencio incluido) va
+// de la ganancia actual a la nueva en Frames frames, con la ganancia del frame
+// n de la rampa = Start + Step * n (n = 1..Frames), así que no hay saltos que
+// se oigan como clics. Se aplica en el formato del dispositivo sobre el buffer
+// ya leído del anillo: en enteros se redondea al par más cercano y se satura.
+// int32 se multiplica en double para no perder los bits bajos.
+//
+// Fuera de las rampas la ganancia es estable: 1 no toca las muestras, 0 permite
+// al lector no leer el anillo y la multiplicación constante es vectorial. Las
+// rampas son vectoriales con 1, 2, 4 u 8 canales; int24 empaquetado usa
+// siempre el escalar. Todas las variantes dan resultados idénticos bit a bit.
+
+#define GAIN_RAMP_MAX_GAIN   16.0f   // +24 dB
+#define GAIN_RAMP_MAX_FRAMES 192000  // 1 s a 192 kHz
+
+typedef struct _GAIN_RAMP {
+    float Start;      // Ganancia anterior al primer frame de la rampa
+    float Target;
+    float Step;       // Incremento por frame
+    ULONG Position;   // Frames de la rampa ya aplicados
+    ULONG Length;     // 0 = ganancia estable en Target
+    SAMPLE_CONVERT_ISA Isa;
+} GAIN_RAMP, *PGAIN_RAMP;
+
+// Gain en [0, GAIN_RAMP_MAX_GAIN]. Isa SCALAR fuerza la referencia; el resto
+// usa SSE2. STATUS_NOT_SUPPORTED si se fuerza una variante que la CPU no tiene.
+NTSTATUS GainRampInitialize(
+    _Out_ PGAIN_RAMP Ramp,
+    _In_ float Gain,
+    _In_ SAMPLE_CONVERT_ISA Isa
+);
+
+BOOLEAN GainRampIsValidGain(
+    _In_ float Gain
+);
+
+// Ganancia del último frame procesado
+float GainRampGetCurrent(
+    _In_ const GAIN_RAMP *Ramp
+);
+
+// Empieza una rampa desde la ganancia actual (también a mitad de otra).
+// Frames 0 cambia de golpe.
+VOID GainRampSetTarget(
+    _Inout_ PGAIN_RAMP Ramp,
+    _In_ float Target,
+    _In_ ULONG Frames
+);
+
+// Silencio estable: la salida es cero sin mirar la entrada
+BOOLEAN GainRampIsSilent(
+    _In_ const GAIN_RAMP *Ramp
+);
+
+// Ganancia estable 1: GainRampApply no haría nada
+BOOLEAN GainRampIsUnity(
+    _In_ const GAIN_RAMP *Ramp
+);
+
+// Aplica la ganancia en el sitio a Frames frames intercalados y avanza la rampa
+VOID GainRampApply(
+    _Inout_ PGAIN_RAMP Ramp,
+    _In_ SAMPLE_FORMAT Format,
+    _In_ ULONG Channels,
+    _Inout_ PVOID Data,
+    _In_ ULONG Frames
+);
+
+#endif // GAIN_RAMP_H
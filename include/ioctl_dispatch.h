@@ -0,0 +1,128 @@
+#ifndef IOCTL_DISPATCH_H
+#define IOCTL_DISPATCH_H
+
+#include "portable.h"
+
+// Despacho de IOCTL por tabla con contabilidad por código: llamadas, errores,
+// pendientes, bytes de entrada y de salida y tiempo del handler (total y
+// máximo). El driver da la tabla código -> handler; el despachador la indexa
+// por la función del CTL_CODE (0x800-0x81F), así que buscar el handler es un
+// acceso a tabla y una comparación del código completo.
+//
+// Los contadores de cada código ocupan su propia línea de caché y se suman
+// con atómicas sin barrera: solo comparten línea las llamadas concurrentes a
+// un mismo código. La lectura no es una instantánea.
+//
+// Solo maneja punteros a DEVICE_OBJECT e IRP: compila en modo usuario con IRP
+// falsos (benchmarks/bench_ioctl_dispatch.c).
+
+struct _DEVICE_OBJECT;
+struct _IRP;
+
+typedef NTSTATUS (*PIOCTL_HANDLER)(
+    _In_ struct _DEVICE_OBJECT *DeviceObject,
+    _In_ struct _IRP *Irp
+);
+
+#define IOCTL_DISPATCH_FIRST_FUNCTION 0x800
+#define IOCTL_DISPATCH_MAX_ENTRIES    32
+
+// Función del CTL_CODE (bits 2-13)
+#define IOCTL_DISPATCH_FUNCTION(code) (((code) >> 2) & 0xFFF)
+
+typedef struct _IOCTL_DISPATCH_ENTRY {
+    ULONG IoControlCode;
+    PIOCTL_HANDLER Handler;
+} IOCTL_DISPATCH_ENTRY, *PIOCTL_DISPATCH_ENTRY;
+
+typedef struct _IOCTL_COUNTERS {
+    volatile ULONG64 Calls;
+    volatile ULONG64 Errors;       // NTSTATUS de error
+    volatile ULONG64 Pending;      // STATUS_PENDING: las completa otro camino
+    volatile ULONG64 BytesIn;      // Longitud del buffer de entrada
+    volatile ULONG64 BytesOut;     // Information de las terminadas con STATUS_SUCCESS
+    volatile ULONG64 TotalTicks;   // Tiempo dentro del handler (VmicQueryPerformanceCounter)
+    volatile ULONG64 MaxTicks;
+    UCHAR Pad[VMIC_CACHE_LINE - 7 * sizeof(ULONG64)];
+} IOCTL_COUNTERS, *PIOCTL_COUNTERS;
+
+typedef struct _IOCTL_DISPATCHER {
+    const IOCTL_DISPATCH_ENTRY *Entries;
+    ULONG EntryCount;
+    UCHAR Index[IOCTL_DISPATCH_MAX_ENTRIES]; // Función - 0x800 -> entrada + 1 (0 = sin handler)
+    volatile ULONG64 UnknownCalls;
+    IOCTL_COUNTERS Counters[IOCTL_DISPATCH_MAX_ENTRIES]; // Uno por entrada
+} IOCTL_DISPATCHER, *PIOCTL_DISPATCHER;
+
+// Salida de IOCTL_VIRTUALMIC_GET_IOCTL_STATS: la cabecera y después Entries
+// IOCTL_CALL_STATS en el orden de la tabla. Los contadores son acumulados.
+typedef struct _IOCTL_STATS_HEADER {
+    ULONG Entries;
+    ULONG Reserved;
+    ULONG64 UnknownCalls;          // Códigos sin handler
+} IOCTL_STATS_HEADER, *PIOCTL_STATS_HEADER;
+
+typedef struct _IOCTL_CALL_STATS {
+    ULONG IoControlCode;
+    ULONG Reserved;
+    ULONG64 Calls;
+    ULONG64 Errors;
+    ULONG64 Pending;
+    ULONG64 BytesIn;
+    ULONG64 BytesOut;
+    ULONG64 TotalTimeNs;
+    ULONG64 MaxTimeNs;
+} IOCTL_CALL_STATS, *PIOCTL_CALL_STATS;
+
+// Entries debe sobrevivir al despachador. STATUS_INVALID_PARAMETER si hay más
+// de IOCTL_DISPATCH_MAX_ENTRIES entradas, una función fuera de rango o
+// repetida, o un handler NULL.
+NTSTATUS IoctlDispatcherInitialize(
+    _Out_ PIOCTL_DISPATCHER Dispatcher,
+    _In_ const IOCTL_DISPATCH_ENTRY *Entries,
+    _In_ ULONG EntryCount
+);
+
+// Entrada de IoControlCode; NULL (y cuenta la llamada como desconocida) si
+// no hay handler para el código exacto
+static inline const IOCTL_DISPATCH_ENTRY *IoctlDispatcherLookup(
+    _Inout_ PIOCTL_DISPATCHER Dispatcher,
+    _In_ ULONG IoControlCode
+)
+{
+    ULONG slot = IOCTL_DISPATCH_FUNCTION(IoControlCode) - IOCTL_DISPATCH_FIRST_FUNCTION;
+    const IOCTL_DISPATCH_ENTRY *entry;
+
+    if (slot < IOCTL_DISPATCH_MAX_ENTRIES && Dispatcher->Index[slot] != 0) {
+        entry = &Dispatcher->Entries[Dispatcher->Index[slot] - 1];
+        if (entry->IoControlCode == IoControlCode) {
+            return entry;
+        }
+    }
+
+    VmicInterlockedAddNoFence64(&Dispatcher->UnknownCalls, 1);
+    return NULL;
+}
+
+// Llama al handler de Entry y contabiliza la llamada. Information solo se lee
+// si el handler devuelve STATUS_SUCCESS (con STATUS_PENDING el IRP ya puede
+// estar completado). Cualquier IRQL a la que se pueda llamar al handler.
+NTSTATUS IoctlDispatcherCall(
+    _Inout_ PIOCTL_DISPATCHER Dispatcher,
+    _In_ const IOCTL_DISPATCH_ENTRY *Entry,
+    _In_ struct _DEVICE_OBJECT *DeviceObject,
+    _In_ struct _IRP *Irp,
+    _In_ ULONG InputLength,
+    _In_ const ULONG_PTR *Information
+);
+
+// Escribe la cabecera y hasta MaxEntries entradas con los tiempos en
+// nanosegundos; devuelve las entradas escritas
+ULONG IoctlDispatcherGetStats(
+    _In_ const IOCTL_DISPATCHER *Dispatcher,
+    _Out_ PIOCTL_STATS_HEADER Header,
+    _Out_writes_(MaxEntries) PIOCTL_CALL_STATS Stats,
+    _In_ ULONG MaxEntries
+);
+
+#endif // IOCTL_DISPATCH_H
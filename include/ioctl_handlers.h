@@ -10,6 +10,16 @@ NTSTATUS HandleSendAudio(
     _In_ PIRP Irp
 );
 
+NTSTATUS HandleSendAudioDirect(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSendAudioBatch(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
 NTSTATUS HandleSetFormat(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp
@@ -25,6 +35,76 @@ NTSTATUS HandleMute(
     _In_ PIRP Irp
 );
 
+NTSTATUS HandleSetBuffer(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetOverflowPolicy(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleMapRing(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleUnmapRing(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetWatermarks(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetChannelMix(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetGain(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetJitterBuffer(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetDriftControl(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleMetering(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleGetLatency(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleDrainTrace(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleGetIoctlStats(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
+NTSTATUS HandleSetDspChain(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
 // Funciones auxiliares para validación
 BOOLEAN ValidateAudioPacket(
     _In_ PVOID InputBuffer,
@@ -46,4 +126,49 @@ BOOLEAN ValidateMuteRequest(
     _In_ ULONG InputBufferLength
 );
 
+BOOLEAN ValidateGainRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateJitterBufferRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateDriftControlRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateMeteringRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateDspChainRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateBufferRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateOverflowPolicyRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateWatermarksRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
+BOOLEAN ValidateChannelMixRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+);
+
 #endif // IOCTL_HANDLERS_H
\ No newline at end of file
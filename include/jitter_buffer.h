@@ -0,0 +1,138 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include "portable.h"
+
+// Jitter buffer por marca de tiempo: los paquetes se guardan en la posición
+// que indica su Timestamp (en frames de entrada, como en RTP) y salen en orden
+// cuando vence su plazo, con silencio en los huecos que no llegaron a tiempo.
+//
+// Reloj: el llamador pasa Now en las mismas unidades que Timestamp. El
+// tránsito de un paquete es Now - Timestamp al llegar; el frame ts vence en
+// ts + Base, con Base = tránsito mínimo observado + retardo de reproducción.
+// El retardo objetivo es el percentil Percentile del tránsito relativo (sobre
+// el mínimo) de los últimos JITTER_BUFFER_HISTORY paquetes, acotado a
+// [MinDelay, MaxDelay].
+//
+// Adaptación: el retardo solo crece en un hueco vencido (se inserta silencio
+// extra antes de ocultarlo, que da más tiempo al paquete que falta) y solo se
+// reduce al volver a cebar: tras MaxDelay frames ocultados sin nada pendiente
+// el productor se da por parado y el siguiente paquete empieza con el retardo
+// objetivo del momento (los tránsitos se vuelven a medir, por si el origen de
+// las marcas de tiempo ha cambiado). Así nunca se recorta audio ya recibido.
+//
+// La memoria la reserva el llamador (JitterBufferGetRequiredSize) y las
+// llamadas se serializan fuera; el camino de datos no reserva ni usa la CRT.
+
+#define JITTER_BUFFER_HISTORY          64      // Tránsitos para el percentil
+#define JITTER_BUFFER_MAX_DELAY_FRAMES 65536   // ~1,4 s a 48 kHz
+#define JITTER_BUFFER_MAX_FRAME_SIZE   64      // 8 canales de 8 bytes
+#define JITTER_BUFFER_SILENCE_FRAMES   256     // Frames del bloque de silencio
+
+typedef enum _JITTER_BUFFER_STATE {
+    JITTER_BUFFER_STATE_IDLE = 0,   // Sin paquetes
+    JITTER_BUFFER_STATE_PRIMING,    // Esperando a que venza el primer frame
+    JITTER_BUFFER_STATE_PLAYING
+} JITTER_BUFFER_STATE;
+
+typedef struct _JITTER_BUFFER_CONFIG {
+    ULONG FrameSize;     // Bytes por frame de entrada
+    ULONG MinDelay;      // Frames
+    ULONG MaxDelay;      // Frames (<= JITTER_BUFFER_MAX_DELAY_FRAMES)
+    ULONG Percentile;    // 1..100
+} JITTER_BUFFER_CONFIG, *PJITTER_BUFFER_CONFIG;
+
+// Contadores acumulados desde la creación (también se devuelven por IOCTL)
+typedef struct _JITTER_BUFFER_STATS {
+    ULONG64 FramesReleased;    // Audio recibido entregado en orden
+    ULONG64 FramesConcealed;   // Silencio en huecos vencidos
+    ULONG64 FramesStretched;   // Silencio añadido al crecer el retardo
+    ULONG64 FramesLate;        // Llegaron con su plazo vencido: descartados
+    ULONG64 FramesOverflow;    // Fuera de la ventana: descartados
+    ULONG PacketsReordered;    // Llegaron antes que alguno anterior
+    ULONG Resyncs;             // Saltos de Timestamp que reiniciaron la ventana
+    ULONG TargetDelay;         // Retardo objetivo actual (frames)
+    ULONG PlayoutDelay;        // Retardo aplicado a la reproducción (frames)
+    ULONG State;               // JITTER_BUFFER_STATE
+    ULONG Reserved;
+} JITTER_BUFFER_STATS, *PJITTER_BUFFER_STATS;
+
+typedef struct _JITTER_BUFFER {
+    JITTER_BUFFER_CONFIG Config;
+    ULONG Capacity;              // Frames de la ventana (potencia de dos)
+    ULONG Mask;
+    PUCHAR Storage;              // Capacity frames
+    PULONG Present;              // Un bit por frame de la ventana
+    PUCHAR Silence;              // JITTER_BUFFER_SILENCE_FRAMES frames a cero
+
+    // Ventana [Next, Next + Capacity); lo recibido termina en End
+    JITTER_BUFFER_STATE State;
+    ULONG64 Next;                // Timestamp del siguiente frame a entregar
+    ULONG64 End;
+    LONG64 Base;                 // El frame ts vence en ts + Base
+    ULONG64 ConcealedRun;        // Frames ocultados seguidos
+
+    // Tránsitos recientes en orden de llegada y ordenados
+    LONG64 Transits[JITTER_BUFFER_HISTORY];
+    LONG64 Sorted[JITTER_BUFFER_HISTORY];
+    ULONG TransitCount;
+    ULONG TransitIndex;
+    ULONG TargetDelay;
+
+    ULONG RunKind;               // Tramo del último JitterBufferPeek
+    JITTER_BUFFER_STATS Stats;
+} JITTER_BUFFER, *PJITTER_BUFFER;
+
+BOOLEAN JitterBufferIsValidConfig(
+    _In_ const JITTER_BUFFER_CONFIG *Config
+);
+
+// Bytes necesarios para Config (0 si no es válida)
+SIZE_T JitterBufferGetRequiredSize(
+    _In_ const JITTER_BUFFER_CONFIG *Config
+);
+
+// El JITTER_BUFFER vive al principio de Memory (se libera junto con ella)
+NTSTATUS JitterBufferInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const JITTER_BUFFER_CONFIG *Config,
+    _Out_ PJITTER_BUFFER *JitterBuffer
+);
+
+// Vacía la ventana y vuelve a IDLE; conserva la estimación y los contadores
+VOID JitterBufferReset(
+    _Inout_ PJITTER_BUFFER JitterBuffer
+);
+
+// Guarda Frames frames que empiezan en Timestamp y llegaron en Now
+VOID JitterBufferInsert(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG64 Timestamp,
+    _In_ const VOID *Data,
+    _In_ ULONG Frames,
+    _In_ ULONG64 Now
+);
+
+// Siguiente tramo contiguo que ya puede salir en Now (audio o silencio).
+// FALSE si hay que esperar. El tramo sigue siendo del buffer hasta
+// JitterBufferConsume, que debe llamarse antes de cualquier otra operación.
+BOOLEAN JitterBufferPeek(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG64 Now,
+    _Out_ const VOID **Data,
+    _Out_ PULONG Frames
+);
+
+// Da por entregados los primeros Frames frames del último tramo
+VOID JitterBufferConsume(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG Frames
+);
+
+VOID JitterBufferGetStats(
+    _In_ const JITTER_BUFFER *JitterBuffer,
+    _Out_ PJITTER_BUFFER_STATS Stats
+);
+
+#endif // JITTER_BUFFER_H
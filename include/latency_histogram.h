@@ -0,0 +1,98 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include "portable.h"
+
+// Latencia de extremo a extremo del anillo interno: cuánto tiempo pasa el
+// audio en el anillo desde que se escribe hasta que el lector lo recibe.
+//
+// El productor marca cada escritura con la posición final del anillo (Head
+// tras escribir) y la hora de llegada (LATENCY_TAGS, cola SPSC de tamaño fijo);
+// el lector, antes de leer, busca la marca que cubre su primer frame y anota
+// la edad en un histograma log-lineal (tipo HDR) de tamaño fijo. Nada reserva
+// memoria ni toma locks propios: las marcas van con ProducerLock y el
+// histograma con ConsumerLock.
+//
+// Con la cola llena la escritura se queda sin marca y la siguiente que sí
+// entra lleva la hora de la más antigua sin marca: la edad de esos frames se
+// sobrestima, nunca se subestima.
+
+// Histograma: valores exactos hasta 2^(SUB_BITS + 1) y después 2^SUB_BITS
+// cubos por octava (error relativo < 1/32). Los valores de 2^MAX_BITS o más
+// se saturan en el último cubo; el máximo se guarda exacto.
+#define LATENCY_HISTOGRAM_SUB_BITS 5
+#define LATENCY_HISTOGRAM_MAX_BITS 32
+#define LATENCY_HISTOGRAM_BUCKETS  ((LATENCY_HISTOGRAM_MAX_BITS - LATENCY_HISTOGRAM_SUB_BITS + 1) << LATENCY_HISTOGRAM_SUB_BITS)
+
+typedef struct _LATENCY_HISTOGRAM {
+    ULONG64 Count;    // Valores anotados en la ventana
+    ULONG64 Max;
+    ULONG Buckets[LATENCY_HISTOGRAM_BUCKETS];
+} LATENCY_HISTOGRAM, *PLATENCY_HISTOGRAM;
+
+// Marcas pendientes de lectura (potencia de dos)
+#define LATENCY_TAGS_COUNT 256
+
+typedef struct _LATENCY_TAG {
+    ULONG64 End;      // Posición del anillo tras la escritura
+    ULONG64 Time;     // Hora de llegada de los frames anteriores a End
+} LATENCY_TAG, *PLATENCY_TAG;
+
+typedef struct _LATENCY_TAGS {
+    // Productor
+    volatile ULONG64 Head;
+    ULONG64 LastEnd;
+    ULONG64 UntaggedTime; // Llegada de la escritura más antigua sin marca
+    BOOLEAN Untagged;
+    UCHAR ProducerPad[VMIC_CACHE_LINE - 3 * sizeof(ULONG64) - sizeof(BOOLEAN)];
+
+    // Consumidor
+    volatile ULONG64 Tail;
+    UCHAR ConsumerPad[VMIC_CACHE_LINE - sizeof(ULONG64)];
+
+    LATENCY_TAG Tags[LATENCY_TAGS_COUNT];
+} LATENCY_TAGS, *PLATENCY_TAGS;
+
+// Vacía la ventana
+VOID LatencyHistogramReset(
+    _Out_ PLATENCY_HISTOGRAM Histogram
+);
+
+VOID LatencyHistogramRecord(
+    _Inout_ PLATENCY_HISTOGRAM Histogram,
+    _In_ ULONG64 Value
+);
+
+// Valor bajo el que queda la fracción PartsPerMillion de la ventana (500000
+// = mediana): el mayor valor del cubo que la alcanza, sin pasar del máximo.
+// 0 con la ventana vacía.
+ULONG64 LatencyHistogramGetPercentile(
+    _In_ const LATENCY_HISTOGRAM *Histogram,
+    _In_ ULONG PartsPerMillion
+);
+
+// Sin marcas, empezando en la posición Position del anillo (con ambos locks)
+VOID LatencyTagsReset(
+    _Out_ PLATENCY_TAGS Tags,
+    _In_ ULONG64 Position
+);
+
+// Productor: los frames escritos hasta End llegaron en Time. Sin frames
+// nuevos desde la marca anterior no hace nada.
+VOID LatencyTagsMark(
+    _Inout_ PLATENCY_TAGS Tags,
+    _In_ ULONG64 End,
+    _In_ ULONG64 Time
+);
+
+// Consumidor: edad en Now del frame en Position (Tail antes de leer), en las
+// unidades de Time. Retira las marcas de frames anteriores, también los
+// descartados. FALSE si el frame no tiene marca.
+BOOLEAN LatencyTagsGetAge(
+    _Inout_ PLATENCY_TAGS Tags,
+    _In_ ULONG64 Position,
+    _In_ ULONG64 Now,
+    _Out_ PULONG64 Age
+);
+
+#endif // LATENCY_HISTOGRAM_H
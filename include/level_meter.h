@@ -0,0 +1,89 @@
+#ifndef LEVEL_METER_H
+#define LEVEL_METER_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+#include "sample_convert.h"
+
+// Medidores de nivel por canal: pico, RMS y muestras saturadas de lo que entra
+// en el anillo, acumulados sobre una ventana que el llamador reinicia cuando
+// lee los valores. Se miden los frames recién escritos en el anillo, en el
+// formato del dispositivo: siguen en caché tras la copia y la pasada extra
+// solo lee.
+//
+// Las muestras se normalizan a float (escala completa = 1) multiplicando por
+// una potencia de dos, así que el pico y las saturaciones son idénticos en
+// todas las variantes; la suma de cuadrados se acumula en float por bloques y
+// en double entre bloques. Una muestra está saturada si su valor absoluto
+// alcanza el máximo positivo del formato (1 en float). Los núcleos SSE2
+// cubren 1, 2, 4 u 8 canales; int24 empaquetado y el resto de canales usan
+// el escalar.
+
+#define LEVEL_METER_MAX_CHANNELS 8
+
+typedef struct _LEVEL_METER_CHANNEL {
+    float Peak;       // Valor absoluto máximo (1 = escala completa)
+    float Rms;
+    ULONG64 Clips;    // Muestras saturadas
+} LEVEL_METER_CHANNEL, *PLEVEL_METER_CHANNEL;
+
+// Valores de una ventana (también se devuelven por IOCTL)
+typedef struct _LEVEL_METER_SNAPSHOT {
+    ULONG64 Frames;   // Frames medidos en la ventana
+    ULONG Channels;
+    ULONG Reserved;
+    LEVEL_METER_CHANNEL Channel[LEVEL_METER_MAX_CHANNELS];
+} LEVEL_METER_SNAPSHOT, *PLEVEL_METER_SNAPSHOT;
+
+typedef struct _LEVEL_METER {
+    SAMPLE_FORMAT Format;
+    ULONG Channels;
+    SAMPLE_CONVERT_ISA Isa;
+    float Scale;          // Normalización: 2^-(bits - 1) en enteros, 1 en float
+    float ClipThreshold;  // Máximo positivo del formato, normalizado
+
+    // Ventana actual
+    ULONG64 Frames;
+    float Peak[LEVEL_METER_MAX_CHANNELS];
+    double SumSquares[LEVEL_METER_MAX_CHANNELS];
+    ULONG64 Clips[LEVEL_METER_MAX_CHANNELS];
+} LEVEL_METER, *PLEVEL_METER;
+
+// Empieza con la ventana vacía. Isa SCALAR fuerza la referencia; el resto usa
+// SSE2. STATUS_NOT_SUPPORTED si se fuerza una variante que la CPU no tiene.
+NTSTATUS LevelMeterInitialize(
+    _Out_ PLEVEL_METER Meter,
+    _In_ SAMPLE_FORMAT Format,
+    _In_ ULONG Channels,
+    _In_ SAMPLE_CONVERT_ISA Isa
+);
+
+// Empieza una ventana nueva
+VOID LevelMeterReset(
+    _Inout_ PLEVEL_METER Meter
+);
+
+// Acumula Frames frames intercalados
+VOID LevelMeterProcess(
+    _Inout_ PLEVEL_METER Meter,
+    _In_ const VOID *Data,
+    _In_ ULONG Frames
+);
+
+// Acumula los Frames frames del anillo que empiezan en el contador Start
+// (hasta Capacity; el tramo puede cruzar el final del buffer). Lo llama el
+// productor justo después de escribirlos.
+VOID LevelMeterProcessRing(
+    _Inout_ PLEVEL_METER Meter,
+    _In_ const RING_BUFFER *Ring,
+    _In_ ULONG64 Start,
+    _In_ ULONG Frames
+);
+
+// Valores de la ventana actual (sin reiniciarla)
+VOID LevelMeterGetSnapshot(
+    _In_ const LEVEL_METER *Meter,
+    _Out_ PLEVEL_METER_SNAPSHOT Snapshot
+);
+
+#endif // LEVEL_METER_H
@@ -0,0 +1,233 @@
+#ifndef LEVEL_METER_KERNELS_H
+#define LEVEL_METER_KERNELS_H
+
+#include "level_meter.h"
+
+// Acumuladores SSE2 por carriles de los medidores, compartidos por
+// level_meter.c y por las escrituras fusionadas (fused_write.c), que miden las
+// muestras en los registros antes de guardarlas. Se les pasan grupos de 8
+// muestras: con 1, 2, 4 u 8 canales el carril i es siempre el canal
+// i % Channels. Las sumas parciales pasan a double cada
+// LEVEL_METER_BLOCK_SAMPLES muestras contadas desde Start, así que medir un
+// tramo de una vez o grupo a grupo da el mismo resultado.
+
+// Muestras por suma parcial en float antes de pasarla a double
+#define LEVEL_METER_BLOCK_SAMPLES 1024
+
+static inline BOOLEAN LevelMeterUsesLanes(ULONG Channels)
+{
+    return (Channels == 1 || Channels == 2 || Channels == 4 || Channels == 8) ? TRUE : FALSE;
+}
+
+#if defined(VMIC_ARCH_X64)
+
+#include <emmintrin.h>
+
+// Pliega los 8 carriles (sin normalizar) en los canales del medidor; no cuenta
+// frames
+static inline VOID LevelMeterLanesFold(PLEVEL_METER Meter, const float *Peaks, const double *Sums,
+                                       const ULONG64 *Clips)
+{
+    ULONG lane;
+    ULONG channel;
+
+    for (lane = 0; lane < 8; lane++) {
+        channel = lane & (Meter->Channels - 1);
+        if (Peaks[lane] * Meter->Scale > Meter->Peak[channel]) {
+            Meter->Peak[channel] = Peaks[lane] * Meter->Scale;
+        }
+        Meter->SumSquares[channel] += Sums[lane] * ((double)Meter->Scale * Meter->Scale);
+        Meter->Clips[channel] += Clips[lane];
+    }
+}
+
+// int32 y float: muestras pasadas a float sin normalizar
+typedef struct _LEVEL_METER_LANES {
+    __m128 Threshold;     // Saturación sin normalizar
+    __m128 PeakLow;
+    __m128 PeakHigh;
+    __m128 SumLow;        // Sumas parciales del bloque
+    __m128 SumHigh;
+    __m128i ClipsLow;
+    __m128i ClipsHigh;
+    ULONG BlockSamples;
+    double Sums[8];
+    ULONG64 Clips[8];
+} LEVEL_METER_LANES, *PLEVEL_METER_LANES;
+
+static inline VOID LevelMeterLanesStart(const LEVEL_METER *Meter, PLEVEL_METER_LANES Lanes)
+{
+    ULONG lane;
+
+    Lanes->Threshold = _mm_set1_ps(Meter->ClipThreshold / Meter->Scale);
+    Lanes->PeakLow = _mm_setzero_ps();
+    Lanes->PeakHigh = _mm_setzero_ps();
+    Lanes->SumLow = _mm_setzero_ps();
+    Lanes->SumHigh = _mm_setzero_ps();
+    Lanes->ClipsLow = _mm_setzero_si128();
+    Lanes->ClipsHigh = _mm_setzero_si128();
+    Lanes->BlockSamples = 0;
+
+    for (lane = 0; lane < 8; lane++) {
+        Lanes->Sums[lane] = 0.0;
+        Lanes->Clips[lane] = 0;
+    }
+}
+
+// Pasa las sumas parciales del bloque a los acumuladores por carril
+static inline VOID LevelMeterLanesFlush(PLEVEL_METER_LANES Lanes)
+{
+    float sums[8];
+    ULONG clips[8];
+    ULONG lane;
+
+    _mm_storeu_ps(sums, Lanes->SumLow);
+    _mm_storeu_ps(sums + 4, Lanes->SumHigh);
+    _mm_storeu_si128((__m128i *)clips, Lanes->ClipsLow);
+    _mm_storeu_si128((__m128i *)(clips + 4), Lanes->ClipsHigh);
+
+    for (lane = 0; lane < 8; lane++) {
+        Lanes->Sums[lane] += (double)sums[lane];
+        Lanes->Clips[lane] += clips[lane];
+    }
+
+    Lanes->SumLow = _mm_setzero_ps();
+    Lanes->SumHigh = _mm_setzero_ps();
+    Lanes->ClipsLow = _mm_setzero_si128();
+    Lanes->ClipsHigh = _mm_setzero_si128();
+    Lanes->BlockSamples = 0;
+}
+
+static inline VOID LevelMeterLanesAddVector(__m128 Value, __m128 Threshold, __m128 *Peak, __m128 *Sum,
+                                            __m128i *Clips)
+{
+    Value = _mm_andnot_ps(_mm_set1_ps(-0.0f), Value);
+    *Peak = _mm_max_ps(Value, *Peak);
+    *Sum = _mm_add_ps(*Sum, _mm_mul_ps(Value, Value));
+    // La comparación da -1 en los carriles saturados
+    *Clips = _mm_sub_epi32(*Clips, _mm_castps_si128(_mm_cmpge_ps(Value, Threshold)));
+}
+
+// Ocho muestras: Low (carriles 0..3) y High (4..7)
+static inline VOID LevelMeterLanesAdd(PLEVEL_METER_LANES Lanes, __m128 Low, __m128 High)
+{
+    LevelMeterLanesAddVector(Low, Lanes->Threshold, &Lanes->PeakLow, &Lanes->SumLow, &Lanes->ClipsLow);
+    LevelMeterLanesAddVector(High, Lanes->Threshold, &Lanes->PeakHigh, &Lanes->SumHigh, &Lanes->ClipsHigh);
+
+    Lanes->BlockSamples += 8;
+    if (Lanes->BlockSamples == LEVEL_METER_BLOCK_SAMPLES) {
+        LevelMeterLanesFlush(Lanes);
+    }
+}
+
+static inline VOID LevelMeterLanesFinish(PLEVEL_METER Meter, PLEVEL_METER_LANES Lanes)
+{
+    float peaks[8];
+
+    if (Lanes->BlockSamples > 0) {
+        LevelMeterLanesFlush(Lanes);
+    }
+
+    _mm_storeu_ps(peaks, Lanes->PeakLow);
+    _mm_storeu_ps(peaks + 4, Lanes->PeakHigh);
+    LevelMeterLanesFold(Meter, peaks, Lanes->Sums, Lanes->Clips);
+}
+
+// int16 sin pasar a float: pico con PMAXSW/PMINSW, saturadas comparando con
+// los extremos y cuadrados exactos con PMADDWD, enmascarando la otra muestra
+// del par para que cada carril de 32 bits tenga una sola (la de índice par o
+// impar). Solo las sumas de los cuadrados pasan a float.
+typedef struct _LEVEL_METER_INT16_LANES {
+    __m128i Maximum;
+    __m128i Minimum;
+    __m128i ClipCount;    // Contadores de 16 bits: un bloque no pasa de 128
+    __m128 SumEven;
+    __m128 SumOdd;
+    ULONG BlockSamples;
+    double Sums[8];
+    ULONG64 Clips[8];
+} LEVEL_METER_INT16_LANES, *PLEVEL_METER_INT16_LANES;
+
+static inline VOID LevelMeterInt16LanesStart(PLEVEL_METER_INT16_LANES Lanes)
+{
+    ULONG lane;
+
+    Lanes->Maximum = _mm_set1_epi16(-32768);
+    Lanes->Minimum = _mm_set1_epi16(32767);
+    Lanes->ClipCount = _mm_setzero_si128();
+    Lanes->SumEven = _mm_setzero_ps();
+    Lanes->SumOdd = _mm_setzero_ps();
+    Lanes->BlockSamples = 0;
+
+    for (lane = 0; lane < 8; lane++) {
+        Lanes->Sums[lane] = 0.0;
+        Lanes->Clips[lane] = 0;
+    }
+}
+
+static inline VOID LevelMeterInt16LanesFlush(PLEVEL_METER_INT16_LANES Lanes)
+{
+    float evenSums[4];
+    float oddSums[4];
+    USHORT clips[8];
+    ULONG lane;
+
+    _mm_storeu_ps(evenSums, Lanes->SumEven);
+    _mm_storeu_ps(oddSums, Lanes->SumOdd);
+    _mm_storeu_si128((__m128i *)clips, Lanes->ClipCount);
+
+    for (lane = 0; lane < 8; lane++) {
+        Lanes->Sums[lane] += (double)((lane & 1) ? oddSums[lane >> 1] : evenSums[lane >> 1]);
+        Lanes->Clips[lane] += clips[lane];
+    }
+
+    Lanes->ClipCount = _mm_setzero_si128();
+    Lanes->SumEven = _mm_setzero_ps();
+    Lanes->SumOdd = _mm_setzero_ps();
+    Lanes->BlockSamples = 0;
+}
+
+static inline VOID LevelMeterInt16LanesAdd(PLEVEL_METER_INT16_LANES Lanes, __m128i Samples)
+{
+    __m128i positive = _mm_set1_epi16(32767);
+    __m128i negative = _mm_set1_epi16(-32768);
+
+    Lanes->Maximum = _mm_max_epi16(Lanes->Maximum, Samples);
+    Lanes->Minimum = _mm_min_epi16(Lanes->Minimum, Samples);
+    Lanes->ClipCount = _mm_sub_epi16(Lanes->ClipCount, _mm_or_si128(_mm_cmpeq_epi16(Samples, positive),
+                                                                    _mm_cmpeq_epi16(Samples, negative)));
+    // -32768^2 cabe sin signo en 32 bits: PMADDWD solo desborda con dos
+    Lanes->SumEven = _mm_add_ps(Lanes->SumEven, _mm_cvtepi32_ps(_mm_madd_epi16(
+        Samples, _mm_and_si128(Samples, _mm_set1_epi32(0x0000FFFF)))));
+    Lanes->SumOdd = _mm_add_ps(Lanes->SumOdd, _mm_cvtepi32_ps(_mm_madd_epi16(
+        Samples, _mm_and_si128(Samples, _mm_set1_epi32((int)0xFFFF0000)))));
+
+    Lanes->BlockSamples += 8;
+    if (Lanes->BlockSamples == LEVEL_METER_BLOCK_SAMPLES) {
+        LevelMeterInt16LanesFlush(Lanes);
+    }
+}
+
+static inline VOID LevelMeterInt16LanesFinish(PLEVEL_METER Meter, PLEVEL_METER_INT16_LANES Lanes)
+{
+    SHORT maximums[8];
+    SHORT minimums[8];
+    float peaks[8];
+    ULONG lane;
+
+    if (Lanes->BlockSamples > 0) {
+        LevelMeterInt16LanesFlush(Lanes);
+    }
+
+    _mm_storeu_si128((__m128i *)maximums, Lanes->Maximum);
+    _mm_storeu_si128((__m128i *)minimums, Lanes->Minimum);
+    for (lane = 0; lane < 8; lane++) {
+        peaks[lane] = (float)max((LONG)maximums[lane], -(LONG)minimums[lane]);
+    }
+
+    LevelMeterLanesFold(Meter, peaks, Lanes->Sums, Lanes->Clips);
+}
+
+#endif // VMIC_ARCH_X64
+
+#endif // LEVEL_METER_KERNELS_H
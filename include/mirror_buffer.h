@@ -0,0 +1,33 @@
+#ifndef MIRROR_BUFFER_H
+#define MIRROR_BUFFER_H
+
+#include "portable.h"
+
+// Memoria "espejo" para el buffer circular: las mismas páginas físicas se
+// mapean dos veces seguidas, de modo que BaseAddress[i] y BaseAddress[i + Size]
+// son el mismo byte. Size debe ser múltiplo de MirrorBufferGetGranularity().
+// Implementaciones: src/driver/mirror_buffer.c (MDL) y
+// src/host/mirror_buffer_linux.c (memfd + mmap).
+typedef struct _MIRROR_BUFFER {
+    PUCHAR BaseAddress;
+    ULONG Size;
+#if defined(VMIC_HOST_BUILD)
+    int Fd;
+#else
+    PMDL PagesMdl;
+    PMDL MirrorMdl;
+#endif
+} MIRROR_BUFFER, *PMIRROR_BUFFER;
+
+ULONG MirrorBufferGetGranularity(VOID);
+
+NTSTATUS MirrorBufferAllocate(
+    _Out_ PMIRROR_BUFFER Mirror,
+    _In_ ULONG Size
+);
+
+VOID MirrorBufferFree(
+    _Inout_ PMIRROR_BUFFER Mirror
+);
+
+#endif // MIRROR_BUFFER_H
@@ -0,0 +1,228 @@
+#ifndef PORTABLE_H
+#define PORTABLE_H
+
+// Capa de portabilidad del núcleo de audio.
+// Los módulos portables (buffer circular, DSP, ...) se compilan tanto dentro
+// del driver (WDK) como en una biblioteca de modo usuario para las pruebas y
+// benchmarks en Linux (VMIC_HOST_BUILD).
+
+#if defined(VMIC_HOST_BUILD)
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Tipos del DDK con el mismo ancho que en Windows (modelo LLP64)
+#ifndef VOID
+#define VOID void
+#endif
+typedef void *PVOID;
+typedef uint8_t UCHAR, *PUCHAR;
+typedef int16_t SHORT, *PSHORT;
+typedef uint16_t USHORT, *PUSHORT;
+typedef int32_t LONG, *PLONG;
+typedef uint32_t ULONG, *PULONG;
+typedef int64_t LONG64, *PLONG64;
+typedef uint64_t ULONG64, *PULONG64;
+typedef int64_t LONGLONG;
+typedef uint64_t ULONGLONG;
+typedef size_t SIZE_T;
+typedef uintptr_t ULONG_PTR, *PULONG_PTR;
+typedef UCHAR BOOLEAN, *PBOOLEAN;
+typedef int32_t NTSTATUS;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+// Anotaciones SAL (sin efecto fuera del WDK)
+#define _In_
+#define _Out_
+#define _Inout_
+#define _In_opt_
+#define _Out_opt_
+#define _Inout_opt_
+#define _In_reads_bytes_(size)
+#define _Out_writes_bytes_(size)
+#define _Out_writes_(size)
+
+#define STATUS_SUCCESS              ((NTSTATUS)0x00000000L)
+#define STATUS_PENDING              ((NTSTATUS)0x00000103L)
+#define STATUS_BUFFER_OVERFLOW      ((NTSTATUS)0x80000005L)
+#define STATUS_DEVICE_BUSY          ((NTSTATUS)0x80000011L)
+#define STATUS_UNSUCCESSFUL         ((NTSTATUS)0xC0000001L)
+#define STATUS_NOT_IMPLEMENTED      ((NTSTATUS)0xC0000002L)
+#define STATUS_INVALID_PARAMETER    ((NTSTATUS)0xC000000DL)
+#define STATUS_INVALID_DEVICE_REQUEST ((NTSTATUS)0xC0000010L)
+#define STATUS_DATA_ERROR           ((NTSTATUS)0xC000003EL)
+#define STATUS_INSUFFICIENT_RESOURCES ((NTSTATUS)0xC000009AL)
+#define STATUS_NOT_SUPPORTED        ((NTSTATUS)0xC00000BBL)
+#define STATUS_BUFFER_TOO_SMALL     ((NTSTATUS)0xC0000023L)
+#define STATUS_DEVICE_NOT_READY     ((NTSTATUS)0xC00000A3L)
+#define STATUS_IO_TIMEOUT           ((NTSTATUS)0xC00000B5L)
+#define STATUS_CANCELLED            ((NTSTATUS)0xC0000120L)
+#define STATUS_INVALID_BUFFER_SIZE  ((NTSTATUS)0xC0000206L)
+#define NT_SUCCESS(status)          (((NTSTATUS)(status)) >= 0)
+
+#define RtlCopyMemory(dst, src, len) memcpy((dst), (src), (len))
+#define RtlMoveMemory(dst, src, len) memmove((dst), (src), (len))
+#define RtlZeroMemory(dst, len)      memset((dst), 0, (len))
+#define RtlFillMemory(dst, len, val) memset((dst), (val), (len))
+
+#define UNREFERENCED_PARAMETER(P) ((void)(P))
+#define FIELD_OFFSET(type, field) ((LONG)offsetof(type, field))
+#define CONTAINING_RECORD(address, type, field) \
+    ((type *)((PUCHAR)(address) - offsetof(type, field)))
+
+// Listas doblemente enlazadas con la semántica de las rutinas del DDK
+typedef struct _LIST_ENTRY {
+    struct _LIST_ENTRY *Flink;
+    struct _LIST_ENTRY *Blink;
+} LIST_ENTRY, *PLIST_ENTRY;
+
+static inline void InitializeListHead(PLIST_ENTRY ListHead)
+{
+    ListHead->Flink = ListHead->Blink = ListHead;
+}
+
+static inline BOOLEAN IsListEmpty(const LIST_ENTRY *ListHead)
+{
+    return ListHead->Flink == ListHead;
+}
+
+static inline void InsertTailList(PLIST_ENTRY ListHead, PLIST_ENTRY Entry)
+{
+    Entry->Flink = ListHead;
+    Entry->Blink = ListHead->Blink;
+    ListHead->Blink->Flink = Entry;
+    ListHead->Blink = Entry;
+}
+
+static inline BOOLEAN RemoveEntryList(PLIST_ENTRY Entry)
+{
+    PLIST_ENTRY flink = Entry->Flink;
+    PLIST_ENTRY blink = Entry->Blink;
+
+    blink->Flink = flink;
+    flink->Blink = blink;
+    return flink == blink;
+}
+
+#ifndef min
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b) (((a) > (b)) ? (a) : (b))
+#endif
+
+#define MAXULONG 0xFFFFFFFFUL
+
+// Accesos atómicos con orden acquire/release
+#define VmicReadNoFence64(ptr)         __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define VmicReadAcquire64(ptr)         __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define VmicWriteRelease64(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+
+// Intercambio con barrera completa
+#define VmicInterlockedExchange32(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+
+// Extensiones vectoriales (sample_convert.c). En modo usuario el sistema
+// conserva el estado AVX entre cambios de contexto: no hay nada que guardar.
+#if defined(__x86_64__)
+#define VMIC_ARCH_X64
+#define VmicCpuHasAvx2() (__builtin_cpu_supports("avx2") != 0)
+#endif
+
+typedef struct _VMIC_VECTOR_STATE {
+    int Unused;
+} VMIC_VECTOR_STATE;
+
+#define VmicSaveVectorState(state)    ((void)(state), STATUS_SUCCESS)
+#define VmicRestoreVectorState(state) ((void)(state))
+
+// Cuerpos genéricos que se especializan con parámetros constantes
+#define VMIC_FORCEINLINE inline __attribute__((always_inline))
+
+// Contadores por procesador (stat_counters.h): sched_getcpu en
+// src/host/processor_linux.c y suma atómica sin barrera
+ULONG VmicGetCurrentProcessor(VOID);
+#define VmicInterlockedAddNoFence64(ptr, value) ((void)__atomic_fetch_add((ptr), (value), __ATOMIC_RELAXED))
+
+// Índice del bit más alto a 1 (Value != 0)
+#define VmicHighestSetBit64(value) ((ULONG)(63 - __builtin_clzll(value)))
+
+// Reserva de registros de la traza (trace_ring.h): incremento con barrera
+// completa que devuelve el valor nuevo, y barrera completa suelta
+#define VmicInterlockedIncrement64(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#define VmicMemoryBarrier()             __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// Máximos de ioctl_dispatch.h: compara e intercambia con barrera completa y
+// devuelve el valor que había
+static inline ULONG64 VmicInterlockedCompareExchange64(volatile ULONG64 *Destination, ULONG64 Exchange, ULONG64 Comparand)
+{
+    __atomic_compare_exchange_n(Destination, &Comparand, Exchange, FALSE, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return Comparand;
+}
+
+// Tiempo de los handlers de IOCTL: CLOCK_MONOTONIC en nanosegundos
+// (src/host/clock_linux.c)
+ULONG64 VmicQueryPerformanceCounter(VOID);
+#define VmicQueryPerformanceFrequency() 1000000000ULL
+
+#else
+
+#include <ntddk.h>
+
+#define VmicReadNoFence64(ptr)         ((ULONG64)ReadNoFence64((volatile LONG64 *)(ptr)))
+#define VmicReadAcquire64(ptr)         ((ULONG64)ReadAcquire64((volatile LONG64 *)(ptr)))
+#define VmicWriteRelease64(ptr, value) WriteRelease64((volatile LONG64 *)(ptr), (LONG64)(value))
+#define VmicInterlockedExchange32(ptr, value) InterlockedExchange((volatile LONG *)(ptr), (LONG)(value))
+
+// El kernel solo conserva los registros XMM: el código AVX debe guardar y
+// restaurar el estado extendido (IRQL <= DISPATCH_LEVEL)
+#if defined(_M_AMD64)
+#define VMIC_ARCH_X64
+#define VmicCpuHasAvx2() (ExIsProcessorFeaturePresent(PF_AVX2_INSTRUCTIONS_AVAILABLE) != FALSE)
+#endif
+
+typedef XSTATE_SAVE VMIC_VECTOR_STATE;
+
+#define VmicSaveVectorState(state)    KeSaveExtendedProcessorState(XSTATE_MASK_AVX, (state))
+#define VmicRestoreVectorState(state) KeRestoreExtendedProcessorState(state)
+
+#define VMIC_FORCEINLINE __forceinline
+
+#define VmicGetCurrentProcessor() KeGetCurrentProcessorNumberEx(NULL)
+#define VmicInterlockedAddNoFence64(ptr, value) \
+    ((void)InterlockedAddNoFence64((volatile LONG64 *)(ptr), (LONG64)(value)))
+
+#define VmicInterlockedIncrement64(ptr) ((ULONG64)InterlockedIncrement64((volatile LONG64 *)(ptr)))
+#define VmicMemoryBarrier()             MemoryBarrier()
+
+#define VmicInterlockedCompareExchange64(ptr, exchange, comparand) \
+    ((ULONG64)InterlockedCompareExchange64((volatile LONG64 *)(ptr), (LONG64)(exchange), (LONG64)(comparand)))
+
+#define VmicQueryPerformanceCounter() ((ULONG64)KeQueryPerformanceCounter(NULL).QuadPart)
+
+static __forceinline ULONG64 VmicQueryPerformanceFrequency(VOID)
+{
+    LARGE_INTEGER frequency;
+
+    KeQueryPerformanceCounter(&frequency);
+    return (ULONG64)frequency.QuadPart;
+}
+
+static __forceinline ULONG VmicHighestSetBit64(ULONG64 Value)
+{
+    ULONG index;
+
+    _BitScanReverse64(&index, Value);
+    return index;
+}
+
+#endif // VMIC_HOST_BUILD
+
+// Tamaño de línea de caché usado para separar datos de productor y consumidor
+#define VMIC_CACHE_LINE 64
+
+#endif // PORTABLE_H
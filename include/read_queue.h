@@ -0,0 +1,60 @@
+#ifndef READ_QUEUE_H
+#define READ_QUEUE_H
+
+#include "portable.h"
+
+// Cola FIFO de lecturas pendientes (IRP_MJ_READ) con umbral de llenado
+// mínimo. El llamador la protege con su propio lock: en el driver es el lock
+// de la IoCsq (src/driver/pending_irp_queue.c), que además gestiona la
+// cancelación. La entrada vive dentro de la petición
+// (Irp->Tail.Overlay.DriverContext), así que encolar no reserva memoria.
+// Los envíos pendientes (OVERFLOW_POLICY_PEND) usan la misma cola con umbral
+// MAXULONG: la cabeza sale cuando cabe el paquete entero.
+typedef struct _READ_QUEUE_ENTRY {
+    LIST_ENTRY Link;
+    ULONG Frames; // Capacidad del buffer del lector en frames
+} READ_QUEUE_ENTRY, *PREAD_QUEUE_ENTRY;
+
+typedef struct _READ_QUEUE {
+    LIST_ENTRY PendingList;
+    ULONG Count;
+    ULONG MinFillFrames; // Evita completar lecturas con unos pocos frames
+} READ_QUEUE, *PREAD_QUEUE;
+
+VOID ReadQueueInitialize(
+    _Out_ PREAD_QUEUE Queue,
+    _In_ ULONG MinFillFrames
+);
+
+VOID ReadQueueInsert(
+    _Inout_ PREAD_QUEUE Queue,
+    _Inout_ PREAD_QUEUE_ENTRY Entry,
+    _In_ ULONG Frames
+);
+
+VOID ReadQueueRemove(
+    _Inout_ PREAD_QUEUE Queue,
+    _Inout_ PREAD_QUEUE_ENTRY Entry
+);
+
+// Entrada siguiente a After (NULL = la primera); NULL al final
+PREAD_QUEUE_ENTRY ReadQueueNext(
+    _In_ PREAD_QUEUE Queue,
+    _In_opt_ PREAD_QUEUE_ENTRY After
+);
+
+// Frames que deben estar disponibles para completar una lectura de Frames:
+// el umbral mínimo, o la lectura completa si pide menos que el umbral
+ULONG ReadQueueThreshold(
+    _In_ PREAD_QUEUE Queue,
+    _In_ ULONG Frames
+);
+
+// Primera lectura si ya puede completarse con AvailableFrames; las demás
+// esperan su turno (orden FIFO estricto)
+PREAD_QUEUE_ENTRY ReadQueuePeekReady(
+    _In_ PREAD_QUEUE Queue,
+    _In_ ULONG AvailableFrames
+);
+
+#endif // READ_QUEUE_H
@@ -0,0 +1,148 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+#include "sample_convert.h"
+
+// Conversión de frecuencia de muestreo polifásica por una razón racional
+// L/M = OutputRate/InputRate (reducida). El filtro prototipo es un sinc con
+// ventana de Kaiser de Taps * L coeficientes, repartido en L fases de Taps
+// coeficientes que se calculan una sola vez al configurar (PASSIVE_LEVEL);
+// cada muestra de salida es un producto escalar de Taps coeficientes con la
+// historia del canal. El camino de datos no reserva memoria ni usa la CRT.
+//
+// Internamente se trabaja en float: la entrada se decodifica desde su formato
+// y la salida se codifica al del destino con los conversores de
+// sample_convert.h. La variante SSE2 del producto escalar acumula en el mismo
+// orden que la escalar y da resultados idénticos bit a bit.
+//
+// El llamador reserva la memoria (ResamplerGetRequiredSize) y serializa las
+// llamadas; un mismo RESAMPLER conserva el estado entre paquetes.
+
+#define RESAMPLER_MAX_PHASES       2560    // Cualquier par de frecuencias estándar (8 a 192 kHz)
+#define RESAMPLER_MAX_COEFFICIENTS 262144  // 1 MB de banco de filtros
+#define RESAMPLER_BLOCK_FRAMES     256     // Frames por pasada de decodificación/codificación
+
+typedef enum _RESAMPLER_QUALITY {
+    RESAMPLER_QUALITY_LOW = 0,  // 16 coeficientes por fase, 60 dB de rechazo
+    RESAMPLER_QUALITY_MEDIUM,   // 32 coeficientes por fase, 80 dB
+    RESAMPLER_QUALITY_HIGH,     // 64 coeficientes por fase, 110 dB
+    RESAMPLER_QUALITY_COUNT
+} RESAMPLER_QUALITY;
+
+typedef struct _RESAMPLER_CONFIG {
+    ULONG InputRate;
+    ULONG OutputRate;
+    ULONG Channels;
+    SAMPLE_FORMAT SourceFormat;
+    SAMPLE_FORMAT TargetFormat;
+    RESAMPLER_QUALITY Quality;
+    SAMPLE_CONVERT_ISA Isa;       // SCALAR fuerza la referencia; el resto usa SSE2
+} RESAMPLER_CONFIG, *PRESAMPLER_CONFIG;
+
+typedef struct _RESAMPLER {
+    RESAMPLER_CONFIG Config;
+    ULONG Interpolation;          // L
+    ULONG Decimation;             // M
+    ULONG Taps;                   // Coeficientes por fase (múltiplo de 8)
+    BOOLEAN Vectorized;
+
+    // Estado del flujo: la próxima salida usa la fase Phase y la ventana de
+    // historia que termina en Position. Siempre Position >= Taps - 1.
+    ULONG Phase;
+    ULONG Position;
+    ULONG HistoryFrames;          // Frames válidos en cada plano de History
+    ULONG HistoryStride;          // Frames reservados por canal
+
+    const float *Coefficients;    // Interpolation filas de Taps (ventana en orden temporal)
+    float *History;               // Un plano por canal
+    float *InputBlock;            // RESAMPLER_BLOCK_FRAMES frames intercalados
+    float *OutputBlock;
+
+    SAMPLE_CONVERTER Decoder;     // Formato de entrada -> float32
+    SAMPLE_CONVERTER Encoder;     // float32 -> formato de destino
+} RESAMPLER, *PRESAMPLER;
+
+// Bytes necesarios para Config (0 si la razón o los parámetros no se admiten)
+SIZE_T ResamplerGetRequiredSize(
+    _In_ const RESAMPLER_CONFIG *Config
+);
+
+// Diseña el banco de filtros en Memory y devuelve el RESAMPLER, que vive al
+// principio de Memory (se libera junto con ella)
+NTSTATUS ResamplerInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const RESAMPLER_CONFIG *Config,
+    _Out_ PRESAMPLER *Resampler
+);
+
+// Prototipo sinc con ventana de Kaiser de Taps * Interpolation coeficientes
+// repartido en Interpolation filas de Taps (ventana en orden temporal), con
+// ganancia unitaria en continua por fila; el corte queda por debajo de la
+// Nyquist más baja. Lo usa también el interpolador de drift_control.h.
+VOID ResamplerDesignFilter(
+    _Out_ float *Coefficients,
+    _In_ ULONG Interpolation,
+    _In_ ULONG Decimation,
+    _In_ ULONG Taps,
+    _In_ double Attenuation
+);
+
+// Olvida la historia (silencio) sin rediseñar el filtro
+VOID ResamplerReset(
+    _Inout_ PRESAMPLER Resampler
+);
+
+// Frames de salida que producirán InputFrames frames de entrada más
+ULONG ResamplerGetOutputFrames(
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG InputFrames
+);
+
+// Cota de ResamplerGetOutputFrames válida en cualquier estado del flujo,
+// ceil(InputFrames * L / M): sirve para reservar espacio antes de conocer el
+// estado con el que se escribirá (envíos en cola)
+ULONG ResamplerGetMaxOutputFrames(
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG InputFrames
+);
+
+// Máximo de frames de entrada cuya salida cabe en OutputFrames frames
+ULONG ResamplerGetInputFrames(
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG OutputFrames
+);
+
+// Convierte a un buffer lineal. Solo consume la entrada cuya salida cabe en
+// MaxOutputFrames; devuelve los frames de salida escritos.
+ULONG ResamplerProcess(
+    _Inout_ PRESAMPLER Resampler,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG FramesConsumed,
+    _Out_ PVOID Target,
+    _In_ ULONG MaxOutputFrames
+);
+
+// Igual que SampleConvertWriteRing: devuelve los frames de entrada consumidos,
+// que son los que caben una vez convertidos (la salida nunca queda retenida).
+// Ring->FrameSize debe ser el tamaño de frame del formato de destino.
+ULONG ResamplerWriteRing(
+    _Inout_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+);
+
+// Igual que SampleConvertWriteRingDropOldest (el llamador excluye al consumidor)
+ULONG ResamplerWriteRingDropOldest(
+    _Inout_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+);
+
+#endif // RESAMPLER_H
@@ -0,0 +1,127 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include "portable.h"
+
+// Buffer circular lock-free de un productor y un consumidor (SPSC).
+// El anillo cuenta en frames completos de FrameSize bytes (BlockAlign del
+// formato activo), así que ninguna escritura parcial puede partir una muestra.
+// Head y Tail son contadores de frames de 64 bits que sólo crecen; la posición
+// real se obtiene con (contador & Mask), por lo que la capacidad en frames es
+// potencia de dos y se aprovecha completa (sin el frame de separación).
+// En modo espejo (Mirrored) Data apunta a 2 * Size bytes donde la segunda mitad
+// es un alias de las mismas páginas físicas: cualquier tramo de hasta Capacity
+// frames es contiguo y las copias nunca se parten en el wrap-around.
+typedef struct _RING_BUFFER {
+    // Línea de caché del productor
+    volatile ULONG64 Head;
+    ULONG64 CachedTail;
+    UCHAR ProducerPad[VMIC_CACHE_LINE - 2 * sizeof(ULONG64)];
+
+    // Línea de caché del consumidor
+    volatile ULONG64 Tail;
+    ULONG64 CachedHead;
+    UCHAR ConsumerPad[VMIC_CACHE_LINE - 2 * sizeof(ULONG64)];
+
+    // Solo lectura tras la inicialización
+    PUCHAR Data;
+    ULONG Capacity;  // Frames (potencia de dos)
+    ULONG Mask;
+    ULONG FrameSize; // Bytes por frame
+    ULONG Size;      // Capacity * FrameSize bytes
+    BOOLEAN Mirrored;
+} RING_BUFFER, *PRING_BUFFER;
+
+// Inicialización
+BOOLEAN RingBufferIsValidCapacity(
+    _In_ ULONG Capacity
+);
+
+ULONG RingBufferRoundUpCapacity(
+    _In_ ULONG Capacity
+);
+
+NTSTATUS RingBufferInitialize(
+    _Out_ PRING_BUFFER Ring,
+    _In_ PVOID Buffer,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+);
+
+NTSTATUS RingBufferInitializeMirrored(
+    _Out_ PRING_BUFFER Ring,
+    _In_ PVOID MirroredBuffer,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+);
+
+// Lado productor (cantidades en frames)
+ULONG RingBufferWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _In_reads_bytes_(Frames * Ring->FrameSize) const VOID *Data,
+    _In_ ULONG Frames
+);
+
+// Acceso directo (zero-copy): devuelve los frames contiguos disponibles para
+// escribir; en modo espejo es todo el espacio libre. Publicar con Commit.
+ULONG RingBufferAcquireWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _Out_ PUCHAR *Region
+);
+
+VOID RingBufferCommitWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+);
+
+// Política "descartar lo más antiguo": hace sitio avanzando Tail, por lo que
+// el llamador debe excluir también al consumidor. Si el paquete supera la
+// capacidad solo se conservan sus últimos Capacity frames.
+ULONG RingBufferWriteDropOldest(
+    _Inout_ PRING_BUFFER Ring,
+    _In_reads_bytes_(Frames * Ring->FrameSize) const VOID *Data,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+);
+
+// Lado consumidor (cantidades en frames)
+ULONG RingBufferRead(
+    _Inout_ PRING_BUFFER Ring,
+    _Out_writes_bytes_(Frames * Ring->FrameSize) PVOID Data,
+    _In_ ULONG Frames
+);
+
+ULONG RingBufferAcquireRead(
+    _Inout_ PRING_BUFFER Ring,
+    _Out_ PUCHAR *Region
+);
+
+VOID RingBufferReleaseRead(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+);
+
+// Descarta hasta Frames frames pendientes sin copiarlos
+ULONG RingBufferDiscard(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+);
+
+// Redimensionado: mueve los frames pendientes de Source a Target (vacío y con
+// el mismo FrameSize) sin perder audio y conservando los contadores. Requiere
+// acceso exclusivo a ambos anillos (el llamador detiene productor y consumidor).
+NTSTATUS RingBufferMigrate(
+    _Inout_ PRING_BUFFER Target,
+    _Inout_ PRING_BUFFER Source
+);
+
+// Consultas (válidas desde cualquier hilo; el resultado es una instantánea)
+ULONG RingBufferGetUsedFrames(
+    _In_ PRING_BUFFER Ring
+);
+
+ULONG RingBufferGetFreeFrames(
+    _In_ PRING_BUFFER Ring
+);
+
+#endif // RING_BUFFER_H
@@ -0,0 +1,106 @@
+#ifndef SAMPLE_CONVERT_H
+#define SAMPLE_CONVERT_H
+
+#include "portable.h"
+#include "ring_buffer.h"
+
+// Conversión de formato de muestra entre el productor y el anillo: PCM entero
+// de 16, 24 (empaquetado, 3 bytes) y 32 bits y coma flotante de 32 bits.
+// Semántica (idéntica en todas las variantes, la escalar es la referencia):
+//   entero -> entero: desplazamiento (se trunca al estrechar, sin dither)
+//   entero -> float:  x / 2^(bits-1)
+//   float -> entero:  x * 2^(bits-1) redondeado al par más cercano y saturado;
+//                     NaN satura al máximo (al mínimo en int32)
+// Las variantes SSE2/AVX2 se eligen en tiempo de ejecución según la CPU.
+
+// FormatTag de AUDIO_FORMAT / SET_FORMAT_REQUEST (valores de WAVEFORMATEX)
+#define AUDIO_FORMAT_TAG_PCM        1
+#define AUDIO_FORMAT_TAG_IEEE_FLOAT 3
+
+typedef enum _SAMPLE_FORMAT {
+    SAMPLE_FORMAT_INT16 = 0,
+    SAMPLE_FORMAT_INT24,     // Empaquetado little-endian
+    SAMPLE_FORMAT_INT32,
+    SAMPLE_FORMAT_FLOAT32,
+    SAMPLE_FORMAT_COUNT
+} SAMPLE_FORMAT, *PSAMPLE_FORMAT;
+
+typedef enum _SAMPLE_CONVERT_ISA {
+    SAMPLE_CONVERT_ISA_SCALAR = 0,
+    SAMPLE_CONVERT_ISA_SSE2,
+    SAMPLE_CONVERT_ISA_AVX2,
+    SAMPLE_CONVERT_ISA_COUNT
+} SAMPLE_CONVERT_ISA;
+
+// Convierte Samples muestras (no frames) de Source a Target
+typedef VOID (*SAMPLE_CONVERT_ROUTINE)(
+    _Out_ PVOID Target,
+    _In_ const VOID *Source,
+    _In_ SIZE_T Samples
+);
+
+typedef struct _SAMPLE_CONVERTER {
+    SAMPLE_FORMAT SourceFormat;
+    SAMPLE_FORMAT TargetFormat;
+    ULONG SourceFrameSize;
+    ULONG TargetFrameSize;
+    ULONG Channels;
+    SAMPLE_CONVERT_ISA Isa;
+    SAMPLE_CONVERT_ROUTINE Routine; // NULL: mismo formato, se copia
+} SAMPLE_CONVERTER, *PSAMPLE_CONVERTER;
+
+ULONG SampleFormatGetBytes(
+    _In_ SAMPLE_FORMAT Format
+);
+
+// FormatTag 0 equivale a PCM; la coma flotante solo existe con 32 bits
+NTSTATUS SampleFormatFromWave(
+    _In_ USHORT FormatTag,
+    _In_ USHORT BitsPerSample,
+    _Out_ PSAMPLE_FORMAT Format
+);
+
+BOOLEAN SampleConvertIsIsaAvailable(
+    _In_ SAMPLE_CONVERT_ISA Isa
+);
+
+// Mejor variante disponible en la CPU actual
+SAMPLE_CONVERT_ISA SampleConvertGetBestIsa(VOID);
+
+// Isa permite forzar una variante (pruebas y benchmarks); STATUS_NOT_SUPPORTED
+// si la CPU no la tiene
+NTSTATUS SampleConverterInitialize(
+    _Out_ PSAMPLE_CONVERTER Converter,
+    _In_ SAMPLE_FORMAT SourceFormat,
+    _In_ SAMPLE_FORMAT TargetFormat,
+    _In_ ULONG Channels,
+    _In_ SAMPLE_CONVERT_ISA Isa
+);
+
+VOID SampleConvertFrames(
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _Out_ PVOID Target,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+);
+
+// Igual que RingBufferWrite, pero Source está en el formato de entrada del
+// conversor y se convierte directamente sobre el anillo (sin copia intermedia).
+// Ring->FrameSize debe ser Converter->TargetFrameSize.
+ULONG SampleConvertWriteRing(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+);
+
+// Igual que RingBufferWriteDropOldest (el llamador excluye al consumidor)
+ULONG SampleConvertWriteRingDropOldest(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+);
+
+#endif // SAMPLE_CONVERT_H
@@ -0,0 +1,28 @@
+#ifndef SAMPLE_CONVERT_KERNELS_H
+#define SAMPLE_CONVERT_KERNELS_H
+
+#include "sample_convert.h"
+
+// Tablas internas de núcleos de conversión indexadas por [origen][destino].
+// Las entradas NULL (mismo formato, o pares sin versión vectorial) usan la
+// copia o el núcleo escalar. Los núcleos vectoriales terminan la cola que no
+// llena un vector con el escalar, así que el resultado es idéntico bit a bit.
+typedef SAMPLE_CONVERT_ROUTINE SAMPLE_CONVERT_TABLE[SAMPLE_FORMAT_COUNT][SAMPLE_FORMAT_COUNT];
+
+extern const SAMPLE_CONVERT_TABLE SampleConvertScalarKernels;
+
+#if defined(VMIC_ARCH_X64)
+// SSE2 no tiene PSHUFB: los pares con int24 empaquetado quedan en escalar
+extern const SAMPLE_CONVERT_TABLE SampleConvertSse2Kernels;
+
+// Compilado con soporte AVX2; solo se llama tras comprobar la CPU y, en el
+// kernel, con el estado extendido guardado (VmicSaveVectorState)
+extern const SAMPLE_CONVERT_TABLE SampleConvertAvx2Kernels;
+#endif
+
+#define SAMPLE_INT16_SCALE 32768.0f
+#define SAMPLE_INT24_SCALE 8388608.0f
+#define SAMPLE_INT32_SCALE 2147483648.0f
+#define SAMPLE_FLOAT_SCALE (1.0f / 2147483648.0f) // Entero alineado a la izquierda -> float
+
+#endif // SAMPLE_CONVERT_KERNELS_H
@@ -0,0 +1,135 @@
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include "portable.h"
+
+// Anillo de audio en memoria compartida entre el proceso productor y el driver
+// (estilo WaveRT): el driver reserva la memoria, la formatea y la mapea en el
+// proceso con IOCTL_VIRTUALMIC_MAP_RING. A partir de ahí el productor escribe
+// frames y avanza WritePosition sin ninguna llamada al sistema.
+//
+// Protocolo:
+//   - La cabecera ocupa SHARED_RING_DATA_OFFSET bytes; le siguen Capacity
+//     frames de FrameSize bytes (Capacity potencia de dos).
+//   - WritePosition y ReadPosition son contadores de frames de 64 bits que
+//     solo crecen; cada uno lo escribe un único lado con semántica release.
+//   - El productor escribe los datos y después publica WritePosition.
+//     El consumidor copia los datos y después publica ReadPosition.
+//   - Timbre (doorbell) opcional: antes de dormir por falta de espacio el
+//     productor publica en ProducerWaitFrames cuántos frames libres necesita
+//     y vuelve a comprobar el espacio; el consumidor, tras liberar frames,
+//     solo lo despierta (evento de notificación en Windows) cuando ya hay ese
+//     espacio. Pedir más de un paquete da histéresis y evita un cambio de
+//     contexto por paquete. Las esperas deben tolerar despertares espurios.
+//   - El consumidor (driver) no confía en la memoria compartida: usa su copia
+//     privada de la posición de lectura, la capacidad y el tamaño de frame, y
+//     trata un WritePosition fuera de rango como corrupción.
+
+#define SHARED_RING_MAGIC   0x474E5256UL // 'VRNG'
+#define SHARED_RING_VERSION 1
+
+typedef struct _SHARED_RING_HEADER {
+    // Descripción (la escribe el driver al formatear)
+    ULONG Magic;
+    ULONG Version;
+    ULONG DataOffset;
+    ULONG Capacity;  // Frames (potencia de dos)
+    ULONG FrameSize; // Bytes por frame
+    UCHAR DescriptionPad[VMIC_CACHE_LINE - 5 * sizeof(ULONG)];
+
+    // Línea de caché del productor
+    volatile ULONG64 WritePosition;
+    volatile LONG ProducerWaitFrames; // 0 = el productor no espera
+    UCHAR ProducerPad[VMIC_CACHE_LINE - sizeof(ULONG64) - sizeof(LONG)];
+
+    // Línea de caché del consumidor
+    volatile ULONG64 ReadPosition;
+    UCHAR ConsumerPad[VMIC_CACHE_LINE - sizeof(ULONG64)];
+} SHARED_RING_HEADER, *PSHARED_RING_HEADER;
+
+#define SHARED_RING_DATA_OFFSET ((ULONG)sizeof(SHARED_RING_HEADER))
+
+// Vista local de un extremo del anillo (no se comparte)
+typedef struct _SHARED_RING_VIEW {
+    PSHARED_RING_HEADER Header;
+    PUCHAR Data;
+    ULONG Capacity;
+    ULONG Mask;
+    ULONG FrameSize;
+    ULONG64 Position;   // Posición propia (autoritativa para este lado)
+    ULONG64 CachedPeer; // Última posición leída del otro lado
+} SHARED_RING_VIEW, *PSHARED_RING_VIEW;
+
+// Bytes necesarios para un anillo de Capacity frames (0 si no es válido)
+SIZE_T SharedRingGetRequiredSize(
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+);
+
+// Lo llama quien reserva la memoria (el driver)
+NTSTATUS SharedRingFormat(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+);
+
+// Extremo productor: valida la cabecera contra el tamaño mapeado
+NTSTATUS SharedRingAttachProducer(
+    _Out_ PSHARED_RING_VIEW View,
+    _In_ PVOID Memory,
+    _In_ SIZE_T Size
+);
+
+// Extremo consumidor: toma la geometría de sus propios parámetros
+NTSTATUS SharedRingAttachConsumer(
+    _Out_ PSHARED_RING_VIEW View,
+    _In_ PVOID Memory,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+);
+
+// Lado productor (cantidades en frames)
+ULONG SharedRingWrite(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_reads_bytes_(Frames * View->FrameSize) const VOID *Data,
+    _In_ ULONG Frames
+);
+
+ULONG SharedRingGetFreeFrames(
+    _Inout_ PSHARED_RING_VIEW View
+);
+
+// Anuncia que el productor va a dormir hasta tener FreeFrames libres.
+// Devuelve FALSE si ya hay ese espacio (no hay que esperar y retira el aviso).
+BOOLEAN SharedRingPrepareWait(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_ ULONG FreeFrames
+);
+
+// Lado consumidor. STATUS_DATA_ERROR si el productor publicó una posición
+// imposible (no se lee nada ni se mueve la posición de lectura).
+NTSTATUS SharedRingRead(
+    _Inout_ PSHARED_RING_VIEW View,
+    _Out_writes_bytes_(Frames * View->FrameSize) PVOID Data,
+    _In_ ULONG Frames,
+    _Out_ PULONG FramesRead
+);
+
+// Igual que SharedRingRead sin copiar los frames (el lector en silencio)
+NTSTATUS SharedRingDiscard(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_ ULONG Frames,
+    _Out_ PULONG FramesDiscarded
+);
+
+ULONG SharedRingGetUsedFrames(
+    _Inout_ PSHARED_RING_VIEW View
+);
+
+// TRUE si hay que tocar el timbre del productor (consume el aviso)
+BOOLEAN SharedRingShouldNotifyProducer(
+    _Inout_ PSHARED_RING_VIEW View
+);
+
+#endif // SHARED_RING_H
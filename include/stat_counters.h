@@ -0,0 +1,68 @@
+#ifndef STAT_COUNTERS_H
+#define STAT_COUNTERS_H
+
+#include "portable.h"
+
+// Contadores de estadísticas sin contención: cada procesador suma en su
+// propia ranura, de una línea de caché, y GET_STATS suma las ranuras. El
+// incremento es una suma atómica sin barrera sobre una línea que casi nunca
+// sale de la caché del procesador, en lugar de un InterlockedIncrement sobre
+// un contador compartido que rebota entre todos los escritores.
+//
+// La ranura es el procesador actual enmascarado con SlotMask: si el hilo
+// migra entre la consulta y la suma, o hay más procesadores que ranuras, dos
+// procesadores comparten ranura sin perder cuentas (la suma sigue siendo
+// atómica). La lectura no es una instantánea: cada ranura se lee por separado.
+//
+// La memoria la reserva el llamador (StatCountersGetRequiredSize).
+
+typedef enum _STAT_COUNTER {
+    STAT_COUNTER_SAMPLES_PROCESSED = 0, // Muestras entregadas al lector
+    STAT_COUNTER_UNDERRUNS,             // Lecturas por debajo de su llenado mínimo
+    STAT_COUNTER_OVERRUNS,              // Escrituras que no cupieron enteras
+    STAT_COUNTER_COUNT
+} STAT_COUNTER;
+
+typedef struct _STAT_COUNTER_SLOT {
+    volatile ULONG64 Values[STAT_COUNTER_COUNT];
+    UCHAR Pad[VMIC_CACHE_LINE - STAT_COUNTER_COUNT * sizeof(ULONG64)];
+} STAT_COUNTER_SLOT, *PSTAT_COUNTER_SLOT;
+
+typedef struct _STAT_COUNTERS {
+    PSTAT_COUNTER_SLOT Slots; // SlotMask + 1 ranuras alineadas a línea de caché
+    ULONG SlotMask;
+} STAT_COUNTERS, *PSTAT_COUNTERS;
+
+// Bytes para una ranura por procesador (Processors redondeado a potencia de
+// dos), con margen para alinearlas; 0 si Processors es 0
+SIZE_T StatCountersGetRequiredSize(
+    _In_ ULONG Processors
+);
+
+// Las ranuras viven en Memory, a cero (se liberan junto con ella)
+NTSTATUS StatCountersInitialize(
+    _Out_ PSTAT_COUNTERS Counters,
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ ULONG Processors
+);
+
+// Camino caliente: cualquier IRQL, sin locks
+static inline VOID StatCountersAdd(
+    _Inout_ PSTAT_COUNTERS Counters,
+    _In_ STAT_COUNTER Counter,
+    _In_ ULONG64 Value
+)
+{
+    PSTAT_COUNTER_SLOT slot = &Counters->Slots[VmicGetCurrentProcessor() & Counters->SlotMask];
+
+    VmicInterlockedAddNoFence64(&slot->Values[Counter], Value);
+}
+
+// Suma de todas las ranuras
+ULONG64 StatCountersRead(
+    _In_ const STAT_COUNTERS *Counters,
+    _In_ STAT_COUNTER Counter
+);
+
+#endif // STAT_COUNTERS_H
@@ -0,0 +1,100 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include "portable.h"
+
+// Traza binaria de eventos del camino caliente: registros de tamaño fijo
+// (evento, hora, procesador y tres argumentos) en un anillo que sobrescribe lo
+// más antiguo. Escribir no formatea ni toma locks: una suma atómica reserva
+// el registro y una escritura con release lo publica, desde cualquier IRQL y
+// cualquier número de escritores. Un único lector (IOCTL_VIRTUALMIC_DRAIN_TRACE)
+// vacía lo publicado y cuenta lo que se perdió por sobrescritura; la
+// herramienta tools/vmic_trace.c decodifica los registros.
+//
+// Un registro vale si su Sequence es su índice + 1. Tras copiarlo, el lector
+// comprueba que ningún escritor ha reservado ya su hueco en la vuelta
+// siguiente: si lo ha hecho, la copia puede estar a medias y se cuenta como
+// perdida.
+//
+// La memoria la reserva el llamador (TraceRingGetRequiredSize).
+
+// Eventos (TRACE_RECORD.Event) y sus argumentos
+typedef enum _TRACE_EVENT {
+    TRACE_EVENT_NONE = 0,
+    TRACE_EVENT_IOCTL,          // Código, bytes de entrada, bytes de salida
+    TRACE_EVENT_IOCTL_COMPLETE, // Código, NTSTATUS, Information
+    TRACE_EVENT_WRITE,          // Bytes recibidos, bytes escritos, política
+    TRACE_EVENT_WRITE_BATCH,    // Paquetes, frames, bytes del lote
+    TRACE_EVENT_READ,           // Frames pedidos, frames leídos, en silencio
+    TRACE_EVENT_COUNT
+} TRACE_EVENT;
+
+typedef struct _TRACE_RECORD {
+    volatile ULONG64 Sequence; // Índice + 1; 0 = nunca escrito
+    ULONG64 Time;              // Tiempo de interrupción (100 ns)
+    USHORT Event;
+    USHORT Processor;
+    ULONG Args[3];
+} TRACE_RECORD, *PTRACE_RECORD;
+
+// Salida de DRAIN_TRACE: la cabecera y después Records registros en orden
+typedef struct _TRACE_DRAIN_HEADER {
+    ULONG Records;
+    ULONG Reserved;
+    ULONG64 Lost;              // Registros sobrescritos antes de vaciarlos
+} TRACE_DRAIN_HEADER, *PTRACE_DRAIN_HEADER;
+
+typedef struct _TRACE_RING {
+    volatile ULONG64 Head;     // Siguiente índice a reservar (escritores)
+    UCHAR Pad[VMIC_CACHE_LINE - sizeof(ULONG64)];
+    ULONG64 Tail;              // Siguiente índice a vaciar (lector)
+    PTRACE_RECORD Records;     // Mask + 1 registros
+    ULONG Mask;
+} TRACE_RING, *PTRACE_RING;
+
+// Bytes para Records registros (redondeado a potencia de dos); 0 si es 0
+SIZE_T TraceRingGetRequiredSize(
+    _In_ ULONG Records
+);
+
+// Los registros viven en Memory, vacíos (se liberan junto con ella)
+NTSTATUS TraceRingInitialize(
+    _Out_ PTRACE_RING Ring,
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ ULONG Records
+);
+
+// Camino caliente: cualquier IRQL, sin locks
+static inline VOID TraceRingWrite(
+    _Inout_ PTRACE_RING Ring,
+    _In_ TRACE_EVENT Event,
+    _In_ ULONG64 Time,
+    _In_ ULONG Arg0,
+    _In_ ULONG Arg1,
+    _In_ ULONG Arg2
+)
+{
+    ULONG64 index = VmicInterlockedIncrement64(&Ring->Head) - 1;
+    PTRACE_RECORD record = &Ring->Records[index & Ring->Mask];
+
+    record->Time = Time;
+    record->Event = (USHORT)Event;
+    record->Processor = (USHORT)VmicGetCurrentProcessor();
+    record->Args[0] = Arg0;
+    record->Args[1] = Arg1;
+    record->Args[2] = Arg2;
+    VmicWriteRelease64(&record->Sequence, index + 1);
+}
+
+// Copia en orden hasta MaxRecords registros publicados y suma a *Lost los
+// sobrescritos. Se detiene en el primero que aún se está escribiendo. Un
+// solo lector a la vez.
+ULONG TraceRingDrain(
+    _Inout_ PTRACE_RING Ring,
+    _Out_writes_(MaxRecords) PTRACE_RECORD Records,
+    _In_ ULONG MaxRecords,
+    _Inout_ PULONG64 Lost
+);
+
+#endif // TRACE_RING_H
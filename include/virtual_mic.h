@@ -9,6 +9,22 @@
 #define IOCTL_VIRTUALMIC_SET_FORMAT     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x801, METHOD_BUFFERED, FILE_ANY_ACCESS)
 #define IOCTL_VIRTUALMIC_GET_STATS      CTL_CODE(FILE_DEVICE_UNKNOWN, 0x802, METHOD_BUFFERED, FILE_READ_ACCESS)
 #define IOCTL_VIRTUALMIC_MUTE           CTL_CODE(FILE_DEVICE_UNKNOWN, 0x803, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_BUFFER     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x804, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_OVERFLOW_POLICY CTL_CODE(FILE_DEVICE_UNKNOWN, 0x805, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_MAP_RING       CTL_CODE(FILE_DEVICE_UNKNOWN, 0x806, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_UNMAP_RING     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x807, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SEND_AUDIO_DIRECT CTL_CODE(FILE_DEVICE_UNKNOWN, 0x808, METHOD_IN_DIRECT, FILE_ANY_ACCESS)
+#define IOCTL_VIRTUALMIC_SEND_AUDIO_BATCH  CTL_CODE(FILE_DEVICE_UNKNOWN, 0x809, METHOD_BUFFERED, FILE_ANY_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_WATERMARKS    CTL_CODE(FILE_DEVICE_UNKNOWN, 0x80A, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_CHANNEL_MIX   CTL_CODE(FILE_DEVICE_UNKNOWN, 0x80B, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_GAIN          CTL_CODE(FILE_DEVICE_UNKNOWN, 0x80C, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_JITTER_BUFFER CTL_CODE(FILE_DEVICE_UNKNOWN, 0x80D, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_DRIFT_CONTROL CTL_CODE(FILE_DEVICE_UNKNOWN, 0x80E, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_METERING          CTL_CODE(FILE_DEVICE_UNKNOWN, 0x80F, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_SET_DSP_CHAIN     CTL_CODE(FILE_DEVICE_UNKNOWN, 0x810, METHOD_BUFFERED, FILE_WRITE_ACCESS)
+#define IOCTL_VIRTUALMIC_GET_LATENCY       CTL_CODE(FILE_DEVICE_UNKNOWN, 0x811, METHOD_BUFFERED, FILE_READ_ACCESS)
+#define IOCTL_VIRTUALMIC_DRAIN_TRACE       CTL_CODE(FILE_DEVICE_UNKNOWN, 0x812, METHOD_BUFFERED, FILE_READ_ACCESS)
+#define IOCTL_VIRTUALMIC_GET_IOCTL_STATS   CTL_CODE(FILE_DEVICE_UNKNOWN, 0x813, METHOD_BUFFERED, FILE_READ_ACCESS)
 
 // Estructuras de datos
 typedef struct _AUDIO_FORMAT {
@@ -26,24 +42,227 @@ typedef struct _AUDIO_BUFFER_PACKET {
     UCHAR Data[1]; // Flexible array member
 } AUDIO_BUFFER_PACKET, *PAUDIO_BUFFER_PACKET;
 
+// SEND_AUDIO_DIRECT: la cabecera va en el buffer de entrada y las muestras en
+// el buffer de "salida", que el I/O manager bloquea y describe con un MDL
+// (METHOD_IN_DIRECT). El anillo se llena leyendo directamente de esas páginas.
+typedef struct _AUDIO_DIRECT_PACKET_HEADER {
+    ULONG64 Timestamp;
+    ULONG DataLength; // Bytes válidos del buffer de datos
+} AUDIO_DIRECT_PACKET_HEADER, *PAUDIO_DIRECT_PACKET_HEADER;
+
+// SEND_AUDIO_BATCH: formato de entrada y vector de resultados en audio_batch.h
+
+// Formato del dispositivo (el del anillo y las lecturas) y, opcionalmente, el
+// de las muestras que envía el productor: el driver convierte entre int16,
+// int24 empaquetado, int32 y float32 al escribir en el anillo. Las peticiones
+// antiguas de 8 bytes equivalen a PCM sin conversión. Con InputSampleRate
+// distinta de SampleRate el driver además convierte la frecuencia (filtro
+// polifásico, ver resampler.h), y con InputChannels distinto de Channels mezcla
+// los canales con el preset del par (SET_CHANNEL_MIX lo sustituye). Cambiar el
+// formato del dispositivo descarta el audio pendiente y cancela lecturas y
+// envíos en cola.
 typedef struct _SET_FORMAT_REQUEST {
     ULONG SampleRate;
     USHORT Channels;
     USHORT BitsPerSample;
+    USHORT FormatTag;           // AUDIO_FORMAT_TAG_* (sample_convert.h); 0 = PCM
+    USHORT InputBitsPerSample;  // 0 = el productor envía el formato del dispositivo
+    USHORT InputFormatTag;
+    USHORT ResamplerQuality;    // RESAMPLE_QUALITY_*
+    ULONG InputSampleRate;      // 0 = el productor envía a la frecuencia del dispositivo
+    USHORT InputChannels;       // 0 = los del dispositivo
+    USHORT Reserved;
 } SET_FORMAT_REQUEST, *PSET_FORMAT_REQUEST;
 
+#define SET_FORMAT_REQUEST_BASE_SIZE FIELD_OFFSET(SET_FORMAT_REQUEST, FormatTag)
+
+// Calidad de la conversión de frecuencia (SET_FORMAT_REQUEST.ResamplerQuality)
+#define RESAMPLE_QUALITY_DEFAULT 0 // Media
+#define RESAMPLE_QUALITY_LOW     1 // 16 coeficientes por fase, 60 dB de rechazo
+#define RESAMPLE_QUALITY_MEDIUM  2 // 32 coeficientes por fase, 80 dB
+#define RESAMPLE_QUALITY_HIGH    3 // 64 coeficientes por fase, 110 dB
+
+// Matriz de mezcla de canales para el par de canales activo (entrada del
+// productor -> dispositivo); InputChannels y OutputChannels deben coincidir con
+// el último SET_FORMAT. Preset es un CHANNEL_MIX_PRESET_* (channel_mix.h):
+// AUTO vuelve al preset del par y CUSTOM usa Matrix[salida][entrada] con
+// ganancias lineales de magnitud hasta 16. Sin efecto en el audio ya escrito.
+typedef struct _SET_CHANNEL_MIX_REQUEST {
+    ULONG Preset;
+    ULONG InputChannels;
+    ULONG OutputChannels;
+    ULONG Reserved;
+    float Matrix[8][8];
+} SET_CHANNEL_MIX_REQUEST, *PSET_CHANNEL_MIX_REQUEST;
+
+// Ganancia lineal de salida (0 a 16) aplicada a lo que se lee. Los cambios de
+// ganancia y de MUTE van de la ganancia actual a la nueva en RampFrames frames
+// del dispositivo (0 = de golpe); ese valor se mantiene para los siguientes.
+// El silencio conserva la ganancia y al quitarlo se vuelve a ella.
+typedef struct _SET_GAIN_REQUEST {
+    float Gain;
+    ULONG RampFrames; // Hasta GAIN_RAMP_MAX_FRAMES (gain_ramp.h)
+} SET_GAIN_REQUEST, *PSET_GAIN_REQUEST;
+
+// Jitter buffer delante de las etapas de entrada (ver jitter_buffer.h). Con él
+// activo, el Timestamp de SEND_AUDIO, SEND_AUDIO_DIRECT y SEND_AUDIO_BATCH es
+// la posición del primer frame del paquete en frames de entrada (como en RTP):
+// los paquetes se reordenan, los huecos que vencen se rellenan con silencio y
+// la política de desbordamiento no se aplica. El retardo sigue al percentil
+// Percentile del jitter observado dentro de [MinDelayFrames, MaxDelayFrames].
+// ENABLE empieza vacío y cancela los envíos en cola; DISABLE descarta lo que
+// quedaba dentro. Si hay buffer de salida se devuelve un JITTER_BUFFER_STATS
+// (jitter_buffer.h) con los contadores del jitter buffer anterior a la petición.
+#define JITTER_BUFFER_MODE_DISABLE 0
+#define JITTER_BUFFER_MODE_ENABLE  1
+#define JITTER_BUFFER_MODE_QUERY   2 // Solo devuelve los contadores
+
+typedef struct _SET_JITTER_BUFFER_REQUEST {
+    ULONG Mode;
+    ULONG MinDelayFrames;
+    ULONG MaxDelayFrames;  // Hasta JITTER_BUFFER_MAX_DELAY_FRAMES; 0 = por defecto
+    ULONG Percentile;      // 1 a 100; 0 = por defecto
+} SET_JITTER_BUFFER_REQUEST, *PSET_JITTER_BUFFER_REQUEST;
+
+// Compensación de deriva de reloj en la lectura (ver drift_control.h): el
+// lector consume el anillo a un ritmo corregido en hasta ±MaxCorrectionPpm
+// para mantener el llenado medio en TargetFillFrames aunque el reloj del
+// productor no coincida con el del consumidor. Solo cubre el anillo interno,
+// no el compartido. Si hay buffer de salida se devuelve un DRIFT_CONTROL_STATS
+// (drift_control.h) con el estado del lazo anterior a la petición.
+#define DRIFT_CONTROL_MODE_DISABLE 0
+#define DRIFT_CONTROL_MODE_ENABLE  1
+#define DRIFT_CONTROL_MODE_QUERY   2 // Solo devuelve el estado
+
+typedef struct _SET_DRIFT_CONTROL_REQUEST {
+    ULONG Mode;
+    ULONG TargetFillFrames;  // Menor que la capacidad del anillo; 0 = la mitad
+    ULONG MaxCorrectionPpm;  // Hasta DRIFT_CONTROL_MAX_CORRECTION_PPM; 0 = por defecto
+    ULONG ResponseFrames;    // Constante de tiempo del lazo; 0 = por defecto
+} SET_DRIFT_CONTROL_REQUEST, *PSET_DRIFT_CONTROL_REQUEST;
+
+// Medidores de nivel por canal (ver level_meter.h) de lo que entra en el
+// anillo interno, en el formato del dispositivo. Los valores se acumulan en
+// una ventana: ENABLE y DISABLE la vacían y METERING_FLAG_RESET empieza una
+// nueva tras devolver la actual. Cambiar el formato del dispositivo también
+// la vacía. Si hay buffer de salida se devuelve un LEVEL_METER_SNAPSHOT con
+// la ventana anterior a la petición.
+#define METERING_MODE_DISABLE 0
+#define METERING_MODE_ENABLE  1
+#define METERING_MODE_QUERY   2 // Solo devuelve la ventana
+
+#define METERING_FLAG_RESET   0x1
+
+typedef struct _METERING_REQUEST {
+    ULONG Mode;
+    ULONG Flags;
+} METERING_REQUEST, *PMETERING_REQUEST;
+
+// Cadena de procesado (ecualizador, compresor, limitador) sobre lo que se lee,
+// tras la ganancia de salida: entrada SET_DSP_CHAIN_REQUEST (dsp_chain.h).
+// Cubre el anillo interno y el compartido. ENABLE sustituye la cadena entera
+// (empieza en silencio) y se mantiene al cambiar el formato del dispositivo;
+// los limitadores retrasan la lectura su anticipación. Si hay buffer de
+// salida se devuelve un DSP_CHAIN_STATS con el estado de la cadena anterior
+// a la petición.
+#define DSP_CHAIN_MODE_DISABLE 0
+#define DSP_CHAIN_MODE_ENABLE  1
+#define DSP_CHAIN_MODE_QUERY   2 // Solo devuelve el estado
+
+// Unidades de SET_BUFFER_REQUEST.Latency
+#define BUFFER_LATENCY_MILLISECONDS 0
+#define BUFFER_LATENCY_FRAMES       1
+
+// Latencia objetivo del buffer. Si hay buffer de salida, el driver devuelve la
+// misma estructura con la capacidad real en frames.
+typedef struct _SET_BUFFER_REQUEST {
+    ULONG Unit;
+    ULONG Latency;
+} SET_BUFFER_REQUEST, *PSET_BUFFER_REQUEST;
+
+// Política ante buffer lleno (SET_OVERFLOW_POLICY_REQUEST.Policy)
+#define OVERFLOW_POLICY_REJECT      0 // Rechaza el paquete completo
+#define OVERFLOW_POLICY_DROP_OLDEST 1 // Descarta el audio más antiguo (latencia acotada)
+#define OVERFLOW_POLICY_BLOCK       2 // Espera hasta TimeoutMs a que haya espacio
+#define OVERFLOW_POLICY_PEND        3 // SEND_AUDIO queda pendiente hasta que quepa (E/S solapada)
+
+typedef struct _SET_OVERFLOW_POLICY_REQUEST {
+    ULONG Policy;
+    ULONG TimeoutMs; // Solo para OVERFLOW_POLICY_BLOCK
+} SET_OVERFLOW_POLICY_REQUEST, *PSET_OVERFLOW_POLICY_REQUEST;
+
+// Mapeo del anillo compartido (protocolo en shared_ring.h). Mientras está
+// mapeado, SEND_AUDIO devuelve STATUS_DEVICE_BUSY: el proceso que lo mapeó es
+// el único productor. Cerrar el handle deshace el mapeo.
+typedef struct _MAP_RING_REQUEST {
+    ULONG Capacity;           // Frames (se redondea a potencia de dos); 0 = la del buffer actual
+    ULONG Reserved;
+    ULONG64 NotificationEvent; // HANDLE de evento opcional: se señala al liberar espacio
+} MAP_RING_REQUEST, *PMAP_RING_REQUEST;
+
+typedef struct _MAP_RING_RESPONSE {
+    ULONG64 BaseAddress;      // Dirección de la cabecera en el proceso que llamó
+    ULONG MappedSize;
+    ULONG Capacity;
+    ULONG FrameSize;
+    ULONG Reserved;
+} MAP_RING_RESPONSE, *PMAP_RING_RESPONSE;
+
+// Avisos de nivel de llenado: el driver señala el evento cuando el anillo
+// entra en la zona baja (usados <= LowWaterFrames) o alta (>= HighWaterFrames),
+// una vez por cruce. Solo cubre el anillo interno, no el compartido.
+typedef struct _SET_WATERMARKS_REQUEST {
+    ULONG LowWaterFrames;
+    ULONG HighWaterFrames;     // 0 = sin umbral alto
+    ULONG64 NotificationEvent; // HANDLE de evento; 0 anula el registro
+} SET_WATERMARKS_REQUEST, *PSET_WATERMARKS_REQUEST;
+
 typedef struct _DRIVER_STATS {
     BOOLEAN IsActive;
-    ULONG64 SamplesProcessed;
+    ULONG64 SamplesProcessed; // Muestras (frames * canales) entregadas al lector
     ULONG BufferUsage; // Percentage as integer (0-100)
-    ULONG Underruns;
-    ULONG Overruns;
+    ULONG Underruns;   // Lecturas que no alcanzaron su llenado mínimo
+    ULONG Overruns;    // Escrituras que no cupieron enteras (según la política)
     AUDIO_FORMAT CurrentFormat;
-    ULONG64 UptimeMs;
+    ULONG64 UptimeMs;  // Desde InitializeDevice
 } DRIVER_STATS, *PDRIVER_STATS;
 
+// Latencia de extremo a extremo del anillo interno (ver latency_histogram.h):
+// edad del primer frame de cada lectura, desde que su paquete entró en el
+// anillo, en microsegundos. Cada petición devuelve la ventana desde la
+// anterior y empieza otra. Los percentiles tienen un error relativo < 3 %;
+// el máximo es exacto. Con el jitter buffer cuenta desde que se suelta el
+// paquete; con el anillo compartido no se mide.
+typedef struct _LATENCY_STATS {
+    ULONG64 Count;    // Lecturas medidas en la ventana
+    ULONG64 P50Us;
+    ULONG64 P99Us;
+    ULONG64 P999Us;
+    ULONG64 MaxUs;
+} LATENCY_STATS, *PLATENCY_STATS;
+
+// Traza binaria del camino caliente (trace_ring.h): DRAIN_TRACE devuelve un
+// TRACE_DRAIN_HEADER seguido de los registros que quepan en el buffer de
+// salida, en orden, y los retira. tools/vmic_trace decodifica la salida.
+
+// Contadores por IOCTL (ioctl_dispatch.h): GET_IOCTL_STATS devuelve un
+// IOCTL_STATS_HEADER seguido de un IOCTL_CALL_STATS por código que quepa en
+// el buffer de salida, acumulados desde la carga del driver.
+
 // Configuración por defecto
 #define DEFAULT_BUFFER_SIZE     8192
+#define DEFAULT_MIRRORED_BUFFER TRUE
+#define MIN_BUFFER_SIZE         256
+#define MAX_BUFFER_SIZE         (8 * 1024 * 1024)
+#define DEFAULT_OVERFLOW_POLICY OVERFLOW_POLICY_REJECT
+#define DEFAULT_BLOCK_TIMEOUT_MS 1000
+#define DEFAULT_READ_MIN_FILL_FRAMES 480 // 10 ms a 48 kHz
+#define DEFAULT_GAIN_RAMP_FRAMES 480     // 10 ms a 48 kHz
+#define DEFAULT_JITTER_MAX_DELAY_FRAMES 9600 // 200 ms a 48 kHz
+#define DEFAULT_JITTER_PERCENTILE 95
+#define DEFAULT_DRIFT_MAX_CORRECTION_PPM 1000
+#define DEFAULT_DRIFT_RESPONSE_SECONDS 60  // Segundos; se pasa a frames con la tasa del dispositivo
+#define DEFAULT_TRACE_RECORDS   4096     // 128 KB de registros de traza
 #define DEFAULT_SAMPLE_RATE     48000
 #define DEFAULT_CHANNELS        2
 #define DEFAULT_BITS_PER_SAMPLE 16
@@ -56,6 +275,7 @@ DRIVER_UNLOAD DriverUnload;
 // Funciones de dispatch
 DRIVER_DISPATCH DispatchCreate;
 DRIVER_DISPATCH DispatchClose;
+DRIVER_DISPATCH DispatchCleanup;
 DRIVER_DISPATCH DispatchDeviceControl;
 DRIVER_DISPATCH DispatchRead;
 
@@ -0,0 +1,49 @@
+#ifndef WATERMARK_H
+#define WATERMARK_H
+
+#include "portable.h"
+
+// Umbrales de llenado del anillo en frames. Lectores y escritores llaman a
+// WatermarkUpdate tras mover el anillo; devuelve TRUE al entrar en la zona baja
+// (Used <= LowWater) o alta (Used >= HighWater), una sola vez por cruce: la
+// zona intermedia hace de histéresis y no se repiten avisos dentro de la misma.
+#define WATERMARK_ZONE_LOW  0
+#define WATERMARK_ZONE_MID  1
+#define WATERMARK_ZONE_HIGH 2
+
+#define WATERMARK_HIGH_DISABLED 0xFFFFFFFFUL // HighWater 0 en la petición
+
+typedef struct _WATERMARK_STATE {
+    ULONG LowWater;
+    ULONG HighWater;
+    volatile LONG Zone; // WATERMARK_ZONE_*
+} WATERMARK_STATE, *PWATERMARK_STATE;
+
+// LowWater < HighWater <= Capacity (HighWater 0 = sin umbral alto)
+BOOLEAN WatermarkIsValid(
+    _In_ ULONG LowWater,
+    _In_ ULONG HighWater,
+    _In_ ULONG Capacity
+);
+
+// Empieza en la zona intermedia: la primera actualización avisa si el anillo
+// ya está por debajo (o por encima) de un umbral al registrarse
+VOID WatermarkInitialize(
+    _Out_ PWATERMARK_STATE Watermarks,
+    _In_ ULONG LowWater,
+    _In_ ULONG HighWater
+);
+
+ULONG WatermarkGetZone(
+    _In_ PWATERMARK_STATE Watermarks,
+    _In_ ULONG UsedFrames
+);
+
+// Seguro entre un lector y un escritor concurrentes: una carrera puede dar un
+// aviso de más, nunca dejar sin aviso un cruce que persiste
+BOOLEAN WatermarkUpdate(
+    _Inout_ PWATERMARK_STATE Watermarks,
+    _In_ ULONG UsedFrames
+);
+
+#endif // WATERMARK_H
@@ -0,0 +1,95 @@
+#include "audio_batch.h"
+
+NTSTATUS AudioBatchValidate(
+    _In_reads_bytes_(Length) const VOID *Buffer,
+    _In_ ULONG Length,
+    _In_ ULONG FrameSize,
+    _Out_ PULONG TotalFrames
+)
+{
+    const AUDIO_BATCH_HEADER *header = (const AUDIO_BATCH_HEADER *)Buffer;
+    const AUDIO_BATCH_DESCRIPTOR *packet;
+    ULONG64 totalFrames = 0;
+    ULONG i;
+
+    *TotalFrames = 0;
+
+    if (Buffer == NULL || FrameSize == 0 || Length < AUDIO_BATCH_HEADER_SIZE(1)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (header->PacketCount == 0 || header->PacketCount > MAX_AUDIO_BATCH_PACKETS ||
+        Length < AUDIO_BATCH_HEADER_SIZE(header->PacketCount)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < header->PacketCount; i++) {
+        packet = &header->Packets[i];
+
+        // Sumas en 64 bits: un offset cercano a 4 GiB no puede dar la vuelta
+        if (packet->DataLength == 0 ||
+            (ULONG64)packet->DataOffset + packet->DataLength > Length ||
+            packet->DataOffset < AUDIO_BATCH_HEADER_SIZE(header->PacketCount)) {
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        if (packet->DataLength % FrameSize != 0) {
+            return STATUS_INVALID_BUFFER_SIZE;
+        }
+
+        totalFrames += packet->DataLength / FrameSize;
+    }
+
+    *TotalFrames = (ULONG)min(totalFrames, 0xFFFFFFFFULL);
+    return STATUS_SUCCESS;
+}
+
+ULONG AudioBatchWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Buffer,
+    _In_opt_ const SAMPLE_CONVERTER *Converter,
+    _In_ BOOLEAN DropOldest,
+    _Out_writes_(((const AUDIO_BATCH_HEADER *)Buffer)->PacketCount) PAUDIO_BATCH_RESULT Results
+)
+{
+    const AUDIO_BATCH_HEADER *header = (const AUDIO_BATCH_HEADER *)Buffer;
+    const AUDIO_BATCH_DESCRIPTOR *packet;
+    const UCHAR *data;
+    ULONG frameSize = (Converter != NULL) ? Converter->SourceFrameSize : Ring->FrameSize;
+    ULONG frames;
+    ULONG written;
+    ULONG dropped;
+    ULONG overruns = 0;
+    ULONG i;
+
+    for (i = 0; i < header->PacketCount; i++) {
+        packet = &header->Packets[i];
+        data = (const UCHAR *)Buffer + packet->DataOffset;
+        frames = packet->DataLength / frameSize;
+
+        if (DropOldest) {
+            if (Converter != NULL) {
+                written = SampleConvertWriteRingDropOldest(Ring, Converter, data, frames, &dropped);
+            } else {
+                written = RingBufferWriteDropOldest(Ring, data, frames, &dropped);
+            }
+            if (dropped > 0) {
+                overruns++;
+            }
+        } else if (RingBufferGetFreeFrames(Ring) >= frames) {
+            if (Converter != NULL) {
+                written = SampleConvertWriteRing(Ring, Converter, data, frames);
+            } else {
+                written = RingBufferWrite(Ring, data, frames);
+            }
+        } else {
+            written = 0;
+            overruns++;
+        }
+
+        Results[i].Status = (written > 0) ? STATUS_SUCCESS : STATUS_BUFFER_TOO_SMALL;
+        Results[i].BytesWritten = written * frameSize;
+    }
+
+    return overruns;
+}
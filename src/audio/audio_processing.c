@@ -1,64 +1,626 @@
 #include "audio_processing.h"
 #include "common.h"
 
-NTSTATUS WriteAudioToBuffer(
+// Las escrituras reciben bytes en el formato de entrada y los pasan a frames
+// bajo ProducerLock: SetAudioFormat cambia conversor y anillo con ambos locks
+// tomados, así que el tamaño de frame no puede cambiar a mitad de una copia.
+// La mezcla de canales, el conversor de frecuencia y el jitter buffer se
+// sustituyen con ProducerLock tomado: solo se tocan dentro de él.
+//
+// Sin conversor de frecuencia, la conversión, la mezcla y los medidores van
+// en una sola pasada (fused_write.c) cuando la configuración activa tiene
+// especialización; se elige en cada escritura, así que sigue sola a los
+// cambios de formato, mezcla o medidores.
+
+// Mide lo que se acaba de escribir a partir del contador Head: sigue en caché
+// tras la copia. Con descartes el anillo puede haber dado más de una vuelta y
+// solo quedan los últimos Capacity frames (con ProducerLock)
+static VOID MeterWrittenFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG64 Head
+)
+{
+    PRING_BUFFER ring = &DeviceExtension->Ring;
+    ULONG64 written = ring->Head - Head;
+    
+    if (!DeviceExtension->MeteringEnabled || written == 0) {
+        return;
+    }
+    
+    if (written > ring->Capacity) {
+        Head = ring->Head - ring->Capacity;
+        written = ring->Capacity;
+    }
+    
+    LevelMeterProcessRing(&DeviceExtension->LevelMeter, ring, Head, (ULONG)written);
+}
+
+// Marca la hora de llegada de lo escrito hasta Head para medir su latencia
+// en la lectura (con ProducerLock)
+static VOID TagWrittenFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    LatencyTagsMark(&DeviceExtension->LatencyTags, DeviceExtension->Ring.Head, KeQueryInterruptTime());
+}
+
+ULONG WriteInputFramesToRing(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const VOID *AudioData,
+    _In_ ULONG Frames
+)
+{
+    ULONG64 head = DeviceExtension->Ring.Head;
+    FUSED_WRITE fused;
+    ULONG written;
+    
+    if (DeviceExtension->Resampler == NULL &&
+        FusedWriteSelect(&fused, &DeviceExtension->InputConverter, DeviceExtension->ChannelMix,
+                         DeviceExtension->MeteringEnabled ? &DeviceExtension->LevelMeter : NULL,
+                         SampleConvertGetBestIsa())) {
+        written = FusedWriteRing(&fused, &DeviceExtension->Ring, AudioData, Frames);
+        TagWrittenFrames(DeviceExtension);
+        return written;
+    }
+    
+    if (DeviceExtension->ChannelMix != NULL) {
+        written = ChannelMixWriteRing(DeviceExtension->ChannelMix, DeviceExtension->Resampler,
+                                      &DeviceExtension->Ring, AudioData, Frames);
+    } else if (DeviceExtension->Resampler != NULL) {
+        written = ResamplerWriteRing(DeviceExtension->Resampler, &DeviceExtension->Ring, AudioData, Frames);
+    } else {
+        written = SampleConvertWriteRing(&DeviceExtension->Ring, &DeviceExtension->InputConverter, AudioData, Frames);
+    }
+    
+    MeterWrittenFrames(DeviceExtension, head);
+    TagWrittenFrames(DeviceExtension);
+    return written;
+}
+
+ULONG WriteInputFramesToRingDropOldest(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const VOID *AudioData,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+)
+{
+    ULONG64 head = DeviceExtension->Ring.Head;
+    ULONG written;
+    
+    if (DeviceExtension->ChannelMix != NULL) {
+        written = ChannelMixWriteRingDropOldest(DeviceExtension->ChannelMix, DeviceExtension->Resampler,
+                                                &DeviceExtension->Ring, AudioData, Frames, DroppedFrames);
+    } else if (DeviceExtension->Resampler != NULL) {
+        written = ResamplerWriteRingDropOldest(DeviceExtension->Resampler, &DeviceExtension->Ring,
+                                               AudioData, Frames, DroppedFrames);
+    } else {
+        written = SampleConvertWriteRingDropOldest(&DeviceExtension->Ring, &DeviceExtension->InputConverter,
+                                                   AudioData, Frames, DroppedFrames);
+    }
+    
+    MeterWrittenFrames(DeviceExtension, head);
+    TagWrittenFrames(DeviceExtension);
+    return written;
+}
+
+ULONG GetRingFramesForInput(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG Frames
+)
+{
+    if (DeviceExtension->Resampler != NULL) {
+        return ResamplerGetMaxOutputFrames(DeviceExtension->Resampler, Frames);
+    }
+    
+    return Frames;
+}
+
+// Reloj del jitter buffer: tiempo de interrupción (100 ns) en frames de
+// entrada. Segundos y resto por separado para no desbordar (con ProducerLock)
+static ULONG64 GetJitterClock(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    ULONG64 time = KeQueryInterruptTime();
+    ULONG64 rate = (DeviceExtension->Resampler != NULL) ? DeviceExtension->Resampler->Config.InputRate
+                                                        : DeviceExtension->Format.SampleRate;
+    
+    return (time / 10000000) * rate + (time % 10000000) * rate / 10000000;
+}
+
+// Pasa al anillo lo que el jitter buffer ya puede soltar en Now; lo que no
+// cabe espera dentro (con ProducerLock tomado). Devuelve frames de entrada.
+static ULONG ReleaseJitterFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG64 Now
+)
+{
+    const VOID *data;
+    ULONG frames;
+    ULONG written;
+    ULONG total = 0;
+    
+    while (JitterBufferPeek(DeviceExtension->JitterBuffer, Now, &data, &frames)) {
+        written = WriteInputFramesToRing(DeviceExtension, data, frames);
+        JitterBufferConsume(DeviceExtension->JitterBuffer, written);
+        total += written;
+        
+        if (written < frames) {
+            break;
+        }
+    }
+    
+    return total;
+}
+
+NTSTATUS WriteTimestampedAudio(
     _In_ PDEVICE_EXTENSION DeviceExtension,
     _In_ PVOID AudioData,
     _In_ ULONG DataLength,
+    _In_ ULONG64 Timestamp,
     _Out_ PULONG BytesWritten
 )
 {
     KIRQL oldIrql;
-    ULONG freeSpace;
-    ULONG bytesToCopy;
-    ULONG firstChunk;
-    ULONG secondChunk;
+    ULONG frameSize;
+    ULONG64 now;
+    ULONG released;
     
     if (AudioData == NULL || DataLength == 0 || BytesWritten == NULL) {
         return STATUS_INVALID_PARAMETER;
     }
     
+    *BytesWritten = 0;
+    
     if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
         return STATUS_DEVICE_NOT_READY;
     }
     
-    KeAcquireSpinLock(&DeviceExtension->BufferLock, &oldIrql);
+    if (DeviceExtension->SharedRingActive) {
+        return STATUS_DEVICE_BUSY;
+    }
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    
+    // Desactivado desde que el llamador lo comprobó: orden de llegada
+    if (DeviceExtension->JitterBuffer == NULL) {
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+        return WriteAudioToBuffer(DeviceExtension, AudioData, DataLength, BytesWritten);
+    }
+    
+    frameSize = DeviceExtension->InputConverter.SourceFrameSize;
+    if (DataLength % frameSize != 0) {
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+        ERROR_PRINT("Packet length %lu is not a multiple of BlockAlign %lu", DataLength, frameSize);
+        return STATUS_INVALID_BUFFER_SIZE;
+    }
+    
+    // El paquete siempre se acepta: lo tardío o fuera de la ventana se cuenta
+    // en las estadísticas del jitter buffer
+    now = GetJitterClock(DeviceExtension);
+    JitterBufferInsert(DeviceExtension->JitterBuffer, Timestamp, AudioData, DataLength / frameSize, now);
+    released = ReleaseJitterFrames(DeviceExtension, now);
+    
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    *BytesWritten = DataLength;
     
-    // Calcular espacio libre
-    freeSpace = GetBufferFreeSpace(DeviceExtension);
-    bytesToCopy = min(DataLength, freeSpace);
+    if (released > 0) {
+        ServicePendingReads(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
+    }
     
-    if (bytesToCopy == 0) {
-        KeReleaseSpinLock(&DeviceExtension->BufferLock, oldIrql);
-        *BytesWritten = 0;
+    return STATUS_SUCCESS;
+}
+
+VOID ServiceJitterBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    KIRQL oldIrql;
+    ULONG released = 0;
+    
+    // Lectura sin lock como pista: se vuelve a mirar dentro
+    if (DeviceExtension->JitterBuffer == NULL) {
+        return;
+    }
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    if (DeviceExtension->JitterBuffer != NULL) {
+        released = ReleaseJitterFrames(DeviceExtension, GetJitterClock(DeviceExtension));
+    }
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    if (released > 0) {
+        ServicePendingReads(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
+    }
+}
+
+// OVERFLOW_POLICY_REJECT: el paquete entra completo o no entra
+static NTSTATUS WriteFramesReject(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID AudioData,
+    _In_ ULONG DataLength,
+    _Out_ PULONG BytesWritten
+)
+{
+    KIRQL oldIrql;
+    PSAMPLE_CONVERTER converter = &DeviceExtension->InputConverter;
+    ULONG frames;
+    
+    *BytesWritten = 0;
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    frames = DataLength / converter->SourceFrameSize;
+    if (RingBufferGetFreeFrames(&DeviceExtension->Ring) >= GetRingFramesForInput(DeviceExtension, frames)) {
+        *BytesWritten = WriteInputFramesToRing(DeviceExtension, AudioData, frames) * converter->SourceFrameSize;
+    }
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    if (*BytesWritten == 0) {
+        StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_OVERRUNS, 1);
         return STATUS_BUFFER_TOO_SMALL;
     }
     
-    // Calcular chunks para escritura circular
-    firstChunk = min(bytesToCopy, 
-                     DeviceExtension->BufferSize - DeviceExtension->WritePosition);
-    secondChunk = bytesToCopy - firstChunk;
+    return STATUS_SUCCESS;
+}
+
+// OVERFLOW_POLICY_DROP_OLDEST: se descarta el audio más antiguo para que la
+// latencia quede acotada por la capacidad del buffer
+static NTSTATUS WriteFramesDropOldest(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID AudioData,
+    _In_ ULONG DataLength,
+    _Out_ PULONG BytesWritten
+)
+{
+    KIRQL oldIrql;
+    PSAMPLE_CONVERTER converter = &DeviceExtension->InputConverter;
+    ULONG droppedFrames = 0;
+    ULONG frames;
+    ULONG framesWritten;
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    
+    frames = DataLength / converter->SourceFrameSize;
+    framesWritten = WriteInputFramesToRing(DeviceExtension, AudioData, frames);
+    
+    if (framesWritten < frames) {
+        // Descartar mueve Tail: excluir también al consumidor (mismo orden que el resize)
+        KeAcquireSpinLockAtDpcLevel(&DeviceExtension->ConsumerLock);
+        framesWritten += WriteInputFramesToRingDropOldest(DeviceExtension,
+                                                          (PUCHAR)AudioData + (SIZE_T)framesWritten * converter->SourceFrameSize,
+                                                          frames - framesWritten,
+                                                          &droppedFrames);
+        KeReleaseSpinLockFromDpcLevel(&DeviceExtension->ConsumerLock);
+    }
+    
+    *BytesWritten = framesWritten * converter->SourceFrameSize;
+    
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
     
-    // Copiar primer chunk
-    if (firstChunk > 0) {
-        RtlCopyMemory((PUCHAR)DeviceExtension->AudioBuffer + DeviceExtension->WritePosition,
-                      AudioData, firstChunk);
+    if (droppedFrames > 0) {
+        StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_OVERRUNS, 1);
     }
     
-    // Copiar segundo chunk (si hay wrap-around)
-    if (secondChunk > 0) {
-        RtlCopyMemory(DeviceExtension->AudioBuffer,
-                      (PUCHAR)AudioData + firstChunk, secondChunk);
-        DeviceExtension->WritePosition = secondChunk;
-    } else {
-        DeviceExtension->WritePosition = (DeviceExtension->WritePosition + firstChunk) % 
-                                         DeviceExtension->BufferSize;
+    return STATUS_SUCCESS;
+}
+
+// OVERFLOW_POLICY_BLOCK: el escritor espera a que el lector libere espacio
+static NTSTATUS WriteFramesBlocking(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID AudioData,
+    _In_ ULONG DataLength,
+    _Out_ PULONG BytesWritten
+)
+{
+    KIRQL oldIrql;
+    LARGE_INTEGER timeout;
+    PSAMPLE_CONVERTER converter = &DeviceExtension->InputConverter;
+    ULONG frameSize;
+    ULONG neededFrames;
+    ULONG64 deadline;
+    ULONG64 now;
+    BOOLEAN blocked = FALSE;
+    
+    // Solo se puede esperar por debajo de DISPATCH_LEVEL
+    if (KeGetCurrentIrql() > APC_LEVEL) {
+        return WriteFramesReject(DeviceExtension, AudioData, DataLength, BytesWritten);
+    }
+    
+    *BytesWritten = 0;
+    deadline = KeQueryInterruptTime() + MS_TO_100NS((ULONG64)DeviceExtension->BlockTimeoutMs);
+    
+    ExAcquireFastMutex(&DeviceExtension->BlockingWriteMutex);
+    
+    for (;;) {
+        KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+        frameSize = converter->SourceFrameSize;
+        *BytesWritten += WriteInputFramesToRing(DeviceExtension,
+                                                (PUCHAR)AudioData + *BytesWritten,
+                                                (DataLength - *BytesWritten) / frameSize) * frameSize;
+        // Espacio con el que el siguiente frame de entrada seguro que entra
+        neededFrames = GetRingFramesForInput(DeviceExtension, 1);
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+        
+        // No queda ningún frame completo por escribir
+        if (DataLength - *BytesWritten < frameSize) {
+            break;
+        }
+        
+        if (!blocked) {
+            StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_OVERRUNS, 1);
+            blocked = TRUE;
+        }
+        
+        now = KeQueryInterruptTime();
+        if (now >= deadline) {
+            break;
+        }
+        
+        // Las lecturas pendientes son las que liberan el espacio que esperamos
+        ServicePendingReads(DeviceExtension);
+        
+        // Anunciar la espera antes de volver a comprobar el espacio: el lector
+        // solo señala el evento si ve WritersWaiting > 0
+        InterlockedIncrement(&DeviceExtension->WritersWaiting);
+        if (RingBufferGetFreeFrames(&DeviceExtension->Ring) < neededFrames) {
+            timeout.QuadPart = -(LONGLONG)(deadline - now);
+            KeWaitForSingleObject(&DeviceExtension->SpaceAvailableEvent,
+                                  Executive,
+                                  KernelMode,
+                                  FALSE,
+                                  &timeout);
+        }
+        InterlockedDecrement(&DeviceExtension->WritersWaiting);
+    }
+    
+    ExReleaseFastMutex(&DeviceExtension->BlockingWriteMutex);
+    
+    if (*BytesWritten == 0) {
+        return STATUS_IO_TIMEOUT;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS WriteAudioToBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID AudioData,
+    _In_ ULONG DataLength,
+    _Out_ PULONG BytesWritten
+)
+{
+    NTSTATUS status;
+    ULONG frameSize;
+    
+    if (AudioData == NULL || DataLength == 0 || BytesWritten == NULL) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    *BytesWritten = 0;
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    // Con el anillo compartido mapeado el único productor es el proceso propietario
+    if (DeviceExtension->SharedRingActive) {
+        return STATUS_DEVICE_BUSY;
+    }
+    
+    // Solo se aceptan frames completos (del formato de entrada): un frame
+    // partido desincroniza los canales
+    frameSize = DeviceExtension->InputConverter.SourceFrameSize;
+    if (DataLength % frameSize != 0) {
+        ERROR_PRINT("Packet length %lu is not a multiple of BlockAlign %lu", DataLength, frameSize);
+        return STATUS_INVALID_BUFFER_SIZE;
+    }
+    
+    // Solo se serializan los productores entre sí; el consumidor no toma
+    // ProducerLock salvo para descartar audio antiguo
+    switch (DeviceExtension->OverflowPolicy) {
+        case OVERFLOW_POLICY_DROP_OLDEST:
+            status = WriteFramesDropOldest(DeviceExtension, AudioData, DataLength, BytesWritten);
+            break;
+            
+        case OVERFLOW_POLICY_BLOCK:
+            status = WriteFramesBlocking(DeviceExtension, AudioData, DataLength, BytesWritten);
+            break;
+            
+        default:
+            status = WriteFramesReject(DeviceExtension, AudioData, DataLength, BytesWritten);
+            break;
+    }
+    
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+    
+    TRACE_LOG(DeviceExtension, TRACE_EVENT_WRITE, DataLength, *BytesWritten, DeviceExtension->OverflowPolicy);
+    VERBOSE_PRINT("Written %lu bytes to audio buffer", *BytesWritten);
+    
+    // Completar las lecturas que esperaban estos frames
+    if (*BytesWritten > 0) {
+        ServicePendingReads(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+// Lote paquete a paquete con la política activa: cada paquete toma los locks
+// por su cuenta (un escritor bloqueante no puede esperar con ellos tomados)
+static VOID WriteAudioBatchPerPacket(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID BatchBuffer,
+    _Out_writes_(MAX_AUDIO_BATCH_PACKETS) PAUDIO_BATCH_RESULT Results
+)
+{
+    PAUDIO_BATCH_HEADER header = (PAUDIO_BATCH_HEADER)BatchBuffer;
+    PVOID audioData;
+    ULONG dataLength;
+    ULONG i;
+    
+    for (i = 0; i < header->PacketCount; i++) {
+        audioData = (PUCHAR)BatchBuffer + header->Packets[i].DataOffset;
+        dataLength = header->Packets[i].DataLength;
+        
+        switch (DeviceExtension->OverflowPolicy) {
+            case OVERFLOW_POLICY_DROP_OLDEST:
+                Results[i].Status = WriteFramesDropOldest(DeviceExtension, audioData, dataLength,
+                                                          &Results[i].BytesWritten);
+                break;
+                
+            case OVERFLOW_POLICY_BLOCK:
+                Results[i].Status = WriteFramesBlocking(DeviceExtension, audioData, dataLength,
+                                                        &Results[i].BytesWritten);
+                break;
+                
+            default:
+                Results[i].Status = WriteFramesReject(DeviceExtension, audioData, dataLength,
+                                                      &Results[i].BytesWritten);
+                break;
+        }
+    }
+    
+    ServicePendingReads(DeviceExtension);
+    SignalWatermarks(DeviceExtension);
+}
+
+// Lote con jitter buffer: todos los paquetes se guardan en una sola sección
+// crítica y después se entrega lo que ya venció. FALSE si se desactivó
+// entretanto (el llamador sigue por el camino normal).
+static BOOLEAN WriteAudioBatchToJitterBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID BatchBuffer,
+    _Out_writes_(MAX_AUDIO_BATCH_PACKETS) PAUDIO_BATCH_RESULT Results
+)
+{
+    KIRQL oldIrql;
+    PAUDIO_BATCH_HEADER header = (PAUDIO_BATCH_HEADER)BatchBuffer;
+    ULONG frameSize;
+    ULONG64 now;
+    ULONG released;
+    ULONG i;
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    
+    if (DeviceExtension->JitterBuffer == NULL) {
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+        return FALSE;
+    }
+    
+    frameSize = DeviceExtension->InputConverter.SourceFrameSize;
+    now = GetJitterClock(DeviceExtension);
+    
+    for (i = 0; i < header->PacketCount; i++) {
+        JitterBufferInsert(DeviceExtension->JitterBuffer,
+                           header->Packets[i].Timestamp,
+                           (PUCHAR)BatchBuffer + header->Packets[i].DataOffset,
+                           header->Packets[i].DataLength / frameSize,
+                           now);
+        Results[i].Status = STATUS_SUCCESS;
+        Results[i].BytesWritten = header->Packets[i].DataLength;
+    }
+    
+    released = ReleaseJitterFrames(DeviceExtension, now);
+    
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    if (released > 0) {
+        ServicePendingReads(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
     }
     
-    KeReleaseSpinLock(&DeviceExtension->BufferLock, oldIrql);
+    return TRUE;
+}
+
+NTSTATUS WriteAudioBatchToBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PVOID BatchBuffer,
+    _In_ ULONG BatchLength,
+    _Out_writes_(MAX_AUDIO_BATCH_PACKETS) PAUDIO_BATCH_RESULT Results,
+    _Out_ PULONG PacketCount
+)
+{
+    NTSTATUS status;
+    KIRQL oldIrql;
+    PAUDIO_BATCH_HEADER header = (PAUDIO_BATCH_HEADER)BatchBuffer;
+    ULONG64 head;
+    ULONG totalFrames;
+    ULONG overruns;
+    BOOLEAN dropOldest;
+    
+    *PacketCount = 0;
     
-    *BytesWritten = bytesToCopy;
-    DEBUG_PRINT("Written %lu bytes to audio buffer", bytesToCopy);
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    if (DeviceExtension->SharedRingActive) {
+        return STATUS_DEVICE_BUSY;
+    }
+    
+    // Todos los descriptores se validan antes de tocar el anillo
+    status = AudioBatchValidate(BatchBuffer, BatchLength, DeviceExtension->InputConverter.SourceFrameSize, &totalFrames);
+    if (!NT_SUCCESS(status)) {
+        ERROR_PRINT("Invalid audio batch: 0x%X", status);
+        return status;
+    }
+    
+    *PacketCount = header->PacketCount;
+    TRACE_LOG(DeviceExtension, TRACE_EVENT_WRITE_BATCH, header->PacketCount, totalFrames, BatchLength);
+    
+    // Con jitter buffer cada paquete entra por su Timestamp
+    if (DeviceExtension->JitterBuffer != NULL &&
+        WriteAudioBatchToJitterBuffer(DeviceExtension, BatchBuffer, Results)) {
+        return STATUS_SUCCESS;
+    }
+    
+    // Un escritor bloqueante no puede esperar con el spinlock tomado
+    if (DeviceExtension->OverflowPolicy == OVERFLOW_POLICY_BLOCK) {
+        WriteAudioBatchPerPacket(DeviceExtension, BatchBuffer, Results);
+        return STATUS_SUCCESS;
+    }
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    
+    // Con conversión de frecuencia los frames de salida de cada paquete
+    // dependen del estado del filtro: AudioBatchWrite no sabe contarlos
+    if (DeviceExtension->Resampler != NULL) {
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+        WriteAudioBatchPerPacket(DeviceExtension, BatchBuffer, Results);
+        return STATUS_SUCCESS;
+    }
+    
+    // Solo hace falta excluir al consumidor si hay que descartar audio antiguo
+    dropOldest = DeviceExtension->OverflowPolicy == OVERFLOW_POLICY_DROP_OLDEST &&
+                 RingBufferGetFreeFrames(&DeviceExtension->Ring) < totalFrames;
+    if (dropOldest) {
+        KeAcquireSpinLockAtDpcLevel(&DeviceExtension->ConsumerLock);
+    }
+    
+    head = DeviceExtension->Ring.Head;
+    overruns = AudioBatchWrite(&DeviceExtension->Ring, BatchBuffer, &DeviceExtension->InputConverter, dropOldest, Results);
+    MeterWrittenFrames(DeviceExtension, head);
+    TagWrittenFrames(DeviceExtension);
+    
+    if (dropOldest) {
+        KeReleaseSpinLockFromDpcLevel(&DeviceExtension->ConsumerLock);
+    }
+    
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    if (overruns > 0) {
+        StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_OVERRUNS, overruns);
+    }
+    
+    VERBOSE_PRINT("Written batch of %lu packets (%lu frames)", header->PacketCount, totalFrames);
+    
+    ServicePendingReads(DeviceExtension);
+    SignalWatermarks(DeviceExtension);
     
     return STATUS_SUCCESS;
 }
@@ -70,152 +632,916 @@ NTSTATUS ReadAudioFromBuffer(
     _Out_ PULONG BytesRead
 )
 {
+    NTSTATUS status = STATUS_SUCCESS;
     KIRQL oldIrql;
-    ULONG usedSpace;
-    ULONG bytesToCopy;
-    ULONG firstChunk;
-    ULONG secondChunk;
+    ULONG frameSize;
+    ULONG framesRead;
+    ULONG channels;
+    ULONG64 position;
+    ULONG64 age;
+    BOOLEAN silent;
     
     if (AudioData == NULL || MaxLength == 0 || BytesRead == NULL) {
         return STATUS_INVALID_PARAMETER;
     }
     
+    *BytesRead = 0;
+    
     if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
         return STATUS_DEVICE_NOT_READY;
     }
     
-    KeAcquireSpinLock(&DeviceExtension->BufferLock, &oldIrql);
+    // Se entregan solo frames completos; el resto del buffer queda sin usar
+    if (MaxLength < DeviceExtension->Ring.FrameSize) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
     
-    // Calcular espacio usado
-    usedSpace = GetBufferUsedSpace(DeviceExtension);
-    bytesToCopy = min(MaxLength, usedSpace);
+    // Solo se serializan los lectores entre sí; el productor no toma este lock.
+    // El tamaño de frame se lee dentro: un cambio de formato toma ambos locks.
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
     
-    if (bytesToCopy == 0) {
-        KeReleaseSpinLock(&DeviceExtension->BufferLock, oldIrql);
-        *BytesRead = 0;
-        return STATUS_SUCCESS;
+    // En silencio estable los frames se consumen sin leer su contenido
+    silent = GainRampIsSilent(&DeviceExtension->OutputGain);
+    channels = DeviceExtension->Format.Channels;
+    position = VmicReadNoFence64(&DeviceExtension->Ring.Tail);
+    
+    if (DeviceExtension->SharedRingActive) {
+        // El productor escribe directamente en la memoria compartida
+        frameSize = DeviceExtension->SharedRing.FrameSize;
+        if (silent) {
+            status = SharedRingDiscard(&DeviceExtension->SharedRing, MaxLength / frameSize, &framesRead);
+        } else {
+            status = SharedRingRead(&DeviceExtension->SharedRing,
+                                    AudioData,
+                                    MaxLength / frameSize,
+                                    &framesRead);
+        }
+        
+        if (framesRead > 0 && DeviceExtension->SharedRingEvent != NULL &&
+            SharedRingShouldNotifyProducer(&DeviceExtension->SharedRing)) {
+            KeSetEvent(DeviceExtension->SharedRingEvent, IO_NO_INCREMENT, FALSE);
+        }
+    } else if (DeviceExtension->DriftControl != NULL) {
+        // También en silencio: el lazo tiene que ver el ritmo real del lector
+        frameSize = DeviceExtension->Ring.FrameSize;
+        framesRead = DriftControlReadRing(DeviceExtension->DriftControl,
+                                          &DeviceExtension->Ring,
+                                          AudioData,
+                                          MaxLength / frameSize);
+    } else {
+        frameSize = DeviceExtension->Ring.FrameSize;
+        framesRead = silent ? RingBufferDiscard(&DeviceExtension->Ring, MaxLength / frameSize)
+                            : RingBufferRead(&DeviceExtension->Ring, AudioData, MaxLength / frameSize);
     }
     
-    // Calcular chunks para lectura circular
-    firstChunk = min(bytesToCopy, 
-                     DeviceExtension->BufferSize - DeviceExtension->ReadPosition);
-    secondChunk = bytesToCopy - firstChunk;
+    // Edad del primer frame entregado; el anillo compartido no lleva marcas
+    if (!DeviceExtension->SharedRingActive && framesRead > 0 &&
+        LatencyTagsGetAge(&DeviceExtension->LatencyTags, position, KeQueryInterruptTime(), &age)) {
+        LatencyHistogramRecord(&DeviceExtension->Latency, age / 10);
+    }
     
-    // Copiar primer chunk
-    if (firstChunk > 0) {
-        RtlCopyMemory(AudioData,
-                      (PUCHAR)DeviceExtension->AudioBuffer + DeviceExtension->ReadPosition,
-                      firstChunk);
+    // La rampa avanza con los frames entregados; con ganancia 1 no se multiplica
+    if (!silent && framesRead > 0 && !GainRampIsUnity(&DeviceExtension->OutputGain)) {
+        GainRampApply(&DeviceExtension->OutputGain,
+                      DeviceExtension->InputConverter.TargetFormat,
+                      DeviceExtension->Format.Channels,
+                      AudioData,
+                      framesRead);
     }
     
-    // Copiar segundo chunk (si hay wrap-around)
-    if (secondChunk > 0) {
-        RtlCopyMemory((PUCHAR)AudioData + firstChunk,
-                      DeviceExtension->AudioBuffer, secondChunk);
-        DeviceExtension->ReadPosition = secondChunk;
-    } else {
-        DeviceExtension->ReadPosition = (DeviceExtension->ReadPosition + firstChunk) % 
-                                        DeviceExtension->BufferSize;
+    // La cadena sigue a la ganancia; en silencio vuelve a su estado de reposo
+    // para no arrastrar colas de filtros ni audio retrasado al quitarlo
+    if (DeviceExtension->DspChain != NULL) {
+        if (silent) {
+            DspChainReset(DeviceExtension->DspChain);
+        } else if (framesRead > 0) {
+            DspChainProcess(DeviceExtension->DspChain, AudioData, framesRead);
+        }
+    }
+    
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    
+    if (!NT_SUCCESS(status)) {
+        ERROR_PRINT("Shared ring corrupted by producer: 0x%X", status);
+        return status;
+    }
+    
+    // Fuera del lock: cada procesador suma en su propia ranura
+    StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_SAMPLES_PROCESSED, (ULONG64)framesRead * channels);
+    
+    // Una lectura corta que alcanza su llenado mínimo es el caso normal de la
+    // cola: solo falta audio si no llega al umbral (o el anillo estaba vacío)
+    if (framesRead < ReadQueueThreshold(&DeviceExtension->PendingReads.Queue, MaxLength / frameSize)) {
+        StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_UNDERRUNS, 1);
+    }
+    
+    if (silent) {
+        RtlZeroMemory(AudioData, (SIZE_T)framesRead * frameSize);
+    }
+    
+    // Despertar a un escritor bloqueado (OVERFLOW_POLICY_BLOCK). La operación
+    // interlocked ordena la publicación de Tail antes de leer WritersWaiting.
+    if (framesRead > 0 && InterlockedOr(&DeviceExtension->WritersWaiting, 0) > 0) {
+        KeSetEvent(&DeviceExtension->SpaceAvailableEvent, IO_NO_INCREMENT, FALSE);
+    }
+    
+    // Completar los envíos pendientes que ya caben (OVERFLOW_POLICY_PEND). La
+    // barrera anterior ordena Tail antes de leer el contador de la cola.
+    if (framesRead > 0) {
+        ServicePendingWrites(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
     }
     
-    KeReleaseSpinLock(&DeviceExtension->BufferLock, oldIrql);
+    *BytesRead = framesRead * frameSize;
     
-    *BytesRead = bytesToCopy;
-    DEBUG_PRINT("Read %lu bytes from audio buffer", bytesToCopy);
+    TRACE_LOG(DeviceExtension, TRACE_EVENT_READ, MaxLength / frameSize, framesRead, silent);
+    VERBOSE_PRINT("Read %lu frames from audio buffer", framesRead);
+    
+    return STATUS_SUCCESS;
+}
+
+// Diseña el banco de filtros (PASSIVE_LEVEL, puede llevar unos milisegundos)
+// en una reserva propia que se libera con FreeResampler
+static NTSTATUS CreateResampler(
+    _In_ const RESAMPLER_CONFIG *Config,
+    _Out_ PRESAMPLER *Resampler
+)
+{
+    NTSTATUS status;
+    PVOID memory;
+    SIZE_T size;
+    
+    *Resampler = NULL;
+    
+    // Razones con demasiadas fases (p. ej. 8000 -> 8001) no se admiten
+    size = ResamplerGetRequiredSize(Config);
+    if (size == 0) {
+        return STATUS_NOT_SUPPORTED;
+    }
+    
+    memory = ExAllocatePoolWithTag(NonPagedPool, size, POOL_TAG);
+    if (memory == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    status = ResamplerInitialize(memory, size, Config, Resampler);
+    if (!NT_SUCCESS(status)) {
+        ExFreePoolWithTag(memory, POOL_TAG);
+        return status;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+// La mezcla lleva sus propios bloques de trabajo (unos 16 KB): no cabe en la
+// extensión del dispositivo sin copiarla entera bajo el spinlock al cambiarla
+static NTSTATUS CreateChannelMix(
+    _In_ const CHANNEL_MIX_CONFIG *Config,
+    _Out_ PCHANNEL_MIX *ChannelMix
+)
+{
+    NTSTATUS status;
+    PCHANNEL_MIX channelMix;
+    
+    *ChannelMix = NULL;
+    
+    channelMix = (PCHANNEL_MIX)ExAllocatePoolWithTag(NonPagedPool, sizeof(CHANNEL_MIX), POOL_TAG);
+    if (channelMix == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    status = ChannelMixInitialize(channelMix, Config);
+    if (!NT_SUCCESS(status)) {
+        ExFreePoolWithTag(channelMix, POOL_TAG);
+        return status;
+    }
+    
+    *ChannelMix = channelMix;
+    return STATUS_SUCCESS;
+}
+
+// Ventana de hasta 2 * MaxDelay frames de entrada: reserva propia que se
+// libera con FreeJitterBuffer
+static NTSTATUS CreateJitterBuffer(
+    _In_ const JITTER_BUFFER_CONFIG *Config,
+    _Out_ PJITTER_BUFFER *JitterBuffer
+)
+{
+    NTSTATUS status;
+    PVOID memory;
+    SIZE_T size;
+    
+    *JitterBuffer = NULL;
+    
+    size = JitterBufferGetRequiredSize(Config);
+    if (size == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    memory = ExAllocatePoolWithTag(NonPagedPool, size, POOL_TAG);
+    if (memory == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    status = JitterBufferInitialize(memory, size, Config, JitterBuffer);
+    if (!NT_SUCCESS(status)) {
+        ExFreePoolWithTag(memory, POOL_TAG);
+        return status;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+// Interpolador y lazo (unos 20 KB) en una reserva propia que se libera con
+// FreeDriftControl. Los ceros de Request toman los valores por defecto para
+// Format y un anillo de Capacity frames.
+static NTSTATUS CreateDriftControl(
+    _In_ const SET_DRIFT_CONTROL_REQUEST *Request,
+    _In_ const AUDIO_FORMAT *Format,
+    _In_ SAMPLE_FORMAT SampleFormat,
+    _In_ ULONG Capacity,
+    _Out_ PDRIFT_CONTROL *DriftControl
+)
+{
+    NTSTATUS status;
+    DRIFT_CONTROL_CONFIG config;
+    PVOID memory;
+    SIZE_T size;
+    
+    *DriftControl = NULL;
+    
+    config.Channels = Format->Channels;
+    config.Format = SampleFormat;
+    config.TargetFill = (Request->TargetFillFrames == 0) ? Capacity / 2 : Request->TargetFillFrames;
+    config.MaxCorrectionPpm = (Request->MaxCorrectionPpm == 0) ? DEFAULT_DRIFT_MAX_CORRECTION_PPM
+                                                               : Request->MaxCorrectionPpm;
+    config.ResponseFrames = (Request->ResponseFrames == 0) ? DEFAULT_DRIFT_RESPONSE_SECONDS * Format->SampleRate
+                                                           : Request->ResponseFrames;
+    config.Isa = SampleConvertGetBestIsa();
+    
+    size = DriftControlGetRequiredSize(&config);
+    if (size == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    memory = ExAllocatePoolWithTag(NonPagedPool, size, POOL_TAG);
+    if (memory == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    status = DriftControlInitialize(memory, size, &config, DriftControl);
+    if (!NT_SUCCESS(status)) {
+        ExFreePoolWithTag(memory, POOL_TAG);
+        return status;
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+// Etapas y líneas de retardo en una reserva propia que se libera con
+// FreeDspChain. Las frecuencias de los filtros se validan aquí contra la
+// frecuencia de muestreo de Format.
+static NTSTATUS CreateDspChain(
+    _In_ const SET_DSP_CHAIN_REQUEST *Request,
+    _In_ const AUDIO_FORMAT *Format,
+    _In_ SAMPLE_FORMAT SampleFormat,
+    _Out_ PDSP_CHAIN *DspChain
+)
+{
+    NTSTATUS status;
+    DSP_CHAIN_CONFIG config;
+    PVOID memory;
+    SIZE_T size;
+    
+    *DspChain = NULL;
+    
+    config.SampleRate = Format->SampleRate;
+    config.Channels = Format->Channels;
+    config.Format = SampleFormat;
+    config.Isa = SampleConvertGetBestIsa();
+    config.Stages = Request->Stages;
+    RtlCopyMemory(config.Stage, Request->Stage, sizeof(config.Stage));
+    
+    size = DspChainGetRequiredSize(&config);
+    if (size == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    memory = ExAllocatePoolWithTag(NonPagedPool, size, POOL_TAG);
+    if (memory == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    status = DspChainInitialize(memory, size, &config, DspChain);
+    if (!NT_SUCCESS(status)) {
+        ExFreePoolWithTag(memory, POOL_TAG);
+        return status;
+    }
     
     return STATUS_SUCCESS;
 }
 
 NTSTATUS SetAudioFormat(
     _In_ PDEVICE_EXTENSION DeviceExtension,
-    _In_ ULONG SampleRate,
-    _In_ USHORT Channels,
-    _In_ USHORT BitsPerSample
+    _In_ const SET_FORMAT_REQUEST *Request
 )
 {
-    if (!IS_VALID_SAMPLE_RATE(SampleRate)) {
+    NTSTATUS status;
+    KIRQL oldIrql;
+    AUDIO_FORMAT format;
+    SAMPLE_CONVERTER converter;
+    SAMPLE_FORMAT deviceFormat;
+    SAMPLE_FORMAT inputFormat;
+    CHANNEL_MIX_CONFIG mixConfig;
+    RESAMPLER_CONFIG resamplerConfig;
+    PCHANNEL_MIX channelMix = NULL;
+    PCHANNEL_MIX oldChannelMix;
+    PRESAMPLER resampler = NULL;
+    PRESAMPLER oldResampler;
+    JITTER_BUFFER_CONFIG jitterConfig;
+    PJITTER_BUFFER jitterBuffer = NULL;
+    PJITTER_BUFFER oldJitterBuffer;
+    PDRIFT_CONTROL driftControl = NULL;
+    PDSP_CHAIN dspChain = NULL;
+    ULONG inputRate;
+    ULONG inputChannels;
+    
+    if (!IS_VALID_SAMPLE_RATE(Request->SampleRate)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    if (!IS_VALID_CHANNELS(Request->Channels)) {
         return STATUS_INVALID_PARAMETER;
     }
     
-    if (!IS_VALID_CHANNELS(Channels)) {
+    if (!IS_VALID_BITS_PER_SAMPLE(Request->BitsPerSample)) {
         return STATUS_INVALID_PARAMETER;
     }
     
-    if (!IS_VALID_BITS_PER_SAMPLE(BitsPerSample)) {
+    inputRate = (Request->InputSampleRate == 0) ? Request->SampleRate : Request->InputSampleRate;
+    if (!IS_VALID_SAMPLE_RATE(inputRate) || Request->ResamplerQuality > RESAMPLE_QUALITY_HIGH) {
         return STATUS_INVALID_PARAMETER;
     }
     
-    // TODO: Implementar cambio de formato dinámico
-    // Por ahora solo validamos los parámetros
+    inputChannels = (Request->InputChannels == 0) ? Request->Channels : Request->InputChannels;
+    if (!IS_VALID_CHANNELS(inputChannels)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    status = SampleFormatFromWave(Request->FormatTag, Request->BitsPerSample, &deviceFormat);
+    if (!NT_SUCCESS(status)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Sin formato de entrada explícito el productor envía el del dispositivo
+    if (Request->InputBitsPerSample == 0) {
+        inputFormat = deviceFormat;
+    } else {
+        status = SampleFormatFromWave(Request->InputFormatTag, Request->InputBitsPerSample, &inputFormat);
+        if (!NT_SUCCESS(status)) {
+            return STATUS_INVALID_PARAMETER;
+        }
+    }
+    
+    // Describe la entrada del productor; sin más etapas es también la conversión
+    status = SampleConverterInitialize(&converter, inputFormat, deviceFormat,
+                                       inputChannels, SampleConvertGetBestIsa());
+    RETURN_IF_NT_ERROR(status);
+    
+    format.SampleRate = Request->SampleRate;
+    format.Channels = Request->Channels;
+    format.BitsPerSample = Request->BitsPerSample;
+    format.BlockAlign = (USHORT)(SampleFormatGetBytes(deviceFormat) * Request->Channels);
+    format.BytesPerSecond = Request->SampleRate * format.BlockAlign;
+    format.FormatTag = (deviceFormat == SAMPLE_FORMAT_FLOAT32) ? AUDIO_FORMAT_TAG_IEEE_FLOAT : AUDIO_FORMAT_TAG_PCM;
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    // Las etapas se preparan antes de tocar el dispositivo: el productor sigue
+    // escribiendo con el formato anterior mientras tanto
+    if (inputChannels != format.Channels) {
+        RtlZeroMemory(&mixConfig, sizeof(mixConfig));
+        mixConfig.InputChannels = inputChannels;
+        mixConfig.OutputChannels = format.Channels;
+        mixConfig.SourceFormat = inputFormat;
+        mixConfig.TargetFormat = (inputRate != format.SampleRate) ? SAMPLE_FORMAT_FLOAT32 : deviceFormat;
+        mixConfig.Preset = CHANNEL_MIX_PRESET_AUTO;
+        mixConfig.Isa = converter.Isa;
+        
+        status = CreateChannelMix(&mixConfig, &channelMix);
+        RETURN_IF_NT_ERROR(status);
+    }
+    
+    // Tras la mezcla el conversor de frecuencia ya trabaja con los canales del dispositivo
+    if (inputRate != format.SampleRate) {
+        resamplerConfig.InputRate = inputRate;
+        resamplerConfig.OutputRate = format.SampleRate;
+        resamplerConfig.Channels = format.Channels;
+        resamplerConfig.SourceFormat = (channelMix != NULL) ? SAMPLE_FORMAT_FLOAT32 : inputFormat;
+        resamplerConfig.TargetFormat = deviceFormat;
+        resamplerConfig.Quality = (Request->ResamplerQuality == RESAMPLE_QUALITY_DEFAULT)
+                                      ? RESAMPLER_QUALITY_MEDIUM
+                                      : (RESAMPLER_QUALITY)(Request->ResamplerQuality - RESAMPLE_QUALITY_LOW);
+        resamplerConfig.Isa = converter.Isa;
+        
+        status = CreateResampler(&resamplerConfig, &resampler);
+        if (!NT_SUCCESS(status)) {
+            FreeChannelMix(channelMix);
+            return status;
+        }
+    }
+    
+    // El anillo compartido fija la disposición de los frames mientras está
+    // mapeado; el mutex además serializa cambios de formato concurrentes
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (DeviceExtension->SharedRingMdl != NULL) {
+        status = STATUS_DEVICE_BUSY;
+        goto Exit;
+    }
+    
+    // El jitter buffer guarda frames de entrada: se rehace vacío con su tamaño
+    if (DeviceExtension->JitterBuffer != NULL) {
+        jitterConfig = DeviceExtension->JitterConfig;
+        jitterConfig.FrameSize = converter.SourceFrameSize;
+        
+        status = CreateJitterBuffer(&jitterConfig, &jitterBuffer);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+    }
+    
+    // Los envíos en cola están en el formato de entrada anterior
+    FlushPendingWrites(DeviceExtension, NULL);
+    
+    if (format.SampleRate == DeviceExtension->Format.SampleRate &&
+        format.Channels == DeviceExtension->Format.Channels &&
+        format.BitsPerSample == DeviceExtension->Format.BitsPerSample &&
+        format.FormatTag == DeviceExtension->Format.FormatTag) {
+        // Mismo formato de dispositivo: el anillo y las lecturas siguen valiendo.
+        // Las etapas anteriores se liberan fuera del lock.
+        KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+        DeviceExtension->InputConverter = converter;
+        oldChannelMix = DeviceExtension->ChannelMix;
+        DeviceExtension->ChannelMix = channelMix;
+        channelMix = oldChannelMix;
+        oldResampler = DeviceExtension->Resampler;
+        DeviceExtension->Resampler = resampler;
+        resampler = oldResampler;
+        oldJitterBuffer = DeviceExtension->JitterBuffer;
+        DeviceExtension->JitterBuffer = jitterBuffer;
+        jitterBuffer = oldJitterBuffer;
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    } else {
+        // El interpolador de la lectura trabaja con el formato del dispositivo
+        if (DeviceExtension->DriftControl != NULL) {
+            status = CreateDriftControl(&DeviceExtension->DriftConfig, &format, deviceFormat,
+                                        DeviceExtension->Ring.Capacity, &driftControl);
+            if (!NT_SUCCESS(status)) {
+                goto Exit;
+            }
+        }
+        
+        // Igual la cadena: se rediseña para la frecuencia y los canales nuevos
+        if (DeviceExtension->DspChain != NULL) {
+            status = CreateDspChain(&DeviceExtension->DspConfig, &format, deviceFormat, &dspChain);
+            if (!NT_SUCCESS(status)) {
+                goto Exit;
+            }
+        }
+        
+        // Una lectura en cola esperaría frames de otro tamaño
+        FlushPendingReads(DeviceExtension, NULL);
+        
+        status = ReformatAudioBuffer(DeviceExtension, &format, &converter, channelMix, resampler,
+                                     jitterBuffer, driftControl, dspChain);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+        
+        // El dispositivo se ha quedado con ellas
+        channelMix = NULL;
+        resampler = NULL;
+        jitterBuffer = NULL;
+        driftControl = NULL;
+        dspChain = NULL;
+    }
+    
+    DEBUG_PRINT("Audio format set - SampleRate: %lu, Channels: %u, Bits: %u, Tag: %u, Input: %u/%u, %lu ch at %lu Hz (ISA %u)",
+                format.SampleRate, format.Channels, format.BitsPerSample, format.FormatTag,
+                inputFormat, deviceFormat, inputChannels, inputRate, converter.Isa);
+    
+Exit:
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    // Las etapas que no llegaron a publicarse o las que se acaban de sustituir
+    FreeChannelMix(channelMix);
+    FreeResampler(resampler);
+    FreeJitterBuffer(jitterBuffer);
+    FreeDriftControl(driftControl);
+    FreeDspChain(dspChain);
+    return status;
+}
+
+NTSTATUS SetChannelMix(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_CHANNEL_MIX_REQUEST *Request
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    KIRQL oldIrql;
+    CHANNEL_MIX_CONFIG mixConfig;
+    RESAMPLER_CONFIG resamplerConfig;
+    PSAMPLE_CONVERTER input = &DeviceExtension->InputConverter;
+    PCHANNEL_MIX channelMix = NULL;
+    PCHANNEL_MIX oldChannelMix;
+    PRESAMPLER resampler = NULL;
+    PRESAMPLER oldResampler;
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    // Serializa con SetAudioFormat: formato y etapas solo cambian con este
+    // mutex tomado, así que se pueden leer sin los spinlocks
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    // Una matriz pensada para otro par de canales no se aplica
+    if (Request->InputChannels != input->Channels ||
+        Request->OutputChannels != DeviceExtension->Format.Channels) {
+        status = STATUS_INVALID_DEVICE_STATE;
+        goto Exit;
+    }
+    
+    // Con los mismos canales, AUTO y DIRECT equivalen a no mezclar
+    if (Request->InputChannels != Request->OutputChannels ||
+        (Request->Preset != CHANNEL_MIX_PRESET_AUTO && Request->Preset != CHANNEL_MIX_PRESET_DIRECT)) {
+        RtlZeroMemory(&mixConfig, sizeof(mixConfig));
+        mixConfig.InputChannels = Request->InputChannels;
+        mixConfig.OutputChannels = Request->OutputChannels;
+        mixConfig.SourceFormat = input->SourceFormat;
+        mixConfig.TargetFormat = (DeviceExtension->Resampler != NULL) ? SAMPLE_FORMAT_FLOAT32 : input->TargetFormat;
+        mixConfig.Preset = (CHANNEL_MIX_PRESET)Request->Preset;
+        mixConfig.Isa = input->Isa;
+        RtlCopyMemory(mixConfig.Matrix, Request->Matrix, sizeof(mixConfig.Matrix));
+        
+        status = CreateChannelMix(&mixConfig, &channelMix);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+    }
+    
+    // El conversor de frecuencia recibe float de la mezcla o el formato de
+    // entrada sin ella: si eso cambia se rehace (y arranca desde silencio)
+    if (DeviceExtension->Resampler != NULL &&
+        (channelMix == NULL) != (DeviceExtension->ChannelMix == NULL)) {
+        resamplerConfig = DeviceExtension->Resampler->Config;
+        resamplerConfig.SourceFormat = (channelMix != NULL) ? SAMPLE_FORMAT_FLOAT32 : input->SourceFormat;
+        
+        status = CreateResampler(&resamplerConfig, &resampler);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+    }
+    
+    // Los frames del anillo por frame de entrada no cambian: los envíos en
+    // cola siguen siendo válidos
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    oldChannelMix = DeviceExtension->ChannelMix;
+    DeviceExtension->ChannelMix = channelMix;
+    channelMix = oldChannelMix;
+    if (resampler != NULL) {
+        oldResampler = DeviceExtension->Resampler;
+        DeviceExtension->Resampler = resampler;
+        resampler = oldResampler;
+    }
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    DEBUG_PRINT("Channel mix set - %lu -> %lu channels, preset %lu",
+                Request->InputChannels, Request->OutputChannels, Request->Preset);
+    
+Exit:
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    FreeChannelMix(channelMix);
+    FreeResampler(resampler);
+    return status;
+}
+
+NTSTATUS SetJitterBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_JITTER_BUFFER_REQUEST *Request,
+    _Out_ PJITTER_BUFFER_STATS Stats
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    KIRQL oldIrql;
+    JITTER_BUFFER_CONFIG config;
+    PJITTER_BUFFER jitterBuffer = NULL;
+    PJITTER_BUFFER oldJitterBuffer;
+    
+    RtlZeroMemory(Stats, sizeof(JITTER_BUFFER_STATS));
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    config.FrameSize = 0;
+    config.MinDelay = Request->MinDelayFrames;
+    config.MaxDelay = (Request->MaxDelayFrames == 0) ? DEFAULT_JITTER_MAX_DELAY_FRAMES : Request->MaxDelayFrames;
+    config.Percentile = (Request->Percentile == 0) ? DEFAULT_JITTER_PERCENTILE : Request->Percentile;
+    
+    // Serializa con SetAudioFormat, que rehace el jitter buffer con JitterConfig
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (Request->Mode == JITTER_BUFFER_MODE_ENABLE) {
+        config.FrameSize = DeviceExtension->InputConverter.SourceFrameSize;
+        
+        status = CreateJitterBuffer(&config, &jitterBuffer);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+        
+        // Los envíos en cola se escribirían sin pasar por él
+        FlushPendingWrites(DeviceExtension, NULL);
+    }
+    
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    if (DeviceExtension->JitterBuffer != NULL) {
+        JitterBufferGetStats(DeviceExtension->JitterBuffer, Stats);
+    }
+    if (Request->Mode != JITTER_BUFFER_MODE_QUERY) {
+        oldJitterBuffer = DeviceExtension->JitterBuffer;
+        DeviceExtension->JitterBuffer = jitterBuffer;
+        jitterBuffer = oldJitterBuffer;
+    }
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    if (Request->Mode == JITTER_BUFFER_MODE_ENABLE) {
+        DeviceExtension->JitterConfig = config;
+        DEBUG_PRINT("Jitter buffer enabled - delay %lu..%lu frames, percentile %lu",
+                    config.MinDelay, config.MaxDelay, config.Percentile);
+    }
+    
+Exit:
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    FreeJitterBuffer(jitterBuffer);
+    return status;
+}
+
+NTSTATUS SetDriftControl(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_DRIFT_CONTROL_REQUEST *Request,
+    _Out_ PDRIFT_CONTROL_STATS Stats
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    KIRQL oldIrql;
+    PDRIFT_CONTROL driftControl = NULL;
+    PDRIFT_CONTROL oldDriftControl;
+    
+    RtlZeroMemory(Stats, sizeof(DRIFT_CONTROL_STATS));
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    // Serializa con SetAudioFormat, que rehace el lazo con DriftConfig
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (Request->Mode == DRIFT_CONTROL_MODE_ENABLE) {
+        if (Request->TargetFillFrames >= DeviceExtension->Ring.Capacity) {
+            status = STATUS_INVALID_PARAMETER;
+            goto Exit;
+        }
+        
+        status = CreateDriftControl(Request, &DeviceExtension->Format, DeviceExtension->InputConverter.TargetFormat,
+                                    DeviceExtension->Ring.Capacity, &driftControl);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+    }
+    
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    if (DeviceExtension->DriftControl != NULL) {
+        DriftControlGetStats(DeviceExtension->DriftControl, Stats);
+    }
+    if (Request->Mode != DRIFT_CONTROL_MODE_QUERY) {
+        oldDriftControl = DeviceExtension->DriftControl;
+        DeviceExtension->DriftControl = driftControl;
+        driftControl = oldDriftControl;
+    }
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    
+    if (Request->Mode == DRIFT_CONTROL_MODE_ENABLE) {
+        DeviceExtension->DriftConfig = *Request;
+        DEBUG_PRINT("Drift control enabled - target %lu frames, %lu ppm, response %lu frames",
+                    Request->TargetFillFrames, Request->MaxCorrectionPpm, Request->ResponseFrames);
+    }
+    
+Exit:
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    FreeDriftControl(driftControl);
+    return status;
+}
+
+NTSTATUS SetDspChain(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const SET_DSP_CHAIN_REQUEST *Request,
+    _Out_ PDSP_CHAIN_STATS Stats
+)
+{
+    NTSTATUS status = STATUS_SUCCESS;
+    KIRQL oldIrql;
+    PDSP_CHAIN dspChain = NULL;
+    PDSP_CHAIN oldDspChain;
+    
+    RtlZeroMemory(Stats, sizeof(DSP_CHAIN_STATS));
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    // Serializa con SetAudioFormat, que rehace la cadena con DspConfig
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (Request->Mode == DSP_CHAIN_MODE_ENABLE) {
+        status = CreateDspChain(Request, &DeviceExtension->Format, DeviceExtension->InputConverter.TargetFormat,
+                                &dspChain);
+        if (!NT_SUCCESS(status)) {
+            goto Exit;
+        }
+    }
+    
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    if (DeviceExtension->DspChain != NULL) {
+        DspChainGetStats(DeviceExtension->DspChain, Stats);
+    }
+    if (Request->Mode != DSP_CHAIN_MODE_QUERY) {
+        oldDspChain = DeviceExtension->DspChain;
+        DeviceExtension->DspChain = dspChain;
+        dspChain = oldDspChain;
+    }
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    
+    if (Request->Mode == DSP_CHAIN_MODE_ENABLE) {
+        DeviceExtension->DspConfig = *Request;
+        DEBUG_PRINT("DSP chain enabled - %lu stages, latency %lu frames",
+                    Request->Stages, DeviceExtension->DspChain->LatencyFrames);
+    }
+    
+Exit:
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    FreeDspChain(dspChain);
+    return status;
+}
+
+NTSTATUS SetMetering(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const METERING_REQUEST *Request,
+    _Out_ PLEVEL_METER_SNAPSHOT Snapshot
+)
+{
+    KIRQL oldIrql;
+    
+    if (!DeviceExtension->IsInitialized || DeviceExtension->AudioBuffer == NULL) {
+        RtlZeroMemory(Snapshot, sizeof(LEVEL_METER_SNAPSHOT));
+        return STATUS_DEVICE_NOT_READY;
+    }
     
-    DEBUG_PRINT("Audio format set - SampleRate: %lu, Channels: %u, Bits: %u",
-                SampleRate, Channels, BitsPerSample);
+    // Los escritores acumulan con ProducerLock: la ventana se lee y se vacía entera
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    
+    LevelMeterGetSnapshot(&DeviceExtension->LevelMeter, Snapshot);
+    
+    if (Request->Mode != METERING_MODE_QUERY) {
+        DeviceExtension->MeteringEnabled = (Request->Mode == METERING_MODE_ENABLE) ? TRUE : FALSE;
+    }
+    
+    if (Request->Mode != METERING_MODE_QUERY || (Request->Flags & METERING_FLAG_RESET) != 0) {
+        LevelMeterReset(&DeviceExtension->LevelMeter);
+    }
+    
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
     
     return STATUS_SUCCESS;
 }
 
+VOID GetLatencyStats(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _Out_ PLATENCY_STATS Stats
+)
+{
+    PLATENCY_HISTOGRAM histogram = &DeviceExtension->Latency;
+    KIRQL oldIrql;
+    
+    // Los lectores anotan con ConsumerLock: la ventana se lee y se vacía entera
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    
+    Stats->Count = histogram->Count;
+    Stats->P50Us = LatencyHistogramGetPercentile(histogram, 500000);
+    Stats->P99Us = LatencyHistogramGetPercentile(histogram, 990000);
+    Stats->P999Us = LatencyHistogramGetPercentile(histogram, 999000);
+    Stats->MaxUs = histogram->Max;
+    LatencyHistogramReset(histogram);
+    
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+}
+
 VOID GetCurrentAudioFormat(
     _In_ PDEVICE_EXTENSION DeviceExtension,
     _Out_ PAUDIO_FORMAT Format
 )
 {
+    KIRQL oldIrql;
+    
     if (Format == NULL) {
         return;
     }
     
-    // Formato por defecto
-    Format->SampleRate = DEFAULT_SAMPLE_RATE;
-    Format->Channels = DEFAULT_CHANNELS;
-    Format->BitsPerSample = DEFAULT_BITS_PER_SAMPLE;
-    Format->BlockAlign = (DEFAULT_CHANNELS * DEFAULT_BITS_PER_SAMPLE) / 8;
-    Format->BytesPerSecond = DEFAULT_SAMPLE_RATE * Format->BlockAlign;
-    Format->FormatTag = 1; // WAVE_FORMAT_PCM
+    // SetAudioFormat lo sustituye entero bajo ambos locks; aquí basta el consumidor
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    *Format = DeviceExtension->Format;
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
 }
 
-ULONG GetBufferFreeSpace(
-    _In_ PDEVICE_EXTENSION DeviceExtension
+NTSTATUS SetOutputGain(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ float Gain,
+    _In_ ULONG RampFrames
 )
 {
-    ULONG usedSpace;
-    ULONG freeSpace;
+    KIRQL oldIrql;
     
-    if (DeviceExtension->WritePosition >= DeviceExtension->ReadPosition) {
-        usedSpace = DeviceExtension->WritePosition - DeviceExtension->ReadPosition;
-    } else {
-        usedSpace = DeviceExtension->BufferSize - DeviceExtension->ReadPosition + 
-                    DeviceExtension->WritePosition;
+    if (!GainRampIsValidGain(Gain) || RampFrames > GAIN_RAMP_MAX_FRAMES) {
+        return STATUS_INVALID_PARAMETER;
     }
     
-    freeSpace = DeviceExtension->BufferSize - usedSpace - 1; // Dejar 1 byte de espacio
-    return freeSpace;
+    // La rampa la recorren las lecturas, que ya están serializadas por este lock
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    DeviceExtension->Gain = Gain;
+    DeviceExtension->GainRampFrames = RampFrames;
+    if (!DeviceExtension->Muted) {
+        GainRampSetTarget(&DeviceExtension->OutputGain, Gain, RampFrames);
+    }
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    
+    return STATUS_SUCCESS;
 }
 
-ULONG GetBufferUsedSpace(
-    _In_ PDEVICE_EXTENSION DeviceExtension
+VOID SetOutputMute(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ BOOLEAN Mute
 )
 {
-    ULONG usedSpace;
+    KIRQL oldIrql;
     
-    if (DeviceExtension->WritePosition >= DeviceExtension->ReadPosition) {
-        usedSpace = DeviceExtension->WritePosition - DeviceExtension->ReadPosition;
-    } else {
-        usedSpace = DeviceExtension->BufferSize - DeviceExtension->ReadPosition + 
-                    DeviceExtension->WritePosition;
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    if (DeviceExtension->Muted != Mute) {
+        DeviceExtension->Muted = Mute;
+        GainRampSetTarget(&DeviceExtension->OutputGain,
+                          Mute ? 0.0f : DeviceExtension->Gain,
+                          DeviceExtension->GainRampFrames);
     }
-    
-    return usedSpace;
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+}
+
+ULONG GetBufferFreeFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    return RingBufferGetFreeFrames(&DeviceExtension->Ring);
+}
+
+ULONG GetBufferUsedFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    return RingBufferGetUsedFrames(&DeviceExtension->Ring);
+}
+
+ULONG GetBufferCapacityFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    return DeviceExtension->Ring.Capacity;
 }
 
 BOOLEAN IsBufferEmpty(
     _In_ PDEVICE_EXTENSION DeviceExtension
 )
 {
-    return DeviceExtension->WritePosition == DeviceExtension->ReadPosition;
+    return GetBufferUsedFrames(DeviceExtension) == 0;
 }
 
 BOOLEAN IsBufferFull(
     _In_ PDEVICE_EXTENSION DeviceExtension
 )
 {
-    return GetBufferFreeSpace(DeviceExtension) == 0;
+    return GetBufferFreeFrames(DeviceExtension) == 0;
 }
\ No newline at end of file
@@ -0,0 +1,498 @@
+#include "channel_mix.h"
+
+#if defined(VMIC_ARCH_X64)
+#include <emmintrin.h>
+#endif
+
+// Los núcleos SSE2 procesan 4 frames por vuelta y dejan la cola al escalar.
+// Como en resampler.c, SSE2 no necesita guardar estado extendido en el kernel.
+
+#define CHANNEL_MIX_MINUS_3DB 0.70710678118654752
+
+// Ganancias de las mezclas ITU-R BS.775 (centro y envolventes a -3 dB)
+// normalizadas para que cada salida sume 1 y no sature con señal a fondo de escala
+#define CHANNEL_MIX_51_FRONT  (1.0 / (1.0 + 2.0 * CHANNEL_MIX_MINUS_3DB))
+#define CHANNEL_MIX_51_OTHER  (CHANNEL_MIX_MINUS_3DB * CHANNEL_MIX_51_FRONT)
+#define CHANNEL_MIX_71_FRONT  (1.0 / (1.0 + 3.0 * CHANNEL_MIX_MINUS_3DB))
+#define CHANNEL_MIX_71_OTHER  (CHANNEL_MIX_MINUS_3DB * CHANNEL_MIX_71_FRONT)
+
+// Posiciones de WAVEFORMATEXTENSIBLE
+#define CHANNEL_FL  0
+#define CHANNEL_FR  1
+#define CHANNEL_FC  2
+#define CHANNEL_LFE 3
+#define CHANNEL_BL  4
+#define CHANNEL_BR  5
+#define CHANNEL_SL  6
+#define CHANNEL_SR  7
+
+// Referencia: también termina la cola de los núcleos vectoriales
+static VOID ChannelMixScalar(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+)
+{
+    ULONG inputs = Mix->InputChannels;
+    ULONG outputs = Mix->OutputChannels;
+    const float *row;
+    float sum;
+    ULONG frame;
+    ULONG output;
+    ULONG input;
+
+    for (frame = 0; frame < Frames; frame++) {
+        for (output = 0; output < outputs; output++) {
+            row = Mix->Matrix[output];
+            sum = row[0] * Source[0];
+            for (input = 1; input < inputs; input++) {
+                sum += row[input] * Source[input];
+            }
+            Target[output] = sum;
+        }
+
+        Source += inputs;
+        Target += outputs;
+    }
+}
+
+#if defined(VMIC_ARCH_X64)
+static VOID ChannelMixMonoToStereoSse2(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+)
+{
+    __m128 gainLeft = _mm_set1_ps(Mix->Matrix[0][0]);
+    __m128 gainRight = _mm_set1_ps(Mix->Matrix[1][0]);
+    __m128 mono;
+    __m128 left;
+    __m128 right;
+    ULONG frame;
+
+    for (frame = 0; frame + 4 <= Frames; frame += 4) {
+        mono = _mm_loadu_ps(Source + frame);
+        left = _mm_mul_ps(mono, gainLeft);
+        right = _mm_mul_ps(mono, gainRight);
+        _mm_storeu_ps(Target + 2 * frame, _mm_unpacklo_ps(left, right));
+        _mm_storeu_ps(Target + 2 * frame + 4, _mm_unpackhi_ps(left, right));
+    }
+
+    ChannelMixScalar(Mix, Target + 2 * frame, Source + frame, Frames - frame);
+}
+
+static VOID ChannelMixStereoToMonoSse2(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+)
+{
+    __m128 gainLeft = _mm_set1_ps(Mix->Matrix[0][0]);
+    __m128 gainRight = _mm_set1_ps(Mix->Matrix[0][1]);
+    __m128 low;
+    __m128 high;
+    __m128 left;
+    __m128 right;
+    ULONG frame;
+
+    for (frame = 0; frame + 4 <= Frames; frame += 4) {
+        low = _mm_loadu_ps(Source + 2 * frame);
+        high = _mm_loadu_ps(Source + 2 * frame + 4);
+        left = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+        right = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(Target + frame, _mm_add_ps(_mm_mul_ps(left, gainLeft), _mm_mul_ps(right, gainRight)));
+    }
+
+    ChannelMixScalar(Mix, Target + frame, Source + 2 * frame, Frames - frame);
+}
+
+// Traspone 4 frames intercalados de Channels (6 u 8) canales a un vector por canal
+static inline VOID LoadPlanes(const float *Source, ULONG Channels, __m128 *Planes)
+{
+    __m128 low;
+    __m128 high;
+
+    Planes[0] = _mm_loadu_ps(Source);
+    Planes[1] = _mm_loadu_ps(Source + Channels);
+    Planes[2] = _mm_loadu_ps(Source + 2 * Channels);
+    Planes[3] = _mm_loadu_ps(Source + 3 * Channels);
+    _MM_TRANSPOSE4_PS(Planes[0], Planes[1], Planes[2], Planes[3]);
+
+    if (Channels == 8) {
+        Planes[4] = _mm_loadu_ps(Source + 4);
+        Planes[5] = _mm_loadu_ps(Source + Channels + 4);
+        Planes[6] = _mm_loadu_ps(Source + 2 * Channels + 4);
+        Planes[7] = _mm_loadu_ps(Source + 3 * Channels + 4);
+        _MM_TRANSPOSE4_PS(Planes[4], Planes[5], Planes[6], Planes[7]);
+        return;
+    }
+
+    // Canales 4 y 5: parejas de los frames 0-1 y 2-3
+    low = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(Source + 4)),
+                       (const __m64 *)(Source + Channels + 4));
+    high = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64 *)(Source + 2 * Channels + 4)),
+                        (const __m64 *)(Source + 3 * Channels + 4));
+    Planes[4] = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+    Planes[5] = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+// Channels constante en cada llamador: el compilador desenrolla los bucles
+static inline VOID ChannelMixSurroundToStereoSse2(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames,
+    _In_ ULONG Channels
+)
+{
+    __m128 gainLeft[CHANNEL_MIX_MAX_CHANNELS];
+    __m128 gainRight[CHANNEL_MIX_MAX_CHANNELS];
+    __m128 planes[CHANNEL_MIX_MAX_CHANNELS];
+    __m128 left;
+    __m128 right;
+    ULONG channel;
+    ULONG frame;
+
+    for (channel = 0; channel < Channels; channel++) {
+        gainLeft[channel] = _mm_set1_ps(Mix->Matrix[0][channel]);
+        gainRight[channel] = _mm_set1_ps(Mix->Matrix[1][channel]);
+    }
+
+    for (frame = 0; frame + 4 <= Frames; frame += 4) {
+        LoadPlanes(Source + (SIZE_T)frame * Channels, Channels, planes);
+
+        left = _mm_mul_ps(planes[0], gainLeft[0]);
+        right = _mm_mul_ps(planes[0], gainRight[0]);
+        for (channel = 1; channel < Channels; channel++) {
+            left = _mm_add_ps(left, _mm_mul_ps(planes[channel], gainLeft[channel]));
+            right = _mm_add_ps(right, _mm_mul_ps(planes[channel], gainRight[channel]));
+        }
+
+        _mm_storeu_ps(Target + 2 * frame, _mm_unpacklo_ps(left, right));
+        _mm_storeu_ps(Target + 2 * frame + 4, _mm_unpackhi_ps(left, right));
+    }
+
+    ChannelMixScalar(Mix, Target + 2 * frame, Source + (SIZE_T)frame * Channels, Frames - frame);
+}
+
+static VOID ChannelMix51ToStereoSse2(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+)
+{
+    ChannelMixSurroundToStereoSse2(Mix, Target, Source, Frames, 6);
+}
+
+static VOID ChannelMix71ToStereoSse2(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+)
+{
+    ChannelMixSurroundToStereoSse2(Mix, Target, Source, Frames, 8);
+}
+#endif
+
+// El núcleo depende solo de la forma: sirve también para matrices propias
+static CHANNEL_MIX_ROUTINE ChannelMixSelectRoutine(
+    _In_ ULONG InputChannels,
+    _In_ ULONG OutputChannels,
+    _In_ SAMPLE_CONVERT_ISA Isa
+)
+{
+#if defined(VMIC_ARCH_X64)
+    if (Isa != SAMPLE_CONVERT_ISA_SCALAR && OutputChannels == 2) {
+        switch (InputChannels) {
+            case 1:
+                return ChannelMixMonoToStereoSse2;
+            case 6:
+                return ChannelMix51ToStereoSse2;
+            case 8:
+                return ChannelMix71ToStereoSse2;
+        }
+    }
+
+    if (Isa != SAMPLE_CONVERT_ISA_SCALAR && InputChannels == 2 && OutputChannels == 1) {
+        return ChannelMixStereoToMonoSse2;
+    }
+#else
+    UNREFERENCED_PARAMETER(InputChannels);
+    UNREFERENCED_PARAMETER(OutputChannels);
+    UNREFERENCED_PARAMETER(Isa);
+#endif
+
+    return ChannelMixScalar;
+}
+
+VOID ChannelMixGetPresetShape(
+    _In_ CHANNEL_MIX_PRESET Preset,
+    _Out_ PULONG InputChannels,
+    _Out_ PULONG OutputChannels
+)
+{
+    *InputChannels = 0;
+    *OutputChannels = 0;
+
+    switch (Preset) {
+        case CHANNEL_MIX_PRESET_MONO_TO_STEREO:
+            *InputChannels = 1;
+            *OutputChannels = 2;
+            break;
+
+        case CHANNEL_MIX_PRESET_STEREO_TO_MONO:
+            *InputChannels = 2;
+            *OutputChannels = 1;
+            break;
+
+        case CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO:
+            *InputChannels = 6;
+            *OutputChannels = 2;
+            break;
+
+        case CHANNEL_MIX_PRESET_SURROUND71_TO_STEREO:
+            *InputChannels = 8;
+            *OutputChannels = 2;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static CHANNEL_MIX_PRESET ChannelMixGetAutoPreset(
+    _In_ ULONG InputChannels,
+    _In_ ULONG OutputChannels
+)
+{
+    ULONG preset;
+    ULONG inputs;
+    ULONG outputs;
+
+    for (preset = CHANNEL_MIX_PRESET_MONO_TO_STEREO; preset < CHANNEL_MIX_PRESET_DIRECT; preset++) {
+        ChannelMixGetPresetShape((CHANNEL_MIX_PRESET)preset, &inputs, &outputs);
+        if (inputs == InputChannels && outputs == OutputChannels) {
+            return (CHANNEL_MIX_PRESET)preset;
+        }
+    }
+
+    return CHANNEL_MIX_PRESET_DIRECT;
+}
+
+static VOID ChannelMixFillPreset(
+    _Inout_ PCHANNEL_MIX Mix
+)
+{
+    const float front51 = (float)CHANNEL_MIX_51_FRONT;
+    const float other51 = (float)CHANNEL_MIX_51_OTHER;
+    const float front71 = (float)CHANNEL_MIX_71_FRONT;
+    const float other71 = (float)CHANNEL_MIX_71_OTHER;
+    ULONG channel;
+
+    switch (Mix->Preset) {
+        case CHANNEL_MIX_PRESET_MONO_TO_STEREO:
+            Mix->Matrix[0][0] = 1.0f;
+            Mix->Matrix[1][0] = 1.0f;
+            break;
+
+        case CHANNEL_MIX_PRESET_STEREO_TO_MONO:
+            Mix->Matrix[0][0] = 0.5f;
+            Mix->Matrix[0][1] = 0.5f;
+            break;
+
+        case CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO:
+            Mix->Matrix[0][CHANNEL_FL] = front51;
+            Mix->Matrix[0][CHANNEL_FC] = other51;
+            Mix->Matrix[0][CHANNEL_BL] = other51;
+            Mix->Matrix[1][CHANNEL_FR] = front51;
+            Mix->Matrix[1][CHANNEL_FC] = other51;
+            Mix->Matrix[1][CHANNEL_BR] = other51;
+            break;
+
+        case CHANNEL_MIX_PRESET_SURROUND71_TO_STEREO:
+            Mix->Matrix[0][CHANNEL_FL] = front71;
+            Mix->Matrix[0][CHANNEL_FC] = other71;
+            Mix->Matrix[0][CHANNEL_BL] = other71;
+            Mix->Matrix[0][CHANNEL_SL] = other71;
+            Mix->Matrix[1][CHANNEL_FR] = front71;
+            Mix->Matrix[1][CHANNEL_FC] = other71;
+            Mix->Matrix[1][CHANNEL_BR] = other71;
+            Mix->Matrix[1][CHANNEL_SR] = other71;
+            break;
+
+        default:
+            // DIRECT: los canales comunes pasan tal cual
+            for (channel = 0; channel < min(Mix->InputChannels, Mix->OutputChannels); channel++) {
+                Mix->Matrix[channel][channel] = 1.0f;
+            }
+            break;
+    }
+}
+
+NTSTATUS ChannelMixInitialize(
+    _Out_ PCHANNEL_MIX Mix,
+    _In_ const CHANNEL_MIX_CONFIG *Config
+)
+{
+    NTSTATUS status;
+    CHANNEL_MIX_PRESET preset = Config->Preset;
+    ULONG inputs;
+    ULONG outputs;
+    ULONG output;
+    ULONG input;
+    float gain;
+
+    if (Config->InputChannels == 0 || Config->InputChannels > CHANNEL_MIX_MAX_CHANNELS ||
+        Config->OutputChannels == 0 || Config->OutputChannels > CHANNEL_MIX_MAX_CHANNELS ||
+        (ULONG)preset >= CHANNEL_MIX_PRESET_COUNT) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (preset == CHANNEL_MIX_PRESET_AUTO) {
+        preset = ChannelMixGetAutoPreset(Config->InputChannels, Config->OutputChannels);
+    }
+
+    ChannelMixGetPresetShape(preset, &inputs, &outputs);
+    if ((inputs != 0 && inputs != Config->InputChannels) ||
+        (outputs != 0 && outputs != Config->OutputChannels)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    // Comparaciones que también rechazan NaN
+    if (preset == CHANNEL_MIX_PRESET_CUSTOM) {
+        for (output = 0; output < Config->OutputChannels; output++) {
+            for (input = 0; input < Config->InputChannels; input++) {
+                gain = Config->Matrix[output][input];
+                if (!(gain >= -CHANNEL_MIX_MAX_GAIN && gain <= CHANNEL_MIX_MAX_GAIN)) {
+                    return STATUS_INVALID_PARAMETER;
+                }
+            }
+        }
+    }
+
+    status = SampleConverterInitialize(&Mix->Decoder, Config->SourceFormat, SAMPLE_FORMAT_FLOAT32,
+                                       Config->InputChannels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    status = SampleConverterInitialize(&Mix->Encoder, SAMPLE_FORMAT_FLOAT32, Config->TargetFormat,
+                                       Config->OutputChannels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    Mix->InputChannels = Config->InputChannels;
+    Mix->OutputChannels = Config->OutputChannels;
+    Mix->Preset = preset;
+    Mix->Routine = ChannelMixSelectRoutine(Config->InputChannels, Config->OutputChannels, Config->Isa);
+
+    RtlZeroMemory(Mix->Matrix, sizeof(Mix->Matrix));
+    if (preset == CHANNEL_MIX_PRESET_CUSTOM) {
+        for (output = 0; output < Config->OutputChannels; output++) {
+            for (input = 0; input < Config->InputChannels; input++) {
+                Mix->Matrix[output][input] = Config->Matrix[output][input];
+            }
+        }
+    } else {
+        ChannelMixFillPreset(Mix);
+    }
+
+    return STATUS_SUCCESS;
+}
+
+VOID ChannelMixFrames(
+    _In_ const CHANNEL_MIX *Mix,
+    _Out_ float *Target,
+    _In_ const float *Source,
+    _In_ ULONG Frames
+)
+{
+    Mix->Routine(Mix, Target, Source, Frames);
+}
+
+// Bloque a bloque: decodificar, mezclar y codificar (o remuestrear) sobre el
+// anillo. Sin descarte solo se toma la entrada cuya salida cabe.
+static ULONG ChannelMixRun(
+    _Inout_ PCHANNEL_MIX Mix,
+    _Inout_opt_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _In_ BOOLEAN DropOldest,
+    _Out_ PULONG DroppedFrames
+)
+{
+    const UCHAR *source = (const UCHAR *)Source;
+    ULONG consumed = 0;
+    ULONG dropped = 0;
+    ULONG space;
+    ULONG chunk;
+
+    *DroppedFrames = 0;
+
+    while (consumed < Frames) {
+        chunk = min(Frames - consumed, CHANNEL_MIX_BLOCK_FRAMES);
+
+        if (!DropOldest) {
+            space = RingBufferGetFreeFrames(Ring);
+            chunk = min(chunk, (Resampler != NULL) ? ResamplerGetInputFrames(Resampler, space) : space);
+            if (chunk == 0) {
+                break;
+            }
+        }
+
+        SampleConvertFrames(&Mix->Decoder,
+                            Mix->InputBlock,
+                            source + (SIZE_T)consumed * Mix->Decoder.SourceFrameSize,
+                            chunk);
+        Mix->Routine(Mix, Mix->OutputBlock, Mix->InputBlock, chunk);
+
+        if (Resampler != NULL) {
+            if (DropOldest) {
+                ResamplerWriteRingDropOldest(Resampler, Ring, Mix->OutputBlock, chunk, &dropped);
+            } else {
+                ResamplerWriteRing(Resampler, Ring, Mix->OutputBlock, chunk);
+            }
+        } else if (DropOldest) {
+            SampleConvertWriteRingDropOldest(Ring, &Mix->Encoder, Mix->OutputBlock, chunk, &dropped);
+        } else {
+            SampleConvertWriteRing(Ring, &Mix->Encoder, Mix->OutputBlock, chunk);
+        }
+
+        *DroppedFrames += dropped;
+        consumed += chunk;
+    }
+
+    return consumed;
+}
+
+ULONG ChannelMixWriteRing(
+    _Inout_ PCHANNEL_MIX Mix,
+    _Inout_opt_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+)
+{
+    ULONG dropped;
+
+    return ChannelMixRun(Mix, Resampler, Ring, Source, Frames, FALSE, &dropped);
+}
+
+ULONG ChannelMixWriteRingDropOldest(
+    _Inout_ PCHANNEL_MIX Mix,
+    _Inout_opt_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+)
+{
+    return ChannelMixRun(Mix, Resampler, Ring, Source, Frames, TRUE, DroppedFrames);
+}
@@ -0,0 +1,349 @@
+#include "drift_control.h"
+#include "resampler.h"
+
+// La fase de 32 bits se parte en DRIFT_CONTROL_PHASE_BITS bits de fila y el
+// resto como peso de la interpolación lineal entre esa fila y la siguiente.
+// La fila PHASES es la fila 0 desplazada un frame: así la interpolación no
+// necesita tratar aparte el paso de una ventana a la siguiente.
+
+#define DRIFT_ONE             ((ULONG64)1 << 32)
+#define DRIFT_FRACTION_BITS   (32 - DRIFT_CONTROL_PHASE_BITS)
+#define DRIFT_FRACTION_MASK   ((1UL << DRIFT_FRACTION_BITS) - 1)
+#define DRIFT_FRACTION_SCALE  (1.0f / (float)(1UL << DRIFT_FRACTION_BITS))
+#define DRIFT_ATTENUATION     80.0    // dB, como RESAMPLER_QUALITY_MEDIUM
+#define DRIFT_HISTORY_FRAMES  (DRIFT_CONTROL_TAPS + DRIFT_CONTROL_BLOCK_FRAMES)
+
+#define DRIFT_CONTROL_ALIGN(size) (((size) + VMIC_CACHE_LINE - 1) & ~(SIZE_T)(VMIC_CACHE_LINE - 1))
+
+typedef struct _DRIFT_CONTROL_LAYOUT {
+    SIZE_T CoefficientsOffset;
+    SIZE_T HistoryOffset;
+    SIZE_T OutputOffset;
+    SIZE_T Size;
+} DRIFT_CONTROL_LAYOUT;
+
+static BOOLEAN DriftControlGetLayout(
+    _In_ const DRIFT_CONTROL_CONFIG *Config,
+    _Out_ DRIFT_CONTROL_LAYOUT *Layout
+)
+{
+    if (!DriftControlIsValidConfig(Config)) {
+        return FALSE;
+    }
+
+    Layout->CoefficientsOffset = DRIFT_CONTROL_ALIGN(sizeof(DRIFT_CONTROL));
+    Layout->HistoryOffset = Layout->CoefficientsOffset +
+                            DRIFT_CONTROL_ALIGN((SIZE_T)(DRIFT_CONTROL_PHASES + 1) * DRIFT_CONTROL_TAPS * sizeof(float));
+    Layout->OutputOffset = Layout->HistoryOffset +
+                           DRIFT_CONTROL_ALIGN((SIZE_T)DRIFT_HISTORY_FRAMES * Config->Channels * sizeof(float));
+    Layout->Size = Layout->OutputOffset +
+                   DRIFT_CONTROL_ALIGN((SIZE_T)DRIFT_CONTROL_BLOCK_FRAMES * Config->Channels * sizeof(float));
+
+    return TRUE;
+}
+
+BOOLEAN DriftControlIsValidConfig(
+    _In_ const DRIFT_CONTROL_CONFIG *Config
+)
+{
+    return Config->Channels >= 1 && Config->Channels <= DRIFT_CONTROL_MAX_CHANNELS &&
+           Config->Format < SAMPLE_FORMAT_COUNT &&
+           Config->TargetFill > 0 &&
+           Config->MaxCorrectionPpm >= 1 && Config->MaxCorrectionPpm <= DRIFT_CONTROL_MAX_CORRECTION_PPM &&
+           Config->ResponseFrames >= DRIFT_CONTROL_MIN_RESPONSE_FRAMES;
+}
+
+SIZE_T DriftControlGetRequiredSize(
+    _In_ const DRIFT_CONTROL_CONFIG *Config
+)
+{
+    DRIFT_CONTROL_LAYOUT layout;
+
+    return DriftControlGetLayout(Config, &layout) ? layout.Size : 0;
+}
+
+NTSTATUS DriftControlInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const DRIFT_CONTROL_CONFIG *Config,
+    _Out_ PDRIFT_CONTROL *DriftControl
+)
+{
+    NTSTATUS status;
+    DRIFT_CONTROL_LAYOUT layout;
+    PDRIFT_CONTROL driftControl = (PDRIFT_CONTROL)Memory;
+    PUCHAR base = (PUCHAR)Memory;
+    float *coefficients;
+    float *shifted;
+    double sum;
+    double response;
+    ULONG k;
+
+    *DriftControl = NULL;
+
+    if (!DriftControlGetLayout(Config, &layout)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Memory == NULL || Size < layout.Size) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    RtlZeroMemory(driftControl, sizeof(DRIFT_CONTROL));
+
+    status = SampleConverterInitialize(&driftControl->Decoder, Config->Format, SAMPLE_FORMAT_FLOAT32,
+                                       Config->Channels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    status = SampleConverterInitialize(&driftControl->Encoder, SAMPLE_FORMAT_FLOAT32, Config->Format,
+                                       Config->Channels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    driftControl->Config = *Config;
+    driftControl->FrameSize = driftControl->Encoder.TargetFrameSize;
+
+    // Razón 1:1 con PHASES fases: el corte queda justo por debajo de la Nyquist
+    coefficients = (float *)(base + layout.CoefficientsOffset);
+    ResamplerDesignFilter(coefficients, DRIFT_CONTROL_PHASES, DRIFT_CONTROL_PHASES,
+                          DRIFT_CONTROL_TAPS, DRIFT_ATTENUATION);
+
+    shifted = coefficients + (SIZE_T)DRIFT_CONTROL_PHASES * DRIFT_CONTROL_TAPS;
+    shifted[0] = 0.0f;
+    sum = 0.0;
+    for (k = 1; k < DRIFT_CONTROL_TAPS; k++) {
+        shifted[k] = coefficients[k - 1];
+        sum += shifted[k];
+    }
+    for (k = 1; k < DRIFT_CONTROL_TAPS; k++) {
+        shifted[k] = (float)(shifted[k] / sum);
+    }
+
+    driftControl->Coefficients = coefficients;
+    driftControl->History = (float *)(base + layout.HistoryOffset);
+    driftControl->OutputBlock = (float *)(base + layout.OutputOffset);
+
+    response = (double)Config->ResponseFrames;
+    driftControl->ProportionalGain = 2.0 / response;
+    driftControl->IntegralGain = 1.0 / (response * response);
+    driftControl->SmoothingFrames = response / 4.0;
+    driftControl->MaxCorrection = (double)Config->MaxCorrectionPpm * 1e-6;
+
+    DriftControlReset(driftControl);
+
+    *DriftControl = driftControl;
+    return STATUS_SUCCESS;
+}
+
+VOID DriftControlReset(
+    _Inout_ PDRIFT_CONTROL DriftControl
+)
+{
+    // La primera ventana empieza con silencio: basta un frame para la primera salida
+    RtlZeroMemory(DriftControl->History, (SIZE_T)(DRIFT_CONTROL_TAPS - 1) * DriftControl->Config.Channels * sizeof(float));
+    DriftControl->HistoryFrames = DRIFT_CONTROL_TAPS - 1;
+    DriftControl->Position = 0;
+    DriftControl->Step = DRIFT_ONE;
+
+    DriftControl->AverageFill = 0.0;
+    DriftControl->Integral = 0.0;
+    DriftControl->Primed = FALSE;
+
+    DriftControl->Stats.CorrectionPpb = 0;
+    DriftControl->Stats.DriftPpb = 0;
+    DriftControl->Stats.AverageFill = 0;
+}
+
+// Genera en OutputBlock hasta MaxFrames frames con la historia disponible
+static ULONG DriftControlGenerate(
+    _Inout_ PDRIFT_CONTROL DriftControl,
+    _In_ ULONG MaxFrames
+)
+{
+    ULONG channels = DriftControl->Config.Channels;
+    float coefficients[DRIFT_CONTROL_TAPS];
+    float *output = DriftControl->OutputBlock;
+    const float *row;
+    const float *window;
+    float fraction;
+    float sum;
+    ULONG frames = 0;
+    ULONG channel;
+    ULONG k;
+
+    while (frames < MaxFrames &&
+           (DriftControl->Position >> 32) + DRIFT_CONTROL_TAPS <= DriftControl->HistoryFrames) {
+        row = DriftControl->Coefficients +
+              (SIZE_T)((DriftControl->Position >> DRIFT_FRACTION_BITS) & (DRIFT_CONTROL_PHASES - 1)) * DRIFT_CONTROL_TAPS;
+        fraction = (float)(ULONG)(DriftControl->Position & DRIFT_FRACTION_MASK) * DRIFT_FRACTION_SCALE;
+
+        for (k = 0; k < DRIFT_CONTROL_TAPS; k++) {
+            coefficients[k] = row[k] + fraction * (row[k + DRIFT_CONTROL_TAPS] - row[k]);
+        }
+
+        window = DriftControl->History + (SIZE_T)(DriftControl->Position >> 32) * channels;
+
+        for (channel = 0; channel < channels; channel++) {
+            sum = 0.0f;
+            for (k = 0; k < DRIFT_CONTROL_TAPS; k++) {
+                sum += coefficients[k] * window[(SIZE_T)k * channels + channel];
+            }
+            output[channel] = sum;
+        }
+
+        DriftControl->Position += DriftControl->Step;
+        output += channels;
+        frames++;
+    }
+
+    return frames;
+}
+
+// Descarta lo anterior a la próxima ventana y añade del anillo lo que piden
+// las siguientes Frames salidas (como mucho un bloque). Solo se llama cuando
+// la historia ya no alcanza para la próxima salida.
+static ULONG DriftControlRefill(
+    _Inout_ PDRIFT_CONTROL DriftControl,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+)
+{
+    ULONG channels = DriftControl->Config.Channels;
+    ULONG shift = (ULONG)(DriftControl->Position >> 32);
+    ULONG64 last;
+    ULONG needed;
+    ULONG available;
+    PUCHAR region;
+
+    if (shift > 0) {
+        RtlMoveMemory(DriftControl->History,
+                      DriftControl->History + (SIZE_T)shift * channels,
+                      (SIZE_T)(DriftControl->HistoryFrames - shift) * channels * sizeof(float));
+        DriftControl->HistoryFrames -= shift;
+        DriftControl->Position -= (ULONG64)shift << 32;
+    }
+
+    // Justo lo necesario: lo que quede en el anillo sigue contando como llenado
+    last = (DriftControl->Position + (ULONG64)(Frames - 1) * DriftControl->Step) >> 32;
+    needed = (ULONG)min(last + DRIFT_CONTROL_TAPS - DriftControl->HistoryFrames,
+                        (ULONG64)(DRIFT_HISTORY_FRAMES - DriftControl->HistoryFrames));
+
+    available = RingBufferAcquireRead(Ring, &region);
+    available = min(available, needed);
+
+    if (available > 0) {
+        SampleConvertFrames(&DriftControl->Decoder,
+                            DriftControl->History + (SIZE_T)DriftControl->HistoryFrames * channels,
+                            region,
+                            available);
+        RingBufferReleaseRead(Ring, available);
+        DriftControl->HistoryFrames += available;
+        DriftControl->Stats.FramesConsumed += available;
+    }
+
+    return available;
+}
+
+// Un paso del lazo tras Elapsed frames entregados con Fill frames en el anillo
+static VOID DriftControlUpdate(
+    _Inout_ PDRIFT_CONTROL DriftControl,
+    _In_ ULONG Fill,
+    _In_ ULONG Capacity,
+    _In_ ULONG Elapsed
+)
+{
+    ULONG target = (DriftControl->Config.TargetFill < Capacity) ? DriftControl->Config.TargetFill : Capacity / 2;
+    double limit = DriftControl->MaxCorrection;
+    double error;
+    double integral;
+    double correction;
+
+    if (DriftControl->Primed) {
+        DriftControl->AverageFill += ((double)Fill - DriftControl->AverageFill) *
+                                     (double)Elapsed / ((double)Elapsed + DriftControl->SmoothingFrames);
+    } else {
+        DriftControl->AverageFill = (double)Fill;
+        DriftControl->Primed = TRUE;
+    }
+
+    error = DriftControl->AverageFill - (double)target;
+    integral = DriftControl->Integral + DriftControl->IntegralGain * error * (double)Elapsed;
+    correction = DriftControl->ProportionalGain * error + integral;
+
+    // Con la corrección saturada la integral no sigue creciendo en ese sentido:
+    // al llegar al objetivo no habría que deshacerla
+    if (correction > limit) {
+        correction = limit;
+        if (error > 0.0) {
+            integral = DriftControl->Integral;
+        }
+    } else if (correction < -limit) {
+        correction = -limit;
+        if (error < 0.0) {
+            integral = DriftControl->Integral;
+        }
+    }
+
+    DriftControl->Integral = (integral > limit) ? limit : (integral < -limit) ? -limit : integral;
+    DriftControl->Step = (ULONG64)((LONG64)DRIFT_ONE + (LONG64)(correction * (double)DRIFT_ONE));
+
+    DriftControl->Stats.CorrectionPpb = (LONG)(correction * 1e9);
+    DriftControl->Stats.DriftPpb = (LONG)(DriftControl->Integral * 1e9);
+    DriftControl->Stats.AverageFill = (ULONG)DriftControl->AverageFill;
+    DriftControl->Stats.TargetFill = target;
+}
+
+ULONG DriftControlReadRing(
+    _Inout_ PDRIFT_CONTROL DriftControl,
+    _Inout_ PRING_BUFFER Ring,
+    _Out_ PVOID Output,
+    _In_ ULONG Frames
+)
+{
+    PUCHAR output = (PUCHAR)Output;
+    ULONG produced = 0;
+    ULONG frames;
+
+    if (Frames == 0) {
+        return 0;
+    }
+
+    while (produced < Frames) {
+        frames = DriftControlGenerate(DriftControl, min(Frames - produced, (ULONG)DRIFT_CONTROL_BLOCK_FRAMES));
+
+        if (frames > 0) {
+            SampleConvertFrames(&DriftControl->Encoder,
+                                output + (SIZE_T)produced * DriftControl->FrameSize,
+                                DriftControl->OutputBlock,
+                                frames);
+            produced += frames;
+            continue;
+        }
+
+        if (DriftControlRefill(DriftControl, Ring, min(Frames - produced, (ULONG)DRIFT_CONTROL_BLOCK_FRAMES)) == 0) {
+            break;
+        }
+    }
+
+    DriftControl->Stats.FramesProduced += produced;
+
+    // Un anillo vacío es un corte del productor, no deriva: el lazo se congela
+    if (produced == Frames) {
+        DriftControlUpdate(DriftControl, RingBufferGetUsedFrames(Ring), Ring->Capacity, Frames);
+    } else {
+        DriftControl->Stats.ShortReads++;
+    }
+
+    return produced;
+}
+
+VOID DriftControlGetStats(
+    _In_ const DRIFT_CONTROL *DriftControl,
+    _Out_ PDRIFT_CONTROL_STATS Stats
+)
+{
+    *Stats = DriftControl->Stats;
+}
@@ -0,0 +1,350 @@
+#include "dsp_stages.h"
+
+// La cadena ocupa una sola reserva: la DSP_CHAIN, el bloque de trabajo y el
+// contexto de cada etapa, cada uno en su propia línea de caché.
+
+#define DSP_PI     3.14159265358979323846
+#define DSP_LN2    0.69314718055994530942
+#define DSP_LOG2_E 1.44269504088896340736
+#define DSP_LOG2_10 3.32192809488736234787
+
+static const DSP_STAGE_OPS *const g_DspStageOps[DSP_STAGE_TYPE_COUNT] = {
+    &DspEqOps,
+    &DspCompressorOps,
+    &DspLimiterOps,
+};
+
+typedef struct _DSP_CHAIN_LAYOUT {
+    SIZE_T BlockOffset;
+    SIZE_T StageOffset[DSP_CHAIN_MAX_STAGES];
+    SIZE_T Size;
+} DSP_CHAIN_LAYOUT;
+
+// sin(pi * X) sin la CRT: reducción a [-1/2, 1/2] y serie de Taylor
+double DspSinPi(
+    _In_ double X
+)
+{
+    double reduced = X - 2.0 * (double)(LONG64)(X / 2.0 + ((X >= 0.0) ? 0.5 : -0.5));
+    double angle;
+    double term;
+    double sum;
+    ULONG k;
+
+    if (reduced > 0.5) {
+        reduced = 1.0 - reduced;
+    } else if (reduced < -0.5) {
+        reduced = -1.0 - reduced;
+    }
+
+    angle = DSP_PI * reduced;
+    term = angle;
+    sum = angle;
+    for (k = 1; k <= 12; k++) {
+        term *= -angle * angle / (double)((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+
+    return sum;
+}
+
+double DspCosPi(
+    _In_ double X
+)
+{
+    return DspSinPi(X + 0.5);
+}
+
+// Parte entera por debajo y serie de e^(f ln 2) para la fracción f en [0, 1)
+double DspExp2(
+    _In_ double X
+)
+{
+    LONG64 whole = (LONG64)X;
+    double fraction;
+    double term = 1.0;
+    double sum = 1.0;
+    ULONG k;
+
+    if ((double)whole > X) {
+        whole--;
+    }
+
+    fraction = (X - (double)whole) * DSP_LN2;
+    for (k = 1; k <= 20; k++) {
+        term *= fraction / (double)k;
+        sum += term;
+    }
+
+    for (; whole > 0; whole--) {
+        sum *= 2.0;
+    }
+    for (; whole < 0; whole++) {
+        sum *= 0.5;
+    }
+
+    return sum;
+}
+
+double DspDbToGain(
+    _In_ double Db
+)
+{
+    return DspExp2(Db * (DSP_LOG2_10 / 20.0));
+}
+
+float DspSmoothingCoefficient(
+    _In_ float Ms,
+    _In_ ULONG SampleRate
+)
+{
+    double frames = (double)Ms * (double)SampleRate / 1000.0;
+
+    return (float)DspExp2(-DSP_LOG2_E / frames);
+}
+
+static BOOLEAN IsInRange(float Value, float Minimum, float Maximum)
+{
+    // Falso también con NaN
+    return (Value >= Minimum && Value <= Maximum) ? TRUE : FALSE;
+}
+
+BOOLEAN DspStageIsValidConfig(
+    _In_ const DSP_STAGE_CONFIG *Stage
+)
+{
+    const DSP_EQ_BAND *band;
+    ULONG i;
+
+    switch (Stage->Type) {
+    case DSP_STAGE_EQ:
+        if (Stage->Bands == 0 || Stage->Bands > DSP_EQ_MAX_BANDS) {
+            return FALSE;
+        }
+
+        // La frecuencia máxima depende del formato: se comprueba al crear la cadena
+        for (i = 0; i < Stage->Bands; i++) {
+            band = &Stage->Band[i];
+            if (band->Shape >= DSP_EQ_SHAPE_COUNT ||
+                !IsInRange(band->Frequency, 1.0f, 1000000.0f) ||
+                !IsInRange(band->Q, DSP_EQ_MIN_Q, DSP_EQ_MAX_Q) ||
+                !IsInRange(band->GainDb, -DSP_EQ_MAX_GAIN_DB, DSP_EQ_MAX_GAIN_DB)) {
+                return FALSE;
+            }
+        }
+        return TRUE;
+
+    case DSP_STAGE_COMPRESSOR:
+        return IsInRange(Stage->ThresholdDb, DSP_COMPRESSOR_MIN_THRESHOLD_DB, 0.0f) &&
+               IsInRange(Stage->Ratio, 1.0f, DSP_COMPRESSOR_MAX_RATIO) &&
+               IsInRange(Stage->KneeDb, 0.0f, DSP_COMPRESSOR_MAX_KNEE_DB) &&
+               IsInRange(Stage->MakeupDb, 0.0f, DSP_COMPRESSOR_MAX_MAKEUP_DB) &&
+               IsInRange(Stage->AttackMs, DSP_MIN_ATTACK_MS, DSP_MAX_ATTACK_MS) &&
+               IsInRange(Stage->ReleaseMs, DSP_MIN_RELEASE_MS, DSP_MAX_RELEASE_MS);
+
+    case DSP_STAGE_LIMITER:
+        return IsInRange(Stage->CeilingDb, DSP_LIMITER_MIN_CEILING_DB, 0.0f) &&
+               IsInRange(Stage->LookaheadMs, DSP_LIMITER_MIN_LOOKAHEAD_MS, DSP_LIMITER_MAX_LOOKAHEAD_MS) &&
+               IsInRange(Stage->ReleaseMs, DSP_MIN_RELEASE_MS, DSP_MAX_RELEASE_MS);
+
+    default:
+        return FALSE;
+    }
+}
+
+static BOOLEAN DspChainGetLayout(
+    _In_ const DSP_CHAIN_CONFIG *Config,
+    _Out_ DSP_CHAIN_LAYOUT *Layout
+)
+{
+    SIZE_T offset;
+    SIZE_T size;
+    ULONG i;
+
+    if (Config->Channels == 0 || Config->Channels > DSP_CHAIN_MAX_CHANNELS ||
+        Config->Format >= SAMPLE_FORMAT_COUNT ||
+        Config->SampleRate == 0 ||
+        Config->Stages == 0 || Config->Stages > DSP_CHAIN_MAX_STAGES) {
+        return FALSE;
+    }
+
+    Layout->BlockOffset = DSP_CONTEXT_ALIGN(sizeof(DSP_CHAIN));
+    offset = Layout->BlockOffset +
+             DSP_CONTEXT_ALIGN((SIZE_T)DSP_CHAIN_BLOCK_FRAMES * Config->Channels * sizeof(float));
+
+    for (i = 0; i < Config->Stages; i++) {
+        if (!DspStageIsValidConfig(&Config->Stage[i])) {
+            return FALSE;
+        }
+
+        size = g_DspStageOps[Config->Stage[i].Type]->GetRequiredSize(&Config->Stage[i], Config->SampleRate,
+                                                                     Config->Channels);
+        if (size == 0) {
+            return FALSE;
+        }
+
+        Layout->StageOffset[i] = offset;
+        offset += DSP_CONTEXT_ALIGN(size);
+    }
+
+    Layout->Size = offset;
+    return TRUE;
+}
+
+BOOLEAN DspChainIsValidConfig(
+    _In_ const DSP_CHAIN_CONFIG *Config
+)
+{
+    DSP_CHAIN_LAYOUT layout;
+
+    return DspChainGetLayout(Config, &layout);
+}
+
+SIZE_T DspChainGetRequiredSize(
+    _In_ const DSP_CHAIN_CONFIG *Config
+)
+{
+    DSP_CHAIN_LAYOUT layout;
+
+    return DspChainGetLayout(Config, &layout) ? layout.Size : 0;
+}
+
+NTSTATUS DspChainInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const DSP_CHAIN_CONFIG *Config,
+    _Out_ PDSP_CHAIN *Chain
+)
+{
+    NTSTATUS status;
+    DSP_CHAIN_LAYOUT layout;
+    PDSP_CHAIN chain = (PDSP_CHAIN)Memory;
+    PUCHAR base = (PUCHAR)Memory;
+    const DSP_STAGE_OPS *ops;
+    PDSP_STAGE stage;
+    ULONG i;
+
+    *Chain = NULL;
+
+    if (!DspChainGetLayout(Config, &layout)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Memory == NULL || Size < layout.Size) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    // Los contextos se diseñan sobre memoria a cero
+    RtlZeroMemory(Memory, layout.Size);
+
+    status = SampleConverterInitialize(&chain->Decoder, Config->Format, SAMPLE_FORMAT_FLOAT32,
+                                       Config->Channels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    status = SampleConverterInitialize(&chain->Encoder, SAMPLE_FORMAT_FLOAT32, Config->Format,
+                                       Config->Channels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    chain->Config = *Config;
+    chain->FrameSize = chain->Encoder.TargetFrameSize;
+    chain->Block = (float *)(base + layout.BlockOffset);
+
+    for (i = 0; i < Config->Stages; i++) {
+        ops = g_DspStageOps[Config->Stage[i].Type];
+        stage = &chain->Stage[i];
+
+        stage->Type = (DSP_STAGE_TYPE)Config->Stage[i].Type;
+        stage->Process = ops->Process;
+        stage->Context = base + layout.StageOffset[i];
+
+        ops->Initialize(stage->Context, &Config->Stage[i], Config->SampleRate, Config->Channels, Config->Isa);
+        chain->LatencyFrames += ops->GetLatency(stage->Context);
+    }
+
+    chain->Idle = TRUE;
+
+    *Chain = chain;
+    return STATUS_SUCCESS;
+}
+
+VOID DspChainReset(
+    _Inout_ PDSP_CHAIN Chain
+)
+{
+    ULONG i;
+
+    // Las líneas de retardo pueden ser grandes: solo se borran si se usaron
+    if (Chain->Idle) {
+        return;
+    }
+
+    for (i = 0; i < Chain->Config.Stages; i++) {
+        g_DspStageOps[Chain->Stage[i].Type]->Reset(Chain->Stage[i].Context);
+    }
+
+    Chain->Idle = TRUE;
+}
+
+VOID DspChainProcess(
+    _Inout_ PDSP_CHAIN Chain,
+    _Inout_ PVOID Data,
+    _In_ ULONG Frames
+)
+{
+    PUCHAR data = (PUCHAR)Data;
+    BOOLEAN native = (Chain->Config.Format == SAMPLE_FORMAT_FLOAT32) ? TRUE : FALSE;
+    float *block = Chain->Block;
+    ULONG frames;
+    ULONG i;
+
+    if (Frames == 0) {
+        return;
+    }
+
+    Chain->Idle = FALSE;
+    Chain->FramesProcessed += Frames;
+
+    while (Frames > 0) {
+        frames = min(Frames, DSP_CHAIN_BLOCK_FRAMES);
+
+        // En float32 las etapas trabajan directamente sobre los datos
+        if (native) {
+            block = (float *)data;
+        } else {
+            SampleConvertFrames(&Chain->Decoder, block, data, frames);
+        }
+
+        for (i = 0; i < Chain->Config.Stages; i++) {
+            Chain->Stage[i].Process(Chain->Stage[i].Context, block, frames);
+        }
+
+        if (!native) {
+            SampleConvertFrames(&Chain->Encoder, data, block, frames);
+        }
+
+        data += (SIZE_T)frames * Chain->FrameSize;
+        Frames -= frames;
+    }
+}
+
+VOID DspChainGetStats(
+    _In_ const DSP_CHAIN *Chain,
+    _Out_ PDSP_CHAIN_STATS Stats
+)
+{
+    ULONG i;
+
+    RtlZeroMemory(Stats, sizeof(DSP_CHAIN_STATS));
+
+    Stats->FramesProcessed = Chain->FramesProcessed;
+    Stats->LatencyFrames = Chain->LatencyFrames;
+    Stats->Stages = Chain->Config.Stages;
+
+    for (i = 0; i < Chain->Config.Stages; i++) {
+        Stats->GainReductionDb[i] = g_DspStageOps[Chain->Stage[i].Type]->GetGainReduction(Chain->Stage[i].Context);
+    }
+}
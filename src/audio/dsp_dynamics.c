@@ -0,0 +1,807 @@
+#include "dsp_stages.h"
+
+#if defined(VMIC_ARCH_X64)
+#include <emmintrin.h>
+#endif
+
+// Compresor y limitador. Los dos siguen el mismo esquema por bloque: el pico
+// de cada frame (máximo entre canales: los canales van enlazados y la imagen
+// no se mueve), una ganancia por frame y su aplicación a todos los canales.
+// El pico, la curva en dB, los logaritmos y exponenciales y la aplicación de
+// la ganancia son vectoriales (4 frames o 1 frame por registro); solo el
+// suavizado de la ganancia, que es una recursión, recorre el bloque en escalar
+// sobre un array de DSP_CHAIN_BLOCK_FRAMES valores.
+//
+// log2 y 2^x se aproximan sin la CRT con polinomios (error por debajo de
+// 0,001 dB) que evalúan las mismas operaciones en escalar y en SSE2.
+
+#define DSP_DB_PER_OCTAVE   6.0205999132796239f   // 20 log10(2)
+#define DSP_OCTAVES_PER_DB  0.16609640474436813f  // 1 / DSP_DB_PER_OCTAVE
+#define DSP_MIN_LEVEL       1e-10f                // -200 dB: evita log2(0)
+#define DSP_MAX_EXPONENT    126.0f
+
+// log2(m) = (2 / ln 2) * atanh(t), t = (m - 1) / (m + 1) en [0, 1/3)
+#define DSP_LOG2_C1 2.8853900817779268f
+#define DSP_LOG2_C3 0.9617966939259756f
+#define DSP_LOG2_C5 0.5770780163555854f
+#define DSP_LOG2_C7 0.4121985831111324f
+
+// 2^f = e^(f ln 2) en [0, 1): Taylor de grado 6
+#define DSP_EXP2_C1 0.6931471805599453f
+#define DSP_EXP2_C2 0.2402265069591007f
+#define DSP_EXP2_C3 0.0555041086648216f
+#define DSP_EXP2_C4 0.0096181291076285f
+#define DSP_EXP2_C5 0.0013333558146428f
+#define DSP_EXP2_C6 0.0001540353039338f
+
+// Por debajo de esto el suavizado se da por terminado (los restos decaerían
+// hasta desnormales)
+#define DSP_SETTLED_DB   1e-6f
+#define DSP_SETTLED_GAIN 1e-7f
+
+typedef struct _DSP_COMPRESSOR {
+    ULONG Channels;
+    SAMPLE_CONVERT_ISA Isa;
+    float Threshold;      // dB
+    float Slope;          // 1 - 1 / Ratio
+    float HalfKnee;       // dB
+    float KneeFactor;     // Slope / (2 * Knee); 0 sin rodilla
+    float Makeup;         // dB
+    float Attack;         // Coeficientes por frame
+    float Release;
+    float Reduction;      // dB, estado del suavizado
+    float Frame[DSP_CHAIN_BLOCK_FRAMES];  // Pico -> reducción -> ganancia de cada frame
+} DSP_COMPRESSOR, *PDSP_COMPRESSOR;
+
+typedef struct _DSP_LIMITER {
+    ULONG Channels;
+    SAMPLE_CONVERT_ISA Isa;
+    float Ceiling;        // Lineal
+    float Release;        // Coeficiente por frame
+    ULONG Lookahead;      // Retardo en frames
+    ULONG Window;         // Lookahead + 1
+
+    // Mínimo deslizante de la ganancia necesaria: cola monótona creciente
+    ULONG Position;       // Frames procesados (módulo 2^32)
+    ULONG QueueHead;
+    ULONG QueueCount;
+    PULONG QueueFrames;
+    float *QueueGains;
+
+    // Relajación y media móvil de Window frames
+    float Held;
+    double Sum;
+    float *History;
+    ULONG HistoryPosition;
+    float Gain;           // La del último frame (estadísticas)
+
+    float *Delay;         // Lookahead frames intercalados (anillo)
+    ULONG DelayPosition;
+
+    float Frame[DSP_CHAIN_BLOCK_FRAMES];  // Pico -> ganancia de cada frame
+} DSP_LIMITER, *PDSP_LIMITER;
+
+typedef struct _DSP_LIMITER_LAYOUT {
+    ULONG Lookahead;
+    SIZE_T QueueFramesOffset;
+    SIZE_T QueueGainsOffset;
+    SIZE_T HistoryOffset;
+    SIZE_T DelayOffset;
+    SIZE_T Size;
+} DSP_LIMITER_LAYOUT;
+
+static inline float FloatFromBits(ULONG Bits)
+{
+    float value;
+
+    RtlCopyMemory(&value, &Bits, sizeof(value));
+    return value;
+}
+
+static inline ULONG BitsFromFloat(float Value)
+{
+    ULONG bits;
+
+    RtlCopyMemory(&bits, &Value, sizeof(bits));
+    return bits;
+}
+
+// Value normal y positivo
+static inline float Log2Scalar(float Value)
+{
+    ULONG bits = BitsFromFloat(Value);
+    float exponent = (float)((LONG)(bits >> 23) - 127);
+    float mantissa = FloatFromBits((bits & 0x007FFFFF) | 0x3F800000);
+    float t = (mantissa - 1.0f) / (mantissa + 1.0f);
+    float t2 = t * t;
+
+    return exponent + t * (DSP_LOG2_C1 + t2 * (DSP_LOG2_C3 + t2 * (DSP_LOG2_C5 + t2 * DSP_LOG2_C7)));
+}
+
+static inline float Exp2Scalar(float Value)
+{
+    float whole;
+    float fraction;
+    float power;
+
+    Value = (Value < DSP_MAX_EXPONENT) ? Value : DSP_MAX_EXPONENT;
+    Value = (Value > -DSP_MAX_EXPONENT) ? Value : -DSP_MAX_EXPONENT;
+
+    // Parte entera por debajo (CVTTPS2DQ trunca hacia cero)
+    whole = (float)(LONG)Value;
+    if (Value < whole) {
+        whole -= 1.0f;
+    }
+
+    fraction = Value - whole;
+    power = 1.0f + fraction * (DSP_EXP2_C1 + fraction * (DSP_EXP2_C2 + fraction * (DSP_EXP2_C3 +
+            fraction * (DSP_EXP2_C4 + fraction * (DSP_EXP2_C5 + fraction * DSP_EXP2_C6)))));
+
+    return power * FloatFromBits((ULONG)((LONG)whole + 127) << 23);
+}
+
+static inline float AbsScalar(float Value)
+{
+    return FloatFromBits(BitsFromFloat(Value) & 0x7FFFFFFF);
+}
+
+static VOID FramePeaksScalar(const float *Block, ULONG Channels, ULONG Frames, float *Peaks)
+{
+    float peak;
+    float sample;
+    ULONG i;
+    ULONG channel;
+
+    for (i = 0; i < Frames; i++) {
+        peak = 0.0f;
+        for (channel = 0; channel < Channels; channel++) {
+            sample = AbsScalar(Block[(SIZE_T)i * Channels + channel]);
+            peak = (sample > peak) ? sample : peak;
+        }
+        Peaks[i] = peak;
+    }
+}
+
+static VOID ApplyGainsScalar(float *Block, ULONG Channels, ULONG Frames, const float *Gains)
+{
+    ULONG i;
+    ULONG channel;
+
+    for (i = 0; i < Frames; i++) {
+        for (channel = 0; channel < Channels; channel++) {
+            Block[(SIZE_T)i * Channels + channel] *= Gains[i];
+        }
+    }
+}
+
+#if defined(VMIC_ARCH_X64)
+
+static inline __m128 AbsSse2(__m128 Value)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), Value);
+}
+
+// Mismas operaciones que Log2Scalar en 4 carriles
+static inline __m128 Log2Sse2(__m128 Value)
+{
+    __m128i bits = _mm_castps_si128(Value);
+    __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                                                    _mm_set1_epi32(0x3F800000)));
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 t = _mm_div_ps(_mm_sub_ps(mantissa, one), _mm_add_ps(mantissa, one));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 series;
+
+    series = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C5), _mm_mul_ps(t2, _mm_set1_ps(DSP_LOG2_C7)));
+    series = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C3), _mm_mul_ps(t2, series));
+    series = _mm_add_ps(_mm_set1_ps(DSP_LOG2_C1), _mm_mul_ps(t2, series));
+
+    return _mm_add_ps(exponent, _mm_mul_ps(t, series));
+}
+
+static inline __m128 Exp2Sse2(__m128 Value)
+{
+    __m128 whole;
+    __m128 fraction;
+    __m128 power;
+    __m128i exponent;
+
+    Value = _mm_min_ps(Value, _mm_set1_ps(DSP_MAX_EXPONENT));
+    Value = _mm_max_ps(Value, _mm_set1_ps(-DSP_MAX_EXPONENT));
+
+    whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(Value));
+    whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmplt_ps(Value, whole), _mm_set1_ps(1.0f)));
+
+    fraction = _mm_sub_ps(Value, whole);
+    power = _mm_add_ps(_mm_set1_ps(DSP_EXP2_C5), _mm_mul_ps(fraction, _mm_set1_ps(DSP_EXP2_C6)));
+    power = _mm_add_ps(_mm_set1_ps(DSP_EXP2_C4), _mm_mul_ps(fraction, power));
+    power = _mm_add_ps(_mm_set1_ps(DSP_EXP2_C3), _mm_mul_ps(fraction, power));
+    power = _mm_add_ps(_mm_set1_ps(DSP_EXP2_C2), _mm_mul_ps(fraction, power));
+    power = _mm_add_ps(_mm_set1_ps(DSP_EXP2_C1), _mm_mul_ps(fraction, power));
+    power = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(fraction, power));
+
+    exponent = _mm_slli_epi32(_mm_add_epi32(_mm_cvttps_epi32(whole), _mm_set1_epi32(127)), 23);
+    return _mm_mul_ps(power, _mm_castsi128_ps(exponent));
+}
+
+// Máximo de los 4 carriles de cada uno de 4 registros (un frame por registro)
+static inline __m128 HorizontalMax4(__m128 A, __m128 B, __m128 C, __m128 D)
+{
+    _MM_TRANSPOSE4_PS(A, B, C, D);
+    return _mm_max_ps(_mm_max_ps(A, B), _mm_max_ps(C, D));
+}
+
+// 1, 2, 4 y 8 canales de 4 en 4 frames; el resto y la cola en escalar. El
+// máximo no depende del orden: el resultado es el mismo que el escalar.
+static VOID FramePeaksSse2(const float *Block, ULONG Channels, ULONG Frames, float *Peaks)
+{
+    __m128 a;
+    __m128 b;
+    __m128 c;
+    __m128 d;
+    ULONG i = 0;
+
+    switch (Channels) {
+    case 1:
+        for (; i + 4 <= Frames; i += 4) {
+            _mm_storeu_ps(Peaks + i, AbsSse2(_mm_loadu_ps(Block + i)));
+        }
+        break;
+
+    case 2:
+        for (; i + 4 <= Frames; i += 4) {
+            a = AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 2));
+            b = AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 2 + 4));
+            // Pares (L, R) de 4 frames -> máximo de cada par
+            c = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            d = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(Peaks + i, _mm_max_ps(c, d));
+        }
+        break;
+
+    case 4:
+        for (; i + 4 <= Frames; i += 4) {
+            a = AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 4));
+            b = AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 4 + 4));
+            c = AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 4 + 8));
+            d = AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 4 + 12));
+            _mm_storeu_ps(Peaks + i, HorizontalMax4(a, b, c, d));
+        }
+        break;
+
+    case 8:
+        for (; i + 4 <= Frames; i += 4) {
+            a = _mm_max_ps(AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8)),
+                           AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 4)));
+            b = _mm_max_ps(AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 8)),
+                           AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 12)));
+            c = _mm_max_ps(AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 16)),
+                           AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 20)));
+            d = _mm_max_ps(AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 24)),
+                           AbsSse2(_mm_loadu_ps(Block + (SIZE_T)i * 8 + 28)));
+            _mm_storeu_ps(Peaks + i, HorizontalMax4(a, b, c, d));
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    FramePeaksScalar(Block + (SIZE_T)i * Channels, Channels, Frames - i, Peaks + i);
+}
+
+// Una multiplicación por muestra, como en el escalar
+static VOID ApplyGainsSse2(float *Block, ULONG Channels, ULONG Frames, const float *Gains)
+{
+    float *frame;
+    __m128 gains;
+    __m128 gain;
+    ULONG i = 0;
+
+    switch (Channels) {
+    case 1:
+        for (; i + 4 <= Frames; i += 4) {
+            _mm_storeu_ps(Block + i, _mm_mul_ps(_mm_loadu_ps(Block + i), _mm_loadu_ps(Gains + i)));
+        }
+        break;
+
+    case 2:
+        for (; i + 4 <= Frames; i += 4) {
+            frame = Block + (SIZE_T)i * 2;
+            gains = _mm_loadu_ps(Gains + i);
+            _mm_storeu_ps(frame, _mm_mul_ps(_mm_loadu_ps(frame), _mm_unpacklo_ps(gains, gains)));
+            _mm_storeu_ps(frame + 4, _mm_mul_ps(_mm_loadu_ps(frame + 4), _mm_unpackhi_ps(gains, gains)));
+        }
+        break;
+
+    case 4:
+    case 8:
+        for (; i < Frames; i++) {
+            frame = Block + (SIZE_T)i * Channels;
+            gain = _mm_set1_ps(Gains[i]);
+            _mm_storeu_ps(frame, _mm_mul_ps(_mm_loadu_ps(frame), gain));
+            if (Channels == 8) {
+                _mm_storeu_ps(frame + 4, _mm_mul_ps(_mm_loadu_ps(frame + 4), gain));
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    ApplyGainsScalar(Block + (SIZE_T)i * Channels, Channels, Frames - i, Gains + i);
+}
+
+#endif // VMIC_ARCH_X64
+
+static VOID FramePeaks(SAMPLE_CONVERT_ISA Isa, const float *Block, ULONG Channels, ULONG Frames, float *Peaks)
+{
+#if defined(VMIC_ARCH_X64)
+    if (Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        FramePeaksSse2(Block, Channels, Frames, Peaks);
+        return;
+    }
+#else
+    UNREFERENCED_PARAMETER(Isa);
+#endif
+    FramePeaksScalar(Block, Channels, Frames, Peaks);
+}
+
+static VOID ApplyGains(SAMPLE_CONVERT_ISA Isa, float *Block, ULONG Channels, ULONG Frames, const float *Gains)
+{
+#if defined(VMIC_ARCH_X64)
+    if (Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        ApplyGainsSse2(Block, Channels, Frames, Gains);
+        return;
+    }
+#else
+    UNREFERENCED_PARAMETER(Isa);
+#endif
+    ApplyGainsScalar(Block, Channels, Frames, Gains);
+}
+
+//
+// Compresor
+//
+
+// Reducción estática en dB (>= 0) para un pico lineal
+static inline float CompressorCurveScalar(const DSP_COMPRESSOR *Compressor, float Peak)
+{
+    float level = DSP_DB_PER_OCTAVE * Log2Scalar((Peak > DSP_MIN_LEVEL) ? Peak : DSP_MIN_LEVEL);
+    float excess = level - Compressor->Threshold;
+    float knee = excess + Compressor->HalfKnee;
+    float quadratic = Compressor->KneeFactor * knee * knee;
+    float linear = Compressor->Slope * excess;
+
+    if (excess >= Compressor->HalfKnee) {
+        return linear;
+    }
+
+    return (knee > 0.0f) ? quadratic : 0.0f;
+}
+
+static VOID CompressorCurve(PDSP_COMPRESSOR Compressor, ULONG Frames)
+{
+    ULONG i = 0;
+
+#if defined(VMIC_ARCH_X64)
+    __m128 minimum = _mm_set1_ps(DSP_MIN_LEVEL);
+    __m128 threshold = _mm_set1_ps(Compressor->Threshold);
+    __m128 halfKnee = _mm_set1_ps(Compressor->HalfKnee);
+    __m128 kneeFactor = _mm_set1_ps(Compressor->KneeFactor);
+    __m128 slope = _mm_set1_ps(Compressor->Slope);
+    __m128 level;
+    __m128 excess;
+    __m128 knee;
+    __m128 quadratic;
+    __m128 above;
+
+    if (Compressor->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        for (; i + 4 <= Frames; i += 4) {
+            level = _mm_loadu_ps(Compressor->Frame + i);
+            level = _mm_mul_ps(_mm_set1_ps(DSP_DB_PER_OCTAVE), Log2Sse2(_mm_max_ps(level, minimum)));
+            excess = _mm_sub_ps(level, threshold);
+            knee = _mm_add_ps(excess, halfKnee);
+            quadratic = _mm_mul_ps(_mm_mul_ps(kneeFactor, knee), knee);
+            quadratic = _mm_and_ps(_mm_cmpgt_ps(knee, _mm_setzero_ps()), quadratic);
+            above = _mm_cmpge_ps(excess, halfKnee);
+            _mm_storeu_ps(Compressor->Frame + i, _mm_or_ps(_mm_and_ps(above, _mm_mul_ps(slope, excess)),
+                                                          _mm_andnot_ps(above, quadratic)));
+        }
+    }
+#endif
+
+    for (; i < Frames; i++) {
+        Compressor->Frame[i] = CompressorCurveScalar(Compressor, Compressor->Frame[i]);
+    }
+}
+
+// Reducción en dB -> ganancia lineal con la ganancia de compensación
+static VOID CompressorGains(PDSP_COMPRESSOR Compressor, ULONG Frames)
+{
+    ULONG i = 0;
+
+#if defined(VMIC_ARCH_X64)
+    __m128 makeup = _mm_set1_ps(Compressor->Makeup);
+    __m128 scale = _mm_set1_ps(DSP_OCTAVES_PER_DB);
+    __m128 gain;
+
+    if (Compressor->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        for (; i + 4 <= Frames; i += 4) {
+            gain = _mm_mul_ps(_mm_sub_ps(makeup, _mm_loadu_ps(Compressor->Frame + i)), scale);
+            _mm_storeu_ps(Compressor->Frame + i, Exp2Sse2(gain));
+        }
+    }
+#endif
+
+    for (; i < Frames; i++) {
+        Compressor->Frame[i] = Exp2Scalar((Compressor->Makeup - Compressor->Frame[i]) * DSP_OCTAVES_PER_DB);
+    }
+}
+
+static VOID CompressorProcess(
+    _Inout_ PVOID Context,
+    _Inout_ float *Block,
+    _In_ ULONG Frames
+)
+{
+    PDSP_COMPRESSOR compressor = (PDSP_COMPRESSOR)Context;
+    float reduction = compressor->Reduction;
+    float target;
+    ULONG i;
+
+    FramePeaks(compressor->Isa, Block, compressor->Channels, Frames, compressor->Frame);
+    CompressorCurve(compressor, Frames);
+
+    // Ataque si la reducción crece, relajación si decrece
+    for (i = 0; i < Frames; i++) {
+        target = compressor->Frame[i];
+        reduction = target + ((target > reduction) ? compressor->Attack : compressor->Release) * (reduction - target);
+        compressor->Frame[i] = reduction;
+    }
+
+    compressor->Reduction = (reduction > DSP_SETTLED_DB) ? reduction : 0.0f;
+
+    CompressorGains(compressor, Frames);
+    ApplyGains(compressor->Isa, Block, compressor->Channels, Frames, compressor->Frame);
+}
+
+static SIZE_T CompressorGetRequiredSize(const DSP_STAGE_CONFIG *Stage, ULONG SampleRate, ULONG Channels)
+{
+    UNREFERENCED_PARAMETER(Stage);
+    UNREFERENCED_PARAMETER(SampleRate);
+    UNREFERENCED_PARAMETER(Channels);
+
+    return sizeof(DSP_COMPRESSOR);
+}
+
+static VOID CompressorReset(PVOID Context)
+{
+    ((PDSP_COMPRESSOR)Context)->Reduction = 0.0f;
+}
+
+static VOID CompressorInitialize(PVOID Context, const DSP_STAGE_CONFIG *Stage, ULONG SampleRate,
+                                 ULONG Channels, SAMPLE_CONVERT_ISA Isa)
+{
+    PDSP_COMPRESSOR compressor = (PDSP_COMPRESSOR)Context;
+
+    compressor->Channels = Channels;
+    compressor->Isa = Isa;
+    compressor->Threshold = Stage->ThresholdDb;
+    compressor->Slope = 1.0f - 1.0f / Stage->Ratio;
+    compressor->HalfKnee = Stage->KneeDb / 2.0f;
+    compressor->KneeFactor = (Stage->KneeDb > 0.0f) ? compressor->Slope / (2.0f * Stage->KneeDb) : 0.0f;
+    compressor->Makeup = Stage->MakeupDb;
+    compressor->Attack = DspSmoothingCoefficient(Stage->AttackMs, SampleRate);
+    compressor->Release = DspSmoothingCoefficient(Stage->ReleaseMs, SampleRate);
+
+    CompressorReset(compressor);
+}
+
+static ULONG CompressorGetLatency(const VOID *Context)
+{
+    UNREFERENCED_PARAMETER(Context);
+    return 0;
+}
+
+static float CompressorGetGainReduction(const VOID *Context)
+{
+    return ((const DSP_COMPRESSOR *)Context)->Reduction;
+}
+
+const DSP_STAGE_OPS DspCompressorOps = {
+    CompressorGetRequiredSize,
+    CompressorInitialize,
+    CompressorProcess,
+    CompressorReset,
+    CompressorGetLatency,
+    CompressorGetGainReduction,
+};
+
+//
+// Limitador
+//
+// Con una ventana de W = Lookahead + 1 frames: r(n) es la ganancia que
+// necesita el frame n (techo / pico, como mucho 1), m(n) el mínimo de r en la
+// ventana, h(n) <= m(n) la misma con relajación exponencial al subir y g(n)
+// la media de h en la ventana. Para un pico en el frame p, h <= r(p) en los W
+// frames que van de p a p + Lookahead, así que g(p + Lookahead) <= r(p): con
+// la señal retrasada Lookahead frames, el pico sale ya atenuado. La media
+// hace de ataque suave (sin escalones) y al final se recorta al techo por el
+// redondeo.
+//
+
+static BOOLEAN LimiterGetLayout(const DSP_STAGE_CONFIG *Stage, ULONG SampleRate, ULONG Channels,
+                                DSP_LIMITER_LAYOUT *Layout)
+{
+    double lookahead = (double)Stage->LookaheadMs * (double)SampleRate / 1000.0 + 0.5;
+    ULONG window;
+
+    Layout->Lookahead = (ULONG)lookahead;
+    if (Layout->Lookahead == 0) {
+        Layout->Lookahead = 1;
+    }
+
+    window = Layout->Lookahead + 1;
+
+    Layout->QueueFramesOffset = DSP_CONTEXT_ALIGN(sizeof(DSP_LIMITER));
+    Layout->QueueGainsOffset = Layout->QueueFramesOffset + DSP_CONTEXT_ALIGN((SIZE_T)window * sizeof(ULONG));
+    Layout->HistoryOffset = Layout->QueueGainsOffset + DSP_CONTEXT_ALIGN((SIZE_T)window * sizeof(float));
+    Layout->DelayOffset = Layout->HistoryOffset + DSP_CONTEXT_ALIGN((SIZE_T)window * sizeof(float));
+    Layout->Size = Layout->DelayOffset +
+                   DSP_CONTEXT_ALIGN((SIZE_T)Layout->Lookahead * Channels * sizeof(float));
+
+    return TRUE;
+}
+
+// Ganancia necesaria de cada frame: techo / max(pico, techo)
+static VOID LimiterRequiredGains(PDSP_LIMITER Limiter, ULONG Frames)
+{
+    ULONG i = 0;
+
+#if defined(VMIC_ARCH_X64)
+    __m128 ceiling = _mm_set1_ps(Limiter->Ceiling);
+
+    if (Limiter->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        for (; i + 4 <= Frames; i += 4) {
+            _mm_storeu_ps(Limiter->Frame + i,
+                          _mm_div_ps(ceiling, _mm_max_ps(_mm_loadu_ps(Limiter->Frame + i), ceiling)));
+        }
+    }
+#endif
+
+    for (; i < Frames; i++) {
+        Limiter->Frame[i] = Limiter->Ceiling /
+                            ((Limiter->Frame[i] > Limiter->Ceiling) ? Limiter->Frame[i] : Limiter->Ceiling);
+    }
+}
+
+// Ganancia que se aplica en cada frame (recursión en escalar)
+static VOID LimiterSmoothGains(PDSP_LIMITER Limiter, ULONG Frames)
+{
+    ULONG capacity = Limiter->Window;
+    ULONG position = Limiter->Position;
+    ULONG head = Limiter->QueueHead;
+    ULONG count = Limiter->QueueCount;
+    ULONG back;
+    float held = Limiter->Held;
+    float required;
+    float minimum;
+    float oldest;
+    ULONG i;
+    ULONG k;
+
+    for (i = 0; i < Frames; i++, position++) {
+        required = Limiter->Frame[i];
+
+        // Cola monótona: fuera los valores de atrás que ya no pueden ser el mínimo
+        while (count > 0) {
+            back = head + count - 1;
+            back = (back >= capacity) ? back - capacity : back;
+            if (Limiter->QueueGains[back] < required) {
+                break;
+            }
+            count--;
+        }
+
+        back = head + count;
+        back = (back >= capacity) ? back - capacity : back;
+        Limiter->QueueFrames[back] = position;
+        Limiter->QueueGains[back] = required;
+        count++;
+
+        // Y por delante el que sale de la ventana
+        if (position - Limiter->QueueFrames[head] >= capacity) {
+            head = (head + 1 == capacity) ? 0 : head + 1;
+            count--;
+        }
+
+        minimum = Limiter->QueueGains[head];
+
+        // Baja de golpe (la media suaviza el ataque) y sube con la relajación
+        if (minimum < held) {
+            held = minimum;
+        } else {
+            held = minimum + Limiter->Release * (held - minimum);
+            if (minimum - held < DSP_SETTLED_GAIN) {
+                held = minimum;
+            }
+        }
+
+        oldest = Limiter->History[Limiter->HistoryPosition];
+        Limiter->History[Limiter->HistoryPosition] = held;
+        Limiter->Sum += (double)held - (double)oldest;
+
+        // La suma se rehace en cada vuelta para que los redondeos no se
+        // acumulen: sin picos la ganancia vuelve a ser 1 exacto
+        if (++Limiter->HistoryPosition == capacity) {
+            Limiter->HistoryPosition = 0;
+            Limiter->Sum = 0.0;
+            for (k = 0; k < capacity; k++) {
+                Limiter->Sum += (double)Limiter->History[k];
+            }
+        }
+
+        Limiter->Frame[i] = (float)(Limiter->Sum / (double)capacity);
+    }
+
+    Limiter->Position = position;
+    Limiter->QueueHead = head;
+    Limiter->QueueCount = count;
+    Limiter->Held = held;
+    if (Frames > 0) {
+        Limiter->Gain = Limiter->Frame[Frames - 1];
+    }
+}
+
+// Intercambia el bloque con la línea de retardo: el bloque sale retrasado
+// Lookahead frames y la línea se queda con sus últimos frames
+static VOID LimiterDelay(PDSP_LIMITER Limiter, float *Block, ULONG Frames)
+{
+    ULONG channels = Limiter->Channels;
+    float *delay;
+    float sample;
+    SIZE_T samples;
+    SIZE_T k;
+    ULONG frames;
+
+    while (Frames > 0) {
+        frames = min(Frames, Limiter->Lookahead - Limiter->DelayPosition);
+        delay = Limiter->Delay + (SIZE_T)Limiter->DelayPosition * channels;
+        samples = (SIZE_T)frames * channels;
+        k = 0;
+
+#if defined(VMIC_ARCH_X64)
+        for (; k + 4 <= samples; k += 4) {
+            __m128 line = _mm_loadu_ps(delay + k);
+            _mm_storeu_ps(delay + k, _mm_loadu_ps(Block + k));
+            _mm_storeu_ps(Block + k, line);
+        }
+#endif
+        for (; k < samples; k++) {
+            sample = delay[k];
+            delay[k] = Block[k];
+            Block[k] = sample;
+        }
+
+        Limiter->DelayPosition += frames;
+        if (Limiter->DelayPosition == Limiter->Lookahead) {
+            Limiter->DelayPosition = 0;
+        }
+
+        Block += samples;
+        Frames -= frames;
+    }
+}
+
+static VOID LimiterClamp(PDSP_LIMITER Limiter, float *Block, SIZE_T Samples)
+{
+    float ceiling = Limiter->Ceiling;
+    float sample;
+    SIZE_T k = 0;
+
+#if defined(VMIC_ARCH_X64)
+    __m128 upper = _mm_set1_ps(ceiling);
+    __m128 lower = _mm_set1_ps(-ceiling);
+
+    if (Limiter->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        for (; k + 4 <= Samples; k += 4) {
+            _mm_storeu_ps(Block + k, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(Block + k), lower), upper));
+        }
+    }
+#endif
+
+    for (; k < Samples; k++) {
+        sample = (Block[k] > -ceiling) ? Block[k] : -ceiling;
+        Block[k] = (sample < ceiling) ? sample : ceiling;
+    }
+}
+
+static VOID LimiterProcess(
+    _Inout_ PVOID Context,
+    _Inout_ float *Block,
+    _In_ ULONG Frames
+)
+{
+    PDSP_LIMITER limiter = (PDSP_LIMITER)Context;
+
+    FramePeaks(limiter->Isa, Block, limiter->Channels, Frames, limiter->Frame);
+    LimiterRequiredGains(limiter, Frames);
+    LimiterSmoothGains(limiter, Frames);
+    LimiterDelay(limiter, Block, Frames);
+    ApplyGains(limiter->Isa, Block, limiter->Channels, Frames, limiter->Frame);
+    LimiterClamp(limiter, Block, (SIZE_T)Frames * limiter->Channels);
+}
+
+static SIZE_T LimiterGetRequiredSize(const DSP_STAGE_CONFIG *Stage, ULONG SampleRate, ULONG Channels)
+{
+    DSP_LIMITER_LAYOUT layout;
+
+    return LimiterGetLayout(Stage, SampleRate, Channels, &layout) ? layout.Size : 0;
+}
+
+static VOID LimiterReset(PVOID Context)
+{
+    PDSP_LIMITER limiter = (PDSP_LIMITER)Context;
+    ULONG k;
+
+    limiter->Position = 0;
+    limiter->QueueHead = 0;
+    limiter->QueueCount = 0;
+    limiter->Held = 1.0f;
+    limiter->Gain = 1.0f;
+    limiter->HistoryPosition = 0;
+    limiter->Sum = (double)limiter->Window;
+    for (k = 0; k < limiter->Window; k++) {
+        limiter->History[k] = 1.0f;
+    }
+
+    RtlZeroMemory(limiter->Delay, (SIZE_T)limiter->Lookahead * limiter->Channels * sizeof(float));
+    limiter->DelayPosition = 0;
+}
+
+static VOID LimiterInitialize(PVOID Context, const DSP_STAGE_CONFIG *Stage, ULONG SampleRate,
+                              ULONG Channels, SAMPLE_CONVERT_ISA Isa)
+{
+    PDSP_LIMITER limiter = (PDSP_LIMITER)Context;
+    PUCHAR base = (PUCHAR)Context;
+    DSP_LIMITER_LAYOUT layout;
+
+    LimiterGetLayout(Stage, SampleRate, Channels, &layout);
+
+    limiter->Channels = Channels;
+    limiter->Isa = Isa;
+    limiter->Ceiling = (float)DspDbToGain((double)Stage->CeilingDb);
+    limiter->Release = DspSmoothingCoefficient(Stage->ReleaseMs, SampleRate);
+    limiter->Lookahead = layout.Lookahead;
+    limiter->Window = layout.Lookahead + 1;
+    limiter->QueueFrames = (PULONG)(base + layout.QueueFramesOffset);
+    limiter->QueueGains = (float *)(base + layout.QueueGainsOffset);
+    limiter->History = (float *)(base + layout.HistoryOffset);
+    limiter->Delay = (float *)(base + layout.DelayOffset);
+
+    LimiterReset(limiter);
+}
+
+static ULONG LimiterGetLatency(const VOID *Context)
+{
+    return ((const DSP_LIMITER *)Context)->Lookahead;
+}
+
+static float LimiterGetGainReduction(const VOID *Context)
+{
+    const DSP_LIMITER *limiter = (const DSP_LIMITER *)Context;
+
+    return (limiter->Gain < 1.0f) ? -DSP_DB_PER_OCTAVE * Log2Scalar(limiter->Gain) : 0.0f;
+}
+
+const DSP_STAGE_OPS DspLimiterOps = {
+    LimiterGetRequiredSize,
+    LimiterInitialize,
+    LimiterProcess,
+    LimiterReset,
+    LimiterGetLatency,
+    LimiterGetGainReduction,
+};
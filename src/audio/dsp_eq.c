@@ -0,0 +1,374 @@
+#include "dsp_stages.h"
+
+#if defined(VMIC_ARCH_X64)
+#include <emmintrin.h>
+#endif
+
+// Ecualizador de biquads en cascada. Cada sección recorre el bloque entero
+// antes de la siguiente (el bloque sigue en L1) con su estado en registros.
+// La recursión de un canal es secuencial, así que los núcleos SSE2 van en
+// paralelo por canales: grupos de 4 (dos a la vez con 8 canales), de 2 y el
+// canal suelto en escalar. Las operaciones son las mismas y en el mismo orden
+// que en el escalar, con resultados idénticos bit a bit.
+
+// Con silencio a la entrada los estados decaen hasta desnormales, decenas de
+// veces más lentos: por debajo de este valor se anulan al final del bloque
+#define DSP_EQ_DENORMAL_THRESHOLD 1e-15f
+
+typedef enum _DSP_EQ_COEFFICIENT {
+    DSP_EQ_B0 = 0,
+    DSP_EQ_B1,
+    DSP_EQ_B2,
+    DSP_EQ_A1,
+    DSP_EQ_A2,
+    DSP_EQ_COEFFICIENTS
+} DSP_EQ_COEFFICIENT;
+
+typedef struct _DSP_EQ {
+    ULONG Channels;
+    ULONG Sections;
+    SAMPLE_CONVERT_ISA Isa;
+    float Coefficients[DSP_EQ_MAX_BANDS][DSP_EQ_COEFFICIENTS];  // Normalizados por a0
+    float State1[DSP_EQ_MAX_BANDS][DSP_CHAIN_MAX_CHANNELS];
+    float State2[DSP_EQ_MAX_BANDS][DSP_CHAIN_MAX_CHANNELS];
+} DSP_EQ, *PDSP_EQ;
+
+// Forma directa II traspuesta sobre Frames frames de un canal (paso Channels)
+static VOID EqSectionScalar(const float *Coefficients, float *State1, float *State2,
+                            float *Samples, ULONG Channels, ULONG Frames)
+{
+    float b0 = Coefficients[DSP_EQ_B0];
+    float b1 = Coefficients[DSP_EQ_B1];
+    float b2 = Coefficients[DSP_EQ_B2];
+    float a1 = Coefficients[DSP_EQ_A1];
+    float a2 = Coefficients[DSP_EQ_A2];
+    float z1 = *State1;
+    float z2 = *State2;
+    float x;
+    float y;
+    ULONG i;
+
+    for (i = 0; i < Frames; i++) {
+        x = Samples[(SIZE_T)i * Channels];
+        y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        Samples[(SIZE_T)i * Channels] = y;
+    }
+
+    *State1 = z1;
+    *State2 = z2;
+}
+
+#if defined(VMIC_ARCH_X64)
+
+#define EQ_SSE2_COEFFICIENTS(Coefficients)                   \
+    __m128 b0 = _mm_set1_ps((Coefficients)[DSP_EQ_B0]);      \
+    __m128 b1 = _mm_set1_ps((Coefficients)[DSP_EQ_B1]);      \
+    __m128 b2 = _mm_set1_ps((Coefficients)[DSP_EQ_B2]);      \
+    __m128 a1 = _mm_set1_ps((Coefficients)[DSP_EQ_A1]);      \
+    __m128 a2 = _mm_set1_ps((Coefficients)[DSP_EQ_A2])
+
+#define EQ_SSE2_STEP(x, y, z1, z2)                                                      \
+    do {                                                                                \
+        (y) = _mm_add_ps(_mm_mul_ps(b0, (x)), (z1));                                    \
+        (z1) = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, (x)), _mm_mul_ps(a1, (y))), (z2)); \
+        (z2) = _mm_sub_ps(_mm_mul_ps(b2, (x)), _mm_mul_ps(a2, (y)));                   \
+    } while (0)
+
+// Dos grupos de 4 canales a la vez: dos recursiones independientes
+static VOID EqSectionSse2x8(const float *Coefficients, float *State1, float *State2,
+                            float *Samples, ULONG Channels, ULONG Frames)
+{
+    EQ_SSE2_COEFFICIENTS(Coefficients);
+    __m128 z1a = _mm_loadu_ps(State1);
+    __m128 z1b = _mm_loadu_ps(State1 + 4);
+    __m128 z2a = _mm_loadu_ps(State2);
+    __m128 z2b = _mm_loadu_ps(State2 + 4);
+    __m128 xa;
+    __m128 xb;
+    __m128 ya;
+    __m128 yb;
+    float *frame;
+    ULONG i;
+
+    for (i = 0; i < Frames; i++) {
+        frame = Samples + (SIZE_T)i * Channels;
+        xa = _mm_loadu_ps(frame);
+        xb = _mm_loadu_ps(frame + 4);
+        EQ_SSE2_STEP(xa, ya, z1a, z2a);
+        EQ_SSE2_STEP(xb, yb, z1b, z2b);
+        _mm_storeu_ps(frame, ya);
+        _mm_storeu_ps(frame + 4, yb);
+    }
+
+    _mm_storeu_ps(State1, z1a);
+    _mm_storeu_ps(State1 + 4, z1b);
+    _mm_storeu_ps(State2, z2a);
+    _mm_storeu_ps(State2 + 4, z2b);
+}
+
+static VOID EqSectionSse2x4(const float *Coefficients, float *State1, float *State2,
+                            float *Samples, ULONG Channels, ULONG Frames)
+{
+    EQ_SSE2_COEFFICIENTS(Coefficients);
+    __m128 z1 = _mm_loadu_ps(State1);
+    __m128 z2 = _mm_loadu_ps(State2);
+    __m128 x;
+    __m128 y;
+    ULONG i;
+
+    for (i = 0; i < Frames; i++) {
+        x = _mm_loadu_ps(Samples + (SIZE_T)i * Channels);
+        EQ_SSE2_STEP(x, y, z1, z2);
+        _mm_storeu_ps(Samples + (SIZE_T)i * Channels, y);
+    }
+
+    _mm_storeu_ps(State1, z1);
+    _mm_storeu_ps(State2, z2);
+}
+
+// Dos canales en la mitad baja del registro (MOVQ)
+static inline __m128 LoadPair(const float *Source)
+{
+    return _mm_castsi128_ps(_mm_loadl_epi64((const __m128i *)Source));
+}
+
+static inline VOID StorePair(float *Target, __m128 Value)
+{
+    _mm_storel_epi64((__m128i *)Target, _mm_castps_si128(Value));
+}
+
+static VOID EqSectionSse2x2(const float *Coefficients, float *State1, float *State2,
+                            float *Samples, ULONG Channels, ULONG Frames)
+{
+    EQ_SSE2_COEFFICIENTS(Coefficients);
+    __m128 z1 = LoadPair(State1);
+    __m128 z2 = LoadPair(State2);
+    __m128 x;
+    __m128 y;
+    ULONG i;
+
+    for (i = 0; i < Frames; i++) {
+        x = LoadPair(Samples + (SIZE_T)i * Channels);
+        EQ_SSE2_STEP(x, y, z1, z2);
+        StorePair(Samples + (SIZE_T)i * Channels, y);
+    }
+
+    StorePair(State1, z1);
+    StorePair(State2, z2);
+}
+
+static VOID EqSectionSse2(const float *Coefficients, float *State1, float *State2,
+                          float *Block, ULONG Channels, ULONG Frames)
+{
+    ULONG channel = 0;
+
+    if (Channels >= 8) {
+        EqSectionSse2x8(Coefficients, State1, State2, Block, Channels, Frames);
+        channel = 8;
+    }
+
+    for (; channel + 4 <= Channels; channel += 4) {
+        EqSectionSse2x4(Coefficients, State1 + channel, State2 + channel, Block + channel, Channels, Frames);
+    }
+
+    if (channel + 2 <= Channels) {
+        EqSectionSse2x2(Coefficients, State1 + channel, State2 + channel, Block + channel, Channels, Frames);
+        channel += 2;
+    }
+
+    if (channel < Channels) {
+        EqSectionScalar(Coefficients, State1 + channel, State2 + channel, Block + channel, Channels, Frames);
+    }
+}
+
+#endif // VMIC_ARCH_X64
+
+static VOID EqProcess(
+    _Inout_ PVOID Context,
+    _Inout_ float *Block,
+    _In_ ULONG Frames
+)
+{
+    PDSP_EQ eq = (PDSP_EQ)Context;
+    ULONG section;
+    ULONG channel;
+
+    for (section = 0; section < eq->Sections; section++) {
+#if defined(VMIC_ARCH_X64)
+        if (eq->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+            EqSectionSse2(eq->Coefficients[section], eq->State1[section], eq->State2[section],
+                          Block, eq->Channels, Frames);
+            continue;
+        }
+#endif
+        for (channel = 0; channel < eq->Channels; channel++) {
+            EqSectionScalar(eq->Coefficients[section], &eq->State1[section][channel],
+                            &eq->State2[section][channel], Block + channel, eq->Channels, Frames);
+        }
+    }
+
+    for (section = 0; section < eq->Sections; section++) {
+        for (channel = 0; channel < eq->Channels; channel++) {
+            if (eq->State1[section][channel] < DSP_EQ_DENORMAL_THRESHOLD &&
+                eq->State1[section][channel] > -DSP_EQ_DENORMAL_THRESHOLD) {
+                eq->State1[section][channel] = 0.0f;
+            }
+            if (eq->State2[section][channel] < DSP_EQ_DENORMAL_THRESHOLD &&
+                eq->State2[section][channel] > -DSP_EQ_DENORMAL_THRESHOLD) {
+                eq->State2[section][channel] = 0.0f;
+            }
+        }
+    }
+}
+
+// Coeficientes de una banda (Audio EQ Cookbook) normalizados por a0
+static VOID EqDesignBand(const DSP_EQ_BAND *Band, ULONG SampleRate, float *Coefficients)
+{
+    double omega = 2.0 * (double)Band->Frequency / (double)SampleRate;  // En unidades de pi
+    double cosine = DspCosPi(omega);
+    double alpha = DspSinPi(omega) / (2.0 * (double)Band->Q);
+    double amplitude = DspDbToGain((double)Band->GainDb / 2.0);         // A = 10^(G/40)
+    double shelf = 2.0 * DspDbToGain((double)Band->GainDb / 4.0) * alpha; // 2 sqrt(A) alpha
+    double b0;
+    double b1;
+    double b2;
+    double a0;
+    double a1;
+    double a2;
+
+    switch (Band->Shape) {
+    case DSP_EQ_LOW_SHELF:
+        b0 = amplitude * ((amplitude + 1.0) - (amplitude - 1.0) * cosine + shelf);
+        b1 = 2.0 * amplitude * ((amplitude - 1.0) - (amplitude + 1.0) * cosine);
+        b2 = amplitude * ((amplitude + 1.0) - (amplitude - 1.0) * cosine - shelf);
+        a0 = (amplitude + 1.0) + (amplitude - 1.0) * cosine + shelf;
+        a1 = -2.0 * ((amplitude - 1.0) + (amplitude + 1.0) * cosine);
+        a2 = (amplitude + 1.0) + (amplitude - 1.0) * cosine - shelf;
+        break;
+
+    case DSP_EQ_HIGH_SHELF:
+        b0 = amplitude * ((amplitude + 1.0) + (amplitude - 1.0) * cosine + shelf);
+        b1 = -2.0 * amplitude * ((amplitude - 1.0) + (amplitude + 1.0) * cosine);
+        b2 = amplitude * ((amplitude + 1.0) + (amplitude - 1.0) * cosine - shelf);
+        a0 = (amplitude + 1.0) - (amplitude - 1.0) * cosine + shelf;
+        a1 = 2.0 * ((amplitude - 1.0) - (amplitude + 1.0) * cosine);
+        a2 = (amplitude + 1.0) - (amplitude - 1.0) * cosine - shelf;
+        break;
+
+    case DSP_EQ_LOW_PASS:
+        b0 = (1.0 - cosine) / 2.0;
+        b1 = 1.0 - cosine;
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosine;
+        a2 = 1.0 - alpha;
+        break;
+
+    case DSP_EQ_HIGH_PASS:
+        b0 = (1.0 + cosine) / 2.0;
+        b1 = -(1.0 + cosine);
+        b2 = b0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosine;
+        a2 = 1.0 - alpha;
+        break;
+
+    case DSP_EQ_BAND_PASS:
+        b0 = alpha;
+        b1 = 0.0;
+        b2 = -alpha;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosine;
+        a2 = 1.0 - alpha;
+        break;
+
+    case DSP_EQ_NOTCH:
+        b0 = 1.0;
+        b1 = -2.0 * cosine;
+        b2 = 1.0;
+        a0 = 1.0 + alpha;
+        a1 = -2.0 * cosine;
+        a2 = 1.0 - alpha;
+        break;
+
+    case DSP_EQ_PEAKING:
+    default:
+        b0 = 1.0 + alpha * amplitude;
+        b1 = -2.0 * cosine;
+        b2 = 1.0 - alpha * amplitude;
+        a0 = 1.0 + alpha / amplitude;
+        a1 = -2.0 * cosine;
+        a2 = 1.0 - alpha / amplitude;
+        break;
+    }
+
+    Coefficients[DSP_EQ_B0] = (float)(b0 / a0);
+    Coefficients[DSP_EQ_B1] = (float)(b1 / a0);
+    Coefficients[DSP_EQ_B2] = (float)(b2 / a0);
+    Coefficients[DSP_EQ_A1] = (float)(a1 / a0);
+    Coefficients[DSP_EQ_A2] = (float)(a2 / a0);
+}
+
+static SIZE_T EqGetRequiredSize(const DSP_STAGE_CONFIG *Stage, ULONG SampleRate, ULONG Channels)
+{
+    ULONG i;
+
+    UNREFERENCED_PARAMETER(Channels);
+
+    // Por encima de Nyquist el diseño no tiene sentido
+    for (i = 0; i < Stage->Bands; i++) {
+        if ((double)Stage->Band[i].Frequency >= (double)SampleRate / 2.0) {
+            return 0;
+        }
+    }
+
+    return sizeof(DSP_EQ);
+}
+
+static VOID EqReset(PVOID Context)
+{
+    PDSP_EQ eq = (PDSP_EQ)Context;
+
+    RtlZeroMemory(eq->State1, sizeof(eq->State1));
+    RtlZeroMemory(eq->State2, sizeof(eq->State2));
+}
+
+static VOID EqInitialize(PVOID Context, const DSP_STAGE_CONFIG *Stage, ULONG SampleRate,
+                         ULONG Channels, SAMPLE_CONVERT_ISA Isa)
+{
+    PDSP_EQ eq = (PDSP_EQ)Context;
+    ULONG i;
+
+    eq->Channels = Channels;
+    eq->Sections = Stage->Bands;
+    eq->Isa = Isa;
+
+    for (i = 0; i < Stage->Bands; i++) {
+        EqDesignBand(&Stage->Band[i], SampleRate, eq->Coefficients[i]);
+    }
+
+    EqReset(eq);
+}
+
+static ULONG EqGetLatency(const VOID *Context)
+{
+    UNREFERENCED_PARAMETER(Context);
+    return 0;
+}
+
+static float EqGetGainReduction(const VOID *Context)
+{
+    UNREFERENCED_PARAMETER(Context);
+    return 0.0f;
+}
+
+const DSP_STAGE_OPS DspEqOps = {
+    EqGetRequiredSize,
+    EqInitialize,
+    EqProcess,
+    EqReset,
+    EqGetLatency,
+    EqGetGainReduction,
+};
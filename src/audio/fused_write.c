@@ -0,0 +1,492 @@
+#include "fused_write.h"
+#include "sample_convert_kernels.h"
+#include "level_meter_kernels.h"
+
+// Cada grupo produce 8 muestras de salida: 8 frames mono, 4 estéreo (o 8/C
+// frames sin mezcla). Los núcleos repiten las operaciones de los de etapas
+// (sample_convert_sse2.c, channel_mix.c y level_meter.c) en el mismo orden;
+// lo que no llena un grupo al final de cada tramo del anillo sigue por las
+// etapas, y el medidor se cierra en cada tramo igual que LevelMeterProcessRing.
+
+#if defined(VMIC_ARCH_X64)
+
+#include <emmintrin.h>
+
+#define FUSED_SAMPLE_BYTES(Format) (((Format) == SAMPLE_FORMAT_INT16) ? sizeof(SHORT) : sizeof(LONG))
+
+// Cuatro muestras enteras alineadas a la izquierda en 32 bits
+static inline __m128i FusedLoadInt4(const UCHAR *Source, SAMPLE_FORMAT Format)
+{
+    if (Format == SAMPLE_FORMAT_INT16) {
+        // Intercalar con ceros por debajo equivale a << 16
+        return _mm_unpacklo_epi16(_mm_setzero_si128(), _mm_loadl_epi64((const __m128i *)Source));
+    }
+
+    return _mm_loadu_si128((const __m128i *)Source);
+}
+
+static inline __m128 FusedIntToFloat(__m128i Value)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(Value), _mm_set1_ps(SAMPLE_FLOAT_SCALE));
+}
+
+// Como FloatToInt de sample_convert_sse2.c con 32 bits
+static inline __m128i FusedFloatToInt32(__m128 Value)
+{
+    __m128 scale = _mm_set1_ps(2147483648.0f);
+
+    Value = _mm_mul_ps(Value, scale);
+
+    // CVTPS2DQ devuelve 0x80000000 fuera de rango; por arriba se corrige a 0x7FFFFFFF
+    return _mm_xor_si128(_mm_cvtps_epi32(Value), _mm_castps_si128(_mm_cmpge_ps(Value, scale)));
+}
+
+// Como FloatToInt con 16 bits, pero sin alinear a la izquierda: el << 16 y el
+// >> 16 de StoreInt16 se anulan
+static inline __m128i FusedFloatToInt16(__m128 Value)
+{
+    Value = _mm_mul_ps(Value, _mm_set1_ps(32768.0f));
+    Value = _mm_min_ps(Value, _mm_set1_ps(32767.0f));
+    Value = _mm_max_ps(Value, _mm_set1_ps(-32768.0f));
+    return _mm_cvtps_epi32(Value);
+}
+
+// Cuatro muestras de origen en float (el decodificador de la mezcla)
+static inline __m128 FusedDecode4(const UCHAR *Source, SAMPLE_FORMAT Format)
+{
+    if (Format == SAMPLE_FORMAT_FLOAT32) {
+        return _mm_loadu_ps((const float *)Source);
+    }
+
+    return FusedIntToFloat(FusedLoadInt4(Source, Format));
+}
+
+// Guarda 8 muestras int16 y las mide
+static inline VOID FusedStoreInt16(PUCHAR Target, __m128i Samples, BOOLEAN Meter,
+                                   PLEVEL_METER_INT16_LANES Int16Lanes)
+{
+    _mm_storeu_si128((__m128i *)Target, Samples);
+    if (Meter) {
+        LevelMeterInt16LanesAdd(Int16Lanes, Samples);
+    }
+}
+
+// Guarda 8 enteros alineados a la izquierda y los mide tal como quedan
+static inline VOID FusedStoreInt(PUCHAR Target, __m128i Low, __m128i High, SAMPLE_FORMAT Format,
+                                 BOOLEAN Meter, PLEVEL_METER_LANES Lanes, PLEVEL_METER_INT16_LANES Int16Lanes)
+{
+    if (Format == SAMPLE_FORMAT_INT16) {
+        // Tras >> 16 todos los valores caben: PACKSSDW no llega a saturar
+        FusedStoreInt16(Target, _mm_packs_epi32(_mm_srai_epi32(Low, 16), _mm_srai_epi32(High, 16)), Meter,
+                        Int16Lanes);
+        return;
+    }
+
+    _mm_storeu_si128((__m128i *)Target, Low);
+    _mm_storeu_si128((__m128i *)(Target + 16), High);
+    if (Meter) {
+        LevelMeterLanesAdd(Lanes, _mm_cvtepi32_ps(Low), _mm_cvtepi32_ps(High));
+    }
+}
+
+// Codifica 8 muestras float en el formato de destino y las mide
+static inline VOID FusedStoreFloat(PUCHAR Target, __m128 Low, __m128 High, SAMPLE_FORMAT Format,
+                                   BOOLEAN Meter, PLEVEL_METER_LANES Lanes, PLEVEL_METER_INT16_LANES Int16Lanes)
+{
+    if (Format == SAMPLE_FORMAT_INT16) {
+        // Ya recortados a 16 bits: PACKSSDW tampoco satura
+        FusedStoreInt16(Target, _mm_packs_epi32(FusedFloatToInt16(Low), FusedFloatToInt16(High)), Meter,
+                        Int16Lanes);
+        return;
+    }
+
+    if (Format == SAMPLE_FORMAT_INT32) {
+        FusedStoreInt(Target, FusedFloatToInt32(Low), FusedFloatToInt32(High), Format, Meter, Lanes, Int16Lanes);
+        return;
+    }
+
+    _mm_storeu_ps((float *)Target, Low);
+    _mm_storeu_ps((float *)(Target + 16), High);
+    if (Meter) {
+        LevelMeterLanesAdd(Lanes, Low, High);
+    }
+}
+
+// Mezcla a estéreo dos frames de 6 u 8 canales y devuelve [L0, R0, L1, R1].
+// First y Second traen los canales 0..3 de cada frame; con 8 canales,
+// FirstHigh y SecondHigh traen los 4..7, y con 6 los canales 4 y 5 están en
+// las posiciones 0-1 de FirstHigh y 2-3 de SecondHigh. Gains[c] es
+// [L, R, L, R] del canal c, así que sobra trasponer y bastan 6 u 8 registros
+// de ganancias. Misma suma por canal, en el mismo orden, que ChannelMixFrames.
+static inline __m128 FusedMixPair(__m128 First, __m128 FirstHigh, __m128 Second, __m128 SecondHigh,
+                                  ULONG Channels, const __m128 *Gains)
+{
+    __m128 mix;
+
+    mix = _mm_mul_ps(_mm_shuffle_ps(First, Second, _MM_SHUFFLE(0, 0, 0, 0)), Gains[0]);
+    mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(First, Second, _MM_SHUFFLE(1, 1, 1, 1)), Gains[1]));
+    mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(First, Second, _MM_SHUFFLE(2, 2, 2, 2)), Gains[2]));
+    mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(First, Second, _MM_SHUFFLE(3, 3, 3, 3)), Gains[3]));
+
+    if (Channels == 8) {
+        mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(FirstHigh, SecondHigh, _MM_SHUFFLE(0, 0, 0, 0)), Gains[4]));
+        mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(FirstHigh, SecondHigh, _MM_SHUFFLE(1, 1, 1, 1)), Gains[5]));
+        mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(FirstHigh, SecondHigh, _MM_SHUFFLE(2, 2, 2, 2)), Gains[6]));
+        mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(FirstHigh, SecondHigh, _MM_SHUFFLE(3, 3, 3, 3)), Gains[7]));
+        return mix;
+    }
+
+    mix = _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(FirstHigh, SecondHigh, _MM_SHUFFLE(2, 2, 0, 0)), Gains[4]));
+    return _mm_add_ps(mix, _mm_mul_ps(_mm_shuffle_ps(FirstHigh, SecondHigh, _MM_SHUFFLE(3, 3, 1, 1)), Gains[5]));
+}
+
+// Shape, formatos y Metering son constantes en cada especialización: el
+// compilador elimina las ramas y desenrolla los bucles por canal. Los
+// acumuladores del medidor son locales para que sigan en registros (las
+// escrituras por PUCHAR podrían pisar cualquier otra memoria).
+static VMIC_FORCEINLINE VOID FusedWriteGroups(
+    _In_ const CHANNEL_MIX *Mix,
+    _Inout_opt_ PLEVEL_METER Meter,
+    _Out_ PUCHAR Target,
+    _In_ const UCHAR *Source,
+    _In_ SIZE_T Groups,
+    _In_ FUSED_WRITE_SHAPE Shape,
+    _In_ SAMPLE_FORMAT SourceFormat,
+    _In_ SAMPLE_FORMAT TargetFormat,
+    _In_ BOOLEAN Metering
+)
+{
+    SIZE_T sourceBytes = FUSED_SAMPLE_BYTES(SourceFormat);
+    SIZE_T targetBytes = FUSED_SAMPLE_BYTES(TargetFormat);
+    ULONG inputs = 0;
+    SIZE_T sourceStep = 8;
+    LEVEL_METER_LANES lanes;
+    LEVEL_METER_INT16_LANES int16Lanes;
+    __m128 gainLeft[2];
+    __m128 gainRight;
+    __m128 gains[CHANNEL_MIX_MAX_CHANNELS];
+    __m128 decoded[CHANNEL_MIX_MAX_CHANNELS];
+    __m128i integerLow;
+    __m128i integerHigh;
+    __m128 low;
+    __m128 high;
+    __m128 left;
+    __m128 right;
+    __m128 mixLow;
+    __m128 mixHigh;
+    SIZE_T group;
+    ULONG channel;
+
+    switch (Shape) {
+        case FUSED_WRITE_SHAPE_MONO_TO_STEREO:
+            inputs = 1;
+            sourceStep = 4;
+            break;
+        case FUSED_WRITE_SHAPE_STEREO_TO_MONO:
+            inputs = 2;
+            sourceStep = 16;
+            break;
+        case FUSED_WRITE_SHAPE_SURROUND51_TO_STEREO:
+            inputs = 6;
+            sourceStep = 24;
+            break;
+        case FUSED_WRITE_SHAPE_SURROUND71_TO_STEREO:
+            inputs = 8;
+            sourceStep = 32;
+            break;
+        default:
+            break;
+    }
+
+    // Filas 0 y 1 de la matriz: 1->2 y 2->1 por separado, 6->2 y 8->2 intercaladas
+    gainLeft[0] = _mm_set1_ps(Mix->Matrix[0][0]);
+    gainLeft[1] = _mm_set1_ps(Mix->Matrix[0][1]);
+    gainRight = _mm_set1_ps(Mix->Matrix[1][0]);
+    for (channel = 0; channel < inputs; channel++) {
+        gains[channel] = _mm_setr_ps(Mix->Matrix[0][channel], Mix->Matrix[1][channel],
+                                     Mix->Matrix[0][channel], Mix->Matrix[1][channel]);
+    }
+
+    if (Metering) {
+        if (TargetFormat == SAMPLE_FORMAT_INT16) {
+            LevelMeterInt16LanesStart(&int16Lanes);
+        } else {
+            LevelMeterLanesStart(Meter, &lanes);
+        }
+    }
+
+    for (group = 0; group < Groups; group++) {
+        switch (Shape) {
+            case FUSED_WRITE_SHAPE_COPY:
+                if (SourceFormat == SAMPLE_FORMAT_FLOAT32) {
+                    FusedStoreFloat(Target, _mm_loadu_ps((const float *)Source),
+                                    _mm_loadu_ps((const float *)(Source + 16)), TargetFormat, Metering,
+                                    &lanes, &int16Lanes);
+                    break;
+                }
+
+                if (SourceFormat == SAMPLE_FORMAT_INT16 && TargetFormat == SAMPLE_FORMAT_INT16) {
+                    // Copia tal cual: el medidor int16 toma las muestras del registro
+                    FusedStoreInt16(Target, _mm_loadu_si128((const __m128i *)Source), Metering, &int16Lanes);
+                    break;
+                }
+
+                integerLow = FusedLoadInt4(Source, SourceFormat);
+                integerHigh = FusedLoadInt4(Source + 4 * sourceBytes, SourceFormat);
+                if (TargetFormat == SAMPLE_FORMAT_FLOAT32) {
+                    FusedStoreFloat(Target, FusedIntToFloat(integerLow), FusedIntToFloat(integerHigh),
+                                    TargetFormat, Metering, &lanes, &int16Lanes);
+                } else {
+                    FusedStoreInt(Target, integerLow, integerHigh, TargetFormat, Metering, &lanes, &int16Lanes);
+                }
+                break;
+
+            case FUSED_WRITE_SHAPE_MONO_TO_STEREO:
+                low = FusedDecode4(Source, SourceFormat);
+                left = _mm_mul_ps(low, gainLeft[0]);
+                right = _mm_mul_ps(low, gainRight);
+                FusedStoreFloat(Target, _mm_unpacklo_ps(left, right), _mm_unpackhi_ps(left, right),
+                                TargetFormat, Metering, &lanes, &int16Lanes);
+                break;
+
+            case FUSED_WRITE_SHAPE_STEREO_TO_MONO:
+                // Frames 0-3 y 4-7, cada uno de dos vectores intercalados
+                low = FusedDecode4(Source, SourceFormat);
+                high = FusedDecode4(Source + 4 * sourceBytes, SourceFormat);
+                left = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+                right = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+                mixLow = _mm_add_ps(_mm_mul_ps(left, gainLeft[0]), _mm_mul_ps(right, gainLeft[1]));
+
+                low = FusedDecode4(Source + 8 * sourceBytes, SourceFormat);
+                high = FusedDecode4(Source + 12 * sourceBytes, SourceFormat);
+                left = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+                right = _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+                mixHigh = _mm_add_ps(_mm_mul_ps(left, gainLeft[0]), _mm_mul_ps(right, gainLeft[1]));
+
+                FusedStoreFloat(Target, mixLow, mixHigh, TargetFormat, Metering, &lanes, &int16Lanes);
+                break;
+
+            default:
+                // 6->2 y 8->2: los frames 0-1 y 2-3 de 4 frames decodificados
+                for (channel = 0; channel < inputs; channel++) {
+                    decoded[channel] = FusedDecode4(Source + 4 * channel * sourceBytes, SourceFormat);
+                }
+
+                if (inputs == 8) {
+                    mixLow = FusedMixPair(decoded[0], decoded[1], decoded[2], decoded[3], 8, gains);
+                    mixHigh = FusedMixPair(decoded[4], decoded[5], decoded[6], decoded[7], 8, gains);
+                } else {
+                    // Los frames impares empiezan a mitad de vector
+                    mixLow = FusedMixPair(decoded[0], decoded[1],
+                                          _mm_shuffle_ps(decoded[1], decoded[2], _MM_SHUFFLE(1, 0, 3, 2)),
+                                          decoded[2], 6, gains);
+                    mixHigh = FusedMixPair(decoded[3], decoded[4],
+                                           _mm_shuffle_ps(decoded[4], decoded[5], _MM_SHUFFLE(1, 0, 3, 2)),
+                                           decoded[5], 6, gains);
+                }
+
+                FusedStoreFloat(Target, mixLow, mixHigh, TargetFormat, Metering, &lanes, &int16Lanes);
+                break;
+        }
+
+        Source += sourceStep * sourceBytes;
+        Target += 8 * targetBytes;
+    }
+
+    if (Metering) {
+        if (TargetFormat == SAMPLE_FORMAT_INT16) {
+            LevelMeterInt16LanesFinish(Meter, &int16Lanes);
+        } else {
+            LevelMeterLanesFinish(Meter, &lanes);
+        }
+    }
+}
+
+#define FUSED_WRITE_NAME(Shape, SourceFormat, TargetFormat, Metering) \
+    FusedWrite_##Shape##_##SourceFormat##_##TargetFormat##_##Metering
+
+#define DEFINE_FUSED_WRITE(Shape, SourceFormat, TargetFormat, Metering)                                      \
+    static VOID FUSED_WRITE_NAME(Shape, SourceFormat, TargetFormat, Metering)(                              \
+        const CHANNEL_MIX *Mix, PLEVEL_METER Meter, PUCHAR Target, const UCHAR *Source, SIZE_T Groups)      \
+    {                                                                                                       \
+        FusedWriteGroups(Mix, Meter, Target, Source, Groups, FUSED_WRITE_SHAPE_##Shape,                     \
+                         SAMPLE_FORMAT_##SourceFormat, SAMPLE_FORMAT_##TargetFormat, Metering);             \
+    }
+
+#define DEFINE_FUSED_TARGETS(Shape, SourceFormat, Meter)  \
+    DEFINE_FUSED_WRITE(Shape, SourceFormat, INT16, Meter) \
+    DEFINE_FUSED_WRITE(Shape, SourceFormat, INT32, Meter) \
+    DEFINE_FUSED_WRITE(Shape, SourceFormat, FLOAT32, Meter)
+
+#define DEFINE_FUSED_SHAPE(Shape, Meter)        \
+    DEFINE_FUSED_TARGETS(Shape, INT16, Meter)   \
+    DEFINE_FUSED_TARGETS(Shape, INT32, Meter)   \
+    DEFINE_FUSED_TARGETS(Shape, FLOAT32, Meter)
+
+// Sin mezcla ni medidores la conversión por etapas ya es una sola pasada
+DEFINE_FUSED_SHAPE(COPY, 1)
+DEFINE_FUSED_SHAPE(MONO_TO_STEREO, 0)
+DEFINE_FUSED_SHAPE(MONO_TO_STEREO, 1)
+DEFINE_FUSED_SHAPE(STEREO_TO_MONO, 0)
+DEFINE_FUSED_SHAPE(STEREO_TO_MONO, 1)
+DEFINE_FUSED_SHAPE(SURROUND51_TO_STEREO, 0)
+DEFINE_FUSED_SHAPE(SURROUND51_TO_STEREO, 1)
+DEFINE_FUSED_SHAPE(SURROUND71_TO_STEREO, 0)
+DEFINE_FUSED_SHAPE(SURROUND71_TO_STEREO, 1)
+
+// Tablas [origen][destino] como las de sample_convert_kernels.h; int24 sin núcleo
+#define FUSED_TARGET_ROW(Shape, SourceFormat, Meter)                                           \
+    { FUSED_WRITE_NAME(Shape, SourceFormat, INT16, Meter), NULL,                               \
+      FUSED_WRITE_NAME(Shape, SourceFormat, INT32, Meter), FUSED_WRITE_NAME(Shape, SourceFormat, FLOAT32, Meter) }
+
+#define FUSED_FORMAT_TABLE(Shape, Meter)                                   \
+    { FUSED_TARGET_ROW(Shape, INT16, Meter), { NULL, NULL, NULL, NULL },   \
+      FUSED_TARGET_ROW(Shape, INT32, Meter), FUSED_TARGET_ROW(Shape, FLOAT32, Meter) }
+
+#define FUSED_EMPTY_TABLE \
+    { { NULL, NULL, NULL, NULL }, { NULL, NULL, NULL, NULL }, { NULL, NULL, NULL, NULL }, { NULL, NULL, NULL, NULL } }
+
+// [forma][medidores][origen][destino]
+static const FUSED_WRITE_ROUTINE FusedWriteKernels[FUSED_WRITE_SHAPE_COUNT][2][SAMPLE_FORMAT_COUNT][SAMPLE_FORMAT_COUNT] = {
+    { FUSED_EMPTY_TABLE, FUSED_FORMAT_TABLE(COPY, 1) },
+    { FUSED_FORMAT_TABLE(MONO_TO_STEREO, 0), FUSED_FORMAT_TABLE(MONO_TO_STEREO, 1) },
+    { FUSED_FORMAT_TABLE(STEREO_TO_MONO, 0), FUSED_FORMAT_TABLE(STEREO_TO_MONO, 1) },
+    { FUSED_FORMAT_TABLE(SURROUND51_TO_STEREO, 0), FUSED_FORMAT_TABLE(SURROUND51_TO_STEREO, 1) },
+    { FUSED_FORMAT_TABLE(SURROUND71_TO_STEREO, 0), FUSED_FORMAT_TABLE(SURROUND71_TO_STEREO, 1) },
+};
+#endif
+
+BOOLEAN FusedWriteSelect(
+    _Out_ PFUSED_WRITE Fused,
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _In_opt_ PCHANNEL_MIX Mix,
+    _In_opt_ PLEVEL_METER Meter,
+    _In_ SAMPLE_CONVERT_ISA Isa
+)
+{
+    SAMPLE_FORMAT sourceFormat;
+    ULONG outputs;
+
+    RtlZeroMemory(Fused, sizeof(FUSED_WRITE));
+    Fused->Converter = Converter;
+    Fused->Mix = Mix;
+    Fused->Meter = Meter;
+
+    if (Mix == NULL) {
+        Fused->Shape = FUSED_WRITE_SHAPE_COPY;
+        sourceFormat = Converter->SourceFormat;
+        Fused->TargetFormat = Converter->TargetFormat;
+        Fused->SourceFrameSize = Converter->SourceFrameSize;
+        Fused->TargetFrameSize = Converter->TargetFrameSize;
+        outputs = Converter->Channels;
+    } else {
+        if (Mix->InputChannels == 1 && Mix->OutputChannels == 2) {
+            Fused->Shape = FUSED_WRITE_SHAPE_MONO_TO_STEREO;
+        } else if (Mix->InputChannels == 2 && Mix->OutputChannels == 1) {
+            Fused->Shape = FUSED_WRITE_SHAPE_STEREO_TO_MONO;
+        } else if (Mix->InputChannels == 6 && Mix->OutputChannels == 2) {
+            Fused->Shape = FUSED_WRITE_SHAPE_SURROUND51_TO_STEREO;
+        } else if (Mix->InputChannels == 8 && Mix->OutputChannels == 2) {
+            Fused->Shape = FUSED_WRITE_SHAPE_SURROUND71_TO_STEREO;
+        } else {
+            return FALSE;
+        }
+
+        sourceFormat = Mix->Decoder.SourceFormat;
+        Fused->TargetFormat = Mix->Encoder.TargetFormat;
+        Fused->SourceFrameSize = Mix->Decoder.SourceFrameSize;
+        Fused->TargetFrameSize = Mix->Encoder.TargetFrameSize;
+        outputs = Mix->OutputChannels;
+    }
+
+    // Los grupos de 8 muestras tienen que ser frames enteros y, midiendo,
+    // coincidir con los carriles del medidor SSE2 (el escalar acumula distinto)
+    if (!LevelMeterUsesLanes(outputs) || Isa == SAMPLE_CONVERT_ISA_SCALAR) {
+        return FALSE;
+    }
+
+    if (Meter != NULL &&
+        (Meter->Isa == SAMPLE_CONVERT_ISA_SCALAR || Meter->Format != Fused->TargetFormat || Meter->Channels != outputs)) {
+        return FALSE;
+    }
+
+    Fused->GroupFrames = 8 / outputs;
+
+#if defined(VMIC_ARCH_X64)
+    Fused->Routine = FusedWriteKernels[Fused->Shape][(Meter != NULL) ? 1 : 0][sourceFormat][Fused->TargetFormat];
+#else
+    UNREFERENCED_PARAMETER(sourceFormat);
+#endif
+
+    return (Fused->Routine != NULL) ? TRUE : FALSE;
+}
+
+// Frames que no llenan un grupo: por las etapas (la mezcla usa sus bloques)
+static VOID FusedWriteTail(
+    _In_ const FUSED_WRITE *Fused,
+    _Out_ PUCHAR Target,
+    _In_ const UCHAR *Source,
+    _In_ ULONG Frames
+)
+{
+    PCHANNEL_MIX mix = Fused->Mix;
+
+    if (mix == NULL) {
+        SampleConvertFrames(Fused->Converter, Target, Source, Frames);
+        return;
+    }
+
+    SampleConvertFrames(&mix->Decoder, mix->InputBlock, Source, Frames);
+    ChannelMixFrames(mix, mix->OutputBlock, mix->InputBlock, Frames);
+    SampleConvertFrames(&mix->Encoder, Target, mix->OutputBlock, Frames);
+}
+
+ULONG FusedWriteRing(
+    _In_ const FUSED_WRITE *Fused,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+)
+{
+    const UCHAR *source = (const UCHAR *)Source;
+    PLEVEL_METER meter = Fused->Meter;
+    PUCHAR region;
+    ULONG written = 0;
+    ULONG chunk;
+    ULONG fused;
+
+    // Como mucho dos tramos (uno si el anillo está en modo espejo), los mismos
+    // en los que LevelMeterProcessRing parte lo escrito
+    while (written < Frames) {
+        chunk = min(RingBufferAcquireWrite(Ring, &region), Frames - written);
+        if (chunk == 0) {
+            break;
+        }
+
+        fused = 0;
+
+#if defined(VMIC_ARCH_X64)
+        if (Fused->Routine != NULL) {
+            fused = chunk - chunk % Fused->GroupFrames;
+            Fused->Routine(Fused->Mix, meter, region, source + (SIZE_T)written * Fused->SourceFrameSize,
+                           fused / Fused->GroupFrames);
+            if (meter != NULL) {
+                meter->Frames += fused;
+            }
+        }
+#endif
+
+        region += (SIZE_T)fused * Fused->TargetFrameSize;
+        FusedWriteTail(Fused, region, source + (SIZE_T)(written + fused) * Fused->SourceFrameSize, chunk - fused);
+
+        // La cola se mide por separado tras los carriles: el mismo orden que el medidor SSE2
+        if (meter != NULL) {
+            LevelMeterProcess(meter, region, chunk - fused);
+        }
+
+        RingBufferCommitWrite(Ring, chunk);
+        written += chunk;
+    }
+
+    return written;
+}
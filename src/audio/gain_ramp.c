@@ -0,0 +1,362 @@
+#include "gain_ramp.h"
+
+#if defined(VMIC_ARCH_X64)
+#include <emmintrin.h>
+#endif
+
+// Los núcleos SSE2 procesan 8 muestras por vuelta y dejan la cola al escalar.
+// Como en channel_mix.c, SSE2 no necesita guardar estado extendido en el kernel.
+
+// Ganancia constante sobre Samples muestras
+typedef VOID (*GAIN_CONSTANT_ROUTINE)(PUCHAR Data, SIZE_T Samples, float Gain);
+
+// Rampa sobre Frames frames: el frame f recibe Start + Step * (First + f)
+typedef VOID (*GAIN_RAMP_ROUTINE)(PUCHAR Data, ULONG Channels, ULONG Frames,
+                                  float Start, float Step, ULONG First);
+
+#define GAIN_INT32_MAXIMUM 2147483647.0
+#define GAIN_INT32_MINIMUM (-2147483648.0)
+
+// Redondeo al par más cercano (el de CVTPS2DQ/CVTPD2DQ) sin la CRT: al sumar
+// 1,5 * 2^52 la propia suma redondea a entero. |Value| <= 2^31.
+static inline LONG RoundToEven(double Value)
+{
+    return (LONG)((Value + 6755399441055744.0) - 6755399441055744.0);
+}
+
+static inline LONG Saturate(LONG Value, LONG Minimum, LONG Maximum)
+{
+    Value = (Value < Maximum) ? Value : Maximum;
+    return (Value > Minimum) ? Value : Minimum;
+}
+
+// int16 e int24 caben exactos en float y, con |ganancia| <= 16, el producto
+// redondeado también: se satura después, como PACKSSDW
+static inline VOID ScaleInt16(PUCHAR Data, SIZE_T Index, float Gain)
+{
+    SHORT *sample = (SHORT *)Data + Index;
+
+    *sample = (SHORT)Saturate(RoundToEven((float)*sample * Gain), -32768, 32767);
+}
+
+static inline VOID ScaleInt24(PUCHAR Data, SIZE_T Index, float Gain)
+{
+    PUCHAR sample = Data + Index * 3;
+    LONG value;
+
+    value = (LONG)(((ULONG)sample[0] << 8) | ((ULONG)sample[1] << 16) | ((ULONG)sample[2] << 24)) >> 8;
+    value = Saturate(RoundToEven((float)value * Gain), -8388608, 8388607);
+
+    sample[0] = (UCHAR)value;
+    sample[1] = (UCHAR)(value >> 8);
+    sample[2] = (UCHAR)(value >> 16);
+}
+
+// Se satura antes de redondear, como MINPD/MAXPD antes de CVTPD2DQ
+static inline VOID ScaleInt32(PUCHAR Data, SIZE_T Index, float Gain)
+{
+    LONG *sample = (LONG *)Data + Index;
+    double value = (double)*sample * (double)Gain;
+
+    value = (value < GAIN_INT32_MAXIMUM) ? value : GAIN_INT32_MAXIMUM;
+    value = (value > GAIN_INT32_MINIMUM) ? value : GAIN_INT32_MINIMUM;
+    *sample = RoundToEven(value);
+}
+
+static inline VOID ScaleFloat(PUCHAR Data, SIZE_T Index, float Gain)
+{
+    ((float *)Data)[Index] *= Gain;
+}
+
+#define DEFINE_SCALAR_GAIN(ConstantName, RampName, Scale)                          \
+    static VOID ConstantName(PUCHAR Data, SIZE_T Samples, float Gain)              \
+    {                                                                              \
+        SIZE_T i;                                                                  \
+        for (i = 0; i < Samples; i++) {                                            \
+            Scale(Data, i, Gain);                                                  \
+        }                                                                          \
+    }                                                                              \
+                                                                                   \
+    static VOID RampName(PUCHAR Data, ULONG Channels, ULONG Frames,                \
+                         float Start, float Step, ULONG First)                     \
+    {                                                                              \
+        SIZE_T index = 0;                                                          \
+        ULONG frame;                                                               \
+        ULONG channel;                                                             \
+        float gain;                                                                \
+        for (frame = 0; frame < Frames; frame++) {                                 \
+            gain = Start + Step * (float)(First + frame);                          \
+            for (channel = 0; channel < Channels; channel++) {                     \
+                Scale(Data, index++, gain);                                        \
+            }                                                                      \
+        }                                                                          \
+    }
+
+DEFINE_SCALAR_GAIN(GainConstantInt16Scalar, GainRampInt16Scalar, ScaleInt16)
+DEFINE_SCALAR_GAIN(GainConstantInt24Scalar, GainRampInt24Scalar, ScaleInt24)
+DEFINE_SCALAR_GAIN(GainConstantInt32Scalar, GainRampInt32Scalar, ScaleInt32)
+DEFINE_SCALAR_GAIN(GainConstantFloatScalar, GainRampFloatScalar, ScaleFloat)
+
+static const GAIN_CONSTANT_ROUTINE GainConstantScalarKernels[SAMPLE_FORMAT_COUNT] = {
+    GainConstantInt16Scalar, GainConstantInt24Scalar, GainConstantInt32Scalar, GainConstantFloatScalar
+};
+
+static const GAIN_RAMP_ROUTINE GainRampScalarKernels[SAMPLE_FORMAT_COUNT] = {
+    GainRampInt16Scalar, GainRampInt24Scalar, GainRampInt32Scalar, GainRampFloatScalar
+};
+
+#if defined(VMIC_ARCH_X64)
+// Ocho muestras con las ganancias de Low (0..3) y High (4..7)
+static inline VOID ScaleInt16Sse2(PUCHAR Data, __m128 Low, __m128 High)
+{
+    __m128i samples = _mm_loadu_si128((const __m128i *)Data);
+    __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), samples), 16);
+    __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), samples), 16);
+
+    low = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(low), Low));
+    high = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(high), High));
+    _mm_storeu_si128((__m128i *)Data, _mm_packs_epi32(low, high));
+}
+
+static inline __m128i ScaleInt32Pairs(__m128i Samples, __m128 Gain)
+{
+    __m128d maximum = _mm_set1_pd(GAIN_INT32_MAXIMUM);
+    __m128d minimum = _mm_set1_pd(GAIN_INT32_MINIMUM);
+    __m128d low = _mm_mul_pd(_mm_cvtepi32_pd(Samples), _mm_cvtps_pd(Gain));
+    __m128d high = _mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(Samples, 8)),
+                              _mm_cvtps_pd(_mm_movehl_ps(Gain, Gain)));
+
+    low = _mm_max_pd(_mm_min_pd(low, maximum), minimum);
+    high = _mm_max_pd(_mm_min_pd(high, maximum), minimum);
+    return _mm_unpacklo_epi64(_mm_cvtpd_epi32(low), _mm_cvtpd_epi32(high));
+}
+
+static inline VOID ScaleInt32Sse2(PUCHAR Data, __m128 Low, __m128 High)
+{
+    _mm_storeu_si128((__m128i *)Data, ScaleInt32Pairs(_mm_loadu_si128((const __m128i *)Data), Low));
+    _mm_storeu_si128((__m128i *)(Data + 16),
+                     ScaleInt32Pairs(_mm_loadu_si128((const __m128i *)(Data + 16)), High));
+}
+
+static inline VOID ScaleFloatSse2(PUCHAR Data, __m128 Low, __m128 High)
+{
+    _mm_storeu_ps((float *)Data, _mm_mul_ps(_mm_loadu_ps((const float *)Data), Low));
+    _mm_storeu_ps((float *)(Data + 16), _mm_mul_ps(_mm_loadu_ps((const float *)(Data + 16)), High));
+}
+
+// Log2 de Channels si es potencia de dos (1, 2, 4, 8); -1 en otro caso
+static inline int GainRampChannelShift(ULONG Channels)
+{
+    switch (Channels) {
+        case 1:
+            return 0;
+        case 2:
+            return 1;
+        case 4:
+            return 2;
+        case 8:
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+// Ganancias de las muestras Sample..Sample+3: el frame de cada una sale de un
+// desplazamiento, y la cuenta es la misma que la del escalar
+static inline __m128 RampGains(__m128 Start, __m128 Step, __m128i First, SIZE_T Sample, __m128i Shift)
+{
+    __m128i index = _mm_add_epi32(_mm_set1_epi32((int)Sample), _mm_setr_epi32(0, 1, 2, 3));
+
+    index = _mm_add_epi32(_mm_srl_epi32(index, Shift), First);
+    return _mm_add_ps(Start, _mm_mul_ps(Step, _mm_cvtepi32_ps(index)));
+}
+
+// Las rampas solo recorren frames completos (8 muestras cubren 1, 2, 4 u 8
+// canales sin partir un frame); los demás canales y la cola van al escalar.
+// Las rampas son cortas (GAIN_RAMP_MAX_FRAMES): los índices caben en 32 bits.
+#define DEFINE_SSE2_GAIN(ConstantName, RampName, ScalarConstant, ScalarRamp, Bytes, Scale)        \
+    static VOID ConstantName(PUCHAR Data, SIZE_T Samples, float Gain)                             \
+    {                                                                                             \
+        __m128 gain = _mm_set1_ps(Gain);                                                          \
+        SIZE_T i;                                                                                 \
+        for (i = 0; i + 8 <= Samples; i += 8) {                                                   \
+            Scale(Data + i * (Bytes), gain, gain);                                                \
+        }                                                                                         \
+        ScalarConstant(Data + i * (Bytes), Samples - i, Gain);                                    \
+    }                                                                                             \
+                                                                                                  \
+    static VOID RampName(PUCHAR Data, ULONG Channels, ULONG Frames,                               \
+                         float Start, float Step, ULONG First)                                    \
+    {                                                                                             \
+        int shift = GainRampChannelShift(Channels);                                               \
+        __m128 start = _mm_set1_ps(Start);                                                        \
+        __m128 step = _mm_set1_ps(Step);                                                          \
+        __m128i first = _mm_set1_epi32((int)First);                                               \
+        __m128i shiftCount;                                                                       \
+        SIZE_T samples;                                                                           \
+        SIZE_T i;                                                                                 \
+        ULONG frames;                                                                             \
+        if (shift < 0) {                                                                          \
+            ScalarRamp(Data, Channels, Frames, Start, Step, First);                               \
+            return;                                                                               \
+        }                                                                                         \
+        shiftCount = _mm_cvtsi32_si128(shift);                                                    \
+        samples = ((SIZE_T)Frames * Channels) & ~(SIZE_T)7;                                       \
+        for (i = 0; i < samples; i += 8) {                                                        \
+            Scale(Data + i * (Bytes),                                                             \
+                  RampGains(start, step, first, i, shiftCount),                                   \
+                  RampGains(start, step, first, i + 4, shiftCount));                              \
+        }                                                                                         \
+        frames = (ULONG)(samples >> shift);                                                       \
+        ScalarRamp(Data + samples * (Bytes), Channels, Frames - frames, Start, Step, First + frames); \
+    }
+
+DEFINE_SSE2_GAIN(GainConstantInt16Sse2, GainRampInt16Sse2, GainConstantInt16Scalar, GainRampInt16Scalar,
+                 sizeof(SHORT), ScaleInt16Sse2)
+DEFINE_SSE2_GAIN(GainConstantInt32Sse2, GainRampInt32Sse2, GainConstantInt32Scalar, GainRampInt32Scalar,
+                 sizeof(LONG), ScaleInt32Sse2)
+DEFINE_SSE2_GAIN(GainConstantFloatSse2, GainRampFloatSse2, GainConstantFloatScalar, GainRampFloatScalar,
+                 sizeof(float), ScaleFloatSse2)
+
+// SSE2 no tiene PSHUFB: int24 empaquetado queda en escalar
+static const GAIN_CONSTANT_ROUTINE GainConstantSse2Kernels[SAMPLE_FORMAT_COUNT] = {
+    GainConstantInt16Sse2, GainConstantInt24Scalar, GainConstantInt32Sse2, GainConstantFloatSse2
+};
+
+static const GAIN_RAMP_ROUTINE GainRampSse2Kernels[SAMPLE_FORMAT_COUNT] = {
+    GainRampInt16Sse2, GainRampInt24Scalar, GainRampInt32Sse2, GainRampFloatSse2
+};
+#endif
+
+BOOLEAN GainRampIsValidGain(
+    _In_ float Gain
+)
+{
+    // También rechaza NaN
+    return (Gain >= 0.0f && Gain <= GAIN_RAMP_MAX_GAIN) ? TRUE : FALSE;
+}
+
+NTSTATUS GainRampInitialize(
+    _Out_ PGAIN_RAMP Ramp,
+    _In_ float Gain,
+    _In_ SAMPLE_CONVERT_ISA Isa
+)
+{
+    if (!GainRampIsValidGain(Gain) || (ULONG)Isa >= SAMPLE_CONVERT_ISA_COUNT) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (!SampleConvertIsIsaAvailable(Isa)) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    Ramp->Start = Gain;
+    Ramp->Target = Gain;
+    Ramp->Step = 0.0f;
+    Ramp->Position = 0;
+    Ramp->Length = 0;
+    Ramp->Isa = Isa;
+
+    return STATUS_SUCCESS;
+}
+
+float GainRampGetCurrent(
+    _In_ const GAIN_RAMP *Ramp
+)
+{
+    if (Ramp->Length == 0) {
+        return Ramp->Target;
+    }
+
+    return Ramp->Start + Ramp->Step * (float)Ramp->Position;
+}
+
+VOID GainRampSetTarget(
+    _Inout_ PGAIN_RAMP Ramp,
+    _In_ float Target,
+    _In_ ULONG Frames
+)
+{
+    float current = GainRampGetCurrent(Ramp);
+
+    Ramp->Target = Target;
+    Ramp->Position = 0;
+
+    if (Frames == 0 || current == Target) {
+        Ramp->Start = Target;
+        Ramp->Step = 0.0f;
+        Ramp->Length = 0;
+        return;
+    }
+
+    // Con el límite, los índices de frame son exactos en float
+    Frames = min(Frames, GAIN_RAMP_MAX_FRAMES);
+
+    Ramp->Start = current;
+    Ramp->Step = (Target - current) / (float)Frames;
+    Ramp->Length = Frames;
+}
+
+BOOLEAN GainRampIsSilent(
+    _In_ const GAIN_RAMP *Ramp
+)
+{
+    return (Ramp->Length == 0 && Ramp->Target == 0.0f) ? TRUE : FALSE;
+}
+
+BOOLEAN GainRampIsUnity(
+    _In_ const GAIN_RAMP *Ramp
+)
+{
+    return (Ramp->Length == 0 && Ramp->Target == 1.0f) ? TRUE : FALSE;
+}
+
+VOID GainRampApply(
+    _Inout_ PGAIN_RAMP Ramp,
+    _In_ SAMPLE_FORMAT Format,
+    _In_ ULONG Channels,
+    _Inout_ PVOID Data,
+    _In_ ULONG Frames
+)
+{
+    const GAIN_CONSTANT_ROUTINE *constantKernels = GainConstantScalarKernels;
+    const GAIN_RAMP_ROUTINE *rampKernels = GainRampScalarKernels;
+    SIZE_T frameSize = (SIZE_T)SampleFormatGetBytes(Format) * Channels;
+    PUCHAR data = (PUCHAR)Data;
+    ULONG frames;
+
+#if defined(VMIC_ARCH_X64)
+    if (Ramp->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        constantKernels = GainConstantSse2Kernels;
+        rampKernels = GainRampSse2Kernels;
+    }
+#endif
+
+    if (Ramp->Length != 0) {
+        frames = min(Frames, Ramp->Length - Ramp->Position);
+        rampKernels[Format](data, Channels, frames, Ramp->Start, Ramp->Step, Ramp->Position + 1);
+
+        Ramp->Position += frames;
+        if (Ramp->Position == Ramp->Length) {
+            Ramp->Start = Ramp->Target;
+            Ramp->Step = 0.0f;
+            Ramp->Position = 0;
+            Ramp->Length = 0;
+        }
+
+        data += frames * frameSize;
+        Frames -= frames;
+    }
+
+    // Ganancia estable
+    if (Frames == 0 || Ramp->Target == 1.0f) {
+        return;
+    }
+
+    if (Ramp->Target == 0.0f) {
+        RtlZeroMemory(data, Frames * frameSize);
+        return;
+    }
+
+    constantKernels[Format](data, (SIZE_T)Frames * Channels, Ramp->Target);
+}
@@ -0,0 +1,474 @@
+#include "jitter_buffer.h"
+#include "ring_buffer.h"
+
+// La ventana es un anillo de Capacity frames indexado por (Timestamp & Mask)
+// con un bit de presencia por frame. Los bits se borran al entregar, así que
+// fuera de [Next, End) siempre están a cero.
+
+#define JITTER_BUFFER_MIN_SAMPLES 8        // Tránsitos antes de recalcular el objetivo
+#define JITTER_BUFFER_MIN_CAPACITY 1024
+
+#define JITTER_BUFFER_ALIGN(size) (((size) + VMIC_CACHE_LINE - 1) & ~(SIZE_T)(VMIC_CACHE_LINE - 1))
+
+// Tramo devuelto por el último JitterBufferPeek
+#define JITTER_RUN_NONE    0
+#define JITTER_RUN_DATA    1
+#define JITTER_RUN_CONCEAL 2
+#define JITTER_RUN_STRETCH 3
+
+typedef struct _JITTER_BUFFER_LAYOUT {
+    ULONG Capacity;
+    SIZE_T StorageOffset;
+    SIZE_T PresentOffset;
+    SIZE_T SilenceOffset;
+    SIZE_T Size;
+} JITTER_BUFFER_LAYOUT;
+
+static BOOLEAN JitterBufferGetLayout(
+    _In_ const JITTER_BUFFER_CONFIG *Config,
+    _Out_ JITTER_BUFFER_LAYOUT *Layout
+)
+{
+    if (!JitterBufferIsValidConfig(Config)) {
+        return FALSE;
+    }
+
+    // Caben el retardo máximo y otro tanto de paquetes adelantados
+    Layout->Capacity = RingBufferRoundUpCapacity(max(2 * Config->MaxDelay, JITTER_BUFFER_MIN_CAPACITY));
+
+    Layout->StorageOffset = JITTER_BUFFER_ALIGN(sizeof(JITTER_BUFFER));
+    Layout->PresentOffset = Layout->StorageOffset +
+                            JITTER_BUFFER_ALIGN((SIZE_T)Layout->Capacity * Config->FrameSize);
+    Layout->SilenceOffset = Layout->PresentOffset + JITTER_BUFFER_ALIGN(Layout->Capacity / 8);
+    Layout->Size = Layout->SilenceOffset +
+                   JITTER_BUFFER_ALIGN((SIZE_T)JITTER_BUFFER_SILENCE_FRAMES * Config->FrameSize);
+
+    return TRUE;
+}
+
+// Pone a Value los bits [Index, Index + Count) (sin vuelta)
+static VOID JitterSetBits(
+    _Inout_ PULONG Bits,
+    _In_ ULONG Index,
+    _In_ ULONG Count,
+    _In_ BOOLEAN Value
+)
+{
+    ULONG bit;
+    ULONG chunk;
+    ULONG mask;
+
+    while (Count > 0) {
+        bit = Index & 31;
+        chunk = min(32 - bit, Count);
+        mask = (chunk == 32) ? MAXULONG : (((1UL << chunk) - 1) << bit);
+
+        if (Value) {
+            Bits[Index >> 5] |= mask;
+        } else {
+            Bits[Index >> 5] &= ~mask;
+        }
+
+        Index += chunk;
+        Count -= chunk;
+    }
+}
+
+// Bits seguidos a Value desde Index, como mucho Limit (sin vuelta)
+static ULONG JitterCountRun(
+    _In_ const ULONG *Bits,
+    _In_ ULONG Index,
+    _In_ ULONG Limit,
+    _In_ BOOLEAN Value
+)
+{
+    ULONG run = 0;
+    ULONG bit;
+    ULONG chunk;
+    ULONG bits;
+    ULONG count;
+
+    while (run < Limit) {
+        bit = Index & 31;
+        chunk = 32 - bit;
+        bits = (Value ? Bits[Index >> 5] : ~Bits[Index >> 5]) >> bit;
+
+        if (bits == (MAXULONG >> bit)) {
+            count = chunk;
+        } else {
+            count = 0;
+            while (bits & 1) {
+                bits >>= 1;
+                count++;
+            }
+        }
+
+        count = min(count, Limit - run);
+        run += count;
+        Index += count;
+
+        if (count < chunk) {
+            break;
+        }
+    }
+
+    return run;
+}
+
+// Olvida los tránsitos (el origen de las marcas de tiempo puede haber
+// cambiado); el objetivo se conserva hasta tener muestras nuevas
+static VOID JitterClearHistory(
+    _Inout_ PJITTER_BUFFER JitterBuffer
+)
+{
+    JitterBuffer->TransitCount = 0;
+    JitterBuffer->TransitIndex = 0;
+}
+
+static VOID JitterAddTransit(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ LONG64 Transit
+)
+{
+    LONG64 *sorted = JitterBuffer->Sorted;
+    LONG64 oldest;
+    LONG64 relative;
+    ULONG count = JitterBuffer->TransitCount;
+    ULONG position;
+
+    // Con la historia llena sale el más antiguo
+    if (count == JITTER_BUFFER_HISTORY) {
+        oldest = JitterBuffer->Transits[JitterBuffer->TransitIndex];
+        for (position = 0; position < count - 1 && sorted[position] != oldest; position++) {
+        }
+        RtlMoveMemory(&sorted[position], &sorted[position + 1], (SIZE_T)(count - position - 1) * sizeof(LONG64));
+        count--;
+    }
+
+    position = count;
+    while (position > 0 && sorted[position - 1] > Transit) {
+        sorted[position] = sorted[position - 1];
+        position--;
+    }
+    sorted[position] = Transit;
+
+    JitterBuffer->Transits[JitterBuffer->TransitIndex] = Transit;
+    JitterBuffer->TransitIndex = (JitterBuffer->TransitIndex + 1) % JITTER_BUFFER_HISTORY;
+    JitterBuffer->TransitCount = ++count;
+
+    if (count >= JITTER_BUFFER_MIN_SAMPLES) {
+        relative = sorted[(count - 1) * JitterBuffer->Config.Percentile / 100] - sorted[0];
+        relative = max(relative, (LONG64)JitterBuffer->Config.MinDelay);
+        relative = min(relative, (LONG64)JitterBuffer->Config.MaxDelay);
+        JitterBuffer->TargetDelay = (ULONG)relative;
+    }
+}
+
+// Base deseada: tránsito mínimo más el retardo objetivo
+static LONG64 JitterGetDesiredBase(
+    _In_ const JITTER_BUFFER *JitterBuffer
+)
+{
+    return JitterBuffer->Sorted[0] + (LONG64)JitterBuffer->TargetDelay;
+}
+
+static VOID JitterClearWindow(
+    _Inout_ PJITTER_BUFFER JitterBuffer
+)
+{
+    RtlZeroMemory(JitterBuffer->Present, JitterBuffer->Capacity / 8);
+}
+
+// Vuelve a cebar desde Timestamp
+static VOID JitterRestart(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG64 Timestamp
+)
+{
+    JitterBuffer->State = JITTER_BUFFER_STATE_PRIMING;
+    JitterBuffer->Next = Timestamp;
+    JitterBuffer->End = Timestamp;
+    JitterBuffer->Base = 0;
+    JitterBuffer->ConcealedRun = 0;
+}
+
+BOOLEAN JitterBufferIsValidConfig(
+    _In_ const JITTER_BUFFER_CONFIG *Config
+)
+{
+    return Config != NULL &&
+           Config->FrameSize != 0 && Config->FrameSize <= JITTER_BUFFER_MAX_FRAME_SIZE &&
+           Config->MinDelay <= Config->MaxDelay &&
+           Config->MaxDelay <= JITTER_BUFFER_MAX_DELAY_FRAMES &&
+           Config->Percentile >= 1 && Config->Percentile <= 100;
+}
+
+SIZE_T JitterBufferGetRequiredSize(
+    _In_ const JITTER_BUFFER_CONFIG *Config
+)
+{
+    JITTER_BUFFER_LAYOUT layout;
+
+    if (!JitterBufferGetLayout(Config, &layout)) {
+        return 0;
+    }
+
+    return layout.Size;
+}
+
+NTSTATUS JitterBufferInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const JITTER_BUFFER_CONFIG *Config,
+    _Out_ PJITTER_BUFFER *JitterBuffer
+)
+{
+    JITTER_BUFFER_LAYOUT layout;
+    PJITTER_BUFFER jitterBuffer = (PJITTER_BUFFER)Memory;
+    PUCHAR base = (PUCHAR)Memory;
+
+    *JitterBuffer = NULL;
+
+    if (!JitterBufferGetLayout(Config, &layout)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Memory == NULL || Size < layout.Size) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    RtlZeroMemory(jitterBuffer, sizeof(JITTER_BUFFER));
+
+    jitterBuffer->Config = *Config;
+    jitterBuffer->Capacity = layout.Capacity;
+    jitterBuffer->Mask = layout.Capacity - 1;
+    jitterBuffer->Storage = base + layout.StorageOffset;
+    jitterBuffer->Present = (PULONG)(base + layout.PresentOffset);
+    jitterBuffer->Silence = base + layout.SilenceOffset;
+    jitterBuffer->TargetDelay = Config->MinDelay;
+
+    RtlZeroMemory(jitterBuffer->Silence, (SIZE_T)JITTER_BUFFER_SILENCE_FRAMES * Config->FrameSize);
+    JitterBufferReset(jitterBuffer);
+
+    *JitterBuffer = jitterBuffer;
+    return STATUS_SUCCESS;
+}
+
+VOID JitterBufferReset(
+    _Inout_ PJITTER_BUFFER JitterBuffer
+)
+{
+    JitterClearWindow(JitterBuffer);
+    JitterBuffer->State = JITTER_BUFFER_STATE_IDLE;
+    JitterBuffer->Next = 0;
+    JitterBuffer->End = 0;
+    JitterBuffer->Base = 0;
+    JitterBuffer->ConcealedRun = 0;
+    JitterBuffer->RunKind = JITTER_RUN_NONE;
+}
+
+VOID JitterBufferInsert(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG64 Timestamp,
+    _In_ const VOID *Data,
+    _In_ ULONG Frames,
+    _In_ ULONG64 Now
+)
+{
+    const UCHAR *data = (const UCHAR *)Data;
+    ULONG frameSize = JitterBuffer->Config.FrameSize;
+    ULONG capacity = JitterBuffer->Capacity;
+    LONG64 distance;
+    ULONG64 skip;
+    ULONG index;
+    ULONG chunk;
+
+    if (Frames == 0) {
+        return;
+    }
+
+    distance = (LONG64)(Timestamp - JitterBuffer->Next);
+
+    if (JitterBuffer->State == JITTER_BUFFER_STATE_IDLE) {
+        JitterRestart(JitterBuffer, Timestamp);
+    } else if (distance >= 2 * (LONG64)capacity || distance + (LONG64)Frames < -(LONG64)capacity) {
+        // Salto de las marcas de tiempo (productor reiniciado): lo guardado
+        // pertenece a otra línea de tiempo
+        JitterClearWindow(JitterBuffer);
+        JitterClearHistory(JitterBuffer);
+        JitterRestart(JitterBuffer, Timestamp);
+        JitterBuffer->Stats.Resyncs++;
+    } else if (JitterBuffer->State == JITTER_BUFFER_STATE_PRIMING && distance < 0 &&
+               JitterBuffer->End - Timestamp <= capacity) {
+        // Aún no ha salido nada: un paquete anterior adelanta el principio
+        JitterBuffer->Next = Timestamp;
+        JitterBuffer->Stats.PacketsReordered++;
+    } else if (Timestamp < JitterBuffer->End) {
+        JitterBuffer->Stats.PacketsReordered++;
+    }
+
+    // También los paquetes tardíos informan del jitter
+    JitterAddTransit(JitterBuffer, (LONG64)(Now - Timestamp));
+
+    // Lo que ya se entregó (o se ocultó) llega tarde
+    if (Timestamp < JitterBuffer->Next) {
+        skip = min(JitterBuffer->Next - Timestamp, (ULONG64)Frames);
+        JitterBuffer->Stats.FramesLate += skip;
+        data += (SIZE_T)skip * frameSize;
+        Frames -= (ULONG)skip;
+        Timestamp += skip;
+    }
+
+    // Lo que no cabe en la ventana se descarta
+    if (Timestamp + Frames > JitterBuffer->Next + capacity) {
+        skip = min(Timestamp + Frames - (JitterBuffer->Next + capacity), (ULONG64)Frames);
+        JitterBuffer->Stats.FramesOverflow += skip;
+        Frames -= (ULONG)skip;
+    }
+
+    if (Frames == 0) {
+        return;
+    }
+
+    JitterBuffer->End = max(JitterBuffer->End, Timestamp + Frames);
+
+    while (Frames > 0) {
+        index = (ULONG)(Timestamp & JitterBuffer->Mask);
+        chunk = min(Frames, capacity - index);
+
+        RtlCopyMemory(JitterBuffer->Storage + (SIZE_T)index * frameSize, data, (SIZE_T)chunk * frameSize);
+        JitterSetBits(JitterBuffer->Present, index, chunk, TRUE);
+
+        data += (SIZE_T)chunk * frameSize;
+        Frames -= chunk;
+        Timestamp += chunk;
+    }
+}
+
+BOOLEAN JitterBufferPeek(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG64 Now,
+    _Out_ const VOID **Data,
+    _Out_ PULONG Frames
+)
+{
+    ULONG index = (ULONG)(JitterBuffer->Next & JitterBuffer->Mask);
+    ULONG limit = JitterBuffer->Capacity - index;
+    ULONG64 pending;
+    LONG64 desired;
+    LONG64 due;
+    ULONG run;
+
+    *Data = NULL;
+    *Frames = 0;
+    JitterBuffer->RunKind = JITTER_RUN_NONE;
+
+    if (JitterBuffer->State == JITTER_BUFFER_STATE_IDLE) {
+        return FALSE;
+    }
+
+    desired = JitterGetDesiredBase(JitterBuffer);
+
+    // El primer frame sale cuando vence con el retardo objetivo
+    if (JitterBuffer->State == JITTER_BUFFER_STATE_PRIMING) {
+        if ((LONG64)(Now - JitterBuffer->Next) < desired) {
+            return FALSE;
+        }
+        JitterBuffer->Base = desired;
+        JitterBuffer->State = JITTER_BUFFER_STATE_PLAYING;
+    }
+
+    pending = (JitterBuffer->End > JitterBuffer->Next) ? JitterBuffer->End - JitterBuffer->Next : 0;
+
+    // Lo recibido en orden sale sin esperar: el retraso lo absorbe el anillo
+    run = JitterCountRun(JitterBuffer->Present, index, (ULONG)min(pending, (ULONG64)limit), TRUE);
+    if (run > 0) {
+        JitterBuffer->RunKind = JITTER_RUN_DATA;
+        *Data = JitterBuffer->Storage + (SIZE_T)index * JitterBuffer->Config.FrameSize;
+        *Frames = run;
+        return TRUE;
+    }
+
+    // Hueco en Next: se espera hasta que venza
+    due = (LONG64)(Now - JitterBuffer->Next) - JitterBuffer->Base;
+    if (due <= 0) {
+        return FALSE;
+    }
+
+    // El jitter ha crecido: más retardo antes de dar el hueco por perdido
+    if (desired > JitterBuffer->Base) {
+        JitterBuffer->RunKind = JITTER_RUN_STRETCH;
+        *Data = JitterBuffer->Silence;
+        *Frames = (ULONG)min(desired - JitterBuffer->Base, (LONG64)JITTER_BUFFER_SILENCE_FRAMES);
+        return TRUE;
+    }
+
+    // Sin nada pendiente durante MaxDelay frames el productor se ha parado
+    if (pending == 0 && JitterBuffer->ConcealedRun >= JitterBuffer->Config.MaxDelay) {
+        JitterClearHistory(JitterBuffer);
+        JitterBuffer->State = JITTER_BUFFER_STATE_IDLE;
+        return FALSE;
+    }
+
+    run = (pending > 0) ? JitterCountRun(JitterBuffer->Present, index, (ULONG)min(pending, (ULONG64)limit), FALSE)
+                        : limit;
+    run = (ULONG)min((LONG64)run, due);
+
+    JitterBuffer->RunKind = JITTER_RUN_CONCEAL;
+    *Data = JitterBuffer->Silence;
+    *Frames = min(run, JITTER_BUFFER_SILENCE_FRAMES);
+    return TRUE;
+}
+
+VOID JitterBufferConsume(
+    _Inout_ PJITTER_BUFFER JitterBuffer,
+    _In_ ULONG Frames
+)
+{
+    if (Frames == 0) {
+        return;
+    }
+
+    switch (JitterBuffer->RunKind) {
+        case JITTER_RUN_DATA:
+            JitterSetBits(JitterBuffer->Present, (ULONG)(JitterBuffer->Next & JitterBuffer->Mask), Frames, FALSE);
+            JitterBuffer->Next += Frames;
+            JitterBuffer->ConcealedRun = 0;
+            JitterBuffer->Stats.FramesReleased += Frames;
+            break;
+
+        case JITTER_RUN_CONCEAL:
+            JitterBuffer->Next += Frames;
+            JitterBuffer->End = max(JitterBuffer->End, JitterBuffer->Next);
+            JitterBuffer->ConcealedRun += Frames;
+            JitterBuffer->Stats.FramesConcealed += Frames;
+            break;
+
+        case JITTER_RUN_STRETCH:
+            JitterBuffer->Base += Frames;
+            JitterBuffer->Stats.FramesStretched += Frames;
+            break;
+
+        default:
+            return;
+    }
+
+    JitterBuffer->RunKind = JITTER_RUN_NONE;
+}
+
+VOID JitterBufferGetStats(
+    _In_ const JITTER_BUFFER *JitterBuffer,
+    _Out_ PJITTER_BUFFER_STATS Stats
+)
+{
+    *Stats = JitterBuffer->Stats;
+    Stats->TargetDelay = JitterBuffer->TargetDelay;
+    Stats->PlayoutDelay = 0;
+    Stats->State = JitterBuffer->State;
+    Stats->Reserved = 0;
+
+    if (JitterBuffer->State == JITTER_BUFFER_STATE_PLAYING && JitterBuffer->TransitCount > 0 &&
+        JitterBuffer->Base > JitterBuffer->Sorted[0]) {
+        Stats->PlayoutDelay = (ULONG)(JitterBuffer->Base - JitterBuffer->Sorted[0]);
+    }
+}
@@ -0,0 +1,164 @@
+#include "latency_histogram.h"
+
+#define LATENCY_HISTOGRAM_EXACT (2UL << LATENCY_HISTOGRAM_SUB_BITS) // Valores con cubo propio
+#define LATENCY_HISTOGRAM_LIMIT (1ULL << LATENCY_HISTOGRAM_MAX_BITS)
+
+// Los valores exactos ocupan los primeros cubos; a partir de ahí cada octava
+// [2^k, 2^(k+1)) se parte en 2^SUB_BITS cubos de ancho 2^shift, con
+// shift = k - SUB_BITS, y el índice sale de los bits altos del valor
+static ULONG LatencyHistogramGetBucket(ULONG64 Value)
+{
+    ULONG shift;
+
+    if (Value >= LATENCY_HISTOGRAM_LIMIT) {
+        Value = LATENCY_HISTOGRAM_LIMIT - 1;
+    }
+
+    if (Value < LATENCY_HISTOGRAM_EXACT) {
+        return (ULONG)Value;
+    }
+
+    shift = VmicHighestSetBit64(Value) - LATENCY_HISTOGRAM_SUB_BITS;
+    return (shift << LATENCY_HISTOGRAM_SUB_BITS) + (ULONG)(Value >> shift);
+}
+
+// Mayor valor que cae en el cubo
+static ULONG64 LatencyHistogramGetBucketTop(ULONG Bucket)
+{
+    ULONG shift;
+
+    if (Bucket < LATENCY_HISTOGRAM_EXACT) {
+        return Bucket;
+    }
+
+    shift = (Bucket >> LATENCY_HISTOGRAM_SUB_BITS) - 1;
+    return ((ULONG64)(Bucket - (shift << LATENCY_HISTOGRAM_SUB_BITS)) << shift) + (1ULL << shift) - 1;
+}
+
+VOID LatencyHistogramReset(
+    _Out_ PLATENCY_HISTOGRAM Histogram
+)
+{
+    RtlZeroMemory(Histogram, sizeof(LATENCY_HISTOGRAM));
+}
+
+VOID LatencyHistogramRecord(
+    _Inout_ PLATENCY_HISTOGRAM Histogram,
+    _In_ ULONG64 Value
+)
+{
+    PULONG bucket = &Histogram->Buckets[LatencyHistogramGetBucket(Value)];
+
+    // Un cubo lleno deja de contar en lugar de volver a cero
+    if (*bucket != MAXULONG) {
+        (*bucket)++;
+    }
+
+    Histogram->Count++;
+    Histogram->Max = max(Histogram->Max, Value);
+}
+
+ULONG64 LatencyHistogramGetPercentile(
+    _In_ const LATENCY_HISTOGRAM *Histogram,
+    _In_ ULONG PartsPerMillion
+)
+{
+    ULONG64 rank;
+    ULONG64 seen = 0;
+    ULONG bucket;
+
+    if (Histogram->Count == 0) {
+        return 0;
+    }
+
+    // Posición (desde 1) del valor pedido en la ventana ordenada
+    rank = (Histogram->Count * min(PartsPerMillion, 1000000) + 999999) / 1000000;
+    rank = max(rank, 1);
+
+    for (bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++) {
+        seen += Histogram->Buckets[bucket];
+        if (seen >= rank) {
+            break;
+        }
+    }
+
+    // El último cubo recoge los valores saturados: su límite no los acota
+    if (bucket >= LATENCY_HISTOGRAM_BUCKETS - 1) {
+        return Histogram->Max;
+    }
+
+    return min(LatencyHistogramGetBucketTop(bucket), Histogram->Max);
+}
+
+VOID LatencyTagsReset(
+    _Out_ PLATENCY_TAGS Tags,
+    _In_ ULONG64 Position
+)
+{
+    Tags->Head = 0;
+    Tags->Tail = 0;
+    Tags->LastEnd = Position;
+    Tags->UntaggedTime = 0;
+    Tags->Untagged = FALSE;
+}
+
+VOID LatencyTagsMark(
+    _Inout_ PLATENCY_TAGS Tags,
+    _In_ ULONG64 End,
+    _In_ ULONG64 Time
+)
+{
+    ULONG64 head = Tags->Head;
+    PLATENCY_TAG tag;
+
+    if (End == Tags->LastEnd) {
+        return;
+    }
+
+    Tags->LastEnd = End;
+
+    // Cola llena: la primera marca que entre cubrirá también estos frames
+    if (head - VmicReadAcquire64(&Tags->Tail) >= LATENCY_TAGS_COUNT) {
+        if (!Tags->Untagged) {
+            Tags->UntaggedTime = Time;
+            Tags->Untagged = TRUE;
+        }
+        return;
+    }
+
+    tag = &Tags->Tags[head & (LATENCY_TAGS_COUNT - 1)];
+    tag->End = End;
+    tag->Time = Tags->Untagged ? Tags->UntaggedTime : Time;
+    Tags->Untagged = FALSE;
+
+    VmicWriteRelease64(&Tags->Head, head + 1);
+}
+
+BOOLEAN LatencyTagsGetAge(
+    _Inout_ PLATENCY_TAGS Tags,
+    _In_ ULONG64 Position,
+    _In_ ULONG64 Now,
+    _Out_ PULONG64 Age
+)
+{
+    ULONG64 head = VmicReadAcquire64(&Tags->Head);
+    ULONG64 tail = Tags->Tail;
+    PLATENCY_TAG tag;
+
+    *Age = 0;
+
+    // Las marcas que terminan antes de Position ya se leyeron o se descartaron
+    while (tail != head && Tags->Tags[tail & (LATENCY_TAGS_COUNT - 1)].End <= Position) {
+        tail++;
+    }
+
+    VmicWriteRelease64(&Tags->Tail, tail);
+
+    if (tail == head) {
+        return FALSE;
+    }
+
+    tag = &Tags->Tags[tail & (LATENCY_TAGS_COUNT - 1)];
+    *Age = (Now > tag->Time) ? Now - tag->Time : 0;
+    return TRUE;
+}
@@ -0,0 +1,286 @@
+#include "level_meter.h"
+#include "level_meter_kernels.h"
+
+// Los núcleos SSE2 miden 8 muestras por vuelta: con 1, 2, 4 u 8 canales el
+// carril i siempre corresponde al canal i % Channels, así que se acumula por
+// carriles y se pliega a canales al final. int32 y float pasan a float sin
+// normalizar (la escala es una potencia de dos y se aplica al plegar, con el
+// mismo resultado que el escalar); int16 se mide en enteros. El acumulador por
+// carriles está en level_meter_kernels.h. Como en gain_ramp.c, SSE2 no necesita
+// guardar estado extendido en el kernel.
+
+typedef VOID (*LEVEL_METER_ROUTINE)(PLEVEL_METER Meter, const UCHAR *Data, ULONG Frames);
+
+#define LEVEL_METER_INT16_SCALE (1.0f / 32768.0f)
+#define LEVEL_METER_INT24_SCALE (1.0f / 8388608.0f)
+#define LEVEL_METER_INT32_SCALE (1.0f / 2147483648.0f)
+
+static inline float LoadInt16(const UCHAR *Data, SIZE_T Index)
+{
+    return (float)((const SHORT *)Data)[Index] * LEVEL_METER_INT16_SCALE;
+}
+
+static inline float LoadInt24(const UCHAR *Data, SIZE_T Index)
+{
+    const UCHAR *sample = Data + Index * 3;
+    LONG value = (LONG)(((ULONG)sample[0] << 8) | ((ULONG)sample[1] << 16) | ((ULONG)sample[2] << 24)) >> 8;
+
+    return (float)value * LEVEL_METER_INT24_SCALE;
+}
+
+static inline float LoadInt32(const UCHAR *Data, SIZE_T Index)
+{
+    return (float)((const LONG *)Data)[Index] * LEVEL_METER_INT32_SCALE;
+}
+
+static inline float LoadFloat(const UCHAR *Data, SIZE_T Index)
+{
+    return ((const float *)Data)[Index];
+}
+
+// Un NaN no cambia el pico ni cuenta como saturado (igual que MAXPS/CMPPS).
+// Se acumula en variables locales: Data es de bytes y podría solapar Meter.
+#define DEFINE_SCALAR_METER(Name, Load)                                            \
+    static VOID Name(PLEVEL_METER Meter, const UCHAR *Data, ULONG Frames)          \
+    {                                                                              \
+        float peaks[LEVEL_METER_MAX_CHANNELS] = { 0 };                             \
+        double sums[LEVEL_METER_MAX_CHANNELS] = { 0 };                             \
+        ULONG64 clips[LEVEL_METER_MAX_CHANNELS] = { 0 };                           \
+        float threshold = Meter->ClipThreshold;                                    \
+        ULONG channels = Meter->Channels;                                          \
+        SIZE_T index = 0;                                                          \
+        ULONG frame;                                                               \
+        ULONG channel;                                                             \
+        float value;                                                               \
+        for (frame = 0; frame < Frames; frame++) {                                 \
+            for (channel = 0; channel < channels; channel++) {                     \
+                value = Load(Data, index++);                                       \
+                value = (value < 0.0f) ? -value : value;                           \
+                peaks[channel] = (value > peaks[channel]) ? value : peaks[channel]; \
+                sums[channel] += (double)(value * value);                          \
+                clips[channel] += (value >= threshold) ? 1 : 0;                    \
+            }                                                                      \
+        }                                                                          \
+        for (channel = 0; channel < channels; channel++) {                         \
+            if (peaks[channel] > Meter->Peak[channel]) {                           \
+                Meter->Peak[channel] = peaks[channel];                             \
+            }                                                                      \
+            Meter->SumSquares[channel] += sums[channel];                           \
+            Meter->Clips[channel] += clips[channel];                               \
+        }                                                                          \
+    }
+
+DEFINE_SCALAR_METER(LevelMeterInt16Scalar, LoadInt16)
+DEFINE_SCALAR_METER(LevelMeterInt24Scalar, LoadInt24)
+DEFINE_SCALAR_METER(LevelMeterInt32Scalar, LoadInt32)
+DEFINE_SCALAR_METER(LevelMeterFloatScalar, LoadFloat)
+
+static const LEVEL_METER_ROUTINE LevelMeterScalarKernels[SAMPLE_FORMAT_COUNT] = {
+    LevelMeterInt16Scalar, LevelMeterInt24Scalar, LevelMeterInt32Scalar, LevelMeterFloatScalar
+};
+
+#if defined(VMIC_ARCH_X64)
+// Ocho muestras sin normalizar en Low (0..3) y High (4..7)
+static inline VOID LoadInt32Sse2(const UCHAR *Data, __m128 *Low, __m128 *High)
+{
+    *Low = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)Data));
+    *High = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(Data + 16)));
+}
+
+static inline VOID LoadFloatSse2(const UCHAR *Data, __m128 *Low, __m128 *High)
+{
+    *Low = _mm_loadu_ps((const float *)Data);
+    *High = _mm_loadu_ps((const float *)(Data + 16));
+}
+
+// Las muestras que no completan un grupo de 8 (siempre frames enteros) y los
+// canales que no reparten 8 carriles van al escalar
+#define DEFINE_SSE2_METER(Name, ScalarName, Bytes, Load)                                          \
+    static VOID Name(PLEVEL_METER Meter, const UCHAR *Data, ULONG Frames)                         \
+    {                                                                                             \
+        LEVEL_METER_LANES lanes;                                                                  \
+        __m128 low;                                                                               \
+        __m128 high;                                                                              \
+        SIZE_T samples;                                                                           \
+        SIZE_T i;                                                                                 \
+        if (!LevelMeterUsesLanes(Meter->Channels)) {                                              \
+            ScalarName(Meter, Data, Frames);                                                      \
+            return;                                                                               \
+        }                                                                                         \
+        samples = ((SIZE_T)Frames * Meter->Channels) & ~(SIZE_T)7;                                \
+        LevelMeterLanesStart(Meter, &lanes);                                                      \
+        for (i = 0; i < samples; i += 8) {                                                        \
+            Load(Data + i * (Bytes), &low, &high);                                                \
+            LevelMeterLanesAdd(&lanes, low, high);                                                \
+        }                                                                                         \
+        LevelMeterLanesFinish(Meter, &lanes);                                                     \
+        ScalarName(Meter, Data + samples * (Bytes), Frames - (ULONG)(samples / Meter->Channels)); \
+    }
+
+DEFINE_SSE2_METER(LevelMeterInt32Sse2, LevelMeterInt32Scalar, sizeof(LONG), LoadInt32Sse2)
+DEFINE_SSE2_METER(LevelMeterFloatSse2, LevelMeterFloatScalar, sizeof(float), LoadFloatSse2)
+
+// int16 se mide en enteros (LEVEL_METER_INT16_LANES)
+static VOID LevelMeterInt16Sse2(PLEVEL_METER Meter, const UCHAR *Data, ULONG Frames)
+{
+    LEVEL_METER_INT16_LANES lanes;
+    SIZE_T samples;
+    SIZE_T i;
+
+    if (!LevelMeterUsesLanes(Meter->Channels)) {
+        LevelMeterInt16Scalar(Meter, Data, Frames);
+        return;
+    }
+
+    samples = ((SIZE_T)Frames * Meter->Channels) & ~(SIZE_T)7;
+    LevelMeterInt16LanesStart(&lanes);
+    for (i = 0; i < samples; i += 8) {
+        LevelMeterInt16LanesAdd(&lanes, _mm_loadu_si128((const __m128i *)(Data + i * sizeof(SHORT))));
+    }
+
+    LevelMeterInt16LanesFinish(Meter, &lanes);
+    LevelMeterInt16Scalar(Meter, Data + samples * sizeof(SHORT), Frames - (ULONG)(samples / Meter->Channels));
+}
+
+// SSE2 no tiene PSHUFB: int24 empaquetado queda en escalar
+static const LEVEL_METER_ROUTINE LevelMeterSse2Kernels[SAMPLE_FORMAT_COUNT] = {
+    LevelMeterInt16Sse2, LevelMeterInt24Scalar, LevelMeterInt32Sse2, LevelMeterFloatSse2
+};
+#endif
+
+// Raíz cuadrada sin la CRT
+static float SquareRoot(double Value)
+{
+#if defined(VMIC_ARCH_X64)
+    return (float)_mm_cvtsd_f64(_mm_sqrt_sd(_mm_setzero_pd(), _mm_set_sd(Value)));
+#else
+    double root = (Value > 1.0) ? Value : 1.0;
+    ULONG i;
+
+    if (Value <= 0.0) {
+        return 0.0f;
+    }
+
+    // Newton desde arriba: decrece hasta la raíz
+    for (i = 0; i < 64; i++) {
+        root = 0.5 * (root + Value / root);
+    }
+
+    return (float)root;
+#endif
+}
+
+NTSTATUS LevelMeterInitialize(
+    _Out_ PLEVEL_METER Meter,
+    _In_ SAMPLE_FORMAT Format,
+    _In_ ULONG Channels,
+    _In_ SAMPLE_CONVERT_ISA Isa
+)
+{
+    if ((ULONG)Format >= SAMPLE_FORMAT_COUNT || Channels == 0 || Channels > LEVEL_METER_MAX_CHANNELS ||
+        (ULONG)Isa >= SAMPLE_CONVERT_ISA_COUNT) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (!SampleConvertIsIsaAvailable(Isa)) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    Meter->Format = Format;
+    Meter->Channels = Channels;
+    Meter->Isa = Isa;
+
+    switch (Format) {
+        case SAMPLE_FORMAT_INT16:
+            Meter->Scale = LEVEL_METER_INT16_SCALE;
+            Meter->ClipThreshold = 32767.0f * LEVEL_METER_INT16_SCALE;
+            break;
+        case SAMPLE_FORMAT_INT24:
+            Meter->Scale = LEVEL_METER_INT24_SCALE;
+            Meter->ClipThreshold = 8388607.0f * LEVEL_METER_INT24_SCALE;
+            break;
+        case SAMPLE_FORMAT_INT32:
+            // En float el máximo ya redondea a 2^31
+            Meter->Scale = LEVEL_METER_INT32_SCALE;
+            Meter->ClipThreshold = 1.0f;
+            break;
+        default:
+            Meter->Scale = 1.0f;
+            Meter->ClipThreshold = 1.0f;
+            break;
+    }
+
+    LevelMeterReset(Meter);
+    return STATUS_SUCCESS;
+}
+
+VOID LevelMeterReset(
+    _Inout_ PLEVEL_METER Meter
+)
+{
+    Meter->Frames = 0;
+    RtlZeroMemory(Meter->Peak, sizeof(Meter->Peak));
+    RtlZeroMemory(Meter->SumSquares, sizeof(Meter->SumSquares));
+    RtlZeroMemory(Meter->Clips, sizeof(Meter->Clips));
+}
+
+VOID LevelMeterProcess(
+    _Inout_ PLEVEL_METER Meter,
+    _In_ const VOID *Data,
+    _In_ ULONG Frames
+)
+{
+    const LEVEL_METER_ROUTINE *kernels = LevelMeterScalarKernels;
+
+#if defined(VMIC_ARCH_X64)
+    if (Meter->Isa != SAMPLE_CONVERT_ISA_SCALAR) {
+        kernels = LevelMeterSse2Kernels;
+    }
+#endif
+
+    if (Frames == 0) {
+        return;
+    }
+
+    kernels[Meter->Format](Meter, (const UCHAR *)Data, Frames);
+    Meter->Frames += Frames;
+}
+
+VOID LevelMeterProcessRing(
+    _Inout_ PLEVEL_METER Meter,
+    _In_ const RING_BUFFER *Ring,
+    _In_ ULONG64 Start,
+    _In_ ULONG Frames
+)
+{
+    ULONG offset = (ULONG)(Start & Ring->Mask);
+    ULONG first;
+
+    Frames = min(Frames, Ring->Capacity);
+
+    // En modo espejo cualquier tramo es contiguo
+    first = Ring->Mirrored ? Frames : min(Frames, Ring->Capacity - offset);
+
+    LevelMeterProcess(Meter, Ring->Data + (SIZE_T)offset * Ring->FrameSize, first);
+    LevelMeterProcess(Meter, Ring->Data, Frames - first);
+}
+
+VOID LevelMeterGetSnapshot(
+    _In_ const LEVEL_METER *Meter,
+    _Out_ PLEVEL_METER_SNAPSHOT Snapshot
+)
+{
+    ULONG channel;
+
+    RtlZeroMemory(Snapshot, sizeof(LEVEL_METER_SNAPSHOT));
+    Snapshot->Frames = Meter->Frames;
+    Snapshot->Channels = Meter->Channels;
+
+    for (channel = 0; channel < Meter->Channels; channel++) {
+        Snapshot->Channel[channel].Peak = Meter->Peak[channel];
+        Snapshot->Channel[channel].Clips = Meter->Clips[channel];
+        if (Meter->Frames > 0) {
+            Snapshot->Channel[channel].Rms = SquareRoot(Meter->SumSquares[channel] / (double)Meter->Frames);
+        }
+    }
+}
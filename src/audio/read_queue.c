@@ -0,0 +1,68 @@
+#include "read_queue.h"
+
+VOID ReadQueueInitialize(
+    _Out_ PREAD_QUEUE Queue,
+    _In_ ULONG MinFillFrames
+)
+{
+    InitializeListHead(&Queue->PendingList);
+    Queue->Count = 0;
+    Queue->MinFillFrames = max(MinFillFrames, 1);
+}
+
+VOID ReadQueueInsert(
+    _Inout_ PREAD_QUEUE Queue,
+    _Inout_ PREAD_QUEUE_ENTRY Entry,
+    _In_ ULONG Frames
+)
+{
+    Entry->Frames = Frames;
+    InsertTailList(&Queue->PendingList, &Entry->Link);
+    Queue->Count++;
+}
+
+VOID ReadQueueRemove(
+    _Inout_ PREAD_QUEUE Queue,
+    _Inout_ PREAD_QUEUE_ENTRY Entry
+)
+{
+    RemoveEntryList(&Entry->Link);
+    InitializeListHead(&Entry->Link);
+    Queue->Count--;
+}
+
+PREAD_QUEUE_ENTRY ReadQueueNext(
+    _In_ PREAD_QUEUE Queue,
+    _In_opt_ PREAD_QUEUE_ENTRY After
+)
+{
+    PLIST_ENTRY next = (After != NULL) ? After->Link.Flink : Queue->PendingList.Flink;
+
+    if (next == &Queue->PendingList) {
+        return NULL;
+    }
+
+    return CONTAINING_RECORD(next, READ_QUEUE_ENTRY, Link);
+}
+
+ULONG ReadQueueThreshold(
+    _In_ PREAD_QUEUE Queue,
+    _In_ ULONG Frames
+)
+{
+    return max(min(Queue->MinFillFrames, Frames), 1);
+}
+
+PREAD_QUEUE_ENTRY ReadQueuePeekReady(
+    _In_ PREAD_QUEUE Queue,
+    _In_ ULONG AvailableFrames
+)
+{
+    PREAD_QUEUE_ENTRY head = ReadQueueNext(Queue, NULL);
+
+    if (head == NULL || AvailableFrames < ReadQueueThreshold(Queue, head->Frames)) {
+        return NULL;
+    }
+
+    return head;
+}
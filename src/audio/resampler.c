@@ -0,0 +1,618 @@
+#include "resampler.h"
+
+#if defined(VMIC_ARCH_X64)
+#include <emmintrin.h>
+#endif
+
+// Diseño del filtro (una vez, en double) y camino de datos (float). SSE2 es
+// parte de x64 y el kernel conserva los registros XMM: el producto escalar
+// vectorial no necesita guardar estado extendido, a diferencia de AVX2.
+
+#define RESAMPLER_PI 3.14159265358979323846
+
+#define RESAMPLER_ALIGN(size) (((size) + VMIC_CACHE_LINE - 1) & ~(SIZE_T)(VMIC_CACHE_LINE - 1))
+
+typedef struct _RESAMPLER_PRESET {
+    ULONG Taps;         // Coeficientes por fase sin decimación
+    double Attenuation; // Rechazo en la banda eliminada (dB)
+} RESAMPLER_PRESET;
+
+static const RESAMPLER_PRESET g_ResamplerPresets[RESAMPLER_QUALITY_COUNT] = {
+    { 16, 60.0 },
+    { 32, 80.0 },
+    { 64, 110.0 },
+};
+
+// Geometría común a ResamplerGetRequiredSize y ResamplerInitialize
+typedef struct _RESAMPLER_LAYOUT {
+    ULONG Interpolation;
+    ULONG Decimation;
+    ULONG Taps;
+    ULONG HistoryStride;
+    SIZE_T CoefficientsOffset;
+    SIZE_T HistoryOffset;
+    SIZE_T InputOffset;
+    SIZE_T OutputOffset;
+    SIZE_T Size;
+} RESAMPLER_LAYOUT;
+
+// Destino de la salida: buffer lineal o anillo (con o sin descarte)
+typedef struct _RESAMPLER_SINK {
+    PRING_BUFFER Ring; // NULL: buffer lineal
+    PUCHAR Buffer;
+    ULONG Capacity;
+    ULONG Written;
+    BOOLEAN DropOldest;
+    ULONG Dropped;
+} RESAMPLER_SINK;
+
+static ULONG GreatestCommonDivisor(ULONG A, ULONG B)
+{
+    ULONG remainder;
+
+    while (B != 0) {
+        remainder = A % B;
+        A = B;
+        B = remainder;
+    }
+
+    return A;
+}
+
+// sin(pi * X) sin la CRT: reducción a [-1/2, 1/2] y serie de Taylor
+static double SinPi(double X)
+{
+    double reduced = X - 2.0 * (double)(LONG64)(X / 2.0 + ((X >= 0.0) ? 0.5 : -0.5));
+    double angle;
+    double term;
+    double sum;
+    ULONG k;
+
+    if (reduced > 0.5) {
+        reduced = 1.0 - reduced;
+    } else if (reduced < -0.5) {
+        reduced = -1.0 - reduced;
+    }
+
+    angle = RESAMPLER_PI * reduced;
+    term = angle;
+    sum = angle;
+    for (k = 1; k <= 12; k++) {
+        term *= -angle * angle / (double)((2 * k) * (2 * k + 1));
+        sum += term;
+    }
+
+    return sum;
+}
+
+// Newton desde arriba: la sucesión decrece hasta la raíz (0 <= X <= 1)
+static double SquareRoot(double X)
+{
+    double root = 1.0;
+    double next;
+    ULONG i;
+
+    if (X <= 0.0) {
+        return 0.0;
+    }
+
+    for (i = 0; i < 64; i++) {
+        next = 0.5 * (root + X / root);
+        if (next >= root) {
+            break;
+        }
+        root = next;
+    }
+
+    return root;
+}
+
+// Función de Bessel modificada de primera especie y orden cero (serie)
+static double BesselI0(double X)
+{
+    double quarter = X * X / 4.0;
+    double term = 1.0;
+    double sum = 1.0;
+    ULONG k;
+
+    for (k = 1; k < 200; k++) {
+        term *= quarter / ((double)k * (double)k);
+        sum += term;
+        if (term < sum * 1e-17) {
+            break;
+        }
+    }
+
+    return sum;
+}
+
+static NTSTATUS ResamplerGetLayout(
+    _In_ const RESAMPLER_CONFIG *Config,
+    _Out_ RESAMPLER_LAYOUT *Layout
+)
+{
+    ULONG divisor;
+    ULONG stretch;
+    SIZE_T offset;
+
+    RtlZeroMemory(Layout, sizeof(RESAMPLER_LAYOUT));
+
+    if (Config->InputRate == 0 || Config->OutputRate == 0 || Config->Channels == 0 ||
+        Config->SourceFormat >= SAMPLE_FORMAT_COUNT || Config->TargetFormat >= SAMPLE_FORMAT_COUNT ||
+        Config->Quality >= RESAMPLER_QUALITY_COUNT) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    divisor = GreatestCommonDivisor(Config->InputRate, Config->OutputRate);
+    Layout->Interpolation = Config->OutputRate / divisor;
+    Layout->Decimation = Config->InputRate / divisor;
+
+    if (Layout->Interpolation > RESAMPLER_MAX_PHASES) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    // Al diezmar el corte baja a la Nyquist de salida: el filtro se alarga en
+    // la misma proporción para conservar la banda de transición. Con esto un
+    // paso entre salidas (como mucho ceil(M/L) frames) nunca supera la ventana.
+    stretch = (Layout->Decimation + Layout->Interpolation - 1) / Layout->Interpolation;
+    Layout->Taps = g_ResamplerPresets[Config->Quality].Taps * stretch;
+
+    if ((ULONG64)Layout->Interpolation * Layout->Taps > RESAMPLER_MAX_COEFFICIENTS) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    Layout->HistoryStride = Layout->Taps + RESAMPLER_BLOCK_FRAMES;
+
+    offset = RESAMPLER_ALIGN(sizeof(RESAMPLER));
+    Layout->CoefficientsOffset = offset;
+    offset += RESAMPLER_ALIGN((SIZE_T)Layout->Interpolation * Layout->Taps * sizeof(float));
+    Layout->HistoryOffset = offset;
+    offset += RESAMPLER_ALIGN((SIZE_T)Config->Channels * Layout->HistoryStride * sizeof(float));
+    Layout->InputOffset = offset;
+    offset += RESAMPLER_ALIGN((SIZE_T)Config->Channels * RESAMPLER_BLOCK_FRAMES * sizeof(float));
+    Layout->OutputOffset = offset;
+    offset += RESAMPLER_ALIGN((SIZE_T)Config->Channels * RESAMPLER_BLOCK_FRAMES * sizeof(float));
+    Layout->Size = offset;
+
+    return STATUS_SUCCESS;
+}
+
+// Sinc con ventana de Kaiser sobre Taps * L coeficientes a L veces la
+// frecuencia de entrada. La transición se deduce del rechazo pedido y la
+// longitud (fórmula de Kaiser) y se coloca justo por debajo de la Nyquist más
+// baja, de modo que imágenes y alias quedan en la banda eliminada.
+VOID ResamplerDesignFilter(
+    _Out_ float *Coefficients,
+    _In_ ULONG Interpolation,
+    _In_ ULONG Decimation,
+    _In_ ULONG Taps,
+    _In_ double Attenuation
+)
+{
+    ULONG length = Taps * Interpolation;
+    double center = (double)(length - 1) / 2.0;
+    double band = (double)max(Interpolation, Decimation);
+    double transition = (Attenuation - 7.95) * band / (2.285 * RESAMPLER_PI * (double)(length - 1));
+    double cutoff = (1.0 - transition / 2.0) * 0.5 / band;
+    double beta = 0.1102 * (Attenuation - 8.7);
+    double windowScale = 1.0 / BesselI0(beta);
+    double offset;
+    double sinc;
+    double ramp;
+    double sum;
+    float *row;
+    ULONG phase;
+    ULONG n;
+    ULONG k;
+
+    for (n = 0; n < length; n++) {
+        offset = (double)n - center;
+        sinc = (offset == 0.0) ? 1.0 : SinPi(2.0 * cutoff * offset) / (RESAMPLER_PI * 2.0 * cutoff * offset);
+        ramp = 2.0 * (double)n / (double)(length - 1) - 1.0;
+
+        // El coeficiente n pertenece a la fase n % L y pesa la entrada n / L
+        // frames antes de la más reciente de la ventana
+        Coefficients[(SIZE_T)(n % Interpolation) * Taps + (Taps - 1 - n / Interpolation)] =
+            (float)(2.0 * cutoff * sinc * BesselI0(beta * SquareRoot(1.0 - ramp * ramp)) * windowScale);
+    }
+
+    // Ganancia exactamente unitaria en continua para todas las fases
+    for (phase = 0; phase < Interpolation; phase++) {
+        row = Coefficients + (SIZE_T)phase * Taps;
+        sum = 0.0;
+        for (k = 0; k < Taps; k++) {
+            sum += row[k];
+        }
+        for (k = 0; k < Taps; k++) {
+            row[k] = (float)(row[k] / sum);
+        }
+    }
+}
+
+// Ocho acumuladores y reducción por parejas: el mismo orden que la variante
+// SSE2, de modo que ambas dan el mismo resultado bit a bit
+static inline float DotProductScalar(const float *Coefficients, const float *Window, ULONG Taps)
+{
+    float accumulators[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    ULONG i;
+    ULONG j;
+
+    for (i = 0; i < Taps; i += 8) {
+        for (j = 0; j < 8; j++) {
+            accumulators[j] += Coefficients[i + j] * Window[i + j];
+        }
+    }
+
+    return ((accumulators[0] + accumulators[4]) + (accumulators[2] + accumulators[6])) +
+           ((accumulators[1] + accumulators[5]) + (accumulators[3] + accumulators[7]));
+}
+
+#if defined(VMIC_ARCH_X64)
+static inline float DotProductSse2(const float *Coefficients, const float *Window, ULONG Taps)
+{
+    __m128 low = _mm_setzero_ps();
+    __m128 high = _mm_setzero_ps();
+    __m128 sum;
+    ULONG i;
+
+    for (i = 0; i < Taps; i += 8) {
+        low = _mm_add_ps(low, _mm_mul_ps(_mm_loadu_ps(Coefficients + i), _mm_loadu_ps(Window + i)));
+        high = _mm_add_ps(high, _mm_mul_ps(_mm_loadu_ps(Coefficients + i + 4), _mm_loadu_ps(Window + i + 4)));
+    }
+
+    sum = _mm_add_ps(low, high);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(sum);
+}
+#endif
+
+// Genera en OutputBlock hasta MaxFrames frames con la historia disponible
+static ULONG ResamplerGenerate(
+    _Inout_ PRESAMPLER Resampler,
+    _In_ ULONG MaxFrames
+)
+{
+    ULONG channels = Resampler->Config.Channels;
+    float *output = Resampler->OutputBlock;
+    const float *coefficients;
+    const float *window;
+    ULONG frames = 0;
+    ULONG channel;
+
+    while (frames < MaxFrames && Resampler->Position < Resampler->HistoryFrames) {
+        coefficients = Resampler->Coefficients + (SIZE_T)Resampler->Phase * Resampler->Taps;
+        window = Resampler->History + (Resampler->Position - (Resampler->Taps - 1));
+
+        for (channel = 0; channel < channels; channel++) {
+#if defined(VMIC_ARCH_X64)
+            if (Resampler->Vectorized) {
+                output[channel] = DotProductSse2(coefficients, window, Resampler->Taps);
+            } else
+#endif
+            {
+                output[channel] = DotProductScalar(coefficients, window, Resampler->Taps);
+            }
+            window += Resampler->HistoryStride;
+        }
+
+        Resampler->Phase += Resampler->Decimation;
+        Resampler->Position += Resampler->Phase / Resampler->Interpolation;
+        Resampler->Phase %= Resampler->Interpolation;
+
+        output += channels;
+        frames++;
+    }
+
+    return frames;
+}
+
+// Añade Frames frames de InputBlock a la historia. Solo se llama con toda la
+// salida posible ya generada (Position >= HistoryFrames): tras descartar lo
+// que ya no necesita ninguna ventana quedan como mucho Taps - 1 frames.
+static VOID ResamplerAppend(
+    _Inout_ PRESAMPLER Resampler,
+    _In_ ULONG Frames
+)
+{
+    ULONG channels = Resampler->Config.Channels;
+    ULONG shift = Resampler->Position - (Resampler->Taps - 1);
+    float *plane;
+    ULONG channel;
+    ULONG i;
+
+    for (channel = 0; channel < channels; channel++) {
+        plane = Resampler->History + (SIZE_T)channel * Resampler->HistoryStride;
+
+        if (shift > 0) {
+            RtlMoveMemory(plane, plane + shift, (SIZE_T)(Resampler->HistoryFrames - shift) * sizeof(float));
+        }
+
+        for (i = 0; i < Frames; i++) {
+            plane[Resampler->HistoryFrames - shift + i] = Resampler->InputBlock[(SIZE_T)i * channels + channel];
+        }
+    }
+
+    Resampler->Position -= shift;
+    Resampler->HistoryFrames += Frames - shift;
+}
+
+static ULONG SinkGetSpace(
+    _In_ const RESAMPLER_SINK *Sink
+)
+{
+    if (Sink->DropOldest) {
+        return MAXULONG;
+    }
+
+    if (Sink->Ring != NULL) {
+        return RingBufferGetFreeFrames(Sink->Ring);
+    }
+
+    return Sink->Capacity - Sink->Written;
+}
+
+static VOID SinkWrite(
+    _Inout_ RESAMPLER_SINK *Sink,
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG Frames
+)
+{
+    ULONG dropped;
+
+    if (Sink->Ring == NULL) {
+        SampleConvertFrames(&Resampler->Encoder,
+                            Sink->Buffer + (SIZE_T)Sink->Written * Resampler->Encoder.TargetFrameSize,
+                            Resampler->OutputBlock,
+                            Frames);
+    } else if (Sink->DropOldest) {
+        SampleConvertWriteRingDropOldest(Sink->Ring, &Resampler->Encoder, Resampler->OutputBlock, Frames, &dropped);
+        Sink->Dropped += dropped;
+    } else {
+        SampleConvertWriteRing(Sink->Ring, &Resampler->Encoder, Resampler->OutputBlock, Frames);
+    }
+
+    Sink->Written += Frames;
+}
+
+// Bucle común: vaciar la historia hacia el destino y añadir solo la entrada
+// cuya salida cabe en él. Devuelve los frames de entrada consumidos.
+static ULONG ResamplerRun(
+    _Inout_ PRESAMPLER Resampler,
+    _Inout_ RESAMPLER_SINK *Sink,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+)
+{
+    const UCHAR *source = (const UCHAR *)Source;
+    ULONG consumed = 0;
+    ULONG produced;
+    ULONG chunk;
+
+    for (;;) {
+        while (Resampler->Position < Resampler->HistoryFrames) {
+            produced = ResamplerGenerate(Resampler, min(RESAMPLER_BLOCK_FRAMES, SinkGetSpace(Sink)));
+            if (produced == 0) {
+                break;
+            }
+            SinkWrite(Sink, Resampler, produced);
+        }
+
+        // Con la entrada limitada abajo el destino no se llena a mitad de la historia
+        if (consumed == Frames || Resampler->Position < Resampler->HistoryFrames) {
+            break;
+        }
+
+        chunk = min(Frames - consumed, RESAMPLER_BLOCK_FRAMES);
+        chunk = min(chunk, ResamplerGetInputFrames(Resampler, SinkGetSpace(Sink)));
+        if (chunk == 0) {
+            break;
+        }
+
+        SampleConvertFrames(&Resampler->Decoder,
+                            Resampler->InputBlock,
+                            source + (SIZE_T)consumed * Resampler->Decoder.SourceFrameSize,
+                            chunk);
+        ResamplerAppend(Resampler, chunk);
+        consumed += chunk;
+    }
+
+    return consumed;
+}
+
+SIZE_T ResamplerGetRequiredSize(
+    _In_ const RESAMPLER_CONFIG *Config
+)
+{
+    RESAMPLER_LAYOUT layout;
+
+    if (!NT_SUCCESS(ResamplerGetLayout(Config, &layout))) {
+        return 0;
+    }
+
+    return layout.Size;
+}
+
+NTSTATUS ResamplerInitialize(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ const RESAMPLER_CONFIG *Config,
+    _Out_ PRESAMPLER *Resampler
+)
+{
+    NTSTATUS status;
+    RESAMPLER_LAYOUT layout;
+    PRESAMPLER resampler = (PRESAMPLER)Memory;
+    PUCHAR base = (PUCHAR)Memory;
+    float *coefficients;
+
+    *Resampler = NULL;
+
+    status = ResamplerGetLayout(Config, &layout);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    if (Memory == NULL || Size < layout.Size) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    RtlZeroMemory(resampler, sizeof(RESAMPLER));
+
+    status = SampleConverterInitialize(&resampler->Decoder, Config->SourceFormat, SAMPLE_FORMAT_FLOAT32,
+                                       Config->Channels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    status = SampleConverterInitialize(&resampler->Encoder, SAMPLE_FORMAT_FLOAT32, Config->TargetFormat,
+                                       Config->Channels, Config->Isa);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+
+    resampler->Config = *Config;
+    resampler->Interpolation = layout.Interpolation;
+    resampler->Decimation = layout.Decimation;
+    resampler->Taps = layout.Taps;
+    resampler->HistoryStride = layout.HistoryStride;
+#if defined(VMIC_ARCH_X64)
+    resampler->Vectorized = (Config->Isa != SAMPLE_CONVERT_ISA_SCALAR);
+#endif
+
+    coefficients = (float *)(base + layout.CoefficientsOffset);
+    resampler->Coefficients = coefficients;
+    resampler->History = (float *)(base + layout.HistoryOffset);
+    resampler->InputBlock = (float *)(base + layout.InputOffset);
+    resampler->OutputBlock = (float *)(base + layout.OutputOffset);
+
+    ResamplerDesignFilter(coefficients,
+                          layout.Interpolation,
+                          layout.Decimation,
+                          layout.Taps,
+                          g_ResamplerPresets[Config->Quality].Attenuation);
+
+    ResamplerReset(resampler);
+
+    *Resampler = resampler;
+    return STATUS_SUCCESS;
+}
+
+VOID ResamplerReset(
+    _Inout_ PRESAMPLER Resampler
+)
+{
+    ULONG channel;
+
+    // Taps - 1 frames de silencio: la primera salida ya tiene ventana completa
+    for (channel = 0; channel < Resampler->Config.Channels; channel++) {
+        RtlZeroMemory(Resampler->History + (SIZE_T)channel * Resampler->HistoryStride,
+                      (SIZE_T)(Resampler->Taps - 1) * sizeof(float));
+    }
+
+    Resampler->Phase = 0;
+    Resampler->Position = Resampler->Taps - 1;
+    Resampler->HistoryFrames = Resampler->Taps - 1;
+}
+
+// La salida k (desde 0) usa la ventana que termina en
+// Position + floor((Phase + k * M) / L): existe si ese frame ya está en la historia
+ULONG ResamplerGetOutputFrames(
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG InputFrames
+)
+{
+    LONG64 available = (LONG64)Resampler->HistoryFrames + InputFrames - Resampler->Position;
+    ULONG64 frames;
+
+    if (available <= 0) {
+        return 0;
+    }
+
+    frames = ((ULONG64)available * Resampler->Interpolation - Resampler->Phase + Resampler->Decimation - 1) /
+             Resampler->Decimation;
+    return (ULONG)min(frames, (ULONG64)MAXULONG);
+}
+
+// Entre llamadas no queda salida pendiente de la entrada ya consumida: solo
+// la entrada nueva aporta salida, como mucho una por cada M/L frames
+ULONG ResamplerGetMaxOutputFrames(
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG InputFrames
+)
+{
+    ULONG64 frames = ((ULONG64)InputFrames * Resampler->Interpolation + Resampler->Decimation - 1) /
+                     Resampler->Decimation;
+
+    return (ULONG)min(frames, (ULONG64)MAXULONG);
+}
+
+ULONG ResamplerGetInputFrames(
+    _In_ const RESAMPLER *Resampler,
+    _In_ ULONG OutputFrames
+)
+{
+    LONG64 frames = (LONG64)(((ULONG64)OutputFrames * Resampler->Decimation + Resampler->Phase) /
+                             Resampler->Interpolation) +
+                    Resampler->Position - Resampler->HistoryFrames;
+
+    if (frames <= 0) {
+        return 0;
+    }
+
+    return (ULONG)min((ULONG64)frames, (ULONG64)MAXULONG);
+}
+
+ULONG ResamplerProcess(
+    _Inout_ PRESAMPLER Resampler,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG FramesConsumed,
+    _Out_ PVOID Target,
+    _In_ ULONG MaxOutputFrames
+)
+{
+    RESAMPLER_SINK sink;
+
+    RtlZeroMemory(&sink, sizeof(sink));
+    sink.Buffer = (PUCHAR)Target;
+    sink.Capacity = MaxOutputFrames;
+
+    *FramesConsumed = ResamplerRun(Resampler, &sink, Source, Frames);
+    return sink.Written;
+}
+
+ULONG ResamplerWriteRing(
+    _Inout_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+)
+{
+    RESAMPLER_SINK sink;
+
+    RtlZeroMemory(&sink, sizeof(sink));
+    sink.Ring = Ring;
+
+    return ResamplerRun(Resampler, &sink, Source, Frames);
+}
+
+ULONG ResamplerWriteRingDropOldest(
+    _Inout_ PRESAMPLER Resampler,
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+)
+{
+    RESAMPLER_SINK sink;
+    ULONG consumed;
+
+    RtlZeroMemory(&sink, sizeof(sink));
+    sink.Ring = Ring;
+    sink.DropOldest = TRUE;
+
+    consumed = ResamplerRun(Resampler, &sink, Source, Frames);
+    *DroppedFrames = sink.Dropped;
+    return consumed;
+}
@@ -0,0 +1,337 @@
+#include "ring_buffer.h"
+
+BOOLEAN RingBufferIsValidCapacity(
+    _In_ ULONG Capacity
+)
+{
+    return Capacity != 0 && (Capacity & (Capacity - 1)) == 0;
+}
+
+ULONG RingBufferRoundUpCapacity(
+    _In_ ULONG Capacity
+)
+{
+    ULONG capacity = 1;
+
+    while (capacity < Capacity && capacity < 0x80000000UL) {
+        capacity <<= 1;
+    }
+
+    return capacity;
+}
+
+NTSTATUS RingBufferInitialize(
+    _Out_ PRING_BUFFER Ring,
+    _In_ PVOID Buffer,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+)
+{
+    if (Ring == NULL || Buffer == NULL || FrameSize == 0 || !RingBufferIsValidCapacity(Capacity)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if ((ULONG64)Capacity * FrameSize > 0xFFFFFFFFULL) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    RtlZeroMemory(Ring, sizeof(RING_BUFFER));
+    Ring->Data = (PUCHAR)Buffer;
+    Ring->Capacity = Capacity;
+    Ring->Mask = Capacity - 1;
+    Ring->FrameSize = FrameSize;
+    Ring->Size = Capacity * FrameSize;
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS RingBufferInitializeMirrored(
+    _Out_ PRING_BUFFER Ring,
+    _In_ PVOID MirroredBuffer,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+)
+{
+    NTSTATUS status;
+
+    status = RingBufferInitialize(Ring, MirroredBuffer, Capacity, FrameSize);
+    if (NT_SUCCESS(status)) {
+        Ring->Mirrored = TRUE;
+    }
+
+    return status;
+}
+
+// Frames libres vistos por el productor; relee Tail solo si la copia local no alcanza
+static ULONG RingBufferProducerFree(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG64 Head,
+    _In_ ULONG Wanted
+)
+{
+    ULONG freeFrames = Ring->Capacity - (ULONG)(Head - Ring->CachedTail);
+
+    if (freeFrames < Wanted) {
+        Ring->CachedTail = VmicReadAcquire64(&Ring->Tail);
+        freeFrames = Ring->Capacity - (ULONG)(Head - Ring->CachedTail);
+    }
+
+    return freeFrames;
+}
+
+// Frames disponibles vistos por el consumidor; relee Head solo si no alcanza
+static ULONG RingBufferConsumerUsed(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG64 Tail,
+    _In_ ULONG Wanted
+)
+{
+    ULONG usedFrames = (ULONG)(Ring->CachedHead - Tail);
+
+    if (usedFrames < Wanted) {
+        Ring->CachedHead = VmicReadAcquire64(&Ring->Head);
+        usedFrames = (ULONG)(Ring->CachedHead - Tail);
+    }
+
+    return usedFrames;
+}
+
+ULONG RingBufferWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _In_reads_bytes_(Frames * Ring->FrameSize) const VOID *Data,
+    _In_ ULONG Frames
+)
+{
+    ULONG64 head;
+    ULONG framesToCopy;
+    ULONG index;
+    ULONG firstChunk;
+
+    // Solo el productor modifica Head
+    head = VmicReadNoFence64(&Ring->Head);
+
+    framesToCopy = min(Frames, RingBufferProducerFree(Ring, head, Frames));
+    if (framesToCopy == 0) {
+        return 0;
+    }
+
+    index = (ULONG)head & Ring->Mask;
+
+    if (Ring->Mirrored) {
+        // La segunda mitad es alias de la primera: una sola copia contigua
+        RtlCopyMemory(Ring->Data + (SIZE_T)index * Ring->FrameSize, Data,
+                      (SIZE_T)framesToCopy * Ring->FrameSize);
+    } else {
+        // Calcular chunks para escritura circular
+        firstChunk = min(framesToCopy, Ring->Capacity - index);
+
+        RtlCopyMemory(Ring->Data + (SIZE_T)index * Ring->FrameSize, Data,
+                      (SIZE_T)firstChunk * Ring->FrameSize);
+        if (framesToCopy > firstChunk) {
+            RtlCopyMemory(Ring->Data, (const UCHAR *)Data + (SIZE_T)firstChunk * Ring->FrameSize,
+                          (SIZE_T)(framesToCopy - firstChunk) * Ring->FrameSize);
+        }
+    }
+
+    // Publicar los datos al consumidor
+    VmicWriteRelease64(&Ring->Head, head + framesToCopy);
+
+    return framesToCopy;
+}
+
+ULONG RingBufferAcquireWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _Out_ PUCHAR *Region
+)
+{
+    ULONG64 head = VmicReadNoFence64(&Ring->Head);
+    ULONG index = (ULONG)head & Ring->Mask;
+    ULONG available = RingBufferProducerFree(Ring, head, Ring->Capacity);
+
+    *Region = Ring->Data + (SIZE_T)index * Ring->FrameSize;
+
+    if (!Ring->Mirrored) {
+        available = min(available, Ring->Capacity - index);
+    }
+
+    return available;
+}
+
+VOID RingBufferCommitWrite(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+)
+{
+    VmicWriteRelease64(&Ring->Head, VmicReadNoFence64(&Ring->Head) + Frames);
+}
+
+ULONG RingBufferWriteDropOldest(
+    _Inout_ PRING_BUFFER Ring,
+    _In_reads_bytes_(Frames * Ring->FrameSize) const VOID *Data,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+)
+{
+    const UCHAR *source = (const UCHAR *)Data;
+    ULONG freeFrames;
+
+    *DroppedFrames = 0;
+
+    // Solo caben los últimos Capacity frames del paquete
+    if (Frames > Ring->Capacity) {
+        *DroppedFrames = Frames - Ring->Capacity;
+        source += (SIZE_T)*DroppedFrames * Ring->FrameSize;
+        Frames = Ring->Capacity;
+    }
+
+    freeFrames = RingBufferGetFreeFrames(Ring);
+    if (freeFrames < Frames) {
+        *DroppedFrames += RingBufferDiscard(Ring, Frames - freeFrames);
+    }
+
+    return RingBufferWrite(Ring, source, Frames);
+}
+
+ULONG RingBufferRead(
+    _Inout_ PRING_BUFFER Ring,
+    _Out_writes_bytes_(Frames * Ring->FrameSize) PVOID Data,
+    _In_ ULONG Frames
+)
+{
+    ULONG64 tail;
+    ULONG framesToCopy;
+    ULONG index;
+    ULONG firstChunk;
+
+    // Solo el consumidor modifica Tail
+    tail = VmicReadNoFence64(&Ring->Tail);
+
+    framesToCopy = min(Frames, RingBufferConsumerUsed(Ring, tail, Frames));
+    if (framesToCopy == 0) {
+        return 0;
+    }
+
+    index = (ULONG)tail & Ring->Mask;
+
+    if (Ring->Mirrored) {
+        RtlCopyMemory(Data, Ring->Data + (SIZE_T)index * Ring->FrameSize,
+                      (SIZE_T)framesToCopy * Ring->FrameSize);
+    } else {
+        // Calcular chunks para lectura circular
+        firstChunk = min(framesToCopy, Ring->Capacity - index);
+
+        RtlCopyMemory(Data, Ring->Data + (SIZE_T)index * Ring->FrameSize,
+                      (SIZE_T)firstChunk * Ring->FrameSize);
+        if (framesToCopy > firstChunk) {
+            RtlCopyMemory((PUCHAR)Data + (SIZE_T)firstChunk * Ring->FrameSize, Ring->Data,
+                          (SIZE_T)(framesToCopy - firstChunk) * Ring->FrameSize);
+        }
+    }
+
+    // Liberar el espacio al productor
+    VmicWriteRelease64(&Ring->Tail, tail + framesToCopy);
+
+    return framesToCopy;
+}
+
+ULONG RingBufferAcquireRead(
+    _Inout_ PRING_BUFFER Ring,
+    _Out_ PUCHAR *Region
+)
+{
+    ULONG64 tail = VmicReadNoFence64(&Ring->Tail);
+    ULONG index = (ULONG)tail & Ring->Mask;
+    ULONG available = RingBufferConsumerUsed(Ring, tail, Ring->Capacity);
+
+    *Region = Ring->Data + (SIZE_T)index * Ring->FrameSize;
+
+    if (!Ring->Mirrored) {
+        available = min(available, Ring->Capacity - index);
+    }
+
+    return available;
+}
+
+VOID RingBufferReleaseRead(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+)
+{
+    VmicWriteRelease64(&Ring->Tail, VmicReadNoFence64(&Ring->Tail) + Frames);
+}
+
+ULONG RingBufferDiscard(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ ULONG Frames
+)
+{
+    ULONG64 tail = VmicReadNoFence64(&Ring->Tail);
+    ULONG framesToDrop = min(Frames, RingBufferConsumerUsed(Ring, tail, Frames));
+
+    if (framesToDrop > 0) {
+        VmicWriteRelease64(&Ring->Tail, tail + framesToDrop);
+    }
+
+    return framesToDrop;
+}
+
+NTSTATUS RingBufferMigrate(
+    _Inout_ PRING_BUFFER Target,
+    _Inout_ PRING_BUFFER Source
+)
+{
+    ULONG64 tail = VmicReadAcquire64(&Source->Tail);
+    ULONG64 head = VmicReadAcquire64(&Source->Head);
+    ULONG pending = (ULONG)(head - tail);
+    PUCHAR region;
+    ULONG chunk;
+
+    if (Target->FrameSize != Source->FrameSize) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (pending > Target->Capacity) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    // Conservar los contadores para que las posiciones sigan siendo monótonas
+    Target->Head = tail;
+    Target->Tail = tail;
+    Target->CachedHead = tail;
+    Target->CachedTail = tail;
+
+    while (pending > 0) {
+        chunk = min(RingBufferAcquireRead(Source, &region), pending);
+        RingBufferWrite(Target, region, chunk);
+        RingBufferReleaseRead(Source, chunk);
+        pending -= chunk;
+    }
+
+    return STATUS_SUCCESS;
+}
+
+ULONG RingBufferGetUsedFrames(
+    _In_ PRING_BUFFER Ring
+)
+{
+    ULONG64 tail;
+    ULONG64 head;
+
+    // Leer Tail antes que Head garantiza head >= tail
+    tail = VmicReadAcquire64(&Ring->Tail);
+    head = VmicReadAcquire64(&Ring->Head);
+
+    // Entre ambas lecturas el productor pudo seguir avanzando
+    if (head - tail > Ring->Capacity) {
+        return Ring->Capacity;
+    }
+
+    return (ULONG)(head - tail);
+}
+
+ULONG RingBufferGetFreeFrames(
+    _In_ PRING_BUFFER Ring
+)
+{
+    return Ring->Capacity - RingBufferGetUsedFrames(Ring);
+}
@@ -0,0 +1,358 @@
+#include "sample_convert_kernels.h"
+
+// Referencia escalar. Los enteros se manejan alineados a la izquierda en 32
+// bits (int16 << 16, int24 << 8): así cualquier par entero es un desplazamiento
+// y entero -> float es un único escalado exacto por 2^-31.
+
+static inline LONG LoadInt16(const UCHAR *Data, SIZE_T Index)
+{
+    return (LONG)((ULONG)(LONG)((const SHORT *)Data)[Index] << 16);
+}
+
+static inline LONG LoadInt24(const UCHAR *Data, SIZE_T Index)
+{
+    const UCHAR *sample = Data + Index * 3;
+
+    return (LONG)(((ULONG)sample[0] << 8) | ((ULONG)sample[1] << 16) | ((ULONG)sample[2] << 24));
+}
+
+static inline LONG LoadInt32(const UCHAR *Data, SIZE_T Index)
+{
+    return ((const LONG *)Data)[Index];
+}
+
+static inline float LoadFloat(const UCHAR *Data, SIZE_T Index)
+{
+    return ((const float *)Data)[Index];
+}
+
+static inline VOID StoreInt16(PUCHAR Data, SIZE_T Index, LONG Value)
+{
+    ((SHORT *)Data)[Index] = (SHORT)(Value >> 16);
+}
+
+static inline VOID StoreInt24(PUCHAR Data, SIZE_T Index, LONG Value)
+{
+    PUCHAR sample = Data + Index * 3;
+
+    sample[0] = (UCHAR)(Value >> 8);
+    sample[1] = (UCHAR)(Value >> 16);
+    sample[2] = (UCHAR)(Value >> 24);
+}
+
+static inline VOID StoreInt32(PUCHAR Data, SIZE_T Index, LONG Value)
+{
+    ((LONG *)Data)[Index] = Value;
+}
+
+static inline VOID StoreFloat(PUCHAR Data, SIZE_T Index, float Value)
+{
+    ((float *)Data)[Index] = Value;
+}
+
+static inline float IntToFloat(LONG Value)
+{
+    return (float)Value * SAMPLE_FLOAT_SCALE;
+}
+
+// Redondeo al par más cercano (el de CVTPS2DQ) sin depender de la CRT: al
+// sumar 1,5 * 2^52 en double la propia suma redondea a entero. |Value| <= 2^31.
+static inline LONG RoundToEven(float Value)
+{
+    return (LONG)(((double)Value + 6755399441055744.0) - 6755399441055744.0);
+}
+
+// Devuelve el entero de Bits bits alineado a la izquierda. Las comparaciones
+// reproducen MINPS/MAXPS y la conversión saturada de los núcleos vectoriales.
+static inline LONG FloatToInt(float Value, ULONG Bits)
+{
+    float scale = (float)(1UL << (Bits - 1));
+    float maximum = scale - 1.0f;
+    float minimum = -scale;
+
+    Value *= scale;
+
+    if (Bits == 32) {
+        if (Value >= SAMPLE_INT32_SCALE) {
+            return 0x7FFFFFFF;
+        }
+        if (!(Value >= -SAMPLE_INT32_SCALE)) {
+            return (LONG)0x80000000UL; // También NaN
+        }
+        return RoundToEven(Value);
+    }
+
+    Value = (Value < maximum) ? Value : maximum;
+    Value = (Value > minimum) ? Value : minimum;
+    return (LONG)((ULONG)RoundToEven(Value) << (32 - Bits));
+}
+
+#define DEFINE_INT_TO_INT(Name, Load, Store)                           \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples) \
+    {                                                                  \
+        SIZE_T i;                                                      \
+        for (i = 0; i < Samples; i++) {                                \
+            Store((PUCHAR)Target, i, Load((const UCHAR *)Source, i));  \
+        }                                                              \
+    }
+
+#define DEFINE_INT_TO_FLOAT(Name, Load)                                \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples) \
+    {                                                                  \
+        SIZE_T i;                                                      \
+        for (i = 0; i < Samples; i++) {                                \
+            StoreFloat((PUCHAR)Target, i,                              \
+                       IntToFloat(Load((const UCHAR *)Source, i)));    \
+        }                                                              \
+    }
+
+#define DEFINE_FLOAT_TO_INT(Name, Store, Bits)                            \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)    \
+    {                                                                     \
+        SIZE_T i;                                                         \
+        for (i = 0; i < Samples; i++) {                                   \
+            Store((PUCHAR)Target, i,                                      \
+                  FloatToInt(LoadFloat((const UCHAR *)Source, i), Bits)); \
+        }                                                                 \
+    }
+
+DEFINE_INT_TO_INT(ScalarInt16ToInt24, LoadInt16, StoreInt24)
+DEFINE_INT_TO_INT(ScalarInt16ToInt32, LoadInt16, StoreInt32)
+DEFINE_INT_TO_INT(ScalarInt24ToInt16, LoadInt24, StoreInt16)
+DEFINE_INT_TO_INT(ScalarInt24ToInt32, LoadInt24, StoreInt32)
+DEFINE_INT_TO_INT(ScalarInt32ToInt16, LoadInt32, StoreInt16)
+DEFINE_INT_TO_INT(ScalarInt32ToInt24, LoadInt32, StoreInt24)
+DEFINE_INT_TO_FLOAT(ScalarInt16ToFloat, LoadInt16)
+DEFINE_INT_TO_FLOAT(ScalarInt24ToFloat, LoadInt24)
+DEFINE_INT_TO_FLOAT(ScalarInt32ToFloat, LoadInt32)
+DEFINE_FLOAT_TO_INT(ScalarFloatToInt16, StoreInt16, 16)
+DEFINE_FLOAT_TO_INT(ScalarFloatToInt24, StoreInt24, 24)
+DEFINE_FLOAT_TO_INT(ScalarFloatToInt32, StoreInt32, 32)
+
+const SAMPLE_CONVERT_TABLE SampleConvertScalarKernels = {
+    // Origen int16
+    { NULL, ScalarInt16ToInt24, ScalarInt16ToInt32, ScalarInt16ToFloat },
+    // Origen int24
+    { ScalarInt24ToInt16, NULL, ScalarInt24ToInt32, ScalarInt24ToFloat },
+    // Origen int32
+    { ScalarInt32ToInt16, ScalarInt32ToInt24, NULL, ScalarInt32ToFloat },
+    // Origen float32
+    { ScalarFloatToInt16, ScalarFloatToInt24, ScalarFloatToInt32, NULL },
+};
+
+ULONG SampleFormatGetBytes(
+    _In_ SAMPLE_FORMAT Format
+)
+{
+    switch (Format) {
+        case SAMPLE_FORMAT_INT16:
+            return 2;
+        case SAMPLE_FORMAT_INT24:
+            return 3;
+        case SAMPLE_FORMAT_INT32:
+        case SAMPLE_FORMAT_FLOAT32:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+NTSTATUS SampleFormatFromWave(
+    _In_ USHORT FormatTag,
+    _In_ USHORT BitsPerSample,
+    _Out_ PSAMPLE_FORMAT Format
+)
+{
+    if (FormatTag == AUDIO_FORMAT_TAG_IEEE_FLOAT) {
+        if (BitsPerSample != 32) {
+            return STATUS_NOT_SUPPORTED;
+        }
+        *Format = SAMPLE_FORMAT_FLOAT32;
+        return STATUS_SUCCESS;
+    }
+
+    if (FormatTag != 0 && FormatTag != AUDIO_FORMAT_TAG_PCM) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    switch (BitsPerSample) {
+        case 16:
+            *Format = SAMPLE_FORMAT_INT16;
+            return STATUS_SUCCESS;
+        case 24:
+            *Format = SAMPLE_FORMAT_INT24;
+            return STATUS_SUCCESS;
+        case 32:
+            *Format = SAMPLE_FORMAT_INT32;
+            return STATUS_SUCCESS;
+        default:
+            return STATUS_NOT_SUPPORTED;
+    }
+}
+
+BOOLEAN SampleConvertIsIsaAvailable(
+    _In_ SAMPLE_CONVERT_ISA Isa
+)
+{
+    switch (Isa) {
+        case SAMPLE_CONVERT_ISA_SCALAR:
+            return TRUE;
+#if defined(VMIC_ARCH_X64)
+        case SAMPLE_CONVERT_ISA_SSE2:
+            return TRUE; // Parte de la arquitectura x64
+        case SAMPLE_CONVERT_ISA_AVX2:
+            return VmicCpuHasAvx2();
+#endif
+        default:
+            return FALSE;
+    }
+}
+
+SAMPLE_CONVERT_ISA SampleConvertGetBestIsa(VOID)
+{
+    if (SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_AVX2)) {
+        return SAMPLE_CONVERT_ISA_AVX2;
+    }
+
+    if (SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)) {
+        return SAMPLE_CONVERT_ISA_SSE2;
+    }
+
+    return SAMPLE_CONVERT_ISA_SCALAR;
+}
+
+NTSTATUS SampleConverterInitialize(
+    _Out_ PSAMPLE_CONVERTER Converter,
+    _In_ SAMPLE_FORMAT SourceFormat,
+    _In_ SAMPLE_FORMAT TargetFormat,
+    _In_ ULONG Channels,
+    _In_ SAMPLE_CONVERT_ISA Isa
+)
+{
+    SAMPLE_CONVERT_ROUTINE routine = NULL;
+
+    RtlZeroMemory(Converter, sizeof(SAMPLE_CONVERTER));
+
+    if (SourceFormat >= SAMPLE_FORMAT_COUNT || TargetFormat >= SAMPLE_FORMAT_COUNT || Channels == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (!SampleConvertIsIsaAvailable(Isa)) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+#if defined(VMIC_ARCH_X64)
+    if (Isa == SAMPLE_CONVERT_ISA_AVX2) {
+        routine = SampleConvertAvx2Kernels[SourceFormat][TargetFormat];
+    } else if (Isa == SAMPLE_CONVERT_ISA_SSE2) {
+        routine = SampleConvertSse2Kernels[SourceFormat][TargetFormat];
+    }
+#endif
+
+    if (routine == NULL) {
+        routine = SampleConvertScalarKernels[SourceFormat][TargetFormat];
+        Isa = SAMPLE_CONVERT_ISA_SCALAR;
+    }
+
+    Converter->SourceFormat = SourceFormat;
+    Converter->TargetFormat = TargetFormat;
+    Converter->SourceFrameSize = SampleFormatGetBytes(SourceFormat) * Channels;
+    Converter->TargetFrameSize = SampleFormatGetBytes(TargetFormat) * Channels;
+    Converter->Channels = Channels;
+    Converter->Isa = Isa;
+    Converter->Routine = routine;
+
+    return STATUS_SUCCESS;
+}
+
+VOID SampleConvertFrames(
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _Out_ PVOID Target,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+)
+{
+    SIZE_T samples = (SIZE_T)Frames * Converter->Channels;
+    VMIC_VECTOR_STATE vectorState;
+
+    if (Converter->Routine == NULL) {
+        RtlCopyMemory(Target, Source, (SIZE_T)Frames * Converter->SourceFrameSize);
+        return;
+    }
+
+    if (Converter->Isa != SAMPLE_CONVERT_ISA_AVX2) {
+        Converter->Routine(Target, Source, samples);
+        return;
+    }
+
+    // Sin estado AVX guardado no se pueden tocar los registros YMM
+    if (!NT_SUCCESS(VmicSaveVectorState(&vectorState))) {
+        SampleConvertScalarKernels[Converter->SourceFormat][Converter->TargetFormat](Target, Source, samples);
+        return;
+    }
+
+    Converter->Routine(Target, Source, samples);
+    VmicRestoreVectorState(&vectorState);
+}
+
+ULONG SampleConvertWriteRing(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames
+)
+{
+    const UCHAR *source = (const UCHAR *)Source;
+    PUCHAR region;
+    ULONG written = 0;
+    ULONG chunk;
+
+    if (Converter->Routine == NULL) {
+        return RingBufferWrite(Ring, Source, Frames);
+    }
+
+    // Como mucho dos tramos (uno si el anillo está en modo espejo)
+    while (written < Frames) {
+        chunk = min(RingBufferAcquireWrite(Ring, &region), Frames - written);
+        if (chunk == 0) {
+            break;
+        }
+
+        SampleConvertFrames(Converter, region, source + (SIZE_T)written * Converter->SourceFrameSize, chunk);
+        RingBufferCommitWrite(Ring, chunk);
+        written += chunk;
+    }
+
+    return written;
+}
+
+ULONG SampleConvertWriteRingDropOldest(
+    _Inout_ PRING_BUFFER Ring,
+    _In_ const SAMPLE_CONVERTER *Converter,
+    _In_ const VOID *Source,
+    _In_ ULONG Frames,
+    _Out_ PULONG DroppedFrames
+)
+{
+    const UCHAR *source = (const UCHAR *)Source;
+    ULONG freeFrames;
+
+    if (Converter->Routine == NULL) {
+        return RingBufferWriteDropOldest(Ring, Source, Frames, DroppedFrames);
+    }
+
+    *DroppedFrames = 0;
+
+    if (Frames > Ring->Capacity) {
+        *DroppedFrames = Frames - Ring->Capacity;
+        source += (SIZE_T)*DroppedFrames * Converter->SourceFrameSize;
+        Frames = Ring->Capacity;
+    }
+
+    freeFrames = RingBufferGetFreeFrames(Ring);
+    if (freeFrames < Frames) {
+        *DroppedFrames += RingBufferDiscard(Ring, Frames - freeFrames);
+    }
+
+    return SampleConvertWriteRing(Ring, Converter, source, Frames);
+}
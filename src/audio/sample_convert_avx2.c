@@ -0,0 +1,169 @@
+#include "sample_convert_kernels.h"
+
+#if defined(VMIC_ARCH_X64)
+
+#include <immintrin.h>
+
+// Núcleos AVX2: 8 muestras por iteración en un vector de 256 bits (enteros
+// alineados a la izquierda en 32 bits o float). La cola va al escalar.
+// Este fichero se compila con AVX2 habilitado (-mavx2 en el host); nada de
+// aquí se ejecuta sin comprobar antes la CPU (SampleConvertIsIsaAvailable).
+
+// int24 empaquetado: 8 muestras son 24 bytes, cargados como dos mitades de 16
+// bytes (desde +0 y +12). Cada carril coloca sus 4 muestras en los 3 bytes
+// altos de cada entero, lo que ya deja el valor alineado a la izquierda. La
+// carga lee 4 bytes de más y el almacenamiento escribe 4 de relleno que la
+// iteración siguiente sobrescribe: los bucles con int24 dejan 2 muestras de
+// margen antes del final para no salirse del buffer.
+#define INT24_SLACK_SAMPLES 2
+
+static inline __m256i LoadInt16(const UCHAR *Data)
+{
+    return _mm256_slli_epi32(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)Data)), 16);
+}
+
+static inline __m256i LoadInt24(const UCHAR *Data)
+{
+    const __m256i spread = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                            -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    __m256i samples;
+
+    samples = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)Data)),
+                                      _mm_loadu_si128((const __m128i *)(Data + 12)),
+                                      1);
+    return _mm256_shuffle_epi8(samples, spread);
+}
+
+static inline __m256i LoadInt32(const UCHAR *Data)
+{
+    return _mm256_loadu_si256((const __m256i *)Data);
+}
+
+static inline VOID StoreInt16(PUCHAR Data, __m256i Value)
+{
+    // PACKSSDW trabaja por carriles: juntar las dos mitades útiles en el carril bajo
+    Value = _mm256_srai_epi32(Value, 16);
+    Value = _mm256_packs_epi32(Value, Value);
+    Value = _mm256_permute4x64_epi64(Value, _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)Data, _mm256_castsi256_si128(Value));
+}
+
+static inline VOID StoreInt24(PUCHAR Data, __m256i Value)
+{
+    const __m256i pack = _mm256_setr_epi8(1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1,
+                                          1, 2, 3, 5, 6, 7, 9, 10, 11, 13, 14, 15, -1, -1, -1, -1);
+
+    Value = _mm256_shuffle_epi8(Value, pack);
+    _mm_storeu_si128((__m128i *)Data, _mm256_castsi256_si128(Value));
+    _mm_storeu_si128((__m128i *)(Data + 12), _mm256_extracti128_si256(Value, 1));
+}
+
+static inline VOID StoreInt32(PUCHAR Data, __m256i Value)
+{
+    _mm256_storeu_si256((__m256i *)Data, Value);
+}
+
+static inline __m256 IntToFloat(__m256i Value)
+{
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(Value), _mm256_set1_ps(SAMPLE_FLOAT_SCALE));
+}
+
+static inline __m256i FloatToInt(__m256 Value, ULONG Bits)
+{
+    __m256 scale = _mm256_set1_ps((float)(1UL << (Bits - 1)));
+    __m256i result;
+
+    Value = _mm256_mul_ps(Value, scale);
+
+    if (Bits == 32) {
+        // CVTPS2DQ devuelve 0x80000000 fuera de rango; por arriba se corrige a 0x7FFFFFFF
+        result = _mm256_cvtps_epi32(Value);
+        return _mm256_xor_si256(result, _mm256_castps_si256(_mm256_cmp_ps(Value, scale, _CMP_GE_OQ)));
+    }
+
+    Value = _mm256_min_ps(Value, _mm256_sub_ps(scale, _mm256_set1_ps(1.0f)));
+    Value = _mm256_max_ps(Value, _mm256_sub_ps(_mm256_setzero_ps(), scale));
+    return _mm256_slli_epi32(_mm256_cvtps_epi32(Value), (int)(32 - Bits));
+}
+
+#define SAMPLE_BYTES_INT16   2
+#define SAMPLE_BYTES_INT24   3
+#define SAMPLE_BYTES_INT32   4
+#define SAMPLE_BYTES_FLOAT32 4
+
+#define SAMPLE_SLACK_INT16   0
+#define SAMPLE_SLACK_INT24   INT24_SLACK_SAMPLES
+#define SAMPLE_SLACK_INT32   0
+#define SAMPLE_SLACK_FLOAT32 0
+
+#define LOOP_SAMPLES(SourceFormat, TargetFormat) \
+    (8 + max(SAMPLE_SLACK_##SourceFormat, SAMPLE_SLACK_##TargetFormat))
+
+#define DEFINE_INT_TO_INT(Name, Load, Store, SourceFormat, TargetFormat)                        \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)                          \
+    {                                                                                           \
+        const UCHAR *source = (const UCHAR *)Source;                                            \
+        PUCHAR target = (PUCHAR)Target;                                                         \
+        SIZE_T i;                                                                               \
+        for (i = 0; i + LOOP_SAMPLES(SourceFormat, TargetFormat) <= Samples; i += 8) {          \
+            Store(target + i * SAMPLE_BYTES_##TargetFormat,                                     \
+                  Load(source + i * SAMPLE_BYTES_##SourceFormat));                              \
+        }                                                                                       \
+        SampleConvertScalarKernels[SAMPLE_FORMAT_##SourceFormat][SAMPLE_FORMAT_##TargetFormat]( \
+            target + i * SAMPLE_BYTES_##TargetFormat,                                           \
+            source + i * SAMPLE_BYTES_##SourceFormat,                                           \
+            Samples - i);                                                                       \
+    }
+
+#define DEFINE_INT_TO_FLOAT(Name, Load, SourceFormat)                                                 \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)                                \
+    {                                                                                                 \
+        const UCHAR *source = (const UCHAR *)Source;                                                  \
+        float *target = (float *)Target;                                                              \
+        SIZE_T i;                                                                                     \
+        for (i = 0; i + LOOP_SAMPLES(SourceFormat, FLOAT32) <= Samples; i += 8) {                     \
+            _mm256_storeu_ps(target + i, IntToFloat(Load(source + i * SAMPLE_BYTES_##SourceFormat))); \
+        }                                                                                             \
+        SampleConvertScalarKernels[SAMPLE_FORMAT_##SourceFormat][SAMPLE_FORMAT_FLOAT32](              \
+            target + i, source + i * SAMPLE_BYTES_##SourceFormat, Samples - i);                       \
+    }
+
+#define DEFINE_FLOAT_TO_INT(Name, Store, TargetFormat, Bits)                             \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)                   \
+    {                                                                                    \
+        const float *source = (const float *)Source;                                     \
+        PUCHAR target = (PUCHAR)Target;                                                  \
+        SIZE_T i;                                                                        \
+        for (i = 0; i + LOOP_SAMPLES(FLOAT32, TargetFormat) <= Samples; i += 8) {        \
+            Store(target + i * SAMPLE_BYTES_##TargetFormat,                              \
+                  FloatToInt(_mm256_loadu_ps(source + i), Bits));                        \
+        }                                                                                \
+        SampleConvertScalarKernels[SAMPLE_FORMAT_FLOAT32][SAMPLE_FORMAT_##TargetFormat]( \
+            target + i * SAMPLE_BYTES_##TargetFormat, source + i, Samples - i);          \
+    }
+
+DEFINE_INT_TO_INT(Avx2Int16ToInt24, LoadInt16, StoreInt24, INT16, INT24)
+DEFINE_INT_TO_INT(Avx2Int16ToInt32, LoadInt16, StoreInt32, INT16, INT32)
+DEFINE_INT_TO_INT(Avx2Int24ToInt16, LoadInt24, StoreInt16, INT24, INT16)
+DEFINE_INT_TO_INT(Avx2Int24ToInt32, LoadInt24, StoreInt32, INT24, INT32)
+DEFINE_INT_TO_INT(Avx2Int32ToInt16, LoadInt32, StoreInt16, INT32, INT16)
+DEFINE_INT_TO_INT(Avx2Int32ToInt24, LoadInt32, StoreInt24, INT32, INT24)
+DEFINE_INT_TO_FLOAT(Avx2Int16ToFloat, LoadInt16, INT16)
+DEFINE_INT_TO_FLOAT(Avx2Int24ToFloat, LoadInt24, INT24)
+DEFINE_INT_TO_FLOAT(Avx2Int32ToFloat, LoadInt32, INT32)
+DEFINE_FLOAT_TO_INT(Avx2FloatToInt16, StoreInt16, INT16, 16)
+DEFINE_FLOAT_TO_INT(Avx2FloatToInt24, StoreInt24, INT24, 24)
+DEFINE_FLOAT_TO_INT(Avx2FloatToInt32, StoreInt32, INT32, 32)
+
+const SAMPLE_CONVERT_TABLE SampleConvertAvx2Kernels = {
+    // Origen int16
+    { NULL, Avx2Int16ToInt24, Avx2Int16ToInt32, Avx2Int16ToFloat },
+    // Origen int24
+    { Avx2Int24ToInt16, NULL, Avx2Int24ToInt32, Avx2Int24ToFloat },
+    // Origen int32
+    { Avx2Int32ToInt16, Avx2Int32ToInt24, NULL, Avx2Int32ToFloat },
+    // Origen float32
+    { Avx2FloatToInt16, Avx2FloatToInt24, Avx2FloatToInt32, NULL },
+};
+
+#endif // VMIC_ARCH_X64
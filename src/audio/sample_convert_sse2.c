@@ -0,0 +1,131 @@
+#include "sample_convert_kernels.h"
+
+#if defined(VMIC_ARCH_X64)
+
+#include <emmintrin.h>
+
+// Núcleos SSE2: 8 muestras por iteración en dos vectores de 4 (enteros
+// alineados a la izquierda en 32 bits o float). La cola va al escalar.
+
+static inline VOID LoadInt16(const UCHAR *Data, __m128i *Low, __m128i *High)
+{
+    __m128i samples = _mm_loadu_si128((const __m128i *)Data);
+
+    // Intercalar con ceros por debajo equivale a << 16
+    *Low = _mm_unpacklo_epi16(_mm_setzero_si128(), samples);
+    *High = _mm_unpackhi_epi16(_mm_setzero_si128(), samples);
+}
+
+static inline VOID LoadInt32(const UCHAR *Data, __m128i *Low, __m128i *High)
+{
+    *Low = _mm_loadu_si128((const __m128i *)Data);
+    *High = _mm_loadu_si128((const __m128i *)(Data + 16));
+}
+
+static inline VOID StoreInt16(PUCHAR Data, __m128i Low, __m128i High)
+{
+    // Tras >> 16 todos los valores caben: PACKSSDW no llega a saturar
+    _mm_storeu_si128((__m128i *)Data,
+                     _mm_packs_epi32(_mm_srai_epi32(Low, 16), _mm_srai_epi32(High, 16)));
+}
+
+static inline VOID StoreInt32(PUCHAR Data, __m128i Low, __m128i High)
+{
+    _mm_storeu_si128((__m128i *)Data, Low);
+    _mm_storeu_si128((__m128i *)(Data + 16), High);
+}
+
+static inline __m128 IntToFloat(__m128i Value)
+{
+    return _mm_mul_ps(_mm_cvtepi32_ps(Value), _mm_set1_ps(SAMPLE_FLOAT_SCALE));
+}
+
+static inline __m128i FloatToInt(__m128 Value, ULONG Bits)
+{
+    __m128 scale = _mm_set1_ps((float)(1UL << (Bits - 1)));
+    __m128i result;
+
+    Value = _mm_mul_ps(Value, scale);
+
+    if (Bits == 32) {
+        // CVTPS2DQ devuelve 0x80000000 fuera de rango; por arriba se corrige a 0x7FFFFFFF
+        result = _mm_cvtps_epi32(Value);
+        return _mm_xor_si128(result, _mm_castps_si128(_mm_cmpge_ps(Value, scale)));
+    }
+
+    Value = _mm_min_ps(Value, _mm_sub_ps(scale, _mm_set1_ps(1.0f)));
+    Value = _mm_max_ps(Value, _mm_sub_ps(_mm_setzero_ps(), scale));
+    return _mm_slli_epi32(_mm_cvtps_epi32(Value), (int)(32 - Bits));
+}
+
+#define DEFINE_INT_TO_INT(Name, Load, Store, SourceFormat, TargetFormat)                        \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)                          \
+    {                                                                                           \
+        const UCHAR *source = (const UCHAR *)Source;                                            \
+        PUCHAR target = (PUCHAR)Target;                                                         \
+        __m128i low;                                                                            \
+        __m128i high;                                                                           \
+        SIZE_T i;                                                                               \
+        for (i = 0; i + 8 <= Samples; i += 8) {                                                 \
+            Load(source + i * SAMPLE_BYTES_##SourceFormat, &low, &high);                        \
+            Store(target + i * SAMPLE_BYTES_##TargetFormat, low, high);                         \
+        }                                                                                       \
+        SampleConvertScalarKernels[SAMPLE_FORMAT_##SourceFormat][SAMPLE_FORMAT_##TargetFormat]( \
+            target + i * SAMPLE_BYTES_##TargetFormat, source + i * SAMPLE_BYTES_##SourceFormat, \
+            Samples - i);                                                                       \
+    }
+
+#define DEFINE_INT_TO_FLOAT(Name, Load, SourceFormat)                                    \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)                   \
+    {                                                                                    \
+        const UCHAR *source = (const UCHAR *)Source;                                     \
+        float *target = (float *)Target;                                                 \
+        __m128i low;                                                                     \
+        __m128i high;                                                                    \
+        SIZE_T i;                                                                        \
+        for (i = 0; i + 8 <= Samples; i += 8) {                                          \
+            Load(source + i * SAMPLE_BYTES_##SourceFormat, &low, &high);                 \
+            _mm_storeu_ps(target + i, IntToFloat(low));                                  \
+            _mm_storeu_ps(target + i + 4, IntToFloat(high));                             \
+        }                                                                                \
+        SampleConvertScalarKernels[SAMPLE_FORMAT_##SourceFormat][SAMPLE_FORMAT_FLOAT32]( \
+            target + i, source + i * SAMPLE_BYTES_##SourceFormat, Samples - i);          \
+    }
+
+#define DEFINE_FLOAT_TO_INT(Name, Store, TargetFormat, Bits)                             \
+    static VOID Name(PVOID Target, const VOID *Source, SIZE_T Samples)                   \
+    {                                                                                    \
+        const float *source = (const float *)Source;                                     \
+        PUCHAR target = (PUCHAR)Target;                                                  \
+        SIZE_T i;                                                                        \
+        for (i = 0; i + 8 <= Samples; i += 8) {                                          \
+            Store(target + i * SAMPLE_BYTES_##TargetFormat,                              \
+                  FloatToInt(_mm_loadu_ps(source + i), Bits),                            \
+                  FloatToInt(_mm_loadu_ps(source + i + 4), Bits));                       \
+        }                                                                                \
+        SampleConvertScalarKernels[SAMPLE_FORMAT_FLOAT32][SAMPLE_FORMAT_##TargetFormat]( \
+            target + i * SAMPLE_BYTES_##TargetFormat, source + i, Samples - i);          \
+    }
+
+#define SAMPLE_BYTES_INT16 2
+#define SAMPLE_BYTES_INT32 4
+
+DEFINE_INT_TO_INT(Sse2Int16ToInt32, LoadInt16, StoreInt32, INT16, INT32)
+DEFINE_INT_TO_INT(Sse2Int32ToInt16, LoadInt32, StoreInt16, INT32, INT16)
+DEFINE_INT_TO_FLOAT(Sse2Int16ToFloat, LoadInt16, INT16)
+DEFINE_INT_TO_FLOAT(Sse2Int32ToFloat, LoadInt32, INT32)
+DEFINE_FLOAT_TO_INT(Sse2FloatToInt16, StoreInt16, INT16, 16)
+DEFINE_FLOAT_TO_INT(Sse2FloatToInt32, StoreInt32, INT32, 32)
+
+const SAMPLE_CONVERT_TABLE SampleConvertSse2Kernels = {
+    // Origen int16
+    { NULL, NULL, Sse2Int16ToInt32, Sse2Int16ToFloat },
+    // Origen int24
+    { NULL, NULL, NULL, NULL },
+    // Origen int32
+    { Sse2Int32ToInt16, NULL, NULL, Sse2Int32ToFloat },
+    // Origen float32
+    { Sse2FloatToInt16, NULL, Sse2FloatToInt32, NULL },
+};
+
+#endif // VMIC_ARCH_X64
@@ -0,0 +1,298 @@
+#include "shared_ring.h"
+#include "ring_buffer.h"
+
+SIZE_T SharedRingGetRequiredSize(
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+)
+{
+    if (FrameSize == 0 || !RingBufferIsValidCapacity(Capacity) ||
+        (ULONG64)Capacity * FrameSize > 0xFFFFFFFFULL - SHARED_RING_DATA_OFFSET) {
+        return 0;
+    }
+
+    return (SIZE_T)SHARED_RING_DATA_OFFSET + (SIZE_T)Capacity * FrameSize;
+}
+
+NTSTATUS SharedRingFormat(
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+)
+{
+    PSHARED_RING_HEADER header = (PSHARED_RING_HEADER)Memory;
+    SIZE_T required = SharedRingGetRequiredSize(Capacity, FrameSize);
+
+    if (Memory == NULL || required == 0 || Size < required) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    RtlZeroMemory(Memory, required);
+    header->Magic = SHARED_RING_MAGIC;
+    header->Version = SHARED_RING_VERSION;
+    header->DataOffset = SHARED_RING_DATA_OFFSET;
+    header->Capacity = Capacity;
+    header->FrameSize = FrameSize;
+
+    return STATUS_SUCCESS;
+}
+
+static VOID SharedRingInitializeView(
+    _Out_ PSHARED_RING_VIEW View,
+    _In_ PVOID Memory,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+)
+{
+    RtlZeroMemory(View, sizeof(SHARED_RING_VIEW));
+    View->Header = (PSHARED_RING_HEADER)Memory;
+    View->Data = (PUCHAR)Memory + SHARED_RING_DATA_OFFSET;
+    View->Capacity = Capacity;
+    View->Mask = Capacity - 1;
+    View->FrameSize = FrameSize;
+}
+
+NTSTATUS SharedRingAttachProducer(
+    _Out_ PSHARED_RING_VIEW View,
+    _In_ PVOID Memory,
+    _In_ SIZE_T Size
+)
+{
+    PSHARED_RING_HEADER header = (PSHARED_RING_HEADER)Memory;
+    SIZE_T required;
+
+    if (View == NULL || Memory == NULL || Size < sizeof(SHARED_RING_HEADER)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (header->Magic != SHARED_RING_MAGIC || header->Version != SHARED_RING_VERSION ||
+        header->DataOffset != SHARED_RING_DATA_OFFSET) {
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    required = SharedRingGetRequiredSize(header->Capacity, header->FrameSize);
+    if (required == 0 || Size < required) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    SharedRingInitializeView(View, Memory, header->Capacity, header->FrameSize);
+
+    // Retomar donde quedó un productor anterior
+    View->Position = VmicReadAcquire64(&header->WritePosition);
+    View->CachedPeer = VmicReadAcquire64(&header->ReadPosition);
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS SharedRingAttachConsumer(
+    _Out_ PSHARED_RING_VIEW View,
+    _In_ PVOID Memory,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize
+)
+{
+    if (View == NULL || Memory == NULL || SharedRingGetRequiredSize(Capacity, FrameSize) == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    SharedRingInitializeView(View, Memory, Capacity, FrameSize);
+    View->Position = VmicReadAcquire64(&View->Header->ReadPosition);
+    View->CachedPeer = View->Position;
+
+    return STATUS_SUCCESS;
+}
+
+// Frames libres vistos por el productor; relee ReadPosition solo si no alcanza
+static ULONG SharedRingProducerFree(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_ ULONG Wanted
+)
+{
+    ULONG freeFrames = View->Capacity - (ULONG)(View->Position - View->CachedPeer);
+
+    if (freeFrames < Wanted) {
+        View->CachedPeer = VmicReadAcquire64(&View->Header->ReadPosition);
+        freeFrames = View->Capacity - (ULONG)(View->Position - View->CachedPeer);
+    }
+
+    return freeFrames;
+}
+
+ULONG SharedRingWrite(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_reads_bytes_(Frames * View->FrameSize) const VOID *Data,
+    _In_ ULONG Frames
+)
+{
+    ULONG framesToCopy = min(Frames, SharedRingProducerFree(View, Frames));
+    ULONG index;
+    ULONG firstChunk;
+
+    if (framesToCopy == 0) {
+        return 0;
+    }
+
+    index = (ULONG)View->Position & View->Mask;
+    firstChunk = min(framesToCopy, View->Capacity - index);
+
+    RtlCopyMemory(View->Data + (SIZE_T)index * View->FrameSize, Data,
+                  (SIZE_T)firstChunk * View->FrameSize);
+    if (framesToCopy > firstChunk) {
+        RtlCopyMemory(View->Data, (const UCHAR *)Data + (SIZE_T)firstChunk * View->FrameSize,
+                      (SIZE_T)(framesToCopy - firstChunk) * View->FrameSize);
+    }
+
+    View->Position += framesToCopy;
+    VmicWriteRelease64(&View->Header->WritePosition, View->Position);
+
+    return framesToCopy;
+}
+
+ULONG SharedRingGetFreeFrames(
+    _Inout_ PSHARED_RING_VIEW View
+)
+{
+    return SharedRingProducerFree(View, View->Capacity);
+}
+
+BOOLEAN SharedRingPrepareWait(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_ ULONG FreeFrames
+)
+{
+    FreeFrames = max(1, min(FreeFrames, View->Capacity));
+
+    // El intercambio es una barrera completa: o el consumidor ve el aviso, o
+    // este lado ve el espacio que liberó
+    VmicInterlockedExchange32(&View->Header->ProducerWaitFrames, (LONG)FreeFrames);
+
+    if (SharedRingGetFreeFrames(View) >= FreeFrames) {
+        VmicInterlockedExchange32(&View->Header->ProducerWaitFrames, 0);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Frames publicados por el productor; FALSE si la posición es imposible
+static BOOLEAN SharedRingConsumerUsed(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_ ULONG Wanted,
+    _Out_ PULONG UsedFrames
+)
+{
+    ULONG64 used = View->CachedPeer - View->Position;
+
+    if (used < Wanted || used > View->Capacity) {
+        View->CachedPeer = VmicReadAcquire64(&View->Header->WritePosition);
+        used = View->CachedPeer - View->Position;
+    }
+
+    // Un WritePosition por detrás de la lectura también da un valor enorme
+    if (used > View->Capacity) {
+        *UsedFrames = 0;
+        return FALSE;
+    }
+
+    *UsedFrames = (ULONG)used;
+    return TRUE;
+}
+
+NTSTATUS SharedRingRead(
+    _Inout_ PSHARED_RING_VIEW View,
+    _Out_writes_bytes_(Frames * View->FrameSize) PVOID Data,
+    _In_ ULONG Frames,
+    _Out_ PULONG FramesRead
+)
+{
+    ULONG usedFrames;
+    ULONG framesToCopy;
+    ULONG index;
+    ULONG firstChunk;
+
+    *FramesRead = 0;
+
+    if (!SharedRingConsumerUsed(View, Frames, &usedFrames)) {
+        return STATUS_DATA_ERROR;
+    }
+
+    framesToCopy = min(Frames, usedFrames);
+    if (framesToCopy == 0) {
+        return STATUS_SUCCESS;
+    }
+
+    index = (ULONG)View->Position & View->Mask;
+    firstChunk = min(framesToCopy, View->Capacity - index);
+
+    RtlCopyMemory(Data, View->Data + (SIZE_T)index * View->FrameSize,
+                  (SIZE_T)firstChunk * View->FrameSize);
+    if (framesToCopy > firstChunk) {
+        RtlCopyMemory((PUCHAR)Data + (SIZE_T)firstChunk * View->FrameSize, View->Data,
+                      (SIZE_T)(framesToCopy - firstChunk) * View->FrameSize);
+    }
+
+    View->Position += framesToCopy;
+    VmicWriteRelease64(&View->Header->ReadPosition, View->Position);
+
+    *FramesRead = framesToCopy;
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS SharedRingDiscard(
+    _Inout_ PSHARED_RING_VIEW View,
+    _In_ ULONG Frames,
+    _Out_ PULONG FramesDiscarded
+)
+{
+    ULONG usedFrames;
+
+    *FramesDiscarded = 0;
+
+    if (!SharedRingConsumerUsed(View, Frames, &usedFrames)) {
+        return STATUS_DATA_ERROR;
+    }
+
+    Frames = min(Frames, usedFrames);
+    if (Frames == 0) {
+        return STATUS_SUCCESS;
+    }
+
+    View->Position += Frames;
+    VmicWriteRelease64(&View->Header->ReadPosition, View->Position);
+
+    *FramesDiscarded = Frames;
+    return STATUS_SUCCESS;
+}
+
+ULONG SharedRingGetUsedFrames(
+    _Inout_ PSHARED_RING_VIEW View
+)
+{
+    ULONG usedFrames;
+
+    SharedRingConsumerUsed(View, View->Capacity, &usedFrames);
+    return usedFrames;
+}
+
+BOOLEAN SharedRingShouldNotifyProducer(
+    _Inout_ PSHARED_RING_VIEW View
+)
+{
+    LONG waitFrames;
+
+    // Barrera completa tras publicar ReadPosition (ver SharedRingPrepareWait)
+    waitFrames = VmicInterlockedExchange32(&View->Header->ProducerWaitFrames, 0);
+    if (waitFrames == 0) {
+        return FALSE;
+    }
+
+    // Todavía no hay el espacio pedido: devolver el aviso. Si el productor lo
+    // retiró mientras tanto, a lo sumo recibirá un despertar espurio.
+    if ((ULONG)waitFrames > View->Capacity - SharedRingGetUsedFrames(View)) {
+        VmicInterlockedExchange32(&View->Header->ProducerWaitFrames, waitFrames);
+        return FALSE;
+    }
+
+    return TRUE;
+}
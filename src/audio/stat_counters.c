@@ -0,0 +1,69 @@
+#include "stat_counters.h"
+
+static ULONG StatCountersGetSlotCount(ULONG Processors)
+{
+    ULONG slots = 1;
+
+    while (slots < Processors && slots < 0x80000000UL) {
+        slots <<= 1;
+    }
+
+    return slots;
+}
+
+SIZE_T StatCountersGetRequiredSize(
+    _In_ ULONG Processors
+)
+{
+    if (Processors == 0) {
+        return 0;
+    }
+
+    // La reserva solo garantiza la alineación del pool: una línea de margen
+    return ((SIZE_T)StatCountersGetSlotCount(Processors) + 1) * sizeof(STAT_COUNTER_SLOT);
+}
+
+NTSTATUS StatCountersInitialize(
+    _Out_ PSTAT_COUNTERS Counters,
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ ULONG Processors
+)
+{
+    ULONG slots;
+    SIZE_T address;
+
+    RtlZeroMemory(Counters, sizeof(STAT_COUNTERS));
+
+    if (Processors == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Memory == NULL || Size < StatCountersGetRequiredSize(Processors)) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    slots = StatCountersGetSlotCount(Processors);
+    address = ((SIZE_T)Memory + VMIC_CACHE_LINE - 1) & ~(SIZE_T)(VMIC_CACHE_LINE - 1);
+
+    Counters->Slots = (PSTAT_COUNTER_SLOT)address;
+    Counters->SlotMask = slots - 1;
+    RtlZeroMemory(Counters->Slots, (SIZE_T)slots * sizeof(STAT_COUNTER_SLOT));
+
+    return STATUS_SUCCESS;
+}
+
+ULONG64 StatCountersRead(
+    _In_ const STAT_COUNTERS *Counters,
+    _In_ STAT_COUNTER Counter
+)
+{
+    ULONG64 total = 0;
+    ULONG slot;
+
+    for (slot = 0; slot <= Counters->SlotMask; slot++) {
+        total += VmicReadNoFence64(&Counters->Slots[slot].Values[Counter]);
+    }
+
+    return total;
+}
@@ -0,0 +1,104 @@
+#include "trace_ring.h"
+
+#define TRACE_RING_MAX_RECORDS (1UL << 24)
+
+static ULONG TraceRingGetRecordCount(ULONG Records)
+{
+    ULONG count = 1;
+
+    while (count < Records && count < TRACE_RING_MAX_RECORDS) {
+        count <<= 1;
+    }
+
+    return count;
+}
+
+SIZE_T TraceRingGetRequiredSize(
+    _In_ ULONG Records
+)
+{
+    if (Records == 0) {
+        return 0;
+    }
+
+    return (SIZE_T)TraceRingGetRecordCount(Records) * sizeof(TRACE_RECORD);
+}
+
+NTSTATUS TraceRingInitialize(
+    _Out_ PTRACE_RING Ring,
+    _Out_writes_bytes_(Size) PVOID Memory,
+    _In_ SIZE_T Size,
+    _In_ ULONG Records
+)
+{
+    ULONG count;
+
+    RtlZeroMemory(Ring, sizeof(TRACE_RING));
+
+    if (Records == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    if (Memory == NULL || Size < TraceRingGetRequiredSize(Records)) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    // Sequence a 0: ningún registro parece publicado
+    count = TraceRingGetRecordCount(Records);
+    Ring->Records = (PTRACE_RECORD)Memory;
+    Ring->Mask = count - 1;
+    RtlZeroMemory(Ring->Records, (SIZE_T)count * sizeof(TRACE_RECORD));
+
+    return STATUS_SUCCESS;
+}
+
+ULONG TraceRingDrain(
+    _Inout_ PTRACE_RING Ring,
+    _Out_writes_(MaxRecords) PTRACE_RECORD Records,
+    _In_ ULONG MaxRecords,
+    _Inout_ PULONG64 Lost
+)
+{
+    ULONG64 capacity = (ULONG64)Ring->Mask + 1;
+    ULONG64 head = VmicReadAcquire64(&Ring->Head);
+    ULONG64 tail = Ring->Tail;
+    PTRACE_RECORD record;
+    ULONG copied = 0;
+
+    // Lo que ya tiene reservado su hueco en una vuelta posterior no se lee
+    if (head - tail > capacity) {
+        *Lost += head - tail - capacity;
+        tail = head - capacity;
+    }
+
+    while (copied < MaxRecords && tail != head) {
+        record = &Ring->Records[tail & Ring->Mask];
+
+        // Sin publicar: o se está escribiendo (se espera al siguiente vaciado)
+        // o ya lo ha reservado la vuelta siguiente (perdido)
+        if (VmicReadAcquire64(&record->Sequence) != tail + 1) {
+            if (VmicReadAcquire64(&Ring->Head) - tail <= capacity) {
+                break;
+            }
+            (*Lost)++;
+            tail++;
+            continue;
+        }
+
+        RtlCopyMemory(&Records[copied], (const VOID *)record, sizeof(TRACE_RECORD));
+
+        // Si un escritor reservó el hueco mientras se copiaba, la copia no vale
+        VmicMemoryBarrier();
+        if (VmicReadNoFence64(&Ring->Head) - tail > capacity) {
+            (*Lost)++;
+            tail++;
+            continue;
+        }
+
+        copied++;
+        tail++;
+    }
+
+    Ring->Tail = tail;
+    return copied;
+}
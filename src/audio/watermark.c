@@ -0,0 +1,61 @@
+#include "watermark.h"
+
+BOOLEAN WatermarkIsValid(
+    _In_ ULONG LowWater,
+    _In_ ULONG HighWater,
+    _In_ ULONG Capacity
+)
+{
+    if (HighWater == 0) {
+        return LowWater < Capacity;
+    }
+
+    return LowWater < HighWater && HighWater <= Capacity;
+}
+
+VOID WatermarkInitialize(
+    _Out_ PWATERMARK_STATE Watermarks,
+    _In_ ULONG LowWater,
+    _In_ ULONG HighWater
+)
+{
+    Watermarks->LowWater = LowWater;
+    Watermarks->HighWater = (HighWater != 0) ? HighWater : WATERMARK_HIGH_DISABLED;
+    Watermarks->Zone = WATERMARK_ZONE_MID;
+}
+
+ULONG WatermarkGetZone(
+    _In_ PWATERMARK_STATE Watermarks,
+    _In_ ULONG UsedFrames
+)
+{
+    if (UsedFrames <= Watermarks->LowWater) {
+        return WATERMARK_ZONE_LOW;
+    }
+
+    if (UsedFrames >= Watermarks->HighWater) {
+        return WATERMARK_ZONE_HIGH;
+    }
+
+    return WATERMARK_ZONE_MID;
+}
+
+BOOLEAN WatermarkUpdate(
+    _Inout_ PWATERMARK_STATE Watermarks,
+    _In_ ULONG UsedFrames
+)
+{
+    LONG zone = (LONG)WatermarkGetZone(Watermarks, UsedFrames);
+
+    // Caso habitual: sin cambio de zona, sin escritura compartida
+    if (zone == Watermarks->Zone) {
+        return FALSE;
+    }
+
+    // El intercambio decide quién anuncia el cruce si lector y escritor lo ven a la vez
+    if (VmicInterlockedExchange32(&Watermarks->Zone, zone) == zone || zone == WATERMARK_ZONE_MID) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
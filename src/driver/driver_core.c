@@ -1,4 +1,5 @@
 #include "driver_core.h"
+#include "audio_processing.h"
 #include "common.h"
 
 // Variables globales
@@ -13,6 +14,10 @@ NTSTATUS InitializeDevice(
     NTSTATUS status;
     PDEVICE_OBJECT deviceObject = NULL;
     PDEVICE_EXTENSION deviceExtension;
+    SAMPLE_FORMAT sampleFormat;
+    ULONG processors;
+    SIZE_T statsSize;
+    SIZE_T traceSize;
     
     UNREFERENCED_PARAMETER(RegistryPath);
     
@@ -42,6 +47,38 @@ NTSTATUS InitializeDevice(
     deviceExtension->DeviceName = g_DeviceName;
     deviceExtension->IsInitialized = FALSE;
     deviceExtension->BufferSize = DEFAULT_BUFFER_SIZE;
+    deviceExtension->MirrorPreferred = DEFAULT_MIRRORED_BUFFER;
+    deviceExtension->MirroredBuffer = DEFAULT_MIRRORED_BUFFER;
+    deviceExtension->StartTimeMs = GetSystemUptimeMs();
+    
+    // Formato por defecto; el productor envía ese mismo formato (sin conversión)
+    deviceExtension->Format.SampleRate = DEFAULT_SAMPLE_RATE;
+    deviceExtension->Format.Channels = DEFAULT_CHANNELS;
+    deviceExtension->Format.BitsPerSample = DEFAULT_BITS_PER_SAMPLE;
+    deviceExtension->Format.BlockAlign = (DEFAULT_CHANNELS * DEFAULT_BITS_PER_SAMPLE) / 8;
+    deviceExtension->Format.BytesPerSecond = DEFAULT_SAMPLE_RATE * deviceExtension->Format.BlockAlign;
+    deviceExtension->Format.FormatTag = AUDIO_FORMAT_TAG_PCM;
+    
+    SampleFormatFromWave(AUDIO_FORMAT_TAG_PCM, DEFAULT_BITS_PER_SAMPLE, &sampleFormat);
+    SampleConverterInitialize(&deviceExtension->InputConverter,
+                              sampleFormat,
+                              sampleFormat,
+                              DEFAULT_CHANNELS,
+                              SAMPLE_CONVERT_ISA_SCALAR);
+    
+    // Ganancia unidad y sin silencio: las lecturas copian sin multiplicar
+    GainRampInitialize(&deviceExtension->OutputGain, 1.0f, SampleConvertGetBestIsa());
+    deviceExtension->Gain = 1.0f;
+    deviceExtension->GainRampFrames = DEFAULT_GAIN_RAMP_FRAMES;
+    deviceExtension->Muted = FALSE;
+    
+    // Medidores desactivados hasta IOCTL_VIRTUALMIC_METERING
+    LevelMeterInitialize(&deviceExtension->LevelMeter, sampleFormat, DEFAULT_CHANNELS, SampleConvertGetBestIsa());
+    deviceExtension->MeteringEnabled = FALSE;
+    
+    // El anillo empieza en la posición 0, sin marcas ni latencias
+    LatencyTagsReset(&deviceExtension->LatencyTags, 0);
+    LatencyHistogramReset(&deviceExtension->Latency);
     
     // Crear enlace simbólico
     status = IoCreateSymbolicLink(&g_SymbolicLinkName, &g_DeviceName);
@@ -53,8 +90,30 @@ NTSTATUS InitializeDevice(
     
     deviceExtension->SymbolicLinkName = g_SymbolicLinkName;
     
-    // Inicializar spinlock para el buffer
-    KeInitializeSpinLock(&deviceExtension->BufferLock);
+    // Inicializar spinlocks de cada lado del buffer
+    KeInitializeSpinLock(&deviceExtension->ProducerLock);
+    KeInitializeSpinLock(&deviceExtension->ConsumerLock);
+    
+    // Política ante buffer lleno
+    deviceExtension->OverflowPolicy = DEFAULT_OVERFLOW_POLICY;
+    deviceExtension->BlockTimeoutMs = DEFAULT_BLOCK_TIMEOUT_MS;
+    ExInitializeFastMutex(&deviceExtension->BlockingWriteMutex);
+    KeInitializeEvent(&deviceExtension->SpaceAvailableEvent, SynchronizationEvent, FALSE);
+    ExInitializeFastMutex(&deviceExtension->SharedRingMutex);
+    KeInitializeSpinLock(&deviceExtension->WatermarkLock);
+    
+    // IRP_MJ_READ con buffer de sistema; las lecturas sin datos quedan pendientes
+    deviceObject->Flags |= DO_BUFFERED_IO;
+    status = InitializePendingReads(deviceExtension);
+    if (NT_SUCCESS(status)) {
+        status = InitializePendingWrites(deviceExtension);
+    }
+    if (!NT_SUCCESS(status)) {
+        ERROR_PRINT("Failed to initialize read queue: 0x%X", status);
+        IoDeleteSymbolicLink(&g_SymbolicLinkName);
+        IoDeleteDevice(deviceObject);
+        return status;
+    }
     
     // Asignar memoria para el buffer de audio
     status = AllocateAudioBuffer(deviceExtension);
@@ -65,6 +124,35 @@ NTSTATUS InitializeDevice(
         return status;
     }
     
+    // Una ranura de contadores por procesador de todos los grupos
+    processors = KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS);
+    statsSize = StatCountersGetRequiredSize(processors);
+    deviceExtension->StatsMemory = ExAllocatePoolWithTag(NonPagedPool, statsSize, POOL_TAG);
+    if (deviceExtension->StatsMemory == NULL) {
+        ERROR_PRINT("Failed to allocate statistics counters");
+        FreeAudioBuffer(deviceExtension);
+        IoDeleteSymbolicLink(&g_SymbolicLinkName);
+        IoDeleteDevice(deviceObject);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    StatCountersInitialize(&deviceExtension->Stats, deviceExtension->StatsMemory, statsSize, processors);
+    
+    // Traza binaria: se reserva aunque VMIC_TRACE=0 (DRAIN_TRACE sigue respondiendo)
+    traceSize = TraceRingGetRequiredSize(DEFAULT_TRACE_RECORDS);
+    deviceExtension->TraceMemory = ExAllocatePoolWithTag(NonPagedPool, traceSize, POOL_TAG);
+    if (deviceExtension->TraceMemory == NULL) {
+        ERROR_PRINT("Failed to allocate trace ring");
+        ExFreePoolWithTag(deviceExtension->StatsMemory, POOL_TAG);
+        FreeAudioBuffer(deviceExtension);
+        IoDeleteSymbolicLink(&g_SymbolicLinkName);
+        IoDeleteDevice(deviceObject);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    TraceRingInitialize(&deviceExtension->Trace, deviceExtension->TraceMemory, traceSize, DEFAULT_TRACE_RECORDS);
+    ExInitializeFastMutex(&deviceExtension->TraceMutex);
+    
     deviceExtension->IsInitialized = TRUE;
     
     DEBUG_PRINT("Driver initialized successfully");
@@ -82,7 +170,13 @@ VOID CleanupDevice(
         
         if (deviceExtension->IsInitialized) {
             // Liberar recursos
+            UnmapSharedRing(deviceExtension, NULL);
+            FlushPendingReads(deviceExtension, NULL);
+            FlushPendingWrites(deviceExtension, NULL);
+            UnregisterWatermarks(deviceExtension, NULL);
             FreeAudioBuffer(deviceExtension);
+            ExFreePoolWithTag(deviceExtension->StatsMemory, POOL_TAG);
+            ExFreePoolWithTag(deviceExtension->TraceMemory, POOL_TAG);
             
             // Eliminar enlace simbólico
             IoDeleteSymbolicLink(&deviceExtension->SymbolicLinkName);
@@ -94,31 +188,350 @@ VOID CleanupDevice(
     DEBUG_PRINT("Device cleanup completed");
 }
 
-NTSTATUS AllocateAudioBuffer(
-    _In_ PDEVICE_EXTENSION DeviceExtension
+VOID DrainTrace(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _Out_ PTRACE_DRAIN_HEADER Header,
+    _In_ ULONG MaxRecords
+)
+{
+    RtlZeroMemory(Header, sizeof(TRACE_DRAIN_HEADER));
+    
+    // Los escritores no se detienen: solo se serializan los lectores
+    ExAcquireFastMutex(&DeviceExtension->TraceMutex);
+    Header->Records = TraceRingDrain(&DeviceExtension->Trace, (PTRACE_RECORD)(Header + 1), MaxRecords, &Header->Lost);
+    ExReleaseFastMutex(&DeviceExtension->TraceMutex);
+}
+
+// Reserva la memoria de respaldo del anillo (espejo si se solicita y es posible)
+static NTSTATUS AllocateRingMemory(
+    _Inout_ PULONG Capacity,
+    _In_ ULONG FrameSize,
+    _Inout_ PBOOLEAN Mirrored,
+    _Out_ PMIRROR_BUFFER Mirror,
+    _Out_ PVOID *Buffer
 )
 {
+    NTSTATUS status;
+    ULONG size;
+    
+    // El anillo indexa frames con máscara: la capacidad debe ser potencia de dos
+    *Capacity = RingBufferRoundUpCapacity(*Capacity);
+    *Buffer = NULL;
+    
+    // Modo espejo: las páginas se mapean dos veces seguidas y ninguna copia
+    // se parte en el wrap-around. Capacity * FrameSize debe ser múltiplo de
+    // página; basta con que Capacity cubra la página dividida entre el mayor
+    // factor potencia de dos de FrameSize. Un anillo más pequeño va al pool:
+    // agrandarlo impondría una latencia mínima de una página de frames.
+    if (*Mirrored && *Capacity < MirrorBufferGetGranularity() / (FrameSize & (~FrameSize + 1))) {
+        *Mirrored = FALSE;
+    }
+    
+    if (*Mirrored) {
+        status = MirrorBufferAllocate(Mirror, *Capacity * FrameSize);
+        if (NT_SUCCESS(status)) {
+            *Buffer = Mirror->BaseAddress;
+            return STATUS_SUCCESS;
+        }
+        
+        ERROR_PRINT("Mirrored buffer unavailable (0x%X), using non-paged pool", status);
+        *Mirrored = FALSE;
+    }
+    
     // Asignar memoria para el buffer de audio
-    DeviceExtension->AudioBuffer = ExAllocatePoolWithTag(NonPagedPool, 
-                                                         DeviceExtension->BufferSize, 
-                                                         POOL_TAG);
-    if (DeviceExtension->AudioBuffer == NULL) {
+    size = *Capacity * FrameSize;
+    *Buffer = ExAllocatePoolWithTag(NonPagedPool, size, POOL_TAG);
+    if (*Buffer == NULL) {
         return STATUS_INSUFFICIENT_RESOURCES;
     }
     
-    RtlZeroMemory(DeviceExtension->AudioBuffer, DeviceExtension->BufferSize);
-    DeviceExtension->WritePosition = 0;
-    DeviceExtension->ReadPosition = 0;
-    
+    RtlZeroMemory(*Buffer, size);
     return STATUS_SUCCESS;
 }
 
+static VOID FreeRingMemory(
+    _In_ BOOLEAN Mirrored,
+    _Inout_ PMIRROR_BUFFER Mirror,
+    _In_ PVOID Buffer
+)
+{
+    if (Mirrored) {
+        MirrorBufferFree(Mirror);
+    } else if (Buffer != NULL) {
+        ExFreePoolWithTag(Buffer, POOL_TAG);
+    }
+}
+
+static NTSTATUS InitializeRing(
+    _Out_ PRING_BUFFER Ring,
+    _In_ PVOID Buffer,
+    _In_ ULONG Capacity,
+    _In_ ULONG FrameSize,
+    _In_ BOOLEAN Mirrored
+)
+{
+    if (Mirrored) {
+        return RingBufferInitializeMirrored(Ring, Buffer, Capacity, FrameSize);
+    }
+    
+    return RingBufferInitialize(Ring, Buffer, Capacity, FrameSize);
+}
+
+NTSTATUS AllocateAudioBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    NTSTATUS status;
+    AUDIO_FORMAT currentFormat;
+    ULONG capacity;
+    
+    // El anillo cuenta frames del formato activo
+    GetCurrentAudioFormat(DeviceExtension, &currentFormat);
+    capacity = (DeviceExtension->BufferSize + currentFormat.BlockAlign - 1) / currentFormat.BlockAlign;
+    
+    status = AllocateRingMemory(&capacity,
+                                currentFormat.BlockAlign,
+                                &DeviceExtension->MirroredBuffer,
+                                &DeviceExtension->Mirror,
+                                &DeviceExtension->AudioBuffer);
+    RETURN_IF_NT_ERROR(status);
+    
+    DeviceExtension->BufferSize = capacity * currentFormat.BlockAlign;
+    
+    return InitializeRing(&DeviceExtension->Ring,
+                          DeviceExtension->AudioBuffer,
+                          capacity,
+                          currentFormat.BlockAlign,
+                          DeviceExtension->MirroredBuffer);
+}
+
 VOID FreeAudioBuffer(
     _In_ PDEVICE_EXTENSION DeviceExtension
 )
 {
-    if (DeviceExtension->AudioBuffer != NULL) {
-        ExFreePoolWithTag(DeviceExtension->AudioBuffer, POOL_TAG);
-        DeviceExtension->AudioBuffer = NULL;
+    FreeRingMemory(DeviceExtension->MirroredBuffer,
+                   &DeviceExtension->Mirror,
+                   DeviceExtension->AudioBuffer);
+    DeviceExtension->AudioBuffer = NULL;
+    
+    FreeResampler(DeviceExtension->Resampler);
+    DeviceExtension->Resampler = NULL;
+    FreeChannelMix(DeviceExtension->ChannelMix);
+    DeviceExtension->ChannelMix = NULL;
+    FreeJitterBuffer(DeviceExtension->JitterBuffer);
+    DeviceExtension->JitterBuffer = NULL;
+    FreeDriftControl(DeviceExtension->DriftControl);
+    DeviceExtension->DriftControl = NULL;
+    FreeDspChain(DeviceExtension->DspChain);
+    DeviceExtension->DspChain = NULL;
+}
+
+VOID FreeResampler(
+    _In_opt_ PRESAMPLER Resampler
+)
+{
+    // El RESAMPLER está al principio de su propia reserva (ResamplerInitialize)
+    if (Resampler != NULL) {
+        ExFreePoolWithTag(Resampler, POOL_TAG);
+    }
+}
+
+VOID FreeChannelMix(
+    _In_opt_ PCHANNEL_MIX ChannelMix
+)
+{
+    if (ChannelMix != NULL) {
+        ExFreePoolWithTag(ChannelMix, POOL_TAG);
+    }
+}
+
+VOID FreeJitterBuffer(
+    _In_opt_ PJITTER_BUFFER JitterBuffer
+)
+{
+    // Como el RESAMPLER, al principio de su propia reserva
+    if (JitterBuffer != NULL) {
+        ExFreePoolWithTag(JitterBuffer, POOL_TAG);
+    }
+}
+
+VOID FreeDriftControl(
+    _In_opt_ PDRIFT_CONTROL DriftControl
+)
+{
+    if (DriftControl != NULL) {
+        ExFreePoolWithTag(DriftControl, POOL_TAG);
+    }
+}
+
+VOID FreeDspChain(
+    _In_opt_ PDSP_CHAIN DspChain
+)
+{
+    if (DspChain != NULL) {
+        ExFreePoolWithTag(DspChain, POOL_TAG);
     }
 }
+
+NTSTATUS ResizeAudioBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ ULONG NewCapacity
+)
+{
+    NTSTATUS status;
+    KIRQL oldIrql;
+    RING_BUFFER newRing;
+    MIRROR_BUFFER newMirror;
+    MIRROR_BUFFER oldMirror;
+    PVOID newBuffer;
+    PVOID oldBuffer;
+    BOOLEAN newMirrored = DeviceExtension->MirrorPreferred;
+    BOOLEAN oldMirrored;
+    ULONG frameSize = DeviceExtension->Ring.FrameSize;
+    ULONG newCapacity = RingBufferRoundUpCapacity(NewCapacity);
+    
+    // Los límites valen para la capacidad real: con frames que no son potencia
+    // de dos (24 bits) el redondeo puede pasar de MAX_BUFFER_SIZE
+    if ((ULONG64)newCapacity * frameSize < MIN_BUFFER_SIZE ||
+        (ULONG64)newCapacity * frameSize > MAX_BUFFER_SIZE) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Reservar el nuevo buffer fuera de los locks (IRQL PASSIVE_LEVEL)
+    status = AllocateRingMemory(&newCapacity, frameSize, &newMirrored, &newMirror, &newBuffer);
+    RETURN_IF_NT_ERROR(status);
+    
+    status = InitializeRing(&newRing, newBuffer, newCapacity, frameSize, newMirrored);
+    if (!NT_SUCCESS(status)) {
+        FreeRingMemory(newMirrored, &newMirror, newBuffer);
+        return status;
+    }
+    
+    // Detener ambos lados (siempre en el mismo orden) mientras se migra el audio pendiente
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    KeAcquireSpinLockAtDpcLevel(&DeviceExtension->ConsumerLock);
+    
+    status = RingBufferMigrate(&newRing, &DeviceExtension->Ring);
+    if (NT_SUCCESS(status)) {
+        oldBuffer = DeviceExtension->AudioBuffer;
+        oldMirrored = DeviceExtension->MirroredBuffer;
+        oldMirror = DeviceExtension->Mirror;
+        
+        DeviceExtension->Ring = newRing;
+        DeviceExtension->AudioBuffer = newBuffer;
+        DeviceExtension->BufferSize = newRing.Size;
+        DeviceExtension->MirroredBuffer = newMirrored;
+        DeviceExtension->Mirror = newMirror;
+    }
+    
+    KeReleaseSpinLockFromDpcLevel(&DeviceExtension->ConsumerLock);
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    if (!NT_SUCCESS(status)) {
+        // Hay más audio pendiente del que cabe en el nuevo tamaño
+        FreeRingMemory(newMirrored, &newMirror, newBuffer);
+        return status;
+    }
+    
+    FreeRingMemory(oldMirrored, &oldMirror, oldBuffer);
+    
+    // Los umbrales registrados se validaron contra la capacidad anterior
+    RefreshWatermarks(DeviceExtension);
+    
+    DEBUG_PRINT("Audio buffer resized to %lu frames (mirrored: %u)", newCapacity, newMirrored);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS ReformatAudioBuffer(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ const AUDIO_FORMAT *Format,
+    _In_ const SAMPLE_CONVERTER *InputConverter,
+    _In_opt_ PCHANNEL_MIX ChannelMix,
+    _In_opt_ PRESAMPLER Resampler,
+    _In_opt_ PJITTER_BUFFER JitterBuffer,
+    _In_opt_ PDRIFT_CONTROL DriftControl,
+    _In_opt_ PDSP_CHAIN DspChain
+)
+{
+    NTSTATUS status;
+    KIRQL oldIrql;
+    RING_BUFFER newRing;
+    MIRROR_BUFFER newMirror;
+    MIRROR_BUFFER oldMirror;
+    PVOID newBuffer;
+    PVOID oldBuffer;
+    PCHANNEL_MIX oldChannelMix;
+    PRESAMPLER oldResampler;
+    PJITTER_BUFFER oldJitterBuffer;
+    PDRIFT_CONTROL oldDriftControl;
+    PDSP_CHAIN oldDspChain;
+    LEVEL_METER newMeter;
+    BOOLEAN newMirrored = DeviceExtension->MirrorPreferred;
+    BOOLEAN oldMirrored;
+    ULONG frameSize = Format->BlockAlign;
+    ULONG newCapacity;
+    
+    // Los medidores pasan al formato nuevo con la ventana vacía
+    status = LevelMeterInitialize(&newMeter, InputConverter->TargetFormat, Format->Channels,
+                                  DeviceExtension->LevelMeter.Isa);
+    RETURN_IF_NT_ERROR(status);
+    
+    // Misma latencia en frames, dentro del tamaño máximo del buffer: la mayor
+    // potencia de dos que cabe, porque AllocateRingMemory redondea hacia arriba
+    newCapacity = min(DeviceExtension->Ring.Capacity, 1UL << VmicHighestSetBit64(MAX_BUFFER_SIZE / frameSize));
+    
+    status = AllocateRingMemory(&newCapacity, frameSize, &newMirrored, &newMirror, &newBuffer);
+    RETURN_IF_NT_ERROR(status);
+    
+    status = InitializeRing(&newRing, newBuffer, newCapacity, frameSize, newMirrored);
+    if (!NT_SUCCESS(status)) {
+        FreeRingMemory(newMirrored, &newMirror, newBuffer);
+        return status;
+    }
+    
+    // El audio pendiente está en el formato anterior: no se migra
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    KeAcquireSpinLockAtDpcLevel(&DeviceExtension->ConsumerLock);
+    
+    oldBuffer = DeviceExtension->AudioBuffer;
+    oldMirrored = DeviceExtension->MirroredBuffer;
+    oldMirror = DeviceExtension->Mirror;
+    oldChannelMix = DeviceExtension->ChannelMix;
+    oldResampler = DeviceExtension->Resampler;
+    oldJitterBuffer = DeviceExtension->JitterBuffer;
+    oldDriftControl = DeviceExtension->DriftControl;
+    oldDspChain = DeviceExtension->DspChain;
+    
+    DeviceExtension->Ring = newRing;
+    DeviceExtension->AudioBuffer = newBuffer;
+    DeviceExtension->BufferSize = newRing.Size;
+    DeviceExtension->MirroredBuffer = newMirrored;
+    DeviceExtension->Mirror = newMirror;
+    DeviceExtension->Format = *Format;
+    DeviceExtension->InputConverter = *InputConverter;
+    DeviceExtension->ChannelMix = ChannelMix;
+    DeviceExtension->Resampler = Resampler;
+    DeviceExtension->JitterBuffer = JitterBuffer;
+    DeviceExtension->DriftControl = DriftControl;
+    DeviceExtension->DspChain = DspChain;
+    DeviceExtension->LevelMeter = newMeter;
+    
+    // Las marcas se refieren a posiciones del anillo anterior
+    LatencyTagsReset(&DeviceExtension->LatencyTags, newRing.Head);
+    
+    KeReleaseSpinLockFromDpcLevel(&DeviceExtension->ConsumerLock);
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    FreeRingMemory(oldMirrored, &oldMirror, oldBuffer);
+    FreeChannelMix(oldChannelMix);
+    FreeResampler(oldResampler);
+    FreeJitterBuffer(oldJitterBuffer);
+    FreeDriftControl(oldDriftControl);
+    FreeDspChain(oldDspChain);
+    
+    // Capacidad nueva y anillo vacío: el productor debe enterarse
+    RefreshWatermarks(DeviceExtension);
+    
+    DEBUG_PRINT("Audio buffer reformatted to %lu frames of %lu bytes", newCapacity, frameSize);
+    return STATUS_SUCCESS;
+}
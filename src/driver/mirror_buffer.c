@@ -0,0 +1,98 @@
+#include "mirror_buffer.h"
+#include "common.h"
+
+ULONG MirrorBufferGetGranularity(VOID)
+{
+    return PAGE_SIZE;
+}
+
+NTSTATUS MirrorBufferAllocate(
+    _Out_ PMIRROR_BUFFER Mirror,
+    _In_ ULONG Size
+)
+{
+    PHYSICAL_ADDRESS lowAddress;
+    PHYSICAL_ADDRESS highAddress;
+    PHYSICAL_ADDRESS skipBytes;
+    PPFN_NUMBER sourcePages;
+    PPFN_NUMBER mirrorPages;
+    ULONG pageCount;
+    
+    RtlZeroMemory(Mirror, sizeof(MIRROR_BUFFER));
+    
+    if (Size == 0 || (Size & (PAGE_SIZE - 1)) != 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    lowAddress.QuadPart = 0;
+    highAddress.QuadPart = -1;
+    skipBytes.QuadPart = 0;
+    
+    // Páginas físicas del buffer (no tienen por qué ser contiguas)
+    Mirror->PagesMdl = MmAllocatePagesForMdlEx(lowAddress, highAddress, skipBytes, Size,
+                                               MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+    if (Mirror->PagesMdl == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    if (MmGetMdlByteCount(Mirror->PagesMdl) != Size) {
+        MirrorBufferFree(Mirror);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    // MDL del doble de tamaño cuyo array de PFN repite las mismas páginas
+    Mirror->MirrorMdl = IoAllocateMdl(NULL, Size * 2, FALSE, FALSE, NULL);
+    if (Mirror->MirrorMdl == NULL) {
+        MirrorBufferFree(Mirror);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    pageCount = Size >> PAGE_SHIFT;
+    sourcePages = MmGetMdlPfnArray(Mirror->PagesMdl);
+    mirrorPages = MmGetMdlPfnArray(Mirror->MirrorMdl);
+    RtlCopyMemory(mirrorPages, sourcePages, pageCount * sizeof(PFN_NUMBER));
+    RtlCopyMemory(mirrorPages + pageCount, sourcePages, pageCount * sizeof(PFN_NUMBER));
+    Mirror->MirrorMdl->MdlFlags |= MDL_PAGES_LOCKED;
+    
+    // Un único mapeo virtual contiguo de 2 * Size bytes
+    Mirror->BaseAddress = (PUCHAR)MmMapLockedPagesSpecifyCache(Mirror->MirrorMdl,
+                                                               KernelMode,
+                                                               MmCached,
+                                                               NULL,
+                                                               FALSE,
+                                                               NormalPagePriority | MdlMappingNoExecute);
+    if (Mirror->BaseAddress == NULL) {
+        MirrorBufferFree(Mirror);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    Mirror->Size = Size;
+    RtlZeroMemory(Mirror->BaseAddress, Size);
+    
+    return STATUS_SUCCESS;
+}
+
+VOID MirrorBufferFree(
+    _Inout_ PMIRROR_BUFFER Mirror
+)
+{
+    if (Mirror->BaseAddress != NULL) {
+        MmUnmapLockedPages(Mirror->BaseAddress, Mirror->MirrorMdl);
+        Mirror->BaseAddress = NULL;
+    }
+    
+    if (Mirror->MirrorMdl != NULL) {
+        // Las páginas pertenecen a PagesMdl; este MDL solo las describe
+        Mirror->MirrorMdl->MdlFlags &= ~MDL_PAGES_LOCKED;
+        IoFreeMdl(Mirror->MirrorMdl);
+        Mirror->MirrorMdl = NULL;
+    }
+    
+    if (Mirror->PagesMdl != NULL) {
+        MmFreePagesFromMdl(Mirror->PagesMdl);
+        ExFreePool(Mirror->PagesMdl);
+        Mirror->PagesMdl = NULL;
+    }
+    
+    Mirror->Size = 0;
+}
@@ -0,0 +1,176 @@
+#include "driver_core.h"
+#include "common.h"
+
+// Cola de IRP pendientes con cancelación segura: IoCsq sobre una READ_QUEUE.
+// La usan las lecturas (pending_reads.c) y, con OVERFLOW_POLICY_PEND, los
+// envíos de audio (pending_writes.c).
+
+// La entrada de la cola vive en DriverContext[0..2]; IoCsq usa DriverContext[3]
+C_ASSERT(sizeof(READ_QUEUE_ENTRY) <= 3 * sizeof(PVOID));
+
+// Contexto de IoCsqRemoveNextIrp
+typedef struct _PENDING_IRP_PEEK_CONTEXT {
+    BOOLEAN Flush;           // Cualquier IRP (de FileObject si no es NULL)
+    PFILE_OBJECT FileObject;
+    ULONG AvailableFrames;   // Frames disponibles para la cabeza (si no es Flush)
+} PENDING_IRP_PEEK_CONTEXT, *PPENDING_IRP_PEEK_CONTEXT;
+
+#define QUEUE_ENTRY_FROM_IRP(irp) ((PREAD_QUEUE_ENTRY)(irp)->Tail.Overlay.DriverContext)
+#define IRP_FROM_QUEUE_ENTRY(entry) CONTAINING_RECORD((entry), IRP, Tail.Overlay.DriverContext)
+
+static NTSTATUS PendingIrpCsqInsertIrp(
+    _In_ PIO_CSQ Csq,
+    _In_ PIRP Irp,
+    _In_ PVOID InsertContext
+)
+{
+    PPENDING_IRP_QUEUE pending = CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq);
+    
+    ReadQueueInsert(&pending->Queue, QUEUE_ENTRY_FROM_IRP(Irp), (ULONG)(ULONG_PTR)InsertContext);
+    return STATUS_SUCCESS;
+}
+
+static VOID PendingIrpCsqRemoveIrp(
+    _In_ PIO_CSQ Csq,
+    _In_ PIRP Irp
+)
+{
+    PPENDING_IRP_QUEUE pending = CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq);
+    
+    ReadQueueRemove(&pending->Queue, QUEUE_ENTRY_FROM_IRP(Irp));
+}
+
+static PIRP PendingIrpCsqPeekNextIrp(
+    _In_ PIO_CSQ Csq,
+    _In_opt_ PIRP Irp,
+    _In_opt_ PVOID PeekContext
+)
+{
+    PPENDING_IRP_QUEUE pending = CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq);
+    PPENDING_IRP_PEEK_CONTEXT peek = (PPENDING_IRP_PEEK_CONTEXT)PeekContext;
+    PREAD_QUEUE_ENTRY entry;
+    PIRP nextIrp;
+    
+    if (peek == NULL) {
+        return NULL;
+    }
+    
+    // Servicio: solo la cabeza, y solo si ya alcanza su umbral (FIFO estricto)
+    if (!peek->Flush) {
+        if (Irp != NULL) {
+            return NULL;
+        }
+        
+        entry = ReadQueuePeekReady(&pending->Queue, peek->AvailableFrames);
+        return (entry != NULL) ? IRP_FROM_QUEUE_ENTRY(entry) : NULL;
+    }
+    
+    entry = ReadQueueNext(&pending->Queue, (Irp != NULL) ? QUEUE_ENTRY_FROM_IRP(Irp) : NULL);
+    while (entry != NULL) {
+        nextIrp = IRP_FROM_QUEUE_ENTRY(entry);
+        if (peek->FileObject == NULL ||
+            IoGetCurrentIrpStackLocation(nextIrp)->FileObject == peek->FileObject) {
+            return nextIrp;
+        }
+        
+        entry = ReadQueueNext(&pending->Queue, entry);
+    }
+    
+    return NULL;
+}
+
+_IRQL_raises_(DISPATCH_LEVEL)
+_Acquires_lock_(CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq)->Lock)
+static VOID PendingIrpCsqAcquireLock(
+    _In_ PIO_CSQ Csq,
+    _Out_ _At_(*Irql, _Post_ _IRQL_saves_) PKIRQL Irql
+)
+{
+    PPENDING_IRP_QUEUE pending = CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq);
+    
+    KeAcquireSpinLock(&pending->Lock, Irql);
+}
+
+_IRQL_requires_(DISPATCH_LEVEL)
+_Releases_lock_(CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq)->Lock)
+static VOID PendingIrpCsqReleaseLock(
+    _In_ PIO_CSQ Csq,
+    _In_ _IRQL_restores_ KIRQL Irql
+)
+{
+    PPENDING_IRP_QUEUE pending = CONTAINING_RECORD(Csq, PENDING_IRP_QUEUE, Csq);
+    
+    KeReleaseSpinLock(&pending->Lock, Irql);
+}
+
+static VOID PendingIrpCsqCompleteCanceledIrp(
+    _In_ PIO_CSQ Csq,
+    _In_ PIRP Irp
+)
+{
+    UNREFERENCED_PARAMETER(Csq);
+    
+    Irp->IoStatus.Status = STATUS_CANCELLED;
+    Irp->IoStatus.Information = 0;
+    IoCompleteRequest(Irp, IO_NO_INCREMENT);
+}
+
+NTSTATUS PendingIrpQueueInitialize(
+    _Out_ PPENDING_IRP_QUEUE Pending,
+    _In_ ULONG MinFillFrames
+)
+{
+    KeInitializeSpinLock(&Pending->Lock);
+    ReadQueueInitialize(&Pending->Queue, MinFillFrames);
+    
+    return IoCsqInitializeEx(&Pending->Csq,
+                             PendingIrpCsqInsertIrp,
+                             PendingIrpCsqRemoveIrp,
+                             PendingIrpCsqPeekNextIrp,
+                             PendingIrpCsqAcquireLock,
+                             PendingIrpCsqReleaseLock,
+                             PendingIrpCsqCompleteCanceledIrp);
+}
+
+VOID PendingIrpQueueInsert(
+    _Inout_ PPENDING_IRP_QUEUE Pending,
+    _In_ PIRP Irp,
+    _In_ ULONG Frames
+)
+{
+    // Marca el IRP como pendiente e instala la rutina de cancelación
+    IoCsqInsertIrpEx(&Pending->Csq, Irp, NULL, (PVOID)(ULONG_PTR)Frames);
+}
+
+PIRP PendingIrpQueueRemoveReady(
+    _Inout_ PPENDING_IRP_QUEUE Pending,
+    _In_ ULONG AvailableFrames
+)
+{
+    PENDING_IRP_PEEK_CONTEXT peek;
+    
+    peek.Flush = FALSE;
+    peek.FileObject = NULL;
+    peek.AvailableFrames = AvailableFrames;
+    
+    return IoCsqRemoveNextIrp(&Pending->Csq, &peek);
+}
+
+VOID PendingIrpQueueFlush(
+    _Inout_ PPENDING_IRP_QUEUE Pending,
+    _In_opt_ PFILE_OBJECT FileObject
+)
+{
+    PENDING_IRP_PEEK_CONTEXT peek;
+    PIRP irp;
+    
+    peek.Flush = TRUE;
+    peek.FileObject = FileObject;
+    peek.AvailableFrames = 0;
+    
+    while ((irp = IoCsqRemoveNextIrp(&Pending->Csq, &peek)) != NULL) {
+        irp->IoStatus.Status = STATUS_CANCELLED;
+        irp->IoStatus.Information = 0;
+        IoCompleteRequest(irp, IO_NO_INCREMENT);
+    }
+}
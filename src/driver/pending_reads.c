@@ -0,0 +1,138 @@
+#include "driver_core.h"
+#include "audio_processing.h"
+#include "common.h"
+
+// Lecturas asíncronas: un IRP_MJ_READ sin datos suficientes queda pendiente
+// (PendingReads) y lo completa el camino de escritura en cuanto el anillo
+// alcanza el umbral de llenado mínimo de la lectura.
+
+NTSTATUS InitializePendingReads(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    DeviceExtension->ReadServiceRequests = 0;
+    
+    return PendingIrpQueueInitialize(&DeviceExtension->PendingReads, DEFAULT_READ_MIN_FILL_FRAMES);
+}
+
+// Tamaño de frame de la fuente de la que lee ReadAudioFromBuffer
+static ULONG GetReadFrameSize(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    return DeviceExtension->SharedRingActive ? DeviceExtension->SharedRing.FrameSize
+                                             : DeviceExtension->Ring.FrameSize;
+}
+
+// Frames con los que comparar el umbral de una lectura, de la misma fuente que
+// ReadAudioFromBuffer. Un anillo lleno ya no puede crecer: satisface cualquier
+// umbral aunque la capacidad sea menor.
+static ULONG GetReadableFrames(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    KIRQL oldIrql;
+    ULONG usedFrames;
+    ULONG capacity;
+    
+    if (DeviceExtension->SharedRingActive) {
+        // La vista guarda estado del consumidor: se consulta bajo su lock
+        KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+        if (DeviceExtension->SharedRingActive) {
+            usedFrames = SharedRingGetUsedFrames(&DeviceExtension->SharedRing);
+            capacity = DeviceExtension->SharedRing.Capacity;
+            KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+            
+            return (usedFrames >= capacity) ? MAXULONG : usedFrames;
+        }
+        KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    }
+    
+    usedFrames = GetBufferUsedFrames(DeviceExtension);
+    
+    return (usedFrames >= DeviceExtension->Ring.Capacity) ? MAXULONG : usedFrames;
+}
+
+// Lee del anillo al buffer del IRP y lo completa
+static NTSTATUS CompleteReadIrp(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG bytesRead = 0;
+    
+    status = ReadAudioFromBuffer(DeviceExtension,
+                                 Irp->AssociatedIrp.SystemBuffer,
+                                 irpStack->Parameters.Read.Length,
+                                 &bytesRead);
+    
+    Irp->IoStatus.Status = status;
+    Irp->IoStatus.Information = NT_SUCCESS(status) ? bytesRead : 0;
+    IoCompleteRequest(Irp, IO_SOUND_INCREMENT);
+    
+    return status;
+}
+
+NTSTATUS QueueOrCompleteRead(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG frames = irpStack->Parameters.Read.Length / GetReadFrameSize(DeviceExtension);
+    
+    if (frames == 0 || Irp->AssociatedIrp.SystemBuffer == NULL) {
+        Irp->IoStatus.Status = STATUS_BUFFER_TOO_SMALL;
+        Irp->IoStatus.Information = 0;
+        IoCompleteRequest(Irp, IO_NO_INCREMENT);
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+    
+    // Con jitter buffer, cada lectura hace avanzar su reloj
+    ServiceJitterBuffer(DeviceExtension);
+    
+    // Camino rápido: sin lecturas por delante y con datos suficientes. Con el
+    // anillo compartido mapeado ningún escritor del driver avisa: se sondea.
+    if (DeviceExtension->SharedRingActive ||
+        (DeviceExtension->PendingReads.Queue.Count == 0 &&
+         GetReadableFrames(DeviceExtension) >= ReadQueueThreshold(&DeviceExtension->PendingReads.Queue, frames))) {
+        return CompleteReadIrp(DeviceExtension, Irp);
+    }
+    
+    PendingIrpQueueInsert(&DeviceExtension->PendingReads, Irp, frames);
+    
+    // Un escritor pudo publicar datos entre la comprobación y la inserción
+    ServicePendingReads(DeviceExtension);
+    
+    return STATUS_PENDING;
+}
+
+VOID ServicePendingReads(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    PIRP irp;
+    
+    // Un único hilo sirve la cola; los demás solo piden otra pasada. Así dos
+    // escritores no reparten los mismos frames entre dos lecturas.
+    if (InterlockedIncrement(&DeviceExtension->ReadServiceRequests) != 1) {
+        return;
+    }
+    
+    do {
+        while ((irp = PendingIrpQueueRemoveReady(&DeviceExtension->PendingReads,
+                                                 GetReadableFrames(DeviceExtension))) != NULL) {
+            CompleteReadIrp(DeviceExtension, irp);
+        }
+    } while (InterlockedDecrement(&DeviceExtension->ReadServiceRequests) != 0);
+}
+
+VOID FlushPendingReads(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+)
+{
+    PendingIrpQueueFlush(&DeviceExtension->PendingReads, FileObject);
+}
@@ -0,0 +1,163 @@
+#include "driver_core.h"
+#include "audio_processing.h"
+#include "common.h"
+
+// Envíos con contrapresión (OVERFLOW_POLICY_PEND): un SEND_AUDIO que no cabe
+// queda pendiente (PendingWrites) y lo completa el lector en cuanto libera
+// espacio para el paquete entero. Los paquetes entran completos y en orden.
+// Con conversión de frecuencia el umbral de cada IRP es la cota de frames de
+// salida del paquete, así que al extraerlo también cabe entero.
+
+NTSTATUS InitializePendingWrites(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    // Con umbral MAXULONG la cabeza solo sale cuando cabe el paquete entero
+    return PendingIrpQueueInitialize(&DeviceExtension->PendingWrites, MAXULONG);
+}
+
+// Muestras de un envío pendiente: siguen siendo válidas hasta completar el IRP
+// (SystemBuffer con METHOD_BUFFERED, páginas bloqueadas con METHOD_IN_DIRECT)
+static const VOID *GetPendingWriteData(
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    
+    if (irpStack->Parameters.DeviceIoControl.IoControlCode == IOCTL_VIRTUALMIC_SEND_AUDIO_DIRECT) {
+        // Ya mapeada al encolar: devuelve la dirección guardada en la MDL
+        return MmGetSystemAddressForMdlSafe(Irp->MdlAddress,
+                                            NormalPagePriority | MdlMappingNoExecute);
+    }
+    
+    return ((PAUDIO_BUFFER_PACKET)Irp->AssociatedIrp.SystemBuffer)->Data;
+}
+
+NTSTATUS QueueOrCompleteWrite(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PIRP Irp,
+    _In_ const VOID *AudioData,
+    _In_ ULONG DataLength
+)
+{
+    KIRQL oldIrql;
+    PSAMPLE_CONVERTER converter = &DeviceExtension->InputConverter;
+    ULONG frameSize = converter->SourceFrameSize;
+    ULONG frames;
+    ULONG ringFrames;
+    BOOLEAN written = FALSE;
+    
+    if (AudioData == NULL || DataLength == 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    if (DeviceExtension->AudioBuffer == NULL) {
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    if (DeviceExtension->SharedRingActive) {
+        return STATUS_DEVICE_BUSY;
+    }
+    
+    if (DataLength % frameSize != 0) {
+        ERROR_PRINT("Packet length %lu is not a multiple of BlockAlign %lu", DataLength, frameSize);
+        return STATUS_INVALID_BUFFER_SIZE;
+    }
+    
+    // Camino rápido: sin envíos por delante y con sitio para el paquete. La
+    // comprobación va bajo ProducerLock para no adelantar al servicio de la cola.
+    // Los frames se calculan dentro por si SetAudioFormat cambió los conversores.
+    KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+    frames = DataLength / converter->SourceFrameSize;
+    ringFrames = GetRingFramesForInput(DeviceExtension, frames);
+    if (DeviceExtension->PendingWrites.Queue.Count == 0 &&
+        RingBufferGetFreeFrames(&DeviceExtension->Ring) >= ringFrames) {
+        WriteInputFramesToRing(DeviceExtension, AudioData, frames);
+        written = TRUE;
+    }
+    KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+    
+    // Un paquete mayor que el anillo nunca llegaría a caber entero
+    if (ringFrames > DeviceExtension->Ring.Capacity) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+    
+    // Bytes del paquete; un IRP pendiente lo conserva hasta completarse
+    Irp->IoStatus.Information = DataLength;
+    
+    if (written) {
+        ServicePendingReads(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
+        return STATUS_SUCCESS;
+    }
+    
+    StatCountersAdd(&DeviceExtension->Stats, STAT_COUNTER_OVERRUNS, 1);
+    PendingIrpQueueInsert(&DeviceExtension->PendingWrites, Irp, ringFrames);
+    
+    // El lector pudo liberar espacio entre la comprobación y la inserción
+    ServicePendingWrites(DeviceExtension);
+    
+    return STATUS_PENDING;
+}
+
+VOID ServicePendingWrites(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    KIRQL oldIrql;
+    PIRP irp;
+    const VOID *audioData;
+    NTSTATUS status;
+    BOOLEAN written = FALSE;
+    
+    // Caso habitual de cada lectura: nada pendiente
+    if (DeviceExtension->PendingWrites.Queue.Count == 0) {
+        return;
+    }
+    
+    for (;;) {
+        status = STATUS_SUCCESS;
+        
+        // Extraer y escribir bajo ProducerLock mantiene el orden de los paquetes
+        // frente al camino rápido de QueueOrCompleteWrite
+        KeAcquireSpinLock(&DeviceExtension->ProducerLock, &oldIrql);
+        irp = PendingIrpQueueRemoveReady(&DeviceExtension->PendingWrites,
+                                         RingBufferGetFreeFrames(&DeviceExtension->Ring));
+        if (irp != NULL) {
+            audioData = GetPendingWriteData(irp);
+            if (audioData != NULL) {
+                WriteInputFramesToRing(DeviceExtension,
+                                       audioData,
+                                       (ULONG)(irp->IoStatus.Information /
+                                               DeviceExtension->InputConverter.SourceFrameSize));
+                written = TRUE;
+            } else {
+                status = STATUS_INSUFFICIENT_RESOURCES;
+            }
+        }
+        KeReleaseSpinLock(&DeviceExtension->ProducerLock, oldIrql);
+        
+        if (irp == NULL) {
+            break;
+        }
+        
+        irp->IoStatus.Status = status;
+        if (!NT_SUCCESS(status)) {
+            irp->IoStatus.Information = 0;
+        }
+        IoCompleteRequest(irp, IO_SOUND_INCREMENT);
+    }
+    
+    if (written) {
+        ServicePendingReads(DeviceExtension);
+        SignalWatermarks(DeviceExtension);
+    }
+}
+
+VOID FlushPendingWrites(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+)
+{
+    PendingIrpQueueFlush(&DeviceExtension->PendingWrites, FileObject);
+}
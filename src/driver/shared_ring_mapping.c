@@ -0,0 +1,211 @@
+#include "driver_core.h"
+#include "common.h"
+
+// Libera la memoria del anillo compartido. La vista de usuario debe
+// desmapearse antes, en el contexto del proceso propietario.
+static VOID FreeSharedRingPages(
+    _In_ PMDL Mdl,
+    _In_opt_ PVOID SystemAddress
+)
+{
+    if (SystemAddress != NULL) {
+        MmUnmapLockedPages(SystemAddress, Mdl);
+    }
+    
+    MmFreePagesFromMdl(Mdl);
+    ExFreePool(Mdl);
+}
+
+NTSTATUS MapSharedRing(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PFILE_OBJECT FileObject,
+    _In_ ULONG Capacity,
+    _In_opt_ HANDLE NotificationEvent,
+    _Out_ PMAP_RING_RESPONSE Response
+)
+{
+    NTSTATUS status;
+    KIRQL oldIrql;
+    PHYSICAL_ADDRESS lowAddress;
+    PHYSICAL_ADDRESS highAddress;
+    PHYSICAL_ADDRESS skipBytes;
+    SHARED_RING_VIEW view;
+    PKEVENT event = NULL;
+    PMDL mdl = NULL;
+    PVOID systemAddress = NULL;
+    PVOID userAddress = NULL;
+    ULONG frameSize = DeviceExtension->Ring.FrameSize;
+    ULONG capacity;
+    SIZE_T size;
+    
+    RtlZeroMemory(Response, sizeof(MAP_RING_RESPONSE));
+    
+    capacity = RingBufferRoundUpCapacity((Capacity != 0) ? Capacity : DeviceExtension->Ring.Capacity);
+    size = SharedRingGetRequiredSize(capacity, frameSize);
+    if (size == 0 || (ULONG64)capacity * frameSize > MAX_BUFFER_SIZE) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // El handle viene del proceso que llama: validarlo como de modo usuario
+    if (NotificationEvent != NULL) {
+        status = ObReferenceObjectByHandle(NotificationEvent,
+                                           EVENT_MODIFY_STATE,
+                                           *ExEventObjectType,
+                                           UserMode,
+                                           (PVOID *)&event,
+                                           NULL);
+        RETURN_IF_NT_ERROR(status);
+    }
+    
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (DeviceExtension->SharedRingMdl != NULL) {
+        status = STATUS_DEVICE_BUSY;
+        goto Exit;
+    }
+    
+    lowAddress.QuadPart = 0;
+    highAddress.QuadPart = -1;
+    skipBytes.QuadPart = 0;
+    
+    // Páginas propias (nunca pool): se exponen al proceso sin filtrar memoria ajena
+    mdl = MmAllocatePagesForMdlEx(lowAddress, highAddress, skipBytes, size,
+                                  MmCached, MM_ALLOCATE_FULLY_REQUIRED);
+    if (mdl == NULL || MmGetMdlByteCount(mdl) < size) {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Exit;
+    }
+    
+    systemAddress = MmMapLockedPagesSpecifyCache(mdl,
+                                                 KernelMode,
+                                                 MmCached,
+                                                 NULL,
+                                                 FALSE,
+                                                 NormalPagePriority | MdlMappingNoExecute);
+    if (systemAddress == NULL) {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Exit;
+    }
+    
+    status = SharedRingFormat(systemAddress, MmGetMdlByteCount(mdl), capacity, frameSize);
+    if (!NT_SUCCESS(status)) {
+        goto Exit;
+    }
+    
+    // El mapeo en modo usuario lanza una excepción si falla
+    __try {
+        userAddress = MmMapLockedPagesSpecifyCache(mdl,
+                                                   UserMode,
+                                                   MmCached,
+                                                   NULL,
+                                                   FALSE,
+                                                   NormalPagePriority | MdlMappingNoExecute);
+    } __except (EXCEPTION_EXECUTE_HANDLER) {
+        userAddress = NULL;
+    }
+    
+    if (userAddress == NULL) {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+        goto Exit;
+    }
+    
+    SharedRingAttachConsumer(&view, systemAddress, capacity, frameSize);
+    
+    DeviceExtension->SharedRingMdl = mdl;
+    DeviceExtension->SharedRingSystemAddress = systemAddress;
+    DeviceExtension->SharedRingUserAddress = userAddress;
+    DeviceExtension->SharedRingProcess = PsGetCurrentProcess();
+    DeviceExtension->SharedRingOwner = FileObject;
+    ObReferenceObject(DeviceExtension->SharedRingProcess);
+    
+    // Publicar al lector
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    DeviceExtension->SharedRing = view;
+    DeviceExtension->SharedRingEvent = event;
+    DeviceExtension->SharedRingActive = TRUE;
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    
+    Response->BaseAddress = (ULONG64)(ULONG_PTR)userAddress;
+    Response->MappedSize = (ULONG)size;
+    Response->Capacity = capacity;
+    Response->FrameSize = frameSize;
+    
+    DEBUG_PRINT("Shared ring mapped: %lu frames of %lu bytes at %p", capacity, frameSize, userAddress);
+    
+    mdl = NULL;
+    event = NULL;
+    status = STATUS_SUCCESS;
+    
+Exit:
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (mdl != NULL) {
+        FreeSharedRingPages(mdl, systemAddress);
+    }
+    
+    if (event != NULL) {
+        ObDereferenceObject(event);
+    }
+    
+    return status;
+}
+
+NTSTATUS UnmapSharedRing(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+)
+{
+    KIRQL oldIrql;
+    KAPC_STATE apcState;
+    PKEVENT event;
+    BOOLEAN attached = FALSE;
+    
+    ExAcquireFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    if (DeviceExtension->SharedRingMdl == NULL) {
+        ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+        return STATUS_INVALID_DEVICE_REQUEST;
+    }
+    
+    if (FileObject != NULL && FileObject != DeviceExtension->SharedRingOwner) {
+        ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+        return STATUS_ACCESS_DENIED;
+    }
+    
+    // Tras soltar el lock ningún lector vuelve a tocar la memoria compartida
+    KeAcquireSpinLock(&DeviceExtension->ConsumerLock, &oldIrql);
+    DeviceExtension->SharedRingActive = FALSE;
+    event = DeviceExtension->SharedRingEvent;
+    DeviceExtension->SharedRingEvent = NULL;
+    KeReleaseSpinLock(&DeviceExtension->ConsumerLock, oldIrql);
+    
+    // La vista de usuario solo se puede quitar desde el proceso propietario
+    if (PsGetCurrentProcess() != DeviceExtension->SharedRingProcess) {
+        KeStackAttachProcess(DeviceExtension->SharedRingProcess, &apcState);
+        attached = TRUE;
+    }
+    
+    MmUnmapLockedPages(DeviceExtension->SharedRingUserAddress, DeviceExtension->SharedRingMdl);
+    
+    if (attached) {
+        KeUnstackDetachProcess(&apcState);
+    }
+    
+    FreeSharedRingPages(DeviceExtension->SharedRingMdl, DeviceExtension->SharedRingSystemAddress);
+    ObDereferenceObject(DeviceExtension->SharedRingProcess);
+    
+    if (event != NULL) {
+        ObDereferenceObject(event);
+    }
+    
+    DeviceExtension->SharedRingMdl = NULL;
+    DeviceExtension->SharedRingSystemAddress = NULL;
+    DeviceExtension->SharedRingUserAddress = NULL;
+    DeviceExtension->SharedRingProcess = NULL;
+    DeviceExtension->SharedRingOwner = NULL;
+    
+    ExReleaseFastMutex(&DeviceExtension->SharedRingMutex);
+    
+    DEBUG_PRINT("Shared ring unmapped");
+    return STATUS_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include "driver_core.h"
+#include "audio_processing.h"
+#include "common.h"
+
+// Avisos de nivel de llenado (IOCTL_VIRTUALMIC_SET_WATERMARKS): el productor
+// espera un evento en lugar de sondear GET_STATS. Un único registro por
+// dispositivo; se anula al cerrar el handle que lo creó.
+
+NTSTATUS RegisterWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PFILE_OBJECT FileObject,
+    _In_ ULONG LowWaterFrames,
+    _In_ ULONG HighWaterFrames,
+    _In_ HANDLE NotificationEvent
+)
+{
+    NTSTATUS status;
+    KIRQL oldIrql;
+    PKEVENT event = NULL;
+    
+    if (NotificationEvent == NULL) {
+        return UnregisterWatermarks(DeviceExtension, FileObject);
+    }
+    
+    if (!WatermarkIsValid(LowWaterFrames, HighWaterFrames, DeviceExtension->Ring.Capacity)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // El handle viene del proceso que llama: validarlo como de modo usuario
+    status = ObReferenceObjectByHandle(NotificationEvent,
+                                       EVENT_MODIFY_STATE,
+                                       *ExEventObjectType,
+                                       UserMode,
+                                       (PVOID *)&event,
+                                       NULL);
+    RETURN_IF_NT_ERROR(status);
+    
+    KeAcquireSpinLock(&DeviceExtension->WatermarkLock, &oldIrql);
+    
+    if (DeviceExtension->WatermarkOwner != NULL && DeviceExtension->WatermarkOwner != FileObject) {
+        KeReleaseSpinLock(&DeviceExtension->WatermarkLock, oldIrql);
+        ObDereferenceObject(event);
+        return STATUS_DEVICE_BUSY;
+    }
+    
+    // Re-registrar desde el mismo handle sustituye umbrales y evento
+    WatermarkInitialize(&DeviceExtension->Watermarks, LowWaterFrames, HighWaterFrames);
+    if (DeviceExtension->WatermarkEvent != NULL) {
+        ObDereferenceObject(DeviceExtension->WatermarkEvent);
+    }
+    DeviceExtension->WatermarkEvent = event;
+    DeviceExtension->WatermarkOwner = FileObject;
+    
+    KeReleaseSpinLock(&DeviceExtension->WatermarkLock, oldIrql);
+    
+    DEBUG_PRINT("Watermarks registered: low %lu, high %lu frames", LowWaterFrames, HighWaterFrames);
+    
+    // Si el anillo ya está en una zona, el productor se entera sin esperar
+    SignalWatermarks(DeviceExtension);
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS UnregisterWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_opt_ PFILE_OBJECT FileObject
+)
+{
+    KIRQL oldIrql;
+    PKEVENT event = NULL;
+    
+    KeAcquireSpinLock(&DeviceExtension->WatermarkLock, &oldIrql);
+    
+    if (FileObject == NULL || DeviceExtension->WatermarkOwner == FileObject) {
+        event = DeviceExtension->WatermarkEvent;
+        DeviceExtension->WatermarkEvent = NULL;
+        DeviceExtension->WatermarkOwner = NULL;
+    }
+    
+    KeReleaseSpinLock(&DeviceExtension->WatermarkLock, oldIrql);
+    
+    if (event == NULL) {
+        return (FileObject == NULL) ? STATUS_SUCCESS : STATUS_INVALID_DEVICE_REQUEST;
+    }
+    
+    ObDereferenceObject(event);
+    return STATUS_SUCCESS;
+}
+
+VOID RefreshWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    KIRQL oldIrql;
+    ULONG capacity = DeviceExtension->Ring.Capacity;
+    ULONG lowWater;
+    ULONG highWater;
+    
+    KeAcquireSpinLock(&DeviceExtension->WatermarkLock, &oldIrql);
+    
+    if (DeviceExtension->WatermarkEvent == NULL) {
+        KeReleaseSpinLock(&DeviceExtension->WatermarkLock, oldIrql);
+        return;
+    }
+    
+    // Un umbral alto por encima de la capacidad no se alcanzaría nunca, y uno
+    // bajo >= capacidad dejaría la zona fija en LOW: se recortan para que
+    // sigan cumpliendo WatermarkIsValid
+    lowWater = DeviceExtension->Watermarks.LowWater;
+    highWater = DeviceExtension->Watermarks.HighWater;
+    if (highWater != WATERMARK_HIGH_DISABLED) {
+        highWater = min(highWater, capacity);
+        lowWater = min(lowWater, highWater - 1);
+    } else {
+        lowWater = min(lowWater, capacity - 1);
+    }
+    
+    // Zona intermedia: la actualización de abajo anuncia la zona actual
+    WatermarkInitialize(&DeviceExtension->Watermarks, lowWater,
+                        (highWater != WATERMARK_HIGH_DISABLED) ? highWater : 0);
+    
+    KeReleaseSpinLock(&DeviceExtension->WatermarkLock, oldIrql);
+    
+    DEBUG_PRINT("Watermarks refreshed: low %lu, high %lu frames", lowWater, highWater);
+    
+    SignalWatermarks(DeviceExtension);
+}
+
+VOID SignalWatermarks(
+    _In_ PDEVICE_EXTENSION DeviceExtension
+)
+{
+    KIRQL oldIrql;
+    
+    // Sin registro basta una lectura sin lock (caso habitual)
+    if (DeviceExtension->WatermarkEvent == NULL) {
+        return;
+    }
+    
+    if (!WatermarkUpdate(&DeviceExtension->Watermarks, GetBufferUsedFrames(DeviceExtension))) {
+        return;
+    }
+    
+    // El lock impide que el evento se libere entre la comprobación y KeSetEvent
+    KeAcquireSpinLock(&DeviceExtension->WatermarkLock, &oldIrql);
+    if (DeviceExtension->WatermarkEvent != NULL) {
+        KeSetEvent(DeviceExtension->WatermarkEvent, IO_NO_INCREMENT, FALSE);
+    }
+    KeReleaseSpinLock(&DeviceExtension->WatermarkLock, oldIrql);
+}
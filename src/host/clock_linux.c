@@ -0,0 +1,11 @@
+#include <time.h>
+
+#include "portable.h"
+
+ULONG64 VmicQueryPerformanceCounter(VOID)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULONG64)ts.tv_sec * 1000000000ULL + (ULONG64)ts.tv_nsec;
+}
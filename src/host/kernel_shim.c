@@ -0,0 +1,583 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ntddk.h"
+
+// Implementación en modo usuario de las rutinas del kernel que usa el driver
+// (ver src/host/km/ntddk.h)
+
+// Segundos entre 1601 y 1970, en unidades de 100 ns
+#define HOST_EPOCH_DIFFERENCE 116444736000000000ULL
+
+static __thread KIRQL g_CurrentIrql = PASSIVE_LEVEL;
+
+static struct _OBJECT_TYPE_HOST {
+    int Unused;
+} g_EventObjectType;
+
+static POBJECT_TYPE g_EventObjectTypePointer = &g_EventObjectType;
+POBJECT_TYPE *ExEventObjectType = &g_EventObjectTypePointer;
+
+static struct _EPROCESS_HOST {
+    int Unused;
+} g_CurrentProcess;
+
+PVOID ExAllocatePoolWithTag(
+    _In_ POOL_TYPE PoolType,
+    _In_ SIZE_T NumberOfBytes,
+    _In_ ULONG Tag
+)
+{
+    void *memory = NULL;
+
+    UNREFERENCED_PARAMETER(PoolType);
+    UNREFERENCED_PARAMETER(Tag);
+
+    // El pool garantiza 16 bytes de alineación
+    if (posix_memalign(&memory, 16, (NumberOfBytes != 0) ? NumberOfBytes : 1) != 0) {
+        return NULL;
+    }
+
+    return memory;
+}
+
+VOID ExFreePoolWithTag(
+    _In_ PVOID P,
+    _In_ ULONG Tag
+)
+{
+    UNREFERENCED_PARAMETER(Tag);
+    free(P);
+}
+
+VOID ExFreePool(
+    _In_ PVOID P
+)
+{
+    free(P);
+}
+
+KIRQL KeGetCurrentIrql(VOID)
+{
+    return g_CurrentIrql;
+}
+
+VOID KeInitializeSpinLock(
+    _Out_ PKSPIN_LOCK SpinLock
+)
+{
+    __atomic_store_n(&SpinLock->Locked, 0, __ATOMIC_RELEASE);
+}
+
+VOID KeAcquireSpinLockAtDpcLevel(
+    _Inout_ PKSPIN_LOCK SpinLock
+)
+{
+    // El dueño puede estar expropiado: ceder en lugar de girar
+    while (__atomic_exchange_n(&SpinLock->Locked, 1, __ATOMIC_ACQUIRE) != 0) {
+        while (__atomic_load_n(&SpinLock->Locked, __ATOMIC_RELAXED) != 0) {
+            sched_yield();
+        }
+    }
+}
+
+VOID KeReleaseSpinLockFromDpcLevel(
+    _Inout_ PKSPIN_LOCK SpinLock
+)
+{
+    __atomic_store_n(&SpinLock->Locked, 0, __ATOMIC_RELEASE);
+}
+
+VOID KeAcquireSpinLock(
+    _Inout_ PKSPIN_LOCK SpinLock,
+    _Out_ PKIRQL OldIrql
+)
+{
+    *OldIrql = g_CurrentIrql;
+    g_CurrentIrql = DISPATCH_LEVEL;
+    KeAcquireSpinLockAtDpcLevel(SpinLock);
+}
+
+VOID KeReleaseSpinLock(
+    _Inout_ PKSPIN_LOCK SpinLock,
+    _In_ KIRQL NewIrql
+)
+{
+    KeReleaseSpinLockFromDpcLevel(SpinLock);
+    g_CurrentIrql = NewIrql;
+}
+
+VOID KeInitializeEvent(
+    _Out_ PRKEVENT Event,
+    _In_ EVENT_TYPE Type,
+    _In_ BOOLEAN State
+)
+{
+    KeInitializeSpinLock(&Event->Lock);
+    Event->Type = Type;
+    Event->Signaled = State ? 1 : 0;
+}
+
+LONG KeSetEvent(
+    _Inout_ PRKEVENT Event,
+    _In_ LONG Increment,
+    _In_ BOOLEAN Wait
+)
+{
+    UNREFERENCED_PARAMETER(Increment);
+    UNREFERENCED_PARAMETER(Wait);
+
+    return __atomic_exchange_n(&Event->Signaled, 1, __ATOMIC_SEQ_CST);
+}
+
+VOID KeClearEvent(
+    _Inout_ PRKEVENT Event
+)
+{
+    __atomic_store_n(&Event->Signaled, 0, __ATOMIC_SEQ_CST);
+}
+
+NTSTATUS KeWaitForSingleObject(
+    _In_ PVOID Object,
+    _In_ KWAIT_REASON WaitReason,
+    _In_ KPROCESSOR_MODE WaitMode,
+    _In_ BOOLEAN Alertable,
+    _In_opt_ PLARGE_INTEGER Timeout
+)
+{
+    PRKEVENT event = (PRKEVENT)Object;
+    ULONG64 deadline = 0;
+    struct timespec pause = { 0, 50000 };
+
+    UNREFERENCED_PARAMETER(WaitReason);
+    UNREFERENCED_PARAMETER(WaitMode);
+    UNREFERENCED_PARAMETER(Alertable);
+
+    if (Timeout != NULL) {
+        deadline = KeQueryInterruptTime() + (ULONG64)(-Timeout->QuadPart);
+    }
+
+    // Sondeo cada 50 us: basta para pruebas y benchmarks
+    for (;;) {
+        if (event->Type == SynchronizationEvent) {
+            if (__atomic_exchange_n(&event->Signaled, 0, __ATOMIC_SEQ_CST) != 0) {
+                return STATUS_SUCCESS;
+            }
+        } else if (__atomic_load_n(&event->Signaled, __ATOMIC_SEQ_CST) != 0) {
+            return STATUS_SUCCESS;
+        }
+
+        if (Timeout != NULL && KeQueryInterruptTime() >= deadline) {
+            return STATUS_TIMEOUT;
+        }
+
+        nanosleep(&pause, NULL);
+    }
+}
+
+VOID ExInitializeFastMutex(
+    _Out_ PFAST_MUTEX FastMutex
+)
+{
+    KeInitializeSpinLock(&FastMutex->Lock);
+    FastMutex->OldIrql = PASSIVE_LEVEL;
+}
+
+VOID ExAcquireFastMutex(
+    _Inout_ PFAST_MUTEX FastMutex
+)
+{
+    KIRQL oldIrql = g_CurrentIrql;
+
+    KeAcquireSpinLockAtDpcLevel(&FastMutex->Lock);
+    FastMutex->OldIrql = oldIrql;
+    g_CurrentIrql = APC_LEVEL;
+}
+
+VOID ExReleaseFastMutex(
+    _Inout_ PFAST_MUTEX FastMutex
+)
+{
+    KIRQL oldIrql = FastMutex->OldIrql;
+
+    KeReleaseSpinLockFromDpcLevel(&FastMutex->Lock);
+    g_CurrentIrql = oldIrql;
+}
+
+ULONG64 KeQueryInterruptTime(VOID)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ULONG64)ts.tv_sec * 10000000ULL + (ULONG64)ts.tv_nsec / 100;
+}
+
+VOID KeQuerySystemTime(
+    _Out_ PLARGE_INTEGER CurrentTime
+)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    CurrentTime->QuadPart = (LONGLONG)((ULONG64)ts.tv_sec * 10000000ULL + (ULONG64)ts.tv_nsec / 100 +
+                                       HOST_EPOCH_DIFFERENCE);
+}
+
+ULONG KeQueryActiveProcessorCountEx(
+    _In_ USHORT GroupNumber
+)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    UNREFERENCED_PARAMETER(GroupNumber);
+    return (count > 0) ? (ULONG)count : 1;
+}
+
+NTSTATUS ObReferenceObjectByHandle(
+    _In_ HANDLE Handle,
+    _In_ ACCESS_MASK DesiredAccess,
+    _In_opt_ POBJECT_TYPE ObjectType,
+    _In_ KPROCESSOR_MODE AccessMode,
+    _Out_ PVOID *Object,
+    _Out_opt_ PVOID HandleInformation
+)
+{
+    UNREFERENCED_PARAMETER(DesiredAccess);
+    UNREFERENCED_PARAMETER(AccessMode);
+    UNREFERENCED_PARAMETER(HandleInformation);
+
+    *Object = NULL;
+
+    if (Handle == NULL) {
+        return STATUS_INVALID_HANDLE;
+    }
+
+    if (ObjectType != NULL && ObjectType != *ExEventObjectType) {
+        return STATUS_OBJECT_TYPE_MISMATCH;
+    }
+
+    *Object = Handle;
+    return STATUS_SUCCESS;
+}
+
+PEPROCESS PsGetCurrentProcess(VOID)
+{
+    return &g_CurrentProcess;
+}
+
+PMDL IoAllocateMdl(
+    _In_opt_ PVOID VirtualAddress,
+    _In_ ULONG Length,
+    _In_ BOOLEAN SecondaryBuffer,
+    _In_ BOOLEAN ChargeQuota,
+    _Inout_opt_ PVOID Irp
+)
+{
+    PMDL mdl = (PMDL)calloc(1, sizeof(MDL));
+
+    UNREFERENCED_PARAMETER(SecondaryBuffer);
+    UNREFERENCED_PARAMETER(ChargeQuota);
+    UNREFERENCED_PARAMETER(Irp);
+
+    if (mdl != NULL) {
+        mdl->StartVa = VirtualAddress;
+        mdl->ByteCount = Length;
+    }
+
+    return mdl;
+}
+
+VOID IoFreeMdl(
+    _In_ PMDL Mdl
+)
+{
+    free(Mdl);
+}
+
+PMDL MmAllocatePagesForMdlEx(
+    _In_ PHYSICAL_ADDRESS LowAddress,
+    _In_ PHYSICAL_ADDRESS HighAddress,
+    _In_ PHYSICAL_ADDRESS SkipBytes,
+    _In_ SIZE_T TotalBytes,
+    _In_ MEMORY_CACHING_TYPE CacheType,
+    _In_ ULONG Flags
+)
+{
+    long pageSize = sysconf(_SC_PAGESIZE);
+    SIZE_T size = (TotalBytes + (SIZE_T)pageSize - 1) & ~((SIZE_T)pageSize - 1);
+    void *pages = NULL;
+    PMDL mdl;
+
+    UNREFERENCED_PARAMETER(LowAddress);
+    UNREFERENCED_PARAMETER(HighAddress);
+    UNREFERENCED_PARAMETER(SkipBytes);
+    UNREFERENCED_PARAMETER(CacheType);
+    UNREFERENCED_PARAMETER(Flags);
+
+    if (size == 0 || size > MAXULONG || posix_memalign(&pages, (size_t)pageSize, size) != 0) {
+        return NULL;
+    }
+
+    // Páginas a cero, como las que entrega el kernel
+    RtlZeroMemory(pages, size);
+
+    mdl = IoAllocateMdl(pages, (ULONG)size, FALSE, FALSE, NULL);
+    if (mdl == NULL) {
+        free(pages);
+        return NULL;
+    }
+
+    mdl->OwnsPages = TRUE;
+    return mdl;
+}
+
+VOID MmFreePagesFromMdl(
+    _Inout_ PMDL MemoryDescriptorList
+)
+{
+    if (MemoryDescriptorList->OwnsPages) {
+        free(MemoryDescriptorList->StartVa);
+        MemoryDescriptorList->StartVa = NULL;
+        MemoryDescriptorList->OwnsPages = FALSE;
+    }
+}
+
+VOID IoCompleteRequest(
+    _In_ PIRP Irp,
+    _In_ CHAR PriorityBoost
+)
+{
+    UNREFERENCED_PARAMETER(PriorityBoost);
+
+    __atomic_add_fetch(&Irp->HostCompleted, 1, __ATOMIC_ACQ_REL);
+}
+
+NTSTATUS IoCreateDevice(
+    _In_ PDRIVER_OBJECT DriverObject,
+    _In_ ULONG DeviceExtensionSize,
+    _In_opt_ PUNICODE_STRING DeviceName,
+    _In_ ULONG DeviceType,
+    _In_ ULONG DeviceCharacteristics,
+    _In_ BOOLEAN Exclusive,
+    _Out_ PDEVICE_OBJECT *DeviceObject
+)
+{
+    PDEVICE_OBJECT device;
+
+    UNREFERENCED_PARAMETER(DeviceName);
+    UNREFERENCED_PARAMETER(DeviceCharacteristics);
+    UNREFERENCED_PARAMETER(Exclusive);
+
+    *DeviceObject = NULL;
+
+    // La extensión va detrás del objeto, alineada como la del kernel
+    device = (PDEVICE_OBJECT)ExAllocatePoolWithTag(NonPagedPool,
+                                                   sizeof(DEVICE_OBJECT) + 16 + DeviceExtensionSize, 0);
+    if (device == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    RtlZeroMemory(device, sizeof(DEVICE_OBJECT) + 16 + DeviceExtensionSize);
+    device->DriverObject = DriverObject;
+    device->DeviceType = DeviceType;
+    device->Flags = DO_DEVICE_INITIALIZING;
+    device->DeviceExtension = (PVOID)(((ULONG_PTR)(device + 1) + 15) & ~(ULONG_PTR)15);
+    device->NextDevice = DriverObject->DeviceObject;
+    DriverObject->DeviceObject = device;
+
+    *DeviceObject = device;
+    return STATUS_SUCCESS;
+}
+
+VOID IoDeleteDevice(
+    _In_ PDEVICE_OBJECT DeviceObject
+)
+{
+    PDEVICE_OBJECT *link = &DeviceObject->DriverObject->DeviceObject;
+
+    while (*link != NULL && *link != DeviceObject) {
+        link = &(*link)->NextDevice;
+    }
+
+    if (*link != NULL) {
+        *link = DeviceObject->NextDevice;
+    }
+
+    ExFreePool(DeviceObject);
+}
+
+NTSTATUS IoCsqInitializeEx(
+    _Out_ PIO_CSQ Csq,
+    _In_ IO_CSQ_INSERT_IRP_EX *CsqInsertIrp,
+    _In_ IO_CSQ_REMOVE_IRP *CsqRemoveIrp,
+    _In_ IO_CSQ_PEEK_NEXT_IRP *CsqPeekNextIrp,
+    _In_ IO_CSQ_ACQUIRE_LOCK *CsqAcquireLock,
+    _In_ IO_CSQ_RELEASE_LOCK *CsqReleaseLock,
+    _In_ IO_CSQ_COMPLETE_CANCELED_IRP *CsqCompleteCanceledIrp
+)
+{
+    Csq->CsqInsertIrp = CsqInsertIrp;
+    Csq->CsqRemoveIrp = CsqRemoveIrp;
+    Csq->CsqPeekNextIrp = CsqPeekNextIrp;
+    Csq->CsqAcquireLock = CsqAcquireLock;
+    Csq->CsqReleaseLock = CsqReleaseLock;
+    Csq->CsqCompleteCanceledIrp = CsqCompleteCanceledIrp;
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS IoCsqInsertIrpEx(
+    _Inout_ PIO_CSQ Csq,
+    _Inout_ PIRP Irp,
+    _Out_opt_ PIO_CSQ_IRP_CONTEXT Context,
+    _In_opt_ PVOID InsertContext
+)
+{
+    NTSTATUS status;
+    KIRQL irql;
+
+    UNREFERENCED_PARAMETER(Context);
+
+    Csq->CsqAcquireLock(Csq, &irql);
+
+    status = Csq->CsqInsertIrp(Csq, Irp, InsertContext);
+    if (NT_SUCCESS(status)) {
+        Irp->Tail.Overlay.DriverContext[3] = Csq;
+        IoMarkIrpPending(Irp);
+    }
+
+    Csq->CsqReleaseLock(Csq, irql);
+    return status;
+}
+
+PIRP IoCsqRemoveNextIrp(
+    _Inout_ PIO_CSQ Csq,
+    _In_opt_ PVOID PeekContext
+)
+{
+    PIRP irp;
+    KIRQL irql;
+
+    Csq->CsqAcquireLock(Csq, &irql);
+
+    irp = Csq->CsqPeekNextIrp(Csq, NULL, PeekContext);
+    if (irp != NULL) {
+        Csq->CsqRemoveIrp(Csq, irp);
+        irp->Tail.Overlay.DriverContext[3] = NULL;
+    }
+
+    Csq->CsqReleaseLock(Csq, irql);
+    return irp;
+}
+
+BOOLEAN IoCancelIrp(
+    _In_ PIRP Irp
+)
+{
+    PIO_CSQ csq = (PIO_CSQ)__atomic_load_n(&Irp->Tail.Overlay.DriverContext[3], __ATOMIC_ACQUIRE);
+    BOOLEAN queued = FALSE;
+    KIRQL irql;
+
+    Irp->Cancel = TRUE;
+
+    if (csq == NULL) {
+        return FALSE;
+    }
+
+    // Quien lo saque de la cola primero se queda con él
+    csq->CsqAcquireLock(csq, &irql);
+    if (Irp->Tail.Overlay.DriverContext[3] == csq) {
+        csq->CsqRemoveIrp(csq, Irp);
+        Irp->Tail.Overlay.DriverContext[3] = NULL;
+        queued = TRUE;
+    }
+    csq->CsqReleaseLock(csq, irql);
+
+    if (queued) {
+        csq->CsqCompleteCanceledIrp(csq, Irp);
+    }
+
+    return queued;
+}
+
+// Quita el modificador l de las conversiones enteras (%lu, %ld, %lx...):
+// en LLP64 son de 32 bits. ll se conserva. Un formato que no cabe se trunca.
+static VOID TranslateLlp64Format(
+    _In_z_ PCSTR Format,
+    _Out_writes_(Size) PCHAR Buffer,
+    _In_ SIZE_T Size
+)
+{
+    SIZE_T length = 0;
+
+    while (*Format != '\0' && length + 1 < Size) {
+        if (*Format != '%') {
+            Buffer[length++] = *Format++;
+            continue;
+        }
+
+        Buffer[length++] = *Format++;
+        while (*Format != '\0' && strchr("-+ #0123456789.*", *Format) != NULL && length + 1 < Size) {
+            Buffer[length++] = *Format++;
+        }
+
+        if (Format[0] == 'l' && Format[1] != 'l' && Format[1] != '\0' && strchr("diouxX", Format[1]) != NULL) {
+            Format++;
+        } else if (Format[0] == 'l' && Format[1] == 'l' && length + 2 < Size) {
+            Buffer[length++] = *Format++;
+            Buffer[length++] = *Format++;
+        }
+
+        if (*Format != '\0' && length + 1 < Size) {
+            Buffer[length++] = *Format++;
+        }
+    }
+
+    Buffer[length] = '\0';
+}
+
+ULONG DbgPrint(
+    _In_z_ PCSTR Format,
+    ...
+)
+{
+    CHAR format[512];
+    va_list args;
+
+    TranslateLlp64Format(Format, format, sizeof(format));
+
+    va_start(args, Format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+
+    return 0;
+}
+
+PIRP HostAllocateIrp(
+    _In_ UCHAR MajorFunction,
+    _In_opt_ PFILE_OBJECT FileObject
+)
+{
+    PIRP irp = (PIRP)calloc(1, sizeof(IRP));
+
+    if (irp != NULL) {
+        irp->RequestorMode = UserMode;
+        irp->HostStack.MajorFunction = MajorFunction;
+        irp->HostStack.FileObject = FileObject;
+        irp->Tail.Overlay.CurrentStackLocation = &irp->HostStack;
+    }
+
+    return irp;
+}
+
+VOID HostFreeIrp(
+    _In_ PIRP Irp
+)
+{
+    free(Irp);
+}
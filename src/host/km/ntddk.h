@@ -0,0 +1,457 @@
+#ifndef VMIC_HOST_NTDDK_H
+#define VMIC_HOST_NTDDK_H
+
+// Sustituto de <ntddk.h> para compilar el driver en Linux (VMIC_HOST_BUILD):
+// solo lo que usan src/main.c, src/driver, src/audio, src/ioctl y src/common,
+// implementado en modo usuario en src/host/kernel_shim.c.
+//
+// - Spin locks de espera activa (cediendo el procesador) y un IRQL por hilo
+//   que suben KeAcquireSpinLock y ExAcquireFastMutex.
+// - Pool con malloc; MDL que describen memoria del proceso (las vistas de
+//   "usuario" y "sistema" son la misma dirección).
+// - IRP de una sola ubicación de pila (HostAllocateIrp) que IoCompleteRequest
+//   marca como completado; IoCsq con cancelación por IoCancelIrp.
+// - Un HANDLE de evento es la dirección de un KEVENT del llamador.
+//
+// No es un simulador del kernel: no hay APC, DPC, procesos ni seguridad.
+
+#include <stdarg.h>
+#include <wchar.h>
+
+#include "portable.h"
+
+// Anotaciones SAL que no cubre portable.h
+#define _In_z_
+#define _In_reads_(size)
+#define _In_reads_opt_(size)
+#define _Out_writes_opt_(size)
+#define _Out_writes_bytes_opt_(size)
+#define _Out_writes_to_(size, count)
+#define _Inout_updates_(size)
+#define _Inout_updates_bytes_(size)
+#define _Field_size_(size)
+#define _Field_size_bytes_(size)
+#define _When_(expr, annotation)
+#define _At_(target, annotation)
+#define _Post_
+#define _IRQL_saves_
+#define _IRQL_restores_
+#define _IRQL_raises_(irql)
+#define _IRQL_requires_(irql)
+#define _IRQL_requires_max_(irql)
+#define _Acquires_lock_(lock)
+#define _Releases_lock_(lock)
+#define _Requires_lock_held_(lock)
+#define _Function_class_(name)
+#define _Use_decl_annotations_
+
+#define C_ASSERT(expr) _Static_assert((expr), #expr)
+#define RTL_NUMBER_OF(array) (sizeof(array) / sizeof((array)[0]))
+#define ARGUMENT_PRESENT(arg) ((arg) != NULL)
+
+// Excepciones estructuradas: aquí nada lanza, el bloque protegido siempre corre
+#define __try                 if (1)
+#define __except(filter)      else if (0)
+#define EXCEPTION_EXECUTE_HANDLER 1
+
+// Tipos básicos que faltan en portable.h
+typedef char CHAR, *PCHAR;
+typedef const char *PCSTR;
+typedef wchar_t WCHAR, *PWCHAR, *PWSTR;
+typedef const wchar_t *PCWSTR;
+typedef int32_t INT;
+typedef uint32_t UINT;
+typedef int64_t LONG_PTR;
+typedef void *HANDLE;
+typedef UCHAR KIRQL, *PKIRQL;
+typedef CHAR KPROCESSOR_MODE;
+typedef ULONG ACCESS_MASK;
+typedef ULONG_PTR KAFFINITY;
+typedef ULONG64 PFN_NUMBER, *PPFN_NUMBER;
+
+typedef union _LARGE_INTEGER {
+    struct {
+        ULONG LowPart;
+        LONG HighPart;
+    } u;
+    LONGLONG QuadPart;
+} LARGE_INTEGER, *PLARGE_INTEGER, PHYSICAL_ADDRESS;
+
+typedef struct _UNICODE_STRING {
+    USHORT Length;
+    USHORT MaximumLength;
+    PWSTR Buffer;
+} UNICODE_STRING, *PUNICODE_STRING;
+
+typedef const UNICODE_STRING *PCUNICODE_STRING;
+
+#define RTL_CONSTANT_STRING(s) \
+    { (USHORT)(sizeof(s) - sizeof((s)[0])), (USHORT)sizeof(s), (PWSTR)(s) }
+
+#define STATUS_TIMEOUT              ((NTSTATUS)0x00000102L)
+#define STATUS_ACCESS_DENIED        ((NTSTATUS)0xC0000022L)
+#define STATUS_OBJECT_TYPE_MISMATCH ((NTSTATUS)0xC0000024L)
+#define STATUS_INVALID_HANDLE       ((NTSTATUS)0xC0000008L)
+#define STATUS_INVALID_DEVICE_STATE ((NTSTATUS)0xC0000184L)
+
+// IRQL
+#define PASSIVE_LEVEL  0
+#define APC_LEVEL      1
+#define DISPATCH_LEVEL 2
+
+#define KernelMode 0
+#define UserMode   1
+
+// Códigos de control
+#define CTL_CODE(DeviceType, Function, Method, Access) \
+    (((ULONG)(DeviceType) << 16) | ((ULONG)(Access) << 14) | ((ULONG)(Function) << 2) | (ULONG)(Method))
+
+#define METHOD_BUFFERED   0
+#define METHOD_IN_DIRECT  1
+#define METHOD_OUT_DIRECT 2
+#define METHOD_NEITHER    3
+
+#define FILE_ANY_ACCESS   0
+#define FILE_READ_ACCESS  1
+#define FILE_WRITE_ACCESS 2
+
+#define FILE_DEVICE_UNKNOWN      0x00000022
+#define FILE_DEVICE_SECURE_OPEN  0x00000100
+#define DO_BUFFERED_IO           0x00000004
+#define DO_DEVICE_INITIALIZING   0x00000080
+
+#define IRP_MJ_CREATE         0x00
+#define IRP_MJ_CLOSE          0x02
+#define IRP_MJ_READ           0x03
+#define IRP_MJ_WRITE          0x04
+#define IRP_MJ_DEVICE_CONTROL 0x0E
+#define IRP_MJ_CLEANUP        0x12
+#define IRP_MJ_MAXIMUM_FUNCTION 0x1B
+
+#define IO_NO_INCREMENT    0
+#define IO_SOUND_INCREMENT 8
+
+#define EVENT_MODIFY_STATE 0x0002
+#define ALL_PROCESSOR_GROUPS 0xFFFF
+
+// Pool
+typedef enum _POOL_TYPE {
+    NonPagedPool = 0,
+    PagedPool = 1,
+    NonPagedPoolNx = 512
+} POOL_TYPE;
+
+PVOID ExAllocatePoolWithTag(
+    _In_ POOL_TYPE PoolType,
+    _In_ SIZE_T NumberOfBytes,
+    _In_ ULONG Tag
+);
+
+VOID ExFreePoolWithTag(
+    _In_ PVOID P,
+    _In_ ULONG Tag
+);
+
+VOID ExFreePool(
+    _In_ PVOID P
+);
+
+// Spin locks: IRQL por hilo, espera activa cediendo el procesador
+typedef struct _KSPIN_LOCK_HOST {
+    volatile LONG Locked;
+} KSPIN_LOCK, *PKSPIN_LOCK;
+
+KIRQL KeGetCurrentIrql(VOID);
+VOID KeInitializeSpinLock(_Out_ PKSPIN_LOCK SpinLock);
+VOID KeAcquireSpinLock(_Inout_ PKSPIN_LOCK SpinLock, _Out_ PKIRQL OldIrql);
+VOID KeReleaseSpinLock(_Inout_ PKSPIN_LOCK SpinLock, _In_ KIRQL NewIrql);
+VOID KeAcquireSpinLockAtDpcLevel(_Inout_ PKSPIN_LOCK SpinLock);
+VOID KeReleaseSpinLockFromDpcLevel(_Inout_ PKSPIN_LOCK SpinLock);
+
+// Eventos y mutex rápidos
+typedef enum _EVENT_TYPE {
+    NotificationEvent,
+    SynchronizationEvent
+} EVENT_TYPE;
+
+typedef enum _KWAIT_REASON {
+    Executive
+} KWAIT_REASON;
+
+typedef struct _KEVENT {
+    KSPIN_LOCK Lock;
+    EVENT_TYPE Type;
+    volatile LONG Signaled;
+} KEVENT, *PKEVENT, *PRKEVENT;
+
+typedef struct _FAST_MUTEX {
+    KSPIN_LOCK Lock;
+    KIRQL OldIrql;
+} FAST_MUTEX, *PFAST_MUTEX;
+
+VOID KeInitializeEvent(_Out_ PRKEVENT Event, _In_ EVENT_TYPE Type, _In_ BOOLEAN State);
+LONG KeSetEvent(_Inout_ PRKEVENT Event, _In_ LONG Increment, _In_ BOOLEAN Wait);
+VOID KeClearEvent(_Inout_ PRKEVENT Event);
+
+// Solo eventos. Timeout relativo (negativo, en 100 ns); NULL espera sin límite
+NTSTATUS KeWaitForSingleObject(
+    _In_ PVOID Object,
+    _In_ KWAIT_REASON WaitReason,
+    _In_ KPROCESSOR_MODE WaitMode,
+    _In_ BOOLEAN Alertable,
+    _In_opt_ PLARGE_INTEGER Timeout
+);
+
+VOID ExInitializeFastMutex(_Out_ PFAST_MUTEX FastMutex);
+VOID ExAcquireFastMutex(_Inout_ PFAST_MUTEX FastMutex);
+VOID ExReleaseFastMutex(_Inout_ PFAST_MUTEX FastMutex);
+
+#define InterlockedIncrement(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#define InterlockedDecrement(ptr) __atomic_sub_fetch((ptr), 1, __ATOMIC_SEQ_CST)
+#define InterlockedOr(ptr, value) __atomic_fetch_or((ptr), (value), __ATOMIC_SEQ_CST)
+#define InterlockedExchange(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+
+// Tiempo (100 ns): de interrupción desde el arranque y de sistema desde 1601
+ULONG64 KeQueryInterruptTime(VOID);
+VOID KeQuerySystemTime(_Out_ PLARGE_INTEGER CurrentTime);
+ULONG KeQueryActiveProcessorCountEx(_In_ USHORT GroupNumber);
+
+// Objetos y procesos
+typedef struct _OBJECT_TYPE_HOST *POBJECT_TYPE;
+typedef struct _EPROCESS_HOST *PEPROCESS;
+
+typedef struct _KAPC_STATE {
+    PVOID Unused;
+} KAPC_STATE, *PKAPC_STATE, *PRKAPC_STATE;
+
+extern POBJECT_TYPE *ExEventObjectType;
+
+// Handle = dirección de un KEVENT (solo eventos)
+NTSTATUS ObReferenceObjectByHandle(
+    _In_ HANDLE Handle,
+    _In_ ACCESS_MASK DesiredAccess,
+    _In_opt_ POBJECT_TYPE ObjectType,
+    _In_ KPROCESSOR_MODE AccessMode,
+    _Out_ PVOID *Object,
+    _Out_opt_ PVOID HandleInformation
+);
+
+#define ObReferenceObject(object)   ((void)(object))
+#define ObDereferenceObject(object) ((void)(object))
+
+PEPROCESS PsGetCurrentProcess(VOID);
+#define KeStackAttachProcess(process, apcState) ((void)(process), (void)(apcState))
+#define KeUnstackDetachProcess(apcState)        ((void)(apcState))
+
+// MDL: memoria del proceso, sin páginas bloqueadas
+typedef struct _MDL {
+    PVOID StartVa;
+    ULONG ByteCount;
+    BOOLEAN OwnsPages;
+} MDL, *PMDL;
+
+typedef enum _MEMORY_CACHING_TYPE {
+    MmNonCached,
+    MmCached
+} MEMORY_CACHING_TYPE;
+
+#define NormalPagePriority        16
+#define MdlMappingNoExecute       0x40000000
+#define MM_ALLOCATE_FULLY_REQUIRED 0x00000004
+
+PMDL IoAllocateMdl(
+    _In_opt_ PVOID VirtualAddress,
+    _In_ ULONG Length,
+    _In_ BOOLEAN SecondaryBuffer,
+    _In_ BOOLEAN ChargeQuota,
+    _Inout_opt_ PVOID Irp
+);
+
+VOID IoFreeMdl(_In_ PMDL Mdl);
+
+PMDL MmAllocatePagesForMdlEx(
+    _In_ PHYSICAL_ADDRESS LowAddress,
+    _In_ PHYSICAL_ADDRESS HighAddress,
+    _In_ PHYSICAL_ADDRESS SkipBytes,
+    _In_ SIZE_T TotalBytes,
+    _In_ MEMORY_CACHING_TYPE CacheType,
+    _In_ ULONG Flags
+);
+
+VOID MmFreePagesFromMdl(_Inout_ PMDL MemoryDescriptorList);
+
+#define MmGetMdlByteCount(mdl) ((mdl)->ByteCount)
+#define MmGetSystemAddressForMdlSafe(mdl, priority) ((void)(priority), (mdl)->StartVa)
+#define MmMapLockedPagesSpecifyCache(mdl, mode, cache, address, bugcheck, priority) \
+    ((void)(mode), (void)(cache), (void)(address), (void)(bugcheck), (void)(priority), (mdl)->StartVa)
+#define MmUnmapLockedPages(address, mdl) ((void)(address), (void)(mdl))
+
+// Objetos de E/S
+struct _IRP;
+struct _DEVICE_OBJECT;
+struct _DRIVER_OBJECT;
+
+typedef struct _FILE_OBJECT {
+    struct _DEVICE_OBJECT *DeviceObject;
+    PVOID FsContext;
+} FILE_OBJECT, *PFILE_OBJECT;
+
+typedef NTSTATUS DRIVER_DISPATCH(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp);
+typedef DRIVER_DISPATCH *PDRIVER_DISPATCH;
+typedef VOID DRIVER_UNLOAD(struct _DRIVER_OBJECT *DriverObject);
+typedef DRIVER_UNLOAD *PDRIVER_UNLOAD;
+typedef NTSTATUS DRIVER_INITIALIZE(struct _DRIVER_OBJECT *DriverObject, PUNICODE_STRING RegistryPath);
+
+typedef struct _DEVICE_OBJECT {
+    struct _DRIVER_OBJECT *DriverObject;
+    struct _DEVICE_OBJECT *NextDevice;
+    ULONG Flags;
+    ULONG DeviceType;
+    PVOID DeviceExtension;
+} DEVICE_OBJECT, *PDEVICE_OBJECT;
+
+typedef struct _DRIVER_OBJECT {
+    PDEVICE_OBJECT DeviceObject;
+    PDRIVER_UNLOAD DriverUnload;
+    PDRIVER_DISPATCH MajorFunction[IRP_MJ_MAXIMUM_FUNCTION + 1];
+} DRIVER_OBJECT, *PDRIVER_OBJECT;
+
+typedef struct _IO_STATUS_BLOCK {
+    NTSTATUS Status;
+    ULONG_PTR Information;
+} IO_STATUS_BLOCK, *PIO_STATUS_BLOCK;
+
+typedef struct _IO_STACK_LOCATION {
+    UCHAR MajorFunction;
+    UCHAR MinorFunction;
+    union {
+        struct {
+            ULONG Length;
+            ULONG Key;
+            LARGE_INTEGER ByteOffset;
+        } Read;
+        struct {
+            ULONG OutputBufferLength;
+            ULONG InputBufferLength;
+            ULONG IoControlCode;
+            PVOID Type3InputBuffer;
+        } DeviceIoControl;
+    } Parameters;
+    PDEVICE_OBJECT DeviceObject;
+    PFILE_OBJECT FileObject;
+} IO_STACK_LOCATION, *PIO_STACK_LOCATION;
+
+typedef struct _IRP {
+    PMDL MdlAddress;
+    union {
+        PVOID SystemBuffer;
+    } AssociatedIrp;
+    IO_STATUS_BLOCK IoStatus;
+    KPROCESSOR_MODE RequestorMode;
+    BOOLEAN PendingReturned;
+    volatile BOOLEAN Cancel;
+    union {
+        struct {
+            PVOID DriverContext[4];
+            PIO_STACK_LOCATION CurrentStackLocation;
+        } Overlay;
+    } Tail;
+    // Solo en el host: veces que IoCompleteRequest lo ha completado
+    volatile LONG HostCompleted;
+    IO_STACK_LOCATION HostStack;
+} IRP, *PIRP;
+
+#define IoGetCurrentIrpStackLocation(irp) ((irp)->Tail.Overlay.CurrentStackLocation)
+#define IoMarkIrpPending(irp)             ((irp)->PendingReturned = TRUE)
+
+VOID IoCompleteRequest(_In_ PIRP Irp, _In_ CHAR PriorityBoost);
+
+NTSTATUS IoCreateDevice(
+    _In_ PDRIVER_OBJECT DriverObject,
+    _In_ ULONG DeviceExtensionSize,
+    _In_opt_ PUNICODE_STRING DeviceName,
+    _In_ ULONG DeviceType,
+    _In_ ULONG DeviceCharacteristics,
+    _In_ BOOLEAN Exclusive,
+    _Out_ PDEVICE_OBJECT *DeviceObject
+);
+
+VOID IoDeleteDevice(_In_ PDEVICE_OBJECT DeviceObject);
+
+// Sin espacio de nombres de objetos: los enlaces no existen
+static inline NTSTATUS IoCreateSymbolicLink(PUNICODE_STRING SymbolicLinkName, PUNICODE_STRING DeviceName)
+{
+    (void)SymbolicLinkName;
+    (void)DeviceName;
+    return STATUS_SUCCESS;
+}
+
+static inline NTSTATUS IoDeleteSymbolicLink(PUNICODE_STRING SymbolicLinkName)
+{
+    (void)SymbolicLinkName;
+    return STATUS_SUCCESS;
+}
+
+// Cola de IRP con cancelación segura: el IRP guarda su cola en DriverContext[3]
+struct _IO_CSQ;
+
+typedef NTSTATUS IO_CSQ_INSERT_IRP_EX(struct _IO_CSQ *Csq, PIRP Irp, PVOID InsertContext);
+typedef VOID IO_CSQ_REMOVE_IRP(struct _IO_CSQ *Csq, PIRP Irp);
+typedef PIRP IO_CSQ_PEEK_NEXT_IRP(struct _IO_CSQ *Csq, PIRP Irp, PVOID PeekContext);
+typedef VOID IO_CSQ_ACQUIRE_LOCK(struct _IO_CSQ *Csq, PKIRQL Irql);
+typedef VOID IO_CSQ_RELEASE_LOCK(struct _IO_CSQ *Csq, KIRQL Irql);
+typedef VOID IO_CSQ_COMPLETE_CANCELED_IRP(struct _IO_CSQ *Csq, PIRP Irp);
+
+typedef struct _IO_CSQ {
+    IO_CSQ_INSERT_IRP_EX *CsqInsertIrp;
+    IO_CSQ_REMOVE_IRP *CsqRemoveIrp;
+    IO_CSQ_PEEK_NEXT_IRP *CsqPeekNextIrp;
+    IO_CSQ_ACQUIRE_LOCK *CsqAcquireLock;
+    IO_CSQ_RELEASE_LOCK *CsqReleaseLock;
+    IO_CSQ_COMPLETE_CANCELED_IRP *CsqCompleteCanceledIrp;
+} IO_CSQ, *PIO_CSQ;
+
+typedef struct _IO_CSQ_IRP_CONTEXT *PIO_CSQ_IRP_CONTEXT;
+
+NTSTATUS IoCsqInitializeEx(
+    _Out_ PIO_CSQ Csq,
+    _In_ IO_CSQ_INSERT_IRP_EX *CsqInsertIrp,
+    _In_ IO_CSQ_REMOVE_IRP *CsqRemoveIrp,
+    _In_ IO_CSQ_PEEK_NEXT_IRP *CsqPeekNextIrp,
+    _In_ IO_CSQ_ACQUIRE_LOCK *CsqAcquireLock,
+    _In_ IO_CSQ_RELEASE_LOCK *CsqReleaseLock,
+    _In_ IO_CSQ_COMPLETE_CANCELED_IRP *CsqCompleteCanceledIrp
+);
+
+NTSTATUS IoCsqInsertIrpEx(
+    _Inout_ PIO_CSQ Csq,
+    _Inout_ PIRP Irp,
+    _Out_opt_ PIO_CSQ_IRP_CONTEXT Context,
+    _In_opt_ PVOID InsertContext
+);
+
+PIRP IoCsqRemoveNextIrp(
+    _Inout_ PIO_CSQ Csq,
+    _In_opt_ PVOID PeekContext
+);
+
+// Cancela un IRP encolado con IoCsq; FALSE si ya no estaba en una cola
+BOOLEAN IoCancelIrp(_In_ PIRP Irp);
+
+// Depuración. Los formatos del driver siguen el modelo LLP64 de Windows (%lu
+// para ULONG, de 32 bits): DbgPrint los traduce antes de vfprintf y no lleva
+// el atributo format(printf), que los comprobaría con el long de 64 bits
+ULONG DbgPrint(_In_z_ PCSTR Format, ...);
+
+// Solo en el host: IRP de una ubicación de pila a cero, con RequestorMode
+// UserMode. Se libera con HostFreeIrp (el MDL, si lo hay, es del llamador).
+PIRP HostAllocateIrp(
+    _In_ UCHAR MajorFunction,
+    _In_opt_ PFILE_OBJECT FileObject
+);
+
+VOID HostFreeIrp(
+    _In_ PIRP Irp
+);
+
+#endif // VMIC_HOST_NTDDK_H
@@ -0,0 +1,8 @@
+#ifndef VMIC_HOST_NTSTRSAFE_H
+#define VMIC_HOST_NTSTRSAFE_H
+
+// Sustituto de <ntstrsafe.h> para la compilación de host: el driver no usa
+// ninguna de sus rutinas (ver ntddk.h)
+#include "ntddk.h"
+
+#endif // VMIC_HOST_NTSTRSAFE_H
@@ -0,0 +1,75 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mirror_buffer.h"
+
+ULONG MirrorBufferGetGranularity(VOID)
+{
+    return (ULONG)sysconf(_SC_PAGESIZE);
+}
+
+NTSTATUS MirrorBufferAllocate(
+    _Out_ PMIRROR_BUFFER Mirror,
+    _In_ ULONG Size
+)
+{
+    PUCHAR reserved;
+    void *first;
+    void *second;
+
+    RtlZeroMemory(Mirror, sizeof(MIRROR_BUFFER));
+    Mirror->Fd = -1;
+
+    if (Size == 0 || (Size % MirrorBufferGetGranularity()) != 0) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    // Objeto de memoria anónimo que respalda ambas vistas
+    Mirror->Fd = memfd_create("vmic_ring", MFD_CLOEXEC);
+    if (Mirror->Fd < 0) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (ftruncate(Mirror->Fd, Size) != 0) {
+        MirrorBufferFree(Mirror);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    // Reservar 2 * Size de espacio virtual contiguo y mapear el objeto dos veces
+    reserved = (PUCHAR)mmap(NULL, (size_t)Size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        MirrorBufferFree(Mirror);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    first = mmap(reserved, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, Mirror->Fd, 0);
+    second = mmap(reserved + Size, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, Mirror->Fd, 0);
+    if (first != reserved || second != reserved + Size) {
+        munmap(reserved, (size_t)Size * 2);
+        MirrorBufferFree(Mirror);
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    Mirror->BaseAddress = reserved;
+    Mirror->Size = Size;
+
+    return STATUS_SUCCESS;
+}
+
+VOID MirrorBufferFree(
+    _Inout_ PMIRROR_BUFFER Mirror
+)
+{
+    if (Mirror->BaseAddress != NULL) {
+        munmap(Mirror->BaseAddress, (size_t)Mirror->Size * 2);
+        Mirror->BaseAddress = NULL;
+    }
+
+    if (Mirror->Fd >= 0) {
+        close(Mirror->Fd);
+        Mirror->Fd = -1;
+    }
+
+    Mirror->Size = 0;
+}
@@ -0,0 +1,12 @@
+#define _GNU_SOURCE
+#include <sched.h>
+
+#include "portable.h"
+
+ULONG VmicGetCurrentProcessor(VOID)
+{
+    int cpu = sched_getcpu();
+
+    // Sin soporte del sistema todos comparten la ranura 0
+    return (cpu < 0) ? 0 : (ULONG)cpu;
+}
@@ -0,0 +1,113 @@
+#include "ioctl_dispatch.h"
+
+NTSTATUS IoctlDispatcherInitialize(
+    _Out_ PIOCTL_DISPATCHER Dispatcher,
+    _In_ const IOCTL_DISPATCH_ENTRY *Entries,
+    _In_ ULONG EntryCount
+)
+{
+    ULONG slot;
+    ULONG i;
+
+    RtlZeroMemory(Dispatcher, sizeof(IOCTL_DISPATCHER));
+
+    if (Entries == NULL || EntryCount > IOCTL_DISPATCH_MAX_ENTRIES) {
+        return STATUS_INVALID_PARAMETER;
+    }
+
+    for (i = 0; i < EntryCount; i++) {
+        slot = IOCTL_DISPATCH_FUNCTION(Entries[i].IoControlCode) - IOCTL_DISPATCH_FIRST_FUNCTION;
+
+        if (Entries[i].Handler == NULL || slot >= IOCTL_DISPATCH_MAX_ENTRIES ||
+            Dispatcher->Index[slot] != 0) {
+            RtlZeroMemory(Dispatcher->Index, sizeof(Dispatcher->Index));
+            return STATUS_INVALID_PARAMETER;
+        }
+
+        Dispatcher->Index[slot] = (UCHAR)(i + 1);
+    }
+
+    Dispatcher->Entries = Entries;
+    Dispatcher->EntryCount = EntryCount;
+
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS IoctlDispatcherCall(
+    _Inout_ PIOCTL_DISPATCHER Dispatcher,
+    _In_ const IOCTL_DISPATCH_ENTRY *Entry,
+    _In_ struct _DEVICE_OBJECT *DeviceObject,
+    _In_ struct _IRP *Irp,
+    _In_ ULONG InputLength,
+    _In_ const ULONG_PTR *Information
+)
+{
+    PIOCTL_COUNTERS counters = &Dispatcher->Counters[Entry - Dispatcher->Entries];
+    NTSTATUS status;
+    ULONG64 start;
+    ULONG64 ticks;
+    ULONG64 max;
+
+    start = VmicQueryPerformanceCounter();
+    status = Entry->Handler(DeviceObject, Irp);
+    ticks = VmicQueryPerformanceCounter() - start;
+
+    VmicInterlockedAddNoFence64(&counters->Calls, 1);
+    VmicInterlockedAddNoFence64(&counters->BytesIn, InputLength);
+    VmicInterlockedAddNoFence64(&counters->TotalTicks, ticks);
+
+    if (status == STATUS_SUCCESS) {
+        VmicInterlockedAddNoFence64(&counters->BytesOut, *Information);
+    } else if (status == STATUS_PENDING) {
+        VmicInterlockedAddNoFence64(&counters->Pending, 1);
+    } else if (!NT_SUCCESS(status)) {
+        VmicInterlockedAddNoFence64(&counters->Errors, 1);
+    }
+
+    // El máximo solo se escribe cuando sube: casi siempre es una lectura
+    max = VmicReadNoFence64(&counters->MaxTicks);
+    while (ticks > max) {
+        max = VmicInterlockedCompareExchange64(&counters->MaxTicks, ticks, max);
+    }
+
+    return status;
+}
+
+static ULONG64 TicksToNs(ULONG64 Ticks, ULONG64 Frequency)
+{
+    // Sin desbordar con totales grandes
+    return (Ticks / Frequency) * 1000000000ULL + (Ticks % Frequency) * 1000000000ULL / Frequency;
+}
+
+ULONG IoctlDispatcherGetStats(
+    _In_ const IOCTL_DISPATCHER *Dispatcher,
+    _Out_ PIOCTL_STATS_HEADER Header,
+    _Out_writes_(MaxEntries) PIOCTL_CALL_STATS Stats,
+    _In_ ULONG MaxEntries
+)
+{
+    ULONG64 frequency = VmicQueryPerformanceFrequency();
+    const IOCTL_COUNTERS *counters;
+    ULONG count = min(MaxEntries, Dispatcher->EntryCount);
+    ULONG i;
+
+    RtlZeroMemory(Header, sizeof(IOCTL_STATS_HEADER));
+    Header->Entries = count;
+    Header->UnknownCalls = VmicReadNoFence64(&Dispatcher->UnknownCalls);
+
+    for (i = 0; i < count; i++) {
+        counters = &Dispatcher->Counters[i];
+
+        RtlZeroMemory(&Stats[i], sizeof(IOCTL_CALL_STATS));
+        Stats[i].IoControlCode = Dispatcher->Entries[i].IoControlCode;
+        Stats[i].Calls = VmicReadNoFence64(&counters->Calls);
+        Stats[i].Errors = VmicReadNoFence64(&counters->Errors);
+        Stats[i].Pending = VmicReadNoFence64(&counters->Pending);
+        Stats[i].BytesIn = VmicReadNoFence64(&counters->BytesIn);
+        Stats[i].BytesOut = VmicReadNoFence64(&counters->BytesOut);
+        Stats[i].TotalTimeNs = TicksToNs(VmicReadNoFence64(&counters->TotalTicks), frequency);
+        Stats[i].MaxTimeNs = TicksToNs(VmicReadNoFence64(&counters->MaxTicks), frequency);
+    }
+
+    return count;
+}
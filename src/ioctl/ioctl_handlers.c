@@ -2,143 +2,719 @@
 #include "audio_processing.h"
 #include "common.h"
 
+// Origen de las muestras de un envío, independiente del método de transferencia
+typedef struct _AUDIO_SEND_SOURCE {
+    const VOID *Data;
+    ULONG DataLength;
+    ULONG64 Timestamp;
+} AUDIO_SEND_SOURCE, *PAUDIO_SEND_SOURCE;
+
+// Parte común de SEND_AUDIO y SEND_AUDIO_DIRECT: una única copia al anillo
+static NTSTATUS SendAudioFromSource(
+    _In_ PDEVICE_EXTENSION DeviceExtension,
+    _In_ PAUDIO_SEND_SOURCE Source,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    ULONG bytesWritten;
+    
+    // Validar que el driver esté inicializado
+    if (!DeviceExtension->IsInitialized) {
+        ERROR_PRINT("Device not initialized");
+        return STATUS_DEVICE_NOT_READY;
+    }
+    
+    // Con jitter buffer el orden lo da Timestamp y el paquete nunca espera
+    if (DeviceExtension->JitterBuffer != NULL) {
+        status = WriteTimestampedAudio(DeviceExtension,
+                                       (PVOID)Source->Data,
+                                       Source->DataLength,
+                                       Source->Timestamp,
+                                       &bytesWritten);
+    } else if (DeviceExtension->OverflowPolicy == OVERFLOW_POLICY_PEND) {
+        // Contrapresión: si no cabe, el IRP queda pendiente hasta que el lector
+        // libere espacio (Information ya contiene los bytes del paquete)
+        return QueueOrCompleteWrite(DeviceExtension, Irp, Source->Data, Source->DataLength);
+    } else {
+        // Escribir datos en el buffer de audio
+        status = WriteAudioToBuffer(DeviceExtension,
+                                   (PVOID)Source->Data,
+                                   Source->DataLength,
+                                   &bytesWritten);
+    }
+    
+    if (NT_SUCCESS(status)) {
+        Irp->IoStatus.Information = bytesWritten;
+        VERBOSE_PRINT("Successfully written %lu bytes to buffer", bytesWritten);
+    } else {
+        ERROR_PRINT("Failed to write audio to buffer: 0x%X", status);
+    }
+    
+    return status;
+}
+
 NTSTATUS HandleSendAudio(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp
 )
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    PAUDIO_BUFFER_PACKET packet;
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PVOID inputBuffer = Irp->AssociatedIrp.SystemBuffer;
+    AUDIO_SEND_SOURCE source;
+    
+    VERBOSE_PRINT("HandleSendAudio called");
+    
+    // Validar buffer de entrada
+    if (!ValidateAudioPacket(inputBuffer, inputBufferLength)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    packet = (PAUDIO_BUFFER_PACKET)inputBuffer;
+    
+    // METHOD_BUFFERED: las muestras ya fueron copiadas a SystemBuffer
+    source.Data = packet->Data;
+    source.DataLength = packet->DataLength;
+    source.Timestamp = packet->Timestamp;
+    
+    return SendAudioFromSource(deviceExtension, &source, Irp);
+}
+
+NTSTATUS HandleSendAudioDirect(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PAUDIO_DIRECT_PACKET_HEADER header;
+    AUDIO_SEND_SOURCE source;
+    
+    VERBOSE_PRINT("HandleSendAudioDirect called");
+    
+    if (Irp->AssociatedIrp.SystemBuffer == NULL ||
+        inputBufferLength < sizeof(AUDIO_DIRECT_PACKET_HEADER)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    header = (PAUDIO_DIRECT_PACKET_HEADER)Irp->AssociatedIrp.SystemBuffer;
+    
+    if (Irp->MdlAddress == NULL || header->DataLength == 0 ||
+        header->DataLength > outputBufferLength) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // METHOD_IN_DIRECT: las páginas del llamador ya están sondeadas y
+    // bloqueadas; basta con una dirección de sistema para leerlas
+    source.Data = MmGetSystemAddressForMdlSafe(Irp->MdlAddress,
+                                               NormalPagePriority | MdlMappingNoExecute);
+    if (source.Data == NULL) {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    
+    source.DataLength = header->DataLength;
+    source.Timestamp = header->Timestamp;
+    
+    return SendAudioFromSource(deviceExtension, &source, Irp);
+}
+
+NTSTATUS HandleSendAudioBatch(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PVOID inputBuffer = Irp->AssociatedIrp.SystemBuffer;
+    AUDIO_BATCH_RESULT results[MAX_AUDIO_BATCH_PACKETS];
+    ULONG packetCount;
+    
+    VERBOSE_PRINT("HandleSendAudioBatch called");
+    
+    if (inputBuffer == NULL || inputBufferLength < AUDIO_BATCH_HEADER_SIZE(1)) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Debe caber un resultado por paquete antes de escribir nada en el anillo
+    packetCount = ((PAUDIO_BATCH_HEADER)inputBuffer)->PacketCount;
+    if (packetCount > MAX_AUDIO_BATCH_PACKETS) {
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    if (outputBufferLength < packetCount * sizeof(AUDIO_BATCH_RESULT)) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+    
+    status = WriteAudioBatchToBuffer(deviceExtension, inputBuffer, inputBufferLength, results, &packetCount);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+    
+    // Entrada y salida comparten SystemBuffer: los resultados se copian al final
+    RtlCopyMemory(inputBuffer, results, packetCount * sizeof(AUDIO_BATCH_RESULT));
+    Irp->IoStatus.Information = packetCount * sizeof(AUDIO_BATCH_RESULT);
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleSetFormat(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    SET_FORMAT_REQUEST formatRequest;
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    
+    DEBUG_PRINT("HandleSetFormat called");
+    
+    // Validar buffer de entrada
+    if (!ValidateFormatRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid format request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Las peticiones cortas (solo SampleRate/Channels/BitsPerSample) dejan a
+    // cero el resto: PCM y sin conversión de entrada
+    RtlZeroMemory(&formatRequest, sizeof(formatRequest));
+    RtlCopyMemory(&formatRequest,
+                  Irp->AssociatedIrp.SystemBuffer,
+                  min(inputBufferLength, (ULONG)sizeof(formatRequest)));
+    
+    // Establecer formato de audio
+    return SetAudioFormat(deviceExtension, &formatRequest);
+}
+
+NTSTATUS HandleGetStats(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDRIVER_STATS stats;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    AUDIO_FORMAT currentFormat;
+    
+    DEBUG_PRINT("HandleGetStats called");
+    
+    // Validar buffer de salida
+    if (!ValidateStatsBuffer(Irp->AssociatedIrp.SystemBuffer, outputBufferLength)) {
+        ERROR_PRINT("Invalid stats buffer");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    stats = (PDRIVER_STATS)Irp->AssociatedIrp.SystemBuffer;
+    RtlZeroMemory(stats, sizeof(DRIVER_STATS));
+    
+    // Llenar estadísticas básicas
+    stats->IsActive = deviceExtension->IsInitialized;
+    stats->SamplesProcessed = StatCountersRead(&deviceExtension->Stats, STAT_COUNTER_SAMPLES_PROCESSED);
+    // Calculate buffer usage as percentage (0-100)
+    stats->BufferUsage = (ULONG)(((ULONG64)GetBufferUsedFrames(deviceExtension) * 100) /
+                                 GetBufferCapacityFrames(deviceExtension));
+    stats->Underruns = (ULONG)StatCountersRead(&deviceExtension->Stats, STAT_COUNTER_UNDERRUNS);
+    stats->Overruns = (ULONG)StatCountersRead(&deviceExtension->Stats, STAT_COUNTER_OVERRUNS);
+    stats->UptimeMs = GetSystemUptimeMs() - deviceExtension->StartTimeMs;
+    
+    // Obtener formato actual
+    GetCurrentAudioFormat(deviceExtension, &currentFormat);
+    RtlCopyMemory(&stats->CurrentFormat, &currentFormat, sizeof(AUDIO_FORMAT));
+    
+    Irp->IoStatus.Information = sizeof(DRIVER_STATS);
+    DEBUG_PRINT("Stats retrieved successfully");
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleMute(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PBOOLEAN muteState;
+    
+    DEBUG_PRINT("HandleMute called");
+    
+    // Validar buffer de entrada
+    if (!ValidateMuteRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid mute request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    muteState = (PBOOLEAN)Irp->AssociatedIrp.SystemBuffer;
+    
+    DEBUG_PRINT("Mute state: %s", *muteState ? "TRUE" : "FALSE");
+    
+    // Cualquier valor distinto de cero silencia
+    SetOutputMute(deviceExtension, *muteState ? TRUE : FALSE);
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleSetGain(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PSET_GAIN_REQUEST gainRequest;
+    
+    DEBUG_PRINT("HandleSetGain called");
+    
+    if (!ValidateGainRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid gain request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    gainRequest = (PSET_GAIN_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    
+    return SetOutputGain(deviceExtension, gainRequest->Gain, gainRequest->RampFrames);
+}
+
+NTSTATUS HandleSetJitterBuffer(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    SET_JITTER_BUFFER_REQUEST jitterRequest;
+    JITTER_BUFFER_STATS stats;
+    
+    DEBUG_PRINT("HandleSetJitterBuffer called");
+    
+    if (!ValidateJitterBufferRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid jitter buffer request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Entrada y salida comparten SystemBuffer
+    jitterRequest = *(PSET_JITTER_BUFFER_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    
+    status = SetJitterBuffer(deviceExtension, &jitterRequest, &stats);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+    
+    if (outputBufferLength >= sizeof(JITTER_BUFFER_STATS)) {
+        RtlCopyMemory(Irp->AssociatedIrp.SystemBuffer, &stats, sizeof(JITTER_BUFFER_STATS));
+        Irp->IoStatus.Information = sizeof(JITTER_BUFFER_STATS);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleSetDriftControl(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    SET_DRIFT_CONTROL_REQUEST driftRequest;
+    DRIFT_CONTROL_STATS stats;
+    
+    DEBUG_PRINT("HandleSetDriftControl called");
+    
+    if (!ValidateDriftControlRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid drift control request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Entrada y salida comparten SystemBuffer
+    driftRequest = *(PSET_DRIFT_CONTROL_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    
+    status = SetDriftControl(deviceExtension, &driftRequest, &stats);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+    
+    if (outputBufferLength >= sizeof(DRIFT_CONTROL_STATS)) {
+        RtlCopyMemory(Irp->AssociatedIrp.SystemBuffer, &stats, sizeof(DRIFT_CONTROL_STATS));
+        Irp->IoStatus.Information = sizeof(DRIFT_CONTROL_STATS);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleMetering(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    METERING_REQUEST meteringRequest;
+    LEVEL_METER_SNAPSHOT snapshot;
+    
+    DEBUG_PRINT("HandleMetering called");
+    
+    if (!ValidateMeteringRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid metering request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Entrada y salida comparten SystemBuffer
+    meteringRequest = *(PMETERING_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    
+    status = SetMetering(deviceExtension, &meteringRequest, &snapshot);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+    
+    if (outputBufferLength >= sizeof(LEVEL_METER_SNAPSHOT)) {
+        RtlCopyMemory(Irp->AssociatedIrp.SystemBuffer, &snapshot, sizeof(LEVEL_METER_SNAPSHOT));
+        Irp->IoStatus.Information = sizeof(LEVEL_METER_SNAPSHOT);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleGetLatency(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    
+    DEBUG_PRINT("HandleGetLatency called");
+    
+    if (Irp->AssociatedIrp.SystemBuffer == NULL || outputBufferLength < sizeof(LATENCY_STATS)) {
+        ERROR_PRINT("Invalid latency buffer");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    GetLatencyStats(deviceExtension, (PLATENCY_STATS)Irp->AssociatedIrp.SystemBuffer);
+    
+    Irp->IoStatus.Information = sizeof(LATENCY_STATS);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleDrainTrace(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PTRACE_DRAIN_HEADER header = (PTRACE_DRAIN_HEADER)Irp->AssociatedIrp.SystemBuffer;
+    
+    DEBUG_PRINT("HandleDrainTrace called");
+    
+    if (header == NULL || outputBufferLength < sizeof(TRACE_DRAIN_HEADER)) {
+        ERROR_PRINT("Invalid trace buffer");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Tantos registros como quepan tras la cabecera
+    DrainTrace(deviceExtension, header, (outputBufferLength - sizeof(TRACE_DRAIN_HEADER)) / sizeof(TRACE_RECORD));
+    
+    Irp->IoStatus.Information = sizeof(TRACE_DRAIN_HEADER) + header->Records * sizeof(TRACE_RECORD);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleGetIoctlStats(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PIOCTL_STATS_HEADER header = (PIOCTL_STATS_HEADER)Irp->AssociatedIrp.SystemBuffer;
+    ULONG entries;
+    
+    DEBUG_PRINT("HandleGetIoctlStats called");
+    
+    if (header == NULL || outputBufferLength < sizeof(IOCTL_STATS_HEADER)) {
+        ERROR_PRINT("Invalid IOCTL stats buffer");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Tantos códigos como quepan tras la cabecera
+    entries = IoctlDispatcherGetStats(&deviceExtension->Dispatcher, header, (PIOCTL_CALL_STATS)(header + 1),
+                                      (outputBufferLength - sizeof(IOCTL_STATS_HEADER)) / sizeof(IOCTL_CALL_STATS));
+    
+    Irp->IoStatus.Information = sizeof(IOCTL_STATS_HEADER) + entries * sizeof(IOCTL_CALL_STATS);
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleSetDspChain(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    NTSTATUS status;
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    SET_DSP_CHAIN_REQUEST dspRequest;
+    DSP_CHAIN_STATS stats;
+    
+    DEBUG_PRINT("HandleSetDspChain called");
+    
+    if (!ValidateDspChainRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid DSP chain request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Entrada y salida comparten SystemBuffer
+    dspRequest = *(PSET_DSP_CHAIN_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    
+    status = SetDspChain(deviceExtension, &dspRequest, &stats);
+    if (!NT_SUCCESS(status)) {
+        return status;
+    }
+    
+    if (outputBufferLength >= sizeof(DSP_CHAIN_STATS)) {
+        RtlCopyMemory(Irp->AssociatedIrp.SystemBuffer, &stats, sizeof(DSP_CHAIN_STATS));
+        Irp->IoStatus.Information = sizeof(DSP_CHAIN_STATS);
+    }
+    
+    return STATUS_SUCCESS;
+}
+
+NTSTATUS HandleSetBuffer(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
 {
     NTSTATUS status;
     PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
-    PAUDIO_BUFFER_PACKET packet;
     ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
     PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
-    PVOID inputBuffer = Irp->AssociatedIrp.SystemBuffer;
-    ULONG bytesWritten;
+    PSET_BUFFER_REQUEST bufferRequest;
+    AUDIO_FORMAT currentFormat;
+    ULONG64 frames;
+    ULONG minFrames;
     
-    DEBUG_PRINT("HandleSendAudio called");
+    DEBUG_PRINT("HandleSetBuffer called");
     
     // Validar buffer de entrada
-    if (!ValidateAudioPacket(inputBuffer, inputBufferLength)) {
+    if (!ValidateBufferRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid buffer request");
         return STATUS_INVALID_PARAMETER;
     }
     
-    packet = (PAUDIO_BUFFER_PACKET)inputBuffer;
-    
-    // Validar que el driver esté inicializado
     if (!deviceExtension->IsInitialized) {
         ERROR_PRINT("Device not initialized");
         return STATUS_DEVICE_NOT_READY;
     }
     
-    // Escribir datos en el buffer de audio
-    status = WriteAudioToBuffer(deviceExtension, 
-                               packet->Data, 
-                               packet->DataLength, 
-                               &bytesWritten);
+    bufferRequest = (PSET_BUFFER_REQUEST)Irp->AssociatedIrp.SystemBuffer;
     
-    if (NT_SUCCESS(status)) {
-        Irp->IoStatus.Information = bytesWritten;
-        DEBUG_PRINT("Successfully written %lu bytes to buffer", bytesWritten);
+    // El tamaño se deriva del formato activo
+    GetCurrentAudioFormat(deviceExtension, &currentFormat);
+    
+    if (bufferRequest->Unit == BUFFER_LATENCY_MILLISECONDS) {
+        frames = ((ULONG64)bufferRequest->Latency * currentFormat.SampleRate + 999) / 1000;
     } else {
-        ERROR_PRINT("Failed to write audio to buffer: 0x%X", status);
+        frames = bufferRequest->Latency;
     }
     
-    return status;
+    // La capacidad se redondea a potencia de dos: el máximo vale para la redondeada
+    if (frames * currentFormat.BlockAlign > MAX_BUFFER_SIZE ||
+        (ULONG64)RingBufferRoundUpCapacity((ULONG)frames) * currentFormat.BlockAlign > MAX_BUFFER_SIZE) {
+        ERROR_PRINT("Requested latency exceeds maximum buffer size");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Nunca por debajo del tamaño mínimo
+    minFrames = (MIN_BUFFER_SIZE + currentFormat.BlockAlign - 1) / currentFormat.BlockAlign;
+    
+    status = ResizeAudioBuffer(deviceExtension, max((ULONG)frames, minFrames));
+    if (!NT_SUCCESS(status)) {
+        ERROR_PRINT("Failed to resize audio buffer: 0x%X", status);
+        return status;
+    }
+    
+    // Devolver la capacidad real (redondeada a potencia de dos)
+    if (outputBufferLength >= sizeof(SET_BUFFER_REQUEST)) {
+        bufferRequest->Unit = BUFFER_LATENCY_FRAMES;
+        bufferRequest->Latency = GetBufferCapacityFrames(deviceExtension);
+        Irp->IoStatus.Information = sizeof(SET_BUFFER_REQUEST);
+    }
+    
+    return STATUS_SUCCESS;
 }
 
-NTSTATUS HandleSetFormat(
+NTSTATUS HandleSetOverflowPolicy(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp
 )
 {
     PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
-    PSET_FORMAT_REQUEST formatRequest;
     ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
     PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PSET_OVERFLOW_POLICY_REQUEST policyRequest;
     
-    DEBUG_PRINT("HandleSetFormat called");
+    DEBUG_PRINT("HandleSetOverflowPolicy called");
     
     // Validar buffer de entrada
-    if (!ValidateFormatRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
-        ERROR_PRINT("Invalid format request");
+    if (!ValidateOverflowPolicyRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid overflow policy request");
         return STATUS_INVALID_PARAMETER;
     }
     
-    formatRequest = (PSET_FORMAT_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    policyRequest = (PSET_OVERFLOW_POLICY_REQUEST)Irp->AssociatedIrp.SystemBuffer;
     
-    // Establecer formato de audio
-    return SetAudioFormat(deviceExtension,
-                         formatRequest->SampleRate,
-                         formatRequest->Channels,
-                         formatRequest->BitsPerSample);
+    // Los escritores leen la política una vez por paquete; el cambio se aplica
+    // a partir del siguiente envío
+    deviceExtension->BlockTimeoutMs = (policyRequest->TimeoutMs != 0) ?
+                                      policyRequest->TimeoutMs : DEFAULT_BLOCK_TIMEOUT_MS;
+    deviceExtension->OverflowPolicy = policyRequest->Policy;
+    
+    DEBUG_PRINT("Overflow policy set to %lu (timeout %lu ms)",
+                deviceExtension->OverflowPolicy, deviceExtension->BlockTimeoutMs);
+    
+    return STATUS_SUCCESS;
 }
 
-NTSTATUS HandleGetStats(
+NTSTATUS HandleMapRing(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp
 )
 {
+    NTSTATUS status;
     PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
     ULONG outputBufferLength = irpStack->Parameters.DeviceIoControl.OutputBufferLength;
-    PDRIVER_STATS stats;
     PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
-    AUDIO_FORMAT currentFormat;
+    MAP_RING_REQUEST mapRequest;
+    MAP_RING_RESPONSE mapResponse;
     
-    DEBUG_PRINT("HandleGetStats called");
+    DEBUG_PRINT("HandleMapRing called");
     
-    // Validar buffer de salida
-    if (!ValidateStatsBuffer(Irp->AssociatedIrp.SystemBuffer, outputBufferLength)) {
-        ERROR_PRINT("Invalid stats buffer");
+    if (Irp->AssociatedIrp.SystemBuffer == NULL ||
+        inputBufferLength < sizeof(MAP_RING_REQUEST) ||
+        outputBufferLength < sizeof(MAP_RING_RESPONSE)) {
+        ERROR_PRINT("Invalid map ring request");
         return STATUS_INVALID_PARAMETER;
     }
     
-    stats = (PDRIVER_STATS)Irp->AssociatedIrp.SystemBuffer;
-    RtlZeroMemory(stats, sizeof(DRIVER_STATS));
+    // La memoria solo puede mapearse en un proceso de usuario
+    if (Irp->RequestorMode != UserMode) {
+        return STATUS_INVALID_DEVICE_REQUEST;
+    }
     
-    // Llenar estadísticas básicas
-    stats->IsActive = deviceExtension->IsInitialized;
-    stats->SamplesProcessed = 0; // TODO: Implementar contador de muestras
-    // Calculate buffer usage as percentage (0-100)
-    stats->BufferUsage = (GetBufferUsedSpace(deviceExtension) * 100) / deviceExtension->BufferSize;
-    stats->Underruns = 0; // TODO: Implementar contador de underruns
-    stats->Overruns = 0;  // TODO: Implementar contador de overruns
-    stats->UptimeMs = 0;  // TODO: Implementar contador de tiempo activo
+    if (!deviceExtension->IsInitialized) {
+        ERROR_PRINT("Device not initialized");
+        return STATUS_DEVICE_NOT_READY;
+    }
     
-    // Obtener formato actual
-    GetCurrentAudioFormat(deviceExtension, &currentFormat);
-    RtlCopyMemory(&stats->CurrentFormat, &currentFormat, sizeof(AUDIO_FORMAT));
+    // Entrada y salida comparten SystemBuffer
+    RtlCopyMemory(&mapRequest, Irp->AssociatedIrp.SystemBuffer, sizeof(MAP_RING_REQUEST));
     
-    Irp->IoStatus.Information = sizeof(DRIVER_STATS);
-    DEBUG_PRINT("Stats retrieved successfully");
+    status = MapSharedRing(deviceExtension,
+                           irpStack->FileObject,
+                           mapRequest.Capacity,
+                           (HANDLE)(ULONG_PTR)mapRequest.NotificationEvent,
+                           &mapResponse);
+    if (!NT_SUCCESS(status)) {
+        ERROR_PRINT("Failed to map shared ring: 0x%X", status);
+        return status;
+    }
+    
+    // El lector ya no vacía el anillo interno: los envíos pendientes no avanzarían
+    FlushPendingWrites(deviceExtension, NULL);
+    
+    RtlCopyMemory(Irp->AssociatedIrp.SystemBuffer, &mapResponse, sizeof(MAP_RING_RESPONSE));
+    Irp->IoStatus.Information = sizeof(MAP_RING_RESPONSE);
     
     return STATUS_SUCCESS;
 }
 
-NTSTATUS HandleMute(
+NTSTATUS HandleUnmapRing(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    
+    DEBUG_PRINT("HandleUnmapRing called");
+    
+    return UnmapSharedRing(deviceExtension, irpStack->FileObject);
+}
+
+NTSTATUS HandleSetWatermarks(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp
 )
 {
     PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
     ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
-    PBOOLEAN muteState;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    PSET_WATERMARKS_REQUEST watermarksRequest;
     
-    DEBUG_PRINT("HandleMute called");
+    DEBUG_PRINT("HandleSetWatermarks called");
     
-    // Validar buffer de entrada
-    if (!ValidateMuteRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
-        ERROR_PRINT("Invalid mute request");
+    if (!ValidateWatermarksRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid watermarks request");
         return STATUS_INVALID_PARAMETER;
     }
     
-    muteState = (PBOOLEAN)Irp->AssociatedIrp.SystemBuffer;
+    // El handle del evento solo tiene sentido en el proceso que lo envía
+    if (Irp->RequestorMode != UserMode) {
+        return STATUS_INVALID_DEVICE_REQUEST;
+    }
     
-    DEBUG_PRINT("Mute state: %s", *muteState ? "TRUE" : "FALSE");
+    watermarksRequest = (PSET_WATERMARKS_REQUEST)Irp->AssociatedIrp.SystemBuffer;
+    
+    return RegisterWatermarks(deviceExtension,
+                              irpStack->FileObject,
+                              watermarksRequest->LowWaterFrames,
+                              watermarksRequest->HighWaterFrames,
+                              (HANDLE)(ULONG_PTR)watermarksRequest->NotificationEvent);
+}
+
+NTSTATUS HandleSetChannelMix(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    ULONG inputBufferLength = irpStack->Parameters.DeviceIoControl.InputBufferLength;
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
     
-    // TODO: Implementar lógica de mute real
-    // Por ahora, solo registramos el estado
+    DEBUG_PRINT("HandleSetChannelMix called");
     
-    return STATUS_SUCCESS;
+    if (!ValidateChannelMixRequest(Irp->AssociatedIrp.SystemBuffer, inputBufferLength)) {
+        ERROR_PRINT("Invalid channel mix request");
+        return STATUS_INVALID_PARAMETER;
+    }
+    
+    // Los coeficientes se validan al construir la mezcla
+    return SetChannelMix(deviceExtension, (PSET_CHANNEL_MIX_REQUEST)Irp->AssociatedIrp.SystemBuffer);
 }
 
 BOOLEAN ValidateAudioPacket(
@@ -173,7 +749,7 @@ BOOLEAN ValidateFormatRequest(
 {
     PSET_FORMAT_REQUEST formatRequest;
     
-    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_FORMAT_REQUEST)) {
+    if (InputBuffer == NULL || InputBufferLength < SET_FORMAT_REQUEST_BASE_SIZE) {
         return FALSE;
     }
     
@@ -218,3 +794,231 @@ BOOLEAN ValidateMuteRequest(
     
     return TRUE;
 }
+
+BOOLEAN ValidateGainRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_GAIN_REQUEST gainRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_GAIN_REQUEST)) {
+        return FALSE;
+    }
+    
+    gainRequest = (PSET_GAIN_REQUEST)InputBuffer;
+    
+    if (!GainRampIsValidGain(gainRequest->Gain) || gainRequest->RampFrames > GAIN_RAMP_MAX_FRAMES) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateJitterBufferRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_JITTER_BUFFER_REQUEST jitterRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_JITTER_BUFFER_REQUEST)) {
+        return FALSE;
+    }
+    
+    jitterRequest = (PSET_JITTER_BUFFER_REQUEST)InputBuffer;
+    
+    if (jitterRequest->Mode > JITTER_BUFFER_MODE_QUERY) {
+        return FALSE;
+    }
+    
+    // Los límites de los retardos solo importan al activarlo
+    if (jitterRequest->Mode == JITTER_BUFFER_MODE_ENABLE &&
+        (jitterRequest->MaxDelayFrames > JITTER_BUFFER_MAX_DELAY_FRAMES ||
+         jitterRequest->Percentile > 100 ||
+         jitterRequest->MinDelayFrames > ((jitterRequest->MaxDelayFrames == 0) ? DEFAULT_JITTER_MAX_DELAY_FRAMES
+                                                                              : jitterRequest->MaxDelayFrames))) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateDriftControlRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_DRIFT_CONTROL_REQUEST driftRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_DRIFT_CONTROL_REQUEST)) {
+        return FALSE;
+    }
+    
+    driftRequest = (PSET_DRIFT_CONTROL_REQUEST)InputBuffer;
+    
+    if (driftRequest->Mode > DRIFT_CONTROL_MODE_QUERY) {
+        return FALSE;
+    }
+    
+    // El objetivo se comprueba contra el anillo al aplicarlo
+    if (driftRequest->Mode == DRIFT_CONTROL_MODE_ENABLE &&
+        (driftRequest->MaxCorrectionPpm > DRIFT_CONTROL_MAX_CORRECTION_PPM ||
+         (driftRequest->ResponseFrames != 0 && driftRequest->ResponseFrames < DRIFT_CONTROL_MIN_RESPONSE_FRAMES))) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateMeteringRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PMETERING_REQUEST meteringRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(METERING_REQUEST)) {
+        return FALSE;
+    }
+    
+    meteringRequest = (PMETERING_REQUEST)InputBuffer;
+    
+    if (meteringRequest->Mode > METERING_MODE_QUERY || (meteringRequest->Flags & ~METERING_FLAG_RESET) != 0) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateDspChainRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_DSP_CHAIN_REQUEST dspRequest;
+    ULONG i;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_DSP_CHAIN_REQUEST)) {
+        return FALSE;
+    }
+    
+    dspRequest = (PSET_DSP_CHAIN_REQUEST)InputBuffer;
+    
+    if (dspRequest->Mode > DSP_CHAIN_MODE_QUERY) {
+        return FALSE;
+    }
+    
+    if (dspRequest->Mode != DSP_CHAIN_MODE_ENABLE) {
+        return TRUE;
+    }
+    
+    // Las frecuencias de los filtros se comprueban contra el formato al aplicarla
+    if (dspRequest->Stages == 0 || dspRequest->Stages > DSP_CHAIN_MAX_STAGES) {
+        return FALSE;
+    }
+    
+    for (i = 0; i < dspRequest->Stages; i++) {
+        if (!DspStageIsValidConfig(&dspRequest->Stage[i])) {
+            return FALSE;
+        }
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateBufferRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_BUFFER_REQUEST bufferRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_BUFFER_REQUEST)) {
+        return FALSE;
+    }
+    
+    bufferRequest = (PSET_BUFFER_REQUEST)InputBuffer;
+    
+    if (bufferRequest->Unit != BUFFER_LATENCY_MILLISECONDS &&
+        bufferRequest->Unit != BUFFER_LATENCY_FRAMES) {
+        return FALSE;
+    }
+    
+    if (bufferRequest->Latency == 0) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateOverflowPolicyRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_OVERFLOW_POLICY_REQUEST policyRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_OVERFLOW_POLICY_REQUEST)) {
+        return FALSE;
+    }
+    
+    policyRequest = (PSET_OVERFLOW_POLICY_REQUEST)InputBuffer;
+    
+    if (policyRequest->Policy != OVERFLOW_POLICY_REJECT &&
+        policyRequest->Policy != OVERFLOW_POLICY_DROP_OLDEST &&
+        policyRequest->Policy != OVERFLOW_POLICY_BLOCK &&
+        policyRequest->Policy != OVERFLOW_POLICY_PEND) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateWatermarksRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_WATERMARKS_REQUEST watermarksRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_WATERMARKS_REQUEST)) {
+        return FALSE;
+    }
+    
+    watermarksRequest = (PSET_WATERMARKS_REQUEST)InputBuffer;
+    
+    // Los umbrales frente a la capacidad se comprueban al registrar
+    if (watermarksRequest->HighWaterFrames != 0 &&
+        watermarksRequest->LowWaterFrames >= watermarksRequest->HighWaterFrames) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
+
+BOOLEAN ValidateChannelMixRequest(
+    _In_ PVOID InputBuffer,
+    _In_ ULONG InputBufferLength
+)
+{
+    PSET_CHANNEL_MIX_REQUEST mixRequest;
+    
+    if (InputBuffer == NULL || InputBufferLength < sizeof(SET_CHANNEL_MIX_REQUEST)) {
+        return FALSE;
+    }
+    
+    mixRequest = (PSET_CHANNEL_MIX_REQUEST)InputBuffer;
+    
+    if (mixRequest->Preset >= CHANNEL_MIX_PRESET_COUNT) {
+        return FALSE;
+    }
+    
+    // El par frente al formato activo se comprueba al aplicarla
+    if (!IS_VALID_CHANNELS(mixRequest->InputChannels) ||
+        !IS_VALID_CHANNELS(mixRequest->OutputChannels)) {
+        return FALSE;
+    }
+    
+    return TRUE;
+}
@@ -18,6 +18,11 @@ NTSTATUS DispatchClose(
     _In_ PIRP Irp
 );
 
+NTSTATUS DispatchCleanup(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+);
+
 NTSTATUS DispatchDeviceControl(
     _In_ PDEVICE_OBJECT DeviceObject,
     _In_ PIRP Irp
@@ -28,6 +33,31 @@ NTSTATUS DispatchRead(
     _In_ PIRP Irp
 );
 
+// Handlers por código; DispatchDeviceControl los busca por la función del
+// CTL_CODE (ioctl_dispatch.h)
+static const IOCTL_DISPATCH_ENTRY g_IoctlDispatchTable[] = {
+    { IOCTL_VIRTUALMIC_SEND_AUDIO,          HandleSendAudio },
+    { IOCTL_VIRTUALMIC_SEND_AUDIO_DIRECT,   HandleSendAudioDirect },
+    { IOCTL_VIRTUALMIC_SEND_AUDIO_BATCH,    HandleSendAudioBatch },
+    { IOCTL_VIRTUALMIC_SET_FORMAT,          HandleSetFormat },
+    { IOCTL_VIRTUALMIC_GET_STATS,           HandleGetStats },
+    { IOCTL_VIRTUALMIC_MUTE,                HandleMute },
+    { IOCTL_VIRTUALMIC_SET_BUFFER,          HandleSetBuffer },
+    { IOCTL_VIRTUALMIC_SET_OVERFLOW_POLICY, HandleSetOverflowPolicy },
+    { IOCTL_VIRTUALMIC_MAP_RING,            HandleMapRing },
+    { IOCTL_VIRTUALMIC_UNMAP_RING,          HandleUnmapRing },
+    { IOCTL_VIRTUALMIC_SET_WATERMARKS,      HandleSetWatermarks },
+    { IOCTL_VIRTUALMIC_SET_CHANNEL_MIX,     HandleSetChannelMix },
+    { IOCTL_VIRTUALMIC_SET_GAIN,            HandleSetGain },
+    { IOCTL_VIRTUALMIC_SET_JITTER_BUFFER,   HandleSetJitterBuffer },
+    { IOCTL_VIRTUALMIC_SET_DRIFT_CONTROL,   HandleSetDriftControl },
+    { IOCTL_VIRTUALMIC_METERING,            HandleMetering },
+    { IOCTL_VIRTUALMIC_SET_DSP_CHAIN,       HandleSetDspChain },
+    { IOCTL_VIRTUALMIC_GET_LATENCY,         HandleGetLatency },
+    { IOCTL_VIRTUALMIC_DRAIN_TRACE,         HandleDrainTrace },
+    { IOCTL_VIRTUALMIC_GET_IOCTL_STATS,     HandleGetIoctlStats }
+};
+
 // Entry point del driver
 NTSTATUS 
 DriverEntry(
@@ -37,6 +67,7 @@ DriverEntry(
 {
     NTSTATUS status;
     PDEVICE_OBJECT deviceObject = NULL;
+    PDEVICE_EXTENSION deviceExtension;
     
     DEBUG_PRINT("VirtualMicrophone Driver Entry - Modular Version");
     
@@ -49,10 +80,21 @@ DriverEntry(
     
     // Obtener el objeto de dispositivo creado
     deviceObject = DriverObject->DeviceObject;
+    deviceExtension = (PDEVICE_EXTENSION)deviceObject->DeviceExtension;
+    
+    // Antes de publicar DispatchDeviceControl
+    status = IoctlDispatcherInitialize(&deviceExtension->Dispatcher, g_IoctlDispatchTable,
+                                       RTL_NUMBER_OF(g_IoctlDispatchTable));
+    if (!NT_SUCCESS(status)) {
+        ERROR_PRINT("Invalid IOCTL dispatch table: 0x%X", status);
+        CleanupDevice(deviceObject);
+        return status;
+    }
     
     // Configurar funciones del driver
     DriverObject->MajorFunction[IRP_MJ_CREATE] = DispatchCreate;
     DriverObject->MajorFunction[IRP_MJ_CLOSE] = DispatchClose;
+    DriverObject->MajorFunction[IRP_MJ_CLEANUP] = DispatchCleanup;
     DriverObject->MajorFunction[IRP_MJ_DEVICE_CONTROL] = DispatchDeviceControl;
     DriverObject->MajorFunction[IRP_MJ_READ] = DispatchRead;
     DriverObject->DriverUnload = DriverUnload;
@@ -81,6 +123,8 @@ DispatchCreate(
     _In_ PIRP Irp
 )
 {
+    UNREFERENCED_PARAMETER(DeviceObject);
+    
     DEBUG_PRINT("Device opened");
     
     Irp->IoStatus.Status = STATUS_SUCCESS;
@@ -96,6 +140,8 @@ DispatchClose(
     _In_ PIRP Irp
 )
 {
+    UNREFERENCED_PARAMETER(DeviceObject);
+    
     DEBUG_PRINT("Device closed");
     
     Irp->IoStatus.Status = STATUS_SUCCESS;
@@ -105,6 +151,35 @@ DispatchClose(
     return STATUS_SUCCESS;
 }
 
+NTSTATUS
+DispatchCleanup(
+    _In_ PDEVICE_OBJECT DeviceObject,
+    _In_ PIRP Irp
+)
+{
+    PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
+    
+    DEBUG_PRINT("Device cleanup");
+    
+    // Deshacer el mapeo del anillo compartido si este handle lo creó
+    // (llega en el contexto del proceso, antes de que desaparezca su espacio)
+    if (deviceExtension->SharedRingOwner == irpStack->FileObject) {
+        UnmapSharedRing(deviceExtension, irpStack->FileObject);
+    }
+    
+    // Las peticiones pendientes de este handle no sobreviven al cierre
+    FlushPendingReads(deviceExtension, irpStack->FileObject);
+    FlushPendingWrites(deviceExtension, irpStack->FileObject);
+    UnregisterWatermarks(deviceExtension, irpStack->FileObject);
+    
+    Irp->IoStatus.Status = STATUS_SUCCESS;
+    Irp->IoStatus.Information = 0;
+    
+    IoCompleteRequest(Irp, IO_NO_INCREMENT);
+    return STATUS_SUCCESS;
+}
+
 NTSTATUS
 DispatchDeviceControl(
     _In_ PDEVICE_OBJECT DeviceObject,
@@ -113,31 +188,31 @@ DispatchDeviceControl(
 {
     NTSTATUS status = STATUS_SUCCESS;
     PIO_STACK_LOCATION irpStack = IoGetCurrentIrpStackLocation(Irp);
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
     ULONG ioControlCode = irpStack->Parameters.DeviceIoControl.IoControlCode;
+    const IOCTL_DISPATCH_ENTRY *entry;
+    
+    // Por paquete: traza binaria en lugar de DbgPrint
+    TRACE_LOG(deviceExtension, TRACE_EVENT_IOCTL, ioControlCode,
+              irpStack->Parameters.DeviceIoControl.InputBufferLength,
+              irpStack->Parameters.DeviceIoControl.OutputBufferLength);
+    VERBOSE_PRINT("IOCTL 0x%X received", ioControlCode);
+    
+    // Sin una cadena de case: la tabla da el handler y contabiliza la llamada
+    entry = IoctlDispatcherLookup(&deviceExtension->Dispatcher, ioControlCode);
+    if (entry != NULL) {
+        status = IoctlDispatcherCall(&deviceExtension->Dispatcher, entry, DeviceObject, Irp,
+                                     irpStack->Parameters.DeviceIoControl.InputBufferLength,
+                                     &Irp->IoStatus.Information);
+    } else {
+        ERROR_PRINT("Unknown IOCTL: 0x%X", ioControlCode);
+        status = STATUS_INVALID_DEVICE_REQUEST;
+    }
     
-    DEBUG_PRINT("IOCTL 0x%X received", ioControlCode);
-    
-    switch (ioControlCode) {
-        case IOCTL_VIRTUALMIC_SEND_AUDIO:
-            status = HandleSendAudio(DeviceObject, Irp);
-            break;
-            
-        case IOCTL_VIRTUALMIC_SET_FORMAT:
-            status = HandleSetFormat(DeviceObject, Irp);
-            break;
-            
-        case IOCTL_VIRTUALMIC_GET_STATS:
-            status = HandleGetStats(DeviceObject, Irp);
-            break;
-            
-        case IOCTL_VIRTUALMIC_MUTE:
-            status = HandleMute(DeviceObject, Irp);
-            break;
-            
-        default:
-            ERROR_PRINT("Unknown IOCTL: 0x%X", ioControlCode);
-            status = STATUS_INVALID_DEVICE_REQUEST;
-            break;
+    // Un envío pendiente lo completa el lector (OVERFLOW_POLICY_PEND)
+    if (status == STATUS_PENDING) {
+        TRACE_LOG(deviceExtension, TRACE_EVENT_IOCTL_COMPLETE, ioControlCode, status, 0);
+        return status;
     }
     
     Irp->IoStatus.Status = status;
@@ -145,6 +220,7 @@ DispatchDeviceControl(
         Irp->IoStatus.Information = 0;
     }
     
+    TRACE_LOG(deviceExtension, TRACE_EVENT_IOCTL_COMPLETE, ioControlCode, status, Irp->IoStatus.Information);
     IoCompleteRequest(Irp, IO_NO_INCREMENT);
     return status;
 }
@@ -155,14 +231,10 @@ DispatchRead(
     _In_ PIRP Irp
 )
 {
-    DEBUG_PRINT("Read request received");
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)DeviceObject->DeviceExtension;
     
-    // TODO: Implementar lectura de audio desde el buffer
-    // Esto sería usado por WaveRT para obtener datos de audio
+    VERBOSE_PRINT("Read request received");
     
-    Irp->IoStatus.Status = STATUS_SUCCESS;
-    Irp->IoStatus.Information = 0;
-    
-    IoCompleteRequest(Irp, IO_NO_INCREMENT);
-    return STATUS_SUCCESS;
+    // Sin datos suficientes la lectura queda pendiente hasta que llegue audio
+    return QueueOrCompleteRead(deviceExtension, Irp);
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_batch.h"
+
+// Funciones de prueba
+BOOLEAN TestBatchValidation(void);
+BOOLEAN TestBatchWriteReject(void);
+BOOLEAN TestBatchWriteDropOldest(void);
+
+// Construye un lote de paquetes de 'frames' frames de 2 bytes consecutivos
+static ULONG BuildBatch(PUCHAR buffer, const ULONG *frames, ULONG count) {
+    PAUDIO_BATCH_HEADER header = (PAUDIO_BATCH_HEADER)buffer;
+    ULONG offset = (ULONG)AUDIO_BATCH_HEADER_SIZE(count);
+    USHORT value = 0;
+    ULONG i;
+    ULONG j;
+
+    header->PacketCount = count;
+    header->Reserved = 0;
+
+    for (i = 0; i < count; i++) {
+        header->Packets[i].Timestamp = i * 1000;
+        header->Packets[i].DataOffset = offset;
+        header->Packets[i].DataLength = frames[i] * sizeof(USHORT);
+
+        for (j = 0; j < frames[i]; j++) {
+            memcpy(buffer + offset + j * sizeof(USHORT), &value, sizeof(USHORT));
+            value++;
+        }
+
+        offset += frames[i] * sizeof(USHORT);
+    }
+
+    return offset;
+}
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 3;
+
+    printf("=== Iniciando pruebas de SEND_AUDIO_BATCH ===\n\n");
+
+    printf("1. Prueba de validación de descriptores...\n");
+    if (TestBatchValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de escritura con rechazo por paquete...\n");
+    if (TestBatchWriteReject()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de escritura descartando lo más antiguo...\n");
+    if (TestBatchWriteDropOldest()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestBatchValidation(void) {
+    static const ULONG frames[] = { 4, 8, 3 };
+    UCHAR buffer[512];
+    PAUDIO_BATCH_HEADER header = (PAUDIO_BATCH_HEADER)buffer;
+    ULONG length = BuildBatch(buffer, frames, 3);
+    ULONG totalFrames;
+
+    if (AudioBatchValidate(buffer, length, sizeof(USHORT), &totalFrames) != STATUS_SUCCESS || totalFrames != 15) {
+        return FALSE;
+    }
+
+    // Datos fuera del buffer recibido
+    if (AudioBatchValidate(buffer, length - 1, sizeof(USHORT), &totalFrames) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    // Frames partidos (el último paquete tiene 6 bytes)
+    if (AudioBatchValidate(buffer, length, 4, &totalFrames) != STATUS_INVALID_BUFFER_SIZE) {
+        return FALSE;
+    }
+
+    // Offset que daría la vuelta en 32 bits
+    header->Packets[1].DataOffset = 0xFFFFFFF0UL;
+    if (AudioBatchValidate(buffer, length, sizeof(USHORT), &totalFrames) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    // Datos solapados con los descriptores
+    header->Packets[1].DataOffset = 8;
+    if (AudioBatchValidate(buffer, length, sizeof(USHORT), &totalFrames) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    // Número de paquetes fuera de rango
+    header->PacketCount = 0;
+    if (AudioBatchValidate(buffer, length, sizeof(USHORT), &totalFrames) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    header->PacketCount = MAX_AUDIO_BATCH_PACKETS + 1;
+    return AudioBatchValidate(buffer, sizeof(buffer), sizeof(USHORT), &totalFrames) == STATUS_INVALID_PARAMETER;
+}
+
+BOOLEAN TestBatchWriteReject(void) {
+    static const ULONG frames[] = { 6, 12, 4 };
+    UCHAR buffer[512];
+    USHORT storage[16];
+    USHORT readData[16];
+    AUDIO_BATCH_RESULT results[3];
+    RING_BUFFER ring;
+    ULONG i;
+
+    BuildBatch(buffer, frames, 3);
+    RingBufferInitialize(&ring, storage, 16, sizeof(USHORT));
+
+    // El segundo paquete no cabe entero: se rechaza y el tercero sí entra
+    if (AudioBatchWrite(&ring, buffer, NULL, FALSE, results) != 1) {
+        return FALSE;
+    }
+
+    if (results[0].Status != STATUS_SUCCESS || results[0].BytesWritten != 12 ||
+        results[1].Status != STATUS_BUFFER_TOO_SMALL || results[1].BytesWritten != 0 ||
+        results[2].Status != STATUS_SUCCESS || results[2].BytesWritten != 8) {
+        return FALSE;
+    }
+
+    if (RingBufferRead(&ring, readData, 16) != 10) {
+        return FALSE;
+    }
+
+    // Paquete 0 (muestras 0..5) seguido del paquete 2 (muestras 18..21)
+    for (i = 0; i < 6; i++) {
+        if (readData[i] != i) {
+            return FALSE;
+        }
+    }
+
+    for (i = 0; i < 4; i++) {
+        if (readData[6 + i] != 18 + i) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestBatchWriteDropOldest(void) {
+    static const ULONG frames[] = { 6, 12, 4 };
+    UCHAR buffer[512];
+    USHORT storage[16];
+    USHORT readData[16];
+    AUDIO_BATCH_RESULT results[3];
+    RING_BUFFER ring;
+    ULONG i;
+
+    BuildBatch(buffer, frames, 3);
+    RingBufferInitialize(&ring, storage, 16, sizeof(USHORT));
+
+    // 22 frames en un anillo de 16: los dos últimos paquetes descartan audio
+    if (AudioBatchWrite(&ring, buffer, NULL, TRUE, results) != 2) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 3; i++) {
+        if (results[i].Status != STATUS_SUCCESS || results[i].BytesWritten != frames[i] * sizeof(USHORT)) {
+            return FALSE;
+        }
+    }
+
+    // Quedan las 16 muestras más recientes: 6..21
+    if (RingBufferRead(&ring, readData, 16) != 16) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 16; i++) {
+        if (readData[i] != 6 + i) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,383 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "channel_mix.h"
+#include "ring_buffer.h"
+
+#define TEST_FRAMES      1024
+#define TEST_RING_FRAMES 64
+
+static const char *g_PresetNames[CHANNEL_MIX_PRESET_COUNT] = {
+    "auto", "mono->estéreo", "estéreo->mono", "5.1->estéreo", "7.1->estéreo", "directa", "propia"
+};
+
+static CHANNEL_MIX g_Mix;
+static CHANNEL_MIX g_MixB;
+static float g_Input[TEST_FRAMES * CHANNEL_MIX_MAX_CHANNELS + 1];
+static float g_Output[TEST_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+static float g_OutputB[TEST_FRAMES * CHANNEL_MIX_MAX_CHANNELS];
+
+// Funciones de prueba
+BOOLEAN TestPresetsAndValidation(void);
+BOOLEAN TestPresetGains(void);
+BOOLEAN TestVectorMatchesScalar(void);
+BOOLEAN TestRingWrite(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de la mezcla de canales ===\n\n");
+
+    printf("1. Prueba de resolución de presets y validación de la configuración...\n");
+    if (TestPresetsAndValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de ganancias de cada preset (impulso por canal)...\n");
+    if (TestPresetGains()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de núcleos SSE2 idénticos al escalar...\n");
+    if (TestVectorMatchesScalar()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de escritura en el anillo (formato, espacio, descarte y remuestreo)...\n");
+    if (TestRingWrite()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+static NTSTATUS InitializeMix(PCHANNEL_MIX mix, ULONG inputs, ULONG outputs, CHANNEL_MIX_PRESET preset,
+                              SAMPLE_FORMAT source, SAMPLE_FORMAT target, SAMPLE_CONVERT_ISA isa,
+                              const float *matrix) {
+    CHANNEL_MIX_CONFIG config;
+
+    memset(&config, 0, sizeof(config));
+    config.InputChannels = inputs;
+    config.OutputChannels = outputs;
+    config.SourceFormat = source;
+    config.TargetFormat = target;
+    config.Preset = preset;
+    config.Isa = isa;
+    if (matrix != NULL) {
+        memcpy(config.Matrix, matrix, sizeof(config.Matrix));
+    }
+
+    return ChannelMixInitialize(mix, &config);
+}
+
+BOOLEAN TestPresetsAndValidation(void) {
+    static const ULONG autoShapes[][3] = {
+        { 1, 2, CHANNEL_MIX_PRESET_MONO_TO_STEREO },
+        { 2, 1, CHANNEL_MIX_PRESET_STEREO_TO_MONO },
+        { 6, 2, CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO },
+        { 8, 2, CHANNEL_MIX_PRESET_SURROUND71_TO_STEREO },
+        { 3, 2, CHANNEL_MIX_PRESET_DIRECT },
+        { 2, 6, CHANNEL_MIX_PRESET_DIRECT },
+    };
+    float matrix[CHANNEL_MIX_MAX_CHANNELS][CHANNEL_MIX_MAX_CHANNELS];
+    ULONG i;
+
+    for (i = 0; i < sizeof(autoShapes) / sizeof(autoShapes[0]); i++) {
+        if (!NT_SUCCESS(InitializeMix(&g_Mix, autoShapes[i][0], autoShapes[i][1], CHANNEL_MIX_PRESET_AUTO,
+                                      SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                                      SAMPLE_CONVERT_ISA_SCALAR, NULL)) ||
+            g_Mix.Preset != (CHANNEL_MIX_PRESET)autoShapes[i][2]) {
+            printf("   %u -> %u canales no resolvió a %s\n",
+                   autoShapes[i][0], autoShapes[i][1], g_PresetNames[autoShapes[i][2]]);
+            return FALSE;
+        }
+    }
+
+    // Canales fuera de rango y presets con otra forma
+    if (InitializeMix(&g_Mix, 0, 2, CHANNEL_MIX_PRESET_AUTO, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_CONVERT_ISA_SCALAR, NULL) != STATUS_INVALID_PARAMETER ||
+        InitializeMix(&g_Mix, 9, 2, CHANNEL_MIX_PRESET_AUTO, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_CONVERT_ISA_SCALAR, NULL) != STATUS_INVALID_PARAMETER ||
+        InitializeMix(&g_Mix, 2, 2, CHANNEL_MIX_PRESET_MONO_TO_STEREO, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_FORMAT_FLOAT32, SAMPLE_CONVERT_ISA_SCALAR, NULL) != STATUS_INVALID_PARAMETER ||
+        InitializeMix(&g_Mix, 6, 1, CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_FORMAT_FLOAT32, SAMPLE_CONVERT_ISA_SCALAR, NULL) != STATUS_INVALID_PARAMETER ||
+        InitializeMix(&g_Mix, 2, 2, CHANNEL_MIX_PRESET_COUNT, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_FORMAT_FLOAT32, SAMPLE_CONVERT_ISA_SCALAR, NULL) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    // Matriz propia: NaN, infinito y ganancias excesivas se rechazan; fuera de
+    // la forma usada los valores no importan
+    memset(matrix, 0, sizeof(matrix));
+    matrix[0][1] = 1.0f;
+    matrix[1][0] = -1.0f;
+    matrix[7][7] = NAN;
+    if (!NT_SUCCESS(InitializeMix(&g_Mix, 2, 2, CHANNEL_MIX_PRESET_CUSTOM, SAMPLE_FORMAT_FLOAT32,
+                                  SAMPLE_FORMAT_FLOAT32, SAMPLE_CONVERT_ISA_SCALAR, &matrix[0][0])) ||
+        g_Mix.Matrix[0][1] != 1.0f || g_Mix.Matrix[1][0] != -1.0f || g_Mix.Matrix[7][7] != 0.0f) {
+        return FALSE;
+    }
+
+    matrix[1][1] = NAN;
+    if (InitializeMix(&g_Mix, 2, 2, CHANNEL_MIX_PRESET_CUSTOM, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_CONVERT_ISA_SCALAR, &matrix[0][0]) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    matrix[1][1] = INFINITY;
+    if (InitializeMix(&g_Mix, 2, 2, CHANNEL_MIX_PRESET_CUSTOM, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                      SAMPLE_CONVERT_ISA_SCALAR, &matrix[0][0]) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    matrix[1][1] = CHANNEL_MIX_MAX_GAIN * 2.0f;
+    return InitializeMix(&g_Mix, 2, 2, CHANNEL_MIX_PRESET_CUSTOM, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                         SAMPLE_CONVERT_ISA_SCALAR, &matrix[0][0]) == STATUS_INVALID_PARAMETER;
+}
+
+BOOLEAN TestPresetGains(void) {
+    // Ganancia esperada [preset][salida][entrada] (en el orden FL FR FC LFE BL BR SL SR)
+    static const double g = 0.70710678118654752;
+    double expected[CHANNEL_MIX_MAX_CHANNELS][CHANNEL_MIX_MAX_CHANNELS];
+    double front;
+    ULONG shapes[][2] = { { 1, 2 }, { 2, 1 }, { 6, 2 }, { 8, 2 }, { 4, 2 } };
+    ULONG preset;
+    ULONG input;
+    ULONG output;
+    ULONG inputs;
+    ULONG outputs;
+    double sum;
+
+    for (preset = CHANNEL_MIX_PRESET_MONO_TO_STEREO; preset <= CHANNEL_MIX_PRESET_DIRECT; preset++) {
+        inputs = shapes[preset - 1][0];
+        outputs = shapes[preset - 1][1];
+        memset(expected, 0, sizeof(expected));
+
+        switch (preset) {
+            case CHANNEL_MIX_PRESET_MONO_TO_STEREO:
+                expected[0][0] = expected[1][0] = 1.0;
+                break;
+            case CHANNEL_MIX_PRESET_STEREO_TO_MONO:
+                expected[0][0] = expected[0][1] = 0.5;
+                break;
+            case CHANNEL_MIX_PRESET_SURROUND51_TO_STEREO:
+                front = 1.0 / (1.0 + 2.0 * g);
+                expected[0][0] = expected[1][1] = front;
+                expected[0][2] = expected[1][2] = expected[0][4] = expected[1][5] = g * front;
+                break;
+            case CHANNEL_MIX_PRESET_SURROUND71_TO_STEREO:
+                front = 1.0 / (1.0 + 3.0 * g);
+                expected[0][0] = expected[1][1] = front;
+                expected[0][2] = expected[1][2] = g * front;
+                expected[0][4] = expected[1][5] = expected[0][6] = expected[1][7] = g * front;
+                break;
+            default:
+                expected[0][0] = expected[1][1] = 1.0;
+                break;
+        }
+
+        if (!NT_SUCCESS(InitializeMix(&g_Mix, inputs, outputs, (CHANNEL_MIX_PRESET)preset,
+                                      SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                                      SampleConvertGetBestIsa(), NULL))) {
+            return FALSE;
+        }
+
+        // Un impulso en cada canal de entrada mide una columna de la matriz
+        for (input = 0; input < inputs; input++) {
+            memset(g_Input, 0, sizeof(g_Input));
+            g_Input[input] = 1.0f;
+            ChannelMixFrames(&g_Mix, g_Output, g_Input, 1);
+
+            for (output = 0; output < outputs; output++) {
+                if (fabs(g_Output[output] - expected[output][input]) > 1e-7) {
+                    printf("   %s: entrada %u -> salida %u = %.8f (esperado %.8f)\n", g_PresetNames[preset],
+                           input, output, g_Output[output], expected[output][input]);
+                    return FALSE;
+                }
+            }
+        }
+
+        // Las mezclas hacia menos canales no saturan: cada salida suma 1
+        if (outputs < inputs) {
+            for (output = 0; output < outputs; output++) {
+                sum = 0.0;
+                for (input = 0; input < inputs; input++) {
+                    sum += expected[output][input];
+                }
+                if (fabs(sum - 1.0) > 1e-9) {
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestVectorMatchesScalar(void) {
+    static const ULONG shapes[][2] = { { 1, 2 }, { 2, 1 }, { 6, 2 }, { 8, 2 }, { 3, 5 }, { 2, 2 } };
+    float matrix[CHANNEL_MIX_MAX_CHANNELS][CHANNEL_MIX_MAX_CHANNELS];
+    ULONG shape;
+    ULONG frames;
+    ULONG offset;
+    ULONG i;
+    ULONG j;
+
+    if (!SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)) {
+        printf("   (sin SSE2: solo la referencia escalar)\n");
+        return TRUE;
+    }
+
+    srand(11);
+    for (i = 0; i < sizeof(g_Input) / sizeof(g_Input[0]); i++) {
+        g_Input[i] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+    }
+
+    // Matrices propias: los núcleos dependen solo de la forma
+    for (i = 0; i < CHANNEL_MIX_MAX_CHANNELS; i++) {
+        for (j = 0; j < CHANNEL_MIX_MAX_CHANNELS; j++) {
+            matrix[i][j] = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+        }
+    }
+
+    for (shape = 0; shape < sizeof(shapes) / sizeof(shapes[0]); shape++) {
+        if (!NT_SUCCESS(InitializeMix(&g_Mix, shapes[shape][0], shapes[shape][1], CHANNEL_MIX_PRESET_CUSTOM,
+                                      SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                                      SAMPLE_CONVERT_ISA_SCALAR, &matrix[0][0])) ||
+            !NT_SUCCESS(InitializeMix(&g_MixB, shapes[shape][0], shapes[shape][1], CHANNEL_MIX_PRESET_CUSTOM,
+                                      SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                                      SAMPLE_CONVERT_ISA_SSE2, &matrix[0][0]))) {
+            return FALSE;
+        }
+
+        // Longitudes con y sin cola, y entrada desalineada
+        for (frames = 0; frames <= 37; frames++) {
+            for (offset = 0; offset < 2; offset++) {
+                memset(g_Output, 0xA5, sizeof(g_Output));
+                memset(g_OutputB, 0xA5, sizeof(g_OutputB));
+                ChannelMixFrames(&g_Mix, g_Output, g_Input + offset, frames);
+                ChannelMixFrames(&g_MixB, g_OutputB, g_Input + offset, frames);
+
+                if (memcmp(g_Output, g_OutputB, sizeof(g_Output)) != 0) {
+                    printf("   %u -> %u canales, %u frames: SSE2 difiere\n",
+                           shapes[shape][0], shapes[shape][1], frames);
+                    return FALSE;
+                }
+            }
+        }
+
+        ChannelMixFrames(&g_Mix, g_Output, g_Input, TEST_FRAMES);
+        ChannelMixFrames(&g_MixB, g_OutputB, g_Input, TEST_FRAMES);
+        if (memcmp(g_Output, g_OutputB, (SIZE_T)TEST_FRAMES * shapes[shape][1] * sizeof(float)) != 0) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestRingWrite(void) {
+    static SHORT packet[1000];
+    static SHORT storage[TEST_RING_FRAMES * 2];
+    static SHORT drained[TEST_RING_FRAMES * 2];
+    static UCHAR resamplerMemory[512 * 1024];
+    RESAMPLER_CONFIG config;
+    PRESAMPLER resampler;
+    RING_BUFFER ring;
+    ULONG64 totalOutput = 0;
+    ULONG consumed = 0;
+    ULONG dropped;
+    ULONG read;
+    ULONG i;
+
+    for (i = 0; i < 1000; i++) {
+        packet[i] = (SHORT)((i * 2654435761UL) >> 17);
+    }
+
+    // int16 mono -> int16 estéreo: ambos canales repiten la muestra exacta
+    if (!NT_SUCCESS(InitializeMix(&g_Mix, 1, 2, CHANNEL_MIX_PRESET_AUTO, SAMPLE_FORMAT_INT16,
+                                  SAMPLE_FORMAT_INT16, SampleConvertGetBestIsa(), NULL)) ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, storage, TEST_RING_FRAMES, 2 * sizeof(SHORT)))) {
+        return FALSE;
+    }
+
+    // Con el anillo más pequeño que el paquete se consume lo que cabe
+    while (consumed < 1000) {
+        consumed += ChannelMixWriteRing(&g_Mix, NULL, &ring, packet + consumed, 1000 - consumed);
+        read = RingBufferRead(&ring, drained, TEST_RING_FRAMES);
+        for (i = 0; i < read; i++) {
+            if (drained[2 * i] != packet[totalOutput + i] || drained[2 * i + 1] != packet[totalOutput + i]) {
+                return FALSE;
+            }
+        }
+        totalOutput += read;
+    }
+
+    if (totalOutput != 1000) {
+        return FALSE;
+    }
+
+    // Descartando lo más antiguo quedan los últimos frames del paquete
+    consumed = ChannelMixWriteRingDropOldest(&g_Mix, NULL, &ring, packet, 1000, &dropped);
+    read = RingBufferRead(&ring, drained, TEST_RING_FRAMES);
+    if (consumed != 1000 || dropped != 1000 - TEST_RING_FRAMES || read != TEST_RING_FRAMES ||
+        drained[0] != packet[1000 - TEST_RING_FRAMES] || drained[2 * read - 1] != packet[999]) {
+        return FALSE;
+    }
+
+    // Mezcla y después remuestreo (44.1 kHz mono -> 48 kHz estéreo)
+    if (!NT_SUCCESS(InitializeMix(&g_Mix, 1, 2, CHANNEL_MIX_PRESET_AUTO, SAMPLE_FORMAT_INT16,
+                                  SAMPLE_FORMAT_FLOAT32, SampleConvertGetBestIsa(), NULL))) {
+        return FALSE;
+    }
+
+    config.InputRate = 44100;
+    config.OutputRate = 48000;
+    config.Channels = 2;
+    config.SourceFormat = SAMPLE_FORMAT_FLOAT32;
+    config.TargetFormat = SAMPLE_FORMAT_INT16;
+    config.Quality = RESAMPLER_QUALITY_LOW;
+    config.Isa = SampleConvertGetBestIsa();
+    if (!NT_SUCCESS(ResamplerInitialize(resamplerMemory, sizeof(resamplerMemory), &config, &resampler))) {
+        return FALSE;
+    }
+
+    consumed = 0;
+    totalOutput = 0;
+    while (consumed < 1000) {
+        consumed += ChannelMixWriteRing(&g_Mix, resampler, &ring, packet + consumed, 1000 - consumed);
+        if (resampler->Position < resampler->HistoryFrames) {
+            return FALSE;
+        }
+
+        read = RingBufferRead(&ring, drained, TEST_RING_FRAMES);
+        for (i = 0; i < read; i++) {
+            if (drained[2 * i] != drained[2 * i + 1]) {
+                return FALSE;
+            }
+        }
+        totalOutput += read;
+    }
+
+    return totalOutput == (1000ULL * 160 + 146) / 147;
+}
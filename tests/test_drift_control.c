@@ -0,0 +1,381 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "drift_control.h"
+
+// Anillo mono en float32 a 48 kHz; el lector pide bloques de 10 ms
+#define TEST_RATE          48000
+#define TEST_RING_FRAMES   8192
+#define TEST_READ_FRAMES   480
+#define TEST_PI            3.14159265358979323846
+
+static UCHAR g_Memory[1 << 18];
+static float g_Storage[TEST_RING_FRAMES];
+static float g_Input[TEST_RING_FRAMES];
+static float g_Output[TEST_RING_FRAMES];
+
+// Funciones de prueba
+BOOLEAN TestConfigValidation(void);
+BOOLEAN TestInterpolationQuality(void);
+BOOLEAN TestUnderrunAndTargetClamp(void);
+BOOLEAN TestDriftLock(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de la compensación de deriva ===\n\n");
+
+    printf("1. Prueba de validación de la configuración...\n");
+    if (TestConfigValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de calidad del interpolador con la corrección saturada...\n");
+    if (TestInterpolationQuality()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de lazo congelado en subdesbordamiento y objetivo acotado...\n");
+    if (TestUnderrunAndTargetClamp()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de enganche a un productor con +300 ppm de deriva...\n");
+    if (TestDriftLock()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+
+    if (passedTests == totalTests) {
+        printf("🎉 Todas las pruebas pasaron!\n");
+        return 0;
+    } else {
+        printf("⚠️  Algunas pruebas fallaron\n");
+        return 1;
+    }
+}
+
+static PDRIFT_CONTROL CreateDriftControl(ULONG targetFill, ULONG maxPpm, ULONG responseFrames) {
+    DRIFT_CONTROL_CONFIG config;
+    PDRIFT_CONTROL driftControl;
+
+    config.Channels = 1;
+    config.Format = SAMPLE_FORMAT_FLOAT32;
+    config.TargetFill = targetFill;
+    config.MaxCorrectionPpm = maxPpm;
+    config.ResponseFrames = responseFrames;
+    config.Isa = SampleConvertGetBestIsa();
+
+    if (!NT_SUCCESS(DriftControlInitialize(g_Memory, sizeof(g_Memory), &config, &driftControl))) {
+        return NULL;
+    }
+
+    return driftControl;
+}
+
+// Residuo (dB sobre la amplitud) tras ajustar a sin y cos de frecuencia Omega
+// (rad/frame) por mínimos cuadrados
+static double SineResidualDb(const float *samples, ULONG frames, double omega, double *amplitude) {
+    double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0;
+    double determinant;
+    double a;
+    double b;
+    double error = 0.0;
+    double fitted;
+    ULONG i;
+
+    for (i = 0; i < frames; i++) {
+        ss += sin(omega * i) * sin(omega * i);
+        cc += cos(omega * i) * cos(omega * i);
+        sc += sin(omega * i) * cos(omega * i);
+        ys += samples[i] * sin(omega * i);
+        yc += samples[i] * cos(omega * i);
+    }
+
+    determinant = ss * cc - sc * sc;
+    a = (ys * cc - yc * sc) / determinant;
+    b = (yc * ss - ys * sc) / determinant;
+
+    for (i = 0; i < frames; i++) {
+        fitted = a * sin(omega * i) + b * cos(omega * i);
+        error += (samples[i] - fitted) * (samples[i] - fitted);
+    }
+
+    *amplitude = sqrt(a * a + b * b);
+    return 10.0 * log10(error / frames / (*amplitude * *amplitude / 2.0));
+}
+
+BOOLEAN TestConfigValidation(void) {
+    DRIFT_CONTROL_CONFIG config;
+    PDRIFT_CONTROL driftControl;
+    SIZE_T size;
+
+    config.Channels = 2;
+    config.Format = SAMPLE_FORMAT_INT16;
+    config.TargetFill = 2400;
+    config.MaxCorrectionPpm = 1000;
+    config.ResponseFrames = 480000;
+    config.Isa = SAMPLE_CONVERT_ISA_SCALAR;
+
+    size = DriftControlGetRequiredSize(&config);
+    if (size == 0 || size > sizeof(g_Memory)) {
+        printf("   Tamaño inesperado: %zu\n", size);
+        return FALSE;
+    }
+
+    if (DriftControlInitialize(g_Memory, size - 1, &config, &driftControl) != STATUS_BUFFER_TOO_SMALL) {
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(DriftControlInitialize(g_Memory, size, &config, &driftControl)) ||
+        driftControl != (PDRIFT_CONTROL)g_Memory || driftControl->FrameSize != 4) {
+        return FALSE;
+    }
+
+    config.Channels = DRIFT_CONTROL_MAX_CHANNELS + 1;
+    if (DriftControlIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.Channels = 2;
+    config.TargetFill = 0;
+    if (DriftControlIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.TargetFill = 2400;
+    config.MaxCorrectionPpm = DRIFT_CONTROL_MAX_CORRECTION_PPM + 1;
+    if (DriftControlIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.MaxCorrectionPpm = 0;
+    if (DriftControlIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.MaxCorrectionPpm = 1000;
+    config.ResponseFrames = DRIFT_CONTROL_MIN_RESPONSE_FRAMES - 1;
+    if (DriftControlIsValidConfig(&config) || DriftControlGetRequiredSize(&config) != 0) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Con el anillo muy por encima del objetivo la corrección se satura en
+// +1000 ppm: el seno sale 1000 ppm más agudo, con la misma amplitud y limpio
+static BOOLEAN CheckSine(double frequency) {
+    RING_BUFFER ring;
+    DRIFT_CONTROL_STATS before;
+    DRIFT_CONTROL_STATS after;
+    PDRIFT_CONTROL driftControl;
+    double omega = 2.0 * TEST_PI * frequency / TEST_RATE;
+    double amplitude;
+    double residual;
+    ULONG64 consumed;
+    ULONG i;
+
+    driftControl = CreateDriftControl(64, 1000, DRIFT_CONTROL_MIN_RESPONSE_FRAMES);
+    if (driftControl == NULL ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, TEST_RING_FRAMES, sizeof(float)))) {
+        return FALSE;
+    }
+
+    for (i = 0; i < TEST_RING_FRAMES; i++) {
+        g_Input[i] = (float)(0.5 * sin(omega * i));
+    }
+    RingBufferWrite(&ring, g_Input, TEST_RING_FRAMES);
+
+    // La primera lectura sale a paso 1 y deja la corrección saturada
+    if (DriftControlReadRing(driftControl, &ring, g_Output, 256) != 256) {
+        return FALSE;
+    }
+
+    DriftControlGetStats(driftControl, &before);
+    if (before.CorrectionPpb != 1000000) {
+        printf("   Corrección %d ppb, se esperaba 1000000\n", before.CorrectionPpb);
+        return FALSE;
+    }
+
+    if (DriftControlReadRing(driftControl, &ring, g_Output, 4096) != 4096) {
+        return FALSE;
+    }
+
+    DriftControlGetStats(driftControl, &after);
+    consumed = after.FramesConsumed - before.FramesConsumed;
+    if (consumed < 4098 || consumed > 4102) {
+        printf("   %llu frames consumidos para 4096 entregados\n", (unsigned long long)consumed);
+        return FALSE;
+    }
+
+    residual = SineResidualDb(g_Output, 4096, omega * 1.001, &amplitude);
+    if (residual > -70.0 || fabs(amplitude - 0.5) > 0.003) {
+        printf("   %.0f Hz: residuo %.1f dB, amplitud %.4f\n", frequency, residual, amplitude);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestInterpolationQuality(void) {
+    RING_BUFFER ring;
+    PDRIFT_CONTROL driftControl;
+    ULONG i;
+
+    if (!CheckSine(1000.0) || !CheckSine(12000.0)) {
+        return FALSE;
+    }
+
+    // Todas las fases tienen ganancia unitaria en continua
+    driftControl = CreateDriftControl(64, 1000, DRIFT_CONTROL_MIN_RESPONSE_FRAMES);
+    if (driftControl == NULL ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, TEST_RING_FRAMES, sizeof(float)))) {
+        return FALSE;
+    }
+
+    for (i = 0; i < TEST_RING_FRAMES; i++) {
+        g_Input[i] = 0.5f;
+    }
+    RingBufferWrite(&ring, g_Input, TEST_RING_FRAMES);
+
+    DriftControlReadRing(driftControl, &ring, g_Output, 256);
+    if (DriftControlReadRing(driftControl, &ring, g_Output, 4096) != 4096) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 4096; i++) {
+        if (fabsf(g_Output[i] - 0.5f) > 1e-5f) {
+            printf("   Frame %u: %g en lugar de 0.5\n", i, g_Output[i]);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestUnderrunAndTargetClamp(void) {
+    RING_BUFFER ring;
+    DRIFT_CONTROL_STATS stats;
+    PDRIFT_CONTROL driftControl;
+
+    // Objetivo mayor que el anillo: se usa la mitad de la capacidad
+    driftControl = CreateDriftControl(5000, 1000, DRIFT_CONTROL_MIN_RESPONSE_FRAMES);
+    if (driftControl == NULL || !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, 1024, sizeof(float)))) {
+        return FALSE;
+    }
+
+    memset(g_Input, 0, sizeof(g_Input));
+    RingBufferWrite(&ring, g_Input, 1024);
+
+    if (DriftControlReadRing(driftControl, &ring, g_Output, 256) != 256) {
+        return FALSE;
+    }
+
+    DriftControlGetStats(driftControl, &stats);
+    if (stats.TargetFill != 512 || stats.AverageFill > 1024 || stats.CorrectionPpb <= 0 || stats.ShortReads != 0) {
+        printf("   Objetivo %u, llenado %u, corrección %d\n", stats.TargetFill, stats.AverageFill, stats.CorrectionPpb);
+        return FALSE;
+    }
+
+    // Pedir más de lo que hay: entrega lo posible y el lazo no cambia
+    if (DriftControlReadRing(driftControl, &ring, g_Output, 2048) >= 2048) {
+        return FALSE;
+    }
+
+    DriftControlGetStats(driftControl, &stats);
+    if (stats.ShortReads != 1 || stats.CorrectionPpb != driftControl->Stats.CorrectionPpb ||
+        RingBufferGetUsedFrames(&ring) != 0) {
+        return FALSE;
+    }
+
+    // Con el anillo vacío no sale nada más que lo que quedaba en la ventana
+    if (DriftControlReadRing(driftControl, &ring, g_Output, 16) != 0) {
+        return FALSE;
+    }
+
+    DriftControlGetStats(driftControl, &stats);
+    if (stats.ShortReads != 2 || stats.FramesProduced > stats.FramesConsumed) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// El productor entrega 10 ms de su reloj, 300 ppm más rápido, en cada lectura
+// de 10 ms del reloj del lector. El lazo debe estimar la deriva y dejar el
+// llenado en el objetivo sin que el anillo se llene ni se vacíe.
+BOOLEAN TestDriftLock(void) {
+    RING_BUFFER ring;
+    DRIFT_CONTROL_STATS stats;
+    PDRIFT_CONTROL driftControl;
+    double credit = 0.0;
+    ULONG minFill = TEST_RING_FRAMES;
+    ULONG maxFill = 0;
+    ULONG written;
+    ULONG fill;
+    ULONG read;
+
+    driftControl = CreateDriftControl(2400, 1000, 24000);
+    if (driftControl == NULL ||
+        !NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, TEST_RING_FRAMES, sizeof(float)))) {
+        return FALSE;
+    }
+
+    memset(g_Input, 0, sizeof(g_Input));
+    RingBufferWrite(&ring, g_Input, 2400);
+
+    // 30 s: unas 60 constantes de tiempo
+    for (read = 0; read < 3000; read++) {
+        credit += TEST_READ_FRAMES * (1.0 + 300e-6);
+        written = (ULONG)credit;
+        if (RingBufferWrite(&ring, g_Input, written) != written) {
+            printf("   Anillo lleno en la lectura %u\n", read);
+            return FALSE;
+        }
+        credit -= written;
+
+        if (DriftControlReadRing(driftControl, &ring, g_Output, TEST_READ_FRAMES) != TEST_READ_FRAMES) {
+            printf("   Anillo vacío en la lectura %u\n", read);
+            return FALSE;
+        }
+
+        if (read >= 1500) {
+            fill = RingBufferGetUsedFrames(&ring);
+            minFill = (fill < minFill) ? fill : minFill;
+            maxFill = (fill > maxFill) ? fill : maxFill;
+        }
+    }
+
+    DriftControlGetStats(driftControl, &stats);
+    if (stats.DriftPpb < 290000 || stats.DriftPpb > 310000 ||
+        abs((int)stats.AverageFill - 2400) > 48 || stats.ShortReads != 0) {
+        printf("   Deriva %d ppb, llenado %u\n", stats.DriftPpb, stats.AverageFill);
+        return FALSE;
+    }
+
+    // Ya enganchado, el llenado apenas se mueve
+    if (minFill + 48 < 2400 || maxFill > 2400 + 48) {
+        printf("   Llenado entre %u y %u\n", minFill, maxFill);
+        return FALSE;
+    }
+
+    return TRUE;
+}
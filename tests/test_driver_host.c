@@ -0,0 +1,475 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "virtual_mic.h"
+#include "driver_core.h"
+
+// El driver completo (DriverEntry, despacho, handlers, lecturas pendientes)
+// sobre el shim de src/host/km: los IRP los crea HostAllocateIrp y se
+// entregan por DriverObject->MajorFunction como lo haría el I/O manager.
+
+#define TEST_PACKET_FRAMES 480
+#define TEST_CHANNELS      DEFAULT_CHANNELS
+
+DRIVER_INITIALIZE DriverEntry;
+
+static DRIVER_OBJECT g_DriverObject;
+static FILE_OBJECT g_FileObject;
+static UCHAR g_SystemBuffer[64 * 1024];
+
+// Funciones de prueba
+BOOLEAN TestDriverEntry(void);
+BOOLEAN TestSendAndRead(void);
+BOOLEAN TestPendingRead(void);
+BOOLEAN TestStatsAndUnknownIoctl(void);
+BOOLEAN TestMaximumBufferFormats(void);
+BOOLEAN TestWatermarksAfterResize(void);
+BOOLEAN TestSmallBufferLatency(void);
+BOOLEAN TestCleanupAndUnload(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 8;
+
+    printf("=== Iniciando pruebas del driver en el host ===\n\n");
+
+    printf("1. Prueba de DriverEntry...\n");
+    if (TestDriverEntry()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de SEND_AUDIO y lectura...\n");
+    if (TestSendAndRead()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de lectura pendiente...\n");
+    if (TestPendingRead()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de estadísticas e IOCTL desconocido...\n");
+    if (TestStatsAndUnknownIoctl()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de buffer máximo con frames de 24 bits...\n");
+    if (TestMaximumBufferFormats()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("6. Prueba de umbrales de llenado tras redimensionar...\n");
+    if (TestWatermarksAfterResize()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("7. Prueba de buffer de 5 ms...\n");
+    if (TestSmallBufferLatency()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("8. Prueba de cleanup y descarga...\n");
+    if (TestCleanupAndUnload()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+// METHOD_BUFFERED: entrada y salida comparten g_SystemBuffer. Devuelve el
+// estado final e Information.
+static NTSTATUS DeviceIoControl(ULONG Code, const void *Input, ULONG InputLength, void *Output,
+                                ULONG OutputLength, ULONG_PTR *Information)
+{
+    PIRP irp = HostAllocateIrp(IRP_MJ_DEVICE_CONTROL, &g_FileObject);
+    PIO_STACK_LOCATION stack = IoGetCurrentIrpStackLocation(irp);
+    NTSTATUS status;
+
+    if (InputLength > 0) {
+        memcpy(g_SystemBuffer, Input, InputLength);
+    }
+
+    irp->AssociatedIrp.SystemBuffer = g_SystemBuffer;
+    stack->Parameters.DeviceIoControl.IoControlCode = Code;
+    stack->Parameters.DeviceIoControl.InputBufferLength = InputLength;
+    stack->Parameters.DeviceIoControl.OutputBufferLength = OutputLength;
+
+    status = g_DriverObject.MajorFunction[IRP_MJ_DEVICE_CONTROL](g_DriverObject.DeviceObject, irp);
+    if (status != STATUS_PENDING && (!irp->HostCompleted || irp->IoStatus.Status != status)) {
+        status = STATUS_UNSUCCESSFUL;
+    }
+
+    if (Output != NULL && NT_SUCCESS(status)) {
+        memcpy(Output, g_SystemBuffer, irp->IoStatus.Information);
+    }
+    if (Information != NULL) {
+        *Information = irp->IoStatus.Information;
+    }
+
+    HostFreeIrp(irp);
+    return status;
+}
+
+static NTSTATUS SendAudio(const SHORT *Samples, ULONG Frames)
+{
+    static UCHAR packetBuffer[sizeof(AUDIO_BUFFER_PACKET) + TEST_PACKET_FRAMES * TEST_CHANNELS * sizeof(SHORT)];
+    PAUDIO_BUFFER_PACKET packet = (PAUDIO_BUFFER_PACKET)packetBuffer;
+    ULONG dataLength = Frames * TEST_CHANNELS * sizeof(SHORT);
+
+    packet->Timestamp = 0;
+    packet->DataLength = dataLength;
+    memcpy(packet->Data, Samples, dataLength);
+
+    return DeviceIoControl(IOCTL_VIRTUALMIC_SEND_AUDIO, packet, sizeof(AUDIO_BUFFER_PACKET) + dataLength,
+                           NULL, 0, NULL);
+}
+
+// IRP_MJ_READ sobre Buffer; el llamador libera el IRP
+static PIRP StartRead(PFILE_OBJECT FileObject, SHORT *Buffer, ULONG Frames, NTSTATUS *Status)
+{
+    PIRP irp = HostAllocateIrp(IRP_MJ_READ, FileObject);
+
+    irp->AssociatedIrp.SystemBuffer = Buffer;
+    IoGetCurrentIrpStackLocation(irp)->Parameters.Read.Length = Frames * TEST_CHANNELS * sizeof(SHORT);
+
+    *Status = g_DriverObject.MajorFunction[IRP_MJ_READ](g_DriverObject.DeviceObject, irp);
+    return irp;
+}
+
+static void FillPattern(SHORT *Samples, ULONG Frames, SHORT Seed)
+{
+    ULONG i;
+
+    for (i = 0; i < Frames * TEST_CHANNELS; i++) {
+        Samples[i] = (SHORT)(Seed + i);
+    }
+}
+
+BOOLEAN TestDriverEntry(void) {
+    PDEVICE_EXTENSION deviceExtension;
+    NTSTATUS status;
+
+    memset(&g_DriverObject, 0, sizeof(g_DriverObject));
+    status = DriverEntry(&g_DriverObject, NULL);
+
+    if (!NT_SUCCESS(status) || g_DriverObject.DeviceObject == NULL || g_DriverObject.DriverUnload == NULL ||
+        g_DriverObject.MajorFunction[IRP_MJ_DEVICE_CONTROL] == NULL ||
+        g_DriverObject.MajorFunction[IRP_MJ_READ] == NULL ||
+        g_DriverObject.MajorFunction[IRP_MJ_CLEANUP] == NULL) {
+        return FALSE;
+    }
+
+    deviceExtension = (PDEVICE_EXTENSION)g_DriverObject.DeviceObject->DeviceExtension;
+    return deviceExtension->IsInitialized && deviceExtension->Dispatcher.EntryCount > 0 &&
+           deviceExtension->Format.SampleRate == DEFAULT_SAMPLE_RATE &&
+           deviceExtension->Format.Channels == DEFAULT_CHANNELS;
+}
+
+BOOLEAN TestSendAndRead(void) {
+    SHORT input[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    SHORT output[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    NTSTATUS status;
+    PIRP irp;
+    BOOLEAN result;
+
+    FillPattern(input, TEST_PACKET_FRAMES, 100);
+    if (SendAudio(input, TEST_PACKET_FRAMES) != STATUS_SUCCESS) {
+        return FALSE;
+    }
+
+    // Hay datos: se completa sin pasar por la cola
+    memset(output, 0, sizeof(output));
+    irp = StartRead(&g_FileObject, output, TEST_PACKET_FRAMES, &status);
+    result = status == STATUS_SUCCESS && irp->HostCompleted && !irp->PendingReturned &&
+             irp->IoStatus.Information == sizeof(output) && memcmp(input, output, sizeof(output)) == 0;
+    HostFreeIrp(irp);
+
+    // Un paquete mal formado no llega al anillo
+    return result &&
+           DeviceIoControl(IOCTL_VIRTUALMIC_SEND_AUDIO, input, 4, NULL, 0, NULL) == STATUS_INVALID_PARAMETER;
+}
+
+BOOLEAN TestPendingRead(void) {
+    SHORT input[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    SHORT output[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    NTSTATUS status;
+    PIRP irp;
+    BOOLEAN result;
+
+    // Anillo vacío: la lectura espera al productor
+    memset(output, 0, sizeof(output));
+    irp = StartRead(&g_FileObject, output, TEST_PACKET_FRAMES, &status);
+    if (status != STATUS_PENDING || irp->HostCompleted || !irp->PendingReturned) {
+        HostFreeIrp(irp);
+        return FALSE;
+    }
+
+    // El envío la completa desde el camino de escritura
+    FillPattern(input, TEST_PACKET_FRAMES, -500);
+    status = SendAudio(input, TEST_PACKET_FRAMES);
+    result = status == STATUS_SUCCESS && irp->HostCompleted && irp->IoStatus.Status == STATUS_SUCCESS &&
+             irp->IoStatus.Information == sizeof(output) && memcmp(input, output, sizeof(output)) == 0;
+    HostFreeIrp(irp);
+    return result;
+}
+
+BOOLEAN TestStatsAndUnknownIoctl(void) {
+    UCHAR buffer[sizeof(IOCTL_STATS_HEADER) + IOCTL_DISPATCH_MAX_ENTRIES * sizeof(IOCTL_CALL_STATS)];
+    PIOCTL_STATS_HEADER header = (PIOCTL_STATS_HEADER)buffer;
+    PIOCTL_CALL_STATS calls = (PIOCTL_CALL_STATS)(header + 1);
+    DRIVER_STATS stats;
+    ULONG_PTR information;
+    ULONG64 sends = 0;
+    ULONG i;
+
+    if (DeviceIoControl(IOCTL_VIRTUALMIC_GET_STATS, NULL, 0, &stats, sizeof(stats), &information) != STATUS_SUCCESS ||
+        information != sizeof(stats)) {
+        return FALSE;
+    }
+
+    // Dos lecturas de 480 frames estéreo entregadas; el anillo quedó vacío
+    if (!stats.IsActive || stats.SamplesProcessed != 2 * TEST_PACKET_FRAMES * TEST_CHANNELS ||
+        stats.BufferUsage != 0 || stats.CurrentFormat.SampleRate != DEFAULT_SAMPLE_RATE) {
+        return FALSE;
+    }
+
+    // Sin handler: el despacho lo rechaza y lo cuenta como desconocido
+    if (DeviceIoControl(CTL_CODE(FILE_DEVICE_UNKNOWN, 0x81F, METHOD_BUFFERED, FILE_ANY_ACCESS),
+                        NULL, 0, NULL, 0, &information) != STATUS_INVALID_DEVICE_REQUEST ||
+        information != 0) {
+        return FALSE;
+    }
+
+    if (DeviceIoControl(IOCTL_VIRTUALMIC_GET_IOCTL_STATS, NULL, 0, buffer, sizeof(buffer), &information) !=
+            STATUS_SUCCESS ||
+        information != sizeof(IOCTL_STATS_HEADER) + header->Entries * sizeof(IOCTL_CALL_STATS)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < header->Entries; i++) {
+        if (calls[i].IoControlCode == IOCTL_VIRTUALMIC_SEND_AUDIO) {
+            sends = calls[i].Calls;
+            if (calls[i].Errors != 1) {
+                return FALSE;
+            }
+        }
+    }
+
+    return header->UnknownCalls == 1 && sends == 3;
+}
+
+static NTSTATUS SetFormat(USHORT BitsPerSample)
+{
+    SET_FORMAT_REQUEST request;
+
+    memset(&request, 0, sizeof(request));
+    request.SampleRate = DEFAULT_SAMPLE_RATE;
+    request.Channels = DEFAULT_CHANNELS;
+    request.BitsPerSample = BitsPerSample;
+
+    return DeviceIoControl(IOCTL_VIRTUALMIC_SET_FORMAT, &request, sizeof(request), NULL, 0, NULL);
+}
+
+static NTSTATUS SetBufferFrames(ULONG Frames)
+{
+    SET_BUFFER_REQUEST request;
+
+    request.Unit = BUFFER_LATENCY_FRAMES;
+    request.Latency = Frames;
+
+    return DeviceIoControl(IOCTL_VIRTUALMIC_SET_BUFFER, &request, sizeof(request), NULL, 0, NULL);
+}
+
+BOOLEAN TestMaximumBufferFormats(void) {
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)g_DriverObject.DeviceObject->DeviceExtension;
+    BOOLEAN result;
+
+    // int16 estéreo: 2^21 frames son exactamente MAX_BUFFER_SIZE
+    if (SetBufferFrames(MAX_BUFFER_SIZE / 4) != STATUS_SUCCESS || deviceExtension->Ring.Capacity != (1UL << 21)) {
+        return FALSE;
+    }
+
+    // Pasar a 24 bits conserva la latencia solo hasta la mayor potencia de
+    // dos que cabe: 2^20 frames (6 MB), no 2^21 (12 MB)
+    if (SetFormat(24) != STATUS_SUCCESS || deviceExtension->Ring.FrameSize != 6 ||
+        deviceExtension->Ring.Capacity != (1UL << 20) || deviceExtension->BufferSize > MAX_BUFFER_SIZE) {
+        return FALSE;
+    }
+
+    // MAX_BUFFER_SIZE / 6 frames se redondearía a 2^21: se rechaza sin tocar el anillo
+    result = SetBufferFrames(MAX_BUFFER_SIZE / 6) == STATUS_INVALID_PARAMETER &&
+             deviceExtension->Ring.Capacity == (1UL << 20) &&
+             SetBufferFrames(1UL << 20) == STATUS_SUCCESS && deviceExtension->BufferSize <= MAX_BUFFER_SIZE;
+
+    // Vuelta al formato y tamaño por defecto
+    return SetFormat(DEFAULT_BITS_PER_SAMPLE) == STATUS_SUCCESS &&
+           SetBufferFrames(DEFAULT_BUFFER_SIZE / 4) == STATUS_SUCCESS && result;
+}
+
+// En el shim el HANDLE del evento es la dirección del KEVENT; NULL anula
+static NTSTATUS SetWatermarks(ULONG LowWater, ULONG HighWater, PKEVENT Event)
+{
+    SET_WATERMARKS_REQUEST request;
+
+    request.LowWaterFrames = LowWater;
+    request.HighWaterFrames = HighWater;
+    request.NotificationEvent = (ULONG64)(ULONG_PTR)Event;
+
+    return DeviceIoControl(IOCTL_VIRTUALMIC_SET_WATERMARKS, &request, sizeof(request), NULL, 0, NULL);
+}
+
+BOOLEAN TestWatermarksAfterResize(void) {
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)g_DriverObject.DeviceObject->DeviceExtension;
+    SHORT input[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    KEVENT event;
+    ULONG capacity;
+    ULONG sent;
+    BOOLEAN result;
+
+    KeInitializeEvent(&event, NotificationEvent, FALSE);
+
+    // Anillo de 8192 frames vacío: el registro anuncia la zona baja
+    if (SetBufferFrames(8192) != STATUS_SUCCESS || SetWatermarks(100, 6000, &event) != STATUS_SUCCESS ||
+        !event.Signaled) {
+        return FALSE;
+    }
+
+    // Al encoger (en modo espejo el mínimo es una granularidad) el umbral alto
+    // se recorta a la capacidad y la zona se vuelve a anunciar
+    KeClearEvent(&event);
+    if (SetBufferFrames(1024) != STATUS_SUCCESS) {
+        return FALSE;
+    }
+
+    capacity = deviceExtension->Ring.Capacity;
+    if (capacity >= 6000 || deviceExtension->Watermarks.HighWater != capacity ||
+        deviceExtension->Watermarks.LowWater != 100 || !event.Signaled) {
+        return FALSE;
+    }
+
+    // El anillo lleno llega al umbral recortado
+    KeClearEvent(&event);
+    FillPattern(input, TEST_PACKET_FRAMES, 0);
+    for (sent = 0; sent < capacity; sent += 256) {
+        SendAudio(input, 256);
+    }
+    if (!event.Signaled || deviceExtension->Watermarks.Zone != WATERMARK_ZONE_HIGH) {
+        return FALSE;
+    }
+
+    // Cambiar el formato vacía el anillo: se anuncia la zona baja sin esperar al lector
+    KeClearEvent(&event);
+    if (SetFormat(24) != STATUS_SUCCESS || !event.Signaled || deviceExtension->Watermarks.Zone != WATERMARK_ZONE_LOW) {
+        return FALSE;
+    }
+
+    // Sin umbral alto, uno bajo >= capacidad dejaría la zona fija en LOW
+    result = SetFormat(DEFAULT_BITS_PER_SAMPLE) == STATUS_SUCCESS && SetBufferFrames(8192) == STATUS_SUCCESS &&
+             SetWatermarks(7000, 0, &event) == STATUS_SUCCESS && SetBufferFrames(1024) == STATUS_SUCCESS &&
+             deviceExtension->Watermarks.LowWater == deviceExtension->Ring.Capacity - 1 &&
+             deviceExtension->Watermarks.HighWater == WATERMARK_HIGH_DISABLED;
+
+    return SetWatermarks(0, 0, NULL) == STATUS_SUCCESS && SetBufferFrames(DEFAULT_BUFFER_SIZE / 4) == STATUS_SUCCESS &&
+           result;
+}
+
+BOOLEAN TestSmallBufferLatency(void) {
+    PDEVICE_EXTENSION deviceExtension = (PDEVICE_EXTENSION)g_DriverObject.DeviceObject->DeviceExtension;
+    SET_BUFFER_REQUEST request;
+    SHORT input[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    SHORT output[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    NTSTATUS status;
+    PIRP irp;
+    ULONG i;
+    BOOLEAN result;
+
+    // 5 ms a 48 kHz son 240 frames: 256 tras redondear, por debajo de la
+    // granularidad del espejo, así que el anillo sale del pool
+    request.Unit = BUFFER_LATENCY_MILLISECONDS;
+    request.Latency = 5;
+    if (DeviceIoControl(IOCTL_VIRTUALMIC_SET_BUFFER, &request, sizeof(request), &request, sizeof(request), NULL) !=
+            STATUS_SUCCESS ||
+        request.Unit != BUFFER_LATENCY_FRAMES || request.Latency != 256 ||
+        deviceExtension->Ring.Capacity != 256 || deviceExtension->MirroredBuffer) {
+        return FALSE;
+    }
+
+    // El anillo pequeño cruza el final sin espejo
+    FillPattern(input, 200, 7);
+    result = TRUE;
+    for (i = 0; i < 3 && result; i++) {
+        memset(output, 0, sizeof(output));
+        result = SendAudio(input, 200) == STATUS_SUCCESS;
+        irp = StartRead(&g_FileObject, output, 200, &status);
+        result = result && status == STATUS_SUCCESS && memcmp(input, output, 200 * TEST_CHANNELS * sizeof(SHORT)) == 0;
+        HostFreeIrp(irp);
+    }
+
+    // Un buffer que cubre la granularidad vuelve a ser espejo
+    return result && SetBufferFrames(DEFAULT_BUFFER_SIZE / 4) == STATUS_SUCCESS &&
+           deviceExtension->Ring.Capacity == DEFAULT_BUFFER_SIZE / 4 && deviceExtension->MirroredBuffer;
+}
+
+BOOLEAN TestCleanupAndUnload(void) {
+    FILE_OBJECT otherFile;
+    SHORT output[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    SHORT otherOutput[TEST_PACKET_FRAMES * TEST_CHANNELS];
+    NTSTATUS status;
+    NTSTATUS otherStatus;
+    PIRP read;
+    PIRP otherRead;
+    PIRP cleanup;
+    BOOLEAN result;
+
+    memset(&otherFile, 0, sizeof(otherFile));
+    read = StartRead(&g_FileObject, output, TEST_PACKET_FRAMES, &status);
+    otherRead = StartRead(&otherFile, otherOutput, TEST_PACKET_FRAMES, &otherStatus);
+
+    // El cierre de un handle cancela solo sus lecturas
+    cleanup = HostAllocateIrp(IRP_MJ_CLEANUP, &g_FileObject);
+    result = status == STATUS_PENDING && otherStatus == STATUS_PENDING &&
+             g_DriverObject.MajorFunction[IRP_MJ_CLEANUP](g_DriverObject.DeviceObject, cleanup) == STATUS_SUCCESS &&
+             read->HostCompleted && read->IoStatus.Status == STATUS_CANCELLED && read->IoStatus.Information == 0 &&
+             !otherRead->HostCompleted;
+    HostFreeIrp(cleanup);
+
+    cleanup = HostAllocateIrp(IRP_MJ_CLEANUP, &otherFile);
+    g_DriverObject.MajorFunction[IRP_MJ_CLEANUP](g_DriverObject.DeviceObject, cleanup);
+    result = result && otherRead->HostCompleted && otherRead->IoStatus.Status == STATUS_CANCELLED;
+    HostFreeIrp(cleanup);
+    HostFreeIrp(read);
+    HostFreeIrp(otherRead);
+
+    // La descarga borra el dispositivo
+    g_DriverObject.DriverUnload(&g_DriverObject);
+    return result && g_DriverObject.DeviceObject == NULL;
+}
@@ -0,0 +1,614 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dsp_chain.h"
+
+#define TEST_RATE          48000
+#define TEST_FRAMES        9600
+#define TEST_MAX_CHANNELS  8
+#define TEST_PI            3.14159265358979323846
+
+static UCHAR g_Memory[1 << 18];
+static UCHAR g_MemoryB[1 << 18];
+static float g_Input[TEST_FRAMES * TEST_MAX_CHANNELS];
+static float g_Output[TEST_FRAMES * TEST_MAX_CHANNELS];
+static float g_OutputB[TEST_FRAMES * TEST_MAX_CHANNELS];
+static SHORT g_Pcm[TEST_FRAMES * TEST_MAX_CHANNELS];
+static SHORT g_PcmB[TEST_FRAMES * TEST_MAX_CHANNELS];
+
+// Funciones de prueba
+BOOLEAN TestConfigValidation(void);
+BOOLEAN TestEqResponse(void);
+BOOLEAN TestCompressorCurve(void);
+BOOLEAN TestLimiterCeiling(void);
+BOOLEAN TestChainBlocksAndReset(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas de la cadena de procesado ===\n\n");
+
+    printf("1. Prueba de validación de etapas y configuraciones...\n");
+    if (TestConfigValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de respuesta del ecualizador y SSE2 idéntico al escalar...\n");
+    if (TestEqResponse()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de la curva estática y el suavizado del compresor...\n");
+    if (TestCompressorCurve()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba del techo y el retardo del limitador...\n");
+    if (TestLimiterCeiling()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de cadena completa en int16: bloques, ISA y reinicio...\n");
+    if (TestChainBlocksAndReset()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    if (passedTests == totalTests) {
+        printf("🎉 ¡Todas las pruebas pasaron!\n");
+        return 0;
+    } else {
+        printf("⚠️  Algunas pruebas fallaron\n");
+        return 1;
+    }
+}
+
+static void InitConfig(DSP_CHAIN_CONFIG *config, SAMPLE_FORMAT format, ULONG channels, SAMPLE_CONVERT_ISA isa) {
+    memset(config, 0, sizeof(*config));
+    config->SampleRate = TEST_RATE;
+    config->Channels = channels;
+    config->Format = format;
+    config->Isa = isa;
+}
+
+static DSP_STAGE_CONFIG *AddEq(DSP_CHAIN_CONFIG *config, ULONG shape, float frequency, float q, float gainDb) {
+    DSP_STAGE_CONFIG *stage = &config->Stage[config->Stages++];
+
+    stage->Type = DSP_STAGE_EQ;
+    stage->Bands = 1;
+    stage->Band[0].Shape = shape;
+    stage->Band[0].Frequency = frequency;
+    stage->Band[0].Q = q;
+    stage->Band[0].GainDb = gainDb;
+    return stage;
+}
+
+static DSP_STAGE_CONFIG *AddCompressor(DSP_CHAIN_CONFIG *config, float thresholdDb, float ratio, float kneeDb,
+                                       float attackMs, float releaseMs) {
+    DSP_STAGE_CONFIG *stage = &config->Stage[config->Stages++];
+
+    stage->Type = DSP_STAGE_COMPRESSOR;
+    stage->ThresholdDb = thresholdDb;
+    stage->Ratio = ratio;
+    stage->KneeDb = kneeDb;
+    stage->AttackMs = attackMs;
+    stage->ReleaseMs = releaseMs;
+    return stage;
+}
+
+static DSP_STAGE_CONFIG *AddLimiter(DSP_CHAIN_CONFIG *config, float ceilingDb, float lookaheadMs, float releaseMs) {
+    DSP_STAGE_CONFIG *stage = &config->Stage[config->Stages++];
+
+    stage->Type = DSP_STAGE_LIMITER;
+    stage->CeilingDb = ceilingDb;
+    stage->LookaheadMs = lookaheadMs;
+    stage->ReleaseMs = releaseMs;
+    return stage;
+}
+
+static PDSP_CHAIN CreateChain(UCHAR *memory, SIZE_T size, const DSP_CHAIN_CONFIG *config) {
+    PDSP_CHAIN chain;
+
+    if (!NT_SUCCESS(DspChainInitialize(memory, size, config, &chain))) {
+        return NULL;
+    }
+
+    return chain;
+}
+
+// Ruido uniforme determinista en [-amplitude, amplitude]
+static void FillNoise(float *samples, SIZE_T count, double amplitude, ULONG seed) {
+    SIZE_T i;
+
+    for (i = 0; i < count; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        samples[i] = (float)(amplitude * ((double)(seed >> 8) / 8388608.0 - 1.0));
+    }
+}
+
+// Amplitud de un seno de frecuencia conocida (mínimos cuadrados sobre sin y cos)
+static double SineAmplitude(const float *samples, ULONG channels, ULONG frames, double frequency) {
+    double omega = 2.0 * TEST_PI * frequency / TEST_RATE;
+    double ys = 0.0;
+    double yc = 0.0;
+    ULONG i;
+
+    for (i = 0; i < frames; i++) {
+        ys += samples[(SIZE_T)i * channels] * sin(omega * i);
+        yc += samples[(SIZE_T)i * channels] * cos(omega * i);
+    }
+
+    return 2.0 * sqrt(ys * ys + yc * yc) / frames;
+}
+
+BOOLEAN TestConfigValidation(void) {
+    DSP_CHAIN_CONFIG config;
+    DSP_STAGE_CONFIG *stage;
+    PDSP_CHAIN chain;
+    DSP_CHAIN_STATS stats;
+
+    // Sin etapas, tipo desconocido, rangos fuera de límites y NaN
+    InitConfig(&config, SAMPLE_FORMAT_FLOAT32, 2, SAMPLE_CONVERT_ISA_SCALAR);
+    if (DspChainIsValidConfig(&config) || DspChainGetRequiredSize(&config) != 0) {
+        printf("   Cadena sin etapas aceptada\n");
+        return FALSE;
+    }
+
+    stage = AddEq(&config, DSP_EQ_PEAKING, 1000.0f, 1.0f, 6.0f);
+    if (!DspChainIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    stage->Band[0].Frequency = 24000.0f;
+    if (!DspStageIsValidConfig(stage) || DspChainIsValidConfig(&config)) {
+        printf("   Banda en Nyquist aceptada por la cadena\n");
+        return FALSE;
+    }
+
+    stage->Band[0].Frequency = 1000.0f;
+    stage->Band[0].Q = NAN;
+    if (DspStageIsValidConfig(stage)) {
+        printf("   Q NaN aceptada\n");
+        return FALSE;
+    }
+
+    stage->Band[0].Q = 1.0f;
+    stage->Band[0].Shape = DSP_EQ_SHAPE_COUNT;
+    if (DspStageIsValidConfig(stage)) {
+        return FALSE;
+    }
+
+    stage->Band[0].Shape = DSP_EQ_PEAKING;
+    stage->Bands = 0;
+    if (DspStageIsValidConfig(stage)) {
+        return FALSE;
+    }
+
+    stage->Bands = 1;
+    stage = AddCompressor(&config, -20.0f, 0.5f, 0.0f, 5.0f, 100.0f);
+    if (DspStageIsValidConfig(stage)) {
+        printf("   Ratio menor que 1 aceptado\n");
+        return FALSE;
+    }
+
+    stage->Ratio = 4.0f;
+    stage = AddLimiter(&config, -1.0f, 50.0f, 50.0f);
+    if (DspStageIsValidConfig(stage)) {
+        printf("   Anticipación fuera de rango aceptada\n");
+        return FALSE;
+    }
+
+    stage->LookaheadMs = 2.0f;
+    stage = &config.Stage[config.Stages++];
+    stage->Type = DSP_STAGE_TYPE_COUNT;
+    if (DspChainIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.Stages--;
+    if (!DspChainIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.Channels = DSP_CHAIN_MAX_CHANNELS + 1;
+    if (DspChainIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    // Memoria corta, y la latencia es la del limitador
+    config.Channels = 2;
+    if (DspChainInitialize(g_Memory, DspChainGetRequiredSize(&config) - 1, &config, &chain) != STATUS_BUFFER_TOO_SMALL ||
+        chain != NULL) {
+        printf("   Memoria insuficiente aceptada\n");
+        return FALSE;
+    }
+
+    chain = CreateChain(g_Memory, DspChainGetRequiredSize(&config), &config);
+    if (chain == NULL) {
+        return FALSE;
+    }
+
+    DspChainGetStats(chain, &stats);
+    if (stats.Stages != 3 || stats.LatencyFrames != 96 || stats.FramesProcessed != 0 ||
+        stats.GainReductionDb[1] != 0.0f || stats.GainReductionDb[2] != 0.0f) {
+        printf("   Estado inicial: %u etapas, latencia %u\n", stats.Stages, stats.LatencyFrames);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestEqResponse(void) {
+    static const struct {
+        ULONG Shape;
+        float Frequency;
+        float GainDb;
+        double Probe;
+        double Expected;     // Ganancia lineal en Probe
+        double Tolerance;
+    } cases[] = {
+        { DSP_EQ_PEAKING, 1000.0f, 6.0f, 1000.0, 1.9953, 0.01 },
+        { DSP_EQ_PEAKING, 1000.0f, -12.0f, 1000.0, 0.2512, 0.005 },
+        { DSP_EQ_PEAKING, 1000.0f, 6.0f, 100.0, 1.0, 0.03 },
+        { DSP_EQ_LOW_PASS, 1000.0f, 0.0f, 1000.0, 0.7071, 0.01 },
+        { DSP_EQ_LOW_PASS, 1000.0f, 0.0f, 8000.0, 0.0, 0.02 },
+        { DSP_EQ_HIGH_PASS, 1000.0f, 0.0f, 100.0, 0.0, 0.02 },
+        { DSP_EQ_LOW_SHELF, 200.0f, 6.0f, 50.0, 1.9953, 0.06 },
+        { DSP_EQ_HIGH_SHELF, 4000.0f, -6.0f, 16000.0, 0.5012, 0.02 },
+        { DSP_EQ_NOTCH, 1000.0f, 0.0f, 1000.0, 0.0, 0.005 },
+        { DSP_EQ_BAND_PASS, 1000.0f, 0.0f, 1000.0, 1.0, 0.01 },
+    };
+    DSP_CHAIN_CONFIG config;
+    PDSP_CHAIN chain;
+    PDSP_CHAIN chainB;
+    ULONG c;
+    ULONG i;
+    ULONG channels;
+    ULONG band;
+    double gain;
+
+    for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        InitConfig(&config, SAMPLE_FORMAT_FLOAT32, 1, SampleConvertGetBestIsa());
+        AddEq(&config, cases[c].Shape, cases[c].Frequency, 0.7071f, cases[c].GainDb);
+        chain = CreateChain(g_Memory, sizeof(g_Memory), &config);
+        if (chain == NULL) {
+            return FALSE;
+        }
+
+        for (i = 0; i < TEST_FRAMES; i++) {
+            g_Output[i] = (float)(0.5 * sin(2.0 * TEST_PI * cases[c].Probe * i / TEST_RATE));
+        }
+
+        DspChainProcess(chain, g_Output, TEST_FRAMES);
+
+        // Se descarta la primera mitad (transitorio)
+        gain = SineAmplitude(g_Output + TEST_FRAMES / 2, 1, TEST_FRAMES / 2, cases[c].Probe) / 0.5;
+        if (fabs(gain - cases[c].Expected) > cases[c].Tolerance) {
+            printf("   Forma %u a %.0f Hz: ganancia %.4f (esperada %.4f)\n",
+                   cases[c].Shape, cases[c].Probe, gain, cases[c].Expected);
+            return FALSE;
+        }
+    }
+
+    if (SampleConvertGetBestIsa() == SAMPLE_CONVERT_ISA_SCALAR) {
+        printf("   (sin SSE2: no se comparan núcleos)\n");
+        return TRUE;
+    }
+
+    // Ocho bandas de todas las formas con todos los anchos de canal
+    for (channels = 1; channels <= TEST_MAX_CHANNELS; channels++) {
+        InitConfig(&config, SAMPLE_FORMAT_FLOAT32, channels, SAMPLE_CONVERT_ISA_SCALAR);
+        AddEq(&config, DSP_EQ_PEAKING, 1000.0f, 1.0f, 6.0f);
+        config.Stage[0].Bands = DSP_EQ_MAX_BANDS;
+        for (band = 1; band < DSP_EQ_MAX_BANDS; band++) {
+            config.Stage[0].Band[band].Shape = band % DSP_EQ_SHAPE_COUNT;
+            config.Stage[0].Band[band].Frequency = 80.0f * (float)(band + 1) * (float)(band + 1);
+            config.Stage[0].Band[band].Q = 0.5f + 0.3f * band;
+            config.Stage[0].Band[band].GainDb = (band & 1) ? 4.0f : -9.0f;
+        }
+
+        chain = CreateChain(g_Memory, sizeof(g_Memory), &config);
+        config.Isa = SampleConvertGetBestIsa();
+        chainB = CreateChain(g_MemoryB, sizeof(g_MemoryB), &config);
+        if (chain == NULL || chainB == NULL) {
+            return FALSE;
+        }
+
+        FillNoise(g_Output, (SIZE_T)TEST_FRAMES * channels, 0.8, channels);
+        memcpy(g_OutputB, g_Output, (SIZE_T)TEST_FRAMES * channels * sizeof(float));
+
+        DspChainProcess(chain, g_Output, TEST_FRAMES);
+        DspChainProcess(chainB, g_OutputB, TEST_FRAMES);
+
+        if (memcmp(g_Output, g_OutputB, (SIZE_T)TEST_FRAMES * channels * sizeof(float)) != 0) {
+            printf("   %u canales: SSE2 distinto del escalar\n", channels);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestCompressorCurve(void) {
+    static const struct {
+        float KneeDb;
+        double InputDb;
+        double ExpectedDb;
+    } cases[] = {
+        { 0.0f, -30.0, -30.0 },      // Por debajo del umbral
+        { 0.0f, -6.0, -16.5 },       // -20 + 14 / 4
+        { 0.0f, -20.0, -20.0 },
+        { 12.0f, -30.0, -30.0 },     // Por debajo de la rodilla
+        { 12.0f, -20.0, -21.125 },   // Centro de la rodilla: 0.75 * 6² / 24
+        { 12.0f, -6.0, -16.5 },      // Por encima de la rodilla
+    };
+    DSP_CHAIN_CONFIG config;
+    DSP_STAGE_CONFIG *stage;
+    PDSP_CHAIN chain;
+    DSP_CHAIN_STATS stats;
+    ULONG c;
+    ULONG i;
+    ULONG settled;
+    double level;
+    double outputDb;
+    SAMPLE_CONVERT_ISA isa;
+
+    for (isa = SAMPLE_CONVERT_ISA_SCALAR; isa <= SampleConvertGetBestIsa(); isa++) {
+        for (c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+            InitConfig(&config, SAMPLE_FORMAT_FLOAT32, 2, isa);
+            AddCompressor(&config, -20.0f, 4.0f, cases[c].KneeDb, 1.0f, 50.0f);
+            chain = CreateChain(g_Memory, sizeof(g_Memory), &config);
+            if (chain == NULL) {
+                return FALSE;
+            }
+
+            // Continua en un canal y en el otro con la mitad: manda el mayor
+            level = pow(10.0, cases[c].InputDb / 20.0);
+            for (i = 0; i < TEST_FRAMES; i++) {
+                g_Output[i * 2] = (float)(level / 2.0);
+                g_Output[i * 2 + 1] = (float)-level;
+            }
+
+            DspChainProcess(chain, g_Output, TEST_FRAMES);
+
+            outputDb = 20.0 * log10(-g_Output[(TEST_FRAMES - 1) * 2 + 1]);
+            if (fabs(outputDb - cases[c].ExpectedDb) > 0.01 ||
+                fabs(g_Output[(TEST_FRAMES - 1) * 2] / -g_Output[(TEST_FRAMES - 1) * 2 + 1] - 0.5) > 1e-6) {
+                printf("   ISA %d, rodilla %.0f dB, entrada %.1f dB: salida %.3f dB (esperada %.3f)\n",
+                       isa, cases[c].KneeDb, cases[c].InputDb, outputDb, cases[c].ExpectedDb);
+                return FALSE;
+            }
+
+            DspChainGetStats(chain, &stats);
+            if (fabs(stats.GainReductionDb[0] - (cases[c].InputDb - cases[c].ExpectedDb)) > 0.01) {
+                printf("   Reducción informada %.3f dB\n", stats.GainReductionDb[0]);
+                return FALSE;
+            }
+        }
+    }
+
+    // Ataque y relajación: tras un escalón la reducción llega al 63 % en la
+    // constante de tiempo (10 ms de ataque = 480 frames)
+    InitConfig(&config, SAMPLE_FORMAT_FLOAT32, 1, SampleConvertGetBestIsa());
+    stage = AddCompressor(&config, -20.0f, 100.0f, 0.0f, 10.0f, 100.0f);
+    stage->MakeupDb = 6.0f;
+    chain = CreateChain(g_Memory, sizeof(g_Memory), &config);
+    if (chain == NULL) {
+        return FALSE;
+    }
+
+    // Ganancia de compensación sola por debajo del umbral
+    for (i = 0; i < 480; i++) {
+        g_Output[i] = 0.01f;
+    }
+    DspChainProcess(chain, g_Output, 480);
+    if (fabs(20.0 * log10(g_Output[479] / 0.01) - 6.0) > 0.005) {
+        printf("   Compensación: %.4f dB\n", 20.0 * log10(g_Output[479] / 0.01));
+        return FALSE;
+    }
+
+    // Escalón a 0 dB: 19.8 dB de reducción objetivo
+    for (i = 0; i < TEST_FRAMES; i++) {
+        g_Output[i] = 1.0f;
+    }
+    DspChainProcess(chain, g_Output, TEST_FRAMES);
+
+    level = 6.0 - 20.0 * log10(g_Output[479]);
+    if (fabs(level / 19.8 - (1.0 - exp(-1.0))) > 0.01) {
+        printf("   Reducción tras una constante de ataque: %.3f dB de 19.8\n", level);
+        return FALSE;
+    }
+
+    // Silencio: relaja y acaba exactamente en 0 dB de reducción
+    memset(g_Output, 0, sizeof(g_Output));
+    for (settled = 0; settled < 20; settled++) {
+        DspChainProcess(chain, g_Output, TEST_FRAMES);
+    }
+
+    DspChainGetStats(chain, &stats);
+    if (stats.GainReductionDb[0] != 0.0f || stats.FramesProcessed != 480 + 21 * TEST_FRAMES) {
+        printf("   Tras el silencio: reducción %g dB, %llu frames\n",
+               stats.GainReductionDb[0], (unsigned long long)stats.FramesProcessed);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestLimiterCeiling(void) {
+    static const ULONG calls[] = { 1, 7, 64, 100, 480, 13 };
+    DSP_CHAIN_CONFIG config;
+    PDSP_CHAIN chain;
+    DSP_CHAIN_STATS stats;
+    ULONG channels;
+    ULONG latency;
+    ULONG offset;
+    ULONG frames;
+    ULONG call;
+    SIZE_T i;
+    float ceiling = (float)pow(10.0, -3.0 / 20.0);
+    SAMPLE_CONVERT_ISA isa;
+
+    for (isa = SAMPLE_CONVERT_ISA_SCALAR; isa <= SampleConvertGetBestIsa(); isa++) {
+        for (channels = 1; channels <= TEST_MAX_CHANNELS; channels++) {
+            InitConfig(&config, SAMPLE_FORMAT_FLOAT32, channels, isa);
+            AddLimiter(&config, -3.0f, 1.5f, 50.0f);
+            chain = CreateChain(g_Memory, sizeof(g_Memory), &config);
+            if (chain == NULL) {
+                return FALSE;
+            }
+
+            latency = chain->LatencyFrames;
+            if (latency != 72) {
+                printf("   Latencia %u frames (esperada 72)\n", latency);
+                return FALSE;
+            }
+
+            // Ruido hasta +12 dB con ráfagas, en llamadas de tamaños variados
+            FillNoise(g_Input, (SIZE_T)TEST_FRAMES * channels, 4.0, 7 * channels);
+            for (i = 0; i < (SIZE_T)TEST_FRAMES * channels; i++) {
+                if ((i / channels / 1000) & 1) {
+                    g_Input[i] *= 0.05f;
+                }
+            }
+
+            memcpy(g_Output, g_Input, (SIZE_T)TEST_FRAMES * channels * sizeof(float));
+            for (offset = 0, call = 0; offset < TEST_FRAMES; offset += frames, call++) {
+                frames = min(calls[call % 6], TEST_FRAMES - offset);
+                DspChainProcess(chain, g_Output + (SIZE_T)offset * channels, frames);
+            }
+
+            for (i = 0; i < (SIZE_T)TEST_FRAMES * channels; i++) {
+                if (fabsf(g_Output[i]) > ceiling) {
+                    printf("   %u canales, muestra %zu: %f sobre el techo %f\n",
+                           channels, i, g_Output[i], ceiling);
+                    return FALSE;
+                }
+            }
+
+            DspChainGetStats(chain, &stats);
+            if (stats.LatencyFrames != latency || stats.GainReductionDb[0] <= 0.0f) {
+                return FALSE;
+            }
+
+            // Por debajo del techo sale intacto, solo retrasado
+            DspChainReset(chain);
+            FillNoise(g_Input, (SIZE_T)TEST_FRAMES * channels, 0.6, 3);
+            memcpy(g_Output, g_Input, (SIZE_T)TEST_FRAMES * channels * sizeof(float));
+            DspChainProcess(chain, g_Output, TEST_FRAMES);
+
+            for (i = 0; i < (SIZE_T)latency * channels; i++) {
+                if (g_Output[i] != 0.0f) {
+                    printf("   El reinicio no vació la línea de retardo\n");
+                    return FALSE;
+                }
+            }
+
+            if (memcmp(g_Output + (SIZE_T)latency * channels, g_Input,
+                       (SIZE_T)(TEST_FRAMES - latency) * channels * sizeof(float)) != 0) {
+                printf("   %u canales: señal bajo el techo modificada\n", channels);
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+// EQ, compresor, limitador y otro EQ sobre int16 estéreo
+static void InitFullChain(DSP_CHAIN_CONFIG *config, SAMPLE_CONVERT_ISA isa) {
+    DSP_STAGE_CONFIG *stage;
+
+    InitConfig(config, SAMPLE_FORMAT_INT16, 2, isa);
+    AddEq(config, DSP_EQ_HIGH_PASS, 80.0f, 0.7071f, 0.0f);
+    stage = AddCompressor(config, -24.0f, 3.0f, 6.0f, 5.0f, 80.0f);
+    stage->MakeupDb = 8.0f;
+    AddLimiter(config, -1.0f, 2.0f, 60.0f);
+    stage = AddEq(config, DSP_EQ_PEAKING, 3000.0f, 1.2f, 3.0f);
+    stage->Bands = 2;
+    stage->Band[1].Shape = DSP_EQ_LOW_SHELF;
+    stage->Band[1].Frequency = 150.0f;
+    stage->Band[1].Q = 0.7f;
+    stage->Band[1].GainDb = -4.0f;
+}
+
+static void FillPcm(SHORT *pcm) {
+    ULONG i;
+
+    for (i = 0; i < TEST_FRAMES; i++) {
+        double envelope = (i < TEST_FRAMES / 2) ? 0.9 : 0.1;
+        pcm[i * 2] = (SHORT)(32767.0 * envelope * sin(2.0 * TEST_PI * 440.0 * i / TEST_RATE));
+        pcm[i * 2 + 1] = (SHORT)(32767.0 * envelope * sin(2.0 * TEST_PI * 97.0 * i / TEST_RATE + 1.0));
+    }
+}
+
+BOOLEAN TestChainBlocksAndReset(void) {
+    DSP_CHAIN_CONFIG config;
+    PDSP_CHAIN chain;
+    PDSP_CHAIN chainB;
+    ULONG offset;
+    ULONG frames;
+    ULONG seed = 12345;
+
+    // Referencia: una sola llamada con la ruta escalar
+    InitFullChain(&config, SAMPLE_CONVERT_ISA_SCALAR);
+    chain = CreateChain(g_Memory, sizeof(g_Memory), &config);
+    if (chain == NULL) {
+        return FALSE;
+    }
+
+    FillPcm(g_Pcm);
+    DspChainProcess(chain, g_Pcm, TEST_FRAMES);
+
+    // La mejor ISA con llamadas de tamaño aleatorio da lo mismo
+    InitFullChain(&config, SampleConvertGetBestIsa());
+    chainB = CreateChain(g_MemoryB, sizeof(g_MemoryB), &config);
+    if (chainB == NULL) {
+        return FALSE;
+    }
+
+    FillPcm(g_PcmB);
+    for (offset = 0; offset < TEST_FRAMES; offset += frames) {
+        seed = seed * 1664525u + 1013904223u;
+        frames = min((seed >> 16) % 300 + 1, TEST_FRAMES - offset);
+        DspChainProcess(chainB, g_PcmB + (SIZE_T)offset * 2, frames);
+    }
+
+    if (memcmp(g_Pcm, g_PcmB, sizeof(SHORT) * TEST_FRAMES * 2) != 0) {
+        printf("   El resultado depende del tamaño de las llamadas o de la ISA\n");
+        return FALSE;
+    }
+
+    // Tras el reinicio se comporta como recién creada
+    DspChainReset(chainB);
+    FillPcm(g_PcmB);
+    DspChainProcess(chainB, g_PcmB, TEST_FRAMES);
+    if (memcmp(g_Pcm, g_PcmB, sizeof(SHORT) * TEST_FRAMES * 2) != 0 ||
+        chainB->FramesProcessed != 2 * TEST_FRAMES) {
+        printf("   El reinicio no devuelve la cadena al silencio\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ring_buffer.h"
+#include "mirror_buffer.h"
+
+// Contabilidad del anillo en frames completos para todas las combinaciones
+// de 16/24/32 bits y 1-8 canales (BlockAlign de 2 a 32 bytes).
+
+#define FRAME_RING_CAPACITY 64
+
+// Funciones de prueba
+BOOLEAN TestPartialWritesKeepWholeFrames(void);
+BOOLEAN TestFrameCountersAcrossWrap(void);
+BOOLEAN TestMirroredFrameLayouts(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 3;
+
+    printf("=== Iniciando pruebas de anillo alineado a frames ===\n\n");
+
+    printf("1. Prueba de escrituras parciales sin partir frames...\n");
+    if (TestPartialWritesKeepWholeFrames()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de contadores de frames de 64 bits en el wrap-around...\n");
+    if (TestFrameCountersAcrossWrap()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de anillo espejo con BlockAlign no potencia de dos...\n");
+    if (TestMirroredFrameLayouts()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+// Cada byte identifica su frame y su posición dentro del frame
+static UCHAR FrameByte(ULONG64 frame, ULONG byteIndex) {
+    return (UCHAR)(frame * 13 + byteIndex * 101);
+}
+
+static void FillFrames(PUCHAR data, ULONG64 firstFrame, ULONG frames, ULONG frameSize) {
+    ULONG f;
+    ULONG b;
+
+    for (f = 0; f < frames; f++) {
+        for (b = 0; b < frameSize; b++) {
+            data[f * frameSize + b] = FrameByte(firstFrame + f, b);
+        }
+    }
+}
+
+static BOOLEAN CheckFrames(const UCHAR *data, ULONG64 firstFrame, ULONG frames, ULONG frameSize) {
+    ULONG f;
+    ULONG b;
+
+    for (f = 0; f < frames; f++) {
+        for (b = 0; b < frameSize; b++) {
+            if (data[f * frameSize + b] != FrameByte(firstFrame + f, b)) {
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+// Escribe en paquetes de 7 frames hasta llenar y lee en bloques de 5
+static BOOLEAN ExerciseLayout(PRING_BUFFER ring, ULONG frameSize, ULONG rounds) {
+    UCHAR packet[7 * 32];
+    UCHAR output[5 * 32];
+    ULONG64 written = 0;
+    ULONG64 read = 0;
+    ULONG round;
+    ULONG n;
+
+    for (round = 0; round < rounds; round++) {
+        // Llenar: la última escritura se recorta a frames completos
+        do {
+            FillFrames(packet, written, 7, frameSize);
+            n = RingBufferWrite(ring, packet, 7);
+            if (n > 7) {
+                return FALSE;
+            }
+            written += n;
+        } while (n == 7);
+
+        if (RingBufferGetUsedFrames(ring) != ring->Capacity || RingBufferGetFreeFrames(ring) != 0) {
+            return FALSE;
+        }
+
+        // Vaciar casi por completo para mover la posición de wrap
+        while (RingBufferGetUsedFrames(ring) > 3) {
+            n = RingBufferRead(ring, output, 5);
+            if (!CheckFrames(output, read, n, frameSize)) {
+                return FALSE;
+            }
+            read += n;
+        }
+    }
+
+    // Los contadores son frames, no bytes
+    return ring->Head == written && ring->Tail == read;
+}
+
+BOOLEAN TestPartialWritesKeepWholeFrames(void) {
+    static const ULONG bitDepths[] = { 16, 24, 32 };
+    PUCHAR storage;
+    RING_BUFFER ring;
+    ULONG channels;
+    size_t i;
+    BOOLEAN result = TRUE;
+
+    storage = (PUCHAR)malloc(FRAME_RING_CAPACITY * 32);
+
+    for (i = 0; i < sizeof(bitDepths) / sizeof(bitDepths[0]) && result; i++) {
+        for (channels = 1; channels <= 8 && result; channels++) {
+            ULONG frameSize = channels * bitDepths[i] / 8;
+
+            if (!NT_SUCCESS(RingBufferInitialize(&ring, storage, FRAME_RING_CAPACITY, frameSize)) ||
+                ring.Size != FRAME_RING_CAPACITY * frameSize) {
+                result = FALSE;
+                break;
+            }
+
+            if (!ExerciseLayout(&ring, frameSize, 3)) {
+                printf("   Falla con %lu bits, %lu canales\n", (unsigned long)bitDepths[i], (unsigned long)channels);
+                result = FALSE;
+            }
+        }
+    }
+
+    free(storage);
+    return result;
+}
+
+BOOLEAN TestFrameCountersAcrossWrap(void) {
+    RING_BUFFER ring;
+    UCHAR storage[16 * 6];
+    UCHAR frames[10 * 6];
+    ULONG64 expected = 0;
+    ULONG i;
+
+    // 24 bits estéreo: 6 bytes por frame
+    RingBufferInitialize(&ring, storage, 16, 6);
+
+    for (i = 0; i < 1000; i++) {
+        FillFrames(frames, expected, 10, 6);
+        if (RingBufferWrite(&ring, frames, 10) != 10) {
+            return FALSE;
+        }
+        if (RingBufferRead(&ring, frames, 10) != 10 || !CheckFrames(frames, expected, 10, 6)) {
+            return FALSE;
+        }
+        expected += 10;
+    }
+
+    return ring.Head == expected && ring.Tail == expected;
+}
+
+BOOLEAN TestMirroredFrameLayouts(void) {
+    static const ULONG bitDepths[] = { 16, 24, 32 };
+    MIRROR_BUFFER mirror;
+    RING_BUFFER ring;
+    ULONG channels;
+    size_t i;
+    BOOLEAN result = TRUE;
+
+    for (i = 0; i < sizeof(bitDepths) / sizeof(bitDepths[0]) && result; i++) {
+        for (channels = 1; channels <= 8 && result; channels++) {
+            ULONG frameSize = channels * bitDepths[i] / 8;
+            // Igual que AllocateRingMemory: capacidad para que Size sea múltiplo de página
+            ULONG capacity = MirrorBufferGetGranularity() / (frameSize & (~frameSize + 1));
+
+            if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, capacity * frameSize))) {
+                return FALSE;
+            }
+
+            RingBufferInitializeMirrored(&ring, mirror.BaseAddress, capacity, frameSize);
+            result = ExerciseLayout(&ring, frameSize, 2);
+
+            MirrorBufferFree(&mirror);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,424 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fused_write.h"
+#include "mirror_buffer.h"
+
+#define TEST_RING_FRAMES  1024
+#define TEST_MAX_CHANNELS 8
+#define TEST_MAX_FRAMES   1400
+
+static const char *g_FormatNames[SAMPLE_FORMAT_COUNT] = { "int16", "int24", "int32", "float32" };
+
+static const SAMPLE_FORMAT g_Formats[] = { SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT32, SAMPLE_FORMAT_FLOAT32 };
+
+#define TEST_FORMAT_COUNT (sizeof(g_Formats) / sizeof(g_Formats[0]))
+
+// Paquetes que dejan colas de todos los tamaños y cruzan el final del anillo
+static const ULONG g_Packets[] = { 1, 7, 333, 480, 5, 1021, 64, 3 };
+
+#define TEST_PACKET_COUNT (sizeof(g_Packets) / sizeof(g_Packets[0]))
+
+static CHANNEL_MIX g_Mix;
+static UCHAR g_Source[TEST_MAX_FRAMES * TEST_MAX_CHANNELS * sizeof(float)];
+static UCHAR g_StorageStaged[TEST_RING_FRAMES * TEST_MAX_CHANNELS * sizeof(float)];
+static UCHAR g_StorageFused[TEST_RING_FRAMES * TEST_MAX_CHANNELS * sizeof(float)];
+
+// Funciones de prueba
+BOOLEAN TestSelection(void);
+BOOLEAN TestCopyMatchesStaged(void);
+BOOLEAN TestMixMatchesStaged(void);
+BOOLEAN TestPartialAndMirroredRing(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de la escritura fusionada ===\n\n");
+
+    printf("1. Prueba de selección de la especialización según la configuración...\n");
+    if (TestSelection()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de conversión con medidores idéntica a las etapas (formatos y canales)...\n");
+    if (TestCopyMatchesStaged()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de conversión y mezcla idéntica a las etapas (formas, formatos y medidores)...\n");
+    if (TestMixMatchesStaged()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de escritura parcial con el anillo casi lleno y en modo espejo...\n");
+    if (TestPartialAndMirroredRing()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+// Ruido con valores a fondo de escala (saturaciones) y, en float, fuera de rango
+static void FillSource(SAMPLE_FORMAT format, ULONG samples)
+{
+    ULONG seed = 12345;
+    ULONG i;
+    LONG value;
+
+    for (i = 0; i < samples; i++) {
+        seed = seed * 1664525 + 1013904223;
+        value = (LONG)seed;
+
+        switch (format) {
+            case SAMPLE_FORMAT_INT16:
+                ((SHORT *)g_Source)[i] = (i % 37 == 0) ? -32768 : (i % 41 == 0) ? 32767 : (SHORT)(value >> 16);
+                break;
+            case SAMPLE_FORMAT_INT32:
+                ((LONG *)g_Source)[i] = (i % 37 == 0) ? (LONG)0x80000000 : (i % 41 == 0) ? 0x7FFFFFFF : value;
+                break;
+            default:
+                ((float *)g_Source)[i] = (i % 37 == 0) ? -1.25f : (i % 41 == 0) ? 1.0f : (float)value / 2147483648.0f;
+                break;
+        }
+    }
+}
+
+static NTSTATUS InitializeMix(ULONG inputs, ULONG outputs, SAMPLE_FORMAT source, SAMPLE_FORMAT target)
+{
+    CHANNEL_MIX_CONFIG config;
+    ULONG output;
+    ULONG input;
+
+    memset(&config, 0, sizeof(config));
+    config.InputChannels = inputs;
+    config.OutputChannels = outputs;
+    config.SourceFormat = source;
+    config.TargetFormat = target;
+    config.Preset = CHANNEL_MIX_PRESET_CUSTOM;
+    config.Isa = SampleConvertGetBestIsa();
+
+    // Ganancias distintas por coeficiente, algunas por encima de 1 para saturar
+    for (output = 0; output < outputs; output++) {
+        for (input = 0; input < inputs; input++) {
+            config.Matrix[output][input] = 0.3f + 0.4f * (float)((output * 3 + input * 5) % 7) / 6.0f;
+        }
+    }
+
+    return ChannelMixInitialize(&g_Mix, &config);
+}
+
+// Lo que hace la escritura por etapas del driver: escribir y medir lo escrito
+static ULONG WriteStaged(PRING_BUFFER ring, const SAMPLE_CONVERTER *converter, PCHANNEL_MIX mix,
+                         PLEVEL_METER meter, const VOID *source, ULONG frames)
+{
+    ULONG64 head = ring->Head;
+    ULONG written;
+
+    if (mix != NULL) {
+        written = ChannelMixWriteRing(mix, NULL, ring, source, frames);
+    } else {
+        written = SampleConvertWriteRing(ring, converter, source, frames);
+    }
+
+    if (meter != NULL) {
+        LevelMeterProcessRing(meter, ring, head, written);
+    }
+
+    return written;
+}
+
+// Escribe la misma secuencia de paquetes por los dos caminos (vaciando el
+// anillo entre paquetes) y compara anillo, frames escritos y medidor
+static BOOLEAN CompareWithStaged(const SAMPLE_CONVERTER *converter, PCHANNEL_MIX mix, BOOLEAN metering,
+                                 SAMPLE_FORMAT target, ULONG channels, ULONG sourceFrameSize)
+{
+    RING_BUFFER staged;
+    RING_BUFFER fused;
+    LEVEL_METER stagedMeter;
+    LEVEL_METER fusedMeter;
+    FUSED_WRITE write;
+    ULONG frameSize = SampleFormatGetBytes(target) * channels;
+    ULONG offset = 0;
+    ULONG packet;
+    ULONG expected;
+
+    // Los medidores se comparan enteros: también el relleno
+    memset(&stagedMeter, 0, sizeof(stagedMeter));
+    memset(&fusedMeter, 0, sizeof(fusedMeter));
+    memset(g_StorageStaged, 0, sizeof(g_StorageStaged));
+    memset(g_StorageFused, 0, sizeof(g_StorageFused));
+    RingBufferInitialize(&staged, g_StorageStaged, TEST_RING_FRAMES, frameSize);
+    RingBufferInitialize(&fused, g_StorageFused, TEST_RING_FRAMES, frameSize);
+    LevelMeterInitialize(&stagedMeter, target, channels, SampleConvertGetBestIsa());
+    LevelMeterInitialize(&fusedMeter, target, channels, SampleConvertGetBestIsa());
+
+    if (!FusedWriteSelect(&write, converter, mix, metering ? &fusedMeter : NULL, SampleConvertGetBestIsa())) {
+        printf("   Sin especialización\n");
+        return FALSE;
+    }
+
+    for (packet = 0; packet < TEST_PACKET_COUNT; packet++) {
+        expected = WriteStaged(&staged, converter, mix, metering ? &stagedMeter : NULL,
+                               g_Source + (SIZE_T)offset * sourceFrameSize, g_Packets[packet]);
+        if (FusedWriteRing(&write, &fused, g_Source + (SIZE_T)offset * sourceFrameSize, g_Packets[packet]) != expected ||
+            expected != g_Packets[packet]) {
+            printf("   Frames escritos distintos en el paquete %u\n", packet);
+            return FALSE;
+        }
+
+        offset += g_Packets[packet] % 97;
+        RingBufferDiscard(&staged, expected);
+        RingBufferDiscard(&fused, expected);
+    }
+
+    if (memcmp(g_StorageStaged, g_StorageFused, (SIZE_T)TEST_RING_FRAMES * frameSize) != 0 ||
+        staged.Head != fused.Head) {
+        printf("   El anillo difiere\n");
+        return FALSE;
+    }
+
+    if (metering && memcmp(&stagedMeter, &fusedMeter, sizeof(LEVEL_METER)) != 0) {
+        printf("   El medidor difiere\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestSelection(void) {
+    SAMPLE_CONVERTER converter;
+    SAMPLE_CONVERTER int24;
+    LEVEL_METER meter;
+    LEVEL_METER scalarMeter;
+    FUSED_WRITE write;
+    SAMPLE_CONVERT_ISA isa = SampleConvertGetBestIsa();
+
+    if (isa == SAMPLE_CONVERT_ISA_SCALAR) {
+        printf("   CPU sin SSE2: nada que fusionar\n");
+        return TRUE;
+    }
+
+    SampleConverterInitialize(&converter, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_FLOAT32, 2, isa);
+    LevelMeterInitialize(&meter, SAMPLE_FORMAT_FLOAT32, 2, isa);
+    LevelMeterInitialize(&scalarMeter, SAMPLE_FORMAT_FLOAT32, 2, SAMPLE_CONVERT_ISA_SCALAR);
+
+    // Conversión con medidores: sí; sin medidores ya es una sola pasada
+    if (!FusedWriteSelect(&write, &converter, NULL, &meter, isa) || write.GroupFrames != 4 ||
+        write.Shape != FUSED_WRITE_SHAPE_COPY) {
+        return FALSE;
+    }
+
+    if (FusedWriteSelect(&write, &converter, NULL, NULL, isa)) {
+        return FALSE;
+    }
+
+    // Escalar forzado, medidor escalar o medidor de otro formato
+    if (FusedWriteSelect(&write, &converter, NULL, &meter, SAMPLE_CONVERT_ISA_SCALAR) ||
+        FusedWriteSelect(&write, &converter, NULL, &scalarMeter, isa)) {
+        return FALSE;
+    }
+
+    LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 2, isa);
+    if (FusedWriteSelect(&write, &converter, NULL, &meter, isa)) {
+        return FALSE;
+    }
+
+    // int24 en cualquier extremo y canales que no reparten los carriles
+    SampleConverterInitialize(&int24, SAMPLE_FORMAT_INT24, SAMPLE_FORMAT_INT16, 2, isa);
+    LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 2, isa);
+    if (FusedWriteSelect(&write, &int24, NULL, &meter, isa)) {
+        return FALSE;
+    }
+
+    SampleConverterInitialize(&converter, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT16, 6, isa);
+    LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 6, isa);
+    if (FusedWriteSelect(&write, &converter, NULL, &meter, isa)) {
+        return FALSE;
+    }
+
+    // Formas de mezcla con núcleo (con y sin medidores) y sin él
+    if (!NT_SUCCESS(InitializeMix(6, 2, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_FLOAT32)) ||
+        !FusedWriteSelect(&write, &converter, &g_Mix, NULL, isa) ||
+        write.Shape != FUSED_WRITE_SHAPE_SURROUND51_TO_STEREO || write.GroupFrames != 4 ||
+        write.SourceFrameSize != 12 || write.TargetFrameSize != 8) {
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(InitializeMix(2, 1, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_INT32)) ||
+        !FusedWriteSelect(&write, &converter, &g_Mix, NULL, isa) || write.GroupFrames != 8) {
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(InitializeMix(2, 2, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT16)) ||
+        FusedWriteSelect(&write, &converter, &g_Mix, NULL, isa)) {
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(InitializeMix(1, 2, SAMPLE_FORMAT_INT24, SAMPLE_FORMAT_INT16)) ||
+        FusedWriteSelect(&write, &converter, &g_Mix, NULL, isa)) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestCopyMatchesStaged(void) {
+    static const ULONG channelCounts[] = { 1, 2, 4, 8 };
+    SAMPLE_CONVERTER converter;
+    SAMPLE_CONVERT_ISA isa = SampleConvertGetBestIsa();
+    ULONG source;
+    ULONG target;
+    ULONG k;
+
+    if (isa == SAMPLE_CONVERT_ISA_SCALAR) {
+        return TRUE;
+    }
+
+    for (source = 0; source < TEST_FORMAT_COUNT; source++) {
+        FillSource(g_Formats[source], TEST_MAX_FRAMES * TEST_MAX_CHANNELS);
+
+        for (target = 0; target < TEST_FORMAT_COUNT; target++) {
+            for (k = 0; k < sizeof(channelCounts) / sizeof(channelCounts[0]); k++) {
+                SampleConverterInitialize(&converter, g_Formats[source], g_Formats[target], channelCounts[k], isa);
+                if (!CompareWithStaged(&converter, NULL, TRUE, g_Formats[target], channelCounts[k],
+                                       converter.SourceFrameSize)) {
+                    printf("   %s -> %s, %u canales\n", g_FormatNames[g_Formats[source]],
+                           g_FormatNames[g_Formats[target]], channelCounts[k]);
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestMixMatchesStaged(void) {
+    static const ULONG shapes[][2] = { { 1, 2 }, { 2, 1 }, { 6, 2 }, { 8, 2 } };
+    SAMPLE_CONVERTER converter;
+    SAMPLE_CONVERT_ISA isa = SampleConvertGetBestIsa();
+    ULONG shape;
+    ULONG source;
+    ULONG target;
+    ULONG metering;
+
+    if (isa == SAMPLE_CONVERT_ISA_SCALAR) {
+        return TRUE;
+    }
+
+    // Con mezcla el conversor de la escritura no se usa
+    SampleConverterInitialize(&converter, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT16, 2, isa);
+
+    for (source = 0; source < TEST_FORMAT_COUNT; source++) {
+        FillSource(g_Formats[source], TEST_MAX_FRAMES * TEST_MAX_CHANNELS);
+
+        for (shape = 0; shape < sizeof(shapes) / sizeof(shapes[0]); shape++) {
+            for (target = 0; target < TEST_FORMAT_COUNT; target++) {
+                if (!NT_SUCCESS(InitializeMix(shapes[shape][0], shapes[shape][1], g_Formats[source], g_Formats[target]))) {
+                    return FALSE;
+                }
+
+                for (metering = 0; metering < 2; metering++) {
+                    if (!CompareWithStaged(&converter, &g_Mix, (BOOLEAN)metering, g_Formats[target], shapes[shape][1],
+                                           g_Mix.Decoder.SourceFrameSize)) {
+                        printf("   %u->%u, %s -> %s, medidores %u\n", shapes[shape][0], shapes[shape][1],
+                               g_FormatNames[g_Formats[source]], g_FormatNames[g_Formats[target]], metering);
+                        return FALSE;
+                    }
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestPartialAndMirroredRing(void) {
+    SAMPLE_CONVERT_ISA isa = SampleConvertGetBestIsa();
+    MIRROR_BUFFER mirror;
+    RING_BUFFER ring;
+    RING_BUFFER reference;
+    LEVEL_METER meter;
+    LEVEL_METER referenceMeter;
+    FUSED_WRITE write;
+    ULONG size = MirrorBufferGetGranularity() * 2;
+    ULONG frameSize = 2 * sizeof(SHORT);
+    ULONG capacity = size / frameSize;
+    ULONG written;
+    BOOLEAN result = TRUE;
+
+    if (isa == SAMPLE_CONVERT_ISA_SCALAR) {
+        return TRUE;
+    }
+
+    FillSource(SAMPLE_FORMAT_FLOAT32, TEST_MAX_FRAMES);
+    if (!NT_SUCCESS(InitializeMix(1, 2, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_INT16))) {
+        return FALSE;
+    }
+
+    memset(&meter, 0, sizeof(meter));
+    memset(&referenceMeter, 0, sizeof(referenceMeter));
+
+    // Anillo normal casi lleno: solo entra lo que cabe, como en la mezcla por etapas
+    RingBufferInitialize(&reference, g_StorageStaged, TEST_RING_FRAMES, frameSize);
+    RingBufferInitialize(&ring, g_StorageFused, TEST_RING_FRAMES, frameSize);
+    LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 2, isa);
+    LevelMeterInitialize(&referenceMeter, SAMPLE_FORMAT_INT16, 2, isa);
+    FusedWriteSelect(&write, NULL, &g_Mix, &meter, isa);
+
+    WriteStaged(&reference, NULL, &g_Mix, &referenceMeter, g_Source, TEST_RING_FRAMES - 13);
+    FusedWriteRing(&write, &ring, g_Source, TEST_RING_FRAMES - 13);
+    written = FusedWriteRing(&write, &ring, g_Source, 100);
+    if (written != 13 || WriteStaged(&reference, NULL, &g_Mix, &referenceMeter, g_Source, 100) != written ||
+        FusedWriteRing(&write, &ring, g_Source, 100) != 0 ||
+        memcmp(g_StorageStaged, g_StorageFused, (SIZE_T)TEST_RING_FRAMES * frameSize) != 0 ||
+        memcmp(&meter, &referenceMeter, sizeof(LEVEL_METER)) != 0) {
+        printf("   La escritura parcial difiere\n");
+        return FALSE;
+    }
+
+    // Modo espejo: un solo tramo aunque cruce el final
+    if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, size))) {
+        return FALSE;
+    }
+
+    RingBufferInitializeMirrored(&ring, mirror.BaseAddress, capacity, frameSize);
+    RingBufferInitialize(&reference, g_StorageStaged, capacity, frameSize);
+    LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 2, isa);
+    LevelMeterInitialize(&referenceMeter, SAMPLE_FORMAT_INT16, 2, isa);
+    FusedWriteSelect(&write, NULL, &g_Mix, &meter, isa);
+
+    RingBufferWrite(&ring, g_StorageFused, capacity - 5);
+    RingBufferDiscard(&ring, capacity - 5);
+    FusedWriteRing(&write, &ring, g_Source, 1001);
+    WriteStaged(&reference, NULL, &g_Mix, NULL, g_Source, 1001);
+    LevelMeterProcess(&referenceMeter, g_StorageStaged, 1001);
+
+    if (ring.Head != capacity + 996 ||
+        memcmp(mirror.BaseAddress + (SIZE_T)(capacity - 5) * frameSize, g_StorageStaged, (SIZE_T)1001 * frameSize) != 0 ||
+        memcmp(&meter, &referenceMeter, sizeof(LEVEL_METER)) != 0) {
+        printf("   El anillo en modo espejo difiere\n");
+        result = FALSE;
+    }
+
+    MirrorBufferFree(&mirror);
+    return result;
+}
@@ -0,0 +1,338 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "gain_ramp.h"
+
+#define TEST_FRAMES      2048
+#define TEST_MAX_CHANNELS 8
+
+static UCHAR g_Input[TEST_FRAMES * TEST_MAX_CHANNELS * sizeof(LONG)];
+static UCHAR g_Output[TEST_FRAMES * TEST_MAX_CHANNELS * sizeof(LONG)];
+static UCHAR g_OutputB[TEST_FRAMES * TEST_MAX_CHANNELS * sizeof(LONG)];
+static float g_Samples[TEST_FRAMES * 2];
+
+// Funciones de prueba
+BOOLEAN TestStateAndValidation(void);
+BOOLEAN TestRampContinuity(void);
+BOOLEAN TestIntegerRoundingAndBlocks(void);
+BOOLEAN TestVectorMatchesScalar(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de la rampa de ganancia ===\n\n");
+
+    printf("1. Prueba de estados estables y validación de ganancias...\n");
+    if (TestStateAndValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de continuidad de la rampa (silencio, vuelta y cambio a mitad)...\n");
+    if (TestRampContinuity()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de redondeo y saturación en enteros e independencia del bloque...\n");
+    if (TestIntegerRoundingAndBlocks()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de núcleos SSE2 idénticos al escalar...\n");
+    if (TestVectorMatchesScalar()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestStateAndValidation(void) {
+    GAIN_RAMP ramp;
+    float nan = (float)NAN;
+
+    if (GainRampInitialize(&ramp, -0.5f, SAMPLE_CONVERT_ISA_SCALAR) != STATUS_INVALID_PARAMETER ||
+        GainRampInitialize(&ramp, 16.5f, SAMPLE_CONVERT_ISA_SCALAR) != STATUS_INVALID_PARAMETER ||
+        GainRampInitialize(&ramp, nan, SAMPLE_CONVERT_ISA_SCALAR) != STATUS_INVALID_PARAMETER ||
+        !GainRampIsValidGain(0.0f) || !GainRampIsValidGain(GAIN_RAMP_MAX_GAIN)) {
+        printf("   Validación de ganancias incorrecta\n");
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(GainRampInitialize(&ramp, 1.0f, SAMPLE_CONVERT_ISA_SCALAR)) ||
+        !GainRampIsUnity(&ramp) || GainRampIsSilent(&ramp)) {
+        return FALSE;
+    }
+
+    // Durante la rampa no hay estado estable; al terminar, sí
+    GainRampSetTarget(&ramp, 0.0f, 4);
+    if (GainRampIsUnity(&ramp) || GainRampIsSilent(&ramp) || GainRampGetCurrent(&ramp) != 1.0f) {
+        return FALSE;
+    }
+
+    memset(g_Samples, 0, sizeof(g_Samples));
+    GainRampApply(&ramp, SAMPLE_FORMAT_FLOAT32, 2, g_Samples, 4);
+    if (!GainRampIsSilent(&ramp) || GainRampGetCurrent(&ramp) != 0.0f) {
+        printf("   La rampa no termina en silencio estable\n");
+        return FALSE;
+    }
+
+    // Cero frames: cambio inmediato; la misma ganancia no abre rampa
+    GainRampSetTarget(&ramp, 1.0f, 0);
+    if (!GainRampIsUnity(&ramp)) {
+        return FALSE;
+    }
+
+    GainRampSetTarget(&ramp, 1.0f, 480);
+    if (!GainRampIsUnity(&ramp)) {
+        return FALSE;
+    }
+
+    // Las rampas más largas se acortan al máximo
+    GainRampSetTarget(&ramp, 0.0f, GAIN_RAMP_MAX_FRAMES * 2);
+    if (ramp.Length != GAIN_RAMP_MAX_FRAMES) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Aplica la rampa a unos (estéreo float) en bloques irregulares y comprueba
+// que la ganancia de cada frame difiere de la anterior como mucho MaxStep
+static BOOLEAN RunContinuity(PGAIN_RAMP ramp, ULONG frames, float *previous, float maxStep) {
+    static const ULONG blocks[] = { 1, 7, 64, 3, 129, 480, 2 };
+    ULONG done = 0;
+    ULONG block = 0;
+    ULONG count;
+    ULONG i;
+
+    for (i = 0; i < frames * 2; i++) {
+        g_Samples[i] = 1.0f;
+    }
+
+    while (done < frames) {
+        count = blocks[block++ % (sizeof(blocks) / sizeof(blocks[0]))];
+        count = (count < frames - done) ? count : frames - done;
+        GainRampApply(ramp, SAMPLE_FORMAT_FLOAT32, 2, g_Samples + done * 2, count);
+        done += count;
+    }
+
+    for (i = 0; i < frames; i++) {
+        if (g_Samples[i * 2] != g_Samples[i * 2 + 1]) {
+            printf("   Frame %u: canales con ganancias distintas\n", i);
+            return FALSE;
+        }
+
+        if (fabsf(g_Samples[i * 2] - *previous) > maxStep) {
+            printf("   Frame %u: salto de %g (máximo %g)\n", i, fabsf(g_Samples[i * 2] - *previous), maxStep);
+            return FALSE;
+        }
+
+        *previous = g_Samples[i * 2];
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestRampContinuity(void) {
+    GAIN_RAMP ramp;
+    float previous = 1.0f;
+    float step;
+    ULONG i;
+
+    if (!NT_SUCCESS(GainRampInitialize(&ramp, 1.0f, SampleConvertGetBestIsa()))) {
+        return FALSE;
+    }
+
+    // Silencio en 480 frames: saltos de 1/480 y después cero exacto
+    step = 1.0f / 480.0f;
+    GainRampSetTarget(&ramp, 0.0f, 480);
+    if (!RunContinuity(&ramp, 600, &previous, step * 1.001f)) {
+        return FALSE;
+    }
+
+    for (i = 1; i < 480; i++) {
+        if (g_Samples[i * 2] > g_Samples[(i - 1) * 2]) {
+            printf("   La rampa de bajada no es monótona\n");
+            return FALSE;
+        }
+    }
+
+    if (g_Samples[0] >= 1.0f || g_Samples[599 * 2] != 0.0f || !GainRampIsSilent(&ramp)) {
+        return FALSE;
+    }
+
+    // Vuelta hacia 0,5 y, a mitad, nuevo destino 2: se parte de la ganancia
+    // alcanzada, sin saltos mayores que el paso de la rampa más rápida
+    GainRampSetTarget(&ramp, 0.5f, 100);
+    if (!RunContinuity(&ramp, 37, &previous, 0.005f * 1.001f)) {
+        return FALSE;
+    }
+
+    step = (2.0f - GainRampGetCurrent(&ramp)) / 200.0f;
+    GainRampSetTarget(&ramp, 2.0f, 200);
+    if (!RunContinuity(&ramp, 300, &previous, step * 1.001f)) {
+        return FALSE;
+    }
+
+    // Fuera de la rampa la ganancia es exactamente la pedida
+    if (g_Samples[299 * 2] != 2.0f || ramp.Length != 0) {
+        printf("   La rampa no termina en la ganancia pedida\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestIntegerRoundingAndBlocks(void) {
+    GAIN_RAMP ramp;
+    GAIN_RAMP rampB;
+    LONG int32[4] = { 0x7FFFFFFF, 0x40000000, (LONG)0x80000000UL, 3 };
+    SHORT int16[4] = { 32767, -32768, 3, -3 };
+    UCHAR int24[6] = { 0xFF, 0xFF, 0x7F, 0x01, 0x00, 0x80 }; // 8388607, -8388607
+    ULONG done;
+    ULONG count;
+    ULONG i;
+
+    // int32 en double: 0x7FFFFFFF / 2 = 1073741823,5 redondea al par
+    GainRampInitialize(&ramp, 0.5f, SAMPLE_CONVERT_ISA_SCALAR);
+    GainRampApply(&ramp, SAMPLE_FORMAT_INT32, 4, int32, 1);
+    if (int32[0] != 1073741824 || int32[1] != 0x20000000 || int32[2] != (LONG)0xC0000000UL || int32[3] != 2) {
+        printf("   Redondeo int32 incorrecto\n");
+        return FALSE;
+    }
+
+    // Saturación en cada formato entero
+    GainRampInitialize(&ramp, 4.0f, SAMPLE_CONVERT_ISA_SCALAR);
+    GainRampApply(&ramp, SAMPLE_FORMAT_INT32, 4, int32, 1);
+    GainRampApply(&ramp, SAMPLE_FORMAT_INT16, 4, int16, 1);
+    GainRampApply(&ramp, SAMPLE_FORMAT_INT24, 2, int24, 1);
+    if (int32[0] != 0x7FFFFFFF || int32[2] != (LONG)0x80000000UL ||
+        int16[0] != 32767 || int16[1] != -32768 || int16[2] != 12 || int16[3] != -12 ||
+        int24[0] != 0xFF || int24[1] != 0xFF || int24[2] != 0x7F ||
+        int24[3] != 0x00 || int24[4] != 0x00 || int24[5] != 0x80) {
+        printf("   Saturación incorrecta\n");
+        return FALSE;
+    }
+
+    // La salida no depende de cómo se trocee la lectura
+    srand(7);
+    for (i = 0; i < sizeof(g_Input); i++) {
+        g_Input[i] = (UCHAR)rand();
+    }
+
+    GainRampInitialize(&ramp, 0.25f, SampleConvertGetBestIsa());
+    GainRampInitialize(&rampB, 0.25f, SampleConvertGetBestIsa());
+    GainRampSetTarget(&ramp, 1.5f, 1000);
+    GainRampSetTarget(&rampB, 1.5f, 1000);
+
+    memcpy(g_Output, g_Input, TEST_FRAMES * 2 * sizeof(SHORT));
+    memcpy(g_OutputB, g_Input, TEST_FRAMES * 2 * sizeof(SHORT));
+    GainRampApply(&ramp, SAMPLE_FORMAT_INT16, 2, g_Output, TEST_FRAMES);
+
+    for (done = 0; done < TEST_FRAMES; done += count) {
+        count = 1 + (ULONG)rand() % 97;
+        count = (count < TEST_FRAMES - done) ? count : TEST_FRAMES - done;
+        GainRampApply(&rampB, SAMPLE_FORMAT_INT16, 2, g_OutputB + done * 2 * sizeof(SHORT), count);
+    }
+
+    if (memcmp(g_Output, g_OutputB, TEST_FRAMES * 2 * sizeof(SHORT)) != 0) {
+        printf("   El resultado depende del tamaño de bloque\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestVectorMatchesScalar(void) {
+    static const float gains[][2] = { { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.3f, 16.0f }, { 16.0f, 0.7f } };
+    GAIN_RAMP scalar;
+    GAIN_RAMP sse2;
+    SAMPLE_FORMAT format;
+    SIZE_T bytes;
+    ULONG channels;
+    ULONG frames;
+    ULONG gain;
+    ULONG position;
+    ULONG i;
+
+    if (!SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)) {
+        printf("   (sin SSE2: solo la referencia escalar)\n");
+        return TRUE;
+    }
+
+    srand(13);
+    for (format = SAMPLE_FORMAT_INT16; format < SAMPLE_FORMAT_COUNT; format++) {
+        // Los enteros con bytes aleatorios incluyen los extremos de escala
+        if (format == SAMPLE_FORMAT_FLOAT32) {
+            for (i = 0; i < sizeof(g_Input) / sizeof(float); i++) {
+                ((float *)g_Input)[i] = (float)rand() / RAND_MAX * 4.0f - 2.0f;
+            }
+        } else {
+            for (i = 0; i < sizeof(g_Input); i++) {
+                g_Input[i] = (UCHAR)rand();
+            }
+        }
+
+        for (channels = 1; channels <= TEST_MAX_CHANNELS; channels++) {
+            bytes = (SIZE_T)SampleFormatGetBytes(format) * channels;
+
+            for (gain = 0; gain < sizeof(gains) / sizeof(gains[0]); gain++) {
+                // Rampa empezada en distintas posiciones, con y sin cola, y
+                // lecturas que cruzan el final de la rampa
+                for (position = 0; position < 3; position++) {
+                    for (frames = 0; frames <= 37; frames++) {
+                        GainRampInitialize(&scalar, gains[gain][0], SAMPLE_CONVERT_ISA_SCALAR);
+                        GainRampInitialize(&sse2, gains[gain][0], SAMPLE_CONVERT_ISA_SSE2);
+                        GainRampSetTarget(&scalar, gains[gain][1], 20 + position);
+                        GainRampSetTarget(&sse2, gains[gain][1], 20 + position);
+
+                        memcpy(g_Output, g_Input, bytes * (position + frames));
+                        memcpy(g_OutputB, g_Input, bytes * (position + frames));
+                        GainRampApply(&scalar, format, channels, g_Output, position);
+                        GainRampApply(&sse2, format, channels, g_OutputB, position);
+                        GainRampApply(&scalar, format, channels, g_Output + bytes * position, frames);
+                        GainRampApply(&sse2, format, channels, g_OutputB + bytes * position, frames);
+
+                        if (memcmp(g_Output, g_OutputB, bytes * (position + frames)) != 0 ||
+                            memcmp(&scalar.Start, &sse2.Start, FIELD_OFFSET(GAIN_RAMP, Isa)) != 0) {
+                            printf("   Formato %u, %u canales, %u frames: SSE2 difiere\n",
+                                   format, channels, frames);
+                            return FALSE;
+                        }
+                    }
+                }
+
+                // Ganancia constante en un bloque largo
+                GainRampInitialize(&scalar, gains[gain][1], SAMPLE_CONVERT_ISA_SCALAR);
+                GainRampInitialize(&sse2, gains[gain][1], SAMPLE_CONVERT_ISA_SSE2);
+                memcpy(g_Output, g_Input, bytes * TEST_FRAMES);
+                memcpy(g_OutputB, g_Input, bytes * TEST_FRAMES);
+                GainRampApply(&scalar, format, channels, g_Output, TEST_FRAMES);
+                GainRampApply(&sse2, format, channels, g_OutputB, TEST_FRAMES);
+                if (memcmp(g_Output, g_OutputB, bytes * TEST_FRAMES) != 0) {
+                    return FALSE;
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
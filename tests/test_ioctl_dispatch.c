@@ -0,0 +1,296 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "ioctl_dispatch.h"
+
+// CTL_CODE(FILE_DEVICE_UNKNOWN, Function, Method, FILE_ANY_ACCESS)
+#define TEST_CTL_CODE(function, method) ((0x22UL << 16) | ((ULONG)(function) << 2) | (method))
+
+#define TEST_IOCTL_SEND    TEST_CTL_CODE(0x800, 0)
+#define TEST_IOCTL_STATS   TEST_CTL_CODE(0x802, 0)
+#define TEST_IOCTL_PEND    TEST_CTL_CODE(0x805, 0)
+#define TEST_IOCTL_SLOW    TEST_CTL_CODE(0x81F, 0)
+
+#define STRESS_THREADS 4
+#define STRESS_CALLS   100000
+
+// IRP falso: el handler decide el resultado
+struct _DEVICE_OBJECT {
+    volatile ULONG64 Handled;
+};
+
+struct _IRP {
+    NTSTATUS Result;
+    ULONG_PTR Information;
+};
+
+// Funciones de prueba
+BOOLEAN TestDispatcherInitialize(void);
+BOOLEAN TestDispatcherLookup(void);
+BOOLEAN TestDispatcherAccounting(void);
+BOOLEAN TestDispatcherTiming(void);
+BOOLEAN TestDispatcherConcurrent(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas del despacho de IOCTL ===\n\n");
+
+    printf("1. Prueba de validación de la tabla...\n");
+    if (TestDispatcherInitialize()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de búsqueda por código...\n");
+    if (TestDispatcherLookup()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de llamadas, errores, pendientes y bytes...\n");
+    if (TestDispatcherAccounting()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de tiempo total y máximo...\n");
+    if (TestDispatcherTiming()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de llamadas concurrentes...\n");
+    if (TestDispatcherConcurrent()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+static NTSTATUS FakeHandler(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    __atomic_add_fetch(&DeviceObject->Handled, 1, __ATOMIC_RELAXED);
+    return Irp->Result;
+}
+
+// Unos 2 ms de trabajo
+static NTSTATUS SlowHandler(struct _DEVICE_OBJECT *DeviceObject, struct _IRP *Irp)
+{
+    struct timespec delay = { 0, 2000000 };
+
+    nanosleep(&delay, NULL);
+    return FakeHandler(DeviceObject, Irp);
+}
+
+static const IOCTL_DISPATCH_ENTRY g_Table[] = {
+    { TEST_IOCTL_SEND,  FakeHandler },
+    { TEST_IOCTL_STATS, FakeHandler },
+    { TEST_IOCTL_PEND,  FakeHandler },
+    { TEST_IOCTL_SLOW,  SlowHandler }
+};
+
+#define TEST_TABLE_ENTRIES (sizeof(g_Table) / sizeof(g_Table[0]))
+
+static IOCTL_DISPATCHER g_Dispatcher;
+
+static NTSTATUS Dispatch(struct _DEVICE_OBJECT *Device, ULONG Code, NTSTATUS Result, ULONG InputLength, ULONG_PTR Information)
+{
+    const IOCTL_DISPATCH_ENTRY *entry = IoctlDispatcherLookup(&g_Dispatcher, Code);
+    struct _IRP irp;
+
+    if (entry == NULL) {
+        return STATUS_INVALID_DEVICE_REQUEST;
+    }
+
+    irp.Result = Result;
+    irp.Information = Information;
+    return IoctlDispatcherCall(&g_Dispatcher, entry, Device, &irp, InputLength, &irp.Information);
+}
+
+BOOLEAN TestDispatcherInitialize(void) {
+    IOCTL_DISPATCH_ENTRY entries[IOCTL_DISPATCH_MAX_ENTRIES + 1];
+    ULONG i;
+
+    for (i = 0; i <= IOCTL_DISPATCH_MAX_ENTRIES; i++) {
+        entries[i].IoControlCode = TEST_CTL_CODE(0x800 + i, 0);
+        entries[i].Handler = FakeHandler;
+    }
+
+    // Las 32 funciones caben; una más no
+    if (!NT_SUCCESS(IoctlDispatcherInitialize(&g_Dispatcher, entries, IOCTL_DISPATCH_MAX_ENTRIES)) ||
+        IoctlDispatcherInitialize(&g_Dispatcher, entries, IOCTL_DISPATCH_MAX_ENTRIES + 1) != STATUS_INVALID_PARAMETER ||
+        IoctlDispatcherInitialize(&g_Dispatcher, NULL, 0) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    // Función repetida (aunque cambie el método), fuera de rango o sin handler
+    entries[1].IoControlCode = TEST_CTL_CODE(0x800, 2);
+    if (IoctlDispatcherInitialize(&g_Dispatcher, entries, 2) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    entries[1].IoControlCode = TEST_CTL_CODE(0x7FF, 0);
+    if (IoctlDispatcherInitialize(&g_Dispatcher, entries, 2) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    entries[1].IoControlCode = TEST_CTL_CODE(0x801, 0);
+    entries[1].Handler = NULL;
+    if (IoctlDispatcherInitialize(&g_Dispatcher, entries, 2) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    // Un fallo no deja entradas a medias
+    return g_Dispatcher.EntryCount == 0 && g_Dispatcher.Index[0] == 0;
+}
+
+BOOLEAN TestDispatcherLookup(void) {
+    if (!NT_SUCCESS(IoctlDispatcherInitialize(&g_Dispatcher, g_Table, TEST_TABLE_ENTRIES))) {
+        return FALSE;
+    }
+
+    if (IoctlDispatcherLookup(&g_Dispatcher, TEST_IOCTL_SEND) != &g_Table[0] ||
+        IoctlDispatcherLookup(&g_Dispatcher, TEST_IOCTL_SLOW) != &g_Table[3] ||
+        g_Dispatcher.UnknownCalls != 0) {
+        return FALSE;
+    }
+
+    // Función sin handler, con otro método o acceso, de otro dispositivo o fuera de rango
+    return IoctlDispatcherLookup(&g_Dispatcher, TEST_CTL_CODE(0x801, 0)) == NULL &&
+           IoctlDispatcherLookup(&g_Dispatcher, TEST_CTL_CODE(0x800, 2)) == NULL &&
+           IoctlDispatcherLookup(&g_Dispatcher, TEST_IOCTL_SEND | (1 << 14)) == NULL &&
+           IoctlDispatcherLookup(&g_Dispatcher, TEST_IOCTL_SEND & 0xFFFF) == NULL &&
+           IoctlDispatcherLookup(&g_Dispatcher, TEST_CTL_CODE(0x820, 0)) == NULL &&
+           IoctlDispatcherLookup(&g_Dispatcher, TEST_CTL_CODE(0x000, 0)) == NULL &&
+           g_Dispatcher.UnknownCalls == 6;
+}
+
+BOOLEAN TestDispatcherAccounting(void) {
+    struct _DEVICE_OBJECT device = { 0 };
+    IOCTL_STATS_HEADER header;
+    IOCTL_CALL_STATS stats[TEST_TABLE_ENTRIES];
+    ULONG i;
+
+    IoctlDispatcherInitialize(&g_Dispatcher, g_Table, TEST_TABLE_ENTRIES);
+
+    // 10 envíos: 8 bien (Information cuenta) y 2 con error (no cuenta)
+    for (i = 0; i < 10; i++) {
+        if (Dispatch(&device, TEST_IOCTL_SEND, (i < 8) ? STATUS_SUCCESS : STATUS_BUFFER_TOO_SMALL, 1000, 100) !=
+            ((i < 8) ? STATUS_SUCCESS : STATUS_BUFFER_TOO_SMALL)) {
+            return FALSE;
+        }
+    }
+
+    // Pendientes: Information no se lee; un aviso cuenta como error
+    Dispatch(&device, TEST_IOCTL_PEND, STATUS_PENDING, 64, 9999);
+    Dispatch(&device, TEST_IOCTL_PEND, STATUS_PENDING, 64, 9999);
+    Dispatch(&device, TEST_IOCTL_STATS, STATUS_BUFFER_OVERFLOW, 0, 48);
+    Dispatch(&device, 0x12345678, STATUS_SUCCESS, 0, 0);
+
+    if (device.Handled != 13 ||
+        IoctlDispatcherGetStats(&g_Dispatcher, &header, stats, TEST_TABLE_ENTRIES) != TEST_TABLE_ENTRIES) {
+        return FALSE;
+    }
+
+    return header.Entries == TEST_TABLE_ENTRIES && header.UnknownCalls == 1 &&
+           stats[0].IoControlCode == TEST_IOCTL_SEND && stats[0].Calls == 10 && stats[0].Errors == 2 &&
+           stats[0].Pending == 0 && stats[0].BytesIn == 10000 && stats[0].BytesOut == 800 &&
+           stats[1].Calls == 1 && stats[1].Errors == 1 && stats[1].BytesOut == 0 &&
+           stats[2].Calls == 2 && stats[2].Pending == 2 && stats[2].Errors == 0 &&
+           stats[2].BytesIn == 128 && stats[2].BytesOut == 0 &&
+           stats[3].IoControlCode == TEST_IOCTL_SLOW && stats[3].Calls == 0 && stats[3].MaxTimeNs == 0;
+}
+
+BOOLEAN TestDispatcherTiming(void) {
+    struct _DEVICE_OBJECT device = { 0 };
+    IOCTL_STATS_HEADER header;
+    IOCTL_CALL_STATS stats[TEST_TABLE_ENTRIES];
+    ULONG i;
+
+    IoctlDispatcherInitialize(&g_Dispatcher, g_Table, TEST_TABLE_ENTRIES);
+
+    for (i = 0; i < 3; i++) {
+        Dispatch(&device, TEST_IOCTL_SLOW, STATUS_SUCCESS, 0, 0);
+    }
+    for (i = 0; i < 1000; i++) {
+        Dispatch(&device, TEST_IOCTL_SEND, STATUS_SUCCESS, 0, 0);
+    }
+
+    IoctlDispatcherGetStats(&g_Dispatcher, &header, stats, TEST_TABLE_ENTRIES);
+
+    // El lento tarda al menos lo que duerme; el rápido, mucho menos
+    if (stats[3].Calls != 3 || stats[3].MaxTimeNs < 2000000 || stats[3].TotalTimeNs < 6000000 ||
+        stats[3].TotalTimeNs < stats[3].MaxTimeNs || stats[0].TotalTimeNs < stats[0].MaxTimeNs ||
+        stats[0].MaxTimeNs >= stats[3].MaxTimeNs) {
+        return FALSE;
+    }
+
+    // Un buffer corto recibe las primeras entradas de la tabla
+    memset(stats, 0xCC, sizeof(stats));
+    return IoctlDispatcherGetStats(&g_Dispatcher, &header, stats, 1) == 1 && header.Entries == 1 &&
+           stats[0].IoControlCode == TEST_IOCTL_SEND && stats[0].Calls == 1000 &&
+           stats[1].IoControlCode == 0xCCCCCCCC &&
+           IoctlDispatcherGetStats(&g_Dispatcher, &header, stats, 0) == 0 && header.Entries == 0;
+}
+
+static struct _DEVICE_OBJECT g_StressDevice;
+
+static void *StressCaller(void *arg)
+{
+    ULONG i;
+
+    (void)arg;
+    for (i = 0; i < STRESS_CALLS; i++) {
+        Dispatch(&g_StressDevice, (i & 1) ? TEST_IOCTL_SEND : TEST_IOCTL_STATS,
+                 (i % 10 == 0) ? STATUS_INVALID_PARAMETER : STATUS_SUCCESS, 16, 4);
+    }
+
+    return NULL;
+}
+
+BOOLEAN TestDispatcherConcurrent(void) {
+    pthread_t threads[STRESS_THREADS];
+    IOCTL_STATS_HEADER header;
+    IOCTL_CALL_STATS stats[TEST_TABLE_ENTRIES];
+    ULONG i;
+
+    IoctlDispatcherInitialize(&g_Dispatcher, g_Table, TEST_TABLE_ENTRIES);
+
+    for (i = 0; i < STRESS_THREADS; i++) {
+        pthread_create(&threads[i], NULL, StressCaller, NULL);
+    }
+    for (i = 0; i < STRESS_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    IoctlDispatcherGetStats(&g_Dispatcher, &header, stats, TEST_TABLE_ENTRIES);
+
+    // Ninguna suma se pierde y el máximo no baja del de ninguna llamada
+    return stats[0].Calls == STRESS_THREADS * STRESS_CALLS / 2 &&
+           stats[1].Calls == STRESS_THREADS * STRESS_CALLS / 2 &&
+           stats[0].Errors + stats[1].Errors == STRESS_THREADS * STRESS_CALLS / 10 &&
+           stats[0].BytesIn + stats[1].BytesIn == (ULONG64)STRESS_THREADS * STRESS_CALLS * 16 &&
+           stats[0].BytesOut + stats[1].BytesOut == (ULONG64)STRESS_THREADS * STRESS_CALLS * 9 / 10 * 4 &&
+           stats[0].MaxTimeNs > 0 && stats[0].TotalTimeNs >= stats[0].MaxTimeNs &&
+           g_StressDevice.Handled == (ULONG64)STRESS_THREADS * STRESS_CALLS;
+}
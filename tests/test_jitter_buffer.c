@@ -0,0 +1,430 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "jitter_buffer.h"
+
+// Tiempo en frames de 48 kHz: paquetes de 10 ms, el lector vacía cada 1 ms
+#define TEST_PACKET_FRAMES 480
+#define TEST_TICK_FRAMES   48
+#define TEST_MAX_PACKETS   1024
+
+typedef struct _TEST_PACKET {
+    ULONG64 Timestamp;
+    ULONG64 Arrival;
+} TEST_PACKET;
+
+static UCHAR g_Memory[1 << 20];
+static SHORT g_Packet[TEST_PACKET_FRAMES];
+static SHORT g_Output[8 * TEST_PACKET_FRAMES];
+static TEST_PACKET g_Packets[TEST_MAX_PACKETS];
+static ULONG g_Seed = 12345;
+static BOOLEAN g_ContentError;
+
+// Funciones de prueba
+BOOLEAN TestConfigValidation(void);
+BOOLEAN TestReorderWhilePriming(void);
+BOOLEAN TestConcealmentAndLatePackets(void);
+BOOLEAN TestDelayAdaptation(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas del jitter buffer ===\n\n");
+
+    printf("1. Prueba de validación de la configuración...\n");
+    if (TestConfigValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de reordenación de paquetes durante el cebado...\n");
+    if (TestReorderWhilePriming()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de silencio en huecos vencidos y descarte de paquetes tardíos...\n");
+    if (TestConcealmentAndLatePackets()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de adaptación del retardo al jitter y de recebado...\n");
+    if (TestDelayAdaptation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+
+    if (passedTests == totalTests) {
+        printf("🎉 Todas las pruebas pasaron!\n");
+        return 0;
+    } else {
+        printf("⚠️  Algunas pruebas fallaron\n");
+        return 1;
+    }
+}
+
+// Contenido del frame ts: nunca cero, para distinguirlo del silencio
+static SHORT SampleFor(ULONG64 Timestamp)
+{
+    return (SHORT)(Timestamp % 32000 + 1);
+}
+
+static VOID FillPacket(ULONG64 Timestamp)
+{
+    ULONG i;
+
+    for (i = 0; i < TEST_PACKET_FRAMES; i++) {
+        g_Packet[i] = SampleFor(Timestamp + i);
+    }
+}
+
+static ULONG NextRandom(void)
+{
+    g_Seed = g_Seed * 1103515245 + 12345;
+    return (g_Seed >> 8) & 0xFFFFFF;
+}
+
+static PJITTER_BUFFER Create(ULONG MinDelay, ULONG MaxDelay, ULONG Percentile)
+{
+    JITTER_BUFFER_CONFIG config;
+    PJITTER_BUFFER jitterBuffer;
+
+    config.FrameSize = sizeof(SHORT);
+    config.MinDelay = MinDelay;
+    config.MaxDelay = MaxDelay;
+    config.Percentile = Percentile;
+
+    if (!NT_SUCCESS(JitterBufferInitialize(g_Memory, sizeof(g_Memory), &config, &jitterBuffer))) {
+        return NULL;
+    }
+
+    return jitterBuffer;
+}
+
+// Saca todo lo que ya puede salir; comprueba que el audio sale en su posición
+static ULONG Drain(PJITTER_BUFFER JitterBuffer, ULONG64 Now, SHORT *Output, ULONG MaxFrames)
+{
+    const VOID *data;
+    const SHORT *samples;
+    ULONG total = 0;
+    ULONG frames;
+    ULONG i;
+
+    while (JitterBufferPeek(JitterBuffer, Now, &data, &frames)) {
+        samples = (const SHORT *)data;
+
+        if (samples[0] != 0) {
+            for (i = 0; i < frames; i++) {
+                if (samples[i] != SampleFor(JitterBuffer->Next + i)) {
+                    g_ContentError = TRUE;
+                }
+            }
+        }
+
+        if (Output != NULL) {
+            frames = min(frames, MaxFrames - total);
+            memcpy(Output + total, data, frames * sizeof(SHORT));
+        }
+
+        JitterBufferConsume(JitterBuffer, frames);
+        total += frames;
+
+        if (Output != NULL && total == MaxFrames) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+static int CompareArrival(const void *A, const void *B)
+{
+    const TEST_PACKET *a = (const TEST_PACKET *)A;
+    const TEST_PACKET *b = (const TEST_PACKET *)B;
+
+    return (a->Arrival > b->Arrival) - (a->Arrival < b->Arrival);
+}
+
+// Entrega los paquetes en orden de llegada y vacía en cada tick hasta End
+static VOID Replay(PJITTER_BUFFER JitterBuffer, TEST_PACKET *Packets, ULONG Count, ULONG64 Start, ULONG64 End)
+{
+    ULONG64 now;
+    ULONG next = 0;
+
+    qsort(Packets, Count, sizeof(TEST_PACKET), CompareArrival);
+
+    for (now = Start; now < End; now += TEST_TICK_FRAMES) {
+        while (next < Count && Packets[next].Arrival <= now) {
+            FillPacket(Packets[next].Timestamp);
+            JitterBufferInsert(JitterBuffer, Packets[next].Timestamp, g_Packet, TEST_PACKET_FRAMES, now);
+            next++;
+        }
+        Drain(JitterBuffer, now, NULL, 0);
+    }
+}
+
+BOOLEAN TestConfigValidation(void) {
+    JITTER_BUFFER_CONFIG config;
+    PJITTER_BUFFER jitterBuffer;
+
+    config.FrameSize = 4;
+    config.MinDelay = 480;
+    config.MaxDelay = 4800;
+    config.Percentile = 95;
+
+    if (!JitterBufferIsValidConfig(&config) || JitterBufferGetRequiredSize(&config) == 0) {
+        return FALSE;
+    }
+
+    // La memoria debe bastar
+    if (JitterBufferInitialize(g_Memory, JitterBufferGetRequiredSize(&config) - 1, &config, &jitterBuffer) !=
+            STATUS_BUFFER_TOO_SMALL ||
+        jitterBuffer != NULL) {
+        return FALSE;
+    }
+
+    config.Percentile = 0;
+    if (JitterBufferIsValidConfig(&config) || JitterBufferGetRequiredSize(&config) != 0) {
+        return FALSE;
+    }
+
+    config.Percentile = 101;
+    if (JitterBufferIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.Percentile = 95;
+    config.MinDelay = 4801;
+    if (JitterBufferIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.MinDelay = 0;
+    config.MaxDelay = JITTER_BUFFER_MAX_DELAY_FRAMES + 1;
+    if (JitterBufferIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    config.MaxDelay = JITTER_BUFFER_MAX_DELAY_FRAMES;
+    config.FrameSize = JITTER_BUFFER_MAX_FRAME_SIZE + 1;
+    if (JitterBufferIsValidConfig(&config)) {
+        return FALSE;
+    }
+
+    // Sin paquetes no sale nada
+    jitterBuffer = Create(0, 4800, 95);
+    if (jitterBuffer == NULL || Drain(jitterBuffer, 1000000, NULL, 0) != 0 ||
+        jitterBuffer->State != JITTER_BUFFER_STATE_IDLE) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestReorderWhilePriming(void) {
+    PJITTER_BUFFER jitterBuffer = Create(0, 4800, 95);
+    JITTER_BUFFER_STATS stats;
+    ULONG64 order[3] = { 960, 0, 480 };
+    ULONG frames;
+    ULONG i;
+
+    if (jitterBuffer == NULL) {
+        return FALSE;
+    }
+
+    g_ContentError = FALSE;
+
+    // Llegan 960, 0 y 480; el primero vence con el tránsito mínimo (40)
+    for (i = 0; i < 3; i++) {
+        FillPacket(order[i]);
+        JitterBufferInsert(jitterBuffer, order[i], g_Packet, TEST_PACKET_FRAMES, 1000 + i * 10);
+    }
+
+    frames = Drain(jitterBuffer, 1020, g_Output, 3 * TEST_PACKET_FRAMES);
+    if (frames != 3 * TEST_PACKET_FRAMES || g_ContentError) {
+        printf("   Salieron %u frames\n", frames);
+        return FALSE;
+    }
+
+    for (i = 0; i < frames; i++) {
+        if (g_Output[i] != SampleFor(i)) {
+            printf("   Frame %u fuera de orden\n", i);
+            return FALSE;
+        }
+    }
+
+    JitterBufferGetStats(jitterBuffer, &stats);
+    if (stats.PacketsReordered != 2 || stats.FramesReleased != frames || stats.FramesConcealed != 0 ||
+        stats.State != JITTER_BUFFER_STATE_PLAYING) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestConcealmentAndLatePackets(void) {
+    PJITTER_BUFFER jitterBuffer = Create(480, 4800, 95);
+    JITTER_BUFFER_STATS stats;
+    ULONG frames;
+    ULONG i;
+
+    if (jitterBuffer == NULL) {
+        return FALSE;
+    }
+
+    g_ContentError = FALSE;
+
+    // Tránsito 100 y retardo mínimo 480: el frame ts vence en ts + 580
+    FillPacket(0);
+    JitterBufferInsert(jitterBuffer, 0, g_Packet, TEST_PACKET_FRAMES, 100);
+
+    if (Drain(jitterBuffer, 579, NULL, 0) != 0) {
+        return FALSE;
+    }
+
+    frames = Drain(jitterBuffer, 580, g_Output, 8 * TEST_PACKET_FRAMES);
+
+    // Falta el paquete 480; el 960 llega a su hora
+    FillPacket(960);
+    JitterBufferInsert(jitterBuffer, 960, g_Packet, TEST_PACKET_FRAMES, 1060);
+
+    // El hueco aún no ha vencido
+    if (frames != TEST_PACKET_FRAMES || Drain(jitterBuffer, 1060, NULL, 0) != 0) {
+        return FALSE;
+    }
+
+    // Al vencer sale frame a frame como silencio
+    frames += Drain(jitterBuffer, 1070, g_Output + frames, 8 * TEST_PACKET_FRAMES - frames);
+    if (frames != TEST_PACKET_FRAMES + 10) {
+        printf("   Salieron %u frames a mitad del hueco\n", frames);
+        return FALSE;
+    }
+
+    frames += Drain(jitterBuffer, 1540, g_Output + frames, 8 * TEST_PACKET_FRAMES - frames);
+    if (frames != 3 * TEST_PACKET_FRAMES || g_ContentError) {
+        printf("   Salieron %u frames\n", frames);
+        return FALSE;
+    }
+
+    for (i = 0; i < frames; i++) {
+        if (g_Output[i] != ((i >= 480 && i < 960) ? 0 : SampleFor(i))) {
+            printf("   Frame %u incorrecto\n", i);
+            return FALSE;
+        }
+    }
+
+    // El paquete que faltaba llega cuando ya se ocultó: se descarta, y los
+    // frames de otro que solapa con lo entregado también
+    FillPacket(480);
+    JitterBufferInsert(jitterBuffer, 480, g_Packet, TEST_PACKET_FRAMES, 1600);
+    FillPacket(1200);
+    JitterBufferInsert(jitterBuffer, 1200, g_Packet, TEST_PACKET_FRAMES, 1610);
+
+    frames = Drain(jitterBuffer, 1610, g_Output, 8 * TEST_PACKET_FRAMES);
+    JitterBufferGetStats(jitterBuffer, &stats);
+
+    if (frames != 240 || g_ContentError || g_Output[0] != SampleFor(1440) ||
+        stats.FramesLate != TEST_PACKET_FRAMES + 240 ||
+        stats.FramesConcealed != TEST_PACKET_FRAMES ||
+        stats.FramesReleased != 2 * TEST_PACKET_FRAMES + 240 ||
+        stats.FramesStretched != 0 ||
+        stats.PlayoutDelay != 480) {
+        printf("   Salieron %u frames, tardíos %llu, ocultados %llu\n",
+               frames, (unsigned long long)stats.FramesLate, (unsigned long long)stats.FramesConcealed);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestDelayAdaptation(void) {
+    PJITTER_BUFFER jitterBuffer = Create(240, 9600, 99);
+    JITTER_BUFFER_STATS early;
+    JITTER_BUFFER_STATS stats;
+    ULONG64 lost;
+    ULONG64 start;
+    ULONG i;
+
+    if (jitterBuffer == NULL) {
+        return FALSE;
+    }
+
+    g_ContentError = FALSE;
+
+    // Fase A: jitter uniforme de hasta 2000 frames (~42 ms)
+    for (i = 0; i < 300; i++) {
+        g_Packets[i].Timestamp = (ULONG64)i * TEST_PACKET_FRAMES;
+        g_Packets[i].Arrival = g_Packets[i].Timestamp + 100 + NextRandom() % 2000;
+    }
+    Replay(jitterBuffer, g_Packets, 100, 0, 100 * TEST_PACKET_FRAMES);
+    JitterBufferGetStats(jitterBuffer, &early);
+    Replay(jitterBuffer, g_Packets + 100, 200, 100 * TEST_PACKET_FRAMES, 300 * TEST_PACKET_FRAMES);
+    JitterBufferGetStats(jitterBuffer, &stats);
+
+    // El retardo ha crecido hasta cubrir el jitter y ya casi no se pierde audio
+    lost = (stats.FramesLate - early.FramesLate) + (stats.FramesConcealed - early.FramesConcealed);
+    if (stats.TargetDelay < 1500 || stats.FramesStretched == 0 || stats.PlayoutDelay < 1500 ||
+        lost * 50 > 200 * TEST_PACKET_FRAMES || g_ContentError) {
+        printf("   Objetivo %u, aplicado %u, perdidos %llu\n",
+               stats.TargetDelay, stats.PlayoutDelay, (unsigned long long)lost);
+        return FALSE;
+    }
+
+    // Fase B: jitter casi nulo; el objetivo baja pero no se recorta el retardo
+    for (i = 0; i < 200; i++) {
+        g_Packets[i].Timestamp = (ULONG64)(300 + i) * TEST_PACKET_FRAMES;
+        g_Packets[i].Arrival = g_Packets[i].Timestamp + 100 + (i % 2) * 50;
+    }
+    Replay(jitterBuffer, g_Packets, 200, 300 * TEST_PACKET_FRAMES, 500 * TEST_PACKET_FRAMES);
+    JitterBufferGetStats(jitterBuffer, &stats);
+
+    if (stats.TargetDelay != 240 || stats.PlayoutDelay < 1500) {
+        printf("   Objetivo %u, aplicado %u\n", stats.TargetDelay, stats.PlayoutDelay);
+        return FALSE;
+    }
+
+    // El productor se para: tras MaxDelay frames ocultados vuelve a IDLE
+    Replay(jitterBuffer, g_Packets, 0, 500 * TEST_PACKET_FRAMES, 600 * TEST_PACKET_FRAMES);
+    if (jitterBuffer->State != JITTER_BUFFER_STATE_IDLE) {
+        return FALSE;
+    }
+
+    // Fase C: otra línea de tiempo; se receba con el objetivo bajo
+    start = 1000000;
+    for (i = 0; i < 50; i++) {
+        g_Packets[i].Timestamp = start + (ULONG64)i * TEST_PACKET_FRAMES;
+        g_Packets[i].Arrival = 600 * TEST_PACKET_FRAMES + (ULONG64)i * TEST_PACKET_FRAMES + (i % 2) * 50;
+    }
+    Replay(jitterBuffer, g_Packets, 50, 600 * TEST_PACKET_FRAMES, 650 * TEST_PACKET_FRAMES);
+    JitterBufferGetStats(jitterBuffer, &stats);
+
+    if (stats.State != JITTER_BUFFER_STATE_PLAYING || stats.PlayoutDelay != 240 || g_ContentError) {
+        printf("   Aplicado %u tras recebar\n", stats.PlayoutDelay);
+        return FALSE;
+    }
+
+    // Un salto hacia atrás de las marcas de tiempo reinicia la ventana
+    FillPacket(0);
+    JitterBufferInsert(jitterBuffer, 0, g_Packet, TEST_PACKET_FRAMES, 650 * TEST_PACKET_FRAMES);
+    JitterBufferGetStats(jitterBuffer, &stats);
+
+    if (stats.Resyncs != 1 || stats.State != JITTER_BUFFER_STATE_PRIMING) {
+        return FALSE;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "latency_histogram.h"
+#include "ring_buffer.h"
+
+// Arnés del camino del driver con reloj simulado: el productor escribe en el
+// anillo y marca la llegada como TagWrittenFrames; el lector toma Tail antes
+// de leer y anota la edad como ReadAudioFromBuffer. Los retrasos inyectados
+// son conocidos, así que los percentiles también.
+
+#define PACKET_FRAMES 480                // 10 ms a 48 kHz
+#define PACKET_US     10000
+#define RING_FRAMES   (1 << 18)
+
+static SHORT g_Storage[RING_FRAMES];
+static SHORT g_Packet[PACKET_FRAMES];
+static SHORT g_Output[RING_FRAMES];
+
+// Funciones de prueba
+BOOLEAN TestLatencyHistogramBuckets(void);
+BOOLEAN TestLatencyHistogramPercentiles(void);
+BOOLEAN TestLatencyInjectedDelays(void);
+BOOLEAN TestLatencyPartialAndDroppedReads(void);
+BOOLEAN TestLatencyTagsFull(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas de latencia de extremo a extremo ===\n\n");
+
+    printf("1. Prueba de cubos exactos y log-lineales...\n");
+    if (TestLatencyHistogramBuckets()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de percentiles sobre una rampa de valores...\n");
+    if (TestLatencyHistogramPercentiles()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de retrasos inyectados en el anillo...\n");
+    if (TestLatencyInjectedDelays()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de lecturas parciales y audio descartado...\n");
+    if (TestLatencyPartialAndDroppedReads()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba con la cola de marcas llena...\n");
+    if (TestLatencyTagsFull()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+// El percentil es el mayor valor del cubo: nunca menos que el real y como
+// mucho 1/32 más
+static BOOLEAN IsWithinBucket(ULONG64 Value, ULONG64 Expected)
+{
+    return Value >= Expected && Value <= Expected + Expected / 32;
+}
+
+BOOLEAN TestLatencyHistogramBuckets(void) {
+    LATENCY_HISTOGRAM histogram;
+    ULONG64 value;
+
+    LatencyHistogramReset(&histogram);
+    if (LatencyHistogramGetPercentile(&histogram, 500000) != 0) {
+        return FALSE;
+    }
+
+    // Hasta 63 cada valor tiene su cubo
+    for (value = 0; value < 64; value++) {
+        LatencyHistogramReset(&histogram);
+        LatencyHistogramRecord(&histogram, value);
+        LatencyHistogramRecord(&histogram, 1000000);
+        if (LatencyHistogramGetPercentile(&histogram, 500000) != value) {
+            return FALSE;
+        }
+    }
+
+    // Por encima, el error relativo queda acotado en todas las octavas
+    for (value = 64; value < (1ULL << 32); value = value * 3 / 2 + 1) {
+        LatencyHistogramReset(&histogram);
+        LatencyHistogramRecord(&histogram, value);
+        LatencyHistogramRecord(&histogram, 1ULL << 40);
+        if (!IsWithinBucket(LatencyHistogramGetPercentile(&histogram, 500000), value)) {
+            return FALSE;
+        }
+    }
+
+    // Lo que no cabe se satura en el último cubo; el máximo sigue exacto
+    return LatencyHistogramGetPercentile(&histogram, 1000000) == 1ULL << 40 &&
+           histogram.Max == 1ULL << 40 && histogram.Buckets[LATENCY_HISTOGRAM_BUCKETS - 1] == 1;
+}
+
+BOOLEAN TestLatencyHistogramPercentiles(void) {
+    LATENCY_HISTOGRAM histogram;
+    ULONG64 value;
+
+    LatencyHistogramReset(&histogram);
+    for (value = 1; value <= 100000; value++) {
+        LatencyHistogramRecord(&histogram, value);
+    }
+
+    if (histogram.Count != 100000 ||
+        !IsWithinBucket(LatencyHistogramGetPercentile(&histogram, 500000), 50000) ||
+        !IsWithinBucket(LatencyHistogramGetPercentile(&histogram, 990000), 99000) ||
+        !IsWithinBucket(LatencyHistogramGetPercentile(&histogram, 999000), 99900) ||
+        LatencyHistogramGetPercentile(&histogram, 1000000) != 100000 ||
+        histogram.Max != 100000) {
+        return FALSE;
+    }
+
+    // Con un solo valor todos los percentiles son él mismo (sin pasar del máximo)
+    LatencyHistogramReset(&histogram);
+    LatencyHistogramRecord(&histogram, 12345);
+    return LatencyHistogramGetPercentile(&histogram, 0) == 12345 &&
+           LatencyHistogramGetPercentile(&histogram, 999000) == 12345;
+}
+
+typedef struct _HARNESS {
+    RING_BUFFER Ring;
+    LATENCY_TAGS Tags;
+    LATENCY_HISTOGRAM Histogram;
+} HARNESS;
+
+static HARNESS g_Harness;
+
+static HARNESS *HarnessCreate(void)
+{
+    RingBufferInitialize(&g_Harness.Ring, g_Storage, RING_FRAMES, sizeof(SHORT));
+    LatencyTagsReset(&g_Harness.Tags, 0);
+    LatencyHistogramReset(&g_Harness.Histogram);
+    return &g_Harness;
+}
+
+static VOID HarnessWrite(HARNESS *Harness, ULONG Frames, ULONG64 Now)
+{
+    RingBufferWrite(&Harness->Ring, g_Packet, Frames);
+    LatencyTagsMark(&Harness->Tags, Harness->Ring.Head, Now);
+}
+
+// Devuelve la edad anotada (MAXULONG si el frame no tenía marca)
+static ULONG64 HarnessRead(HARNESS *Harness, ULONG Frames, ULONG64 Now)
+{
+    ULONG64 position = Harness->Ring.Tail;
+    ULONG64 age;
+
+    if (RingBufferRead(&Harness->Ring, g_Output, Frames) == 0 ||
+        !LatencyTagsGetAge(&Harness->Tags, position, Now, &age)) {
+        return MAXULONG;
+    }
+
+    LatencyHistogramRecord(&Harness->Histogram, age);
+    return age;
+}
+
+BOOLEAN TestLatencyInjectedDelays(void) {
+    HARNESS *harness = HarnessCreate();
+    ULONG64 now;
+    ULONG64 delay;
+    ULONG i;
+
+    // 98 % de las lecturas a 5 ms, 1,8 % a 20 ms y 0,2 % a 50 ms
+    for (i = 0; i < 10000; i++) {
+        if (i % 500 == 499) {
+            delay = 50000;
+        } else if (i % 100 >= 98) {
+            delay = 20000;
+        } else {
+            delay = 5000;
+        }
+
+        now = (ULONG64)i * PACKET_US;
+        HarnessWrite(harness, PACKET_FRAMES, now);
+        if (HarnessRead(harness, PACKET_FRAMES, now + delay) != delay) {
+            return FALSE;
+        }
+    }
+
+    return harness->Histogram.Count == 10000 &&
+           IsWithinBucket(LatencyHistogramGetPercentile(&harness->Histogram, 500000), 5000) &&
+           IsWithinBucket(LatencyHistogramGetPercentile(&harness->Histogram, 990000), 20000) &&
+           IsWithinBucket(LatencyHistogramGetPercentile(&harness->Histogram, 999000), 50000) &&
+           harness->Histogram.Max == 50000;
+}
+
+BOOLEAN TestLatencyPartialAndDroppedReads(void) {
+    HARNESS *harness = HarnessCreate();
+
+    // Tres paquetes a 0, 1 y 2 ms; una lectura de paquete y medio a 5 ms
+    HarnessWrite(harness, PACKET_FRAMES, 0);
+    HarnessWrite(harness, PACKET_FRAMES, 1000);
+    HarnessWrite(harness, PACKET_FRAMES, 2000);
+    if (HarnessRead(harness, PACKET_FRAMES + PACKET_FRAMES / 2, 5000) != 5000) {
+        return FALSE;
+    }
+
+    // La siguiente empieza a mitad del segundo paquete; la última, en el tercero
+    if (HarnessRead(harness, PACKET_FRAMES / 2, 6000) != 5000 ||
+        HarnessRead(harness, PACKET_FRAMES, 7000) != 5000) {
+        return FALSE;
+    }
+
+    // Escrituras vacías no marcan nada
+    HarnessWrite(harness, 0, 7500);
+    if (HarnessRead(harness, PACKET_FRAMES, 8000) != MAXULONG) {
+        return FALSE;
+    }
+
+    // Lo descartado (DROP_OLDEST o silencio) se salta sin leer sus marcas
+    HarnessWrite(harness, PACKET_FRAMES, 10000);
+    HarnessWrite(harness, PACKET_FRAMES, 11000);
+    HarnessWrite(harness, PACKET_FRAMES, 12000);
+    RingBufferDiscard(&harness->Ring, 2 * PACKET_FRAMES + 10);
+    return HarnessRead(harness, PACKET_FRAMES, 15000) == 3000 && harness->Histogram.Count == 4;
+}
+
+BOOLEAN TestLatencyTagsFull(void) {
+    HARNESS *harness = HarnessCreate();
+    ULONG i;
+
+    // 10 paquetes más de los que caben en la cola, uno por milisegundo
+    for (i = 0; i < LATENCY_TAGS_COUNT + 10; i++) {
+        HarnessWrite(harness, PACKET_FRAMES / 8, (ULONG64)i * 1000);
+    }
+
+    // Los que tienen marca miden bien
+    if (HarnessRead(harness, LATENCY_TAGS_COUNT * (PACKET_FRAMES / 8), 300000) != 300000) {
+        return FALSE;
+    }
+
+    // El primero sin marca no se mide; la marca que entra después cubre los
+    // sin marca con la llegada del más antiguo
+    if (HarnessRead(harness, PACKET_FRAMES / 8, 301000) != MAXULONG) {
+        return FALSE;
+    }
+
+    HarnessWrite(harness, PACKET_FRAMES / 8, 302000);
+    return HarnessRead(harness, PACKET_FRAMES / 8, 303000) == 303000 - LATENCY_TAGS_COUNT * 1000 &&
+           harness->Histogram.Count == 2;
+}
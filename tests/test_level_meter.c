@@ -0,0 +1,316 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "level_meter.h"
+
+#define TEST_FRAMES       4800
+#define TEST_MAX_CHANNELS 8
+#define TEST_RING_FRAMES  1024
+#define TEST_PI           3.14159265358979323846
+
+static UCHAR g_Data[TEST_FRAMES * TEST_MAX_CHANNELS * sizeof(LONG)];
+static UCHAR g_Storage[TEST_RING_FRAMES * TEST_MAX_CHANNELS * sizeof(LONG)];
+
+// Funciones de prueba
+BOOLEAN TestValidationAndWindow(void);
+BOOLEAN TestKnownLevels(void);
+BOOLEAN TestVectorMatchesScalar(void);
+BOOLEAN TestRingWrap(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de los medidores de nivel ===\n\n");
+
+    printf("1. Prueba de validación y de la ventana de medida...\n");
+    if (TestValidationAndWindow()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de pico, RMS y saturaciones con señales conocidas en todos los formatos...\n");
+    if (TestKnownLevels()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de núcleos SSE2 equivalentes al escalar...\n");
+    if (TestVectorMatchesScalar()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de medida sobre el anillo cruzando el final del buffer...\n");
+    if (TestRingWrap()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+// Escribe Value (escala completa = 1, saturado) en la muestra Index
+static void StoreSample(SAMPLE_FORMAT format, SIZE_T index, double value)
+{
+    double scaled;
+    LONG integer;
+
+    if (format == SAMPLE_FORMAT_FLOAT32) {
+        ((float *)g_Data)[index] = (float)value;
+        return;
+    }
+
+    scaled = value * ((format == SAMPLE_FORMAT_INT16) ? 32768.0 : (format == SAMPLE_FORMAT_INT24) ? 8388608.0 : 2147483648.0);
+    scaled = floor(scaled + 0.5);
+
+    switch (format) {
+        case SAMPLE_FORMAT_INT16:
+            integer = (LONG)fmax(fmin(scaled, 32767.0), -32768.0);
+            ((SHORT *)g_Data)[index] = (SHORT)integer;
+            break;
+        case SAMPLE_FORMAT_INT24:
+            integer = (LONG)fmax(fmin(scaled, 8388607.0), -8388608.0);
+            g_Data[index * 3] = (UCHAR)integer;
+            g_Data[index * 3 + 1] = (UCHAR)(integer >> 8);
+            g_Data[index * 3 + 2] = (UCHAR)(integer >> 16);
+            break;
+        default:
+            ((LONG *)g_Data)[index] = (LONG)fmax(fmin(scaled, 2147483647.0), -2147483648.0);
+            break;
+    }
+}
+
+// Seno por canal: amplitud 0.9 / (canal + 1), frecuencia distinta en cada uno
+static void FillSines(SAMPLE_FORMAT format, ULONG channels, ULONG frames)
+{
+    ULONG frame;
+    ULONG channel;
+
+    for (frame = 0; frame < frames; frame++) {
+        for (channel = 0; channel < channels; channel++) {
+            StoreSample(format, (SIZE_T)frame * channels + channel,
+                        0.9 / (channel + 1) * sin(2.0 * TEST_PI * (channel + 1) * 100.0 * frame / 48000.0 + 0.3));
+        }
+    }
+}
+
+BOOLEAN TestValidationAndWindow(void) {
+    LEVEL_METER meter;
+    LEVEL_METER_SNAPSHOT snapshot;
+    ULONG frame;
+
+    if (LevelMeterInitialize(&meter, SAMPLE_FORMAT_COUNT, 2, SAMPLE_CONVERT_ISA_SCALAR) != STATUS_INVALID_PARAMETER ||
+        LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 0, SAMPLE_CONVERT_ISA_SCALAR) != STATUS_INVALID_PARAMETER ||
+        LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 9, SAMPLE_CONVERT_ISA_SCALAR) != STATUS_INVALID_PARAMETER ||
+        LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 2, SAMPLE_CONVERT_ISA_COUNT) != STATUS_INVALID_PARAMETER) {
+        printf("   Configuración inválida aceptada\n");
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(LevelMeterInitialize(&meter, SAMPLE_FORMAT_INT16, 2, SampleConvertGetBestIsa()))) {
+        return FALSE;
+    }
+
+    // Ventana vacía: todo a cero, sin dividir por cero
+    LevelMeterGetSnapshot(&meter, &snapshot);
+    if (snapshot.Frames != 0 || snapshot.Channels != 2 ||
+        snapshot.Channel[0].Peak != 0.0f || snapshot.Channel[0].Rms != 0.0f || snapshot.Channel[1].Clips != 0) {
+        printf("   Ventana inicial no vacía\n");
+        return FALSE;
+    }
+
+    // Canal 0 con onda cuadrada a escala completa, canal 1 a -6 dB
+    for (frame = 0; frame < 100; frame++) {
+        ((SHORT *)g_Data)[frame * 2] = (frame & 1) ? 32767 : -32768;
+        ((SHORT *)g_Data)[frame * 2 + 1] = (frame & 1) ? 16384 : -16384;
+    }
+
+    LevelMeterProcess(&meter, g_Data, 100);
+    LevelMeterGetSnapshot(&meter, &snapshot);
+    if (snapshot.Frames != 100 || snapshot.Channel[0].Clips != 100 || snapshot.Channel[1].Clips != 0 ||
+        snapshot.Channel[0].Peak != 1.0f || snapshot.Channel[1].Peak != 0.5f ||
+        fabs(snapshot.Channel[0].Rms - 1.0) > 1e-4 || fabs(snapshot.Channel[1].Rms - 0.5) > 1e-6) {
+        printf("   Onda cuadrada: %llu frames, pico %f/%f, RMS %f/%f, saturadas %llu/%llu\n",
+               (unsigned long long)snapshot.Frames, snapshot.Channel[0].Peak, snapshot.Channel[1].Peak,
+               snapshot.Channel[0].Rms, snapshot.Channel[1].Rms,
+               (unsigned long long)snapshot.Channel[0].Clips, (unsigned long long)snapshot.Channel[1].Clips);
+        return FALSE;
+    }
+
+    // Consultar no reinicia; Reset empieza una ventana nueva
+    LevelMeterProcess(&meter, g_Data, 0);
+    LevelMeterGetSnapshot(&meter, &snapshot);
+    if (snapshot.Frames != 100) {
+        return FALSE;
+    }
+
+    LevelMeterReset(&meter);
+    memset(g_Data, 0, 50 * 2 * sizeof(SHORT));
+    LevelMeterProcess(&meter, g_Data, 50);
+    LevelMeterGetSnapshot(&meter, &snapshot);
+    if (snapshot.Frames != 50 || snapshot.Channel[0].Peak != 0.0f || snapshot.Channel[0].Clips != 0 ||
+        snapshot.Channel[0].Rms != 0.0f) {
+        printf("   La ventana nueva conserva valores de la anterior\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestKnownLevels(void) {
+    static const ULONG bytes[SAMPLE_FORMAT_COUNT] = { 2, 3, 4, 4 };
+    LEVEL_METER meter;
+    LEVEL_METER_SNAPSHOT snapshot;
+    SAMPLE_FORMAT format;
+    ULONG channels;
+    ULONG channel;
+    double amplitude;
+
+    for (format = SAMPLE_FORMAT_INT16; format < SAMPLE_FORMAT_COUNT; format++) {
+        for (channels = 1; channels <= TEST_MAX_CHANNELS; channels++) {
+            if (!NT_SUCCESS(LevelMeterInitialize(&meter, format, channels, SampleConvertGetBestIsa()))) {
+                return FALSE;
+            }
+
+            // 4800 frames: ciclos completos de todos los senos
+            FillSines(format, channels, TEST_FRAMES);
+            LevelMeterProcess(&meter, g_Data, TEST_FRAMES);
+            LevelMeterGetSnapshot(&meter, &snapshot);
+
+            for (channel = 0; channel < channels; channel++) {
+                amplitude = 0.9 / (channel + 1);
+                if (fabs(snapshot.Channel[channel].Peak - amplitude) > 1e-3 ||
+                    fabs(snapshot.Channel[channel].Rms - amplitude / sqrt(2.0)) > 1e-4 ||
+                    snapshot.Channel[channel].Clips != 0) {
+                    printf("   Formato %u, %u canales, canal %u: pico %f, RMS %f (esperado %f, %f)\n",
+                           format, channels, channel, snapshot.Channel[channel].Peak,
+                           snapshot.Channel[channel].Rms, amplitude, amplitude / sqrt(2.0));
+                    return FALSE;
+                }
+            }
+
+            // Las muestras en los extremos del formato cuentan como saturadas
+            // en su canal; una por debajo del máximo no
+            StoreSample(format, 0, 1.0);
+            StoreSample(format, (SIZE_T)channels * 3 + channels - 1, -1.0);
+            StoreSample(format, (SIZE_T)channels * 5, 0.9999);
+            LevelMeterReset(&meter);
+            LevelMeterProcess(&meter, g_Data, TEST_FRAMES);
+            LevelMeterGetSnapshot(&meter, &snapshot);
+
+            if (snapshot.Channel[0].Peak < meter.ClipThreshold || snapshot.Channel[channels - 1].Peak != 1.0f ||
+                snapshot.Channel[0].Clips != ((channels == 1) ? 2U : 1U) ||
+                (channels > 1 && snapshot.Channel[channels - 1].Clips != 1)) {
+                printf("   Formato %u (%u bytes), %u canales: saturadas %llu/%llu, pico %f\n",
+                       format, bytes[format], channels, (unsigned long long)snapshot.Channel[0].Clips,
+                       (unsigned long long)snapshot.Channel[channels - 1].Clips, snapshot.Channel[0].Peak);
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestVectorMatchesScalar(void) {
+    LEVEL_METER scalar;
+    LEVEL_METER sse2;
+    SAMPLE_FORMAT format;
+    ULONG channels;
+    ULONG channel;
+    ULONG frames;
+    ULONG i;
+
+    if (!SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)) {
+        printf("   (SSE2 no disponible, se omite)\n");
+        return TRUE;
+    }
+
+    // Ruido pseudoaleatorio a escala completa, con saturaciones
+    for (i = 0; i < sizeof(g_Data) / sizeof(LONG); i++) {
+        ((LONG *)g_Data)[i] = (LONG)(i * 2654435761UL);
+    }
+    for (i = 0; i < TEST_FRAMES * TEST_MAX_CHANNELS; i++) {
+        ((float *)g_Data)[i] = (float)((LONG)(i * 2654435761UL) >> 8) / 8000000.0f;
+    }
+
+    for (format = SAMPLE_FORMAT_INT16; format < SAMPLE_FORMAT_COUNT; format++) {
+        for (channels = 1; channels <= TEST_MAX_CHANNELS; channels++) {
+            // Colas de todas las longitudes y bloques que cruzan la suma parcial
+            for (frames = 0; frames <= TEST_FRAMES; frames = (frames < 40) ? frames + 1 : frames * 3) {
+                LevelMeterInitialize(&scalar, format, channels, SAMPLE_CONVERT_ISA_SCALAR);
+                LevelMeterInitialize(&sse2, format, channels, SAMPLE_CONVERT_ISA_SSE2);
+                LevelMeterProcess(&scalar, g_Data, frames);
+                LevelMeterProcess(&sse2, g_Data, frames);
+
+                for (channel = 0; channel < channels; channel++) {
+                    if (scalar.Peak[channel] != sse2.Peak[channel] ||
+                        scalar.Clips[channel] != sse2.Clips[channel] ||
+                        fabs(scalar.SumSquares[channel] - sse2.SumSquares[channel]) >
+                            1e-5 * scalar.SumSquares[channel] + 1e-12) {
+                        printf("   Formato %u, %u canales, %u frames, canal %u: SSE2 difiere\n",
+                               format, channels, frames, channel);
+                        return FALSE;
+                    }
+                }
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestRingWrap(void) {
+    RING_BUFFER ring;
+    LEVEL_METER linear;
+    LEVEL_METER wrapped;
+    LEVEL_METER_SNAPSHOT expected;
+    LEVEL_METER_SNAPSHOT actual;
+    ULONG64 head;
+    ULONG channels = 3;
+    ULONG frameSize = channels * sizeof(float);
+
+    if (!NT_SUCCESS(RingBufferInitialize(&ring, g_Storage, TEST_RING_FRAMES, frameSize))) {
+        return FALSE;
+    }
+
+    FillSines(SAMPLE_FORMAT_FLOAT32, channels, 700);
+    LevelMeterInitialize(&linear, SAMPLE_FORMAT_FLOAT32, channels, SampleConvertGetBestIsa());
+    LevelMeterInitialize(&wrapped, SAMPLE_FORMAT_FLOAT32, channels, SampleConvertGetBestIsa());
+
+    // Deja Head cerca del final para que los 700 frames crucen el wrap-around
+    RingBufferWrite(&ring, g_Storage, 900);
+    RingBufferDiscard(&ring, 900);
+
+    head = ring.Head;
+    if (RingBufferWrite(&ring, g_Data, 700) != 700) {
+        return FALSE;
+    }
+
+    LevelMeterProcessRing(&wrapped, &ring, head, (ULONG)(ring.Head - head));
+    LevelMeterProcess(&linear, g_Data, 700);
+    LevelMeterGetSnapshot(&linear, &expected);
+    LevelMeterGetSnapshot(&wrapped, &actual);
+
+    if (memcmp(&expected, &actual, sizeof(expected)) != 0 || actual.Frames != 700) {
+        printf("   La medida del anillo difiere de la del paquete\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mirror_buffer.h"
+#include "ring_buffer.h"
+
+// Funciones de prueba
+BOOLEAN TestMirrorAliasing(void);
+BOOLEAN TestMirrorRejectsUnalignedSize(void);
+BOOLEAN TestMirroredRingOddPackets(void);
+BOOLEAN TestMirroredRingContiguousRegion(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas del buffer espejo ===\n\n");
+
+    printf("1. Prueba de alias entre ambas vistas...\n");
+    if (TestMirrorAliasing()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de tamaño no alineado a página...\n");
+    if (TestMirrorRejectsUnalignedSize()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de paquetes de tamaño impar sobre anillo espejo...\n");
+    if (TestMirroredRingOddPackets()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de región contigua en el wrap-around...\n");
+    if (TestMirroredRingContiguousRegion()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestMirrorAliasing(void) {
+    MIRROR_BUFFER mirror;
+    ULONG size = MirrorBufferGetGranularity() * 2;
+    BOOLEAN result;
+
+    if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, size))) {
+        return FALSE;
+    }
+
+    // Escribir en la primera vista se ve en la segunda y viceversa
+    mirror.BaseAddress[10] = 0xA5;
+    mirror.BaseAddress[size + 20] = 0x5A;
+
+    result = mirror.BaseAddress[size + 10] == 0xA5 && mirror.BaseAddress[20] == 0x5A;
+
+    MirrorBufferFree(&mirror);
+    return result && mirror.BaseAddress == NULL;
+}
+
+BOOLEAN TestMirrorRejectsUnalignedSize(void) {
+    MIRROR_BUFFER mirror;
+
+    return MirrorBufferAllocate(&mirror, MirrorBufferGetGranularity() + 1) == STATUS_INVALID_PARAMETER;
+}
+
+BOOLEAN TestMirroredRingOddPackets(void) {
+    static const ULONG packetSizes[] = { 1, 3, 997, 1921, 4099, 7 };
+    MIRROR_BUFFER mirror;
+    RING_BUFFER ring;
+    UCHAR *input;
+    UCHAR *output;
+    ULONG size = MirrorBufferGetGranularity() * 2;
+    ULONG64 writePos = 0;
+    ULONG64 readPos = 0;
+    ULONG round;
+    ULONG i;
+    BOOLEAN result = TRUE;
+
+    if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, size))) {
+        return FALSE;
+    }
+
+    RingBufferInitializeMirrored(&ring, mirror.BaseAddress, size, 1);
+    input = (UCHAR *)malloc(size);
+    output = (UCHAR *)malloc(size);
+
+    // Suficientes vueltas para cruzar el final del buffer en muchos offsets
+    for (round = 0; round < 200 && result; round++) {
+        ULONG length = packetSizes[round % (sizeof(packetSizes) / sizeof(packetSizes[0]))];
+
+        for (i = 0; i < length; i++) {
+            input[i] = (UCHAR)(writePos + i);
+        }
+
+        if (RingBufferWrite(&ring, input, length) != length) {
+            result = FALSE;
+            break;
+        }
+        writePos += length;
+
+        if (RingBufferRead(&ring, output, length) != length) {
+            result = FALSE;
+            break;
+        }
+
+        for (i = 0; i < length; i++) {
+            if (output[i] != (UCHAR)(readPos + i)) {
+                result = FALSE;
+                break;
+            }
+        }
+        readPos += length;
+    }
+
+    free(input);
+    free(output);
+    MirrorBufferFree(&mirror);
+    return result;
+}
+
+BOOLEAN TestMirroredRingContiguousRegion(void) {
+    MIRROR_BUFFER mirror;
+    RING_BUFFER ring;
+    UCHAR scratch[512];
+    PUCHAR region;
+    ULONG size = MirrorBufferGetGranularity();
+    ULONG available;
+    ULONG i;
+    BOOLEAN result = TRUE;
+
+    if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, size))) {
+        return FALSE;
+    }
+
+    RingBufferInitializeMirrored(&ring, mirror.BaseAddress, size, 1);
+
+    // Dejar Head y Tail a 100 bytes del final
+    while (ring.Head < size - 100) {
+        ULONG chunk = (ULONG)min(sizeof(scratch), size - 100 - ring.Head);
+        RingBufferWrite(&ring, scratch, chunk);
+        RingBufferRead(&ring, scratch, chunk);
+    }
+
+    // Todo el espacio libre es contiguo aunque cruce el final
+    available = RingBufferAcquireWrite(&ring, &region);
+    if (available != size) {
+        result = FALSE;
+    }
+
+    for (i = 0; i < 300; i++) {
+        region[i] = (UCHAR)(i * 3);
+    }
+    RingBufferCommitWrite(&ring, 300);
+
+    // Procesamiento in situ sobre la memoria del anillo
+    available = RingBufferAcquireRead(&ring, &region);
+    if (available != 300) {
+        result = FALSE;
+    }
+
+    for (i = 0; i < 300 && result; i++) {
+        if (region[i] != (UCHAR)(i * 3)) {
+            result = FALSE;
+        }
+    }
+
+    // Los bytes que cruzaron el final están al principio de la primera vista
+    if (mirror.BaseAddress[0] != (UCHAR)(100 * 3)) {
+        result = FALSE;
+    }
+
+    RingBufferReleaseRead(&ring, 300);
+    result = result && RingBufferGetUsedFrames(&ring) == 0;
+
+    MirrorBufferFree(&mirror);
+    return result;
+}
@@ -0,0 +1,446 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "virtual_mic.h"
+#include "driver_core.h"
+#include "audio_processing.h"
+
+// Lecturas pendientes del driver real (src/driver/pending_reads.c y la IoCsq
+// de src/driver/pending_irp_queue.c) sobre el shim de src/host/km: los
+// IRP_MJ_READ llegan por DispatchRead, el audio por SEND_AUDIO, la
+// cancelación por IoCancelIrp y el cierre por IRP_MJ_CLEANUP.
+
+#define TEST_CHANNELS      DEFAULT_CHANNELS
+#define TEST_MIN_FILL      DEFAULT_READ_MIN_FILL_FRAMES
+#define TEST_MAX_FRAMES    (2 * TEST_MIN_FILL)
+#define STRESS_READ_FRAMES 64
+#define STRESS_MAX_CHUNK   48
+#define STRESS_READS       2000
+
+DRIVER_INITIALIZE DriverEntry;
+
+static DRIVER_OBJECT g_DriverObject;
+static FILE_OBJECT g_FileObject;
+static PDEVICE_EXTENSION g_DeviceExtension;
+
+// Funciones de prueba
+BOOLEAN TestReadPendsUntilMinFill(void);
+BOOLEAN TestReadFifoOrder(void);
+BOOLEAN TestReadCancel(void);
+BOOLEAN TestReadFlushByFile(void);
+BOOLEAN TestReadUnderruns(void);
+BOOLEAN TestReadConcurrentStress(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 6;
+
+    printf("=== Iniciando pruebas de lecturas pendientes ===\n\n");
+
+    memset(&g_DriverObject, 0, sizeof(g_DriverObject));
+    if (!NT_SUCCESS(DriverEntry(&g_DriverObject, NULL))) {
+        printf("DriverEntry falló\n");
+        return 1;
+    }
+    g_DeviceExtension = (PDEVICE_EXTENSION)g_DriverObject.DeviceObject->DeviceExtension;
+
+    printf("1. Prueba de lectura pendiente hasta el llenado mínimo...\n");
+    if (TestReadPendsUntilMinFill()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de orden FIFO y lecturas pequeñas...\n");
+    if (TestReadFifoOrder()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de cancelación de una lectura pendiente...\n");
+    if (TestReadCancel()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de vaciado al cerrar un handle...\n");
+    if (TestReadFlushByFile()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de underruns con el llenado mínimo...\n");
+    if (TestReadUnderruns()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("6. Prueba de estrés: cada lectura se completa exactamente una vez...\n");
+    if (TestReadConcurrentStress()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    g_DriverObject.DriverUnload(&g_DriverObject);
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+// SEND_AUDIO de Frames frames numerados desde *Next (ambos canales iguales).
+// Solo un hilo envía a la vez: el paquete es estático.
+static NTSTATUS SendFrames(USHORT *Next, ULONG Frames)
+{
+    static UCHAR packetBuffer[sizeof(AUDIO_BUFFER_PACKET) + TEST_MIN_FILL * TEST_CHANNELS * sizeof(SHORT)];
+    PAUDIO_BUFFER_PACKET packet = (PAUDIO_BUFFER_PACKET)packetBuffer;
+    SHORT *samples = (SHORT *)packet->Data;
+    PIRP irp = HostAllocateIrp(IRP_MJ_DEVICE_CONTROL, &g_FileObject);
+    PIO_STACK_LOCATION stack = IoGetCurrentIrpStackLocation(irp);
+    NTSTATUS status;
+    ULONG i;
+
+    packet->Timestamp = 0;
+    packet->DataLength = Frames * TEST_CHANNELS * sizeof(SHORT);
+    for (i = 0; i < Frames; i++) {
+        samples[i * TEST_CHANNELS] = (SHORT)(*Next + i);
+        samples[i * TEST_CHANNELS + 1] = (SHORT)(*Next + i);
+    }
+
+    irp->AssociatedIrp.SystemBuffer = packetBuffer;
+    stack->Parameters.DeviceIoControl.IoControlCode = IOCTL_VIRTUALMIC_SEND_AUDIO;
+    stack->Parameters.DeviceIoControl.InputBufferLength = sizeof(AUDIO_BUFFER_PACKET) + packet->DataLength;
+    stack->Parameters.DeviceIoControl.OutputBufferLength = 0;
+
+    status = g_DriverObject.MajorFunction[IRP_MJ_DEVICE_CONTROL](g_DriverObject.DeviceObject, irp);
+    HostFreeIrp(irp);
+
+    if (status == STATUS_SUCCESS) {
+        *Next = (USHORT)(*Next + Frames);
+    }
+
+    return status;
+}
+
+// IRP_MJ_READ de Frames frames sobre Buffer; el llamador libera el IRP
+static PIRP StartRead(PFILE_OBJECT FileObject, SHORT *Buffer, ULONG Frames, NTSTATUS *Status)
+{
+    PIRP irp = HostAllocateIrp(IRP_MJ_READ, FileObject);
+
+    irp->AssociatedIrp.SystemBuffer = Buffer;
+    IoGetCurrentIrpStackLocation(irp)->Parameters.Read.Length = Frames * TEST_CHANNELS * sizeof(SHORT);
+
+    *Status = g_DriverObject.MajorFunction[IRP_MJ_READ](g_DriverObject.DeviceObject, irp);
+    return irp;
+}
+
+static NTSTATUS Cleanup(PFILE_OBJECT FileObject)
+{
+    PIRP irp = HostAllocateIrp(IRP_MJ_CLEANUP, FileObject);
+    NTSTATUS status;
+
+    status = g_DriverObject.MajorFunction[IRP_MJ_CLEANUP](g_DriverObject.DeviceObject, irp);
+    HostFreeIrp(irp);
+    return status;
+}
+
+// Completado una sola vez con Frames frames numerados desde First
+static BOOLEAN ReadCompletedWith(PIRP Irp, const SHORT *Buffer, ULONG Frames, USHORT First)
+{
+    ULONG i;
+
+    if (Irp->HostCompleted != 1 || Irp->IoStatus.Status != STATUS_SUCCESS ||
+        Irp->IoStatus.Information != Frames * TEST_CHANNELS * sizeof(SHORT)) {
+        return FALSE;
+    }
+
+    for (i = 0; i < Frames; i++) {
+        if ((USHORT)Buffer[i * TEST_CHANNELS] != (USHORT)(First + i) ||
+            (USHORT)Buffer[i * TEST_CHANNELS + 1] != (USHORT)(First + i)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static BOOLEAN ReadCancelled(PIRP Irp)
+{
+    return Irp->HostCompleted == 1 && Irp->IoStatus.Status == STATUS_CANCELLED && Irp->IoStatus.Information == 0;
+}
+
+BOOLEAN TestReadPendsUntilMinFill(void) {
+    static SHORT output[TEST_MAX_FRAMES * TEST_CHANNELS];
+    USHORT next = 0;
+    NTSTATUS status;
+    PIRP irp;
+    BOOLEAN result;
+
+    irp = StartRead(&g_FileObject, output, TEST_MAX_FRAMES, &status);
+    if (status != STATUS_PENDING || !irp->PendingReturned) {
+        HostFreeIrp(irp);
+        return FALSE;
+    }
+
+    // Por debajo del umbral la lectura sigue pendiente
+    result = SendFrames(&next, TEST_MIN_FILL - 1) == STATUS_SUCCESS && irp->HostCompleted == 0 &&
+             g_DeviceExtension->PendingReads.Queue.Count == 1;
+
+    // El frame que alcanza el umbral la completa con lo que hay
+    result = result && SendFrames(&next, 1) == STATUS_SUCCESS && ReadCompletedWith(irp, output, TEST_MIN_FILL, 0) &&
+             g_DeviceExtension->PendingReads.Queue.Count == 0;
+    HostFreeIrp(irp);
+
+    // Con datos suficientes se completa sin encolarse
+    result = result && SendFrames(&next, TEST_MIN_FILL) == STATUS_SUCCESS &&
+             SendFrames(&next, TEST_MIN_FILL) == STATUS_SUCCESS;
+    irp = StartRead(&g_FileObject, output, TEST_MAX_FRAMES, &status);
+    result = result && status == STATUS_SUCCESS && !irp->PendingReturned &&
+             ReadCompletedWith(irp, output, TEST_MAX_FRAMES, TEST_MIN_FILL);
+    HostFreeIrp(irp);
+
+    return result;
+}
+
+BOOLEAN TestReadFifoOrder(void) {
+    static SHORT firstOutput[TEST_MAX_FRAMES * TEST_CHANNELS];
+    SHORT secondOutput[2 * TEST_CHANNELS];
+    USHORT next = 0;
+    NTSTATUS firstStatus;
+    NTSTATUS secondStatus;
+    PIRP first;
+    PIRP second;
+    BOOLEAN result;
+
+    first = StartRead(&g_FileObject, firstOutput, TEST_MAX_FRAMES, &firstStatus);
+    second = StartRead(&g_FileObject, secondOutput, 2, &secondStatus);
+    result = firstStatus == STATUS_PENDING && secondStatus == STATUS_PENDING;
+
+    // La segunda podría completarse con 2 frames, pero espera a la primera
+    result = result && SendFrames(&next, 2) == STATUS_SUCCESS && first->HostCompleted == 0 &&
+             second->HostCompleted == 0;
+
+    result = result && SendFrames(&next, TEST_MIN_FILL - 2) == STATUS_SUCCESS &&
+             ReadCompletedWith(first, firstOutput, TEST_MIN_FILL, 0) && second->HostCompleted == 0;
+
+    // Una lectura menor que el umbral se completa en cuanto cabe entera
+    result = result && SendFrames(&next, 2) == STATUS_SUCCESS &&
+             ReadCompletedWith(second, secondOutput, 2, TEST_MIN_FILL);
+
+    HostFreeIrp(first);
+    HostFreeIrp(second);
+    return result;
+}
+
+BOOLEAN TestReadCancel(void) {
+    static SHORT firstOutput[TEST_MAX_FRAMES * TEST_CHANNELS];
+    static SHORT secondOutput[TEST_MAX_FRAMES * TEST_CHANNELS];
+    USHORT next = 0;
+    NTSTATUS firstStatus;
+    NTSTATUS secondStatus;
+    PIRP first;
+    PIRP second;
+    BOOLEAN result;
+
+    first = StartRead(&g_FileObject, firstOutput, TEST_MAX_FRAMES, &firstStatus);
+    second = StartRead(&g_FileObject, secondOutput, TEST_MAX_FRAMES, &secondStatus);
+    result = firstStatus == STATUS_PENDING && secondStatus == STATUS_PENDING;
+
+    // Cancelar la cabeza deja paso a la siguiente sin consumir audio
+    result = result && IoCancelIrp(first) && ReadCancelled(first) &&
+             g_DeviceExtension->PendingReads.Queue.Count == 1;
+
+    result = result && SendFrames(&next, TEST_MIN_FILL) == STATUS_SUCCESS && first->HostCompleted == 1 &&
+             ReadCompletedWith(second, secondOutput, TEST_MIN_FILL, 0);
+
+    // Cancelar una lectura ya completada no tiene efecto
+    result = result && !IoCancelIrp(second) && ReadCompletedWith(second, secondOutput, TEST_MIN_FILL, 0);
+
+    HostFreeIrp(first);
+    HostFreeIrp(second);
+    return result;
+}
+
+BOOLEAN TestReadFlushByFile(void) {
+    static SHORT outputs[4][TEST_MIN_FILL * TEST_CHANNELS];
+    FILE_OBJECT fileA;
+    FILE_OBJECT fileB;
+    NTSTATUS status;
+    PIRP reads[4];
+    BOOLEAN result = TRUE;
+    ULONG i;
+
+    memset(&fileA, 0, sizeof(fileA));
+    memset(&fileB, 0, sizeof(fileB));
+
+    for (i = 0; i < 4; i++) {
+        reads[i] = StartRead((i % 2 == 0) ? &fileA : &fileB, outputs[i], TEST_MIN_FILL, &status);
+        result = result && status == STATUS_PENDING;
+    }
+
+    // El cierre de un handle cancela solo sus lecturas
+    result = result && Cleanup(&fileA) == STATUS_SUCCESS && g_DeviceExtension->PendingReads.Queue.Count == 2 &&
+             ReadCancelled(reads[0]) && ReadCancelled(reads[2]) &&
+             reads[1]->HostCompleted == 0 && reads[3]->HostCompleted == 0;
+
+    result = result && Cleanup(&fileB) == STATUS_SUCCESS && g_DeviceExtension->PendingReads.Queue.Count == 0;
+    for (i = 0; i < 4; i++) {
+        result = result && ReadCancelled(reads[i]);
+        HostFreeIrp(reads[i]);
+    }
+
+    return result;
+}
+
+// MAP_RING / UNMAP_RING con el handle de las pruebas
+static NTSTATUS MapRing(ULONG Code, PVOID Buffer, ULONG InputLength, ULONG OutputLength)
+{
+    PIRP irp = HostAllocateIrp(IRP_MJ_DEVICE_CONTROL, &g_FileObject);
+    PIO_STACK_LOCATION stack = IoGetCurrentIrpStackLocation(irp);
+    NTSTATUS status;
+
+    irp->AssociatedIrp.SystemBuffer = Buffer;
+    stack->Parameters.DeviceIoControl.IoControlCode = Code;
+    stack->Parameters.DeviceIoControl.InputBufferLength = InputLength;
+    stack->Parameters.DeviceIoControl.OutputBufferLength = OutputLength;
+
+    status = g_DriverObject.MajorFunction[IRP_MJ_DEVICE_CONTROL](g_DriverObject.DeviceObject, irp);
+    HostFreeIrp(irp);
+    return status;
+}
+
+BOOLEAN TestReadUnderruns(void) {
+    static SHORT output[TEST_MAX_FRAMES * TEST_CHANNELS];
+    UCHAR mapBuffer[max(sizeof(MAP_RING_REQUEST), sizeof(MAP_RING_RESPONSE))];
+    PSTAT_COUNTERS stats = &g_DeviceExtension->Stats;
+    ULONG64 underruns = StatCountersRead(stats, STAT_COUNTER_UNDERRUNS);
+    USHORT next = 0;
+    NTSTATUS status;
+    PIRP irp;
+    BOOLEAN result;
+
+    // Completada en el umbral con la mitad de lo pedido: no falta audio
+    irp = StartRead(&g_FileObject, output, TEST_MAX_FRAMES, &status);
+    result = status == STATUS_PENDING && SendFrames(&next, TEST_MIN_FILL) == STATUS_SUCCESS &&
+             ReadCompletedWith(irp, output, TEST_MIN_FILL, 0) &&
+             StatCountersRead(stats, STAT_COUNTER_UNDERRUNS) == underruns;
+    HostFreeIrp(irp);
+
+    // El anillo compartido se sondea: vacío, la lectura vuelve sin frames
+    memset(mapBuffer, 0, sizeof(mapBuffer));
+    if (!result || MapRing(IOCTL_VIRTUALMIC_MAP_RING, mapBuffer, sizeof(MAP_RING_REQUEST),
+                           sizeof(MAP_RING_RESPONSE)) != STATUS_SUCCESS) {
+        return FALSE;
+    }
+
+    irp = StartRead(&g_FileObject, output, TEST_MAX_FRAMES, &status);
+    result = status == STATUS_SUCCESS && irp->IoStatus.Information == 0 &&
+             StatCountersRead(stats, STAT_COUNTER_UNDERRUNS) == underruns + 1;
+    HostFreeIrp(irp);
+
+    return MapRing(IOCTL_VIRTUALMIC_UNMAP_RING, NULL, 0, 0) == STATUS_SUCCESS && result;
+}
+
+// Estado compartido por la prueba de estrés
+typedef struct _STRESS_CONTEXT {
+    SHORT Buffer[STRESS_READ_FRAMES * TEST_CHANNELS];
+    volatile BOOLEAN ReaderDone;
+    volatile BOOLEAN Failed;
+} STRESS_CONTEXT, *PSTRESS_CONTEXT;
+
+static void *StressWriter(void *arg) {
+    PSTRESS_CONTEXT context = (PSTRESS_CONTEXT)arg;
+    USHORT next = 0;
+    ULONG chunkFrames = 1;
+
+    while (!context->ReaderDone) {
+        chunkFrames = (chunkFrames * 7 + 3) % STRESS_MAX_CHUNK + 1;
+
+        // Único productor: si ahora cabe, el envío no se rechaza
+        if (GetBufferFreeFrames(g_DeviceExtension) < chunkFrames) {
+            sched_yield();
+        } else if (SendFrames(&next, chunkFrames) != STATUS_SUCCESS) {
+            context->Failed = TRUE;
+        }
+    }
+
+    return NULL;
+}
+
+static void *StressReader(void *arg) {
+    PSTRESS_CONTEXT context = (PSTRESS_CONTEXT)arg;
+    USHORT expected = 0;
+    NTSTATUS status;
+    PIRP irp;
+    ULONG i;
+    ULONG j;
+
+    for (i = 0; i < STRESS_READS && !context->Failed; i++) {
+        irp = StartRead(&g_FileObject, context->Buffer, STRESS_READ_FRAMES, &status);
+
+        // Algunas lecturas se cancelan mientras compiten con el escritor
+        if (i % 7 == 3) {
+            IoCancelIrp(irp);
+        }
+
+        while (__atomic_load_n(&irp->HostCompleted, __ATOMIC_ACQUIRE) == 0) {
+            sched_yield();
+        }
+
+        // Cancelada o completada, nunca ambas; el audio nunca se salta
+        for (j = 0; j < irp->IoStatus.Information / (TEST_CHANNELS * sizeof(SHORT)); j++) {
+            if ((USHORT)context->Buffer[j * TEST_CHANNELS] != expected++) {
+                context->Failed = TRUE;
+            }
+        }
+
+        if (irp->HostCompleted != 1 || (irp->IoStatus.Status == STATUS_SUCCESS && irp->IoStatus.Information == 0) ||
+            (irp->IoStatus.Status != STATUS_SUCCESS && irp->IoStatus.Status != STATUS_CANCELLED)) {
+            context->Failed = TRUE;
+        }
+
+        HostFreeIrp(irp);
+    }
+
+    context->ReaderDone = TRUE;
+    return NULL;
+}
+
+BOOLEAN TestReadConcurrentStress(void) {
+    PSTRESS_CONTEXT context;
+    pthread_t writer;
+    pthread_t reader;
+    BOOLEAN result;
+
+    context = (PSTRESS_CONTEXT)calloc(1, sizeof(STRESS_CONTEXT));
+    if (context == NULL) {
+        return FALSE;
+    }
+
+    pthread_create(&writer, NULL, StressWriter, context);
+    pthread_create(&reader, NULL, StressReader, context);
+
+    pthread_join(reader, NULL);
+    pthread_join(writer, NULL);
+
+    result = !context->Failed && g_DeviceExtension->PendingReads.Queue.Count == 0;
+
+    free(context);
+    return result;
+}
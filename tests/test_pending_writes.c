@@ -0,0 +1,526 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "read_queue.h"
+#include "ring_buffer.h"
+
+// Modelo de modo usuario de src/driver/pending_writes.c (OVERFLOW_POLICY_PEND):
+// la IoCsq se sustituye por un mutex y los IRP por FAKE_WRITE, pero la cola,
+// el umbral de paquete completo y el orden de locks son los del driver.
+
+#define TEST_RING_FRAMES    64
+#define MAX_PACKET_FRAMES   48
+#define STRESS_WRITES       4000
+#define STRESS_IN_FLIGHT    4
+
+typedef struct _FAKE_WRITE {
+    READ_QUEUE_ENTRY Entry;
+    PVOID FileObject;
+    BOOLEAN Queued;
+    USHORT Data[TEST_RING_FRAMES];
+    ULONG Frames;
+    volatile NTSTATUS Status;
+    volatile LONG Completions;
+} FAKE_WRITE, *PFAKE_WRITE;
+
+typedef struct _FAKE_DEVICE {
+    RING_BUFFER Ring;
+    USHORT Storage[TEST_RING_FRAMES];
+    READ_QUEUE WriteQueue;
+    pthread_mutex_t ProducerLock;
+    pthread_mutex_t QueueLock;      // Lock de la IoCsq
+    pthread_mutex_t CompletionLock; // Modela la espera de E/S solapada
+    pthread_cond_t Completed;
+    volatile LONG Overruns;
+} FAKE_DEVICE, *PFAKE_DEVICE;
+
+// Funciones de prueba
+BOOLEAN TestWritePendsUntilPacketFits(void);
+BOOLEAN TestWriteFifoOrder(void);
+BOOLEAN TestWriteCancelAndOversize(void);
+BOOLEAN TestWriteFlushByFile(void);
+BOOLEAN TestWriteProducerConsumerStress(void);
+
+static void FakeDeviceInit(PFAKE_DEVICE device) {
+    memset(device, 0, sizeof(*device));
+    RingBufferInitialize(&device->Ring, device->Storage, TEST_RING_FRAMES, sizeof(USHORT));
+    ReadQueueInitialize(&device->WriteQueue, 0xFFFFFFFFUL);
+    pthread_mutex_init(&device->ProducerLock, NULL);
+    pthread_mutex_init(&device->QueueLock, NULL);
+    pthread_mutex_init(&device->CompletionLock, NULL);
+    pthread_cond_init(&device->Completed, NULL);
+}
+
+static void FakeInitWrite(PFAKE_WRITE write, USHORT *next, ULONG frames, PVOID fileObject) {
+    ULONG i;
+
+    memset(write, 0, sizeof(*write));
+    write->Frames = frames;
+    write->FileObject = fileObject;
+    write->Status = STATUS_PENDING;
+
+    for (i = 0; i < frames; i++) {
+        write->Data[i] = (*next)++;
+    }
+}
+
+static void FakeComplete(PFAKE_DEVICE device, PFAKE_WRITE write, NTSTATUS status) {
+    pthread_mutex_lock(&device->CompletionLock);
+    write->Status = status;
+    write->Completions++;
+    pthread_cond_broadcast(&device->Completed);
+    pthread_mutex_unlock(&device->CompletionLock);
+}
+
+// ServicePendingWrites: lo llama el lector tras liberar espacio
+static void FakeService(PFAKE_DEVICE device) {
+    PREAD_QUEUE_ENTRY entry;
+    PFAKE_WRITE write;
+
+    if (__atomic_load_n(&device->WriteQueue.Count, __ATOMIC_SEQ_CST) == 0) {
+        return;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&device->ProducerLock);
+        pthread_mutex_lock(&device->QueueLock);
+        entry = ReadQueuePeekReady(&device->WriteQueue, RingBufferGetFreeFrames(&device->Ring));
+        if (entry != NULL) {
+            ReadQueueRemove(&device->WriteQueue, entry);
+            CONTAINING_RECORD(entry, FAKE_WRITE, Entry)->Queued = FALSE;
+        }
+        pthread_mutex_unlock(&device->QueueLock);
+
+        if (entry != NULL) {
+            write = CONTAINING_RECORD(entry, FAKE_WRITE, Entry);
+            RingBufferWrite(&device->Ring, write->Data, write->Frames);
+        }
+        pthread_mutex_unlock(&device->ProducerLock);
+
+        if (entry == NULL) {
+            break;
+        }
+
+        FakeComplete(device, write, STATUS_SUCCESS);
+    }
+}
+
+// QueueOrCompleteWrite
+static NTSTATUS FakeSubmitWrite(PFAKE_DEVICE device, PFAKE_WRITE write) {
+    BOOLEAN written = FALSE;
+
+    if (write->Frames > device->Ring.Capacity) {
+        return STATUS_BUFFER_TOO_SMALL;
+    }
+
+    pthread_mutex_lock(&device->ProducerLock);
+    if (device->WriteQueue.Count == 0 && RingBufferGetFreeFrames(&device->Ring) >= write->Frames) {
+        RingBufferWrite(&device->Ring, write->Data, write->Frames);
+        written = TRUE;
+    }
+    pthread_mutex_unlock(&device->ProducerLock);
+
+    if (written) {
+        FakeComplete(device, write, STATUS_SUCCESS);
+        return STATUS_SUCCESS;
+    }
+
+    __atomic_add_fetch(&device->Overruns, 1, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_lock(&device->QueueLock);
+    write->Queued = TRUE;
+    ReadQueueInsert(&device->WriteQueue, &write->Entry, write->Frames);
+    pthread_mutex_unlock(&device->QueueLock);
+
+    FakeService(device);
+    return STATUS_PENDING;
+}
+
+// ReadAudioFromBuffer seguido de ServicePendingWrites
+static ULONG FakeRead(PFAKE_DEVICE device, USHORT *data, ULONG frames) {
+    ULONG framesRead = RingBufferRead(&device->Ring, data, frames);
+
+    if (framesRead > 0) {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        FakeService(device);
+    }
+
+    return framesRead;
+}
+
+// Rutina de cancelación de la IoCsq
+static void FakeCancel(PFAKE_DEVICE device, PFAKE_WRITE write) {
+    BOOLEAN cancelled = FALSE;
+
+    pthread_mutex_lock(&device->QueueLock);
+    if (write->Queued) {
+        ReadQueueRemove(&device->WriteQueue, &write->Entry);
+        write->Queued = FALSE;
+        cancelled = TRUE;
+    }
+    pthread_mutex_unlock(&device->QueueLock);
+
+    if (cancelled) {
+        FakeComplete(device, write, STATUS_CANCELLED);
+    }
+}
+
+// FlushPendingWrites
+static void FakeFlush(PFAKE_DEVICE device, PVOID fileObject) {
+    PREAD_QUEUE_ENTRY entry;
+
+    for (;;) {
+        pthread_mutex_lock(&device->QueueLock);
+        entry = ReadQueueNext(&device->WriteQueue, NULL);
+        while (entry != NULL && fileObject != NULL &&
+               CONTAINING_RECORD(entry, FAKE_WRITE, Entry)->FileObject != fileObject) {
+            entry = ReadQueueNext(&device->WriteQueue, entry);
+        }
+        if (entry != NULL) {
+            ReadQueueRemove(&device->WriteQueue, entry);
+            CONTAINING_RECORD(entry, FAKE_WRITE, Entry)->Queued = FALSE;
+        }
+        pthread_mutex_unlock(&device->QueueLock);
+
+        if (entry == NULL) {
+            break;
+        }
+
+        FakeComplete(device, CONTAINING_RECORD(entry, FAKE_WRITE, Entry), STATUS_CANCELLED);
+    }
+}
+
+static BOOLEAN ExpectSequence(const USHORT *data, ULONG frames, USHORT first) {
+    ULONG i;
+
+    for (i = 0; i < frames; i++) {
+        if (data[i] != (USHORT)(first + i)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas de envíos pendientes (contrapresión) ===\n\n");
+
+    printf("1. Prueba de envío pendiente hasta que cabe el paquete...\n");
+    if (TestWritePendsUntilPacketFits()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de orden FIFO entre envíos...\n");
+    if (TestWriteFifoOrder()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de cancelación y paquete mayor que el anillo...\n");
+    if (TestWriteCancelAndOversize()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de vaciado al cerrar un handle...\n");
+    if (TestWriteFlushByFile()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de productor más rápido que el consumidor...\n");
+    if (TestWriteProducerConsumerStress()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestWritePendsUntilPacketFits(void) {
+    static FAKE_DEVICE device;
+    FAKE_WRITE fill;
+    FAKE_WRITE pending;
+    USHORT readData[TEST_RING_FRAMES];
+    USHORT next = 0;
+
+    FakeDeviceInit(&device);
+
+    FakeInitWrite(&fill, &next, 40, NULL);
+    if (FakeSubmitWrite(&device, &fill) != STATUS_SUCCESS) {
+        return FALSE;
+    }
+
+    // 40 + 32 frames no caben en 64: el envío queda pendiente
+    FakeInitWrite(&pending, &next, 32, NULL);
+    if (FakeSubmitWrite(&device, &pending) != STATUS_PENDING || device.Overruns != 1) {
+        return FALSE;
+    }
+
+    // Liberar menos de lo necesario no escribe una parte del paquete
+    FakeRead(&device, readData, 4);
+    if (pending.Completions != 0 || RingBufferGetUsedFrames(&device.Ring) != 36) {
+        return FALSE;
+    }
+
+    FakeRead(&device, readData, 4);
+    if (pending.Completions != 1 || pending.Status != STATUS_SUCCESS ||
+        RingBufferGetUsedFrames(&device.Ring) != 64) {
+        return FALSE;
+    }
+
+    // El audio sale en el orden de los envíos
+    return FakeRead(&device, readData, TEST_RING_FRAMES) == 64 && ExpectSequence(readData, 64, 8);
+}
+
+BOOLEAN TestWriteFifoOrder(void) {
+    static FAKE_DEVICE device;
+    FAKE_WRITE fill;
+    FAKE_WRITE large;
+    FAKE_WRITE small;
+    USHORT readData[TEST_RING_FRAMES];
+    USHORT next = 0;
+
+    FakeDeviceInit(&device);
+
+    FakeInitWrite(&fill, &next, 60, NULL);
+    FakeSubmitWrite(&device, &fill);
+
+    FakeInitWrite(&large, &next, 32, NULL);
+    FakeInitWrite(&small, &next, 2, NULL);
+
+    // El paquete pequeño cabría, pero no adelanta al que espera
+    if (FakeSubmitWrite(&device, &large) != STATUS_PENDING ||
+        FakeSubmitWrite(&device, &small) != STATUS_PENDING) {
+        return FALSE;
+    }
+
+    if (FakeRead(&device, readData, 28) != 28 || large.Completions != 1 || small.Completions != 0) {
+        return FALSE;
+    }
+
+    if (FakeRead(&device, readData, 2) != 2 || small.Completions != 1) {
+        return FALSE;
+    }
+
+    return FakeRead(&device, readData, TEST_RING_FRAMES) == 64 && ExpectSequence(readData, 64, 30);
+}
+
+BOOLEAN TestWriteCancelAndOversize(void) {
+    static FAKE_DEVICE device;
+    FAKE_WRITE fill;
+    FAKE_WRITE first;
+    FAKE_WRITE second;
+    FAKE_WRITE oversize;
+    USHORT readData[TEST_RING_FRAMES];
+    USHORT next = 0;
+    USHORT secondStart;
+
+    FakeDeviceInit(&device);
+
+    // Un paquete mayor que el anillo nunca cabría: se rechaza sin encolar
+    FakeInitWrite(&oversize, &next, MAX_PACKET_FRAMES, NULL);
+    oversize.Frames = TEST_RING_FRAMES + 1;
+    if (FakeSubmitWrite(&device, &oversize) != STATUS_BUFFER_TOO_SMALL || device.WriteQueue.Count != 0) {
+        return FALSE;
+    }
+
+    next = 0;
+    FakeInitWrite(&fill, &next, 48, NULL);
+    FakeSubmitWrite(&device, &fill);
+
+    FakeInitWrite(&first, &next, 32, NULL);
+    secondStart = next;
+    FakeInitWrite(&second, &next, 16, NULL);
+    FakeSubmitWrite(&device, &first);
+    FakeSubmitWrite(&device, &second);
+
+    // Cancelar la cabeza no toca el anillo y deja paso a la siguiente
+    FakeCancel(&device, &first);
+    if (first.Completions != 1 || first.Status != STATUS_CANCELLED ||
+        RingBufferGetUsedFrames(&device.Ring) != 48) {
+        return FALSE;
+    }
+
+    FakeRead(&device, readData, 16);
+    if (second.Completions != 1 || second.Status != STATUS_SUCCESS) {
+        return FALSE;
+    }
+
+    // Cancelar un envío ya completado no tiene efecto
+    FakeCancel(&device, &second);
+    if (second.Completions != 1) {
+        return FALSE;
+    }
+
+    return FakeRead(&device, readData, TEST_RING_FRAMES) == 48 &&
+           ExpectSequence(readData, 32, 16) && ExpectSequence(readData + 32, 16, secondStart);
+}
+
+BOOLEAN TestWriteFlushByFile(void) {
+    static FAKE_DEVICE device;
+    FAKE_WRITE fill;
+    FAKE_WRITE writes[4];
+    USHORT next = 0;
+    int fileA = 0;
+    int fileB = 0;
+    ULONG i;
+
+    FakeDeviceInit(&device);
+
+    FakeInitWrite(&fill, &next, TEST_RING_FRAMES / 2, NULL);
+    FakeSubmitWrite(&device, &fill);
+    FakeInitWrite(&fill, &next, TEST_RING_FRAMES / 2, NULL);
+    FakeSubmitWrite(&device, &fill);
+
+    for (i = 0; i < 4; i++) {
+        FakeInitWrite(&writes[i], &next, 8, (i % 2 == 0) ? (PVOID)&fileA : (PVOID)&fileB);
+        FakeSubmitWrite(&device, &writes[i]);
+    }
+
+    FakeFlush(&device, &fileA);
+    if (device.WriteQueue.Count != 2 || writes[0].Completions != 1 || writes[2].Completions != 1 ||
+        writes[1].Completions != 0 || writes[3].Completions != 0) {
+        return FALSE;
+    }
+
+    // Descarga del driver: todos
+    FakeFlush(&device, NULL);
+    for (i = 0; i < 4; i++) {
+        if (writes[i].Completions != 1 || writes[i].Status != STATUS_CANCELLED) {
+            return FALSE;
+        }
+    }
+
+    return device.WriteQueue.Count == 0 && RingBufferGetUsedFrames(&device.Ring) == TEST_RING_FRAMES;
+}
+
+// Estado compartido por la prueba de estrés
+typedef struct _STRESS_CONTEXT {
+    FAKE_DEVICE Device;
+    FAKE_WRITE Writes[STRESS_WRITES];
+    ULONG64 TotalFrames;
+    volatile BOOLEAN Failed;
+} STRESS_CONTEXT, *PSTRESS_CONTEXT;
+
+static void *StressProducer(void *arg) {
+    PSTRESS_CONTEXT context = (PSTRESS_CONTEXT)arg;
+    PFAKE_DEVICE device = &context->Device;
+    USHORT next = 0;
+    ULONG frames = 1;
+    ULONG i;
+
+    for (i = 0; i < STRESS_WRITES; i++) {
+        // Como un lector de ficheros con varias escrituras solapadas: espera a
+        // que se complete la más antigua en lugar de reintentar
+        if (i >= STRESS_IN_FLIGHT) {
+            PFAKE_WRITE oldest = &context->Writes[i - STRESS_IN_FLIGHT];
+
+            pthread_mutex_lock(&device->CompletionLock);
+            while (oldest->Completions == 0) {
+                pthread_cond_wait(&device->Completed, &device->CompletionLock);
+            }
+            pthread_mutex_unlock(&device->CompletionLock);
+        }
+
+        frames = (frames * 7 + 5) % MAX_PACKET_FRAMES + 1;
+        FakeInitWrite(&context->Writes[i], &next, frames, NULL);
+
+        if (FakeSubmitWrite(device, &context->Writes[i]) == STATUS_BUFFER_TOO_SMALL) {
+            context->Failed = TRUE;
+        }
+    }
+
+    return NULL;
+}
+
+static void *StressConsumer(void *arg) {
+    PSTRESS_CONTEXT context = (PSTRESS_CONTEXT)arg;
+    USHORT chunk[TEST_RING_FRAMES];
+    USHORT expected = 0;
+    ULONG64 position = 0;
+    ULONG request = 1;
+    ULONG n;
+    ULONG i;
+
+    while (position < context->TotalFrames && !context->Failed) {
+        request = (request * 5 + 3) % TEST_RING_FRAMES + 1;
+
+        n = FakeRead(&context->Device, chunk, request);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (chunk[i] != expected++) {
+                context->Failed = TRUE;
+            }
+        }
+
+        position += n;
+    }
+
+    return NULL;
+}
+
+BOOLEAN TestWriteProducerConsumerStress(void) {
+    PSTRESS_CONTEXT context;
+    pthread_t producer;
+    pthread_t consumer;
+    BOOLEAN result;
+    ULONG frames = 1;
+    ULONG i;
+
+    context = (PSTRESS_CONTEXT)calloc(1, sizeof(STRESS_CONTEXT));
+    if (context == NULL) {
+        return FALSE;
+    }
+
+    FakeDeviceInit(&context->Device);
+
+    // Misma secuencia de tamaños que el productor
+    for (i = 0; i < STRESS_WRITES; i++) {
+        frames = (frames * 7 + 5) % MAX_PACKET_FRAMES + 1;
+        context->TotalFrames += frames;
+    }
+
+    pthread_create(&producer, NULL, StressProducer, context);
+    pthread_create(&consumer, NULL, StressConsumer, context);
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    result = !context->Failed && context->Device.WriteQueue.Count == 0 &&
+             RingBufferGetUsedFrames(&context->Device.Ring) == 0;
+
+    for (i = 0; i < STRESS_WRITES; i++) {
+        if (context->Writes[i].Completions != 1 || context->Writes[i].Status != STATUS_SUCCESS) {
+            result = FALSE;
+        }
+    }
+
+    free(context);
+    return result;
+}
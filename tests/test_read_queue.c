@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "read_queue.h"
+
+// La cola de src/audio/read_queue.c por sí sola: umbral, cabeza lista y
+// recorrido. El camino de lectura del driver que la usa (pendiente, FIFO,
+// cancelación, cierre y concurrencia) se prueba en test_pending_reads.c.
+
+#define TEST_MIN_FILL 8
+
+// Funciones de prueba
+BOOLEAN TestReadQueueThreshold(void);
+BOOLEAN TestReadQueuePeekReady(void);
+BOOLEAN TestReadQueueRemoveAndNext(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 3;
+
+    printf("=== Iniciando pruebas de la cola de lecturas ===\n\n");
+
+    printf("1. Prueba del umbral de llenado mínimo...\n");
+    if (TestReadQueueThreshold()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de cabeza lista en orden FIFO...\n");
+    if (TestReadQueuePeekReady()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de retirada y recorrido...\n");
+    if (TestReadQueueRemoveAndNext()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestReadQueueThreshold(void) {
+    READ_QUEUE queue;
+
+    ReadQueueInitialize(&queue, TEST_MIN_FILL);
+
+    // El umbral, o la lectura entera si pide menos; nunca cero
+    if (ReadQueueThreshold(&queue, 16) != TEST_MIN_FILL || ReadQueueThreshold(&queue, 2) != 2 ||
+        ReadQueueThreshold(&queue, 0) != 1) {
+        return FALSE;
+    }
+
+    // Un umbral de cero equivale a un frame
+    ReadQueueInitialize(&queue, 0);
+    return queue.MinFillFrames == 1 && ReadQueueThreshold(&queue, 16) == 1;
+}
+
+BOOLEAN TestReadQueuePeekReady(void) {
+    READ_QUEUE queue;
+    READ_QUEUE_ENTRY first;
+    READ_QUEUE_ENTRY second;
+
+    ReadQueueInitialize(&queue, TEST_MIN_FILL);
+    if (ReadQueuePeekReady(&queue, MAXULONG) != NULL) {
+        return FALSE;
+    }
+
+    ReadQueueInsert(&queue, &first, 16);
+    ReadQueueInsert(&queue, &second, 2);
+
+    // La segunda cabría con 2 frames, pero solo se mira la cabeza
+    if (queue.Count != 2 || ReadQueuePeekReady(&queue, 2) != NULL ||
+        ReadQueuePeekReady(&queue, TEST_MIN_FILL) != &first) {
+        return FALSE;
+    }
+
+    ReadQueueRemove(&queue, &first);
+    return ReadQueuePeekReady(&queue, 1) == NULL && ReadQueuePeekReady(&queue, 2) == &second;
+}
+
+BOOLEAN TestReadQueueRemoveAndNext(void) {
+    READ_QUEUE queue;
+    READ_QUEUE_ENTRY entries[4];
+    ULONG i;
+
+    ReadQueueInitialize(&queue, TEST_MIN_FILL);
+    for (i = 0; i < 4; i++) {
+        ReadQueueInsert(&queue, &entries[i], i + 1);
+    }
+
+    // Retirar del centro conserva el orden del resto
+    ReadQueueRemove(&queue, &entries[1]);
+    ReadQueueRemove(&queue, &entries[2]);
+    if (queue.Count != 2 || ReadQueueNext(&queue, NULL) != &entries[0] ||
+        ReadQueueNext(&queue, &entries[0]) != &entries[3] || ReadQueueNext(&queue, &entries[3]) != NULL) {
+        return FALSE;
+    }
+
+    ReadQueueRemove(&queue, &entries[0]);
+    ReadQueueRemove(&queue, &entries[3]);
+    return queue.Count == 0 && ReadQueueNext(&queue, NULL) == NULL && entries[3].Frames == 4;
+}
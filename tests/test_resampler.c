@@ -0,0 +1,430 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "resampler.h"
+#include "ring_buffer.h"
+
+#define TEST_MAX_CHANNELS  2
+#define TEST_SIGNAL_FRAMES 48000
+#define TEST_OUTPUT_FRAMES (TEST_SIGNAL_FRAMES * 4)
+#define TEST_RING_FRAMES   64
+#define TEST_TONE_HZ       997.0
+
+static const char *g_QualityNames[RESAMPLER_QUALITY_COUNT] = { "baja", "media", "alta" };
+
+// THD+N máximo aceptado por calidad (dB respecto al tono)
+static const double g_MaxThdN[RESAMPLER_QUALITY_COUNT] = { -60.0, -80.0, -110.0 };
+
+static UCHAR g_Memory[2 * 1024 * 1024];
+static UCHAR g_MemoryB[2 * 1024 * 1024];
+static float g_Input[TEST_SIGNAL_FRAMES * TEST_MAX_CHANNELS];
+static float g_Output[TEST_OUTPUT_FRAMES * TEST_MAX_CHANNELS];
+static float g_OutputB[TEST_OUTPUT_FRAMES * TEST_MAX_CHANNELS];
+
+// Funciones de prueba
+BOOLEAN TestRatiosAndLimits(void);
+BOOLEAN TestFrameAccounting(void);
+BOOLEAN TestVectorMatchesScalar(void);
+BOOLEAN TestToneQuality(void);
+BOOLEAN TestRingWrite(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas del conversor de frecuencia polifásico ===\n\n");
+
+    printf("1. Prueba de razones reducidas, longitudes de filtro y límites...\n");
+    if (TestRatiosAndLimits()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de cuentas de frames previstas frente a producidas...\n");
+    if (TestFrameAccounting()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de producto escalar SSE2 idéntico al escalar...\n");
+    if (TestVectorMatchesScalar()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de calidad con un tono (THD+N por calidad y ganancia en continua)...\n");
+    if (TestToneQuality()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de escritura en el anillo (espacio limitado y descarte)...\n");
+    if (TestRingWrite()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+static PRESAMPLER CreateResampler(PUCHAR memory, ULONG inputRate, ULONG outputRate, ULONG channels,
+                                  SAMPLE_FORMAT source, SAMPLE_FORMAT target,
+                                  RESAMPLER_QUALITY quality, SAMPLE_CONVERT_ISA isa) {
+    RESAMPLER_CONFIG config;
+    PRESAMPLER resampler;
+
+    config.InputRate = inputRate;
+    config.OutputRate = outputRate;
+    config.Channels = channels;
+    config.SourceFormat = source;
+    config.TargetFormat = target;
+    config.Quality = quality;
+    config.Isa = isa;
+
+    if (!NT_SUCCESS(ResamplerInitialize(memory, sizeof(g_Memory), &config, &resampler))) {
+        return NULL;
+    }
+
+    return resampler;
+}
+
+// Ajuste por mínimos cuadrados de un seno de frecuencia conocida: el residuo
+// es ruido más distorsión (incluidos imágenes y alias del conversor)
+static double MeasureThdN(const float *signal, ULONG frames, ULONG stride, double frequency, double rate) {
+    double scc = 0.0, sss = 0.0, scs = 0.0, syc = 0.0, sys = 0.0;
+    double det, a, b, c, s, fit, residual = 0.0, power = 0.0;
+    ULONG i;
+
+    for (i = 0; i < frames; i++) {
+        c = cos(2.0 * M_PI * frequency * i / rate);
+        s = sin(2.0 * M_PI * frequency * i / rate);
+        scc += c * c;
+        sss += s * s;
+        scs += c * s;
+        syc += signal[i * stride] * c;
+        sys += signal[i * stride] * s;
+    }
+
+    det = scc * sss - scs * scs;
+    a = (syc * sss - sys * scs) / det;
+    b = (sys * scc - syc * scs) / det;
+
+    for (i = 0; i < frames; i++) {
+        fit = a * cos(2.0 * M_PI * frequency * i / rate) + b * sin(2.0 * M_PI * frequency * i / rate);
+        residual += (signal[i * stride] - fit) * (signal[i * stride] - fit);
+        power += fit * fit;
+    }
+
+    return 10.0 * log10(residual / power);
+}
+
+BOOLEAN TestRatiosAndLimits(void) {
+    RESAMPLER_CONFIG config;
+    PRESAMPLER resampler;
+
+    resampler = CreateResampler(g_Memory, 44100, 48000, 2, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                                RESAMPLER_QUALITY_MEDIUM, SAMPLE_CONVERT_ISA_SCALAR);
+    if (resampler == NULL || resampler->Interpolation != 160 || resampler->Decimation != 147 ||
+        resampler->Taps != 32) {
+        return FALSE;
+    }
+
+    // Al diezmar el filtro se alarga en proporción (48 -> 8 kHz: 6 veces)
+    resampler = CreateResampler(g_Memory, 48000, 8000, 1, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT16,
+                                RESAMPLER_QUALITY_HIGH, SAMPLE_CONVERT_ISA_SCALAR);
+    if (resampler == NULL || resampler->Interpolation != 1 || resampler->Decimation != 6 ||
+        resampler->Taps != 384) {
+        return FALSE;
+    }
+
+    // El peor par estándar cabe: 11.025 -> 192 kHz son 2560 fases
+    resampler = CreateResampler(g_Memory, 11025, 192000, 2, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT32,
+                                RESAMPLER_QUALITY_HIGH, SAMPLE_CONVERT_ISA_SCALAR);
+    if (resampler == NULL || resampler->Interpolation != 2560) {
+        return FALSE;
+    }
+
+    // Razones con demasiadas fases, parámetros inválidos y memoria corta
+    config.InputRate = 8000;
+    config.OutputRate = 8001;
+    config.Channels = 2;
+    config.SourceFormat = SAMPLE_FORMAT_INT16;
+    config.TargetFormat = SAMPLE_FORMAT_INT16;
+    config.Quality = RESAMPLER_QUALITY_LOW;
+    config.Isa = SAMPLE_CONVERT_ISA_SCALAR;
+    if (ResamplerGetRequiredSize(&config) != 0 ||
+        ResamplerInitialize(g_Memory, sizeof(g_Memory), &config, &resampler) != STATUS_NOT_SUPPORTED ||
+        resampler != NULL) {
+        return FALSE;
+    }
+
+    config.OutputRate = 48000;
+    config.Channels = 0;
+    if (ResamplerInitialize(g_Memory, sizeof(g_Memory), &config, &resampler) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    config.Channels = 2;
+    return ResamplerGetRequiredSize(&config) > sizeof(RESAMPLER) &&
+           ResamplerInitialize(g_Memory, ResamplerGetRequiredSize(&config) - 1, &config, &resampler) ==
+               STATUS_BUFFER_TOO_SMALL &&
+           ResamplerInitialize(g_Memory, ResamplerGetRequiredSize(&config), &config, &resampler) == STATUS_SUCCESS;
+}
+
+BOOLEAN TestFrameAccounting(void) {
+    static const ULONG rates[][2] = {
+        { 44100, 48000 }, { 48000, 44100 }, { 16000, 48000 }, { 48000, 16000 }, { 48000, 8000 }, { 8000, 44100 }
+    };
+    PRESAMPLER resampler;
+    ULONG64 totalInput;
+    ULONG64 totalOutput;
+    ULONG pair;
+    ULONG chunk;
+    ULONG space;
+    ULONG predicted;
+    ULONG produced;
+    ULONG consumed;
+    ULONG round;
+
+    srand(7);
+
+    for (pair = 0; pair < sizeof(rates) / sizeof(rates[0]); pair++) {
+        resampler = CreateResampler(g_Memory, rates[pair][0], rates[pair][1], 2, SAMPLE_FORMAT_FLOAT32,
+                                    SAMPLE_FORMAT_FLOAT32, RESAMPLER_QUALITY_LOW, SAMPLE_CONVERT_ISA_SCALAR);
+        if (resampler == NULL) {
+            return FALSE;
+        }
+
+        totalInput = 0;
+        totalOutput = 0;
+
+        for (round = 0; round < 200; round++) {
+            chunk = (ULONG)(rand() % 700);
+
+            // Con espacio de sobra se consume todo y sale justo lo previsto
+            // y nunca más que la cota independiente del estado
+            predicted = ResamplerGetOutputFrames(resampler, chunk);
+            if (predicted > ResamplerGetMaxOutputFrames(resampler, chunk)) {
+                return FALSE;
+            }
+            produced = ResamplerProcess(resampler, g_Input, chunk, &consumed, g_Output, TEST_OUTPUT_FRAMES);
+            if (consumed != chunk || produced != predicted) {
+                printf("   %u -> %u Hz: %u frames dieron %u (previstos %u)\n",
+                       rates[pair][0], rates[pair][1], chunk, produced, predicted);
+                return FALSE;
+            }
+            totalInput += consumed;
+            totalOutput += produced;
+
+            // Con espacio limitado solo se consume la entrada cuya salida cabe
+            space = (ULONG)(rand() % 300);
+            predicted = min(chunk, ResamplerGetInputFrames(resampler, space));
+            produced = ResamplerProcess(resampler, g_Input, chunk, &consumed, g_Output, space);
+            if (consumed != predicted || produced > space) {
+                return FALSE;
+            }
+            totalInput += consumed;
+            totalOutput += produced;
+        }
+
+        // Desde el estado inicial N frames de entrada dan ceil(N * L / M)
+        if (totalOutput != (totalInput * resampler->Interpolation + resampler->Decimation - 1) /
+                           resampler->Decimation) {
+            printf("   %u -> %u Hz: %llu frames de salida para %llu de entrada\n", rates[pair][0], rates[pair][1],
+                   (unsigned long long)totalOutput, (unsigned long long)totalInput);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestVectorMatchesScalar(void) {
+    static const ULONG rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 48000, 16000 } };
+    PRESAMPLER scalar;
+    PRESAMPLER vector;
+    ULONG pair;
+    ULONG quality;
+    ULONG offset;
+    ULONG chunk;
+    ULONG consumed;
+    ULONG producedScalar;
+    ULONG producedVector;
+    ULONG totalOutput;
+    ULONG i;
+
+    if (!SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SSE2)) {
+        printf("   SSE2 no disponible en esta CPU: se omite\n");
+        return TRUE;
+    }
+
+    srand(11);
+    for (i = 0; i < TEST_SIGNAL_FRAMES * 2; i++) {
+        g_Input[i] = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+    }
+
+    for (pair = 0; pair < sizeof(rates) / sizeof(rates[0]); pair++) {
+        for (quality = 0; quality < RESAMPLER_QUALITY_COUNT; quality++) {
+            scalar = CreateResampler(g_Memory, rates[pair][0], rates[pair][1], 2, SAMPLE_FORMAT_FLOAT32,
+                                     SAMPLE_FORMAT_FLOAT32, (RESAMPLER_QUALITY)quality, SAMPLE_CONVERT_ISA_SCALAR);
+            vector = CreateResampler(g_MemoryB, rates[pair][0], rates[pair][1], 2, SAMPLE_FORMAT_FLOAT32,
+                                     SAMPLE_FORMAT_FLOAT32, (RESAMPLER_QUALITY)quality, SAMPLE_CONVERT_ISA_SSE2);
+            if (scalar == NULL || vector == NULL || !vector->Vectorized) {
+                return FALSE;
+            }
+
+            // Paquetes de tamaños distintos: el estado entre llamadas también debe coincidir
+            totalOutput = 0;
+            for (offset = 0; offset < 20000; offset += chunk) {
+                chunk = 1 + (offset * 7919) % 613;
+                producedScalar = ResamplerProcess(scalar, g_Input + offset * 2, chunk, &consumed,
+                                                  g_Output + totalOutput * 2, TEST_OUTPUT_FRAMES - totalOutput);
+                producedVector = ResamplerProcess(vector, g_Input + offset * 2, chunk, &consumed,
+                                                  g_OutputB + totalOutput * 2, TEST_OUTPUT_FRAMES - totalOutput);
+                if (producedScalar != producedVector) {
+                    return FALSE;
+                }
+                totalOutput += producedScalar;
+            }
+
+            if (memcmp(g_Output, g_OutputB, (SIZE_T)totalOutput * 2 * sizeof(float)) != 0) {
+                printf("   %u -> %u Hz, calidad %s: salida distinta\n",
+                       rates[pair][0], rates[pair][1], g_QualityNames[quality]);
+                return FALSE;
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestToneQuality(void) {
+    static const ULONG rates[][2] = { { 44100, 48000 }, { 48000, 44100 }, { 48000, 16000 }, { 16000, 48000 } };
+    PRESAMPLER resampler;
+    ULONG pair;
+    ULONG quality;
+    ULONG consumed;
+    ULONG produced;
+    ULONG settle;
+    ULONG i;
+    double alias;
+    double thdN;
+
+    for (pair = 0; pair < sizeof(rates) / sizeof(rates[0]); pair++) {
+        // Al diezmar, un segundo tono por encima de la Nyquist de salida mide el alias
+        alias = (rates[pair][1] + 0.375 * ((double)rates[pair][0] - rates[pair][1])) / 2.0;
+        for (i = 0; i < rates[pair][0] / 2; i++) {
+            g_Input[i] = (float)(0.5 * sin(2.0 * M_PI * TEST_TONE_HZ * i / rates[pair][0]));
+            if (rates[pair][1] < rates[pair][0]) {
+                g_Input[i] += (float)(0.25 * sin(2.0 * M_PI * alias * i / rates[pair][0]));
+            }
+        }
+
+        printf("   %6u -> %6u Hz:", rates[pair][0], rates[pair][1]);
+        for (quality = 0; quality < RESAMPLER_QUALITY_COUNT; quality++) {
+            resampler = CreateResampler(g_Memory, rates[pair][0], rates[pair][1], 1, SAMPLE_FORMAT_FLOAT32,
+                                        SAMPLE_FORMAT_FLOAT32, (RESAMPLER_QUALITY)quality,
+                                        SampleConvertGetBestIsa());
+            if (resampler == NULL) {
+                return FALSE;
+            }
+
+            produced = ResamplerProcess(resampler, g_Input, rates[pair][0] / 2, &consumed,
+                                        g_Output, TEST_OUTPUT_FRAMES);
+
+            // Descartar el arranque (la ventana se llena desde silencio)
+            settle = resampler->Taps * resampler->Interpolation / resampler->Decimation + 1;
+            thdN = MeasureThdN(g_Output + settle, produced - 2 * settle, 1, TEST_TONE_HZ, rates[pair][1]);
+            printf(" %s %.1f dB", g_QualityNames[quality], thdN);
+
+            if (thdN > g_MaxThdN[quality]) {
+                printf("\n");
+                return FALSE;
+            }
+        }
+        printf("\n");
+    }
+
+    // Ganancia unidad en continua en todas las fases
+    for (i = 0; i < 4800; i++) {
+        g_Input[i] = 0.25f;
+    }
+
+    resampler = CreateResampler(g_Memory, 44100, 48000, 1, SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_FLOAT32,
+                                RESAMPLER_QUALITY_HIGH, SAMPLE_CONVERT_ISA_SCALAR);
+    produced = ResamplerProcess(resampler, g_Input, 4800, &consumed, g_Output, TEST_OUTPUT_FRAMES);
+    for (i = 200; i < produced; i++) {
+        if (fabs(g_Output[i] - 0.25) > 1e-6) {
+            printf("   Continua: salida %u = %.9f\n", i, g_Output[i]);
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestRingWrite(void) {
+    static SHORT packet[1000 * 2];
+    static SHORT storage[TEST_RING_FRAMES * 2];
+    static SHORT drained[TEST_RING_FRAMES * 2];
+    RING_BUFFER ring;
+    PRESAMPLER resampler;
+    ULONG64 totalInput = 0;
+    ULONG64 totalOutput = 0;
+    ULONG predicted;
+    ULONG consumed;
+    ULONG dropped;
+    ULONG i;
+
+    for (i = 0; i < 1000 * 2; i++) {
+        packet[i] = (SHORT)((i * 2654435761UL) >> 17);
+    }
+
+    resampler = CreateResampler(g_Memory, 44100, 48000, 2, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT16,
+                                RESAMPLER_QUALITY_MEDIUM, SampleConvertGetBestIsa());
+    if (resampler == NULL || !NT_SUCCESS(RingBufferInitialize(&ring, storage, TEST_RING_FRAMES, 4))) {
+        return FALSE;
+    }
+
+    // Anillo más pequeño que la salida: se consume lo que cabe y nada queda retenido
+    while (totalInput < 1000) {
+        predicted = ResamplerGetOutputFrames(resampler,
+                                             min(1000 - (ULONG)totalInput,
+                                                 ResamplerGetInputFrames(resampler, RingBufferGetFreeFrames(&ring))));
+        consumed = ResamplerWriteRing(resampler, &ring, packet + totalInput * 2, 1000 - (ULONG)totalInput);
+        if (RingBufferGetUsedFrames(&ring) != predicted || resampler->Position < resampler->HistoryFrames) {
+            return FALSE;
+        }
+
+        totalInput += consumed;
+        totalOutput += RingBufferRead(&ring, drained, TEST_RING_FRAMES);
+    }
+
+    if (totalOutput != (totalInput * 160 + 146) / 147) {
+        return FALSE;
+    }
+
+    // Descartando lo más antiguo todo el paquete entra y quedan sus últimos frames
+    predicted = ResamplerGetOutputFrames(resampler, 1000);
+    consumed = ResamplerWriteRingDropOldest(resampler, &ring, packet, 1000, &dropped);
+
+    return consumed == 1000 &&
+           dropped == predicted - TEST_RING_FRAMES &&
+           RingBufferGetUsedFrames(&ring) == TEST_RING_FRAMES;
+}
@@ -0,0 +1,353 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ring_buffer.h"
+
+#define STRESS_RING_SIZE    4096
+#define STRESS_TOTAL_BYTES  (64ULL * 1024 * 1024)
+
+// Funciones de prueba
+BOOLEAN TestRingInitialize(void);
+BOOLEAN TestRingBasicReadWrite(void);
+BOOLEAN TestRingWrapAround(void);
+BOOLEAN TestRingFullCapacity(void);
+BOOLEAN TestRingConcurrentStress(void);
+BOOLEAN TestRingDropOldest(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 6;
+
+    printf("=== Iniciando pruebas del buffer circular SPSC ===\n\n");
+
+    printf("1. Prueba de inicialización y tamaño potencia de dos...\n");
+    if (TestRingInitialize()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de escritura/lectura básica...\n");
+    if (TestRingBasicReadWrite()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de wrap-around...\n");
+    if (TestRingWrapAround()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de capacidad completa (sin byte de separación)...\n");
+    if (TestRingFullCapacity()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de estrés productor/consumidor concurrentes...\n");
+    if (TestRingConcurrentStress()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("6. Prueba de política descartar lo más antiguo...\n");
+    if (TestRingDropOldest()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestRingInitialize(void) {
+    RING_BUFFER ring;
+    UCHAR storage[64];
+
+    // Tamaños no potencia de dos se rechazan
+    if (RingBufferInitialize(&ring, storage, 48, 1) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    if (RingBufferInitialize(&ring, NULL, 64, 1) != STATUS_INVALID_PARAMETER) {
+        return FALSE;
+    }
+
+    if (RingBufferRoundUpCapacity(5000) != 8192 || RingBufferRoundUpCapacity(8192) != 8192) {
+        return FALSE;
+    }
+
+    if (!NT_SUCCESS(RingBufferInitialize(&ring, storage, sizeof(storage), 1))) {
+        return FALSE;
+    }
+
+    // Productor y consumidor en líneas de caché distintas
+    if ((size_t)((PUCHAR)&ring.Tail - (PUCHAR)&ring.Head) < VMIC_CACHE_LINE) {
+        return FALSE;
+    }
+
+    return RingBufferGetUsedFrames(&ring) == 0 && RingBufferGetFreeFrames(&ring) == 64;
+}
+
+BOOLEAN TestRingBasicReadWrite(void) {
+    RING_BUFFER ring;
+    UCHAR storage[1024];
+    UCHAR testData[100];
+    UCHAR readData[100];
+    ULONG i;
+
+    RingBufferInitialize(&ring, storage, sizeof(storage), 1);
+
+    for (i = 0; i < sizeof(testData); i++) {
+        testData[i] = (UCHAR)i;
+    }
+
+    if (RingBufferWrite(&ring, testData, sizeof(testData)) != sizeof(testData)) {
+        return FALSE;
+    }
+
+    if (RingBufferGetUsedFrames(&ring) != sizeof(testData)) {
+        return FALSE;
+    }
+
+    if (RingBufferRead(&ring, readData, sizeof(readData)) != sizeof(readData)) {
+        return FALSE;
+    }
+
+    // Lectura de buffer vacío
+    if (RingBufferRead(&ring, readData, sizeof(readData)) != 0) {
+        return FALSE;
+    }
+
+    return memcmp(testData, readData, sizeof(testData)) == 0;
+}
+
+BOOLEAN TestRingWrapAround(void) {
+    RING_BUFFER ring;
+    UCHAR storage[64];
+    UCHAR testData[40];
+    UCHAR readData[40];
+    ULONG i;
+    ULONG round;
+
+    RingBufferInitialize(&ring, storage, sizeof(storage), 1);
+
+    // Varias vueltas completas con escrituras que cruzan el final del buffer
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < sizeof(testData); i++) {
+            testData[i] = (UCHAR)(round * 31 + i);
+        }
+
+        if (RingBufferWrite(&ring, testData, sizeof(testData)) != sizeof(testData)) {
+            return FALSE;
+        }
+
+        if (RingBufferRead(&ring, readData, sizeof(readData)) != sizeof(readData)) {
+            return FALSE;
+        }
+
+        if (memcmp(testData, readData, sizeof(testData)) != 0) {
+            return FALSE;
+        }
+    }
+
+    return RingBufferGetUsedFrames(&ring) == 0;
+}
+
+BOOLEAN TestRingFullCapacity(void) {
+    RING_BUFFER ring;
+    UCHAR storage[256];
+    UCHAR testData[300];
+    UCHAR readData[300];
+
+    RingBufferInitialize(&ring, storage, sizeof(storage), 1);
+    memset(testData, 0x5A, sizeof(testData));
+
+    // Se acepta exactamente la capacidad del buffer
+    if (RingBufferWrite(&ring, testData, sizeof(testData)) != sizeof(storage)) {
+        return FALSE;
+    }
+
+    if (RingBufferGetFreeFrames(&ring) != 0 || RingBufferWrite(&ring, testData, 1) != 0) {
+        return FALSE;
+    }
+
+    if (RingBufferRead(&ring, readData, sizeof(readData)) != sizeof(storage)) {
+        return FALSE;
+    }
+
+    return RingBufferGetFreeFrames(&ring) == sizeof(storage);
+}
+
+BOOLEAN TestRingDropOldest(void) {
+    RING_BUFFER ring;
+    USHORT storage[16];
+    USHORT testData[40];
+    USHORT readData[16];
+    ULONG dropped;
+    ULONG i;
+
+    RingBufferInitialize(&ring, storage, 16, sizeof(USHORT));
+
+    for (i = 0; i < 40; i++) {
+        testData[i] = (USHORT)i;
+    }
+
+    // Con espacio libre no se descarta nada
+    if (RingBufferWriteDropOldest(&ring, testData, 10, &dropped) != 10 || dropped != 0) {
+        return FALSE;
+    }
+
+    // 10 + 10 frames en un anillo de 16: se pierden los 4 más antiguos
+    if (RingBufferWriteDropOldest(&ring, testData + 10, 10, &dropped) != 10 || dropped != 4) {
+        return FALSE;
+    }
+
+    if (RingBufferRead(&ring, readData, 16) != 16) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 16; i++) {
+        if (readData[i] != (USHORT)(i + 4)) {
+            return FALSE;
+        }
+    }
+
+    // Paquete mayor que la capacidad: solo quedan sus últimos 16 frames
+    RingBufferWrite(&ring, testData, 5);
+    if (RingBufferWriteDropOldest(&ring, testData, 40, &dropped) != 16 || dropped != 24 + 5) {
+        return FALSE;
+    }
+
+    if (RingBufferRead(&ring, readData, 16) != 16 || readData[0] != 24 || readData[15] != 39) {
+        return FALSE;
+    }
+
+    // Discard nunca avanza más allá de lo escrito
+    RingBufferWrite(&ring, testData, 3);
+    if (RingBufferDiscard(&ring, 8) != 3 || RingBufferGetUsedFrames(&ring) != 0) {
+        return FALSE;
+    }
+
+    return RingBufferGetFreeFrames(&ring) == 16;
+}
+
+// Estado compartido por la prueba de estrés
+typedef struct _STRESS_CONTEXT {
+    RING_BUFFER Ring;
+    UCHAR Storage[STRESS_RING_SIZE];
+    ULONG64 TotalBytes;
+    volatile BOOLEAN Corrupted;
+} STRESS_CONTEXT, *PSTRESS_CONTEXT;
+
+static UCHAR PatternByte(ULONG64 position) {
+    return (UCHAR)((position * 2654435761ULL) >> 24);
+}
+
+static void *StressProducer(void *arg) {
+    PSTRESS_CONTEXT context = (PSTRESS_CONTEXT)arg;
+    UCHAR chunk[1500];
+    ULONG64 position = 0;
+    ULONG chunkSize = 1;
+    ULONG written;
+    ULONG i;
+
+    while (position < context->TotalBytes && !context->Corrupted) {
+        // Tamaños variables e impares para cruzar el wrap en todas las posiciones
+        chunkSize = (chunkSize * 7 + 13) % sizeof(chunk) + 1;
+        if (position + chunkSize > context->TotalBytes) {
+            chunkSize = (ULONG)(context->TotalBytes - position);
+        }
+
+        for (i = 0; i < chunkSize; i++) {
+            chunk[i] = PatternByte(position + i);
+        }
+
+        written = 0;
+        while (written < chunkSize && !context->Corrupted) {
+            ULONG n = RingBufferWrite(&context->Ring, chunk + written, chunkSize - written);
+            if (n == 0) {
+                sched_yield();
+            }
+            written += n;
+        }
+
+        position += chunkSize;
+    }
+
+    return NULL;
+}
+
+static void *StressConsumer(void *arg) {
+    PSTRESS_CONTEXT context = (PSTRESS_CONTEXT)arg;
+    UCHAR chunk[1024];
+    ULONG64 position = 0;
+    ULONG request = 1;
+    ULONG n;
+    ULONG i;
+
+    while (position < context->TotalBytes) {
+        request = (request * 5 + 3) % sizeof(chunk) + 1;
+
+        n = RingBufferRead(&context->Ring, chunk, request);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (chunk[i] != PatternByte(position + i)) {
+                context->Corrupted = TRUE;
+                return NULL;
+            }
+        }
+
+        position += n;
+    }
+
+    return NULL;
+}
+
+BOOLEAN TestRingConcurrentStress(void) {
+    PSTRESS_CONTEXT context;
+    pthread_t producer;
+    pthread_t consumer;
+    BOOLEAN result;
+
+    context = (PSTRESS_CONTEXT)calloc(1, sizeof(STRESS_CONTEXT));
+    if (context == NULL) {
+        return FALSE;
+    }
+
+    RingBufferInitialize(&context->Ring, context->Storage, sizeof(context->Storage), 1);
+    context->TotalBytes = STRESS_TOTAL_BYTES;
+
+    pthread_create(&producer, NULL, StressProducer, context);
+    pthread_create(&consumer, NULL, StressConsumer, context);
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    result = !context->Corrupted && RingBufferGetUsedFrames(&context->Ring) == 0;
+
+    free(context);
+    return result;
+}
@@ -0,0 +1,388 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ring_buffer.h"
+#include "mirror_buffer.h"
+
+// Redimensionado del anillo con productor y consumidor activos. Reproduce el
+// protocolo de ResizeAudioBuffer: un lock por lado y el redimensionador toma
+// ambos (productor y luego consumidor) mientras migra el audio pendiente.
+
+#define RESIZE_TOTAL_BYTES (32ULL * 1024 * 1024)
+
+// MIN_BUFFER_SIZE y MAX_BUFFER_SIZE de virtual_mic.h
+#define RESIZE_MIN_BYTES 256
+#define RESIZE_MAX_BYTES (8 * 1024 * 1024)
+
+// Funciones de prueba
+BOOLEAN TestMigratePreservesData(void);
+BOOLEAN TestMigrateRejectsSmallTarget(void);
+BOOLEAN TestMigrateToMirrored(void);
+BOOLEAN TestConcurrentResize(void);
+BOOLEAN TestMaximumCapacityOddFrames(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas de redimensionado del buffer ===\n\n");
+
+    printf("1. Prueba de migración sin pérdida de audio...\n");
+    if (TestMigratePreservesData()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de destino demasiado pequeño...\n");
+    if (TestMigrateRejectsSmallTarget()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de migración a buffer espejo...\n");
+    if (TestMigrateToMirrored()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de redimensionado con productor/consumidor concurrentes...\n");
+    if (TestConcurrentResize()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de capacidad máxima con frames de 6 bytes...\n");
+    if (TestMaximumCapacityOddFrames()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestMigratePreservesData(void) {
+    RING_BUFFER source;
+    RING_BUFFER target;
+    UCHAR sourceStorage[64];
+    UCHAR targetStorage[256];
+    UCHAR data[64];
+    ULONG i;
+
+    RingBufferInitialize(&source, sourceStorage, sizeof(sourceStorage), 1);
+    RingBufferInitialize(&target, targetStorage, sizeof(targetStorage), 1);
+
+    // Dejar datos pendientes que cruzan el final del buffer de origen
+    RingBufferWrite(&source, data, 50);
+    RingBufferRead(&source, data, 50);
+    for (i = 0; i < 40; i++) {
+        data[i] = (UCHAR)(i + 1);
+    }
+    RingBufferWrite(&source, data, 40);
+
+    if (!NT_SUCCESS(RingBufferMigrate(&target, &source))) {
+        return FALSE;
+    }
+
+    // Los contadores continúan donde estaban
+    if (target.Tail != 50 || target.Head != 90 || RingBufferGetUsedFrames(&target) != 40) {
+        return FALSE;
+    }
+
+    memset(data, 0, sizeof(data));
+    if (RingBufferRead(&target, data, sizeof(data)) != 40) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 40; i++) {
+        if (data[i] != (UCHAR)(i + 1)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestMigrateRejectsSmallTarget(void) {
+    RING_BUFFER source;
+    RING_BUFFER target;
+    UCHAR sourceStorage[256];
+    UCHAR targetStorage[64];
+    UCHAR data[100] = { 0 };
+
+    RingBufferInitialize(&source, sourceStorage, sizeof(sourceStorage), 1);
+    RingBufferInitialize(&target, targetStorage, sizeof(targetStorage), 1);
+    RingBufferWrite(&source, data, sizeof(data));
+
+    // El origen queda intacto si la migración falla
+    return RingBufferMigrate(&target, &source) == STATUS_BUFFER_TOO_SMALL &&
+           RingBufferGetUsedFrames(&source) == sizeof(data);
+}
+
+BOOLEAN TestMigrateToMirrored(void) {
+    MIRROR_BUFFER mirror;
+    RING_BUFFER source;
+    RING_BUFFER target;
+    UCHAR sourceStorage[1024];
+    UCHAR data[1000];
+    ULONG size = MirrorBufferGetGranularity();
+    ULONG i;
+    BOOLEAN result = TRUE;
+
+    if (!NT_SUCCESS(MirrorBufferAllocate(&mirror, size))) {
+        return FALSE;
+    }
+
+    RingBufferInitialize(&source, sourceStorage, sizeof(sourceStorage), 1);
+    RingBufferInitializeMirrored(&target, mirror.BaseAddress, size, 1);
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = (UCHAR)(i * 7);
+    }
+    RingBufferWrite(&source, data, sizeof(data));
+
+    if (!NT_SUCCESS(RingBufferMigrate(&target, &source))) {
+        result = FALSE;
+    }
+
+    memset(data, 0, sizeof(data));
+    if (RingBufferRead(&target, data, sizeof(data)) != sizeof(data)) {
+        result = FALSE;
+    }
+
+    for (i = 0; i < sizeof(data) && result; i++) {
+        if (data[i] != (UCHAR)(i * 7)) {
+            result = FALSE;
+        }
+    }
+
+    MirrorBufferFree(&mirror);
+    return result;
+}
+
+// Comprobación de ResizeAudioBuffer: los límites se aplican a la capacidad
+// ya redondeada a potencia de dos, que es la que se reserva
+static ULONG ResizeCapacity(ULONG RequestedFrames, ULONG FrameSize) {
+    ULONG capacity = RingBufferRoundUpCapacity(RequestedFrames);
+
+    if ((ULONG64)capacity * FrameSize < RESIZE_MIN_BYTES || (ULONG64)capacity * FrameSize > RESIZE_MAX_BYTES) {
+        return 0;
+    }
+
+    return capacity;
+}
+
+BOOLEAN TestMaximumCapacityOddFrames(void) {
+    const ULONG frameSize = 6; // 24 bits estéreo
+    RING_BUFFER source;
+    RING_BUFFER target;
+    PUCHAR sourceStorage;
+    PUCHAR targetStorage;
+    ULONG capacity;
+    BOOLEAN result;
+
+    // MAX / 6 frames caben en bytes pero se redondean a 2^21 frames (12 MB)
+    if (ResizeCapacity(RESIZE_MAX_BYTES / frameSize, frameSize) != 0 ||
+        ResizeCapacity(RESIZE_MIN_BYTES / frameSize, frameSize) != 64) {
+        return FALSE;
+    }
+
+    // La mayor capacidad admitida es 2^20 frames (6 MB) y se llena entera
+    capacity = ResizeCapacity(1UL << 20, frameSize);
+    if (capacity != (1UL << 20) || ResizeCapacity(capacity + 1, frameSize) != 0) {
+        return FALSE;
+    }
+
+    sourceStorage = (PUCHAR)malloc((SIZE_T)capacity * frameSize);
+    targetStorage = (PUCHAR)malloc((SIZE_T)capacity * frameSize);
+    if (sourceStorage == NULL || targetStorage == NULL) {
+        free(sourceStorage);
+        free(targetStorage);
+        return FALSE;
+    }
+
+    memset(targetStorage, 0x5A, (SIZE_T)capacity * frameSize);
+    RingBufferInitialize(&source, sourceStorage, capacity, frameSize);
+    result = RingBufferWrite(&source, targetStorage, capacity) == capacity &&
+             NT_SUCCESS(RingBufferInitialize(&target, targetStorage, capacity, frameSize)) &&
+             target.Size <= RESIZE_MAX_BYTES &&
+             NT_SUCCESS(RingBufferMigrate(&target, &source)) &&
+             RingBufferGetUsedFrames(&target) == capacity;
+
+    free(sourceStorage);
+    free(targetStorage);
+    return result;
+}
+
+// Estado compartido, equivalente a los campos de DEVICE_EXTENSION
+typedef struct _RESIZE_CONTEXT {
+    RING_BUFFER Ring;
+    PUCHAR Storage;
+    pthread_mutex_t ProducerLock;
+    pthread_mutex_t ConsumerLock;
+    volatile BOOLEAN Done;
+    volatile BOOLEAN Corrupted;
+    ULONG Resizes;
+    ULONG RejectedResizes;
+} RESIZE_CONTEXT, *PRESIZE_CONTEXT;
+
+static UCHAR PatternByte(ULONG64 position) {
+    return (UCHAR)((position * 0x9E3779B1ULL) >> 19);
+}
+
+static void *ResizeProducer(void *arg) {
+    PRESIZE_CONTEXT context = (PRESIZE_CONTEXT)arg;
+    UCHAR chunk[777];
+    ULONG64 position = 0;
+    ULONG chunkSize;
+    ULONG written;
+    ULONG i;
+
+    while (position < RESIZE_TOTAL_BYTES && !context->Corrupted) {
+        chunkSize = (ULONG)min(sizeof(chunk), RESIZE_TOTAL_BYTES - position);
+        for (i = 0; i < chunkSize; i++) {
+            chunk[i] = PatternByte(position + i);
+        }
+
+        written = 0;
+        while (written < chunkSize && !context->Corrupted) {
+            ULONG n;
+
+            pthread_mutex_lock(&context->ProducerLock);
+            n = RingBufferWrite(&context->Ring, chunk + written, chunkSize - written);
+            pthread_mutex_unlock(&context->ProducerLock);
+
+            if (n == 0) {
+                sched_yield();
+            }
+            written += n;
+        }
+
+        position += chunkSize;
+    }
+
+    return NULL;
+}
+
+static void *ResizeConsumer(void *arg) {
+    PRESIZE_CONTEXT context = (PRESIZE_CONTEXT)arg;
+    UCHAR chunk[500];
+    ULONG64 position = 0;
+    ULONG n;
+    ULONG i;
+
+    while (position < RESIZE_TOTAL_BYTES) {
+        pthread_mutex_lock(&context->ConsumerLock);
+        n = RingBufferRead(&context->Ring, chunk, sizeof(chunk));
+        pthread_mutex_unlock(&context->ConsumerLock);
+
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (chunk[i] != PatternByte(position + i)) {
+                context->Corrupted = TRUE;
+                context->Done = TRUE;
+                return NULL;
+            }
+        }
+
+        position += n;
+    }
+
+    context->Done = TRUE;
+    return NULL;
+}
+
+static void *Resizer(void *arg) {
+    static const ULONG sizes[] = { 512, 65536, 1024, 4096, 256, 16384 };
+    PRESIZE_CONTEXT context = (PRESIZE_CONTEXT)arg;
+    RING_BUFFER newRing;
+    PUCHAR newStorage;
+    PUCHAR oldStorage;
+    ULONG index = 0;
+
+    while (!context->Done) {
+        ULONG size = sizes[index++ % (sizeof(sizes) / sizeof(sizes[0]))];
+
+        newStorage = (PUCHAR)malloc(size);
+        RingBufferInitialize(&newRing, newStorage, size, 1);
+
+        pthread_mutex_lock(&context->ProducerLock);
+        pthread_mutex_lock(&context->ConsumerLock);
+
+        if (NT_SUCCESS(RingBufferMigrate(&newRing, &context->Ring))) {
+            oldStorage = context->Storage;
+            context->Ring = newRing;
+            context->Storage = newStorage;
+            newStorage = oldStorage;
+            context->Resizes++;
+        } else {
+            context->RejectedResizes++;
+        }
+
+        pthread_mutex_unlock(&context->ConsumerLock);
+        pthread_mutex_unlock(&context->ProducerLock);
+
+        free(newStorage);
+        sched_yield();
+    }
+
+    return NULL;
+}
+
+BOOLEAN TestConcurrentResize(void) {
+    PRESIZE_CONTEXT context;
+    pthread_t producer;
+    pthread_t consumer;
+    pthread_t resizer;
+    BOOLEAN result;
+
+    context = (PRESIZE_CONTEXT)calloc(1, sizeof(RESIZE_CONTEXT));
+    if (context == NULL) {
+        return FALSE;
+    }
+
+    context->Storage = (PUCHAR)malloc(8192);
+    RingBufferInitialize(&context->Ring, context->Storage, 8192, 1);
+    pthread_mutex_init(&context->ProducerLock, NULL);
+    pthread_mutex_init(&context->ConsumerLock, NULL);
+
+    pthread_create(&producer, NULL, ResizeProducer, context);
+    pthread_create(&consumer, NULL, ResizeConsumer, context);
+    pthread_create(&resizer, NULL, Resizer, context);
+
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+    pthread_join(resizer, NULL);
+
+    result = !context->Corrupted && context->Resizes > 0 &&
+             context->Ring.Head == RESIZE_TOTAL_BYTES && context->Ring.Tail == RESIZE_TOTAL_BYTES;
+
+    printf("   %u redimensionados, %u rechazados por audio pendiente\n",
+           context->Resizes, context->RejectedResizes);
+
+    pthread_mutex_destroy(&context->ProducerLock);
+    pthread_mutex_destroy(&context->ConsumerLock);
+    free(context->Storage);
+    free(context);
+    return result;
+}
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sample_convert.h"
+#include "ring_buffer.h"
+
+#define MAX_TEST_SAMPLES 1024
+#define GUARD_BYTES      32
+#define GUARD_VALUE      0xA5
+#define TEST_RING_FRAMES 64
+
+static const char *g_IsaNames[SAMPLE_CONVERT_ISA_COUNT] = { "escalar", "SSE2", "AVX2" };
+
+// Funciones de prueba
+BOOLEAN TestFormatMapping(void);
+BOOLEAN TestScalarReferenceValues(void);
+BOOLEAN TestVectorMatchesScalar(void);
+BOOLEAN TestLosslessRoundTrips(void);
+BOOLEAN TestConvertedRingWrite(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas de conversión de formato de muestra ===\n\n");
+    printf("Variante elegida en esta CPU: %s\n\n", g_IsaNames[SampleConvertGetBestIsa()]);
+
+    printf("1. Prueba de FormatTag/BitsPerSample a formato de muestra...\n");
+    if (TestFormatMapping()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de valores de la referencia escalar (escala, saturación, redondeo)...\n");
+    if (TestScalarReferenceValues()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de núcleos vectoriales idénticos a la referencia...\n");
+    if (TestVectorMatchesScalar()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de ida y vuelta sin pérdidas...\n");
+    if (TestLosslessRoundTrips()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de escritura convertida en el anillo (wrap-around y descarte)...\n");
+    if (TestConvertedRingWrite()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+static BOOLEAN Convert(SAMPLE_FORMAT source, SAMPLE_FORMAT target, SAMPLE_CONVERT_ISA isa,
+                       PVOID output, const VOID *input, ULONG samples) {
+    SAMPLE_CONVERTER converter;
+
+    if (!NT_SUCCESS(SampleConverterInitialize(&converter, source, target, 1, isa))) {
+        return FALSE;
+    }
+
+    SampleConvertFrames(&converter, output, input, samples);
+    return TRUE;
+}
+
+BOOLEAN TestFormatMapping(void) {
+    SAMPLE_FORMAT format;
+
+    if (SampleFormatFromWave(AUDIO_FORMAT_TAG_PCM, 16, &format) != STATUS_SUCCESS || format != SAMPLE_FORMAT_INT16 ||
+        SampleFormatFromWave(0, 24, &format) != STATUS_SUCCESS || format != SAMPLE_FORMAT_INT24 ||
+        SampleFormatFromWave(AUDIO_FORMAT_TAG_PCM, 32, &format) != STATUS_SUCCESS || format != SAMPLE_FORMAT_INT32 ||
+        SampleFormatFromWave(AUDIO_FORMAT_TAG_IEEE_FLOAT, 32, &format) != STATUS_SUCCESS || format != SAMPLE_FORMAT_FLOAT32) {
+        return FALSE;
+    }
+
+    // Float de 16 bits, PCM de 8 bits y etiquetas desconocidas no existen
+    if (SampleFormatFromWave(AUDIO_FORMAT_TAG_IEEE_FLOAT, 16, &format) != STATUS_NOT_SUPPORTED ||
+        SampleFormatFromWave(AUDIO_FORMAT_TAG_PCM, 8, &format) != STATUS_NOT_SUPPORTED ||
+        SampleFormatFromWave(0xFFFE, 16, &format) != STATUS_NOT_SUPPORTED) {
+        return FALSE;
+    }
+
+    return SampleFormatGetBytes(SAMPLE_FORMAT_INT16) == 2 &&
+           SampleFormatGetBytes(SAMPLE_FORMAT_INT24) == 3 &&
+           SampleFormatGetBytes(SAMPLE_FORMAT_INT32) == 4 &&
+           SampleFormatGetBytes(SAMPLE_FORMAT_FLOAT32) == 4 &&
+           SampleConvertIsIsaAvailable(SAMPLE_CONVERT_ISA_SCALAR);
+}
+
+BOOLEAN TestScalarReferenceValues(void) {
+    static const SHORT int16In[] = { 0, 16384, -32768, 32767 };
+    static const float floatIn[] = { 1.0f, -1.0f, 2.0f, -2.0f, 0.5f / 32768.0f, 1.5f / 32768.0f,
+                                     2.5f / 32768.0f, NAN, INFINITY, -INFINITY };
+    static const SHORT int16Expected[] = { 32767, -32768, 32767, -32768, 0, 2, 2, 32767, 32767, -32768 };
+    static const LONG int32Expected[] = { 0x7FFFFFFF, (LONG)0x80000000UL, 0x7FFFFFFF, (LONG)0x80000000UL,
+                                          32768, 98304, 163840, (LONG)0x80000000UL, 0x7FFFFFFF,
+                                          (LONG)0x80000000UL };
+    static const UCHAR int24In[] = { 0x56, 0x34, 0x12, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x80 };
+    float floatOut[4];
+    SHORT int16Out[10];
+    LONG int32Out[10];
+    ULONG i;
+
+    Convert(SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_FLOAT32, SAMPLE_CONVERT_ISA_SCALAR, floatOut, int16In, 4);
+    if (floatOut[0] != 0.0f || floatOut[1] != 0.5f || floatOut[2] != -1.0f || floatOut[3] != 32767.0f / 32768.0f) {
+        return FALSE;
+    }
+
+    // Saturación, NaN e infinitos; los empates redondean al par
+    Convert(SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_INT16, SAMPLE_CONVERT_ISA_SCALAR, int16Out, floatIn, 10);
+    Convert(SAMPLE_FORMAT_FLOAT32, SAMPLE_FORMAT_INT32, SAMPLE_CONVERT_ISA_SCALAR, int32Out, floatIn, 10);
+    for (i = 0; i < 10; i++) {
+        if (int16Out[i] != int16Expected[i] || int32Out[i] != int32Expected[i]) {
+            printf("   Muestra %u: int16 %d (esperado %d), int32 %d (esperado %d)\n",
+                   i, int16Out[i], int16Expected[i], int32Out[i], int32Expected[i]);
+            return FALSE;
+        }
+    }
+
+    // int24 empaquetado little-endian con signo
+    Convert(SAMPLE_FORMAT_INT24, SAMPLE_FORMAT_INT32, SAMPLE_CONVERT_ISA_SCALAR, int32Out, int24In, 3);
+    if (int32Out[0] != 0x12345600 || int32Out[1] != -256 || int32Out[2] != (LONG)0x80000000UL) {
+        return FALSE;
+    }
+
+    // Estrechar trunca hacia menos infinito
+    Convert(SAMPLE_FORMAT_INT24, SAMPLE_FORMAT_INT16, SAMPLE_CONVERT_ISA_SCALAR, int16Out, int24In, 3);
+    return int16Out[0] == 0x1234 && int16Out[1] == -1 && int16Out[2] == -32768;
+}
+
+static void FillSource(PUCHAR buffer, SAMPLE_FORMAT format, ULONG samples, ULONG seed) {
+    static const float specials[] = { 0.0f, -0.0f, 1.0f, -1.0f, 1.0000001f, -1.0000001f,
+                                      0.5f / 32768.0f, -1.5f / 32768.0f, 0.5f / 8388608.0f,
+                                      NAN, INFINITY, -INFINITY, 1e30f, -1e30f };
+    float *floats = (float *)buffer;
+    ULONG i;
+
+    srand(seed);
+
+    if (format != SAMPLE_FORMAT_FLOAT32) {
+        for (i = 0; i < samples * SampleFormatGetBytes(format); i++) {
+            buffer[i] = (UCHAR)rand();
+        }
+        return;
+    }
+
+    // Rango con saturación, valores especiales y empates intercalados
+    for (i = 0; i < samples; i++) {
+        if (i % 7 == 3) {
+            floats[i] = specials[(i / 7) % (sizeof(specials) / sizeof(specials[0]))];
+        } else {
+            floats[i] = ((float)rand() / (float)RAND_MAX) * 3.0f - 1.5f;
+        }
+    }
+}
+
+BOOLEAN TestVectorMatchesScalar(void) {
+    static UCHAR source[MAX_TEST_SAMPLES * 4];
+    static UCHAR expected[MAX_TEST_SAMPLES * 4 + GUARD_BYTES];
+    static UCHAR actual[MAX_TEST_SAMPLES * 4 + GUARD_BYTES];
+    static const ULONG lengths[] = { 0, 1, 7, 8, 9, 10, 11, 17, 31, 33, 67, 1000, MAX_TEST_SAMPLES };
+    ULONG isa;
+    ULONG from;
+    ULONG to;
+    ULONG i;
+    ULONG bytes;
+    ULONG samples;
+    ULONG checked = 0;
+
+    for (isa = SAMPLE_CONVERT_ISA_SSE2; isa < SAMPLE_CONVERT_ISA_COUNT; isa++) {
+        if (!SampleConvertIsIsaAvailable((SAMPLE_CONVERT_ISA)isa)) {
+            printf("   %s no disponible en esta CPU: se omite\n", g_IsaNames[isa]);
+            continue;
+        }
+
+        for (from = 0; from < SAMPLE_FORMAT_COUNT; from++) {
+            for (to = 0; to < SAMPLE_FORMAT_COUNT; to++) {
+                for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+                    samples = lengths[i];
+                    bytes = samples * SampleFormatGetBytes((SAMPLE_FORMAT)to);
+
+                    FillSource(source, (SAMPLE_FORMAT)from, samples, from * 31 + to * 7 + i);
+                    memset(expected, GUARD_VALUE, sizeof(expected));
+                    memset(actual, GUARD_VALUE, sizeof(actual));
+
+                    Convert((SAMPLE_FORMAT)from, (SAMPLE_FORMAT)to, SAMPLE_CONVERT_ISA_SCALAR,
+                            expected, source, samples);
+                    if (!Convert((SAMPLE_FORMAT)from, (SAMPLE_FORMAT)to, (SAMPLE_CONVERT_ISA)isa,
+                                 actual, source, samples)) {
+                        return FALSE;
+                    }
+
+                    // Mismos bytes y nada escrito después del final
+                    if (memcmp(expected, actual, bytes + GUARD_BYTES) != 0) {
+                        printf("   %s: par %u -> %u con %u muestras difiere de la referencia\n",
+                               g_IsaNames[isa], from, to, samples);
+                        return FALSE;
+                    }
+                    checked++;
+                }
+            }
+        }
+    }
+
+    printf("   %u combinaciones comprobadas\n", checked);
+    return TRUE;
+}
+
+BOOLEAN TestLosslessRoundTrips(void) {
+    static const SAMPLE_FORMAT wider[] = { SAMPLE_FORMAT_INT24, SAMPLE_FORMAT_INT32, SAMPLE_FORMAT_FLOAT32 };
+    static UCHAR original[MAX_TEST_SAMPLES * 4];
+    static UCHAR wide[MAX_TEST_SAMPLES * 4];
+    static UCHAR back[MAX_TEST_SAMPLES * 4];
+    SAMPLE_CONVERT_ISA isa = SampleConvertGetBestIsa();
+    ULONG i;
+
+    // int16 -> {int24, int32, float} -> int16
+    for (i = 0; i < sizeof(wider) / sizeof(wider[0]); i++) {
+        FillSource(original, SAMPLE_FORMAT_INT16, MAX_TEST_SAMPLES, i);
+        Convert(SAMPLE_FORMAT_INT16, wider[i], isa, wide, original, MAX_TEST_SAMPLES);
+        Convert(wider[i], SAMPLE_FORMAT_INT16, isa, back, wide, MAX_TEST_SAMPLES);
+        if (memcmp(original, back, MAX_TEST_SAMPLES * 2) != 0) {
+            return FALSE;
+        }
+    }
+
+    // int24 -> {int32, float} -> int24 (float tiene 24 bits de mantisa)
+    for (i = 1; i < sizeof(wider) / sizeof(wider[0]); i++) {
+        FillSource(original, SAMPLE_FORMAT_INT24, MAX_TEST_SAMPLES, i + 10);
+        Convert(SAMPLE_FORMAT_INT24, wider[i], isa, wide, original, MAX_TEST_SAMPLES);
+        Convert(wider[i], SAMPLE_FORMAT_INT24, isa, back, wide, MAX_TEST_SAMPLES);
+        if (memcmp(original, back, MAX_TEST_SAMPLES * 3) != 0) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestConvertedRingWrite(void) {
+    SAMPLE_CONVERTER converter;
+    RING_BUFFER ring;
+    LONG storage[TEST_RING_FRAMES * 2];
+    SHORT packet[TEST_RING_FRAMES * 2 * 2];
+    LONG output[TEST_RING_FRAMES * 2];
+    ULONG dropped;
+    ULONG i;
+
+    // Estéreo int16 -> int32: frames de 4 bytes a la entrada y 8 en el anillo
+    if (SampleConverterInitialize(&converter, SAMPLE_FORMAT_INT16, SAMPLE_FORMAT_INT32, 2,
+                                  SampleConvertGetBestIsa()) != STATUS_SUCCESS ||
+        converter.SourceFrameSize != 4 || converter.TargetFrameSize != 8) {
+        return FALSE;
+    }
+
+    RingBufferInitialize(&ring, storage, TEST_RING_FRAMES, converter.TargetFrameSize);
+
+    for (i = 0; i < TEST_RING_FRAMES * 2 * 2; i++) {
+        packet[i] = (SHORT)(i * 97 - 3000);
+    }
+
+    // Dejar la cabeza a mitad del anillo para forzar el wrap-around
+    if (SampleConvertWriteRing(&ring, &converter, packet, 40) != 40 ||
+        RingBufferRead(&ring, output, 40) != 40) {
+        return FALSE;
+    }
+
+    if (SampleConvertWriteRing(&ring, &converter, packet, 50) != 50 ||
+        SampleConvertWriteRing(&ring, &converter, packet, 50) != 14 ||
+        RingBufferRead(&ring, output, TEST_RING_FRAMES) != TEST_RING_FRAMES) {
+        return FALSE;
+    }
+
+    for (i = 0; i < TEST_RING_FRAMES * 2; i++) {
+        if (output[i] != (LONG)((ULONG)(LONG)packet[i % 100] << 16)) {
+            return FALSE;
+        }
+    }
+
+    // Descartar lo más antiguo: un paquete mayor que el anillo deja sus últimos frames
+    if (SampleConvertWriteRingDropOldest(&ring, &converter, packet, TEST_RING_FRAMES * 2, &dropped) != TEST_RING_FRAMES ||
+        dropped != TEST_RING_FRAMES ||
+        RingBufferRead(&ring, output, TEST_RING_FRAMES) != TEST_RING_FRAMES) {
+        return FALSE;
+    }
+
+    for (i = 0; i < TEST_RING_FRAMES * 2; i++) {
+        if (output[i] != (LONG)((ULONG)(LONG)packet[TEST_RING_FRAMES * 2 + i] << 16)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
@@ -0,0 +1,336 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "shared_ring.h"
+
+#define CROSS_PROCESS_FRAMES 1024
+#define CROSS_PROCESS_TOTAL  (4ULL * 1024 * 1024)
+
+// Funciones de prueba
+BOOLEAN TestSharedRingFormat(void);
+BOOLEAN TestSharedRingReadWrite(void);
+BOOLEAN TestSharedRingRejectsCorruptPosition(void);
+BOOLEAN TestSharedRingDoorbell(void);
+BOOLEAN TestSharedRingCrossProcess(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas del anillo compartido ===\n\n");
+
+    printf("1. Prueba de formato y validación de la cabecera...\n");
+    if (TestSharedRingFormat()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de escritura/lectura con wrap-around...\n");
+    if (TestSharedRingReadWrite()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de posición corrupta del productor...\n");
+    if (TestSharedRingRejectsCorruptPosition()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba del timbre (doorbell) del productor...\n");
+    if (TestSharedRingDoorbell()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba productor/consumidor en procesos separados...\n");
+    if (TestSharedRingCrossProcess()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestSharedRingFormat(void) {
+    SHARED_RING_VIEW view;
+    SIZE_T size = SharedRingGetRequiredSize(64, 4);
+    PUCHAR memory;
+    BOOLEAN result = FALSE;
+
+    // Capacidad no potencia de dos
+    if (SharedRingGetRequiredSize(48, 4) != 0 || size != SHARED_RING_DATA_OFFSET + 256) {
+        return FALSE;
+    }
+
+    memory = (PUCHAR)calloc(1, size);
+    if (memory == NULL) {
+        return FALSE;
+    }
+
+    if (SharedRingFormat(memory, size - 1, 64, 4) != STATUS_INVALID_PARAMETER ||
+        !NT_SUCCESS(SharedRingFormat(memory, size, 64, 4))) {
+        goto Exit;
+    }
+
+    // El productor no acepta un mapeo más pequeño que lo que declara la cabecera
+    if (SharedRingAttachProducer(&view, memory, size - 4) != STATUS_INVALID_PARAMETER) {
+        goto Exit;
+    }
+
+    if (!NT_SUCCESS(SharedRingAttachProducer(&view, memory, size)) ||
+        view.Capacity != 64 || view.FrameSize != 4 || SharedRingGetFreeFrames(&view) != 64) {
+        goto Exit;
+    }
+
+    ((PSHARED_RING_HEADER)memory)->Magic = 0;
+    result = SharedRingAttachProducer(&view, memory, size) == STATUS_NOT_SUPPORTED;
+
+Exit:
+    free(memory);
+    return result;
+}
+
+BOOLEAN TestSharedRingReadWrite(void) {
+    SHARED_RING_VIEW producer;
+    SHARED_RING_VIEW consumer;
+    SIZE_T size = SharedRingGetRequiredSize(32, sizeof(ULONG));
+    PUCHAR memory = (PUCHAR)calloc(1, size);
+    ULONG testData[20];
+    ULONG readData[20];
+    ULONG framesRead;
+    ULONG round;
+    ULONG i;
+    BOOLEAN result = FALSE;
+
+    if (memory == NULL) {
+        return FALSE;
+    }
+
+    SharedRingFormat(memory, size, 32, sizeof(ULONG));
+    SharedRingAttachProducer(&producer, memory, size);
+    SharedRingAttachConsumer(&consumer, memory, 32, sizeof(ULONG));
+
+    for (round = 0; round < 10; round++) {
+        for (i = 0; i < 20; i++) {
+            testData[i] = round * 100 + i;
+        }
+
+        if (SharedRingWrite(&producer, testData, 20) != 20 || SharedRingGetUsedFrames(&consumer) != 20) {
+            goto Exit;
+        }
+
+        if (!NT_SUCCESS(SharedRingRead(&consumer, readData, 20, &framesRead)) || framesRead != 20 ||
+            memcmp(testData, readData, sizeof(testData)) != 0) {
+            goto Exit;
+        }
+    }
+
+    // Lleno: solo se acepta la capacidad
+    SharedRingWrite(&producer, testData, 20);
+    if (SharedRingWrite(&producer, testData, 20) != 12 || SharedRingGetFreeFrames(&producer) != 0) {
+        goto Exit;
+    }
+
+    // Descartar libera espacio igual que leer, sin copiar
+    result = NT_SUCCESS(SharedRingDiscard(&consumer, 40, &framesRead)) && framesRead == 32 &&
+             SharedRingGetUsedFrames(&consumer) == 0 && SharedRingGetFreeFrames(&producer) == 32;
+
+Exit:
+    free(memory);
+    return result;
+}
+
+BOOLEAN TestSharedRingRejectsCorruptPosition(void) {
+    SHARED_RING_VIEW consumer;
+    SIZE_T size = SharedRingGetRequiredSize(16, 2);
+    PUCHAR memory = (PUCHAR)calloc(1, size);
+    PSHARED_RING_HEADER header = (PSHARED_RING_HEADER)memory;
+    USHORT readData[16];
+    ULONG framesRead;
+    BOOLEAN result;
+
+    if (memory == NULL) {
+        return FALSE;
+    }
+
+    SharedRingFormat(memory, size, 16, 2);
+    SharedRingAttachConsumer(&consumer, memory, 16, 2);
+
+    // La cabecera miente sobre la geometría: el consumidor usa la suya
+    header->Capacity = 1U << 20;
+    header->FrameSize = 4096;
+
+    // Más frames publicados que la capacidad
+    header->WritePosition = 17;
+    result = SharedRingRead(&consumer, readData, 16, &framesRead) == STATUS_DATA_ERROR && framesRead == 0;
+
+    // Posición de escritura por detrás de la de lectura
+    header->WritePosition = 4;
+    consumer.Position = 8;
+    result = result && SharedRingRead(&consumer, readData, 16, &framesRead) == STATUS_DATA_ERROR;
+
+    // Una posición válida vuelve a leerse con normalidad
+    header->WritePosition = 24;
+    result = result && NT_SUCCESS(SharedRingRead(&consumer, readData, 16, &framesRead)) && framesRead == 16;
+
+    free(memory);
+    return result;
+}
+
+BOOLEAN TestSharedRingDoorbell(void) {
+    SHARED_RING_VIEW producer;
+    SHARED_RING_VIEW consumer;
+    SIZE_T size = SharedRingGetRequiredSize(8, 1);
+    PUCHAR memory = (PUCHAR)calloc(1, size);
+    UCHAR data[8] = { 0 };
+    ULONG framesRead;
+    BOOLEAN result;
+
+    if (memory == NULL) {
+        return FALSE;
+    }
+
+    SharedRingFormat(memory, size, 8, 1);
+    SharedRingAttachProducer(&producer, memory, size);
+    SharedRingAttachConsumer(&consumer, memory, 8, 1);
+
+    // Con espacio libre no hace falta esperar ni dejar aviso
+    result = !SharedRingPrepareWait(&producer, 4) && producer.Header->ProducerWaitFrames == 0;
+
+    // Lleno: el productor pide 4 frames libres
+    SharedRingWrite(&producer, data, 8);
+    result = result && SharedRingPrepareWait(&producer, 4);
+
+    // Con 2 libres aún no se toca el timbre, pero el aviso se conserva
+    SharedRingRead(&consumer, data, 2, &framesRead);
+    result = result && !SharedRingShouldNotifyProducer(&consumer) && producer.Header->ProducerWaitFrames == 4;
+
+    // Con 4 libres se toca una sola vez
+    SharedRingRead(&consumer, data, 2, &framesRead);
+    result = result && SharedRingShouldNotifyProducer(&consumer);
+    result = result && !SharedRingShouldNotifyProducer(&consumer);
+
+    // Sin aviso no hay timbre aunque se libere espacio
+    SharedRingRead(&consumer, data, 4, &framesRead);
+    result = result && framesRead == 4 && !SharedRingShouldNotifyProducer(&consumer);
+
+    free(memory);
+    return result;
+}
+
+static ULONG PatternFrame(ULONG64 position) {
+    return (ULONG)(position * 2654435761ULL);
+}
+
+static void CrossProcessProducer(PVOID memory, SIZE_T size) {
+    SHARED_RING_VIEW producer;
+    ULONG chunk[97];
+    ULONG64 position = 0;
+    ULONG count;
+    ULONG written;
+    ULONG i;
+
+    SharedRingAttachProducer(&producer, memory, size);
+
+    while (position < CROSS_PROCESS_TOTAL) {
+        count = (ULONG)min((ULONG64)(sizeof(chunk) / sizeof(chunk[0])), CROSS_PROCESS_TOTAL - position);
+        for (i = 0; i < count; i++) {
+            chunk[i] = PatternFrame(position + i);
+        }
+
+        written = 0;
+        while (written < count) {
+            ULONG n = SharedRingWrite(&producer, chunk + written, count - written);
+            if (n == 0) {
+                sched_yield();
+            }
+            written += n;
+        }
+
+        position += count;
+    }
+}
+
+BOOLEAN TestSharedRingCrossProcess(void) {
+    SHARED_RING_VIEW consumer;
+    SIZE_T size = SharedRingGetRequiredSize(CROSS_PROCESS_FRAMES, sizeof(ULONG));
+    ULONG chunk[200];
+    ULONG64 position = 0;
+    ULONG framesRead;
+    ULONG i;
+    PVOID memory;
+    pid_t child;
+    int childStatus;
+    BOOLEAN result = TRUE;
+
+    // Memoria compartida entre procesos, como la vista que mapea el driver
+    memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return FALSE;
+    }
+
+    SharedRingFormat(memory, size, CROSS_PROCESS_FRAMES, sizeof(ULONG));
+    SharedRingAttachConsumer(&consumer, memory, CROSS_PROCESS_FRAMES, sizeof(ULONG));
+
+    child = fork();
+    if (child < 0) {
+        munmap(memory, size);
+        return FALSE;
+    }
+
+    if (child == 0) {
+        CrossProcessProducer(memory, size);
+        _exit(0);
+    }
+
+    while (position < CROSS_PROCESS_TOTAL && result) {
+        if (!NT_SUCCESS(SharedRingRead(&consumer, chunk, 200, &framesRead))) {
+            result = FALSE;
+            break;
+        }
+
+        if (framesRead == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < framesRead; i++) {
+            if (chunk[i] != PatternFrame(position + i)) {
+                result = FALSE;
+                break;
+            }
+        }
+
+        position += framesRead;
+    }
+
+    if (!result) {
+        kill(child, SIGKILL);
+    }
+
+    waitpid(child, &childStatus, 0);
+    munmap(memory, size);
+
+    return result && WIFEXITED(childStatus) && WEXITSTATUS(childStatus) == 0;
+}
@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "stat_counters.h"
+
+#define STRESS_THREADS    8
+#define STRESS_INCREMENTS 200000
+
+// Funciones de prueba
+BOOLEAN TestStatCountersLayout(void);
+BOOLEAN TestStatCountersSingleThread(void);
+BOOLEAN TestStatCountersSharedSlots(void);
+BOOLEAN TestStatCountersConcurrentWriters(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de contadores por procesador ===\n\n");
+
+    printf("1. Prueba de tamaño y alineación de las ranuras...\n");
+    if (TestStatCountersLayout()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de suma y lectura en un hilo...\n");
+    if (TestStatCountersSingleThread()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba con menos ranuras que procesadores...\n");
+    if (TestStatCountersSharedSlots()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de escritores concurrentes sin cuentas perdidas...\n");
+    if (TestStatCountersConcurrentWriters()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestStatCountersLayout(void) {
+    STAT_COUNTERS counters;
+    SIZE_T size = StatCountersGetRequiredSize(6);
+    PUCHAR memory = (PUCHAR)malloc(size + 1);
+    BOOLEAN result;
+
+    if (sizeof(STAT_COUNTER_SLOT) != VMIC_CACHE_LINE || StatCountersGetRequiredSize(0) != 0 ||
+        StatCountersGetRequiredSize(1) != 2 * VMIC_CACHE_LINE || size != 9 * VMIC_CACHE_LINE) {
+        free(memory);
+        return FALSE;
+    }
+
+    // Memoria desalineada a propósito: las ranuras se alinean dentro
+    result = StatCountersInitialize(&counters, memory + 1, size - 1, 6) == STATUS_BUFFER_TOO_SMALL &&
+             StatCountersInitialize(&counters, memory + 1, size, 0) == STATUS_INVALID_PARAMETER &&
+             NT_SUCCESS(StatCountersInitialize(&counters, memory + 1, size, 6)) &&
+             counters.SlotMask == 7 &&
+             ((SIZE_T)counters.Slots % VMIC_CACHE_LINE) == 0 &&
+             (PUCHAR)(counters.Slots + 8) <= memory + 1 + size;
+
+    free(memory);
+    return result;
+}
+
+BOOLEAN TestStatCountersSingleThread(void) {
+    STAT_COUNTERS counters;
+    SIZE_T size = StatCountersGetRequiredSize(4);
+    PVOID memory = malloc(size);
+    ULONG i;
+    BOOLEAN result;
+
+    // La memoria llega sucia: Initialize pone las ranuras a cero
+    memset(memory, 0xA5, size);
+    if (!NT_SUCCESS(StatCountersInitialize(&counters, memory, size, 4)) ||
+        StatCountersRead(&counters, STAT_COUNTER_OVERRUNS) != 0) {
+        free(memory);
+        return FALSE;
+    }
+
+    for (i = 0; i < 1000; i++) {
+        StatCountersAdd(&counters, STAT_COUNTER_SAMPLES_PROCESSED, 960);
+        if (i % 10 == 0) {
+            StatCountersAdd(&counters, STAT_COUNTER_UNDERRUNS, 1);
+        }
+    }
+    StatCountersAdd(&counters, STAT_COUNTER_OVERRUNS, 0x100000000ULL);
+
+    // Cada contador por separado; los 64 bits completos
+    result = StatCountersRead(&counters, STAT_COUNTER_SAMPLES_PROCESSED) == 960000 &&
+             StatCountersRead(&counters, STAT_COUNTER_UNDERRUNS) == 100 &&
+             StatCountersRead(&counters, STAT_COUNTER_OVERRUNS) == 0x100000000ULL;
+
+    free(memory);
+    return result;
+}
+
+typedef struct _WRITER_CONTEXT {
+    PSTAT_COUNTERS Counters;
+    ULONG Index;
+} WRITER_CONTEXT;
+
+static void *CounterWriter(void *arg)
+{
+    WRITER_CONTEXT *context = (WRITER_CONTEXT *)arg;
+    ULONG i;
+
+    for (i = 0; i < STRESS_INCREMENTS; i++) {
+        StatCountersAdd(context->Counters, STAT_COUNTER_SAMPLES_PROCESSED, 2);
+        StatCountersAdd(context->Counters, STAT_COUNTER_OVERRUNS, 1);
+
+        // Forzar migraciones y entrelazados entre la consulta del procesador y la suma
+        if ((i + context->Index) % 4096 == 0) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+static BOOLEAN RunWriters(ULONG Processors)
+{
+    STAT_COUNTERS counters;
+    SIZE_T size = StatCountersGetRequiredSize(Processors);
+    PVOID memory = malloc(size);
+    pthread_t threads[STRESS_THREADS];
+    WRITER_CONTEXT contexts[STRESS_THREADS];
+    ULONG i;
+    BOOLEAN result;
+
+    if (!NT_SUCCESS(StatCountersInitialize(&counters, memory, size, Processors))) {
+        free(memory);
+        return FALSE;
+    }
+
+    for (i = 0; i < STRESS_THREADS; i++) {
+        contexts[i].Counters = &counters;
+        contexts[i].Index = i;
+        pthread_create(&threads[i], NULL, CounterWriter, &contexts[i]);
+    }
+
+    for (i = 0; i < STRESS_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    result = StatCountersRead(&counters, STAT_COUNTER_SAMPLES_PROCESSED) ==
+                 2ULL * STRESS_THREADS * STRESS_INCREMENTS &&
+             StatCountersRead(&counters, STAT_COUNTER_OVERRUNS) == (ULONG64)STRESS_THREADS * STRESS_INCREMENTS &&
+             StatCountersRead(&counters, STAT_COUNTER_UNDERRUNS) == 0;
+
+    free(memory);
+    return result;
+}
+
+BOOLEAN TestStatCountersSharedSlots(void) {
+    // Una sola ranura para todos: como un contador compartido, pero exacto
+    return RunWriters(1);
+}
+
+BOOLEAN TestStatCountersConcurrentWriters(void) {
+    return RunWriters(STRESS_THREADS);
+}
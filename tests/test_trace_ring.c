@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "trace_ring.h"
+
+#define STRESS_WRITERS 4
+#define STRESS_RECORDS 200000
+#define STRESS_RING    64
+
+// Funciones de prueba
+BOOLEAN TestTraceRingLayout(void);
+BOOLEAN TestTraceRingDrainInOrder(void);
+BOOLEAN TestTraceRingOverwrite(void);
+BOOLEAN TestTraceRingUnpublished(void);
+BOOLEAN TestTraceRingConcurrent(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 5;
+
+    printf("=== Iniciando pruebas de la traza binaria ===\n\n");
+
+    printf("1. Prueba de tamaño de registros y reserva...\n");
+    if (TestTraceRingLayout()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de vaciado en orden y por partes...\n");
+    if (TestTraceRingDrainInOrder()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de sobrescritura con registros perdidos...\n");
+    if (TestTraceRingOverwrite()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de registro reservado sin publicar...\n");
+    if (TestTraceRingUnpublished()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("5. Prueba de escritores y lector concurrentes...\n");
+    if (TestTraceRingConcurrent()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+static TRACE_RECORD g_Memory[1024];
+static TRACE_RECORD g_Drained[1024];
+
+BOOLEAN TestTraceRingLayout(void) {
+    TRACE_RING ring;
+
+    if (sizeof(TRACE_RECORD) != 32 || sizeof(TRACE_DRAIN_HEADER) != 16 ||
+        TraceRingGetRequiredSize(0) != 0 || TraceRingGetRequiredSize(3) != 4 * sizeof(TRACE_RECORD) ||
+        TraceRingGetRequiredSize(64) != 64 * sizeof(TRACE_RECORD)) {
+        return FALSE;
+    }
+
+    // La memoria llega sucia: ningún registro debe parecer publicado
+    memset(g_Memory, 0xA5, sizeof(g_Memory));
+    return TraceRingInitialize(&ring, g_Memory, sizeof(g_Memory), 0) == STATUS_INVALID_PARAMETER &&
+           TraceRingInitialize(&ring, g_Memory, 8 * sizeof(TRACE_RECORD), 9) == STATUS_BUFFER_TOO_SMALL &&
+           NT_SUCCESS(TraceRingInitialize(&ring, g_Memory, sizeof(g_Memory), 9)) &&
+           ring.Mask == 15 && g_Memory[15].Sequence == 0;
+}
+
+BOOLEAN TestTraceRingDrainInOrder(void) {
+    TRACE_RING ring;
+    ULONG64 lost = 0;
+    ULONG drained;
+    ULONG i;
+
+    TraceRingInitialize(&ring, g_Memory, sizeof(g_Memory), 16);
+    if (TraceRingDrain(&ring, g_Drained, 16, &lost) != 0) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 10; i++) {
+        TraceRingWrite(&ring, TRACE_EVENT_WRITE, 1000 + i, i, i * 2, i * 3);
+    }
+
+    // Por partes: 4 y después el resto
+    drained = TraceRingDrain(&ring, g_Drained, 4, &lost);
+    drained += TraceRingDrain(&ring, g_Drained + drained, 16, &lost);
+    if (drained != 10 || lost != 0 || TraceRingDrain(&ring, g_Drained, 16, &lost) != 0) {
+        return FALSE;
+    }
+
+    for (i = 0; i < 10; i++) {
+        if (g_Drained[i].Sequence != i + 1 || g_Drained[i].Time != 1000 + i ||
+            g_Drained[i].Event != TRACE_EVENT_WRITE || g_Drained[i].Args[0] != i ||
+            g_Drained[i].Args[1] != i * 2 || g_Drained[i].Args[2] != i * 3) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOLEAN TestTraceRingOverwrite(void) {
+    TRACE_RING ring;
+    ULONG64 lost = 0;
+    ULONG drained;
+    ULONG i;
+
+    TraceRingInitialize(&ring, g_Memory, sizeof(g_Memory), 16);
+
+    // 26 registros en 16 huecos: los 10 primeros se pierden
+    for (i = 0; i < 26; i++) {
+        TraceRingWrite(&ring, TRACE_EVENT_READ, i, i, 0, 0);
+    }
+
+    drained = TraceRingDrain(&ring, g_Drained, 64, &lost);
+    if (drained != 16 || lost != 10 || g_Drained[0].Args[0] != 10 || g_Drained[15].Args[0] != 25) {
+        return FALSE;
+    }
+
+    // Lo perdido se cuenta una sola vez
+    TraceRingWrite(&ring, TRACE_EVENT_READ, 26, 26, 0, 0);
+    return TraceRingDrain(&ring, g_Drained, 64, &lost) == 1 && lost == 10 && g_Drained[0].Args[0] == 26;
+}
+
+BOOLEAN TestTraceRingUnpublished(void) {
+    TRACE_RING ring;
+    ULONG64 lost = 0;
+    ULONG64 index;
+
+    TraceRingInitialize(&ring, g_Memory, sizeof(g_Memory), 16);
+
+    // Un escritor reserva el índice 1 y aún no ha publicado; el 2 sí
+    TraceRingWrite(&ring, TRACE_EVENT_IOCTL, 0, 0, 0, 0);
+    index = VmicInterlockedIncrement64(&ring.Head) - 1;
+    TraceRingWrite(&ring, TRACE_EVENT_IOCTL, 2, 2, 0, 0);
+
+    // El vaciado se detiene en el hueco para conservar el orden
+    if (TraceRingDrain(&ring, g_Drained, 16, &lost) != 1 || g_Drained[0].Time != 0) {
+        return FALSE;
+    }
+
+    g_Memory[index].Time = 1;
+    g_Memory[index].Sequence = index + 1;
+    return TraceRingDrain(&ring, g_Drained, 16, &lost) == 2 && lost == 0 &&
+           g_Drained[0].Time == 1 && g_Drained[1].Time == 2;
+}
+
+typedef struct _STRESS_CONTEXT {
+    PTRACE_RING Ring;
+    ULONG Writer;
+} STRESS_CONTEXT;
+
+static volatile LONG g_WritersDone;
+
+static void *StressWriter(void *arg)
+{
+    STRESS_CONTEXT *context = (STRESS_CONTEXT *)arg;
+    ULONG i;
+
+    for (i = 0; i < STRESS_RECORDS; i++) {
+        TraceRingWrite(context->Ring, TRACE_EVENT_WRITE, i, context->Writer, i, (context->Writer * 31 + i) ^ 0xA5A5A5A5);
+    }
+
+    __atomic_add_fetch(&g_WritersDone, 1, __ATOMIC_SEQ_CST);
+    return NULL;
+}
+
+// Cada registro vaciado debe estar entero (los argumentos cuadran) y cada
+// escritor debe aparecer en el orden en que escribió
+static BOOLEAN DrainAndCheck(PTRACE_RING Ring, PULONG64 Lost, ULONG64 *Seen, LONG64 *Last)
+{
+    ULONG drained = TraceRingDrain(Ring, g_Drained, STRESS_RING, Lost);
+    PTRACE_RECORD record;
+    ULONG i;
+
+    for (i = 0; i < drained; i++) {
+        record = &g_Drained[i];
+        if (record->Args[0] >= STRESS_WRITERS || record->Time != record->Args[1] ||
+            record->Args[2] != ((record->Args[0] * 31 + record->Args[1]) ^ 0xA5A5A5A5) ||
+            (LONG64)record->Args[1] <= Last[record->Args[0]]) {
+            return FALSE;
+        }
+        Last[record->Args[0]] = record->Args[1];
+    }
+
+    *Seen += drained;
+    return TRUE;
+}
+
+BOOLEAN TestTraceRingConcurrent(void) {
+    TRACE_RING ring;
+    pthread_t threads[STRESS_WRITERS];
+    STRESS_CONTEXT contexts[STRESS_WRITERS];
+    LONG64 last[STRESS_WRITERS];
+    ULONG64 lost = 0;
+    ULONG64 seen = 0;
+    BOOLEAN result = TRUE;
+    ULONG i;
+
+    TraceRingInitialize(&ring, g_Memory, STRESS_RING * sizeof(TRACE_RECORD), STRESS_RING);
+    g_WritersDone = 0;
+
+    for (i = 0; i < STRESS_WRITERS; i++) {
+        last[i] = -1;
+        contexts[i].Ring = &ring;
+        contexts[i].Writer = i;
+        pthread_create(&threads[i], NULL, StressWriter, &contexts[i]);
+    }
+
+    // Anillo pequeño: el lector compite con escritores que dan vueltas
+    while (result && __atomic_load_n(&g_WritersDone, __ATOMIC_SEQ_CST) < STRESS_WRITERS) {
+        result = DrainAndCheck(&ring, &lost, &seen, last);
+    }
+
+    for (i = 0; i < STRESS_WRITERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    while (result && seen + lost < ring.Head) {
+        result = DrainAndCheck(&ring, &lost, &seen, last);
+    }
+
+    // Todo registro se vacía o se cuenta como perdido
+    return result && seen + lost == (ULONG64)STRESS_WRITERS * STRESS_RECORDS && seen > 0;
+}
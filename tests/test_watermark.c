@@ -0,0 +1,261 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+
+#include "ring_buffer.h"
+#include "watermark.h"
+
+#define STRESS_RING_FRAMES  256
+#define STRESS_LOW_WATER    64
+#define STRESS_HIGH_WATER   192
+#define STRESS_TOTAL_FRAMES (4ULL * 1024 * 1024)
+
+// Funciones de prueba
+BOOLEAN TestWatermarkValidation(void);
+BOOLEAN TestWatermarkCrossings(void);
+BOOLEAN TestWatermarkInitialZone(void);
+BOOLEAN TestWatermarkNoLostWakeup(void);
+
+int main(void) {
+    int passedTests = 0;
+    int totalTests = 4;
+
+    printf("=== Iniciando pruebas de umbrales de llenado ===\n\n");
+
+    printf("1. Prueba de validación de umbrales...\n");
+    if (TestWatermarkValidation()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("2. Prueba de un aviso por cruce (histéresis)...\n");
+    if (TestWatermarkCrossings()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("3. Prueba de aviso inmediato al registrar...\n");
+    if (TestWatermarkInitialZone()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("4. Prueba de productor guiado por eventos sin despertares perdidos...\n");
+    if (TestWatermarkNoLostWakeup()) {
+        printf("   ✅ PASADA\n");
+        passedTests++;
+    } else {
+        printf("   ❌ FALLIDA\n");
+    }
+
+    printf("\n=== Resultados ===\n");
+    printf("Pruebas pasadas: %d/%d\n", passedTests, totalTests);
+    printf("Porcentaje de éxito: %.1f%%\n", (float)passedTests / totalTests * 100);
+
+    return (passedTests == totalTests) ? 0 : 1;
+}
+
+BOOLEAN TestWatermarkValidation(void) {
+    return WatermarkIsValid(64, 192, 256) &&
+           WatermarkIsValid(0, 256, 256) &&
+           WatermarkIsValid(64, 0, 256) &&     // Sin umbral alto
+           !WatermarkIsValid(192, 64, 256) &&
+           !WatermarkIsValid(64, 64, 256) &&
+           !WatermarkIsValid(64, 300, 256) &&
+           !WatermarkIsValid(256, 0, 256);
+}
+
+BOOLEAN TestWatermarkCrossings(void) {
+    WATERMARK_STATE watermarks;
+    ULONG signals = 0;
+    ULONG used;
+
+    WatermarkInitialize(&watermarks, 64, 192);
+
+    // Llenado de 100 a 255 y vaciado hasta 0, frame a frame
+    for (used = 100; used < 256; used++) {
+        signals += WatermarkUpdate(&watermarks, used);
+    }
+
+    if (signals != 1 || watermarks.Zone != WATERMARK_ZONE_HIGH) {
+        return FALSE;
+    }
+
+    for (used = 255; used > 0; used--) {
+        signals += WatermarkUpdate(&watermarks, used);
+    }
+    signals += WatermarkUpdate(&watermarks, 0);
+
+    if (signals != 2 || watermarks.Zone != WATERMARK_ZONE_LOW) {
+        return FALSE;
+    }
+
+    // Oscilar dentro de la zona intermedia no vuelve a avisar
+    for (used = 0; used < 10; used++) {
+        signals += WatermarkUpdate(&watermarks, 100 + (used % 2) * 50);
+    }
+
+    // Volver a bajar sí: es un nuevo cruce
+    signals += WatermarkUpdate(&watermarks, 64);
+    return signals == 3;
+}
+
+BOOLEAN TestWatermarkInitialZone(void) {
+    WATERMARK_STATE watermarks;
+
+    // Registrarse con el anillo vacío avisa en la primera actualización
+    WatermarkInitialize(&watermarks, 64, 192);
+    if (!WatermarkUpdate(&watermarks, 0) || WatermarkUpdate(&watermarks, 10)) {
+        return FALSE;
+    }
+
+    // En la zona intermedia no hay nada que avisar
+    WatermarkInitialize(&watermarks, 64, 192);
+    if (WatermarkUpdate(&watermarks, 100)) {
+        return FALSE;
+    }
+
+    // HighWater 0: nunca se avisa por arriba
+    WatermarkInitialize(&watermarks, 64, 0);
+    return watermarks.HighWater == WATERMARK_HIGH_DISABLED &&
+           !WatermarkUpdate(&watermarks, 0xFFFFFFF0UL) &&
+           WatermarkUpdate(&watermarks, 0);
+}
+
+// Modelo de host de SignalWatermarks con un evento de reinicio automático
+typedef struct _EVENT_CONTEXT {
+    RING_BUFFER Ring;
+    ULONG Storage[STRESS_RING_FRAMES];
+    WATERMARK_STATE Watermarks;
+    pthread_mutex_t Lock;
+    pthread_cond_t Signaled;
+    BOOLEAN EventSet;
+    volatile BOOLEAN Failed;
+    ULONG64 Wakeups;
+} EVENT_CONTEXT, *PEVENT_CONTEXT;
+
+static void SignalIfCrossed(PEVENT_CONTEXT context) {
+    if (WatermarkUpdate(&context->Watermarks, RingBufferGetUsedFrames(&context->Ring))) {
+        pthread_mutex_lock(&context->Lock);
+        context->EventSet = TRUE;
+        pthread_cond_signal(&context->Signaled);
+        pthread_mutex_unlock(&context->Lock);
+    }
+}
+
+static void *EventProducer(void *arg) {
+    PEVENT_CONTEXT context = (PEVENT_CONTEXT)arg;
+    ULONG chunk[STRESS_RING_FRAMES];
+    ULONG64 position = 0;
+    struct timespec deadline;
+    ULONG used;
+    ULONG n;
+    ULONG i;
+    int rc;
+
+    while (position < STRESS_TOTAL_FRAMES && !context->Failed) {
+        // Rellenar hasta el umbral alto y esperar al aviso de nivel bajo
+        used = RingBufferGetUsedFrames(&context->Ring);
+        if (used < STRESS_HIGH_WATER) {
+            n = (ULONG)min((ULONG64)(STRESS_HIGH_WATER - used), STRESS_TOTAL_FRAMES - position);
+            for (i = 0; i < n; i++) {
+                chunk[i] = (ULONG)(position + i);
+            }
+            RingBufferWrite(&context->Ring, chunk, n);
+            position += n;
+            SignalIfCrossed(context);
+            continue;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 5;
+
+        pthread_mutex_lock(&context->Lock);
+        rc = 0;
+        while (!context->EventSet && rc != ETIMEDOUT) {
+            rc = pthread_cond_timedwait(&context->Signaled, &context->Lock, &deadline);
+        }
+        context->EventSet = FALSE;
+        pthread_mutex_unlock(&context->Lock);
+
+        // Un despertar perdido deja al productor dormido con el anillo vacío
+        if (rc == ETIMEDOUT) {
+            context->Failed = TRUE;
+        }
+        context->Wakeups++;
+    }
+
+    return NULL;
+}
+
+static void *EventConsumer(void *arg) {
+    PEVENT_CONTEXT context = (PEVENT_CONTEXT)arg;
+    ULONG chunk[32];
+    ULONG64 position = 0;
+    ULONG request = 1;
+    ULONG n;
+    ULONG i;
+
+    while (position < STRESS_TOTAL_FRAMES && !context->Failed) {
+        request = (request * 5 + 3) % 32 + 1;
+
+        n = RingBufferRead(&context->Ring, chunk, request);
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+
+        for (i = 0; i < n; i++) {
+            if (chunk[i] != (ULONG)(position + i)) {
+                context->Failed = TRUE;
+            }
+        }
+
+        position += n;
+        SignalIfCrossed(context);
+    }
+
+    return NULL;
+}
+
+BOOLEAN TestWatermarkNoLostWakeup(void) {
+    PEVENT_CONTEXT context;
+    pthread_t producer;
+    pthread_t consumer;
+    BOOLEAN result;
+
+    context = (PEVENT_CONTEXT)calloc(1, sizeof(EVENT_CONTEXT));
+    if (context == NULL) {
+        return FALSE;
+    }
+
+    RingBufferInitialize(&context->Ring, context->Storage, STRESS_RING_FRAMES, sizeof(ULONG));
+    WatermarkInitialize(&context->Watermarks, STRESS_LOW_WATER, STRESS_HIGH_WATER);
+    pthread_mutex_init(&context->Lock, NULL);
+    pthread_cond_init(&context->Signaled, NULL);
+
+    pthread_create(&producer, NULL, EventProducer, context);
+    pthread_create(&consumer, NULL, EventConsumer, context);
+
+    pthread_join(consumer, NULL);
+    pthread_join(producer, NULL);
+
+    // El productor solo despierta por cruces, no una vez por paquete
+    result = !context->Failed && context->Wakeups > 0 &&
+             context->Wakeups < STRESS_TOTAL_FRAMES / (STRESS_HIGH_WATER - STRESS_LOW_WATER) * 3;
+
+    pthread_mutex_destroy(&context->Lock);
+    pthread_cond_destroy(&context->Signaled);
+    free(context);
+    return result;
+}
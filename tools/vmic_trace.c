@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "trace_ring.h"
+
+// Decodifica la traza binaria del driver: la entrada es la salida de
+// IOCTL_VIRTUALMIC_DRAIN_TRACE tal cual (TRACE_DRAIN_HEADER y registros),
+// uno o varios vaciados seguidos, desde ficheros o de la entrada estándar
+// ("-"). Escribe un registro por línea con la hora relativa al primero y un
+// resumen por evento al final.
+
+#define TRACE_FILE_DEVICE_UNKNOWN 0x22
+#define TRACE_IOCTL_FIRST         0x800
+
+static const char *g_EventNames[TRACE_EVENT_COUNT] = {
+    "NONE", "IOCTL", "IOCTL_COMPLETE", "WRITE", "WRITE_BATCH", "READ"
+};
+
+// Por función de CTL_CODE desde 0x800 (virtual_mic.h)
+static const char *g_IoctlNames[] = {
+    "SEND_AUDIO", "SET_FORMAT", "GET_STATS", "MUTE", "SET_BUFFER", "SET_OVERFLOW_POLICY",
+    "MAP_RING", "UNMAP_RING", "SEND_AUDIO_DIRECT", "SEND_AUDIO_BATCH", "SET_WATERMARKS",
+    "SET_CHANNEL_MIX", "SET_GAIN", "SET_JITTER_BUFFER", "SET_DRIFT_CONTROL", "METERING",
+    "SET_DSP_CHAIN", "GET_LATENCY", "DRAIN_TRACE", "GET_IOCTL_STATS"
+};
+
+#define TRACE_IOCTL_NAME_COUNT (sizeof(g_IoctlNames) / sizeof(g_IoctlNames[0]))
+
+typedef struct _TRACE_DECODER {
+    BOOLEAN Started;
+    ULONG64 FirstTime;
+    ULONG64 Records;
+    ULONG64 Lost;
+    ULONG64 Events[TRACE_EVENT_COUNT + 1]; // El último cuenta los desconocidos
+} TRACE_DECODER;
+
+static const char *GetIoctlName(ULONG Code)
+{
+    ULONG function = (Code >> 2) & 0xFFF;
+
+    if ((Code >> 16) != TRACE_FILE_DEVICE_UNKNOWN || function < TRACE_IOCTL_FIRST ||
+        function - TRACE_IOCTL_FIRST >= TRACE_IOCTL_NAME_COUNT) {
+        return "?";
+    }
+
+    return g_IoctlNames[function - TRACE_IOCTL_FIRST];
+}
+
+static void PrintRecord(TRACE_DECODER *Decoder, const TRACE_RECORD *Record)
+{
+    const ULONG *args = Record->Args;
+
+    if (!Decoder->Started) {
+        Decoder->FirstTime = Record->Time;
+        Decoder->Started = TRUE;
+    }
+
+    printf("%14.4f ms  cpu %3u  ", (double)(LONG64)(Record->Time - Decoder->FirstTime) / 10000.0,
+           Record->Processor);
+
+    switch (Record->Event) {
+        case TRACE_EVENT_IOCTL:
+            printf("%-15s %s (0x%08X) in %u out %u\n", g_EventNames[Record->Event],
+                   GetIoctlName(args[0]), args[0], args[1], args[2]);
+            break;
+
+        case TRACE_EVENT_IOCTL_COMPLETE:
+            printf("%-15s %s (0x%08X) status 0x%08X info %u\n", g_EventNames[Record->Event],
+                   GetIoctlName(args[0]), args[0], args[1], args[2]);
+            break;
+
+        case TRACE_EVENT_WRITE:
+            printf("%-15s bytes %u written %u policy %u\n", g_EventNames[Record->Event], args[0], args[1], args[2]);
+            break;
+
+        case TRACE_EVENT_WRITE_BATCH:
+            printf("%-15s packets %u frames %u bytes %u\n", g_EventNames[Record->Event], args[0], args[1], args[2]);
+            break;
+
+        case TRACE_EVENT_READ:
+            printf("%-15s frames %u read %u silent %u\n", g_EventNames[Record->Event], args[0], args[1], args[2]);
+            break;
+
+        default:
+            printf("event %-9u %u %u %u\n", Record->Event, args[0], args[1], args[2]);
+            break;
+    }
+
+    Decoder->Records++;
+    Decoder->Events[min(Record->Event, TRACE_EVENT_COUNT)]++;
+}
+
+// FALSE si el fichero está truncado
+static BOOLEAN DecodeStream(TRACE_DECODER *Decoder, FILE *Input)
+{
+    TRACE_DRAIN_HEADER header;
+    TRACE_RECORD record;
+    ULONG i;
+
+    while (fread(&header, sizeof(header), 1, Input) == 1) {
+        if (header.Lost > 0) {
+            printf("%14s     ---  %llu registros perdidos\n", "", (unsigned long long)header.Lost);
+            Decoder->Lost += header.Lost;
+        }
+
+        for (i = 0; i < header.Records; i++) {
+            if (fread(&record, sizeof(record), 1, Input) != 1) {
+                return FALSE;
+            }
+            PrintRecord(Decoder, &record);
+        }
+    }
+
+    return TRUE;
+}
+
+int main(int argc, char **argv)
+{
+    TRACE_DECODER decoder;
+    FILE *input;
+    int result = 0;
+    int i;
+    ULONG event;
+
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <volcado de DRAIN_TRACE | -> ...\n", argv[0]);
+        return 2;
+    }
+
+    memset(&decoder, 0, sizeof(decoder));
+
+    for (i = 1; i < argc; i++) {
+        input = (strcmp(argv[i], "-") == 0) ? stdin : fopen(argv[i], "rb");
+        if (input == NULL) {
+            fprintf(stderr, "No se puede abrir %s\n", argv[i]);
+            result = 1;
+            continue;
+        }
+
+        if (!DecodeStream(&decoder, input)) {
+            fprintf(stderr, "%s: vaciado truncado\n", argv[i]);
+            result = 1;
+        }
+
+        if (input != stdin) {
+            fclose(input);
+        }
+    }
+
+    printf("\n=== %llu registros, %llu perdidos ===\n",
+           (unsigned long long)decoder.Records, (unsigned long long)decoder.Lost);
+    for (event = 1; event <= TRACE_EVENT_COUNT; event++) {
+        if (decoder.Events[event] > 0) {
+            printf("%-15s %llu\n", (event < TRACE_EVENT_COUNT) ? g_EventNames[event] : "desconocidos",
+                   (unsigned long long)decoder.Events[event]);
+        }
+    }
+
+    return result;
+}